@@ -1,4 +1,8 @@
 #include "uhal_adc.h"
+#include "udrv_system.h"
+#include "uhal_powersave.h"
+#include "uhal_pwm.h"
+#include "udrv_powersave.h"
 
 static void *(g_ADCHandle);
 static am_hal_gpio_pincfg_t g_AM_PIN_ADC;
@@ -11,6 +15,29 @@ static UDRV_ADC_MODE              uhal_adc_mode       = UDRV_ADC_MODE_DEFAULT; /
 
 volatile uint8_t is_adc_pin_active[5] = {0,0,0,0,0};
 
+/* Continuous sampling.
+ * The ADC is configured once and kept powered while a stream is running. Every
+ * conversion is started by a CTIMER interrupt and the FIFO is drained by DMA
+ * into one half of a ping-pong buffer; a completed half is converted and handed
+ * to the user from the event loop while DMA fills the other half.
+ * CTIMER 3A is the only timer that can trigger the ADC in hardware, but it is
+ * owned by the RTC alarm (uhal_rtc.c), so the trigger comes from CTIMER 6A in
+ * software. Timer A6 is only otherwise used by PWM on pad 46, so a stream is
+ * refused while PWM holds it and PWM leaves it alone while a stream runs.
+ */
+#define ADC_STREAM_TIMER                6
+#define ADC_STREAM_TIMER_INT            AM_HAL_CTIMER_INT_TIMERA6C0
+
+static uint32_t adc_stream_buf[2][UHAL_ADC_STREAM_RAW_MAX];
+static int16_t  adc_stream_out[UDRV_ADC_STREAM_BLOCK_MAX];
+static volatile bool adc_stream_active;
+static volatile bool adc_stream_pending[2];     // half owned by the event loop
+static volatile uint8_t adc_stream_fill;        // half currently filled by DMA
+static volatile uint32_t adc_stream_overrun;
+static uint32_t adc_stream_block;
+static uint32_t adc_stream_decimation;
+static UDRV_ADC_BLOCK_HANDLER ADC_BLOCK_HANDLER;
+
 static uint32_t get_apollo_adc_pin(uint32_t pin) {
     switch (pin) {
         case 31:
@@ -113,6 +140,62 @@ UDRV_ADC_MODE uhal_adc_get_mode (void) {
 //*****************************************************************************
 static volatile bool wait_adc_int_flag = false;
 am_hal_adc_sample_t Sample;
+
+static void adc_stream_dma_arm(uint8_t half)
+{
+    am_hal_adc_dma_config_t dma_config;
+
+    dma_config.bDynamicPriority  = true;
+    dma_config.ePriority         = AM_HAL_ADC_PRIOR_SERVICE_IMMED;
+    dma_config.bDMAEnable        = true;
+    dma_config.ui32SampleCount   = adc_stream_block * adc_stream_decimation;
+    dma_config.ui32TargetAddress = (uint32_t)adc_stream_buf[half];
+
+    ADC->DMASTAT = 0;
+    am_hal_adc_configure_dma(g_ADCHandle, &dma_config);
+}
+
+static void adc_stream_isr(uint32_t status)
+{
+    if (status & AM_HAL_ADC_INT_DERR)
+    {
+        adc_stream_overrun++;
+        adc_stream_dma_arm(adc_stream_fill);
+        return;
+    }
+
+    if (status & AM_HAL_ADC_INT_DCMP)
+    {
+        uint8_t done = adc_stream_fill;
+        uint8_t next = done ^ 1;
+
+        if (adc_stream_pending[next])
+        {
+            // The other half is still being consumed: drop this block and refill it.
+            adc_stream_overrun++;
+            next = done;
+        }
+        else
+        {
+            udrv_system_event_t adc_event = {
+                .request = UDRV_SYS_EVT_OP_ADC_BLOCK,
+                .p_context = (void *)(uint32_t)done,
+            };
+
+            adc_stream_pending[done] = true;
+            udrv_system_event_produce(&adc_event);
+            uhal_mcu_consume_event();
+        }
+
+        adc_stream_fill = next;
+        adc_stream_dma_arm(next);
+    }
+}
+
+static void adc_stream_trigger(void)
+{
+    am_hal_adc_sw_trigger(g_ADCHandle);
+}
 void am_adc_isr(void)
 {
     #if CFG_SYSVIEW
@@ -136,6 +219,16 @@ void am_adc_isr(void)
     {
         //am_log_inf("Error clearing ADC interrupt status\n");
     }
+    if (adc_stream_active)
+    {
+        adc_stream_isr(ui32IntMask);
+
+        #if CFG_SYSVIEW
+        SEGGER_SYSVIEW_RecordExitISR();
+        #endif
+        return;
+    }
+
     //
     // If we got a conversion completion interrupt (which should be our only
     // ADC interrupt), go ahead and read the data.
@@ -168,6 +261,9 @@ void am_adc_isr(void)
 
 int32_t uhal_adc_read (uint32_t pin, int16_t *value) {
 
+    if (adc_stream_active)
+        return -UDRV_BUSY;
+
     uint32_t _uFuncSel = get_apollo_adc_pin(pin);
 
     if(_uFuncSel == 3)
@@ -266,7 +362,164 @@ int32_t uhal_adc_read (uint32_t pin, int16_t *value) {
     return UDRV_RETURN_OK;
 }
 
+int32_t uhal_adc_stream_start (uint32_t pin, uint32_t sample_rate, uint32_t block_size,
+                               uint32_t decimation, UDRV_ADC_BLOCK_HANDLER handler) {
+    uint32_t trigger_rate, timer_clk, period;
+    uint32_t slot_number = 0;
+
+    if (adc_stream_active || uhal_pwm_ctimer_busy(ADC_STREAM_TIMER, AM_HAL_CTIMER_TIMERA))
+        return -UDRV_BUSY;
+
+    if (handler == NULL || sample_rate == 0 || block_size == 0 || decimation == 0 ||
+        block_size > UDRV_ADC_STREAM_BLOCK_MAX || block_size * decimation > UHAL_ADC_STREAM_RAW_MAX)
+        return -UDRV_WRONG_ARG;
+
+    // Hardware averaging needs one trigger per averaged measurement.
+    trigger_rate = sample_rate << ADCSlotConfig.eMeasToAvg;
+    if (trigger_rate > UHAL_ADC_STREAM_TRIGGER_MAX)
+        return -UDRV_WRONG_ARG;
+
+    if (trigger_rate > 3000000 / 0xFFFF)
+    {
+        timer_clk = AM_HAL_CTIMER_HFRC_3MHZ;
+        period = 3000000 / trigger_rate;
+    }
+    else
+    {
+        timer_clk = AM_HAL_CTIMER_HFRC_12KHZ;
+        period = 12000 / trigger_rate;
+    }
+    if (period < 2 || period > 0xFFFF)
+        return -UDRV_WRONG_ARG;
+
+    uint32_t _uFuncSel = get_apollo_adc_pin(pin);
+    if (_uFuncSel == 3)
+        return -UDRV_WRONG_ARG;
+
+    g_AM_PIN_ADC.uFuncSel = _uFuncSel;
+    am_hal_gpio_pinconfig(pin, g_AM_PIN_ADC);
+
+    if (AM_HAL_STATUS_SUCCESS != am_hal_adc_initialize(slot_number, &g_ADCHandle))
+        return -UDRV_INTERNAL_ERR;
+
+    am_hal_adc_power_control(g_ADCHandle, AM_HAL_SYSCTRL_WAKE, false);
+
+    //
+    // Keep the ADC clocked between conversions so each trigger converts
+    // immediately; the configuration below is not touched again until stop.
+    //
+    uhal_adc_set_mode(uhal_adc_mode);
+    ADCConfig.eClock             = AM_HAL_ADC_CLKSEL_HFRC;
+    ADCConfig.ePolarity          = AM_HAL_ADC_TRIGPOL_RISING;
+    ADCConfig.eTrigger           = AM_HAL_ADC_TRIGSEL_SOFTWARE;
+    ADCConfig.eClockMode         = AM_HAL_ADC_CLKMODE_LOW_LATENCY;
+    ADCConfig.ePowerMode         = AM_HAL_ADC_LPMODE0;
+    ADCConfig.eRepeat            = AM_HAL_ADC_SINGLE_SCAN;
+    am_hal_adc_configure(g_ADCHandle, &ADCConfig);
+
+    uhal_adc_set_resolution(uhal_adc_resolution);
+    ADCSlotConfig.eChannel        = get_apollo_slot_channel(pin);
+    ADCSlotConfig.bWindowCompare  = false;
+    ADCSlotConfig.bEnabled        = true;
+    am_hal_adc_configure_slot(g_ADCHandle, slot_number, &ADCSlotConfig);
+
+    adc_stream_block = block_size;
+    adc_stream_decimation = decimation;
+    adc_stream_overrun = 0;
+    adc_stream_pending[0] = false;
+    adc_stream_pending[1] = false;
+    adc_stream_fill = 0;
+    ADC_BLOCK_HANDLER = handler;
+    adc_stream_dma_arm(0);
+
+    am_hal_adc_interrupt_clear(g_ADCHandle, 0xFFFFFFFF);
+    am_hal_adc_interrupt_enable(g_ADCHandle, AM_HAL_ADC_INT_DCMP | AM_HAL_ADC_INT_DERR);
+    NVIC_EnableIRQ(ADC_IRQn);
+
+    adc_stream_active = true;
+    am_hal_adc_enable(g_ADCHandle);
+
+    //
+    // Conversion trigger.
+    //
+    am_hal_ctimer_stop(ADC_STREAM_TIMER, AM_HAL_CTIMER_TIMERA);
+    am_hal_ctimer_clear(ADC_STREAM_TIMER, AM_HAL_CTIMER_TIMERA);
+    am_hal_ctimer_config_single(ADC_STREAM_TIMER, AM_HAL_CTIMER_TIMERA,
+                                timer_clk | AM_HAL_CTIMER_FN_REPEAT | AM_HAL_CTIMER_INT_ENABLE);
+    am_hal_ctimer_compare_set(ADC_STREAM_TIMER, AM_HAL_CTIMER_TIMERA, 0, period - 1);
+    am_hal_ctimer_int_clear(ADC_STREAM_TIMER_INT);
+    am_hal_ctimer_int_register(ADC_STREAM_TIMER_INT, adc_stream_trigger);
+    am_hal_ctimer_int_enable(ADC_STREAM_TIMER_INT);
+    NVIC_SetPriority(CTIMER_IRQn, NVIC_configKERNEL_INTERRUPT_PRIORITY);
+    NVIC_EnableIRQ(CTIMER_IRQn);
+    am_hal_ctimer_start(ADC_STREAM_TIMER, AM_HAL_CTIMER_TIMERA);
+
+    // HFRC and with it the trigger timer stop in deep sleep, keep the idle task
+    // in normal sleep until the stream is stopped.
+    udrv_powersave_set_latency(UDRV_PS_LATENCY_ADC, 0);
+
+    return UDRV_RETURN_OK;
+}
+
+int32_t uhal_adc_stream_stop (void) {
+    if (!adc_stream_active)
+        return UDRV_RETURN_OK;
+
+    am_hal_ctimer_stop(ADC_STREAM_TIMER, AM_HAL_CTIMER_TIMERA);
+    am_hal_ctimer_int_disable(ADC_STREAM_TIMER_INT);
+    am_hal_ctimer_int_clear(ADC_STREAM_TIMER_INT);
+
+    am_hal_adc_interrupt_disable(g_ADCHandle, AM_HAL_ADC_INT_DCMP | AM_HAL_ADC_INT_DERR);
+    ADC->DMACFG = 0;
+    adc_stream_active = false;
+    udrv_powersave_set_latency(UDRV_PS_LATENCY_ADC, UDRV_PS_LATENCY_ANY);
+
+    uhal_adc_suspend();
+
+    return UDRV_RETURN_OK;
+}
+
+void uhal_adc_stream_handler (void *p_context) {
+    uint8_t half = (uint32_t)p_context & 1;
+    uint32_t *raw = adc_stream_buf[half];
+
+    if (!adc_stream_active)
+    {
+        adc_stream_pending[half] = false;
+        return;
+    }
+
+    for (uint32_t i = 0; i < adc_stream_block; i++)
+    {
+        uint32_t sum = 0;
+
+        for (uint32_t j = 0; j < adc_stream_decimation; j++)
+            sum += AM_HAL_ADC_FIFO_SAMPLE(*raw++);
+        adc_stream_out[i] = (int16_t)(sum / adc_stream_decimation);
+    }
+
+    // The raw half can be refilled as soon as it is converted.
+    adc_stream_pending[half] = false;
+
+    if (ADC_BLOCK_HANDLER != NULL)
+        ADC_BLOCK_HANDLER(adc_stream_out, adc_stream_block);
+}
+
+uint32_t uhal_adc_stream_overruns (void) {
+    return adc_stream_overrun;
+}
+
+bool uhal_adc_stream_ctimer_busy (uint32_t timer, uint32_t segment) {
+    return adc_stream_active && timer == ADC_STREAM_TIMER && segment == AM_HAL_CTIMER_TIMERA;
+}
+
 void uhal_adc_suspend (void) {
+    // A running stream keeps the ADC powered: its latency bound holds the idle
+    // task in normal sleep, where the trigger timer keeps running. Only
+    // uhal_adc_stream_stop() ends it.
+    if (adc_stream_active)
+        return;
+
     //
     // Disable the ADC.
     //
@@ -324,6 +577,18 @@ void uhal_adc_suspend (void) {
 void uhal_adc_resume (void) {
 }
 
+// uhal_adc_read() powers the ADC down again itself, so it only stays up for a stream.
+bool uhal_adc_is_active (void) {
+    if (adc_stream_active)
+        return true;
+
+    for (int i = 0 ; i < sizeof(is_adc_pin_active) ; i++) {
+        if (is_adc_pin_active[i] == true)
+            return true;
+    }
+    return false;
+}
+
 void uhal_adc_oversampling(uint32_t oversampling)
 {
 	switch (oversampling) {
@@ -10,13 +10,23 @@
 #include "am_util.h"
 #include "am_log.h"
 
+#define UHAL_ADC_STREAM_RAW_MAX     256     /**< Raw samples per DMA half buffer */
+#define UHAL_ADC_STREAM_TRIGGER_MAX 50000   /**< Conversions per second the trigger interrupt can sustain */
+
 int32_t uhal_adc_read (uint32_t pin, int16_t *value);
 void uhal_adc_suspend (void);
 void uhal_adc_resume (void);
+bool uhal_adc_is_active (void);
 void uhal_adc_set_resolution (UDRV_ADC_RESOLUTION resolution);
 UDRV_ADC_RESOLUTION uhal_adc_get_resolution (void);
 void uhal_adc_set_mode (UDRV_ADC_MODE mode);
 UDRV_ADC_MODE uhal_adc_get_mode (void);
 void uhal_adc_oversampling (uint32_t uloversampling);
+int32_t uhal_adc_stream_start (uint32_t pin, uint32_t sample_rate, uint32_t block_size,
+                               uint32_t decimation, UDRV_ADC_BLOCK_HANDLER handler);
+int32_t uhal_adc_stream_stop (void);
+void uhal_adc_stream_handler (void *p_context);
+uint32_t uhal_adc_stream_overruns (void);
+bool uhal_adc_stream_ctimer_busy (uint32_t timer, uint32_t segment);
 
 #endif  // #ifndef _UHAL_ADC_H_
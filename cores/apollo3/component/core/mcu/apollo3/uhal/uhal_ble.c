@@ -97,6 +97,8 @@
 #include "uhal_uart.h"
 #include "uhal_powersave.h"
 #include "uhal_delay.h"
+#include "uhal_ble_scan.h"
+#include "uhal_ble_nus_pipe.h"
 
 //*****************************************************************************
 //
@@ -403,12 +405,27 @@ static QueueHandle_t        Scanner_Queue;
 static SemaphoreHandle_t    Scanner_Semaphore;
 static TaskHandle_t         Scanner_Task;
 
+/* NUS Tx chunk, one notification per LL PDU */
+#define NUS_TX_CHUNK_MAX        (LE_MAX_TX_SIZE - L2C_HDR_LEN - ATT_VALUE_NTF_LEN)
+/* ATTS confirms a notification as soon as L2CAP takes it while flow is enabled, so the HCI
+ * queue keeps the controller fed; the stack rejects more than it can hold pending while
+ * flow is disabled (tests/nus_pipe). */
+#define NUS_TX_PIPELINE_DEPTH   ATT_NUM_SIMUL_NTF
+
 static void ble_queue_reset(void)
 {
     BLE_rxq.start = 0;
     BLE_rxq.end = 0;
 }
 
+/* The host has to serve the controller within a connection event, let a deep
+ * sleep exit take a quarter of the interval (1.25 ms units, 0: no connection). */
+static void ble_conn_latency(uint16_t conn_interval)
+{
+    udrv_powersave_set_latency(UDRV_PS_LATENCY_BLE,
+                               (conn_interval == 0) ? UDRV_PS_LATENCY_ANY : (uint32_t)conn_interval * 1250 / 4);
+}
+
 void uhal_ble_wake_lock (void) {
     uhal_ble_wlock_cnt++;
 }
@@ -627,14 +644,43 @@ static void bleModuleClose(bleModuleMsg_t *pMsg)
     #endif
 }
 
+void uhal_ble_scan_wakeup(void)
+{
+    if(Scanner_Semaphore != NULL)
+        xSemaphoreGive(Scanner_Semaphore);
+}
+
 // RX Task to handle incoming data via UART
 void scanner_handler(void *pvPaParameters)
 {
     scanner_data_t data;
+    uint32_t wait_ms = UINT32_MAX;
 
     while(1)
     {
-        xSemaphoreTake(Scanner_Semaphore, portMAX_DELAY);
+        xSemaphoreTake(Scanner_Semaphore, (wait_ms == UINT32_MAX) ? portMAX_DELAY : pdMS_TO_TICKS(wait_ms));
+
+        uint16_t batch_num = uhal_ble_scan_batch_collect(xTaskGetTickCount(), &wait_ms);
+        if(batch_num != 0)
+        {
+            if(uhal_mcu_sleep_status() == true)
+            {
+                // Resume peripherals...
+                uhal_mcu_resume();
+
+                uhal_ble_scan_batch_deliver(batch_num);
+
+                // Suspend peripherals...
+                uhal_mcu_suspend();
+            }
+            else
+            {
+                uhal_ble_scan_batch_deliver(batch_num);
+            }
+        }
+
+        if(uxQueueMessagesWaiting(Scanner_Queue) == 0)
+            continue;
 
         if(uhal_mcu_sleep_status() == true)
         {
@@ -702,6 +748,7 @@ static void bleModuleProcMsg(bleModuleMsg_t *pMsg)
             #endif
             {
                 am_log_inf("NUS");
+                uhal_nus_tx_pipe_confirm(pMsg->hdr.status);
                 xSemaphoreGive(nus_notify_semaphore);
             }
             else
@@ -758,6 +805,8 @@ static void bleModuleProcMsg(bleModuleMsg_t *pMsg)
         {
             am_log_inf("Scan start.");
             uhal_is_scanning = true;
+            uhal_ble_scan_set_active(true);
+            uhal_ble_scan_wakeup();
             xSemaphoreGive(scan_start_semaphore);
         }
         break;
@@ -765,6 +814,9 @@ static void bleModuleProcMsg(bleModuleMsg_t *pMsg)
         case DM_SCAN_STOP_IND:
         {
             uhal_is_scanning = false;
+            uhal_ble_scan_set_active(false);
+            // Deliver the partial batch, the scanner task then waits for the next start.
+            uhal_ble_scan_wakeup();
             xSemaphoreGive(scan_stop_semaphore);
             am_log_inf("Scan stop.");
         }
@@ -773,9 +825,23 @@ static void bleModuleProcMsg(bleModuleMsg_t *pMsg)
 
         case DM_SCAN_REPORT_IND:
         {
-            if(SCAN_DATA_HANDLER && (pMsg->dm.scanReport.len !=0))
+            if((SCAN_DATA_HANDLER || uhal_ble_scan_batch_enabled()) && (pMsg->dm.scanReport.len !=0) &&
+               uhal_ble_scan_filter_accept(pMsg->dm.scanReport.rssi, pMsg->dm.scanReport.addr,
+                                           pMsg->dm.scanReport.pData, pMsg->dm.scanReport.len))
             {
                 scanner_data_t data;
+
+                if(uhal_ble_scan_batch_enabled())
+                {
+                    // Aggregated here, the scanner task delivers on the batch interval.
+                    uhal_ble_scan_batch_add(pMsg->dm.scanReport.rssi, pMsg->dm.scanReport.addr,
+                                            pMsg->dm.scanReport.pData, pMsg->dm.scanReport.len);
+                    break;
+                }
+
+                if(!uhal_ble_scan_dedup_check(pMsg->dm.scanReport.addr, xTaskGetTickCount()))
+                    break;
+
                 memcpy(&data.adv_data, pMsg->dm.scanReport.pData, pMsg->dm.scanReport.len);
                 data.adv_length = pMsg->dm.scanReport.len;
                 memcpy(&data.mac_addr, pMsg->dm.scanReport.addr, sizeof(data.mac_addr));
@@ -822,6 +888,12 @@ static void bleModuleProcMsg(bleModuleMsg_t *pMsg)
             }
 
             ble_queue_reset();
+            uhal_nus_tx_pipe_reset(NUS_TX_PIPELINE_DEPTH);
+            ble_conn_latency(pMsg->dm.connOpen.connInterval);
+
+            // Ask for the largest LL payload and an ATT MTU that fills it, so each NUS chunk is one PDU.
+            DmConnSetDataLen((dmConnId_t) pMsg->hdr.param, LE_MAX_TX_SIZE, LE_MAX_TX_TIME);
+            AttcMtuReq((dmConnId_t) pMsg->hdr.param, LE_MAX_TX_SIZE - L2C_HDR_LEN);
 
             #ifdef AM_NUS_ADD
             uhal_nus_main_proc_msg(&pMsg->hdr);
@@ -911,6 +983,8 @@ static void bleModuleProcMsg(bleModuleMsg_t *pMsg)
             am_log_inf(">>> Connection closed reason 0x%x <<<",
                     evt->reason);
             ble_queue_reset();
+            uhal_nus_tx_pipe_reset(NUS_TX_PIPELINE_DEPTH);
+            ble_conn_latency(0);
             bleModuleClose(pMsg);
 
             att_mtu = ATT_DEFAULT_MTU - 3;
@@ -947,6 +1021,8 @@ static void bleModuleProcMsg(bleModuleMsg_t *pMsg)
 
         case DM_CONN_UPDATE_IND:
             am_log_inf("Update");
+            if (pMsg->dm.connUpdate.status == HCI_SUCCESS)
+                ble_conn_latency(pMsg->dm.connUpdate.connInterval);
 
             #ifdef AM_CUS_ADD
             uhal_cus_main_proc_msg(&pMsg->hdr);
@@ -1421,6 +1497,7 @@ void uhal_nus_data_handler(uint8_t *p_data, uint16_t length)
     uint32_t err_code;
     size_t rx_available = fund_circular_queue_available_get(&BLE_rxq);
 
+    udrv_powersave_wake_source(UDRV_PS_WAKE_SRC_BLE);
     udrv_powersave_in_sleep = false;
     am_log_inf("rx_available.(%d)", rx_available);
     am_log_inf("Received data from BLE NUS.(%d)", length);
@@ -1461,57 +1538,37 @@ int32_t uhal_nus_read(uint8_t *Buffer, int32_t NumberOfBytes)
     return (int32_t)fund_circular_queue_out(&BLE_rxq, Buffer, NumberOfBytes);
 }
 
+#ifdef AM_NUS_ADD
+static nus_tx_wait_t uhal_nus_tx_wait(void)
+{
+    if(isInISR())
+        return NUS_TX_WAIT_ABORT;
+
+    if(xSemaphoreTake(nus_notify_semaphore, (connparam_conf.connIntervalMax)*3) != pdTRUE)
+        return NUS_TX_WAIT_TIMEOUT;
+
+    return NUS_TX_WAIT_CONFIRM;
+}
+
+static int32_t uhal_nus_tx_send(uint8_t *pdata, uint16_t len)
+{
+    return (int32_t)uhal_nus_main_send_data(NUS_CHAR2_HDL, pdata, len);
+}
+#endif
+
 /**@snippet [Handling the data transmission over BLE] */
 int32_t uhal_nus_write(uint8_t *pdata, uint16_t length)
 {
     #ifdef AM_NUS_ADD
-    uint32_t ret;
-
-    uint8_t *p = pdata;
-    uint16_t remaining = length, chunk_len = att_mtu;
-    do
-    {
-        if(remaining <= att_mtu)
-        {
-            ret = uhal_nus_main_send_data(NUS_CHAR2_HDL, p, remaining);
-            if(ret == 0)
-            {
-                p += remaining;
-                remaining -= remaining;
-            }
-        }
-        else
-        {
-            ret = uhal_nus_main_send_data(NUS_CHAR2_HDL, p, chunk_len);
-            if(ret == 0)
-            {
-                p += chunk_len;
-                remaining -= chunk_len;
-            }
-        }
+    uint16_t chunk_len = (att_mtu < NUS_TX_CHUNK_MAX) ? att_mtu : NUS_TX_CHUNK_MAX;
 
-        if(ret == 0)
-        {
-            if(isInISR())
-            {
-                BaseType_t xHigherPriorityTaskWoken, xResult;
-                xResult = xSemaphoreTakeFromISR(nus_notify_semaphore, &xHigherPriorityTaskWoken);
-                if (xResult != pdFAIL)
-                    portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
-            }    
-            else
-                xSemaphoreTake(nus_notify_semaphore, (connparam_conf.connIntervalMax)*3);
-        }
-
-    } while (ret == 0 && remaining != 0);
-    
-    if(remaining != 0)
+    if(uhal_nus_tx_pipe_write(pdata, length, chunk_len, uhal_nus_tx_send, uhal_nus_tx_wait) != 0)
     {
-        //am_log_inf("sending failed. (%u)", remaining);
+        //am_log_inf("sending failed. (%u)", length);
         return -UDRV_INTERNAL_ERR;
     }
 
-    am_log_inf("sending completed. (%u)", remaining);
+    am_log_inf("sending completed. (%u)", length);
     #endif
 
     return UDRV_RETURN_OK;
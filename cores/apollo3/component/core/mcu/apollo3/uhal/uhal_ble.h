@@ -118,6 +118,7 @@ int32_t uhal_ble_set_scan_interval_window(uint16_t scan_interval, uint16_t scan_
 void uhal_scan_init(bool connect_if_match);
 void uhal_ble_scan_start(uint16_t scan_sec);
 void uhal_ble_scan_stop(void);
+void uhal_ble_scan_wakeup(void);
 void uhal_nus_peer_manager_init(void);
 int32_t uhal_nus_set_keypairing(uint8_t *pairing_key, uint8_t key_length);
 int32_t uhal_nus_set_permission(uint8_t permission);
@@ -0,0 +1,212 @@
+#include "uhal_ble_nus_pipe.h"
+
+#ifdef SUPPORT_BLE
+
+#include <string.h>
+#include "att_defs.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* NUS Tx pipeline.
+ * Up to depth notifications are queued in the stack; each ATTS_HANDLE_VALUE_CNF
+ * returns a slot (flow control follows the HCI buffer-complete events through
+ * L2CAP).
+ *
+ * The confirms carry no chunk identity. They come in send order, except that
+ * while flow is disabled the oldest chunk waits for its confirm and the ones
+ * behind it are rejected with ATT_ERR_OVERFLOW right away.
+ */
+typedef struct
+{
+    uint16_t inflight_off[NUS_TX_PIPELINE_MAX];  /* offset of each unconfirmed chunk, oldest at tail */
+    uint8_t  inflight_gen[NUS_TX_PIPELINE_MAX];  /* write that sent each unconfirmed chunk */
+    uint16_t failed_off[NUS_TX_PIPELINE_MAX];    /* chunks of the current write rejected by the stack, in stream order */
+    uint8_t  head;
+    uint8_t  tail;
+    uint8_t  inflight;
+    uint8_t  held;                               /* chunks behind the tail already rejected */
+    uint8_t  failed;
+    uint8_t  depth;
+    uint8_t  gen;                                /* current write */
+    uint16_t accepted;                           /* chunks of the current write confirmed */
+    bool     broken;                             /* a chunk after a rejected one was accepted */
+} nus_tx_pipe_t;
+
+static nus_tx_pipe_t nus_tx_pipe = {.depth = 1};
+
+void uhal_nus_tx_pipe_reset(uint8_t depth)
+{
+    taskENTER_CRITICAL();
+    nus_tx_pipe.head = 0;
+    nus_tx_pipe.tail = 0;
+    nus_tx_pipe.inflight = 0;
+    nus_tx_pipe.held = 0;
+    nus_tx_pipe.failed = 0;
+    nus_tx_pipe.broken = false;
+    nus_tx_pipe.depth = (depth == 0) ? 1 : ((depth < NUS_TX_PIPELINE_MAX) ? depth : NUS_TX_PIPELINE_MAX);
+    taskEXIT_CRITICAL();
+}
+
+static void nus_tx_pipe_fail(uint8_t slot)
+{
+    uint8_t i;
+    uint16_t off = nus_tx_pipe.inflight_off[slot];
+
+    // Late confirms of an abandoned write just free their slot.
+    if(nus_tx_pipe.inflight_gen[slot] != nus_tx_pipe.gen)
+        return;
+
+    for(i = nus_tx_pipe.failed; i > 0 && nus_tx_pipe.failed_off[i - 1] > off; i--)
+        nus_tx_pipe.failed_off[i] = nus_tx_pipe.failed_off[i - 1];
+    nus_tx_pipe.failed_off[i] = off;
+    nus_tx_pipe.failed++;
+}
+
+/* Drop the tail slot with the rejected ones held behind it. */
+static void nus_tx_pipe_pop(void)
+{
+    nus_tx_pipe.tail = (nus_tx_pipe.tail + 1 + nus_tx_pipe.held) % NUS_TX_PIPELINE_MAX;
+    nus_tx_pipe.inflight -= 1 + nus_tx_pipe.held;
+    nus_tx_pipe.held = 0;
+}
+
+void uhal_nus_tx_pipe_confirm(uint8_t status)
+{
+    taskENTER_CRITICAL();
+    if(status == ATT_ERR_OVERFLOW && nus_tx_pipe.inflight > nus_tx_pipe.held + 1)
+    {
+        // Rejected behind the chunk waiting for flow to resume, the stack never sent it.
+        nus_tx_pipe_fail((nus_tx_pipe.tail + 1 + nus_tx_pipe.held) % NUS_TX_PIPELINE_MAX);
+        nus_tx_pipe.held++;
+    }
+    else if(nus_tx_pipe.inflight > 0)
+    {
+        uint8_t slot = nus_tx_pipe.tail;
+
+        if(status != ATT_SUCCESS)
+            nus_tx_pipe_fail(slot);
+        else if(nus_tx_pipe.inflight_gen[slot] == nus_tx_pipe.gen)
+        {
+            // Resending an earlier chunk now would reorder the stream.
+            if(nus_tx_pipe.failed > 0 && nus_tx_pipe.inflight_off[slot] > nus_tx_pipe.failed_off[0])
+                nus_tx_pipe.broken = true;
+            nus_tx_pipe.accepted++;
+        }
+        nus_tx_pipe_pop();
+    }
+    taskEXIT_CRITICAL();
+}
+
+int32_t uhal_nus_tx_pipe_write(uint8_t *pdata, uint16_t length, uint16_t chunk_len, nus_tx_send_t send, nus_tx_wait_cb_t wait)
+{
+    uint16_t pos = 0, off = 0, len = 0, accepted = 0;
+    uint8_t resends = 0;
+    bool can_send, done, give_up;
+
+    // Slots still in flight belong to an aborted write from here on.
+    taskENTER_CRITICAL();
+    nus_tx_pipe.gen++;
+    nus_tx_pipe.failed = 0;
+    nus_tx_pipe.accepted = 0;
+    nus_tx_pipe.broken = false;
+    taskEXIT_CRITICAL();
+
+    while(1)
+    {
+        uint8_t pending = 0;
+
+        taskENTER_CRITICAL();
+        // The resend budget is for rejections in a row, flow control stalls are routine.
+        if(nus_tx_pipe.accepted != accepted)
+        {
+            accepted = nus_tx_pipe.accepted;
+            resends = 0;
+        }
+        give_up = nus_tx_pipe.broken || ((nus_tx_pipe.failed > 0) && (resends >= NUS_TX_MAX_RESENDS));
+        // Nothing new while a chunk waits for flow to resume, the stack rejects it anyway.
+        // Rejected chunks are resent once every later chunk has been confirmed, so an
+        // accepted one overtaking them is caught rather than reordered.
+        can_send = !give_up && (nus_tx_pipe.failed > 0 || pos < length) &&
+                   (nus_tx_pipe.inflight < nus_tx_pipe.depth) && (nus_tx_pipe.held == 0) &&
+                   (nus_tx_pipe.failed == 0 || nus_tx_pipe.inflight == 0);
+        if(can_send)
+        {
+            // Rejected chunks go first, in stream order.
+            if(nus_tx_pipe.failed > 0)
+            {
+                off = nus_tx_pipe.failed_off[0];
+                nus_tx_pipe.failed--;
+                memmove(&nus_tx_pipe.failed_off[0], &nus_tx_pipe.failed_off[1], nus_tx_pipe.failed * sizeof(uint16_t));
+                resends++;
+            }
+            else
+            {
+                off = pos;
+                pos += ((length - pos) < chunk_len) ? (length - pos) : chunk_len;
+            }
+            len = ((length - off) < chunk_len) ? (length - off) : chunk_len;
+
+            // Claim the slot before sending, the confirm may arrive before the call returns.
+            nus_tx_pipe.inflight_off[nus_tx_pipe.head] = off;
+            nus_tx_pipe.inflight_gen[nus_tx_pipe.head] = nus_tx_pipe.gen;
+            nus_tx_pipe.head = (nus_tx_pipe.head + 1) % NUS_TX_PIPELINE_MAX;
+            nus_tx_pipe.inflight++;
+        }
+        for(uint8_t i = 0; i < nus_tx_pipe.inflight; i++)
+        {
+            if(nus_tx_pipe.inflight_gen[(nus_tx_pipe.tail + i) % NUS_TX_PIPELINE_MAX] == nus_tx_pipe.gen)
+                pending++;
+        }
+        done = (pos >= length) && (pending == 0) && (nus_tx_pipe.failed == 0);
+        taskEXIT_CRITICAL();
+
+        if(done)
+            return 0;
+
+        if(give_up)
+            return -1;
+
+        if(can_send)
+        {
+            if(send(pdata + off, len) != 0)
+            {
+                taskENTER_CRITICAL();
+                nus_tx_pipe.head = (nus_tx_pipe.head + NUS_TX_PIPELINE_MAX - 1) % NUS_TX_PIPELINE_MAX;
+                nus_tx_pipe.inflight--;
+                taskEXIT_CRITICAL();
+                return -1;
+            }
+            continue;
+        }
+
+        switch(wait())
+        {
+            case NUS_TX_WAIT_CONFIRM:
+                break;
+
+            case NUS_TX_WAIT_TIMEOUT:
+            {
+                bool stale;
+
+                // No confirm at all (message buffer exhausted). Chunks of an aborted write
+                // holding the slots are taken as lost, ours may already be on air: give up
+                // rather than send duplicates.
+                taskENTER_CRITICAL();
+                stale = (nus_tx_pipe.inflight > 0) && (nus_tx_pipe.inflight_gen[nus_tx_pipe.tail] != nus_tx_pipe.gen);
+                while(nus_tx_pipe.inflight > 0 && nus_tx_pipe.inflight_gen[nus_tx_pipe.tail] != nus_tx_pipe.gen)
+                    nus_tx_pipe_pop();
+                taskEXIT_CRITICAL();
+
+                if(!stale)
+                    return -1;
+                break;
+            }
+
+            default:
+                // Cannot block here, report what is still pending.
+                return -1;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef _UHAL_BLE_NUS_PIPE_H_
+#define _UHAL_BLE_NUS_PIPE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define NUS_TX_PIPELINE_MAX         4       /**< Notifications kept in flight at most */
+#define NUS_TX_MAX_RESENDS          8       /**< Rejected chunks resent without one accepted before giving up */
+
+typedef enum
+{
+    NUS_TX_WAIT_CONFIRM,                    /**< A confirm arrived, or may have */
+    NUS_TX_WAIT_TIMEOUT,                    /**< No confirm within the wait */
+    NUS_TX_WAIT_ABORT,                      /**< Cannot wait (ISR context) */
+} nus_tx_wait_t;
+
+/**
+ * @brief       Hand one chunk to the stack as a notification
+ * @return      0 on success
+ */
+typedef int32_t (*nus_tx_send_t)(uint8_t *pdata, uint16_t len);
+
+/**
+ * @brief       Block until uhal_nus_tx_pipe_confirm() was called or the wait timed out
+ */
+typedef nus_tx_wait_t (*nus_tx_wait_cb_t)(void);
+
+/**
+ * @brief       Forget the chunks in flight and size the pipeline, called on connection open and close
+ * @param       depth       notifications kept in flight, 1 to NUS_TX_PIPELINE_MAX
+ */
+void uhal_nus_tx_pipe_reset(uint8_t depth);
+
+/**
+ * @brief       Account one ATTS_HANDLE_VALUE_CNF of the NUS Tx characteristic
+ * @param       status      ATT status of the confirm
+ */
+void uhal_nus_tx_pipe_confirm(uint8_t status);
+
+/**
+ * @brief       Send a buffer as notifications of at most chunk_len bytes, in order
+ * @return      0 when every chunk was accepted, -1 otherwise
+ */
+int32_t uhal_nus_tx_pipe_write(uint8_t *pdata, uint16_t length, uint16_t chunk_len, nus_tx_send_t send, nus_tx_wait_cb_t wait);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // #ifndef _UHAL_BLE_NUS_PIPE_H_
@@ -0,0 +1,364 @@
+#include "uhal_ble_scan.h"
+#include "udrv_errno.h"
+
+#ifdef SUPPORT_BLE
+
+#include <string.h>
+#include "dm_api.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Scanner filter, dedup and batch state.
+ * Reports are filtered and aggregated in the BLE stack task before they reach
+ * Scanner_Queue, so the scanner task only runs user callbacks for what is left.
+ * Dedup and batching share the device cache and are mutually exclusive: while a
+ * batch handler is set, reports are only aggregated and the dedup window is not
+ * applied (a batch already reports each device once per interval).
+ */
+typedef struct
+{
+    uint8_t  addr[SCAN_FILTER_ADDR_MAX][6];
+    uint8_t  addr_num;
+    int8_t   min_rssi;
+    bool     mfr_enabled;
+    uint16_t company_id;
+    uint8_t  uuid[16];
+    uint8_t  uuid_len;                          /* 0: disabled, 2 or 16 bytes */
+} scan_filter_t;
+
+typedef struct
+{
+    bool     used;
+    uint8_t  mac_addr[6];
+    uint32_t last_ms;
+    uint16_t count;
+    int8_t   rssi_min;
+    int8_t   rssi_max;
+    int32_t  rssi_sum;
+    uint8_t  adv_length;
+    uint8_t  adv_data[31];
+} scan_cache_entry_t;
+
+static scan_filter_t scan_filter = {.min_rssi = SCAN_RSSI_NONE};
+static scan_cache_entry_t scan_cache[SCAN_CACHE_SIZE];
+static udrv_ble_scan_batch_entry_t scan_batch[SCAN_CACHE_SIZE];
+static uint32_t scan_dedup_window_ms;
+static uint32_t scan_batch_interval_ms;
+static uint32_t scan_batch_last_ms;
+static bool scan_active;
+static BLE_SCAN_BATCH_HANDLER SCAN_BATCH_HANDLER;
+
+static uint32_t scan_addr_hash(uint8_t *mac_addr)
+{
+    uint32_t h = 2166136261u;
+
+    for (int i = 0; i < 6; i++)
+    {
+        h ^= mac_addr[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/* Linear probing; slots are recycled in place and never emptied, so probe
+ * chains stay intact. Expired (dedup) entries are reused, else the least
+ * recently seen one is evicted when evict is set.
+ */
+static scan_cache_entry_t *scan_cache_slot(uint8_t *mac_addr, uint32_t now_ms, uint32_t expire_ms, bool evict)
+{
+    uint32_t idx = scan_addr_hash(mac_addr) & (SCAN_CACHE_SIZE - 1);
+    scan_cache_entry_t *reuse = NULL, *oldest = NULL;
+
+    for (int i = 0; i < SCAN_CACHE_SIZE; i++)
+    {
+        scan_cache_entry_t *e = &scan_cache[(idx + i) & (SCAN_CACHE_SIZE - 1)];
+
+        if (!e->used)
+        {
+            if (reuse == NULL)
+                reuse = e;
+            break;
+        }
+        if (memcmp(e->mac_addr, mac_addr, 6) == 0)
+            return e;
+        if (reuse == NULL && expire_ms != 0 && (now_ms - e->last_ms) >= expire_ms)
+            reuse = e;
+        if (oldest == NULL || (int32_t)(e->last_ms - oldest->last_ms) < 0)
+            oldest = e;
+    }
+
+    if (reuse == NULL && evict)
+        reuse = oldest;
+
+    if (reuse != NULL)
+    {
+        memset(reuse, 0, sizeof(scan_cache_entry_t));
+        reuse->used = true;
+        memcpy(reuse->mac_addr, mac_addr, 6);
+    }
+    return reuse;
+}
+
+static bool scan_uuid_in_list(uint8_t *p, uint8_t n, uint8_t step)
+{
+    for (uint8_t i = 0; i + step <= n; i += step)
+    {
+        if (memcmp(&p[i], scan_filter.uuid, step) == 0)
+            return true;
+    }
+    return false;
+}
+
+static bool scan_adv_match(uint8_t *adv_data, uint8_t adv_length)
+{
+    bool mfr_ok = !scan_filter.mfr_enabled;
+    bool uuid_ok = (scan_filter.uuid_len == 0);
+    uint8_t i = 0;
+
+    while (i + 1 < adv_length && !(mfr_ok && uuid_ok))
+    {
+        uint8_t len = adv_data[i];
+        if (len == 0 || i + 1 + len > adv_length)
+            break;
+
+        uint8_t type = adv_data[i + 1];
+        uint8_t *p = &adv_data[i + 2];
+        uint8_t n = len - 1;
+
+        if (type == DM_ADV_TYPE_MANUFACTURER && n >= 2 &&
+            (uint16_t)(p[0] | (p[1] << 8)) == scan_filter.company_id)
+        {
+            mfr_ok = true;
+        }
+
+        if (scan_filter.uuid_len == 2)
+        {
+            if (type == DM_ADV_TYPE_16_UUID_PART || type == DM_ADV_TYPE_16_UUID)
+                uuid_ok |= scan_uuid_in_list(p, n, 2);
+            else if (type == DM_ADV_TYPE_SERVICE_DATA && n >= 2)
+                uuid_ok |= (memcmp(p, scan_filter.uuid, 2) == 0);
+        }
+        else if (scan_filter.uuid_len == 16)
+        {
+            if (type == DM_ADV_TYPE_128_UUID_PART || type == DM_ADV_TYPE_128_UUID)
+                uuid_ok |= scan_uuid_in_list(p, n, 16);
+            else if (type == DM_ADV_TYPE_SVC_DATA_128 && n >= 16)
+                uuid_ok |= (memcmp(p, scan_filter.uuid, 16) == 0);
+        }
+
+        i += len + 1;
+    }
+
+    return mfr_ok && uuid_ok;
+}
+
+bool uhal_ble_scan_filter_accept(int8_t rssi, uint8_t *mac_addr, uint8_t *adv_data, uint8_t adv_length)
+{
+    if (rssi < scan_filter.min_rssi)
+        return false;
+
+    if (scan_filter.addr_num != 0)
+    {
+        uint8_t i;
+        for (i = 0; i < scan_filter.addr_num; i++)
+        {
+            if (memcmp(scan_filter.addr[i], mac_addr, 6) == 0)
+                break;
+        }
+        if (i == scan_filter.addr_num)
+            return false;
+    }
+
+    if (scan_filter.mfr_enabled || scan_filter.uuid_len != 0)
+        return scan_adv_match(adv_data, adv_length);
+
+    return true;
+}
+
+bool uhal_ble_scan_dedup_check(uint8_t *mac_addr, uint32_t now_ms)
+{
+    scan_cache_entry_t *e;
+    bool report = true;
+
+    if (scan_dedup_window_ms == 0)
+        return true;
+
+    taskENTER_CRITICAL();
+    e = scan_cache_slot(mac_addr, now_ms, scan_dedup_window_ms, true);
+    if (e->count != 0 && (now_ms - e->last_ms) < scan_dedup_window_ms)
+    {
+        report = false;
+    }
+    else
+    {
+        e->last_ms = now_ms;
+        e->count = 1;
+    }
+    taskEXIT_CRITICAL();
+
+    return report;
+}
+
+void uhal_ble_scan_batch_add(int8_t rssi, uint8_t *mac_addr, uint8_t *adv_data, uint8_t adv_length)
+{
+    scan_cache_entry_t *e;
+
+    taskENTER_CRITICAL();
+    // New devices wait for the next batch once the cache is full.
+    e = scan_cache_slot(mac_addr, xTaskGetTickCount(), 0, false);
+    if (e != NULL)
+    {
+        if (e->count == 0 || rssi < e->rssi_min)
+            e->rssi_min = rssi;
+        if (e->count == 0 || rssi > e->rssi_max)
+            e->rssi_max = rssi;
+        if (e->count < UINT16_MAX)
+        {
+            e->count++;
+            e->rssi_sum += rssi;
+        }
+        e->adv_length = (adv_length > sizeof(e->adv_data)) ? sizeof(e->adv_data) : adv_length;
+        memcpy(e->adv_data, adv_data, e->adv_length);
+    }
+    taskEXIT_CRITICAL();
+}
+
+bool uhal_ble_scan_batch_enabled(void)
+{
+    return (scan_batch_interval_ms != 0) && (SCAN_BATCH_HANDLER != NULL);
+}
+
+uint16_t uhal_ble_scan_batch_collect(uint32_t now_ms, uint32_t *wait_ms)
+{
+    uint16_t count = 0;
+    uint32_t elapsed;
+
+    if (!uhal_ble_scan_batch_enabled())
+    {
+        *wait_ms = UINT32_MAX;
+        return 0;
+    }
+
+    // Once the scan stopped, what is left goes out now and the scanner task sleeps
+    // until the next scan start.
+    elapsed = now_ms - scan_batch_last_ms;
+    if (scan_active && elapsed < scan_batch_interval_ms)
+    {
+        *wait_ms = scan_batch_interval_ms - elapsed;
+        return 0;
+    }
+
+    taskENTER_CRITICAL();
+    for (int i = 0; i < SCAN_CACHE_SIZE; i++)
+    {
+        scan_cache_entry_t *e = &scan_cache[i];
+        if (e->used && e->count != 0)
+        {
+            udrv_ble_scan_batch_entry_t *b = &scan_batch[count++];
+            memcpy(b->mac_addr, e->mac_addr, 6);
+            b->count = e->count;
+            b->rssi_min = e->rssi_min;
+            b->rssi_max = e->rssi_max;
+            b->rssi_avg = (int8_t)(e->rssi_sum / e->count);
+            b->adv_length = e->adv_length;
+            memcpy(b->adv_data, e->adv_data, e->adv_length);
+        }
+    }
+    memset(scan_cache, 0, sizeof(scan_cache));
+    taskEXIT_CRITICAL();
+
+    scan_batch_last_ms = now_ms;
+    *wait_ms = scan_active ? scan_batch_interval_ms : UINT32_MAX;
+    return count;
+}
+
+void uhal_ble_scan_batch_deliver(uint16_t count)
+{
+    if (count != 0 && SCAN_BATCH_HANDLER != NULL)
+        SCAN_BATCH_HANDLER(scan_batch, count);
+}
+
+void uhal_ble_scan_cache_reset(void)
+{
+    taskENTER_CRITICAL();
+    memset(scan_cache, 0, sizeof(scan_cache));
+    scan_batch_last_ms = xTaskGetTickCount();
+    taskEXIT_CRITICAL();
+}
+
+void uhal_ble_scan_set_active(bool active)
+{
+    if (active)
+        uhal_ble_scan_cache_reset();
+    scan_active = active;
+}
+
+int32_t uhal_ble_scan_filter_set_rssi(int8_t min_rssi)
+{
+    scan_filter.min_rssi = min_rssi;
+    return UDRV_RETURN_OK;
+}
+
+int32_t uhal_ble_scan_filter_add_address(uint8_t *mac_addr)
+{
+    if (mac_addr == NULL)
+        return -UDRV_WRONG_ARG;
+
+    if (scan_filter.addr_num >= SCAN_FILTER_ADDR_MAX)
+        return -UDRV_BUFF_OVERFLOW;
+
+    taskENTER_CRITICAL();
+    memcpy(scan_filter.addr[scan_filter.addr_num], mac_addr, 6);
+    scan_filter.addr_num++;
+    taskEXIT_CRITICAL();
+    return UDRV_RETURN_OK;
+}
+
+int32_t uhal_ble_scan_filter_set_manufacturer_id(uint16_t company_id)
+{
+    scan_filter.company_id = company_id;
+    scan_filter.mfr_enabled = true;
+    return UDRV_RETURN_OK;
+}
+
+int32_t uhal_ble_scan_filter_set_service_uuid(uint8_t *uuid, uint8_t uuid_len)
+{
+    if (uuid == NULL || (uuid_len != 2 && uuid_len != 16))
+        return -UDRV_WRONG_ARG;
+
+    taskENTER_CRITICAL();
+    memcpy(scan_filter.uuid, uuid, uuid_len);
+    scan_filter.uuid_len = uuid_len;
+    taskEXIT_CRITICAL();
+    return UDRV_RETURN_OK;
+}
+
+void uhal_ble_scan_filter_clear(void)
+{
+    taskENTER_CRITICAL();
+    memset(&scan_filter, 0, sizeof(scan_filter));
+    scan_filter.min_rssi = SCAN_RSSI_NONE;
+    taskEXIT_CRITICAL();
+}
+
+int32_t uhal_ble_scan_set_dedup_window(uint32_t window_ms)
+{
+    scan_dedup_window_ms = window_ms;
+    // The cache holds the batch in progress then, dedup only applies without batching.
+    if (!uhal_ble_scan_batch_enabled())
+        uhal_ble_scan_cache_reset();
+    return UDRV_RETURN_OK;
+}
+
+int32_t uhal_ble_scan_set_batch(uint32_t interval_ms, BLE_SCAN_BATCH_HANDLER handler)
+{
+    if (interval_ms != 0 && handler == NULL)
+        return -UDRV_WRONG_ARG;
+
+    uhal_ble_scan_cache_reset();
+    SCAN_BATCH_HANDLER = handler;
+    scan_batch_interval_ms = interval_ms;
+    return UDRV_RETURN_OK;
+}
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef _UHAL_BLE_SCAN_H_
+#define _UHAL_BLE_SCAN_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "udrv_ble.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define SCAN_FILTER_ADDR_MAX        8       /**< Size of the address allow-list */
+#define SCAN_CACHE_SIZE             32      /**< Devices tracked by the dedup/batch cache, power of 2 */
+#define SCAN_RSSI_NONE              (-128)  /**< RSSI threshold disabled */
+
+/**
+ * @brief       Check an advertising report against the configured filters
+ * @return      true if the report should be delivered
+ */
+bool uhal_ble_scan_filter_accept(int8_t rssi, uint8_t *mac_addr, uint8_t *adv_data, uint8_t adv_length);
+
+/**
+ * @brief       Deduplicate an accepted report
+ * @return      true if the device has not been reported within the dedup window
+ */
+bool uhal_ble_scan_dedup_check(uint8_t *mac_addr, uint32_t now_ms);
+
+/**
+ * @brief       Aggregate an accepted report into the batch cache
+ */
+void uhal_ble_scan_batch_add(int8_t rssi, uint8_t *mac_addr, uint8_t *adv_data, uint8_t adv_length);
+
+/**
+ * @brief       Move the aggregated entries out of the cache once the batch interval elapsed
+ * @param       now_ms      current time in ms
+ * @param       wait_ms     time in ms until the next batch is due, UINT32_MAX if batching is disabled
+ *                          or no scan is running
+ * @return      number of entries ready for uhal_ble_scan_batch_deliver()
+ */
+uint16_t uhal_ble_scan_batch_collect(uint32_t now_ms, uint32_t *wait_ms);
+
+/**
+ * @brief       Hand the collected entries to the registered batch handler
+ */
+void uhal_ble_scan_batch_deliver(uint16_t count);
+
+bool uhal_ble_scan_batch_enabled(void);
+
+/**
+ * @brief       Forget all tracked devices
+ */
+void uhal_ble_scan_cache_reset(void);
+
+/**
+ * @brief       Track the scan state, called on scan start (resets the cache) and stop
+ * @note        uhal_ble_scan_batch_collect() flushes the last batch once stopped and
+ *              reports no further wait until the next start
+ */
+void uhal_ble_scan_set_active(bool active);
+
+int32_t uhal_ble_scan_filter_set_rssi(int8_t min_rssi);
+int32_t uhal_ble_scan_filter_add_address(uint8_t *mac_addr);
+int32_t uhal_ble_scan_filter_set_manufacturer_id(uint16_t company_id);
+int32_t uhal_ble_scan_filter_set_service_uuid(uint8_t *uuid, uint8_t uuid_len);
+void uhal_ble_scan_filter_clear(void);
+int32_t uhal_ble_scan_set_dedup_window(uint32_t window_ms);
+int32_t uhal_ble_scan_set_batch(uint32_t interval_ms, BLE_SCAN_BATCH_HANDLER handler);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // #ifndef _UHAL_BLE_SCAN_H_
@@ -79,6 +79,7 @@ void uhal_gpio_handler_handler(void *pdata)
 
 static void gpio_wakeup_handler(uint32_t irq_num)
 {
+    udrv_powersave_wake_source(UDRV_PS_WAKE_SRC_GPIO);
     udrv_powersave_in_sleep = false;
     udrv_powersave_early_wakeup = true;
     uhal_mcu_wake_up();
@@ -224,6 +225,11 @@ static void rak_hal_gpio_interrupt_service(uint32_t pinNumber)
             return;
         }
 
+#ifdef RADIO_DIO_1
+        udrv_powersave_wake_source((pinNumber == RADIO_DIO_1) ? UDRV_PS_WAKE_SRC_RADIO : UDRV_PS_WAKE_SRC_GPIO);
+#else
+        udrv_powersave_wake_source(UDRV_PS_WAKE_SRC_GPIO);
+#endif
         udrv_powersave_in_sleep = false;
         rui_gpio_int_event[pinNumber].request = UDRV_SYS_EVT_OP_GPIO_INTERRUPT;
         rui_gpio_int_event[pinNumber].p_context = (void *) (long) pinNumber;
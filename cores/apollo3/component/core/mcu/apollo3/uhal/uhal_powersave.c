@@ -58,6 +58,7 @@ void consume_event_task_handler(void *pvPaParameters)
 
 static void ps_timer_timeout_handler(TimerHandle_t xTimer)
 {
+  udrv_powersave_wake_source(UDRV_PS_WAKE_SRC_TIMER);
   uhal_mcu_wake_up();
   ps_tmr_handler(p_context);
 }
@@ -120,18 +121,10 @@ int32_t uhal_ps_timer_start (uint32_t count, void *m_data) {
         
     p_context = m_data;
 
+    // Changing the period (re)starts the timer from now, one timer command instead of three
     if( isInISR() ) 
     {
         BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-        if(pdPASS != xTimerStopFromISR(uhal_ps_timer_id, xHigherPriorityTaskWoken))
-        {
-            return -UDRV_INTERNAL_ERR;
-        }
-
-        if(xHigherPriorityTaskWoken != pdFALSE)
-        {
-            portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
-        }
 
         if(pdPASS != xTimerChangePeriodFromISR( uhal_ps_timer_id,
                         (uint32_t) (count*1.024f), // This is not correct solution! FIX ME!
@@ -144,36 +137,15 @@ int32_t uhal_ps_timer_start (uint32_t count, void *m_data) {
         {
             portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
         }
-
-        if(pdPASS != xTimerStartFromISR(uhal_ps_timer_id, &xHigherPriorityTaskWoken))
-        {
-            return -UDRV_INTERNAL_ERR;
-        }
-
-        if(xHigherPriorityTaskWoken != pdFALSE)
-        {
-            portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
-        }
     } 
     else
     {
-        if(pdPASS != xTimerStop(uhal_ps_timer_id, OSTIMER_WAIT_FOR_QUEUE))
-        {
-            return -UDRV_INTERNAL_ERR;
-        }
-
         if(pdPASS != xTimerChangePeriod( uhal_ps_timer_id,
                         (uint32_t) (count*1.024f), // This is not correct solution! FIX ME!
                         OSTIMER_WAIT_FOR_QUEUE ))
         {
             return -UDRV_INTERNAL_ERR;
         }
-
-        // Start application timers.
-        if (pdPASS != xTimerStart(uhal_ps_timer_id, OSTIMER_WAIT_FOR_QUEUE))
-        {
-            return -UDRV_INTERNAL_ERR;
-        }
     }
 
     return UDRV_RETURN_OK;
@@ -228,18 +200,10 @@ int32_t uhal_uart_wait_timer_start (uint32_t count) {
                             uart_wait_timer_timeout_handler);
     }
 
+    // Changing the period (re)starts the timer from now, one timer command instead of three
     if( isInISR() ) 
     {
         BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-        if(pdPASS != xTimerStopFromISR(uart_wait_timer_id, xHigherPriorityTaskWoken))
-        {
-            return -UDRV_INTERNAL_ERR;
-        }
-
-        if(xHigherPriorityTaskWoken != pdFALSE)
-        {
-            portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
-        }
 
         if(pdPASS != xTimerChangePeriodFromISR( uart_wait_timer_id,
                         (uint32_t) (count*1.024f), // This is not correct solution! FIX ME!
@@ -252,36 +216,15 @@ int32_t uhal_uart_wait_timer_start (uint32_t count) {
         {
             portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
         }
-
-        if(pdPASS != xTimerStartFromISR(uart_wait_timer_id, &xHigherPriorityTaskWoken))
-        {
-            return -UDRV_INTERNAL_ERR;
-        }
-
-        if(xHigherPriorityTaskWoken != pdFALSE)
-        {
-            portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
-        }
     } 
     else
     {
-        if(pdPASS != xTimerStop(uart_wait_timer_id, OSTIMER_WAIT_FOR_QUEUE))
-        {
-            return -UDRV_INTERNAL_ERR;
-        }
-
         if(pdPASS != xTimerChangePeriod( uart_wait_timer_id,
                         (uint32_t) (count*1.024f), // This is not correct solution! FIX ME!
                         OSTIMER_WAIT_FOR_QUEUE ))
         {
             return -UDRV_INTERNAL_ERR;
         }
-
-        // Start application timers.
-        if (pdPASS != xTimerStart(uart_wait_timer_id, OSTIMER_WAIT_FOR_QUEUE))
-        {
-            return -UDRV_INTERNAL_ERR;
-        }
     }
 
     rx_wait_active = true;
@@ -329,6 +272,7 @@ void uart0_rx_interrupt_handler()
   if(uhal_mcu_sleep_status() == true)
   {
     am_log_inf("Resume System");
+    udrv_powersave_wake_source(UDRV_PS_WAKE_SRC_UART);
     uhal_mcu_wake_up();
 
     uhal_uart_resume();
@@ -353,6 +297,7 @@ void uart1_rx_interrupt_handler()
   if(uhal_mcu_sleep_status() == true)
   {
     am_log_inf("Resume System");
+    udrv_powersave_wake_source(UDRV_PS_WAKE_SRC_UART);
     uhal_mcu_wake_up();
 
     uhal_uart_resume();
@@ -496,6 +441,43 @@ void uhal_mcu_consume_event (void)
   }
 }
 
+/* Tickless idle policy, called by the idle task through configPRE_SLEEP_PROCESSING
+ * with interrupts masked and the FreeRTOS tick compare on the STIMER already set
+ * for idle_ticks. Every FreeRTOS timer (user, system, ps and uart wait timers) is
+ * covered by idle_ticks; the LoRaMac timer list runs on its own CTIMER alarm, so
+ * the earlier of the two is the next expiry. Deep sleep is only entered when that
+ * expiry is far enough away and every registered latency bound allows it. */
+uint32_t uhal_mcu_idle_sleep(uint32_t idle_ticks)
+{
+  uint64_t idle_us = (uint64_t)idle_ticks * 1000000 / configTICK_RATE_HZ;
+  uint32_t alarm_ticks = uhal_rtc_get_alarm_remaining();
+  UDRV_PS_IDLE depth;
+  uint32_t start, slept;
+
+  if (alarm_ticks != UINT32_MAX)
+  {
+    uint64_t alarm_us = (uint64_t)alarm_ticks * 1000000 / SYS_RTC_FREQ;
+    if (alarm_us < idle_us)
+      idle_us = alarm_us;
+  }
+
+  if (idle_us < UHAL_PS_DEEP_SLEEP_MIN_IDLE_US || udrv_powersave_get_latency() < UHAL_PS_DEEP_SLEEP_LATENCY_US)
+    depth = UDRV_PS_IDLE_NORMAL;
+  else
+    depth = UDRV_PS_IDLE_DEEP;
+
+  start = am_hal_stimer_counter_get();
+  am_hal_sysctrl_sleep((depth == UDRV_PS_IDLE_DEEP) ? AM_HAL_SYSCTRL_SLEEP_DEEP : AM_HAL_SYSCTRL_SLEEP_NORMAL);
+  slept = am_hal_stimer_counter_get() - start;
+
+  // Interrupts are still masked, a pending tick compare means the idle time ran out
+  udrv_powersave_idle_account(depth, (uint64_t)slept * 1000000 / configSTIMER_CLOCK_HZ,
+                              (am_hal_stimer_int_status_get(false) & AM_HAL_STIMER_INT_COMPAREA) != 0);
+
+  // The WFI has been done here
+  return 0;
+}
+
 void uhal_sys_clock_init(void) {
 }
 
@@ -522,15 +504,8 @@ void uhal_mcu_resume(void) {
 
     uhal_mcu_clear_rx_interrupt();
 
-    uhal_rtc_resume();
-    uhal_gpio_resume();
-    #ifdef SUPPORT_SPI
-    uhal_spimst_resume();
-    #endif
-    uhal_twimst_resume();
-    uhal_uart_resume();
-    uhal_pwm_resume();
-    uhal_adc_resume();
+    // The sleep suspended them through the registry, SPI and TWI come back on first use
+    udrv_powersave_periph_resume_all();
 
     is_mcu_resumed = true;
 
@@ -563,15 +538,7 @@ void uhal_mcu_suspend(void) {
         taskENTER_CRITICAL();
     }
 
-    #ifdef SUPPORT_SPI
-    uhal_spimst_suspend();
-    #endif
-    uhal_adc_suspend();
-    uhal_pwm_suspend();
-    uhal_uart_suspend();
-    uhal_twimst_suspend();
-    uhal_gpio_suspend();
-    uhal_rtc_suspend();
+    udrv_powersave_periph_suspend_all();
 
     if(is_mcu_sleeping == true)
       uhal_mcu_set_rx_interrupt();
@@ -22,6 +22,15 @@
 
 #define UART_WAIT_TIMEOUT_TIME 10000
 
+/* Deep sleep stops the HFRC, so coming back takes longer and only pays off
+ * for idle periods well above it. Both can be overridden per board. */
+#ifndef UHAL_PS_DEEP_SLEEP_LATENCY_US
+#define UHAL_PS_DEEP_SLEEP_LATENCY_US   100
+#endif
+#ifndef UHAL_PS_DEEP_SLEEP_MIN_IDLE_US
+#define UHAL_PS_DEEP_SLEEP_MIN_IDLE_US  2000
+#endif
+
 void uhal_mcu_sleep (uint32_t level);
 void uhal_mcu_wake_up (void);
 void uhal_sys_clock_init(void);
@@ -38,5 +47,6 @@ void uhal_mcu_resume(void);
 void uhal_mcu_suspend(void);
 bool uhal_mcu_sleep_status(void);
 void uhal_mcu_consume_event(void);
+uint32_t uhal_mcu_idle_sleep(uint32_t idle_ticks);
 
 #endif  // #ifndef _UHAL_POWERSAVE_H_
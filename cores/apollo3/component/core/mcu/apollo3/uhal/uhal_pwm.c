@@ -1,5 +1,6 @@
 #include "uhal_pwm.h"
 #include "uhal_timer.h"
+#include "uhal_adc.h"
 #include "udrv_pwm.h"
 #include "udrv_errno.h"
 
@@ -98,6 +99,36 @@ static UDRV_PWM_RESOLUTION pwm_resolution = UDRV_PWM_RESOLUTION_8BIT;
 
 static volatile bool ready_flag[UDRV_PWM_MAX];            // A flag indicating PWM status.
 
+// Find the CTIMER segment driving a pad, false if the pad has no timer output
+static bool pwm_ctimer(uint32_t pin, uint32_t *timer, uint32_t *segment)
+{
+    uint8_t ctx = 0;
+    for (ctx = 0; ctx < 32; ctx++)
+    {
+        if (CTXPADNUM(ctx) == pin)
+        {
+            break;
+        }
+    }
+    if (ctx >= 32)
+    {
+        return false;
+    }
+
+    // Use the 0th index of the outcfg_tbl to select the functions
+    *timer = OUTCTIMN(ctx, 0);
+    *segment = OUTCTIMB(ctx, 0) ? AM_HAL_CTIMER_TIMERB : AM_HAL_CTIMER_TIMERA;
+    return true;
+}
+
+// The ADC stream triggers from CTIMER A6, which is also the timer of pad 46
+static bool pwm_pin_blocked(uint32_t pin)
+{
+    uint32_t timer, segment;
+
+    return pwm_ctimer(pin, &timer, &segment) && uhal_adc_stream_ctimer_busy(timer, segment);
+}
+
 static inline bool isInISR(void)
 {
   return (SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) != 0 ;
@@ -151,6 +182,13 @@ void uhal_pwm_init(udrv_pwm_port port, uint32_t freq_hz, uint8_t is_invert, uint
         return;
     }
 
+    if (pwm_pin_blocked(pin)) {
+        // Left uninitialized, uhal_pwm_set_duty() reports -UDRV_BUSY
+        pwm_status[port].initialized = false;
+        pwm_status[port].pin = pin;
+        return;
+    }
+
     pwm_init(port, freq_hz, is_invert, pin);
 
     pwm_status[port].initialized = true;
@@ -175,6 +213,10 @@ int32_t uhal_pwm_set_duty(udrv_pwm_port port, uint32_t duty) {
 
     uint32_t ontime = duty;
 
+    if (pwm_pin_blocked(pwm_status[port].pin)) {
+        return -UDRV_BUSY;
+    }
+
     switch (pwm_resolution) {
         case UDRV_PWM_RESOLUTION_8BIT:
             if (duty > 255) {
@@ -334,7 +376,7 @@ static void pwm_deinit(udrv_pwm_port port) {
 }
 
 void uhal_pwm_deinit(udrv_pwm_port port) {
-    if (port >= UDRV_PWM_MAX) {
+    if (port >= UDRV_PWM_MAX || pwm_pin_blocked(pwm_status[port].pin)) {
         return;
     }
 
@@ -390,7 +432,7 @@ static void pwm_disable(udrv_pwm_port port) {
 }
 
 void uhal_pwm_disable(udrv_pwm_port port) {
-    if (port >= UDRV_PWM_MAX) {
+    if (port >= UDRV_PWM_MAX || pwm_pin_blocked(pwm_status[port].pin)) {
         return;
     }
 
@@ -423,6 +465,26 @@ void uhal_pwm_resume(void) {
     }
 }
 
+bool uhal_pwm_ctimer_busy(uint32_t timer, uint32_t segment) {
+    uint32_t pwm_timer, pwm_segment;
+
+    for (int i = UDRV_PWM_0 ; i < UDRV_PWM_MAX ; i++) {
+        if (pwm_status[i].initialized == true &&
+            pwm_ctimer(pwm_status[i].pin, &pwm_timer, &pwm_segment) &&
+            pwm_timer == timer && pwm_segment == segment)
+            return true;
+    }
+    return false;
+}
+
+bool uhal_pwm_is_active(void) {
+    for (int i = UDRV_PWM_0 ; i < UDRV_PWM_MAX ; i++) {
+        if (pwm_status[i].initialized == true)
+            return true;
+    }
+    return false;
+}
+
 static timer_handler pwm_tmr_handler = NULL;
 static void *p_context = NULL;
 static void pwm_timer_timeout_handler(TimerHandle_t xTimer)
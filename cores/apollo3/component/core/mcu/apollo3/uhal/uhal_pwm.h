@@ -26,6 +26,8 @@ void uhal_pwm_enable(udrv_pwm_port port);
 void uhal_pwm_disable(udrv_pwm_port port);
 void uhal_pwm_suspend(void);
 void uhal_pwm_resume(void);
+bool uhal_pwm_is_active(void);
+bool uhal_pwm_ctimer_busy(uint32_t timer, uint32_t segment);
 UDRV_PWM_RESOLUTION uhal_pwm_get_resolution (void);
 void uhal_pwm_set_resolution (UDRV_PWM_RESOLUTION resolution);
 int32_t uhal_pwm_timer_create (timer_handler tmr_handler, TimerMode_E mode);
@@ -21,6 +21,8 @@ static uint32_t max_ticks = UINT32_MAX;
 static uint32_t rtc_timer_context = 0;
 static rtc_handler compare0_handler;
 static uint32_t alarm_cnt = 0;
+static uint32_t alarm_start = 0;
+static uint32_t alarm_compare = 0;
 static udrv_system_event_t rui_rtc_event = {.request = UDRV_SYS_EVT_OP_RTC, .p_context = NULL};
 
 static TaskHandle_t rtc_event_task;
@@ -77,6 +79,7 @@ void uhal_rtc_handler_handler(void *pdata)
 void uhal_rtc_handler(void)
 {
     if (compare0_handler) {
+        udrv_powersave_wake_source(UDRV_PS_WAKE_SRC_RTC);
         udrv_powersave_in_sleep = false;
         udrv_system_event_produce(&rui_rtc_event);
 
@@ -224,6 +227,8 @@ int32_t uhal_rtc_set_alarm (RtcID_E timer_id, uint32_t count, void *m_data) {
 
     am_hal_ctimer_start(3, AM_HAL_CTIMER_BOTH);
 
+    alarm_start = am_hal_stimer_counter_get();
+    alarm_compare = compare_val;
     alarm_cnt = 1;
     return 0;
 }
@@ -283,6 +288,21 @@ uint32_t uhal_rtc_get_max_ticks()
     return  max_ticks;
 }
 
+/* Ticks left until the LoRaMac alarm on CTIMER 3 fires, UINT32_MAX if none is set.
+ * Counted on the free-running STIMER, which has the same clock: CTIMER 3 is
+ * cleared by its own interrupt, before uhal_rtc_handler() drops the alarm. */
+uint32_t uhal_rtc_get_alarm_remaining(void)
+{
+    uint32_t elapsed;
+
+    if (alarm_cnt == 0)
+        return UINT32_MAX;
+
+    // Unsigned, so the STIMER wrapping in between does not matter
+    elapsed = am_hal_stimer_counter_get() - alarm_start;
+    return (elapsed < alarm_compare) ? (alarm_compare - elapsed) : 0;
+}
+
 void uhal_rtc_suspend(void){
 }
 
@@ -21,6 +21,7 @@ uint32_t uhal_rtc_get_elapsed_time (RtcID_E timer_id, uint32_t old_ts);
 void uhal_rtc_suspend(void);
 void uhal_rtc_resume(void);
 uint32_t uhal_rtc_get_max_ticks(void);
+uint32_t uhal_rtc_get_alarm_remaining(void);
 void uhal_rtc_handler_handler(void *pdata);
 
 
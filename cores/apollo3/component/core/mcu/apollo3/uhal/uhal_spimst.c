@@ -1,5 +1,6 @@
 #include "uhal_spimst.h"
 #include "uhal_gpio.h"
+#include "udrv_powersave.h"
 #include "am_bsp_pins.h"
 #include "error_check.h"
 
@@ -47,8 +48,8 @@ static am_hal_iom_config_t IOM1_SPIConfig =
     .eInterfaceMode = AM_HAL_IOM_SPI_MODE,
     .ui32ClockFreq  = AM_HAL_IOM_4MHZ,
     .eSpiMode       = AM_HAL_IOM_SPI_MODE_0,
-    .pNBTxnBuf      = 0,
-    .ui32NBTxnBufLength = 0
+    .pNBTxnBuf      = &IOM1_DMATCBBuffer[0],
+    .ui32NBTxnBufLength = sizeof(IOM1_DMATCBBuffer) / sizeof(uint32_t)
 };
 
 typedef struct uhal_spimst_status {
@@ -58,6 +59,69 @@ typedef struct uhal_spimst_status {
 
 static uhal_spimst_status_t spimst_status[UDRV_SPIMST_MAX];
 
+/* Transaction queue.
+ * Descriptor lists are queued per port and run back to back from the IOM
+ * interrupt through am_hal_iom_nonblocking_transfer (command queue + DMA), so
+ * the submitting task is free while the bus is busy. Chip select is a GPIO
+ * driven around each descriptor; transfers longer than one IOM transaction
+ * are split under the same CS.
+ */
+#define SPIMST_QUEUE_PORTS      2
+#define SPIMST_QUEUE_DEPTH      8
+
+typedef struct {
+    udrv_spimst_xfer_t          *xfer;      // NULL: bus hold for a blocking full-duplex transfer
+    uint32_t                    count;
+    UDRV_SPIMST_XFER_HANDLER    handler;
+    void                        *p_context;
+} spimst_job_t;
+
+typedef struct {
+    udrv_spimst_port    port;
+    void                **handle;
+    spimst_job_t        jobs[SPIMST_QUEUE_DEPTH];
+    volatile uint8_t    head;
+    volatile uint8_t    tail;
+    volatile bool       busy;
+    uint32_t            index;              // descriptor of the job at tail
+    uint32_t            offset;             // bytes done in the current phase
+    bool                started;            // CS asserted for this descriptor
+    bool                reading;            // write phase done
+    bool                cs_driven;
+    uint32_t            csn;
+    int32_t             status;             // first error in the job at tail
+    SemaphoreHandle_t   done;               // blocking callers
+} spimst_queue_t;
+
+static spimst_queue_t spimst_queue[SPIMST_QUEUE_PORTS] = {
+    { .port = UDRV_SPIMST_0, .handle = &IOM0_Handle },
+    { .port = UDRV_SPIMST_1, .handle = &IOM1_Handle },
+};
+
+static void spimst_iom_isr(void *handle)
+{
+    uint32_t ui32Status;
+
+    if (!am_hal_iom_interrupt_status_get(handle, true, &ui32Status))
+    {
+        if ( ui32Status )
+        {
+            am_hal_iom_interrupt_clear(handle, ui32Status);
+            am_hal_iom_interrupt_service(handle, ui32Status);
+        }
+    }
+}
+
+void am_iomaster0_isr()
+{
+    spimst_iom_isr(IOM0_Handle);
+}
+
+void am_iomaster1_isr()
+{
+    spimst_iom_isr(IOM1_Handle);
+}
+
 static uint8_t udrv_spimst_0_order = 0;
 static uint8_t udrv_spimst_1_order = 0;
 
@@ -177,6 +241,22 @@ static void spi1_give_semaphore(void)
     }
 }
 
+static void spimst_take(udrv_spimst_port port)
+{
+    if (port == UDRV_SPIMST_0)
+        spi0_take_semaphore();
+    else
+        spi1_take_semaphore();
+}
+
+static void spimst_give(udrv_spimst_port port)
+{
+    if (port == UDRV_SPIMST_0)
+        spi0_give_semaphore();
+    else
+        spi1_give_semaphore();
+}
+
 static void spi0_set_up(void)
 {
     uint32_t err_code;
@@ -513,6 +593,8 @@ static void spimst_init(udrv_spimst_port port) {
     if (port == UDRV_SPIMST_0) {
         if(spi0_semaphore == NULL)
             spi0_semaphore = xSemaphoreCreateMutex();
+        if(spimst_queue[0].done == NULL)
+            spimst_queue[0].done = xSemaphoreCreateBinary();
         spi0_set_up();
     } else
 #endif
@@ -520,6 +602,8 @@ static void spimst_init(udrv_spimst_port port) {
     if (port == UDRV_SPIMST_1) {
         if(spi1_semaphore == NULL)
             spi1_semaphore = xSemaphoreCreateMutex();
+        if(spimst_queue[1].done == NULL)
+            spimst_queue[1].done = xSemaphoreCreateBinary();
         spi1_set_up();
     } else
 #endif
@@ -580,211 +664,334 @@ void uhal_spimst_deinit(udrv_spimst_port port) {
     spimst_status[port].active = false;
 }
 
-int8_t uhal_spimst_trx(udrv_spimst_port port, uint8_t *write_data, uint32_t write_length, uint8_t *read_data, uint32_t read_length, uint32_t csn) {
-    uint32_t err_code;
-    
-    if (port >= UDRV_SPIMST_MAX) 
-        return -1;
+static inline spimst_queue_t *spimst_get_queue(udrv_spimst_port port)
+{
+    return (port < SPIMST_QUEUE_PORTS) ? &spimst_queue[port] : NULL;
+}
 
-    if(spimst_status[port].resumed == false)
-        return -1;
+static void spimst_cs_assert(spimst_queue_t *q, uint32_t csn)
+{
+    uhal_gpio_set_dir(csn, GPIO_DIR_OUT);
 
-    bool set_logic = false;
-#if SPI0_ENABLED
-    if (port == UDRV_SPIMST_0) {
-        spi0_take_semaphore();
+    if (uhal_gpio_get_logic(csn) != GPIO_LOGIC_LOW)
+    {
+        uhal_gpio_set_logic(csn, GPIO_LOGIC_LOW);
+        q->cs_driven = true;
+        q->csn = csn;
+    }
+}
 
-        am_hal_iom_transfer_t tx;
-        am_hal_iom_transfer_t rx;
-        memset(&tx, 0, sizeof(am_hal_iom_transfer_t));
-        memset(&rx, 0, sizeof(am_hal_iom_transfer_t));
+static void spimst_cs_release(spimst_queue_t *q)
+{
+    if (q->cs_driven)
+    {
+        uhal_gpio_set_logic(q->csn, GPIO_LOGIC_HIGH);
+        q->cs_driven = false;
+    }
+}
 
-        // Direction
-        if ((write_data != NULL) && (read_data != NULL))
-        {
-            tx.ui32InstrLen    = 0;
-            tx.ui32Instr       = 0;
-            tx.eDirection      = AM_HAL_IOM_FULLDUPLEX;
-            tx.ui32NumBytes    = write_length;
-            tx.pui32TxBuffer   = (uint32_t *) write_data;
-            tx.pui32RxBuffer   = (uint32_t *) read_data;
-            tx.bContinue       = false;
-            tx.ui8RepeatCount  = 0;
-            tx.ui32PauseCondition = 0;
-            tx.ui32StatusSetClr = 0;
-            tx.uPeerInfo.ui32SpiChipSelect = 0xFF;
-        }
-        else if (write_data != NULL)
-        {
-            tx.ui32InstrLen    = 0;
-            tx.ui32Instr       = 0;
-            tx.eDirection      = AM_HAL_IOM_TX;
-            tx.ui32NumBytes    = write_length;
-            tx.pui32TxBuffer   = (uint32_t *) write_data;
-            tx.bContinue       = false;
-            tx.ui8RepeatCount  = 0;
-            tx.ui32PauseCondition = 0;
-            tx.ui32StatusSetClr = 0;
-            tx.uPeerInfo.ui32SpiChipSelect = 0xFF;
-        }
-        else if (read_data != NULL)
-        {
-            rx.ui32InstrLen    = 0;
-            rx.ui32Instr       = 0;
-            rx.eDirection      = AM_HAL_IOM_RX;
-            rx.ui32NumBytes    = read_length;
-            rx.pui32RxBuffer   = (uint32_t *) read_data;
-            rx.bContinue       = false;
-            rx.ui8RepeatCount  = 0;
-            rx.ui32PauseCondition = 0;
-            rx.ui32StatusSetClr = 0;
-            rx.uPeerInfo.ui32SpiChipSelect = 0xFF;
-        }
+static void spimst_done(void *pCallbackCtxt, uint32_t transactionStatus);
 
-        uhal_gpio_set_dir(csn, GPIO_DIR_OUT);
-         
-        if (uhal_gpio_get_logic(csn) != GPIO_LOGIC_LOW)
-        {
-            uhal_gpio_set_logic(csn, GPIO_LOGIC_LOW);
-            set_logic = true;
-        }
+// The IOM and its DMA stop with HFRC in deep sleep, keep the idle task in
+// normal sleep while either queue holds its bus.
+static void spimst_hold_latency(void)
+{
+    bool busy = false;
 
+    for (int i = 0; i < SPIMST_QUEUE_PORTS; i++)
+        busy |= spimst_queue[i].busy;
+    udrv_powersave_set_latency(UDRV_PS_LATENCY_SPI, busy ? 0 : UDRV_PS_LATENCY_ANY);
+}
 
+// Called with interrupts masked.
+static void spimst_run(spimst_queue_t *q)
+{
+    while (q->tail != q->head)
+    {
+        spimst_job_t *job = &q->jobs[q->tail];
 
-        // Direction
-        if ((write_data != NULL) && (read_data != NULL))
-        {            
-            err_code = am_hal_iom_spi_blocking_fullduplex(IOM0_Handle, &tx);
-            ERROR_CHECK(err_code);
-        }
-        else if (write_data != NULL)
+        if (job->xfer == NULL)
         {
-            err_code = am_hal_iom_blocking_transfer(IOM0_Handle, &tx);
-            ERROR_CHECK(err_code);
-        }
-        else if (read_data != NULL)
-        {
-            err_code = am_hal_iom_blocking_transfer(IOM0_Handle, &rx);
-            ERROR_CHECK(err_code);
+            // Bus hold for a blocking full-duplex transfer, ended by spimst_release().
+            q->busy = true;
+            spimst_hold_latency();
+            job->handler(q->port, UDRV_RETURN_OK, job->p_context);
+            return;
         }
 
-        if (set_logic)
+        if (q->index < job->count)
         {
-            uhal_gpio_set_logic(csn, GPIO_LOGIC_HIGH);
-        }
-        spi0_give_semaphore();
+            udrv_spimst_xfer_t *x = &job->xfer[q->index];
+            am_hal_iom_transfer_t t;
+            uint32_t remain;
+
+            if (!q->started)
+            {
+                spimst_cs_assert(q, x->csn);
+                q->started = true;
+            }
+
+            if (!q->reading && q->offset >= x->write_length)
+            {
+                q->reading = true;
+                q->offset = 0;
+            }
+            remain = (q->reading ? x->read_length : x->write_length) - q->offset;
+
+            if (remain != 0)
+            {
+                memset(&t, 0, sizeof(am_hal_iom_transfer_t));
+                t.eDirection      = q->reading ? AM_HAL_IOM_RX : AM_HAL_IOM_TX;
+                t.ui32NumBytes    = (remain > AM_HAL_IOM_MAX_TXNSIZE_SPI) ? AM_HAL_IOM_MAX_TXNSIZE_SPI : remain;
+                t.pui32TxBuffer   = (uint32_t *) (x->write_data + q->offset);
+                t.pui32RxBuffer   = (uint32_t *) (x->read_data + q->offset);
+                t.uPeerInfo.ui32SpiChipSelect = 0xFF;
+                q->offset += t.ui32NumBytes;
+
+                if (am_hal_iom_nonblocking_transfer(*q->handle, &t, spimst_done, q) == AM_HAL_STATUS_SUCCESS)
+                {
+                    q->busy = true;
+                    spimst_hold_latency();
+                    return;
+                }
+
+                // Abandon the rest of the list.
+                q->status = -UDRV_INTERNAL_ERR;
+                q->index = job->count;
+                spimst_cs_release(q);
+                continue;
+            }
+
+            if (!(x->flags & UDRV_SPIMST_XFER_KEEP_CS))
+                spimst_cs_release(q);
+
+            q->index++;
+            q->offset = 0;
+            q->reading = false;
+            q->started = false;
+            continue;
+        }
+
+        q->tail = (q->tail + 1) % SPIMST_QUEUE_DEPTH;
+        q->index = 0;
+        q->offset = 0;
+        q->reading = false;
+        q->started = false;
+        if (job->handler != NULL)
+            job->handler(q->port, q->status, job->p_context);
+        q->status = UDRV_RETURN_OK;
+    }
 
-        if(err_code == 0)
-            return 0;
-        else
-            return -1;
-    } else
-#endif
-#if SPI1_ENABLED
-    if (port == UDRV_SPIMST_1) {
-        spi1_take_semaphore();
+    q->busy = false;
+    spimst_hold_latency();
+}
 
-        am_hal_iom_transfer_t tx;
-        am_hal_iom_transfer_t rx;
-        memset(&tx, 0, sizeof(am_hal_iom_transfer_t));
-        memset(&rx, 0, sizeof(am_hal_iom_transfer_t));
+static void spimst_done(void *pCallbackCtxt, uint32_t transactionStatus)
+{
+    spimst_queue_t *q = (spimst_queue_t *) pCallbackCtxt;
+    uint32_t critical = am_hal_interrupt_master_disable();
 
-        // Direction
-        if ((write_data != NULL) && (read_data != NULL))
-        {
-            tx.ui32InstrLen    = 0;
-            tx.ui32Instr       = 0;
-            tx.eDirection      = AM_HAL_IOM_FULLDUPLEX;
-            tx.ui32NumBytes    = write_length;
-            tx.pui32TxBuffer   = (uint32_t *) write_data;
-            tx.pui32RxBuffer   = (uint32_t *) read_data;
-            tx.bContinue       = false;
-            tx.ui8RepeatCount  = 0;
-            tx.ui32PauseCondition = 0;
-            tx.ui32StatusSetClr = 0;
-            tx.uPeerInfo.ui32SpiChipSelect = 0xFF;
-        }
-        else if (write_data != NULL)
-        {
-            tx.ui32InstrLen    = 0;
-            tx.ui32Instr       = 0;
-            tx.eDirection      = AM_HAL_IOM_TX;
-            tx.ui32NumBytes    = write_length;
-            tx.pui32TxBuffer   = (uint32_t *) write_data;
-            tx.bContinue       = false;
-            tx.ui8RepeatCount  = 0;
-            tx.ui32PauseCondition = 0;
-            tx.ui32StatusSetClr = 0;
-            tx.uPeerInfo.ui32SpiChipSelect = 0xFF;
-        }
-        else if (read_data != NULL)
-        {
-            rx.ui32InstrLen    = 0;
-            rx.ui32Instr       = 0;
-            rx.eDirection      = AM_HAL_IOM_RX;
-            rx.ui32NumBytes    = read_length;
-            rx.pui32RxBuffer   = (uint32_t *) read_data;
-            rx.bContinue       = false;
-            rx.ui8RepeatCount  = 0;
-            rx.ui32PauseCondition = 0;
-            rx.ui32StatusSetClr = 0;
-            rx.uPeerInfo.ui32SpiChipSelect = 0xFF;
-        }
+    if (transactionStatus != AM_HAL_STATUS_SUCCESS)
+    {
+        q->status = -UDRV_INTERNAL_ERR;
+        q->index = q->jobs[q->tail].count;
+        spimst_cs_release(q);
+    }
+
+    spimst_run(q);
+
+    am_hal_interrupt_master_set(critical);
+}
+
+static int32_t spimst_enqueue(spimst_queue_t *q, udrv_spimst_xfer_t *xfer, uint32_t count,
+                              UDRV_SPIMST_XFER_HANDLER handler, void *p_context)
+{
+    uint32_t critical = am_hal_interrupt_master_disable();
+    uint8_t next = (q->head + 1) % SPIMST_QUEUE_DEPTH;
+
+    if (next == q->tail)
+    {
+        am_hal_interrupt_master_set(critical);
+        return -UDRV_BUSY;
+    }
+
+    q->jobs[q->head].xfer = xfer;
+    q->jobs[q->head].count = count;
+    q->jobs[q->head].handler = handler;
+    q->jobs[q->head].p_context = p_context;
+    q->head = next;
+
+    if (!q->busy)
+        spimst_run(q);
+
+    am_hal_interrupt_master_set(critical);
+    return UDRV_RETURN_OK;
+}
+
+// Take the bus without queueing when nothing is queued or running.
+static bool spimst_claim(spimst_queue_t *q)
+{
+    uint32_t critical = am_hal_interrupt_master_disable();
+    bool idle = (q->tail == q->head) && !q->busy;
+
+    if (idle)
+        q->busy = true;
+
+    am_hal_interrupt_master_set(critical);
+    return idle;
+}
+
+static void spimst_unclaim(spimst_queue_t *q)
+{
+    uint32_t critical = am_hal_interrupt_master_disable();
+
+    q->busy = false;
+    spimst_run(q);
+
+    am_hal_interrupt_master_set(critical);
+}
+
+static void spimst_release(spimst_queue_t *q)
+{
+    uint32_t critical = am_hal_interrupt_master_disable();
+
+    q->tail = (q->tail + 1) % SPIMST_QUEUE_DEPTH;
+    q->busy = false;
+    spimst_run(q);
+
+    am_hal_interrupt_master_set(critical);
+}
+
+static void spimst_wake(udrv_spimst_port port, int32_t status, void *p_context)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    *(int32_t *) p_context = status;
+    xSemaphoreGiveFromISR(spimst_queue[port].done, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+int32_t uhal_spimst_submit(udrv_spimst_port port, udrv_spimst_xfer_t *xfer, uint32_t count,
+                           UDRV_SPIMST_XFER_HANDLER handler, void *p_context) {
+    spimst_queue_t *q = spimst_get_queue(port);
+
+    if (q == NULL || xfer == NULL || count == 0)
+        return -UDRV_WRONG_ARG;
+
+    if (spimst_status[port].resumed == false)
+        return -UDRV_NOT_INIT;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if ((xfer[i].write_length != 0 && xfer[i].write_data == NULL) ||
+            (xfer[i].read_length != 0 && xfer[i].read_data == NULL))
+            return -UDRV_WRONG_ARG;
+    }
+
+    return spimst_enqueue(q, xfer, count, handler, p_context);
+}
+
+bool uhal_spimst_busy(udrv_spimst_port port) {
+    spimst_queue_t *q = spimst_get_queue(port);
+
+    return (q != NULL) && (q->busy || q->head != q->tail);
+}
+
+static int8_t spimst_fullduplex(spimst_queue_t *q, uint8_t *write_data, uint8_t *read_data, uint32_t length, uint32_t csn)
+{
+    am_hal_iom_transfer_t tx;
+    uint32_t err_code;
+
+    memset(&tx, 0, sizeof(am_hal_iom_transfer_t));
+    tx.eDirection      = AM_HAL_IOM_FULLDUPLEX;
+    tx.ui32NumBytes    = length;
+    tx.pui32TxBuffer   = (uint32_t *) write_data;
+    tx.pui32RxBuffer   = (uint32_t *) read_data;
+    tx.uPeerInfo.ui32SpiChipSelect = 0xFF;
+
+    spimst_cs_assert(q, csn);
+    err_code = am_hal_iom_spi_blocking_fullduplex(*q->handle, &tx);
+    ERROR_CHECK(err_code);
+    spimst_cs_release(q);
+
+    return (err_code == 0) ? 0 : -1;
+}
+
+int8_t uhal_spimst_trx(udrv_spimst_port port, uint8_t *write_data, uint32_t write_length, uint8_t *read_data, uint32_t read_length, uint32_t csn) {
+    spimst_queue_t *q = spimst_get_queue(port);
+    int32_t status = -UDRV_INTERNAL_ERR;
+
+    if (q == NULL)
+        return -1;
+
+    if(spimst_status[port].resumed == false)
+        return -1;
+
+    if (isInISR() || q->done == NULL)
+    {
+        // Cannot wait for the queue here; only run when the bus is free.
+        if (uhal_spimst_busy(port))
+            return -1;
 
-        uhal_gpio_set_dir(csn, GPIO_DIR_OUT);
-        if (uhal_gpio_get_logic(csn) != GPIO_LOGIC_LOW)
-        {
-            uhal_gpio_set_logic(csn, GPIO_LOGIC_LOW);
-            set_logic = true;
-        }
-        // Direction
         if ((write_data != NULL) && (read_data != NULL))
+            return spimst_fullduplex(q, write_data, read_data, write_length, csn);
+
+        am_hal_iom_transfer_t t;
+        memset(&t, 0, sizeof(am_hal_iom_transfer_t));
+        t.eDirection      = (write_data != NULL) ? AM_HAL_IOM_TX : AM_HAL_IOM_RX;
+        t.ui32NumBytes    = (write_data != NULL) ? write_length : read_length;
+        t.pui32TxBuffer   = (uint32_t *) write_data;
+        t.pui32RxBuffer   = (uint32_t *) read_data;
+        t.uPeerInfo.ui32SpiChipSelect = 0xFF;
+
+        spimst_cs_assert(q, csn);
+        status = am_hal_iom_blocking_transfer(*q->handle, &t);
+        spimst_cs_release(q);
+        return (status == 0) ? 0 : -1;
+    }
+
+    spimst_take(port);
+
+    if ((write_data != NULL) && (read_data != NULL))
+    {
+        // The IOM command queue has no full-duplex mode; run it blocking
+        // right away on an idle bus (one call per byte from the radio),
+        // else once the queue hands over the bus.
+        if (spimst_claim(q))
         {
-            err_code = am_hal_iom_spi_blocking_fullduplex(IOM1_Handle, &tx);
-            ERROR_CHECK(err_code);
-        }
-        else if (write_data != NULL)
-        {
-            err_code = am_hal_iom_blocking_transfer(IOM1_Handle, &tx);
-            ERROR_CHECK(err_code);
-        }
-        else if (read_data != NULL)
-        {
-            err_code = am_hal_iom_blocking_transfer(IOM1_Handle, &rx);
-            ERROR_CHECK(err_code);
+            status = spimst_fullduplex(q, write_data, read_data, write_length, csn);
+            spimst_unclaim(q);
         }
-
-        if (set_logic)
+        else if (spimst_enqueue(q, NULL, 0, spimst_wake, &status) == UDRV_RETURN_OK)
         {
-            uhal_gpio_set_logic(csn, GPIO_LOGIC_HIGH);
+            xSemaphoreTake(q->done, portMAX_DELAY);
+            status = spimst_fullduplex(q, write_data, read_data, write_length, csn);
+            spimst_release(q);
         }
-        spi1_give_semaphore();
-
-        if(err_code == 0)
-            return 0;
-        else
-            return -1;
-    } else
-#endif
-#if SPI2_ENABLED
-    if (port == UDRV_SPIMST_2) {
-    } else
-#endif
-#if SPI3_ENABLED
-    if (port == UDRV_SPIMST_3) {
-    } else
-#endif
+    }
+    else
     {
-        //should not be here
-        return -1;
+        udrv_spimst_xfer_t xfer = {
+            .write_data   = write_data,
+            .write_length = (write_data != NULL) ? write_length : 0,
+            .read_data    = read_data,
+            .read_length  = (read_data != NULL) ? read_length : 0,
+            .csn          = csn,
+            .flags        = 0,
+        };
+
+        if (spimst_enqueue(q, &xfer, 1, spimst_wake, &status) == UDRV_RETURN_OK)
+            xSemaphoreTake(q->done, portMAX_DELAY);
     }
 
-    return -1;
+    spimst_give(port);
+
+    return (status == 0) ? 0 : -1;
 }
 
 void uhal_spimst_suspend(void) {
     for (int i = UDRV_SPIMST_0 ; i < UDRV_SPIMST_MAX ; i++) {
-        if (spimst_status[i].active == true) {
+        if (spimst_status[i].active == true && !uhal_spimst_busy(i)) {
             spimst_deinit(i);
         }
     }
@@ -798,3 +1005,11 @@ void uhal_spimst_resume(void) {
     }
 }
 
+bool uhal_spimst_is_active(void) {
+    for (int i = UDRV_SPIMST_0 ; i < UDRV_SPIMST_MAX ; i++) {
+        if (spimst_status[i].active == true)
+            return true;
+    }
+    return false;
+}
+
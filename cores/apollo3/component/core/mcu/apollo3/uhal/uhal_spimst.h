@@ -6,6 +6,7 @@
 #include <string.h>
 #include "pin_define.h"
 #include "udrv_spimst.h"
+#include "udrv_errno.h"
 
 #include "am_mcu_apollo.h"
 #include "am_bsp.h"
@@ -17,6 +18,9 @@ void uhal_spimst_setup_freq(udrv_spimst_port port, uint32_t clk_Hz);
 void uhal_spimst_setup_byte_order(udrv_spimst_port port, bool msb_first);
 void uhal_spimst_deinit(udrv_spimst_port port);
 int8_t uhal_spimst_trx(udrv_spimst_port port, uint8_t *write_data, uint32_t write_length, uint8_t *read_data, uint32_t read_length, uint32_t csn);
+int32_t uhal_spimst_submit(udrv_spimst_port port, udrv_spimst_xfer_t *xfer, uint32_t count, UDRV_SPIMST_XFER_HANDLER handler, void *p_context);
+bool uhal_spimst_busy(udrv_spimst_port port);
 void uhal_spimst_suspend(void);
 void uhal_spimst_resume(void);
+bool uhal_spimst_is_active(void);
 #endif  // #ifndef _UHAL_SPIMST_H_
@@ -72,6 +72,7 @@ void uhal_timer_handler_handler(void *pdata)
 
 static void uhal_timer_handler_dispatcher(TimerHandle_t xTimer)
 {
+    udrv_powersave_wake_source(UDRV_PS_WAKE_SRC_TIMER);
     udrv_powersave_in_sleep = false;
 
     TimerID_E timer_id = get_apollo_timer_number(xTimer);
@@ -94,6 +95,7 @@ static void uhal_timer_handler_dispatcher(TimerHandle_t xTimer)
 
 static void uhal_sys_timer_handler_dispatcher(TimerHandle_t xTimer)
 {
+    udrv_powersave_wake_source(UDRV_PS_WAKE_SRC_TIMER);
     udrv_powersave_in_sleep = false;
 
     SysTimerID_E timer_id = get_sys_apollo_timer_number(xTimer);
@@ -1,4 +1,5 @@
 #include "uhal_twimst.h"
+#include "udrv_powersave.h"
 #include "am_bsp_pins.h"
 #include "stdbool.h"
 
@@ -19,13 +20,45 @@
 #define TWI_TIMEOUT	10000
 
 void    *IOM2_Handle;
+uint32_t IOM2_DMATCBBuffer[256];
 
 static am_hal_iom_config_t IOM2_I2cConfig =
 {
     .eInterfaceMode = AM_HAL_IOM_I2C_MODE,
-    .ui32ClockFreq  = AM_HAL_IOM_400KHZ
+    .ui32ClockFreq  = AM_HAL_IOM_400KHZ,
+    .pNBTxnBuf      = &IOM2_DMATCBBuffer[0],
+    .ui32NBTxnBufLength = sizeof(IOM2_DMATCBBuffer) / sizeof(uint32_t)
 };
 
+/* Transaction queue.
+ * Transactions are queued and run back to back from the IOM interrupt through
+ * am_hal_iom_nonblocking_transfer (command queue + DMA). A write of up to three
+ * bytes followed by a read is sent as the IOM offset of the read, which gives
+ * write, repeated start and read in a single command; longer writes are sent
+ * without stop and followed by the read.
+ */
+#define TWIMST_QUEUE_DEPTH      8
+
+typedef enum {
+    TWIMST_PHASE_START,
+    TWIMST_PHASE_READ,
+    TWIMST_PHASE_DONE,
+} twimst_phase_t;
+
+typedef struct {
+    udrv_twimst_xfer_t          *xfer;
+    UDRV_TWIMST_XFER_HANDLER    handler;
+    void                        *p_context;
+} twimst_job_t;
+
+static twimst_job_t twimst_jobs[TWIMST_QUEUE_DEPTH];
+static volatile uint8_t twimst_head;
+static volatile uint8_t twimst_tail;
+static volatile bool twimst_busy;
+static twimst_phase_t twimst_phase;
+static int32_t twimst_result;
+static SemaphoreHandle_t twi2_done = NULL;
+
 static uint8_t udrv_spimst_0_order = 0;
 static uint8_t udrv_spimst_1_order = 0;
 
@@ -104,6 +137,168 @@ void am_iomaster2_isr()
     }
 }
 
+static void twimst_done(void *pCallbackCtxt, uint32_t transactionStatus);
+
+// Called with interrupts masked.
+static void twimst_run(void)
+{
+    while (twimst_tail != twimst_head)
+    {
+        twimst_job_t *job = &twimst_jobs[twimst_tail];
+        udrv_twimst_xfer_t *x = job->xfer;
+        twimst_phase_t next = TWIMST_PHASE_DONE;
+        am_hal_iom_transfer_t t;
+
+        if (twimst_phase == TWIMST_PHASE_DONE)
+        {
+            twimst_tail = (twimst_tail + 1) % TWIMST_QUEUE_DEPTH;
+            twimst_phase = TWIMST_PHASE_START;
+            if (job->handler != NULL)
+                job->handler(UDRV_TWIMST_0, x, twimst_result, job->p_context);
+            twimst_result = UDRV_RETURN_OK;
+            continue;
+        }
+
+        memset(&t, 0, sizeof(am_hal_iom_transfer_t));
+        t.uPeerInfo.ui32I2CDevAddr = (uint32_t) x->address;
+
+        if (twimst_phase == TWIMST_PHASE_START && x->read_length != 0 &&
+            x->write_length <= AM_HAL_IOM_MAX_OFFSETSIZE)
+        {
+            t.ui32InstrLen = x->write_length;
+            for (uint16_t i = 0; i < x->write_length; i++)
+                t.ui32Instr = (t.ui32Instr << 8) | x->write_data[i];
+            t.eDirection    = AM_HAL_IOM_RX;
+            t.ui32NumBytes  = x->read_length;
+            t.pui32RxBuffer = (uint32_t *) x->read_data;
+        }
+        else if (twimst_phase == TWIMST_PHASE_START && (x->write_length != 0 || x->read_length == 0))
+        {
+            t.eDirection    = AM_HAL_IOM_TX;
+            t.ui32NumBytes  = x->write_length;
+            t.pui32TxBuffer = (uint32_t *) x->write_data;
+            t.bContinue     = (x->read_length != 0) || (x->flags & UDRV_TWIMST_XFER_NO_STOP);
+            if (x->read_length != 0)
+                next = TWIMST_PHASE_READ;
+        }
+        else
+        {
+            t.eDirection    = AM_HAL_IOM_RX;
+            t.ui32NumBytes  = x->read_length;
+            t.pui32RxBuffer = (uint32_t *) x->read_data;
+        }
+
+        twimst_phase = next;
+        if (am_hal_iom_nonblocking_transfer(IOM2_Handle, &t, twimst_done, NULL) == AM_HAL_STATUS_SUCCESS)
+        {
+            // The IOM and its DMA stop with HFRC in deep sleep
+            twimst_busy = true;
+            udrv_powersave_set_latency(UDRV_PS_LATENCY_TWI, 0);
+            return;
+        }
+
+        twimst_result = -UDRV_INTERNAL_ERR;
+        twimst_phase = TWIMST_PHASE_DONE;
+    }
+
+    twimst_busy = false;
+    udrv_powersave_set_latency(UDRV_PS_LATENCY_TWI, UDRV_PS_LATENCY_ANY);
+}
+
+static void twimst_done(void *pCallbackCtxt, uint32_t transactionStatus)
+{
+    uint32_t critical = am_hal_interrupt_master_disable();
+
+    if (transactionStatus != AM_HAL_STATUS_SUCCESS)
+    {
+        twimst_result = -UDRV_NACK;
+        twimst_phase = TWIMST_PHASE_DONE;
+    }
+
+    twimst_busy = false;
+    twimst_run();
+
+    am_hal_interrupt_master_set(critical);
+}
+
+static int32_t twimst_enqueue(udrv_twimst_xfer_t *xfer, UDRV_TWIMST_XFER_HANDLER handler, void *p_context)
+{
+    uint32_t critical = am_hal_interrupt_master_disable();
+    uint8_t next = (twimst_head + 1) % TWIMST_QUEUE_DEPTH;
+
+    if (next == twimst_tail)
+    {
+        am_hal_interrupt_master_set(critical);
+        return -UDRV_BUSY;
+    }
+
+    twimst_jobs[twimst_head].xfer = xfer;
+    twimst_jobs[twimst_head].handler = handler;
+    twimst_jobs[twimst_head].p_context = p_context;
+    twimst_head = next;
+
+    if (!twimst_busy)
+        twimst_run();
+
+    am_hal_interrupt_master_set(critical);
+    return UDRV_RETURN_OK;
+}
+
+static void twimst_wake(udrv_twimst_port port, udrv_twimst_xfer_t *xfer, int32_t status, void *p_context)
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    *(int32_t *) p_context = status;
+    xSemaphoreGiveFromISR(twi2_done, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+static bool twimst_xfer_valid(udrv_twimst_xfer_t *xfer)
+{
+    if (xfer == NULL)
+        return false;
+
+    if ((xfer->write_length != 0 && xfer->write_data == NULL) ||
+        (xfer->read_length != 0 && xfer->read_data == NULL))
+        return false;
+
+    return (xfer->write_length <= AM_HAL_IOM_MAX_TXNSIZE_I2C) &&
+           (xfer->read_length <= AM_HAL_IOM_MAX_TXNSIZE_I2C);
+}
+
+static uint32_t i2c_blocking(udrv_twimst_xfer_t *xfer)
+{
+    int32_t status = -UDRV_INTERNAL_ERR;
+
+    if (!twimst_xfer_valid(xfer))
+        return AM_HAL_STATUS_INVALID_ARG;
+
+    if (isInISR() || twi2_done == NULL)
+    {
+        // Cannot wait for the queue here; only run when the bus is free.
+        am_hal_iom_transfer_t t;
+
+        if (twimst_busy || twimst_head != twimst_tail || (xfer->read_length != 0 && xfer->write_length != 0))
+            return AM_HAL_STATUS_IN_USE;
+
+        memset(&t, 0, sizeof(am_hal_iom_transfer_t));
+        t.uPeerInfo.ui32I2CDevAddr = (uint32_t) xfer->address;
+        t.eDirection    = (xfer->read_length != 0) ? AM_HAL_IOM_RX : AM_HAL_IOM_TX;
+        t.ui32NumBytes  = (xfer->read_length != 0) ? xfer->read_length : xfer->write_length;
+        t.pui32TxBuffer = (uint32_t *) xfer->write_data;
+        t.pui32RxBuffer = (uint32_t *) xfer->read_data;
+        t.bContinue     = (xfer->flags & UDRV_TWIMST_XFER_NO_STOP) ? true : false;
+        return am_hal_iom_blocking_transfer(IOM2_Handle, &t);
+    }
+
+    twi2_take_semaphore();
+    if (twimst_enqueue(xfer, twimst_wake, &status) == UDRV_RETURN_OK)
+        xSemaphoreTake(twi2_done, portMAX_DELAY);
+    twi2_give_semaphore();
+
+    return (status == UDRV_RETURN_OK) ? AM_HAL_STATUS_SUCCESS : AM_HAL_STATUS_FAIL;
+}
+
 static void iom_set_up(void)
 {
     twi2_take_semaphore();
@@ -128,6 +323,7 @@ static void iom_set_up(void)
 
     // Enable interrupts for NB send to work
     am_hal_iom_interrupt_enable(IOM2_Handle, 0xFF);
+    NVIC_SetPriority((IRQn_Type) (IOMSTR2_IRQn), NVIC_configMAX_SYSCALL_INTERRUPT_PRIORITY);
     NVIC_EnableIRQ(IOMSTR2_IRQn);
 
     //
@@ -140,54 +336,25 @@ static void iom_set_up(void)
 
 static uint32_t i2c_read(uint8_t slave_address, uint8_t *p_data, uint32_t length)
 {
-    uint32_t err_code = 0;
-    am_hal_iom_transfer_t Transaction;
-    
-    twi2_take_semaphore();
-
-    Transaction.ui32InstrLen    = 0;
-    Transaction.ui32Instr       = 0;
-    Transaction.eDirection      = AM_HAL_IOM_RX;
-    Transaction.ui32NumBytes    = length;
-    Transaction.pui32RxBuffer   = (uint32_t *) p_data;
-    Transaction.bContinue       = false;
-    Transaction.ui8RepeatCount  = 0;
-    Transaction.ui32PauseCondition = 0;
-    Transaction.ui32StatusSetClr = 0;
-
-    Transaction.uPeerInfo.ui32I2CDevAddr = (uint32_t) slave_address;
+    udrv_twimst_xfer_t xfer = {
+        .address      = slave_address,
+        .read_data    = p_data,
+        .read_length  = length,
+    };
 
-    err_code = am_hal_iom_blocking_transfer(IOM2_Handle, &Transaction);
-
-    twi2_give_semaphore();
-
-    return err_code;
+    return i2c_blocking(&xfer);
 }
 
 static uint32_t i2c_write(uint8_t slave_address, uint8_t *p_data, uint32_t length, bool send_stop)
 {
-    uint32_t err_code = 0;
-    am_hal_iom_transfer_t Transaction;
-
-    twi2_take_semaphore();
-
-    Transaction.ui32InstrLen    = 0;
-    Transaction.ui32Instr       = 0;
-    Transaction.eDirection      = AM_HAL_IOM_TX;
-    Transaction.ui32NumBytes    = length;
-    Transaction.pui32TxBuffer   = (uint32_t *) p_data;
-    Transaction.bContinue       = (send_stop ? false : true);
-    Transaction.ui8RepeatCount  = 0;
-    Transaction.ui32PauseCondition = 0;
-    Transaction.ui32StatusSetClr = 0;
-
-    Transaction.uPeerInfo.ui32I2CDevAddr = (uint32_t) slave_address;
-
-    err_code = am_hal_iom_blocking_transfer(IOM2_Handle, &Transaction);
-
-    twi2_give_semaphore();
-
-    return err_code;
+    udrv_twimst_xfer_t xfer = {
+        .address      = slave_address,
+        .write_data   = p_data,
+        .write_length = length,
+        .flags        = send_stop ? 0 : UDRV_TWIMST_XFER_NO_STOP,
+    };
+
+    return i2c_blocking(&xfer);
 }
 
 static void iom_clean_up(void)
@@ -227,6 +394,8 @@ static void twimst_init(udrv_twimst_port port) {
         #if TWI0_ENABLED
         if(twi2_semaphore == NULL)
             twi2_semaphore = xSemaphoreCreateMutex();
+        if(twi2_done == NULL)
+            twi2_done = xSemaphoreCreateBinary();
         iom_set_up();
         #endif
     } else if (port == UDRV_TWIMST_1) {
@@ -292,6 +461,46 @@ int32_t uhal_twimst_write(udrv_twimst_port port, uint8_t twi_addr, uint8_t *data
     }
 }
 
+int32_t uhal_twimst_write_read(udrv_twimst_port port, uint8_t twi_addr, uint8_t *write_data, uint16_t write_len, uint8_t *read_data, uint16_t read_len)
+{
+    uint32_t err_code = AM_HAL_STATUS_HW_ERR;
+
+    if (port == UDRV_TWIMST_0) {
+        #if TWI0_ENABLED
+        udrv_twimst_xfer_t xfer = {
+            .address      = twi_addr,
+            .write_data   = write_data,
+            .write_length = write_len,
+            .read_data    = read_data,
+            .read_length  = read_len,
+        };
+        err_code = i2c_blocking(&xfer);
+        #endif
+    }
+
+    switch (err_code) {
+        case AM_HAL_STATUS_SUCCESS:
+            return UDRV_RETURN_OK;
+        default:
+            return -UDRV_NACK;
+    }
+}
+
+int32_t uhal_twimst_submit(udrv_twimst_port port, udrv_twimst_xfer_t *xfer, UDRV_TWIMST_XFER_HANDLER handler, void *p_context)
+{
+    if (port != UDRV_TWIMST_0 || !twimst_xfer_valid(xfer))
+        return -UDRV_WRONG_ARG;
+
+    #if TWI0_ENABLED
+    if (twimst_status[port].active == false)
+        return -UDRV_NOT_INIT;
+
+    return twimst_enqueue(xfer, handler, p_context);
+    #else
+    return -UDRV_NOT_INIT;
+    #endif
+}
+
 int32_t uhal_twimst_read(udrv_twimst_port port, uint8_t twi_addr, uint8_t * data, uint16_t len)
 {
     uint32_t err_code = AM_HAL_STATUS_HW_ERR;
@@ -314,6 +523,9 @@ int32_t uhal_twimst_read(udrv_twimst_port port, uint8_t twi_addr, uint8_t * data
 uint8_t uhal_twimst_suspend(void)
 {
     for (int i = UDRV_TWIMST_0 ; i < UDRV_TWIMST_MAX ; i++) {
+        // Keep the bus up while queued transactions are pending.
+        if (i == UDRV_TWIMST_0 && (twimst_busy || twimst_head != twimst_tail))
+            continue;
         if (twimst_status[i].active == true) {
             twimst_deinit(i);
 	}
@@ -332,3 +544,13 @@ uint8_t uhal_twimst_resume(void)
 
     return 0;
 }
+
+bool uhal_twimst_is_active(void)
+{
+    for (int i = UDRV_TWIMST_0 ; i < UDRV_TWIMST_MAX ; i++) {
+        if (twimst_status[i].active == true)
+            return true;
+    }
+
+    return false;
+}
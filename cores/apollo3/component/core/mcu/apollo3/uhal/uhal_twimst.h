@@ -17,7 +17,10 @@ void uhal_twimst_deinit(udrv_twimst_port port);
 void uhal_twimst_setup_freq(udrv_twimst_port port, uint32_t clk_Hz);
 int32_t uhal_twimst_write(udrv_twimst_port port, uint8_t twi_addr, uint8_t *data, uint16_t len, bool send_stop);
 int32_t uhal_twimst_read(udrv_twimst_port port, uint8_t twi_addr, uint8_t * data, uint16_t len);
+int32_t uhal_twimst_write_read(udrv_twimst_port port, uint8_t twi_addr, uint8_t *write_data, uint16_t write_len, uint8_t *read_data, uint16_t read_len);
+int32_t uhal_twimst_submit(udrv_twimst_port port, udrv_twimst_xfer_t *xfer, UDRV_TWIMST_XFER_HANDLER handler, void *p_context);
 uint8_t uhal_twimst_suspend(void);
 uint8_t uhal_twimst_resume(void);
+bool uhal_twimst_is_active(void);
 
 #endif  // #ifndef _UHAL_TWIMST_H_
@@ -1210,3 +1210,11 @@ void uhal_uart_resume(void) {
     }
 }
 
+bool uhal_uart_is_active(void) {
+    for (int i = SERIAL_UART0 ; i < UHAL_UART_MAX ; i++) {
+        if (uart_status[i].active == true)
+            return true;
+    }
+    return false;
+}
+
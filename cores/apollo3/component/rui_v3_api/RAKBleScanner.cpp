@@ -27,4 +27,39 @@ void RAKBleScanner::setScannerCallback(void (*userFunc) (int8_t, uint8_t *, uint
     udrv_ble_scan_data_handler ((BLE_SCAN_DATA_HANDLER)userFunc);
 }
 
+bool RAKBleScanner::setFilterRssi(int8_t min_rssi)
+{
+    return (udrv_ble_scan_filter_set_rssi(min_rssi) == 0);
+}
+
+bool RAKBleScanner::addFilterAddress(uint8_t *mac_addr)
+{
+    return (udrv_ble_scan_filter_add_address(mac_addr) == 0);
+}
+
+bool RAKBleScanner::setFilterManufacturerId(uint16_t company_id)
+{
+    return (udrv_ble_scan_filter_set_manufacturer_id(company_id) == 0);
+}
+
+bool RAKBleScanner::setFilterServiceUuid(uint8_t *uuid, uint8_t uuid_len)
+{
+    return (udrv_ble_scan_filter_set_service_uuid(uuid, uuid_len) == 0);
+}
+
+void RAKBleScanner::clearFilter(void)
+{
+    udrv_ble_scan_filter_clear();
+}
+
+bool RAKBleScanner::setDedupWindow(uint32_t window_ms)
+{
+    return (udrv_ble_scan_set_dedup_window(window_ms) == 0);
+}
+
+bool RAKBleScanner::setBatchCallback(uint32_t interval_ms, void (*userFunc) (udrv_ble_scan_batch_entry_t *, uint16_t))
+{
+    return (udrv_ble_scan_set_batch(interval_ms, (BLE_SCAN_BATCH_HANDLER)userFunc) == 0);
+}
+
 #endif
@@ -49,6 +49,73 @@ public:
    */
   void setScannerCallback(void (*userFunc) (int8_t, uint8_t *, uint8_t *, uint16_t));
 
+  /**@par	Description
+   *		Drop advertising reports weaker than the given RSSI
+   * @par	Syntax
+   *		api.ble.scanner.setFilterRssi(min_rssi)
+   * @param	min_rssi	minimum RSSI in dBm, -128 disables the threshold
+   * @return	TRUE for success SET,FALSE for SET fail(Type: bool)
+   */
+  bool setFilterRssi(int8_t min_rssi);
+
+  /**@par	Description
+   *		Add a device address to the allow-list, only listed devices are reported once the list is not empty
+   * @par	Syntax
+   *		api.ble.scanner.addFilterAddress(mac_addr)
+   * @param	mac_addr	6-byte device address, same byte order as the scan callback
+   * @return	TRUE for success SET,FALSE if the list is full(Type: bool)
+   */
+  bool addFilterAddress(uint8_t *mac_addr);
+
+  /**@par	Description
+   *		Only report advertisements carrying manufacturer specific data with this company ID
+   * @par	Syntax
+   *		api.ble.scanner.setFilterManufacturerId(company_id)
+   * @param	company_id	Bluetooth SIG company identifier
+   * @return	TRUE for success SET,FALSE for SET fail(Type: bool)
+   */
+  bool setFilterManufacturerId(uint16_t company_id);
+
+  /**@par	Description
+   *		Only report advertisements listing this service UUID (or carrying service data for it)
+   * @par	Syntax
+   *		api.ble.scanner.setFilterServiceUuid(uuid, uuid_len)
+   * @param	uuid		UUID in little-endian byte order
+   * @param	uuid_len	2 or 16
+   * @return	TRUE for success SET,FALSE for SET fail(Type: bool)
+   */
+  bool setFilterServiceUuid(uint8_t *uuid, uint8_t uuid_len);
+
+  /**@par	Description
+   *		Remove all scan filters
+   * @par	Syntax
+   *		api.ble.scanner.clearFilter()
+   * @return	void
+   */
+  void clearFilter(void);
+
+  /**@par	Description
+   *		Report each device at most once per time window.
+   *		Not applied while batching is enabled, a batch already reports each device once per interval.
+   * @par	Syntax
+   *		api.ble.scanner.setDedupWindow(window_ms)
+   * @param	window_ms	deduplication window in ms, 0 reports every advertisement
+   * @return	TRUE for success SET,FALSE for SET fail(Type: bool)
+   */
+  bool setDedupWindow(uint32_t window_ms);
+
+  /**@par	Description
+   *		Aggregate reports per device and deliver them together at a fixed interval,
+   *		each entry carries the report count, min/max/avg RSSI and the last payload.
+   *		The per-report callback is not called while batching is enabled.
+   * @par	Syntax
+   *		api.ble.scanner.setBatchCallback(interval_ms, userFunc)
+   * @param	interval_ms	batch interval in ms, 0 disables batching
+   * @param	userFunc	callback
+   * @return	TRUE for success SET,FALSE for SET fail(Type: bool)
+   */
+  bool setBatchCallback(uint32_t interval_ms, void (*userFunc) (udrv_ble_scan_batch_entry_t *, uint16_t));
+
   /**@example	example_ble_scanner/src/app.cpp
    */
 
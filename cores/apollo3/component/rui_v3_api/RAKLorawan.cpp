@@ -395,6 +395,21 @@ bool RAKLorawan::adr::set(bool value) {
     }
 }
 
+//linkadapt
+bool RAKLorawan::linkadapt::get() {
+    return service_lora_get_link_adapt();
+}
+
+bool RAKLorawan::linkadapt::set(bool value) {
+    if (SERVICE_LORAWAN != service_lora_get_nwm())
+    {
+        return false;
+    }
+
+    service_lora_set_link_adapt(value);
+    return true;
+}
+
 //deviceClass
 uint8_t RAKLorawan::deviceClass::get() {
     return service_lora_get_class();
@@ -14,6 +14,7 @@
 #include "service_lora_multicast.h"
 #include "service_battery.h"
 #include "service_lora_arssi.h"
+#include "service_lora_linkq.h"
 
 using namespace std;
 
@@ -1812,6 +1813,57 @@ public:
     bool set(bool value);
   };
 
+  /**@par	Description
+     *		This api allows the user to access the device side link adaptation
+     * @ingroup		Network
+     * @note		It only acts while ADR is off and is disabled after a reboot
+     */
+  class linkadapt
+  {
+  public:
+    /**@par	Description
+	 *     	This api allows the user to get the device side link adaptation
+	 *
+	 * @par	Syntax
+	 *	api.lorawan.linkadapt.get()
+	 *
+   * @return	bool
+	 * @retval	TRUE  : link adaptation enabled
+	 * @retval	FALSE : link adaptation disabled
+	 */
+    bool get();
+
+    /**@par	Description
+	 *     	This api allows the user to enable the device side link adaptation. LinkCheckAns margins
+	 *	and lost confirmed uplinks then move the datarate and TX power away from the configured
+	 *	ones, which are restored when it is disabled.
+	 *
+	 * @par	Syntax
+	 *	api.lorawan.linkadapt.set(value)
+	 *
+	 * @param	value	the status of link adaptation
+   * @return	bool
+	 * @retval	TRUE  for setting status of link adaptation success
+	 * @retval	FALSE for setting status of link adaptation failure
+	 * @par         Example
+         * @verbatim
+       void setup()
+       {
+           Serial.begin(115200);
+
+           api.lorawan.adr.set(0);
+           Serial.printf("Set link adaptation %s\r\n", api.lorawan.linkadapt.set(1) ? "Success" : "Fail");
+       }
+
+       void loop()
+       {
+       }
+
+           @endverbatim
+	 */
+    bool set(bool value);
+  };
+
   /**@par	Description
      *		This api allows the user to access the LoRaWAN® class
      * @ingroup		Network
@@ -3424,6 +3476,7 @@ channel mask
   njm njm;
   njs njs;
   adr adr;
+  linkadapt linkadapt;
   deviceClass deviceClass;
   dcs dcs;
   dr dr;
@@ -26,6 +26,19 @@ RAKProtocol::registerHandler(uint8_t frame_type,
     }
 }
 
+int32_t
+RAKProtocol::registerChunkHandler(uint8_t frame_type,
+				  RAK_PROTO_CHUNK_HANDLER chunk_handler)
+{
+    if (service_mode_proto_register_chunked(frame_type,
+					    (SERVICE_MODE_PROTOCOL_CHUNK_HANDLER)
+					    chunk_handler) == UDRV_RETURN_OK) {
+	return 0;
+    } else {
+	return -1;
+    }
+}
+
 int32_t
 RAKProtocol::deregisterHandler(uint8_t frame_type)
 {
@@ -19,6 +19,15 @@ typedef enum
 
 typedef void    (*RAK_PROTO_HANDLER)(int, uint8_t *, uint16_t);
 
+typedef enum
+{
+    RAK_PROTO_CHUNK_MORE = 0,   // More payload of this frame follows
+    RAK_PROTO_CHUNK_LAST,       // Last chunk, the frame checksum is correct
+    RAK_PROTO_CHUNK_ABORT,      // Checksum error or timeout, drop the chunks received so far
+} RAK_PROTO_CHUNK_STATE;
+
+typedef void    (*RAK_PROTO_CHUNK_HANDLER)(int, uint8_t *, uint16_t, uint16_t, uint16_t, RAK_PROTO_CHUNK_STATE);
+
 class           RAKProtocol {
   private:
 
@@ -79,6 +88,25 @@ class           RAKProtocol {
     int32_t         registerHandler(uint8_t frame_type,
 				    RAK_PROTO_HANDLER request_handler);
 
+    /**@par	Description
+     *      	This API is used to register a frame type whose request payload is delivered in chunks while it arrives.
+     *		The payload of such frames can be up to 65535 bytes, e.g. certificates or firmware images.
+     * @ingroup	Api_Mode
+     *
+     * @par	Syntax
+     * 		api.apiMode.registerChunkHandler(frame_type, chunk_handler);
+     *
+     * @param   frame_type             frame type header of API mode protocol
+     * @param   chunk_handler          handler called with (port, chunk, chunk length, offset, total payload length, state) \n
+     *						List of states:\n
+     *						RAK_PROTO_CHUNK_MORE\n
+     *						RAK_PROTO_CHUNK_LAST\n
+     *						RAK_PROTO_CHUNK_ABORT\n
+     *
+     */
+    int32_t         registerChunkHandler(uint8_t frame_type,
+					 RAK_PROTO_CHUNK_HANDLER chunk_handler);
+
     /**@par	Description
      *      	This API is used to deregister a frame type for API mode stack.
      * @ingroup	Api_Mode
@@ -312,3 +312,13 @@ bool RAKSystem::scheduler::task::destroy(void) {
     return true;
 }
 
+#if CFG_PROFILE
+uint8_t RAKSystem::scheduler::task::getStats(RUI_TASK_STATS *stats, uint8_t max) {
+    return service_taskmon_get(stats, max);
+}
+
+void RAKSystem::scheduler::task::resetStats(void) {
+    service_taskmon_reset();
+}
+#endif
+
@@ -13,6 +13,7 @@
 #include "service_mode_cli.h"
 #include "service_battery.h"
 #include "service_nvm.h"
+#include "service_taskmon.h"
 #ifdef SUPPORT_FS
 #include "service_fs.h"
 #endif
@@ -61,6 +62,11 @@ typedef enum {
  */
 typedef void (*RAK_TASK_HANDLER) (void);
 
+/**@par	Description
+ * 	The CPU share, context switches and minimum free stack of a task
+ */
+typedef service_taskmon_info_t RUI_TASK_STATS;
+
 /**@}*/
 
 /** @def CHANGE_ATCMD_PERM(ATCMD,ATCMD_PERMISSIONS);
@@ -1246,6 +1252,46 @@ class RAKSystem {
      */
           bool    destroy(char *name);
           bool    destroy(void);
+#if CFG_PROFILE
+    /**@par     Description
+     *      Get the CPU share, context switches and minimum free stack of every task,
+     *      only available in firmware built with CFG_PROFILE=1
+     * @ingroup System_Scheduler
+     * @par     Syntax
+     *  api.system.scheduler.task.getStats(stats, max)
+     * @param   stats filled with one entry per task
+     * @param   max capacity of stats in tasks
+     * @return  the number of tasks filled in
+     * @par         Example
+         * @verbatim
+            RUI_TASK_STATS stats[8];
+
+            void setup()
+            {
+              Serial.begin(115200);
+            }
+            void loop()
+            {
+              uint8_t n = api.system.scheduler.task.getStats(stats, 8);
+
+              for (uint8_t i = 0; i < n; i++) {
+                Serial.printf("%s %u.%u%% %u bytes free\r\n", stats[i].name, stats[i].cpu_permille / 10,
+                              stats[i].cpu_permille % 10, stats[i].stack_free);
+              }
+              delay(10000);
+            }
+           @endverbatim
+     */
+          uint8_t getStats(RUI_TASK_STATS *stats, uint8_t max);
+    /**@par     Description
+     *      Clear the CPU share and the context switches, the minimum free stack is kept
+     * @ingroup System_Scheduler
+     * @par     Syntax
+     *  api.system.scheduler.task.resetStats()
+     * @return  void
+     */
+          void    resetStats(void);
+#endif
       };
       task task;
     };
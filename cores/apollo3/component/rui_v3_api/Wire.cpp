@@ -1,3 +1,4 @@
+#include <string.h>
 #include "Wire.h"
 #include "udrv_serial.h"
 #include "udrv_errno.h"
@@ -14,9 +15,11 @@ uint8_t TwoWire::rxBufferLength = 0;
 uint8_t TwoWire::txBuffer[TWI_BUFFER_MAX];
 uint8_t TwoWire::txBufferIndex = 0;
 uint8_t TwoWire::txBufferLength = 0;
+TwoWire *TwoWire::txPending = NULL;
 
 TwoWire::TwoWire(udrv_twimst_port port) {
     TwoWire::port = port;
+    pendingFailed = false;
 }
 
 void TwoWire::begin(void)
@@ -26,12 +29,14 @@ void TwoWire::begin(void)
   
     txBufferIndex = 0;
     txBufferLength = 0;
+    pendingFailed = false;
 	
     udrv_twimst_init(port);
 }
 
 void TwoWire::end(void)
 {
+    flushPending();
     udrv_twimst_deinit(port);
 }
 
@@ -40,13 +45,65 @@ void TwoWire::setClock(uint32_t clock)
     udrv_twimst_setup_freq(port, clock);
 }
 
+// Send a write held back by endTransmission(false) on its own, on the bus of
+// the instance that held it. A failure is kept for that instance to report.
+int32_t TwoWire::flushPending(void)
+{
+  int32_t ret = UDRV_RETURN_OK;
+  TwoWire *owner = txPending;
+
+  if (owner != NULL)
+  {
+    ret = udrv_twimst_write(owner->port, owner->slaveAddress, txBuffer, txBufferLength, false);
+    if (ret != UDRV_RETURN_OK)
+      owner->pendingFailed = true;
+    txPending = NULL;
+    txBufferIndex = 0;
+    txBufferLength = 0;
+  }
+  return ret;
+}
+
 uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint32_t iaddress, uint8_t isize, uint8_t sendStop)
 {
+  int32_t ret;
+
   // clamp to buffer length
   if(quantity > TWI_BUFFER_MAX){
     quantity = TWI_BUFFER_MAX;
   }
-  int32_t ret = udrv_twimst_read(port, slaveAddress, rxBuffer, quantity);
+
+  if (isize > 0)
+  {
+    if (isize > 3)
+      isize = 3;
+
+    beginTransmission(address);
+    while (isize-- > 0)
+      write((uint8_t)(iaddress >> (isize * 8)));
+    txPending = this;
+  }
+
+  if (txPending == this && slaveAddress == address)
+  {
+    // Register read: write, repeated start and read as one transaction.
+    ret = udrv_twimst_write_read(port, address, txBuffer, txBufferLength, rxBuffer, quantity);
+    txPending = NULL;
+    txBufferIndex = 0;
+    txBufferLength = 0;
+  }
+  else
+  {
+    flushPending();
+    ret = pendingFailed ? -UDRV_NACK : udrv_twimst_read(port, address, rxBuffer, quantity);
+  }
+
+  // A held back write that failed on its own is reported here.
+  if (pendingFailed)
+  {
+    pendingFailed = false;
+    ret = -UDRV_NACK;
+  }
 //  udrv_serial_printf(ATCMD_IO_SERIAL_PORT, "udrv_twimst_read ret=%d\r\n", ret);
     
   if (!ret == 0)
@@ -81,6 +138,8 @@ uint8_t TwoWire::requestFrom(int address, int quantity, int sendStop)
 
 void TwoWire::beginTransmission(uint8_t address)
 {
+    flushPending();
+
     txBufferIndex = 0;
     txBufferLength = 0;
 
@@ -94,12 +153,30 @@ void TwoWire::beginTransmission(int address)
 
 uint32_t TwoWire::endTransmission(uint8_t sendStop)
 {
-  int32_t ret = udrv_twimst_write(port, slaveAddress, txBuffer, txBufferLength, sendStop);
+  int32_t ret = UDRV_RETURN_OK;
+
+  if (!sendStop)
+  {
+    // Held back so that a following requestFrom() from the same device goes
+    // out as one transaction; sent on its own otherwise, and a NACK is then
+    // reported by the next endTransmission() or requestFrom().
+    txPending = this;
+  }
+  else
+  {
+    ret = udrv_twimst_write(port, slaveAddress, txBuffer, txBufferLength, sendStop);
 //  udrv_serial_printf(ATCMD_IO_SERIAL_PORT, "udrv_twimst_read ret=%d\r\n", ret);
 
-  // reset tx buffer iterator vars
-  txBufferIndex = 0;
-  txBufferLength = 0;
+    // reset tx buffer iterator vars
+    txBufferIndex = 0;
+    txBufferLength = 0;
+  }
+
+  if (pendingFailed)
+  {
+    pendingFailed = false;
+    ret = -UDRV_NACK;
+  }
 
   if (!ret == UDRV_RETURN_OK)
   {
@@ -124,10 +201,14 @@ size_t TwoWire::write(uint8_t data)
 
 size_t TwoWire::write(const uint8_t *data, size_t quantity)
 {
-    for(size_t i = 0; i < quantity; ++i){
-      write(data[i]);
+    if (quantity > (size_t)(TWI_BUFFER_MAX - txBufferLength)) {
+      quantity = TWI_BUFFER_MAX - txBufferLength;
     }
 
+    memcpy(&txBuffer[txBufferIndex], data, quantity);
+    txBufferIndex += quantity;
+    txBufferLength = txBufferIndex;
+
     return quantity;
 }
 
@@ -19,6 +19,10 @@ class TwoWire : public Stream
     static uint8_t txBuffer[];
     static uint8_t txBufferIndex;
     static uint8_t txBufferLength;
+    static TwoWire *txPending;
+    bool pendingFailed;
+
+    int32_t flushPending(void);
 
   public:
     TwoWire(udrv_twimst_port);
@@ -121,6 +125,9 @@ class TwoWire : public Stream
      *
      * @retval	0		success
      * @retval	1		fail
+     * @note	With sendStop false the bytes are sent together with the next requestFrom() from the same device,
+     * 		or on their own before any other transfer. A NACK is then reported by the next endTransmission()
+     * 		or requestFrom() (which returns 0).
      * @par     Example
      * @verbatim
        void setup() {
@@ -95,6 +95,23 @@ void sleep::setup(RUI_WAKEUP_TRIGGER_MODE mode, uint32_t pin) {
   udrv_gpio_set_wakeup_enable(pin);
 }
 
+bool sleep::getStats(RUI_POWER_STATS *stats) {
+  if (stats == NULL) {
+    return false;
+  }
+
+  udrv_powersave_get_stats(stats);
+  return true;
+}
+
+void sleep::resetStats() {
+  udrv_powersave_reset_stats();
+}
+
+void sleep::setLatency(uint32_t max_us) {
+  udrv_powersave_set_latency(UDRV_PS_LATENCY_USER, max_us);
+}
+
 uint8_t lpm::get() {
   return (uint8_t)service_nvm_get_auto_sleep_time_from_nvm();
 }
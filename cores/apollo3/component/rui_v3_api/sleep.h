@@ -28,6 +28,12 @@ typedef enum
   RUI_WAKEUP_FALLING_EDGE,	///< Trigger wakeup during falling edge.
 } RUI_WAKEUP_TRIGGER_MODE;
 
+/**@par Description
+ *      power accounting counters: sleep residency and count per level, idle task sleeps per depth,
+ *      wake-ups per source for both, sleep refusals per reason and the wake-locks currently held
+ */
+typedef udrv_powersave_stats_t RUI_POWER_STATS;
+
 /**@}*/
 
 class sleep {
@@ -160,6 +166,55 @@ class sleep {
      @endverbatim
    */
   void setup(RUI_WAKEUP_TRIGGER_MODE mode, uint32_t pin);
+
+  /**@par	Description
+   *	        Get the power accounting counters collected since boot or the last resetStats()
+   * @ingroup	Powersave
+   * @par	Syntax
+   *      	api.system.sleep.getStats(&stats);
+   * @param  	stats		filled with the counters
+   * @return	bool
+   * @retval	TRUE for success
+   * @retval	FALSE for a NULL pointer
+   * @par       Example
+   * @verbatim
+     void setup()
+     {
+       Serial.begin(115200);
+     }
+
+     void loop()
+     {
+       RUI_POWER_STATS stats;
+
+       api.system.sleep.all(10000);
+       if (api.system.sleep.getStats(&stats)) {
+         Serial.printf("Asleep %u ms of %u ms\r\n", (uint32_t)stats.residency_ms[1], (uint32_t)stats.elapsed_ms);
+       }
+     }
+     @endverbatim
+   */
+  bool getStats(RUI_POWER_STATS *stats);
+
+  /**@par	Description
+   *	        Clear the power accounting counters, the held wake-locks are kept
+   * @ingroup	Powersave
+   * @par	Syntax
+   *      	api.system.sleep.resetStats();
+   * @retval void
+   */
+  void resetStats();
+
+  /**@par	Description
+   *	        Bound the time the device needs to wake up from idle sleep. Deep sleep is
+   *	        skipped while it would take longer than the bound to come back.
+   * @ingroup	Powersave
+   * @par	Syntax
+   *      	api.system.sleep.setLatency(max_us);
+   * @param  	max_us		tolerated wake-up latency in us, UINT32_MAX to remove the bound
+   * @retval void
+   */
+  void setLatency(uint32_t max_us);
 };
 
 /**@par	Description
@@ -0,0 +1,138 @@
+#include <string.h>
+#include "service_profile.h"
+#ifdef RTT_LOG_ENABLED
+#include "SEGGER_RTT.h"
+#endif
+
+#if CFG_PROFILE
+
+static service_profile_stat_t profile_stat[SERVICE_PROFILE_ZONE_MAX];
+static service_profile_trace_t profile_trace[SERVICE_PROFILE_TRACE_NUM];
+static uint32_t profile_trace_wr;
+static volatile bool profile_streaming;
+
+#ifdef RTT_LOG_ENABLED
+static uint8_t profile_rtt_buf[SERVICE_PROFILE_RTT_SIZE];
+#endif
+
+static const char * const profile_zone_name[SERVICE_PROFILE_ZONE_MAX] = {
+    "LOOP", "EVENT", "HANDLER", "SERIAL", "LORAMAC", "LMHPKG", "RADIOIRQ", "FLASH",
+};
+
+/* Zones are recorded from tasks and interrupts alike */
+#if defined(__linux__)
+#define PROFILE_LOCK()
+#define PROFILE_UNLOCK()
+#else
+#define PROFILE_LOCK()      uint32_t _primask = __get_PRIMASK(); __disable_irq()
+#define PROFILE_UNLOCK()    __set_PRIMASK(_primask)
+#endif
+
+void service_profile_init(void)
+{
+#if !defined(__linux__)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
+#ifdef RTT_LOG_ENABLED
+    SEGGER_RTT_ConfigUpBuffer(SERVICE_PROFILE_RTT_CHANNEL, "profile", profile_rtt_buf, sizeof(profile_rtt_buf), SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+#endif
+}
+
+void service_profile_record(SERVICE_PROFILE_ZONE zone, uint32_t start, uint16_t arg)
+{
+    uint32_t cycles = service_profile_now() - start;
+    service_profile_stat_t *s;
+    service_profile_trace_t rec;
+
+    if (zone >= SERVICE_PROFILE_ZONE_MAX)
+        return;
+
+    rec.start = start;
+    rec.cycles = cycles;
+    rec.zone = (uint16_t)zone;
+    rec.arg = arg;
+
+    {
+        PROFILE_LOCK();
+
+        s = &profile_stat[zone];
+        if (s->count == 0 || cycles < s->min)
+            s->min = cycles;
+        if (cycles > s->max)
+            s->max = cycles;
+        s->total += cycles;
+        s->count++;
+
+        profile_trace[profile_trace_wr++ & (SERVICE_PROFILE_TRACE_NUM - 1)] = rec;
+
+        PROFILE_UNLOCK();
+    }
+
+#ifdef RTT_LOG_ENABLED
+    //Skipped when the host does not keep up, the ring still has it
+    if (profile_streaming)
+        SEGGER_RTT_Write(SERVICE_PROFILE_RTT_CHANNEL, &rec, sizeof(rec));
+#endif
+}
+
+void service_profile_get(SERVICE_PROFILE_ZONE zone, service_profile_stat_t *stat)
+{
+    if (zone >= SERVICE_PROFILE_ZONE_MAX || stat == NULL)
+        return;
+
+    PROFILE_LOCK();
+    *stat = profile_stat[zone];
+    PROFILE_UNLOCK();
+}
+
+void service_profile_reset(void)
+{
+    PROFILE_LOCK();
+    memset(profile_stat, 0, sizeof(profile_stat));
+    profile_trace_wr = 0;
+    PROFILE_UNLOCK();
+}
+
+uint16_t service_profile_trace_read(service_profile_trace_t *buf, uint16_t max)
+{
+    uint32_t n, first;
+
+    if (buf == NULL)
+        return 0;
+
+    PROFILE_LOCK();
+    n = (profile_trace_wr < SERVICE_PROFILE_TRACE_NUM) ? profile_trace_wr : SERVICE_PROFILE_TRACE_NUM;
+    if (n > max)
+        n = max;
+    first = profile_trace_wr - n;
+    for (uint32_t i = 0; i < n; i++)
+        buf[i] = profile_trace[(first + i) & (SERVICE_PROFILE_TRACE_NUM - 1)];
+    PROFILE_UNLOCK();
+
+    return (uint16_t)n;
+}
+
+void service_profile_stream(bool enable)
+{
+    profile_streaming = enable;
+}
+
+bool service_profile_is_streaming(void)
+{
+    return profile_streaming;
+}
+
+const char *service_profile_zone_name(SERVICE_PROFILE_ZONE zone)
+{
+    return (zone < SERVICE_PROFILE_ZONE_MAX) ? profile_zone_name[zone] : "";
+}
+
+uint32_t service_profile_cycles_to_us(uint32_t cycles)
+{
+    return (uint32_t)((uint64_t)cycles * 1000000 / SERVICE_PROFILE_HZ);
+}
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef _SERVICE_PROFILE_H_
+#define _SERVICE_PROFILE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef CFG_PROFILE
+#define CFG_PROFILE 0
+#endif
+
+//Profiled zones, keep service_profile.c names in sync
+typedef enum _SERVICE_PROFILE_ZONE {
+    SERVICE_PROFILE_LOOP = 0,           // rui_running()
+    SERVICE_PROFILE_EVENT_CONSUME,      // udrv_system_event_consume()
+    SERVICE_PROFILE_EVENT_HANDLER,      // one system event, arg: the request
+    SERVICE_PROFILE_SERIAL,             // serial rx dispatch to the port mode
+    SERVICE_PROFILE_LORAMAC,            // LoRaMacProcess()
+    SERVICE_PROFILE_LMH_PACKAGES,       // LmHandlerPackagesProcess()
+    SERVICE_PROFILE_RADIO_IRQ,          // radio DIO interrupt
+    SERVICE_PROFILE_FLASH,              // flash write/erase, arg: 0 = write, 1 = erase
+    SERVICE_PROFILE_ZONE_MAX,
+} SERVICE_PROFILE_ZONE;
+
+typedef struct service_profile_stat {
+    uint32_t count;
+    uint32_t min;                       // cycles
+    uint32_t max;                       // cycles
+    uint64_t total;                     // cycles
+} service_profile_stat_t;
+
+//Binary trace record, streamed over RTT as is
+typedef struct service_profile_trace {
+    uint32_t start;                     // cycle counter at zone entry
+    uint32_t cycles;
+    uint16_t zone;
+    uint16_t arg;
+} service_profile_trace_t;
+
+#define SERVICE_PROFILE_TRACE_NUM       64      // power of 2
+#define SERVICE_PROFILE_RTT_CHANNEL     2       // 0 is the log, 1 SystemView
+#define SERVICE_PROFILE_RTT_SIZE        1024
+
+/* Cycle counter: the DWT on target, the monotonic clock in ns for Linux simulations */
+#if defined(__linux__)
+#include <time.h>
+
+#define SERVICE_PROFILE_HZ              1000000000UL
+
+static inline uint32_t service_profile_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+#else
+#include "am_mcu_apollo.h"
+
+#define SERVICE_PROFILE_HZ              SystemCoreClock
+
+static inline uint32_t service_profile_now(void)
+{
+    return DWT->CYCCNT;
+}
+#endif
+
+#if CFG_PROFILE
+#define SERVICE_PROFILE_BEGIN(zone)         uint32_t _profile_start_##zone = service_profile_now()
+#define SERVICE_PROFILE_END_ARG(zone, arg)  service_profile_record(zone, _profile_start_##zone, (uint16_t)(arg))
+#else
+#define SERVICE_PROFILE_BEGIN(zone)
+#define SERVICE_PROFILE_END_ARG(zone, arg)
+#endif
+#define SERVICE_PROFILE_END(zone)           SERVICE_PROFILE_END_ARG(zone, 0)
+
+/**
+ * @brief       Start the cycle counter and the RTT trace channel
+ */
+void service_profile_init(void);
+
+/**
+ * @brief       Account one pass through a zone, called by SERVICE_PROFILE_END()
+ * @param       zone: the zone
+ * @param       start: service_profile_now() at zone entry
+ * @param       arg: zone specific value kept in the trace
+ */
+void service_profile_record(SERVICE_PROFILE_ZONE zone, uint32_t start, uint16_t arg);
+
+void service_profile_get(SERVICE_PROFILE_ZONE zone, service_profile_stat_t *stat);
+void service_profile_reset(void);
+const char *service_profile_zone_name(SERVICE_PROFILE_ZONE zone);
+uint32_t service_profile_cycles_to_us(uint32_t cycles);
+
+/**
+ * @brief       Copy the trace ring, oldest record first
+ * @param       buf: destination
+ * @param       max: capacity of buf in records
+ * @return      number of records copied
+ */
+uint16_t service_profile_trace_read(service_profile_trace_t *buf, uint16_t max);
+
+/**
+ * @brief       Stream every trace record over RTT channel SERVICE_PROFILE_RTT_CHANNEL
+ */
+void service_profile_stream(bool enable);
+bool service_profile_is_streaming(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // #ifndef _SERVICE_PROFILE_H_
@@ -0,0 +1,176 @@
+#include <string.h>
+#include <stdbool.h>
+#include "service_taskmon.h"
+
+#if CFG_PROFILE
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timers.h"
+
+typedef struct {
+    UBaseType_t number;                 // kernel task number, 0 if the slot is free
+    bool seen;                          // found in the current snapshot
+    char name[SERVICE_TASKMON_NAME_LEN];
+    uint32_t run_last;                  // ulRunTimeCounter at the previous sample
+    uint64_t run;                       // run-time counter ticks since reset
+    uint16_t stack_min;                 // words
+} taskmon_slot_t;
+
+/*
+ * A task is given a free slot when first seen and keeps it until it is deleted.
+ * The slot index + 1 is stored as its trace tag (uxTaskNumber) for the switch hook.
+ */
+static taskmon_slot_t taskmon_slot[SERVICE_TASKMON_TASK_MAX];
+static volatile uint32_t taskmon_switch[SERVICE_TASKMON_TASK_MAX];
+static uint8_t taskmon_untracked;
+static uint32_t taskmon_total_last;
+static uint64_t taskmon_total;
+static TimerHandle_t taskmon_timer;
+
+static void taskmon_timer_handler(TimerHandle_t xTimer)
+{
+    service_taskmon_sample();
+}
+
+void service_taskmon_init(void)
+{
+    if (taskmon_timer != NULL)
+        return;
+
+    taskmon_timer = xTimerCreate("taskmon", pdMS_TO_TICKS(SERVICE_TASKMON_PERIOD_MS), pdTRUE, NULL, taskmon_timer_handler);
+    if (taskmon_timer != NULL)
+        xTimerStart(taskmon_timer, 0);
+}
+
+void service_taskmon_switched_in(uint32_t tag)
+{
+    if (tag - 1 < SERVICE_TASKMON_TASK_MAX)
+        taskmon_switch[tag - 1]++;
+}
+
+static taskmon_slot_t *taskmon_slot_find(TaskStatus_t *status)
+{
+    UBaseType_t tag = uxTaskGetTaskNumber(status->xHandle);
+    taskmon_slot_t *slot;
+
+    if (tag - 1 < SERVICE_TASKMON_TASK_MAX && taskmon_slot[tag - 1].number == status->xTaskNumber)
+        return &taskmon_slot[tag - 1];
+
+    for (uint8_t i = 0; i < SERVICE_TASKMON_TASK_MAX; i++)
+    {
+        slot = &taskmon_slot[i];
+        if (slot->number != 0)
+            continue;
+
+        memset(slot, 0, sizeof(taskmon_slot_t));
+        slot->number = status->xTaskNumber;
+        strncpy(slot->name, status->pcTaskName, SERVICE_TASKMON_NAME_LEN - 1);
+        slot->stack_min = status->usStackHighWaterMark;
+        taskmon_switch[i] = 0;
+        vTaskSetTaskNumber(status->xHandle, i + 1);
+        return slot;
+    }
+    return NULL;
+}
+
+//Called with the scheduler suspended
+static void taskmon_update(void)
+{
+    TaskStatus_t *status;
+    UBaseType_t num;
+    uint32_t total;
+
+    //The task count cannot change while the scheduler is suspended
+    num = uxTaskGetNumberOfTasks();
+    status = pvPortMalloc(num * sizeof(TaskStatus_t));
+    if (status == NULL)
+        return;
+
+    num = uxTaskGetSystemState(status, num, &total);
+    for (uint8_t i = 0; i < SERVICE_TASKMON_TASK_MAX; i++)
+        taskmon_slot[i].seen = false;
+
+    taskmon_untracked = 0;
+    for (UBaseType_t i = 0; i < num; i++)
+    {
+        taskmon_slot_t *slot = taskmon_slot_find(&status[i]);
+
+        if (slot == NULL)
+        {
+            taskmon_untracked++;
+            continue;
+        }
+
+        slot->seen = true;
+        slot->run += status[i].ulRunTimeCounter - slot->run_last;
+        slot->run_last = status[i].ulRunTimeCounter;
+        if (status[i].usStackHighWaterMark < slot->stack_min)
+            slot->stack_min = status[i].usStackHighWaterMark;
+    }
+
+    //Free the slots of deleted tasks
+    for (uint8_t i = 0; i < SERVICE_TASKMON_TASK_MAX; i++)
+    {
+        if (!taskmon_slot[i].seen)
+            taskmon_slot[i].number = 0;
+    }
+
+    taskmon_total += total - taskmon_total_last;
+    taskmon_total_last = total;
+    vPortFree(status);
+}
+
+void service_taskmon_sample(void)
+{
+    vTaskSuspendAll();
+    taskmon_update();
+    xTaskResumeAll();
+}
+
+uint8_t service_taskmon_get(service_taskmon_info_t *info, uint8_t max)
+{
+    uint8_t count = 0;
+
+    if (info == NULL)
+        return 0;
+
+    vTaskSuspendAll();
+    taskmon_update();
+    for (uint8_t i = 0; i < SERVICE_TASKMON_TASK_MAX && count < max; i++)
+    {
+        taskmon_slot_t *slot = &taskmon_slot[i];
+
+        if (slot->number == 0)
+            continue;
+
+        memcpy(info[count].name, slot->name, SERVICE_TASKMON_NAME_LEN);
+        info[count].cpu_permille = taskmon_total ? (uint16_t)(slot->run * 1000 / taskmon_total) : 0;
+        info[count].switches = taskmon_switch[i];
+        info[count].stack_free = slot->stack_min * sizeof(StackType_t);
+        count++;
+    }
+    xTaskResumeAll();
+
+    return count;
+}
+
+uint8_t service_taskmon_get_untracked(void)
+{
+    return taskmon_untracked;
+}
+
+void service_taskmon_reset(void)
+{
+    vTaskSuspendAll();
+    //Bring run_last up to date so counting restarts from now
+    taskmon_update();
+    for (uint8_t i = 0; i < SERVICE_TASKMON_TASK_MAX; i++)
+    {
+        taskmon_slot[i].run = 0;
+        taskmon_switch[i] = 0;
+    }
+    taskmon_total = 0;
+    xTaskResumeAll();
+}
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef _SERVICE_TASKMON_H_
+#define _SERVICE_TASKMON_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#ifndef CFG_PROFILE
+#define CFG_PROFILE 0
+#endif
+
+#define SERVICE_TASKMON_TASK_MAX        24      // live tasks tracked, slots of deleted tasks are reused
+#define SERVICE_TASKMON_NAME_LEN        16      // configMAX_TASK_NAME_LEN
+#define SERVICE_TASKMON_PERIOD_MS       5000    // sampling period, keeps the 32-bit run-time counters from wrapping
+
+typedef struct service_taskmon_info {
+    char name[SERVICE_TASKMON_NAME_LEN];
+    uint16_t cpu_permille;              // share of the run time since boot or the last reset
+    uint32_t switches;                  // times the task was switched in since boot or the last reset
+    uint32_t stack_free;                // minimum free stack ever seen, in bytes
+} service_taskmon_info_t;
+
+/**
+ * @brief       Start the periodic sampling timer
+ */
+void service_taskmon_init(void);
+
+/**
+ * @brief       Fold the FreeRTOS run-time counters and stack high-water marks into the statistics
+ */
+void service_taskmon_sample(void);
+
+/**
+ * @brief       Take a sample and copy the per-task statistics
+ * @param       info: destination
+ * @param       max: capacity of info in tasks
+ * @return      number of tasks copied
+ */
+uint8_t service_taskmon_get(service_taskmon_info_t *info, uint8_t max);
+
+/**
+ * @brief       Clear the run time and switch counts, the stack minimums are kept
+ */
+void service_taskmon_reset(void);
+
+/**
+ * @brief       Number of live tasks left out of the last sample because all slots were taken
+ */
+uint8_t service_taskmon_get_untracked(void);
+
+/**
+ * @brief       traceTASK_SWITCHED_IN() hook, called by the kernel on every context switch
+ * @param       tag: uxTaskNumber of the task, its slot index + 1 or 0 if it has no slot yet
+ */
+void service_taskmon_switched_in(uint32_t tag);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // #ifndef _SERVICE_TASKMON_H_
@@ -406,6 +406,10 @@ static void LmhpFragmentationOnMcpsIndication( McpsIndication_t *mcpsIndication
                     fragSessionData.FragDecoderPorcessStatus = FRAG_SESSION_ONGOING;
                     FragSessionData[fragSessionData.FragGroupData.FragSession.Fields.FragIndex] = fragSessionData;
 #if( FRAG_DECODER_FILE_HANDLING_NEW_API == 1 )
+                    if( LmhpFragmentationParams->OnSessionReset != NULL )
+                    {
+                        LmhpFragmentationParams->OnSessionReset( );
+                    }
                     FragDecoderInit( fragSessionData.FragGroupData.FragNb,
                                      fragSessionData.FragGroupData.FragSize,
                                      &LmhpFragmentationParams->DecoderCallbacks );
@@ -441,6 +445,13 @@ static void LmhpFragmentationOnMcpsIndication( McpsIndication_t *mcpsIndication
                 {
                     // Delete session
                     FragSessionData[id].FragGroupData.IsActive = false;
+                    FragSessionData[id].FragDecoderPorcessStatus = FRAG_SESSION_NOT_STARTED;
+#if( FRAG_DECODER_FILE_HANDLING_NEW_API == 1 )
+                    if( LmhpFragmentationParams->OnSessionReset != NULL )
+                    {
+                        LmhpFragmentationParams->OnSessionReset( );
+                    }
+#endif
                 }
                 LmhpFragmentationState.DataBuffer[dataBufferIndex++] = FRAGMENTATION_FRAG_SESSION_DELETE_ANS;
                 LmhpFragmentationState.DataBuffer[dataBufferIndex++] = status;
@@ -488,11 +499,13 @@ static void LmhpFragmentationOnMcpsIndication( McpsIndication_t *mcpsIndication
                 if( FragSessionData[fragIndex].FragDecoderPorcessStatus >= 0 )
                 {
                     // Fragmentation successfully done
+                    int32_t processStatus = FragSessionData[fragIndex].FragDecoderPorcessStatus;
+
                     FragSessionData[fragIndex].FragDecoderPorcessStatus = FRAG_SESSION_NOT_STARTED;
                     if( LmhpFragmentationParams->OnDone != NULL )
                     {
 #if( FRAG_DECODER_FILE_HANDLING_NEW_API == 1 )
-                        LmhpFragmentationParams->OnDone( FragSessionData[fragIndex].FragDecoderPorcessStatus,
+                        LmhpFragmentationParams->OnDone( processStatus,
                                                             ( FragSessionData[fragIndex].FragGroupData.FragNb * FragSessionData[fragIndex].FragGroupData.FragSize ) - FragSessionData[fragIndex].FragGroupData.Padding );
 #else
                         LmhpFragmentationParams->OnDone( FragSessionData[fragIndex].FragDecoderPorcessStatus,
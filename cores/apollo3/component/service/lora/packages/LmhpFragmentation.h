@@ -74,6 +74,11 @@ typedef struct LmhpFragmentationParams_s
      * \param [IN] size   Received file size
      */
     void ( *OnDone )( int32_t status, uint32_t size );
+    /*!
+     * Notifies that a fragmentation session was set up or deleted, anything
+     * written through DecoderCallbacks for an earlier session is stale
+     */
+    void ( *OnSessionReset )( void );
 #else
     /*!
      * Notifies that the fragmentation session is finished
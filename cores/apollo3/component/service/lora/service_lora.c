@@ -18,6 +18,7 @@
 #include "service_lora_certification.h"
 #include "RegionNvm.h"
 #include "service_lora_arssi.h"
+#include "service_lora_linkq.h"
 #include "service_lora_test.h"
 #include "LmHandler.h"
 #include "LmhPackage.h"
@@ -131,14 +132,39 @@ static SingleChannel_t SingleChannelUS915 =
 };
 #ifndef STM32WLE5xx
 static uint32_t flash_base_size;
+/* Fragments are gathered page by page, in the flash driver's page buffer,
+ * instead of rewriting a whole flash page for every fragment. */
+static udrv_flash_stream_t fuota_stream = {.page_index = UDRV_FLASH_STREAM_NO_PAGE};
+/* The FragDecoder ignores write errors, the session fails at OnDone instead */
+static bool fuota_stream_failed;
+static void fuota_OnFragSessionReset( void )
+{
+    /* Forget the erased/programmed pages and the dirty page of an earlier session */
+    fuota_stream_failed = (udrv_flash_stream_open(&fuota_stream, MCU_FLASH_OTA_ADDRESS,
+                                                  MCU_BOOTLOADER_FLAG_LOCATION - MCU_FLASH_OTA_ADDRESS,
+                                                  NULL) != UDRV_RETURN_OK);
+    if (fuota_stream_failed)
+    {
+        udrv_serial_log_printf("FUOTA flash stream open failed\r\n");
+    }
+}
 static int8_t fuota_FragDecoderWrite( uint32_t addr, uint8_t *data, uint32_t size )
 {
-    udrv_flash_write(MCU_FLASH_OTA_ADDRESS + addr, size, data);
+    if (fuota_stream.page == NULL ||
+        udrv_flash_stream_write(&fuota_stream, addr, data, size) != UDRV_RETURN_OK)
+    {
+        fuota_stream_failed = true;
+        return -1;
+    }
     return 0;
 }
 static int8_t fuota_FragDecoderRead( uint32_t addr, uint8_t *data , uint32_t size )
 {
-    udrv_flash_read(MCU_FLASH_OTA_ADDRESS + addr, size, data);
+    if (fuota_stream.page == NULL ||
+        udrv_flash_stream_read(&fuota_stream, addr, data, size) != UDRV_RETURN_OK)
+    {
+        return -1;
+    }
     return 0;
 }
 static void fuota_OnFragProgress( uint16_t fragCounter, uint16_t fragNb, uint8_t fragSize, uint16_t fragNbLost )
@@ -150,6 +176,12 @@ static void fuota_OnFragProgress( uint16_t fragCounter, uint16_t fragNb, uint8_t
 }
 static void fuota_OnFragDone( int32_t status, uint32_t size )
 {
+    int32_t ret = udrv_flash_stream_close(&fuota_stream);
+    if (fuota_stream_failed || FragDecoderGetStatus().MatrixError != 0 || ret != UDRV_RETURN_OK)
+    {
+        udrv_serial_log_printf("FUOTA Failed\r\n");
+        return;
+    }
     udrv_serial_log_printf("FUOTA Completed\r\n");
     uint8_t flash_base_flag = 0xaa;
     udrv_flash_write(MCU_BOOTLOADER_FLAG_LOCATION+4, 1, &flash_base_flag);
@@ -167,6 +199,7 @@ static LmhpFragmentationParams_t LmhpFragmentationParam1 =
     },
     .OnProgress = fuota_OnFragProgress,
     .OnDone = fuota_OnFragDone,
+    .OnSessionReset = fuota_OnFragSessionReset,
 #endif
 };
 
@@ -348,6 +381,7 @@ static void McpsConfirm(McpsConfirm_t *mcpsConfirm)
 
     if( mcpsConfirm->McpsRequest == MCPS_CONFIRMED)
     {
+        service_lora_linkq_tx(mcpsConfirm->AckReceived);
         if(mcpsConfirm->AckReceived)
             udrv_serial_log_printf("+EVT:SEND_CONFIRMED_OK\r\n");
         else
@@ -369,6 +403,8 @@ static void McpsIndication(McpsIndication_t *mcpsIndication)
         rssi = mcpsIndication->Rssi;
         snr = mcpsIndication->Snr;
         service_lora_arssi_rx_callback(rssi);
+        service_lora_linkq_rx(rssi, snr);
+        MulticastMcpsIndication(mcpsIndication);
 
         if (mcpsIndication->BufferSize > 0)
         {
@@ -681,6 +717,10 @@ static void MlmeConfirm(MlmeConfirm_t *mlmeConfirm)
         DemodMargin = mlmeConfirm->DemodMargin;
         NbGateways = mlmeConfirm->NbGateways;
         linkcheck_state = mlmeConfirm->Status;
+        if(linkcheck_state == LORAMAC_EVENT_INFO_STATUS_OK)
+        {
+            service_lora_linkq_margin(DemodMargin);
+        }
         if(linkcheck_state!= LORAMAC_EVENT_INFO_STATUS_OK)
         {
             udrv_serial_log_printf("+EVT:LINKCHECK:1:0:0:0:0\r\n");
@@ -1869,6 +1909,7 @@ int32_t service_lora_send(uint8_t *buff, uint32_t len, SERVICE_LORA_SEND_INFO in
         }
     }
 
+    service_lora_linkq_apply(&dr);
     mcpsReq.Req.Unconfirmed.Datarate = dr;
     mcpsReq.Req.Confirmed.Datarate = dr;
 
@@ -0,0 +1,222 @@
+#ifdef SUPPORT_LORA
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "udrv_errno.h"
+#include "service_lora.h"
+#include "service_nvm.h"
+#include "service_lora_linkq.h"
+#include "LoRaMac.h"
+#include "Region.h"
+
+static bool link_adapt;
+
+static int16_t rx_rssi[LINKQ_WINDOW];
+static int8_t rx_snr[LINKQ_WINDOW];
+static uint8_t rx_head, rx_count;
+
+static uint8_t margin[LINKQ_WINDOW];
+static uint8_t margin_head, margin_count;
+
+static uint16_t tx_lost_bits;           // one bit per confirmed uplink, set if lost
+static uint8_t tx_count;
+
+static int8_t adapt_dr = -1;
+static int8_t adapt_base_dr = -1;       // configured datarate adapt_dr started from
+static int8_t adapt_txp;
+static int8_t adapt_base_txp;           // configured TX power adapt_txp started from
+
+// Put the configured datarate and TX power back into the MAC, the MAC MIB
+// holds the adapted ones
+static void linkq_restore(void)
+{
+    if (adapt_base_dr < 0)
+        return;
+
+    service_lora_set_dr(service_nvm_get_dr_from_nvm(), false);
+    service_lora_set_txpower(service_nvm_get_txpower_from_nvm(), false);
+}
+
+// Drop the margin and loss history, it belongs to the previous setting
+static void linkq_restart(void)
+{
+    margin_head = margin_count = 0;
+    tx_lost_bits = 0;
+    tx_count = 0;
+}
+
+void service_lora_set_link_adapt(bool enable)
+{
+    link_adapt = enable;
+    service_lora_linkq_reset();
+}
+
+bool service_lora_get_link_adapt(void)
+{
+    return link_adapt;
+}
+
+void service_lora_linkq_reset(void)
+{
+    linkq_restore();
+    rx_head = rx_count = 0;
+    linkq_restart();
+    adapt_dr = adapt_base_dr = -1;
+    adapt_txp = adapt_base_txp = 0;
+}
+
+void service_lora_linkq_rx(int16_t rssi, int8_t snr)
+{
+    rx_rssi[rx_head] = rssi;
+    rx_snr[rx_head] = snr;
+    rx_head = (rx_head + 1) % LINKQ_WINDOW;
+    if (rx_count < LINKQ_WINDOW)
+        rx_count++;
+}
+
+void service_lora_linkq_margin(uint8_t demod_margin)
+{
+    margin[margin_head] = demod_margin;
+    margin_head = (margin_head + 1) % LINKQ_WINDOW;
+    if (margin_count < LINKQ_WINDOW)
+        margin_count++;
+}
+
+void service_lora_linkq_tx(bool acked)
+{
+    tx_lost_bits = (tx_lost_bits << 1) | (acked ? 0 : 1);
+    if (tx_count < LINKQ_WINDOW)
+        tx_count++;
+}
+
+static uint8_t linkq_tx_lost(void)
+{
+    uint16_t bits = tx_lost_bits;
+
+    if (tx_count < LINKQ_WINDOW)
+        bits &= (1 << tx_count) - 1;
+    return __builtin_popcount(bits);
+}
+
+static uint8_t linkq_margin_min(void)
+{
+    uint8_t min = UINT8_MAX;
+
+    for (uint8_t i = 0; i < margin_count; i++)
+    {
+        if (margin[i] < min)
+            min = margin[i];
+    }
+    return min;
+}
+
+void service_lora_linkq_get(service_lora_linkq_t *linkq)
+{
+    int32_t rssi_sum = 0, snr_sum = 0;
+
+    memset(linkq, 0, sizeof(service_lora_linkq_t));
+
+    linkq->rx_samples = rx_count;
+    if (rx_count != 0)
+    {
+        linkq->snr_min = INT8_MAX;
+        for (uint8_t i = 0; i < rx_count; i++)
+        {
+            rssi_sum += rx_rssi[i];
+            snr_sum += rx_snr[i];
+            if (rx_snr[i] < linkq->snr_min)
+                linkq->snr_min = rx_snr[i];
+        }
+        linkq->rssi_avg = rssi_sum / rx_count;
+        linkq->snr_avg = snr_sum / rx_count;
+    }
+
+    linkq->margin_samples = margin_count;
+    if (margin_count != 0)
+    {
+        linkq->margin_min = linkq_margin_min();
+        linkq->margin_last = margin[(margin_head + LINKQ_WINDOW - 1) % LINKQ_WINDOW];
+    }
+
+    linkq->tx_samples = tx_count;
+    linkq->tx_lost = linkq_tx_lost();
+    linkq->dr = adapt_dr;
+    linkq->txpower = adapt_txp;
+}
+
+void service_lora_linkq_apply(SERVICE_LORA_DATA_RATE *dr)
+{
+    GetPhyParams_t getPhy;
+    PhyParam_t phyParam;
+    int8_t min_dr;
+    bool more_robust = false;
+    int8_t steps = 0;
+
+    if (link_adapt == false)
+        return;
+
+    if (service_lora_get_adr() == true)
+    {
+        // The network server owns the datarate and TX power now
+        if (adapt_base_dr >= 0)
+            service_lora_linkq_reset();
+        return;
+    }
+
+    // (Re)start from the configured values when they have been changed
+    if (adapt_base_dr != (int8_t)*dr || adapt_base_txp != (int8_t)service_nvm_get_txpower_from_nvm())
+    {
+        linkq_restore();
+        adapt_base_dr = adapt_dr = (int8_t)*dr;
+        adapt_base_txp = adapt_txp = (int8_t)service_nvm_get_txpower_from_nvm();
+        linkq_restart();
+    }
+
+    getPhy.Attribute = PHY_MIN_TX_DR;
+    getPhy.UplinkDwellTime = 0;
+    phyParam = RegionGetPhyParam((LoRaMacRegion_t)service_lora_get_band(), &getPhy);
+    min_dr = phyParam.Value;
+
+    if (tx_count >= LINKQ_LOSS_MIN_SAMPLES &&
+        linkq_tx_lost() * 100 >= LINKQ_LOSS_PERCENT * tx_count)
+    {
+        more_robust = true;
+    }
+    else if (margin_count != 0)
+    {
+        int16_t spare = (int16_t)linkq_margin_min() - LINKQ_INSTALL_MARGIN;
+
+        if (spare < 0)
+            more_robust = true;
+        else
+            steps = spare / LINKQ_STEP_DB;
+    }
+
+    if (more_robust)
+    {
+        // Full power first, then a lower datarate
+        if (adapt_txp != 0 && service_lora_set_txpower(0, false) == UDRV_RETURN_OK)
+            adapt_txp = 0;
+        else if (adapt_dr > min_dr && service_lora_set_dr((SERVICE_LORA_DATA_RATE)(adapt_dr - 1), false) == UDRV_RETURN_OK)
+            adapt_dr--;
+    }
+    else if (steps > 0)
+    {
+        // One step per decision, a higher datarate first, then less power
+        if (adapt_dr < LINKQ_MAX_DR && service_lora_set_dr((SERVICE_LORA_DATA_RATE)(adapt_dr + 1), false) == UDRV_RETURN_OK)
+            adapt_dr++;
+        else if (service_lora_set_txpower(adapt_txp + 1, false) == UDRV_RETURN_OK)
+            adapt_txp++;
+    }
+
+    if (more_robust || steps > 0)
+    {
+        // Wait for fresh samples at the new setting
+        linkq_restart();
+    }
+
+    *dr = (SERVICE_LORA_DATA_RATE)adapt_dr;
+}
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef __SERVICE_LORA_LINKQ_H__
+#define __SERVICE_LORA_LINKQ_H__
+
+#ifdef SUPPORT_LORA
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include <stdint.h>
+#include <stdbool.h>
+#include "service_lora.h"
+
+#define LINKQ_WINDOW            16      // samples kept for each metric
+#define LINKQ_INSTALL_MARGIN    10      // dB kept above the demodulation floor
+#define LINKQ_STEP_DB           3       // margin worth one datarate or TX power step
+#define LINKQ_LOSS_MIN_SAMPLES  4       // confirmed uplinks needed to judge the loss ratio
+#define LINKQ_LOSS_PERCENT      50      // loss ratio that makes the link more robust
+#define LINKQ_MAX_DR            DR_5    // highest datarate the engine moves up to
+
+typedef struct service_lora_linkq_s
+{
+    uint8_t rx_samples;         // downlinks in the window
+    int16_t rssi_avg;
+    int8_t snr_avg;
+    int8_t snr_min;
+    uint8_t margin_samples;     // LinkCheckAns in the window
+    uint8_t margin_min;
+    uint8_t margin_last;
+    uint8_t tx_samples;         // confirmed uplinks in the window
+    uint8_t tx_lost;
+    int8_t dr;                  // datarate chosen by the engine, -1 if not running
+    int8_t txpower;
+} service_lora_linkq_t;
+
+/**
+ * Device side link adaptation, only applied while ADR is off.
+ * LinkCheckAns margins move the datarate up then the TX power down,
+ * lost confirmed uplinks move them back.
+ */
+void service_lora_set_link_adapt(bool enable);
+bool service_lora_get_link_adapt(void);
+
+void service_lora_linkq_reset(void);
+void service_lora_linkq_rx(int16_t rssi, int8_t snr);
+void service_lora_linkq_margin(uint8_t margin);
+void service_lora_linkq_tx(bool acked);
+void service_lora_linkq_get(service_lora_linkq_t *linkq);
+
+/**
+ * Pick the datarate and TX power of the next uplink.
+ * @param dr    in: configured datarate, out: datarate to use
+ */
+void service_lora_linkq_apply(SERVICE_LORA_DATA_RATE *dr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // end SUPPORT_LORA
+
+#endif // end service_lora_linkq.h
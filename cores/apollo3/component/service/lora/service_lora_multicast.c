@@ -28,7 +28,19 @@
 #define LORAMAC_MAX_MC_CTX 4
 
 McSession_t McSession_group[LORAMAC_MAX_MC_CTX];
+static McSessionStats_t McSession_stats[LORAMAC_MAX_MC_CTX];
 
+/* Group index of a multicast address, -1 if there is none.
+ * LORAMAC_MAX_MC_CTX is 4, a scan is as fast as any table here. */
+static int8_t mc_find(uint32_t devaddr)
+{
+    for (int8_t i = 0; i < LORAMAC_MAX_MC_CTX; i++)
+    {
+        if (McSession_group[i].Address == devaddr)
+            return i;
+    }
+    return -1;
+}
 
 int32_t service_lora_addmulc(McSession_t McSession)
 {
@@ -38,11 +50,8 @@ int32_t service_lora_addmulc(McSession_t McSession)
     McChannelParams_t channel;
     uint8_t status = 0x00;
 
-    for (i = 0; i < 4; i++)
-    {
-        if (McSession.Address == McSession_group[i].Address)
-            return -UDRV_PARAM_ERR;
-    }
+    if (mc_find(McSession.Address) >= 0)
+        return -UDRV_PARAM_ERR;
 
     for (i = 0; i < 4; i++)
     {
@@ -347,6 +356,7 @@ int32_t service_lora_addmulc(McSession_t McSession)
             }
 
             memcpy(&McSession_group[i], &McSession, sizeof(McSession_t));   
+            memset(&McSession_stats[i], 0, sizeof(McSessionStats_t));
             if(service_nvm_set_multicast_to_nvm(McSession_group)!=UDRV_RETURN_OK)
             {
                 return -UDRV_INTERNAL_ERR;
@@ -358,7 +368,6 @@ int32_t service_lora_addmulc(McSession_t McSession)
     }
      if (i == 4)
     {
-        memset(&McSession_group[i], 0, sizeof(McSession_t));
         return -UDRV_PARAM_ERR;
     }
 
@@ -367,24 +376,19 @@ int32_t service_lora_addmulc(McSession_t McSession)
 
 int32_t service_lora_rmvmulc(uint32_t devaddr)
 {
-    uint8_t i;
-    for(i=0;i<4;i++)
+    int8_t i = mc_find(devaddr);
+
+    if(i < 0)
     {
-        if((McSession_group[i].Address) == devaddr)
-        {
-            if(LoRaMacMcChannelDelete((AddressIdentifier_t)(McSession_group[i].GroupID)) != LORAMAC_STATUS_OK)
-            {
-                return -UDRV_INTERNAL_ERR;
-            }
-            memset(&McSession_group[i], 0, sizeof(McSession_t));
-            if(service_nvm_set_multicast_to_nvm(McSession_group)!=UDRV_RETURN_OK)
-            {
-                return -UDRV_INTERNAL_ERR;
-            }
-            break;
-        }
+        return -UDRV_INTERNAL_ERR;
+    }
+    if(LoRaMacMcChannelDelete((AddressIdentifier_t)(McSession_group[i].GroupID)) != LORAMAC_STATUS_OK)
+    {
+        return -UDRV_INTERNAL_ERR;
     }
-    if(i==4)
+    memset(&McSession_group[i], 0, sizeof(McSession_t));
+    memset(&McSession_stats[i], 0, sizeof(McSessionStats_t));
+    if(service_nvm_set_multicast_to_nvm(McSession_group)!=UDRV_RETURN_OK)
     {
         return -UDRV_INTERNAL_ERR;
     }
@@ -441,8 +445,59 @@ int32_t service_lora_lstmulc(McSession_t *iterator)
     return -UDRV_CONTINUE;
 }
 
+int32_t service_lora_get_multicast_list(McSession_t *list, uint8_t max, uint8_t *count)
+{
+    uint8_t n = 0;
+
+    if (list == NULL || count == NULL)
+    {
+        return -UDRV_WRONG_ARG;
+    }
+
+    for (uint8_t i = 0 ; i < LORAMAC_MAX_MC_CTX && n < max ; i++)
+    {
+        if (McSession_group[i].Address == 0)
+            continue;
+        memcpy(&list[n], &McSession_group[i], sizeof(McSession_t));
+        list[n].entry = i + 1;
+        n++;
+    }
+    *count = n;
+    return UDRV_RETURN_OK;
+}
+
+int32_t service_lora_get_multicast_stats(uint32_t devaddr, McSessionStats_t *stats)
+{
+    int8_t i;
+
+    if (stats == NULL || devaddr == 0 || (i = mc_find(devaddr)) < 0)
+    {
+        return -UDRV_WRONG_ARG;
+    }
+    memcpy(stats, &McSession_stats[i], sizeof(McSessionStats_t));
+    return UDRV_RETURN_OK;
+}
+
 void MulticastMcpsIndication(McpsIndication_t *mcpsIndication)
 {
+    McSessionStats_t *stats;
+    int8_t i;
+
+    if (mcpsIndication->Multicast != 1 || mcpsIndication->DevAddress == 0)
+        return;
+
+    if ((i = mc_find(mcpsIndication->DevAddress)) < 0)
+        return;
+
+    stats = &McSession_stats[i];
+    if (stats->Frames != 0 && mcpsIndication->DownLinkCounter > stats->LastFCnt + 1)
+    {
+        stats->FCntGaps += mcpsIndication->DownLinkCounter - stats->LastFCnt - 1;
+    }
+    stats->Frames++;
+    stats->LastFCnt = mcpsIndication->DownLinkCounter;
+    stats->LastRssi = mcpsIndication->Rssi;
+    stats->LastSnr = mcpsIndication->Snr;
 }
 
 
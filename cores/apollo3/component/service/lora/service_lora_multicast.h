@@ -35,11 +35,22 @@ typedef struct McSession_s
     uint8_t entry;
 }McSession_t;
 
+typedef struct McSessionStats_s
+{
+    uint32_t Frames;        // Downlinks received for the group
+    uint32_t FCntGaps;      // Downlinks missed, from the FCnt jumps
+    uint32_t LastFCnt;
+    int16_t LastRssi;
+    int8_t LastSnr;
+}McSessionStats_t;
+
 
 
 int32_t service_lora_addmulc(McSession_t McSession);
 int32_t service_lora_rmvmulc(uint32_t devaddr);
 int32_t service_lora_lstmulc(McSession_t *iterator);
+int32_t service_lora_get_multicast_list(McSession_t *list, uint8_t max, uint8_t *count);
+int32_t service_lora_get_multicast_stats(uint32_t devaddr, McSessionStats_t *stats);
 void MulticastMcpsIndication( McpsIndication_t *mcpsIndication );
 int32_t service_lora_setup_multicast(void);
 int32_t service_lora_clear_multicast(void);
@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include "udrv_errno.h"
 #include "udrv_serial.h"
+#include "udrv_powersave.h"
 #include "board_basic.h"
 #include "service_nvm.h"
 #include "service_lora_p2p.h"
@@ -110,7 +111,7 @@ static void OnTxDone(void)
         udrv_serial_log_printf("+EVT:TXFSK DONE\r\n");
 
 
-    udrv_powersave_wake_unlock();   
+    udrv_powersave_wake_unlock_by(UDRV_PS_WLOCK_LORA_P2P);   
 
     if(lora_p2p_status.isContinue_compatible_tx == true)
     {
@@ -171,7 +172,7 @@ static void OnRxDone(uint8_t *payload, uint16_t size, int16_t rssi, int8_t snr)
         return ;
     }
     Radio.Standby();
-    udrv_powersave_wake_unlock();
+    udrv_powersave_wake_unlock_by(UDRV_PS_WLOCK_LORA_P2P);
 }
 
 static void OnTxTimeout(void)
@@ -207,7 +208,7 @@ static void OnRxTimeout(void)
         (*service_lora_p2p_recv_callback)(recv_data_pkg);
     }
     Radio.Standby();
-    udrv_powersave_wake_unlock();
+    udrv_powersave_wake_unlock_by(UDRV_PS_WLOCK_LORA_P2P);
 }
 
 static void OnRxError(void)
@@ -235,7 +236,7 @@ static void OnRxError(void)
     else
     {
         Radio.Standby();
-        udrv_powersave_wake_unlock();
+        udrv_powersave_wake_unlock_by(UDRV_PS_WLOCK_LORA_P2P);
     }
 }
 
@@ -383,7 +384,7 @@ int32_t service_lora_p2p_send(uint8_t *p_data, uint8_t len, bool cad_enable)
     else
         memcpy(lora_p2p_buf, p_data, len);
 
-    udrv_powersave_wake_lock();
+    udrv_powersave_wake_lock_by(UDRV_PS_WLOCK_LORA_P2P);
     Radio.Standby();
 
     lora_p2p_status.isRadioBusy = true;
@@ -467,7 +468,7 @@ int32_t service_lora_p2p_recv(uint32_t timeout)
         lora_p2p_status.isRadioBusy = false;
         lora_p2p_status.isContinue_no_exit = false;
         lora_p2p_status.isContinue_compatible_tx = false;
-        udrv_powersave_wake_unlock ();   
+        udrv_powersave_wake_unlock_by(UDRV_PS_WLOCK_LORA_P2P);   
         Radio.Standby();
     }
     else if (timeout == 65535)
@@ -477,7 +478,7 @@ int32_t service_lora_p2p_recv(uint32_t timeout)
         service_lora_p2p_config();
         Radio.Standby();
         Radio.Rx(0);  
-        udrv_powersave_wake_lock();   
+        udrv_powersave_wake_lock_by(UDRV_PS_WLOCK_LORA_P2P);   
     }
     else if (timeout == 65534)
     {
@@ -485,7 +486,7 @@ int32_t service_lora_p2p_recv(uint32_t timeout)
         service_lora_p2p_config();
         Radio.Standby();
         Radio.Rx(0); 
-        udrv_powersave_wake_lock();
+        udrv_powersave_wake_lock_by(UDRV_PS_WLOCK_LORA_P2P);
     }
     else if (timeout == 65533)
     {
@@ -493,13 +494,13 @@ int32_t service_lora_p2p_recv(uint32_t timeout)
         service_lora_p2p_config();
         Radio.Standby();
         Radio.Rx(0); 
-        udrv_powersave_wake_lock();
+        udrv_powersave_wake_lock_by(UDRV_PS_WLOCK_LORA_P2P);
     }
     else
     {
         LORA_P2P_DEBUG("Start recv data\r\n");
         Radio.Rx(timeout);
-        udrv_powersave_wake_lock();
+        udrv_powersave_wake_lock_by(UDRV_PS_WLOCK_LORA_P2P);
     }
     return UDRV_RETURN_OK;
 }
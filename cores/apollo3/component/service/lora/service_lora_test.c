@@ -5,6 +5,7 @@
 #include <stdint.h>
 #include "udrv_errno.h"
 #include "udrv_serial.h"
+#include "udrv_powersave.h"
 #include "board_basic.h"
 #include "service_nvm.h"
 #include "LoRaMac.h"
@@ -107,20 +108,20 @@ static uint8_t freq_cnt;
 static uint32_t service_lora_test_full_wlock_cnt;
 static volatile uint32_t freq_seq[128] = {0};
 static void service_lora_test_full_wake_lock(void) {
-    udrv_powersave_wake_lock();
+    udrv_powersave_wake_lock_by(UDRV_PS_WLOCK_LORA_TEST);
     service_lora_test_full_wlock_cnt++;
 }
 
 static void service_lora_test_full_wake_unlock(void) {
     if (service_lora_test_full_wlock_cnt > 0) {
-        udrv_powersave_wake_unlock();
+        udrv_powersave_wake_unlock_by(UDRV_PS_WLOCK_LORA_TEST);
         service_lora_test_full_wlock_cnt--;
     }
 }
 
 static void service_lora_test_full_wake_unlock_all(void) {
     while (service_lora_test_full_wlock_cnt > 0) {
-        udrv_powersave_wake_unlock();
+        udrv_powersave_wake_unlock_by(UDRV_PS_WLOCK_LORA_TEST);
         service_lora_test_full_wlock_cnt--;
     }
 }
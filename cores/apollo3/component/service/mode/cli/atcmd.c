@@ -118,6 +118,10 @@ at_cmd_info atcmd_info_tbl[] =
     {ATCMD_REBOOT,   /*1*/          At_Reboot,             0, "triggers a reset of the MCU", ATZ_PERM},
     {ATCMD_ATR,      /*3*/          At_Restore,            0, "restore default parameters", ATR_PERM},
     {ATCMD_DEBUG,    /*3*/          At_Debug,              0, "set debug log", AT_DEBUG_PERM},
+#if CFG_PROFILE && !defined(RUI_BOOTLOADER)
+    {ATCMD_PROFILE,                 At_Profile,            0, "get the execution profile", AT_PROFILE_PERM},
+    {ATCMD_TASKSTAT,                At_TaskStat,           0, "get the CPU share and stack margin of each task", AT_TASKSTAT_PERM},
+#endif
 #ifndef RUI_BOOTLOADER
     {ATCMD_ATE,      /*88*/         At_Echo,               0, "show or hide the AT command input", ATE_PERM},
     {ATCMD_FSN,      /*hidden*/     At_FSn,                0, "", AT_FSN_PERM},
@@ -147,6 +151,7 @@ at_cmd_info atcmd_info_tbl[] =
     {ATCMD_SLEEP,    /*85*/         At_Sleep,              0, "enter sleep mode for a period of time (ms)", AT_SLEEP_PERM},
     {ATCMD_AUTOSLEEP,/*86*/         At_AutoSleep,          0, "get or set the low power mode (0 = off, 1 = on)", AT_AUTOSLEEP_PERM},
     {ATCMD_AUTOSLEEPLEVEL,/*99*/    At_AutoSleepLevel,     0, "get or set the low power mode level", AT_AUTOSLEEPLEVEL_PERM},
+    {ATCMD_POWERSTAT,               At_PowerStat,          0, "get or clear the power accounting counters", AT_POWERSTAT_PERM},
 /* Serial Port Command */
     {ATCMD_LOCK,     /*10*/         At_Lock,               0, "lock the serial port",AT_LOCK_PERM },
     {ATCMD_PWORD,    /*11*/         At_Pword,              0, "set the serial port locking password (max 8 char)", AT_PWORD_PERM},
@@ -158,6 +163,7 @@ at_cmd_info atcmd_info_tbl[] =
 #ifdef SUPPORT_LORA
 #ifdef SUPPORT_PASSTHRU
     {ATCMD_PAM,      /*74*/         At_TransparentMode,    0, "enter data transparent transmission mode", ATD_PERM},
+    {ATCMD_TPFLUSH,  /* */          At_TransparentFlush,   0, "get or set the transparent mode idle flush (ms), delimiter and flow control", AT_TPFLUSH_PERM},
 #endif
 /* LoRaWAN Keys and IDs */
     {ATCMD_APPEUI,   /*16*/         At_AppEui,             0, "get or set the application EUI (8 bytes in hex)", AT_APPEUI_PERM},
@@ -197,6 +203,7 @@ at_cmd_info atcmd_info_tbl[] =
     {ATCMD_LBT,       /* */         At_Lbt,                0, "get or set the LoRaWAN LBT (support Korea Japan)", AT_TIMEREQ_PERM},
     {ATCMD_LBTRSSI,   /* */         At_LbtRssi,            0, "get or set the LoRaWAN LBT rssi (support Korea Japan)", AT_TIMEREQ_PERM},
     {ATCMD_LBTSCANTIME,/* */        At_LbtScantime,        0, "get or set the LoRaWAN LBT scantime (support Korea Japan)", AT_TIMEREQ_PERM},
+    {ATCMD_LINKADAPT, /* */         At_LinkAdapt,          0, "get or set the device side link adaptation (0 = off, 1 = on)", AT_LINKADAPT_PERM},
 /* LoRaWAN Class B */
     {ATCMD_PGSLOT,   /*44*/         At_PingSlot,           0, "get or set the unicast ping slot periodicity (0-7)", AT_PGSLOT_PERM},
     {ATCMD_BFREQ,    /*45*/         At_BeaconFreq,         0, "get the data rate and beacon frequency (MHz)", AT_BFREQ_PERM},
@@ -219,6 +226,7 @@ at_cmd_info atcmd_info_tbl[] =
     {ATCMD_ADDMULC,  /*69*/         At_Addmulc,            0, "add a new multicast group", AT_ADDMULC_PERM},
     {ATCMD_RMVMULC,  /*70*/         At_Rmvmulc,            0, "delete a multicast group" , AT_RMVMULC_PERM},
     {ATCMD_LSTMULC,  /*71*/         At_Lstmulc,            0, "view multicast group information", AT_LSTMULC_PERM},
+    {ATCMD_MULCSTAT,                At_Mulcstat,           0, "view multicast group downlink statistics", AT_MULCSTAT_PERM},
 /* LoRaWAN Certification */
     {ATCMD_TRSSI,    /*77*/         At_Trssi,              0, "start RF RSSI tone test", AT_TRSSI_PERM},
     {ATCMD_TTONE,    /*78*/         At_Ttone,              0, "start RF tone test", AT_TTONE_PERM},
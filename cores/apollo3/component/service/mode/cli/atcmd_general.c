@@ -6,6 +6,8 @@
 #include "udrv_system.h"
 #include "mcu_basic.h"
 #include "service_debug.h"
+#include "service_profile.h"
+#include "service_taskmon.h"
 #include "service_nvm.h"
 #ifdef RUI_BOOTLOADER
 #include "uhal_flash.h"
@@ -97,6 +99,82 @@ int At_Debug (SERIAL_PORT port, char *cmd, stParam *param)
     
 }
 
+#if CFG_PROFILE && !defined(RUI_BOOTLOADER)
+int At_Profile (SERIAL_PORT port, char *cmd, stParam *param)
+{
+    if (param->argc == 1 && !strcmp(param->argv[0], "?"))
+    {
+        service_profile_stat_t stat;
+
+        for (int zone = 0; zone < SERVICE_PROFILE_ZONE_MAX; zone++)
+        {
+            service_profile_get((SERVICE_PROFILE_ZONE)zone, &stat);
+            atcmd_printf("%s:%u:%u:%u:%u\r\n", service_profile_zone_name((SERVICE_PROFILE_ZONE)zone), stat.count,
+                         service_profile_cycles_to_us(stat.min), service_profile_cycles_to_us(stat.max),
+                         stat.count ? service_profile_cycles_to_us((uint32_t)(stat.total / stat.count)) : 0);
+        }
+        return AT_OK;
+    }
+    else if (param->argc == 1 && !strcmp(param->argv[0], "TRACE"))
+    {
+        static service_profile_trace_t trace[SERVICE_PROFILE_TRACE_NUM];
+        uint16_t n = service_profile_trace_read(trace, SERVICE_PROFILE_TRACE_NUM);
+
+        for (uint16_t i = 0; i < n; i++)
+        {
+            atcmd_printf("%s:%u:%u:%u\r\n", service_profile_zone_name((SERVICE_PROFILE_ZONE)trace[i].zone), trace[i].arg,
+                         trace[i].start, service_profile_cycles_to_us(trace[i].cycles));
+        }
+        return AT_OK;
+    }
+    else if (param->argc == 1 && !strcmp(param->argv[0], "0"))
+    {
+        service_profile_reset();
+        return AT_OK;
+    }
+    else if (param->argc == 2 && !strcmp(param->argv[0], "RTT"))
+    {
+        uint32_t enable;
+
+        if (0 != at_check_digital_uint32_t(param->argv[1], &enable) || enable > 1)
+            return AT_PARAM_ERROR;
+        service_profile_stream(enable == 1);
+        return AT_OK;
+    }
+    else
+    {
+        return AT_PARAM_ERROR;
+    }
+}
+
+int At_TaskStat (SERIAL_PORT port, char *cmd, stParam *param)
+{
+    if (param->argc == 1 && !strcmp(param->argv[0], "?"))
+    {
+        static service_taskmon_info_t info[SERVICE_TASKMON_TASK_MAX];
+        uint8_t n = service_taskmon_get(info, SERVICE_TASKMON_TASK_MAX);
+
+        for (uint8_t i = 0; i < n; i++)
+        {
+            atcmd_printf("%s:%u.%u:%u:%u\r\n", info[i].name, info[i].cpu_permille / 10, info[i].cpu_permille % 10,
+                         info[i].switches, info[i].stack_free);
+        }
+        if (service_taskmon_get_untracked() != 0)
+            atcmd_printf("untracked:%u\r\n", service_taskmon_get_untracked());
+        return AT_OK;
+    }
+    else if (param->argc == 1 && !strcmp(param->argv[0], "0"))
+    {
+        service_taskmon_reset();
+        return AT_OK;
+    }
+    else
+    {
+        return AT_PARAM_ERROR;
+    }
+}
+#endif
+
 
 int At_Reboot (SERIAL_PORT port, char *cmd, stParam *param)
 {
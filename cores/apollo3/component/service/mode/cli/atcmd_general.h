@@ -6,6 +6,8 @@ int At_Attention (SERIAL_PORT port, char *cmd, stParam *param);
 int At_Reboot (SERIAL_PORT port, char *cmd, stParam *param);
 int At_Restore (SERIAL_PORT port, char *cmd, stParam *param);
 int At_Debug (SERIAL_PORT port, char *cmd, stParam *param);
+int At_Profile (SERIAL_PORT port, char *cmd, stParam *param);
+int At_TaskStat (SERIAL_PORT port, char *cmd, stParam *param);
 int At_Dfu (SERIAL_PORT port, char *cmd, stParam *param);
 #ifndef RUI_BOOTLOADER
 int At_Echo (SERIAL_PORT port, char *cmd, stParam *param);
@@ -191,6 +191,36 @@
  * | AT+BOOTVER?        | --                 | AT+BOOTVER: get the version of RUI Bootloader                     | OK                 |
  * | AT+BOOTVER=?       | --                 | <string>                                                          | OK                 |
  * | Example<br>AT+BOOTVER=?| --             | RUI STM32WLE5CC Bootloader v0.5                                   | OK                 |
+ *
+ * @subsection ATCMD_general_20 AT+PROF: get the execution profile
+ *
+ * This command is only available in firmware built with CFG_PROFILE=1 and reports the time spent in the profiled zones.
+ * Each line of AT+PROF=? is <zone>:<count>:<min us>:<max us>:<mean us>, each line of AT+PROF=TRACE is
+ * <zone>:<arg>:<start cycle>:<us> for the latest passes, oldest first. AT+PROF=RTT:1 streams every pass
+ * as a binary record on RTT up channel 2.
+ *
+ * | Command            | Input parameter    | Return value                                                      | Return code        |
+ * |:------------------:|:------------------:|:------------------------------------------------------------------|:------------------:|
+ * | AT+PROF?           | --                 | AT+PROF: get the execution profile                                | OK                 |
+ * | AT+PROF=?          | --                 | <string>:<uint32>:<uint32>:<uint32>:<uint32> per zone             | OK                 |
+ * | AT+PROF=\<Input\>  | 0                  | -- (clear the statistics and the trace)                           | OK                 |
+ * | AT+PROF=\<Input\>  | TRACE              | <string>:<uint16>:<uint32>:<uint32> per record                    | OK                 |
+ * | AT+PROF=RTT:\<Input\>| 0 or 1           | --                                                                | OK                 |
+ * | Example<br>AT+PROF=?| --                | LOOP:1520:12:4810:35                                              | OK                 |
+ *
+ * @subsection ATCMD_general_21 AT+TASKSTAT: get the CPU share and stack margin of each task
+ *
+ * This command is only available in firmware built with CFG_PROFILE=1. Each line is
+ * <task>:<CPU %>:<context switches>:<minimum free stack in bytes>. The CPU share and the switches
+ * count from boot or the last AT+TASKSTAT=0, the free stack is the lowest ever seen. Deleted tasks are
+ * dropped; when more than 24 tasks are alive, a last untracked:<count> line reports the ones left out.
+ *
+ * | Command            | Input parameter    | Return value                                                      | Return code        |
+ * |:------------------:|:------------------:|:------------------------------------------------------------------|:------------------:|
+ * | AT+TASKSTAT?       | --                 | AT+TASKSTAT: get the CPU share and stack margin of each task      | OK                 |
+ * | AT+TASKSTAT=?      | --                 | <string>:<float>:<uint32>:<uint32> per task                       | OK                 |
+ * | AT+TASKSTAT=\<Input\>| 0                | -- (clear the CPU share and the switches)                         | OK                 |
+ * | Example<br>AT+TASKSTAT=?| --            | loop:1.2:4521:14880                                               | OK                 |
  */
 
 #ifndef _ATCMD_GENERAL_DEF_H_
@@ -202,6 +232,8 @@
 #define ATCMD_BOOT                  "AT+BOOT"
 #define ATCMD_BOOTVER               "AT+BOOTVER"
 #define ATCMD_DEBUG					"AT+DEBUG"
+#define ATCMD_PROFILE               "AT+PROF"
+#define ATCMD_TASKSTAT              "AT+TASKSTAT"
 #define ATCMD_ATE                   "ATE"
 #define ATCMD_FSN                   "AT+FSN"
 #define ATCMD_SN                    "AT+SN"
@@ -9,6 +9,7 @@
 
 //at+addmulc=C:11223344:11223344556677881122334455667788:11223344556677881122334455667788
 //at+lstmulc=?
+//at+mulcstat=?
 //at+rmvmulc=11223344
 int At_Addmulc(SERIAL_PORT port, char *cmd, stParam *param)
 {
@@ -110,24 +111,38 @@ int At_Lstmulc(SERIAL_PORT port, char *cmd, stParam *param)
     {
         return AT_MODE_NO_SUPPORT;
     }
-    McSession_t McSession ;
+    McSession_t list[LORAMAC_MAX_MC_CTX];
+    McSession_t empty;
+    uint8_t count, n = 0;
 
     if (param->argc == 1 && !strcmp(param->argv[0], "?"))
     {
-        uint8_t i=1;
-        while (service_lora_lstmulc(&McSession) == -UDRV_CONTINUE) {
+        if (service_lora_get_multicast_list(list, LORAMAC_MAX_MC_CTX, &count) != UDRV_RETURN_OK)
+        {
+            return AT_ERROR;
+        }
+        memset(&empty, 0, sizeof(McSession_t));
+
+        //Every group slot is listed, an unused one with all fields 0
+        for (uint8_t i = 1; i <= LORAMAC_MAX_MC_CTX; i++)
+        {
+            McSession_t *McSession = &empty;
+
+            if (n < count && list[n].entry == i)
+            {
+                McSession = &list[n++];
+            }
             if(i>1)
             {
                 atcmd_printf(",");
             }
-            //atcmd_printf("MC%d:", i);
-            if(McSession.Address==0)
+            if(McSession->Address==0)
             {
                 atcmd_printf("0:");
             }
             else
             {
-                if (McSession.Devclass == 1)
+                if (McSession->Devclass == 1)
                 {
                     atcmd_printf("B:");
                 }
@@ -136,24 +151,61 @@ int At_Lstmulc(SERIAL_PORT port, char *cmd, stParam *param)
                     atcmd_printf("C:");
                 }
             }
-            atcmd_printf("%08X:", McSession.Address);
+            atcmd_printf("%08X:", McSession->Address);
 
             for (int j = 0; j < 16; j++)
             {
-                atcmd_printf("%02X", McSession.McNwkSKey[j]);
+                atcmd_printf("%02X", McSession->McNwkSKey[j]);
             }
             atcmd_printf(":");
 
             for (int j = 0; j < 16; j++)
             {
-                atcmd_printf("%02X", McSession.McAppSKey[j]);
+                atcmd_printf("%02X", McSession->McAppSKey[j]);
             }
             atcmd_printf(":");
 
-            atcmd_printf("%09d:", McSession.Frequency);
-            atcmd_printf("%02d:", McSession.Datarate);
-            atcmd_printf("%d", McSession.Periodicity);
-            i++;
+            atcmd_printf("%09d:", McSession->Frequency);
+            atcmd_printf("%02d:", McSession->Datarate);
+            atcmd_printf("%d", McSession->Periodicity);
+        }
+        atcmd_printf("\r\n");
+        return AT_OK;
+    }
+    else /* This command can only be queried, not set */
+    {
+        return AT_PARAM_ERROR;
+    }
+}
+
+int At_Mulcstat(SERIAL_PORT port, char *cmd, stParam *param)
+{
+    if(SERVICE_LORAWAN != service_lora_get_nwm())
+    {
+        return AT_MODE_NO_SUPPORT;
+    }
+    McSession_t list[LORAMAC_MAX_MC_CTX];
+    McSessionStats_t stats;
+    uint8_t count;
+
+    if (param->argc == 1 && !strcmp(param->argv[0], "?"))
+    {
+        if (service_lora_get_multicast_list(list, LORAMAC_MAX_MC_CTX, &count) != UDRV_RETURN_OK)
+        {
+            return AT_ERROR;
+        }
+        for (uint8_t i = 0; i < count; i++)
+        {
+            if (service_lora_get_multicast_stats(list[i].Address, &stats) != UDRV_RETURN_OK)
+            {
+                return AT_ERROR;
+            }
+            if(i>0)
+            {
+                atcmd_printf(",");
+            }
+            atcmd_printf("%08X:%u:%u:%u:%d:%d", list[i].Address, stats.Frames, stats.FCntGaps,
+                         stats.LastFCnt, stats.LastRssi, stats.LastSnr);
         }
         atcmd_printf("\r\n");
         return AT_OK;
@@ -13,5 +13,6 @@
 int At_Addmulc(SERIAL_PORT port, char *cmd, stParam *param);
 int At_Rmvmulc(SERIAL_PORT port, char *cmd, stParam *param);
 int At_Lstmulc(SERIAL_PORT port, char *cmd, stParam *param);
+int At_Mulcstat(SERIAL_PORT port, char *cmd, stParam *param);
 
 #endif //_ATCMD_GENERAL_H_
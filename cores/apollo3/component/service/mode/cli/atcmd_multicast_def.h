@@ -37,6 +37,16 @@
  * | AT+LSTMULC=\<Input\>  | --              | MC1:\<Class\>:\<Dev Addr\>:\<Nwk SKey\>:\<App SKey\>:\<Freq\>:\<DR\>:\<Periodicity\>                                                                  | OK                 |
  * | Example<br>AT+LSTMULC=| --              | MC1:C:01020304:0102030405060708:0102030405060708:868000000:0:0<br>MC2:C:01020304:0102030405060708:0102030405060708:868000000:0:0                                                                | OK                 |
  *
+ * @subsection ATCMD_multicast_4 AT+MULCSTAT: multicast group downlink statistics
+ *
+ * This command shows, for every configured multicast group, the downlinks received, the downlinks missed as counted from the FCnt gaps, and the FCnt, RSSI and SNR of the last one.
+ *
+ * | Command            | Input parameter    | Return value                                                      | Return code        |
+ * |:------------------:|:------------------:|:------------------------------------------------------------------|:------------------:|
+ * | AT+MULCSTAT?          | --              | AT+MULCSTAT: view multicast group downlink statistics             | OK                 |
+ * | AT+MULCSTAT=?         | --              | \<Dev Addr\>:\<Frames\>:\<Missed\>:\<Last FCnt\>:\<Last RSSI\>:\<Last SNR\>              | OK                 |
+ * | Example<br>AT+MULCSTAT=?| --            | 01020304:12:1:13:-87:7,01020305:3:0:3:-90:5                      | OK                 |
+ *
  */
 #endif
 
@@ -47,5 +57,6 @@
 #define ATCMD_ADDMULC          "AT+ADDMULC"
 #define ATCMD_RMVMULC          "AT+RMVMULC"
 #define ATCMD_LSTMULC          "AT+LSTMULC"
+#define ATCMD_MULCSTAT         "AT+MULCSTAT"
 
 #endif //
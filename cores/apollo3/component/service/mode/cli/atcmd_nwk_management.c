@@ -6,6 +6,7 @@
 #include "atcmd_nwk_management.h"
 #include "udrv_errno.h"
 #include "service_lora.h"
+#include "service_lora_linkq.h"
 
 int At_ADR (SERIAL_PORT port, char *cmd, stParam *param) {
 
@@ -688,6 +689,38 @@ int At_LbtScantime(SERIAL_PORT port, char *cmd, stParam *param)
 
 }
 
+int At_LinkAdapt(SERIAL_PORT port, char *cmd, stParam *param)
+{
+    if(SERVICE_LORAWAN != service_lora_get_nwm())
+    {
+        return AT_MODE_NO_SUPPORT;
+    }
+
+    if (param->argc == 1 && !strcmp(param->argv[0], "?"))
+    {
+        service_lora_linkq_t linkq;
+
+        service_lora_linkq_get(&linkq);
+        atcmd_printf("%s=%d:%d:%d\r\n", cmd, service_lora_get_link_adapt(), linkq.dr, linkq.txpower);
+        return AT_OK;
+    }
+    else if (param->argc == 1)
+    {
+        uint32_t enable;
+
+        if (0 != at_check_digital_uint32_t(param->argv[0], &enable) || enable > 1)
+        {
+            return AT_PARAM_ERROR;
+        }
+        service_lora_set_link_adapt((bool)enable);
+        return AT_OK;
+    }
+    else
+    {
+        return AT_PARAM_ERROR;
+    }
+}
+
 
 
 #endif
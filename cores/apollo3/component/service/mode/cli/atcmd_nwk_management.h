@@ -19,5 +19,6 @@ int At_Timereq(SERIAL_PORT port, char *cmd, stParam *param);
 int At_Lbt(SERIAL_PORT port, char *cmd, stParam *param);
 int At_LbtRssi(SERIAL_PORT port, char *cmd, stParam *param);
 int At_LbtScantime(SERIAL_PORT port, char *cmd, stParam *param);
+int At_LinkAdapt(SERIAL_PORT port, char *cmd, stParam *param);
 
 #endif //_ATCMD_NWK_MNG_H_
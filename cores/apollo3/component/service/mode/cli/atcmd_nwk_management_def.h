@@ -207,6 +207,20 @@
  * | Example<br>AT+LBTSCANTIME=?| --                 | 5                                                           | OK                 |
  * | Example<br>AT+LBTSCANTIME= | 5                  | --                                                          | OK                 |
  *
+ * @subsection ATCMD_nwk_mng_18 AT+LINKADAPT: device side link adaptation
+ *
+ * This command allows the user to enable the device side link adaptation. While ADR is off, LinkCheckAns margins
+ * and lost confirmed uplinks move the datarate and TX power away from the configured ones (AT+DR, AT+TXP), which
+ * are restored when it is disabled. The setting is not kept across a reboot.
+ *
+ * | Command                  | Input parameter    | Return value                                                      | Return code        |
+ * |:------------------------:|:------------------:|:------------------------------------------------------------------|:------------------:|
+ * | AT+LINKADAPT?            | --                 | AT+LINKADAPT: get or set the device side link adaptation (0 = off, 1 = on) | OK        |
+ * | AT+LINKADAPT=?           | --                 | <enable>:<datarate>:<TX power> in use, -1:0 while not adapting    | OK                 |
+ * | AT+LINKADAPT=\<Input\>   | 0 or 1             | --                                                                | OK / AT_PARAM_ERROR|
+ * | Example<br>AT+LINKADAPT= | 1                  | --                                                                | OK                 |
+ * | Example<br>AT+LINKADAPT=?| --                 | 1:3:0                                                             | OK                 |
+ *
  */
 #endif 
 
@@ -231,5 +245,6 @@
 #define ATCMD_LBT             "AT+LBT"
 #define ATCMD_LBTRSSI         "AT+LBTRSSI"
 #define ATCMD_LBTSCANTIME     "AT+LBTSCANTIME"
+#define ATCMD_LINKADAPT       "AT+LINKADAPT"
 
 #endif //_ATCMD_NWK_MNG_DEF_H_
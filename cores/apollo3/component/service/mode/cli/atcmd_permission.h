@@ -18,6 +18,14 @@
 #define AT_DEBUG_PERM       ATCMD_PERM_READ | ATCMD_PERM_WRITE
 #endif
 
+#ifndef AT_PROFILE_PERM
+#define AT_PROFILE_PERM     ATCMD_PERM_READ | ATCMD_PERM_WRITE
+#endif
+
+#ifndef AT_TASKSTAT_PERM
+#define AT_TASKSTAT_PERM    ATCMD_PERM_READ | ATCMD_PERM_WRITE
+#endif
+
 #ifndef AT_BOOT_PERM
 #define AT_BOOT_PERM        ATCMD_PERM_READ
 #endif
@@ -110,6 +118,10 @@
 #define AT_AUTOSLEEPLEVEL_PERM       ATCMD_PERM_READ | ATCMD_PERM_WRITE
 #endif
 
+#ifndef AT_POWERSTAT_PERM
+#define AT_POWERSTAT_PERM            ATCMD_PERM_READ | ATCMD_PERM_WRITE
+#endif
+
 #ifndef AT_LOCK_PERM
 #define AT_LOCK_PERM        ATCMD_PERM_READ
 #endif
@@ -134,6 +146,10 @@
 #define ATD_PERM            ATCMD_PERM_READ | ATCMD_PERM_WRITE
 #endif
 
+#ifndef AT_TPFLUSH_PERM
+#define AT_TPFLUSH_PERM     ATCMD_PERM_READ | ATCMD_PERM_WRITE
+#endif
+
 #ifndef AT_APPEUI_PERM
 #define AT_APPEUI_PERM      ATCMD_PERM_READ | ATCMD_PERM_WRITE
 #endif
@@ -250,6 +266,10 @@
 #define AT_LINKCHECK_PERM   ATCMD_PERM_READ | ATCMD_PERM_WRITE
 #endif
 
+#ifndef AT_LINKADAPT_PERM
+#define AT_LINKADAPT_PERM   ATCMD_PERM_READ | ATCMD_PERM_WRITE
+#endif
+
 #ifndef AT_TIMEREQ_PERM
 #define AT_TIMEREQ_PERM   ATCMD_PERM_READ | ATCMD_PERM_WRITE
 #endif
@@ -378,6 +398,10 @@
 #define AT_LSTMULC_PERM     ATCMD_PERM_READ
 #endif
 
+#ifndef AT_MULCSTAT_PERM
+#define AT_MULCSTAT_PERM    ATCMD_PERM_READ
+#endif
+
 #ifndef AT_TRSSI_PERM
 #define AT_TRSSI_PERM       ATCMD_PERM_READ | ATCMD_PERM_WRITE
 #endif
@@ -6,6 +6,9 @@
 #include "udrv_dfu.h"
 #include "udrv_serial.h"
 #include "service_mode.h"
+#if defined(SUPPORT_LORA) && defined(SUPPORT_PASSTHRU)
+#include "service_mode_transparent.h"
+#endif
 
 int At_Lock (SERIAL_PORT port, char *cmd, stParam *param)
 {
@@ -272,5 +275,45 @@ int At_TransparentMode(SERIAL_PORT port, char *cmd, stParam *param)
         return AT_PARAM_ERROR;
     }
 }
+
+int At_TransparentFlush(SERIAL_PORT port, char *cmd, stParam *param)
+{
+    if (param->argc == 1 && !strcmp(param->argv[0], "?"))
+    {
+        atcmd_printf("%s=%u:%d:%u:%u\r\n", cmd, service_nvm_get_tp_idle_ms_from_nvm(port),
+                     service_nvm_get_tp_delimiter_from_nvm(port), service_nvm_get_tp_flow_control_from_nvm(port),
+                     service_mode_transparent_get_overflow(port));
+        return AT_OK;
+    }
+    else if (param->argc == 3)
+    {
+        uint32_t idle_ms;
+        uint32_t delimiter;
+        uint32_t flow_control;
+
+        if (0 != at_check_digital_uint32_t(param->argv[0], &idle_ms) || idle_ms == 0)
+        {
+            return AT_PARAM_ERROR;
+        }
+        if (!strcmp(param->argv[1], "-1"))
+        {
+            delimiter = (uint32_t)TP_NO_DELIMITER;
+        }
+        else if (0 != at_check_digital_uint32_t(param->argv[1], &delimiter) || delimiter > 0xFF)
+        {
+            return AT_PARAM_ERROR;
+        }
+        if (0 != at_check_digital_uint32_t(param->argv[2], &flow_control) || flow_control > 1)
+        {
+            return AT_PARAM_ERROR;
+        }
+
+        return at_error_code_form_udrv(service_mode_transparent_set_flush(port, idle_ms, (int16_t)delimiter, (bool)flow_control));
+    }
+    else
+    {
+        return AT_PARAM_ERROR;
+    }
+}
 #endif
 #endif
@@ -8,5 +8,6 @@ int At_Baud (SERIAL_PORT port, char *cmd, stParam *param);
 int At_AtCmdMode (SERIAL_PORT port, char *cmd, stParam *param);
 int At_ApiMode (SERIAL_PORT port, char *cmd, stParam *param);
 int At_TransparentMode (SERIAL_PORT port, char *cmd, stParam *param);
+int At_TransparentFlush (SERIAL_PORT port, char *cmd, stParam *param);
 
 #endif //_ATCMD_SERIAL_PORT_H_
@@ -70,6 +70,21 @@
  * | ATD                | --                 |                                                                   | OK                 |
  * | ATD=\<param\>      | <fport>            |                                                                   | OK / AT_PARAM_ERROR|
  * 
+ * @subsection ATCMD_serial_port_8 AT+TPFLUSH: pass through mode flush and flow control
+ *
+ * This command configures when pass through mode sends the bytes it has buffered on this port: after
+ * an idle gap in milliseconds, or when the delimiter byte (0-255, -1 for none) arrives. With flow
+ * control on, XOFF is sent when every buffer waits for an uplink and XON once one is free again.
+ * The query also returns the bytes dropped in the last pass through session. The setting is saved.
+ *
+ * | Command                  | Input parameter    | Return value                                                      | Return code        |
+ * |:------------------------:|:------------------:|:------------------------------------------------------------------|:------------------:|
+ * | AT+TPFLUSH?              | --                 | AT+TPFLUSH: get or set the pass through flush and flow control    | OK                 |
+ * | AT+TPFLUSH=?             | --                 | <idle ms>:<delimiter>:<flow control>:<dropped bytes>              | OK                 |
+ * | AT+TPFLUSH=\<Input\>     | <idle ms>:<delimiter>:<flow control> | --                                              | OK / AT_PARAM_ERROR|
+ * | Example<br>AT+TPFLUSH=   | 500:13:1           | --                                                                | OK                 |
+ * | Example<br>AT+TPFLUSH=?  | --                 | 500:13:1:0                                                        | OK                 |
+ *
  * @subsection ATCMD_serial_port_7 +++: Exit transparent transmission mode
  *
  * This command provides Exit data transparent transmission mode
@@ -92,5 +107,6 @@
 #define ATCMD_APM                   "AT+APM"
 #if defined(SUPPORT_LORA) && defined(SUPPORT_PASSTHRU)
 #define ATCMD_PAM                   "ATD"
+#define ATCMD_TPFLUSH               "AT+TPFLUSH"
 #endif
 #endif //_ATCMD_SERIAL_PORT_DEF_H_
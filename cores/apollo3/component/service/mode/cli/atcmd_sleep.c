@@ -4,6 +4,7 @@
 #include "atcmd_general.h"
 #include "udrv_errno.h"
 #include "udrv_system.h"
+#include "udrv_powersave.h"
 
 extern uint32_t orig_auto_sleep_time;
 
@@ -122,5 +123,63 @@ int At_AutoSleepLevel(SERIAL_PORT port, char *cmd, stParam *param)
         return AT_PARAM_ERROR;
 }
 
+int At_PowerStat(SERIAL_PORT port, char *cmd, stParam *param)
+{
+    if (param->argc == 1 && !strcmp(param->argv[0], "?"))
+    {
+        udrv_powersave_stats_t stats;
+
+        udrv_powersave_get_stats(&stats);
+
+        //64-bit printf is not available, print seconds and milliseconds
+        atcmd_printf("%s=TIME:%lu.%03lu\r\n", cmd, (unsigned long)(stats.elapsed_ms / 1000), (unsigned long)(stats.elapsed_ms % 1000));
+
+        atcmd_printf("%s=SLEEP:", cmd);
+        for (int i = 0; i < UDRV_PS_LEVEL_MAX; i++)
+        {
+            atcmd_printf("%s%d=%lu.%03lu/%u", (i == 0) ? "" : ",", i, (unsigned long)(stats.residency_ms[i] / 1000),
+                         (unsigned long)(stats.residency_ms[i] % 1000), stats.sleep_cnt[i]);
+        }
+
+        atcmd_printf("\r\n%s=WAKE:", cmd);
+        for (int i = 0; i < UDRV_PS_WAKE_SRC_MAX; i++)
+            atcmd_printf("%s%s=%u", (i == 0) ? "" : ",", udrv_powersave_wake_source_name((UDRV_PS_WAKE_SRC)i), stats.wakeup_cnt[i]);
+
+        atcmd_printf("\r\n%s=IDLE:", cmd);
+        for (int i = 0; i < UDRV_PS_IDLE_MAX; i++)
+        {
+            uint64_t ms = stats.idle_residency_us[i] / 1000;
+
+            atcmd_printf("%s%s=%lu.%03lu/%u", (i == 0) ? "" : ",", udrv_powersave_idle_name((UDRV_PS_IDLE)i),
+                         (unsigned long)(ms / 1000), (unsigned long)(ms % 1000), stats.idle_cnt[i]);
+        }
+
+        atcmd_printf("\r\n%s=IDLEWAKE:", cmd);
+        for (int i = 0; i < UDRV_PS_WAKE_SRC_MAX; i++)
+            atcmd_printf("%s%s=%u", (i == 0) ? "" : ",", udrv_powersave_wake_source_name((UDRV_PS_WAKE_SRC)i), stats.idle_wakeup_cnt[i]);
+
+        atcmd_printf("\r\n%s=REFUSE:", cmd);
+        for (int i = 0; i < UDRV_PS_REFUSE_MAX; i++)
+            atcmd_printf("%s%s=%u", (i == 0) ? "" : ",", udrv_powersave_refuse_name((UDRV_PS_REFUSE)i), stats.refuse_cnt[i]);
+
+        atcmd_printf("\r\n%s=WLOCK:", cmd);
+        for (int i = 0; i < UDRV_PS_WLOCK_MAX; i++)
+            atcmd_printf("%s%s=%u", (i == 0) ? "" : ",", udrv_powersave_wlock_name((UDRV_PS_WLOCK)i), stats.wlock_cnt[i]);
+
+        atcmd_printf("\r\n");
+        return AT_OK;
+    }
+    else if (param->argc == 1)
+    {
+        if (strcmp(param->argv[0], "0"))
+            return AT_PARAM_ERROR;
+
+        udrv_powersave_reset_stats();
+        return AT_OK;
+    }
+    else
+        return AT_PARAM_ERROR;
+}
+
 #endif
 
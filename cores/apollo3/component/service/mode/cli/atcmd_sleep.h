@@ -5,5 +5,6 @@
 int At_Sleep(SERIAL_PORT port, char *cmd, stParam *param);
 int At_AutoSleep(SERIAL_PORT port, char *cmd, stParam *param);
 int At_AutoSleepLevel(SERIAL_PORT port, char *cmd, stParam *param);
+int At_PowerStat(SERIAL_PORT port, char *cmd, stParam *param);
 
 #endif //_ATCMD_SLEEP_H_
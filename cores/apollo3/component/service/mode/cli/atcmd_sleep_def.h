@@ -40,6 +40,20 @@
  * | Example<br>AT+LPMLVL= | 1                  | --                                                                                          | OK                 |
  * | Example<br>AT+LPMLVL=?|                    | 1                                                                                           | OK                 |
  *
+ * @subsection ATCMD_sleep_4 AT+LPMSTAT: power accounting
+ *
+ * This command provides a way to read or clear the sleep residency, wake-up and sleep-refusal counters and the held wake-locks.
+ * SLEEP and WAKE count the sleeps requested through AT+SLEEP or AT+LPM, IDLE and IDLEWAKE the sleeps the idle task takes between them.
+ * Times are in seconds, the sleep levels and idle depths are given as \<time\>/\<count\>.
+ *
+ * | Command                | Input parameter    | Return value                                                                                | Return code        |
+ * |:----------------------:|:------------------:|:--------------------------------------------------------------------------------------------|:------------------:|
+ * | AT+LPMSTAT?            | --                 | AT+LPMSTAT: get or clear the power accounting counters                                      | OK                 |
+ * | AT+LPMSTAT=?           | --                 | AT+LPMSTAT=TIME:\<elapsed\><br>AT+LPMSTAT=SLEEP:\<level\>=\<time\>/\<count\>,...<br>AT+LPMSTAT=WAKE:\<source\>=\<count\>,...<br>AT+LPMSTAT=IDLE:\<depth\>=\<time\>/\<count\>,...<br>AT+LPMSTAT=IDLEWAKE:\<source\>=\<count\>,...<br>AT+LPMSTAT=REFUSE:\<reason\>=\<count\>,...<br>AT+LPMSTAT=WLOCK:\<holder\>=\<count\>,... | OK |
+ * | AT+LPMSTAT=\<Input\>   | 0                  | --                                                                                          | OK / AT_PARAM_ERROR|
+ * | Example<br>AT+LPMSTAT=?|                    | AT+LPMSTAT=TIME:3600.125<br>AT+LPMSTAT=SLEEP:0=0.000/0,1=0.000/0,2=3571.410/58<br>AT+LPMSTAT=WAKE:TIMER=57,RTC=0,GPIO=0,UART=1,BLE=0,RADIO=0,OTHER=0<br>AT+LPMSTAT=IDLE:NORMAL=12.304/48211,DEEP=3552.870/1630<br>AT+LPMSTAT=IDLEWAKE:TIMER=48120,RTC=1598,GPIO=3,UART=115,BLE=0,RADIO=4,OTHER=1<br>AT+LPMSTAT=REFUSE:WLOCK=2,RXWAIT=0,RESUMED=1,MINWAKE=4,EVENT=9<br>AT+LPMSTAT=WLOCK:OTHER=0,P2P=0,TEST=0,PROTO=0 | OK |
+ * | Example<br>AT+LPMSTAT= | 0                  | --                                                                                          | OK                 |
+ *
  */
 
 #ifndef _ATCMD_SLEEP_DEF_H_
@@ -48,4 +62,5 @@
 #define ATCMD_SLEEP                 "AT+SLEEP"
 #define ATCMD_AUTOSLEEP             "AT+LPM"
 #define ATCMD_AUTOSLEEPLEVEL        "AT+LPMLVL"
+#define ATCMD_POWERSTAT             "AT+LPMSTAT"
 #endif //_ATCMD_SLEEP_DEF_H_
@@ -25,18 +25,47 @@ extern at_cmd_cust_info atcmd_cust_tbl[ATCMD_CUST_TABLE_SIZE];
 #endif
 
 #ifdef SUPPORT_ATCMD_HISTORY
-static char gCmdHistoryBuffer[CLI_HISTORY_NUM][CLI_BUFFER_SIZE+1];
-static char gCmdHistoryIdx;
-static char gCmdHistoryCnt;
+/* Command history: variable-length entries packed into one ring arena and
+ * indexed by a ring of (offset, length) pairs. */
+typedef struct {
+    uint16_t off;
+    uint16_t len;
+} cli_history_entry_t;
+
+static char gCmdHistoryArena[CLI_HISTORY_ARENA_SIZE];
+static cli_history_entry_t gCmdHistory[CLI_HISTORY_NUM];
+static uint8_t gCmdHistoryHead;     /* next index slot */
+static uint8_t gCmdHistoryCnt;
+static uint16_t gCmdHistoryWr;      /* next arena offset */
+static uint16_t gCmdHistoryUsed;
+static uint8_t gCmdHistoryIdx;      /* recalled entry, 0: the line being typed */
+static uint16_t gCmdHistoryPrefix;  /* search prefix length in sgCmdBuffer */
 #endif
 
 #ifdef RUI_BOOTLOADER
 static inline void __put_char(SERIAL_PORT port, char c) {
     while (app_uart_put(c) != NRF_SUCCESS);
 }
+
+static inline void __output_begin(SERIAL_PORT port) {
+}
+
+static inline void __output_end(SERIAL_PORT port, bool done) {
+}
 #else
 static inline void __put_char(SERIAL_PORT port, char c) {
-    udrv_serial_write(port, (unsigned char*)&c,1);
+    udrv_serial_cli_write(port, (unsigned char*)&c,1);
+}
+
+/* Echo and responses are collected per port and sent in one write once the
+ * pending input is consumed or a command completes. */
+static inline void __output_begin(SERIAL_PORT port) {
+    udrv_serial_cli_hold(port);
+}
+
+static inline void __output_end(SERIAL_PORT port, bool done) {
+    if (done || udrv_serial_read_available(port) <= 0)
+        udrv_serial_cli_flush(port);
 }
 #endif
 
@@ -63,75 +92,95 @@ static void Cli_PrintCmdInScreen(SERIAL_PORT port)
     }
 }
 
-static uint8_t Cli_GetPrevHistoryIdx()
+/* History entry n (1 = newest) */
+static inline cli_history_entry_t *Cli_HistoryEntry(uint8_t n)
 {
-    char CmdIdx = gCmdHistoryIdx;
-    if(gCmdHistoryIdx == 0)
-        CmdIdx =0;
-    else
-        CmdIdx--;
-
-    return CmdIdx;
+    return &gCmdHistory[(gCmdHistoryHead + CLI_HISTORY_NUM - n) % CLI_HISTORY_NUM];
 }
 
-static uint8_t Cli_GetNextHistoryIdx()
+static void Cli_HistoryCopy(char *dst, cli_history_entry_t *e, uint16_t len)
 {
-    char CmdIdx = gCmdHistoryIdx;
+    uint16_t first = CLI_HISTORY_ARENA_SIZE - e->off;
 
-    CmdIdx++;
+    if (first > len)
+        first = len;
+    memcpy(dst, &gCmdHistoryArena[e->off], first);
+    memcpy(dst + first, gCmdHistoryArena, len - first);
+}
 
-    if(CmdIdx >= CLI_HISTORY_NUM || CmdIdx > gCmdHistoryCnt)
-        CmdIdx--;
+static bool Cli_HistoryMatch(cli_history_entry_t *e, const char *s, uint16_t len)
+{
+    uint16_t first = CLI_HISTORY_ARENA_SIZE - e->off;
 
-    return CmdIdx;
+    if (e->len < len)
+        return false;
+    if (first > len)
+        first = len;
+    return memcmp(&gCmdHistoryArena[e->off], s, first) == 0 &&
+           memcmp(gCmdHistoryArena, s + first, len - first) == 0;
 }
 
-static inline void Cli_StoreCmdBufToHistory(uint8_t history)
+/* Walk from entry n in direction step and return the first entry starting
+ * with the search prefix, 0 if there is none. */
+static uint8_t Cli_HistoryFind(uint8_t n, int8_t step)
 {
-    uint32_t len = strlen((const char*)sgCmdBuffer);
-    memcpy(&gCmdHistoryBuffer[history], sgCmdBuffer, len);
-    gCmdHistoryBuffer[history][len]=0x00;
+    for (; n >= 1 && n <= gCmdHistoryCnt; n += step)
+    {
+        if (Cli_HistoryMatch(Cli_HistoryEntry(n), sgCmdBuffer, gCmdHistoryPrefix))
+            return n;
+    }
+    return 0;
 }
 
 static inline void Cli_RestoreHistoryToCmdBuf(uint8_t history)
 {
-    uint32_t len = strlen((const char*)&gCmdHistoryBuffer[history]);
-    memcpy(sgCmdBuffer, &gCmdHistoryBuffer[history], len);
-    sgCmdBuffer[len]= 0x00;
-    sgCurPos = len;
+    cli_history_entry_t *e = Cli_HistoryEntry(history);
+
+    Cli_HistoryCopy(sgCmdBuffer, e, e->len);
+    sgCmdBuffer[e->len]= 0x00;
+    sgCurPos = e->len;
 }
 
 static void Cli_MovetoPrevHistoryCmdBuf(SERIAL_PORT port)
 {
-    uint8_t CmdIdx = gCmdHistoryIdx;
-    uint8_t NewCmdIdx = Cli_GetPrevHistoryIdx();
-    
+    uint8_t NewCmdIdx;
+
     if(!service_nvm_get_atcmd_echo_from_nvm()) 
         return;
-    
-    if(CmdIdx == NewCmdIdx)
+
+    if(gCmdHistoryIdx == 0)
         return;
 
+    NewCmdIdx = Cli_HistoryFind(gCmdHistoryIdx - 1, -1);
+
     Cli_EraseCmdInScreen(port);
-    Cli_StoreCmdBufToHistory(CmdIdx);
-    Cli_RestoreHistoryToCmdBuf(NewCmdIdx);
+    if (NewCmdIdx == 0) {
+        //Back to the line being typed, it is still the prefix of the buffer
+        sgCmdBuffer[gCmdHistoryPrefix] = 0x00;
+        sgCurPos = gCmdHistoryPrefix;
+    } else {
+        Cli_RestoreHistoryToCmdBuf(NewCmdIdx);
+    }
     Cli_PrintCmdInScreen(port);
     gCmdHistoryIdx = NewCmdIdx;
 }
 
 static void Cli_MovetoNextHistoryCmdBuf(SERIAL_PORT port)
 {
-    uint8_t CmdIdx = gCmdHistoryIdx;
-    uint8_t NewCmdIdx = Cli_GetNextHistoryIdx();
+    uint8_t NewCmdIdx;
 
     if(!service_nvm_get_atcmd_echo_from_nvm()) 
         return;
-    
-    if(CmdIdx == NewCmdIdx)
+
+    //What is typed before the first recall is used as the search prefix
+    if(gCmdHistoryIdx == 0)
+        gCmdHistoryPrefix = sgCurPos;
+
+    NewCmdIdx = Cli_HistoryFind(gCmdHistoryIdx + 1, 1);
+    if(NewCmdIdx == 0)
         return;
 
     Cli_EraseCmdInScreen(port);
-    Cli_StoreCmdBufToHistory(CmdIdx);
     Cli_RestoreHistoryToCmdBuf(NewCmdIdx);
     Cli_PrintCmdInScreen(port);
     gCmdHistoryIdx = NewCmdIdx;
@@ -139,38 +188,50 @@ static void Cli_MovetoNextHistoryCmdBuf(SERIAL_PORT port)
 
 static void Cli_RecordInHistoryCmdBuf()
 {
-    uint32_t i = CLI_HISTORY_NUM-2;
-    uint32_t len;
+    uint16_t len = strlen((const char*)sgCmdBuffer);
+    uint16_t first;
+    cli_history_entry_t *e;
 
-    if(sgCurPos)
-    {
-        //shift history log
-        for(; i>0 ; i--)
-        {
-            len = strlen((const char*)&gCmdHistoryBuffer[i]);
-            memcpy(&gCmdHistoryBuffer[i+1], &gCmdHistoryBuffer[i], len);
-            gCmdHistoryBuffer[i+1][len] = 0x00;
-        }
+    gCmdHistoryIdx = 0;
 
-        //copy buf to index 1
-        len = strlen((const char*)&sgCmdBuffer);
-        memcpy(&gCmdHistoryBuffer[1], &sgCmdBuffer, len);
-        gCmdHistoryBuffer[1][len] = 0x00;
+    if(len == 0 || len > CLI_HISTORY_ARENA_SIZE)
+        return;
 
-        //Record how much history we record
-        gCmdHistoryCnt++;
-        if(gCmdHistoryCnt>=CLI_HISTORY_NUM)
-            gCmdHistoryCnt = CLI_HISTORY_NUM-1;
+    //Skip a repeat of the newest entry
+    if(gCmdHistoryCnt && Cli_HistoryEntry(1)->len == len &&
+       Cli_HistoryMatch(Cli_HistoryEntry(1), sgCmdBuffer, len))
+        return;
+
+    //Entries are packed back to back, so the oldest ones give their room up
+    while(gCmdHistoryCnt == CLI_HISTORY_NUM || gCmdHistoryUsed + len > CLI_HISTORY_ARENA_SIZE)
+    {
+        gCmdHistoryUsed -= Cli_HistoryEntry(gCmdHistoryCnt)->len;
+        gCmdHistoryCnt--;
     }
 
-    //Reset buf
-    gCmdHistoryBuffer[0][0]=0x00;
-    gCmdHistoryIdx = 0;
+    e = &gCmdHistory[gCmdHistoryHead];
+    e->off = gCmdHistoryWr;
+    e->len = len;
+
+    first = CLI_HISTORY_ARENA_SIZE - gCmdHistoryWr;
+    if(first > len)
+        first = len;
+    memcpy(&gCmdHistoryArena[gCmdHistoryWr], sgCmdBuffer, first);
+    memcpy(gCmdHistoryArena, sgCmdBuffer + first, len - first);
+
+    gCmdHistoryWr = (gCmdHistoryWr + len) % CLI_HISTORY_ARENA_SIZE;
+    gCmdHistoryUsed += len;
+    gCmdHistoryHead = (gCmdHistoryHead + 1) % CLI_HISTORY_NUM;
+    gCmdHistoryCnt++;
 }
 #endif
 #endif
 
 void service_mode_cli_handler(SERIAL_PORT port, uint8_t ch) {
+    bool done = false;
+
+    __output_begin(port);
+
     switch (ch)
     {
         case 0x1b: /* Special Key, read again for real data */
@@ -182,6 +243,9 @@ void service_mode_cli_handler(SERIAL_PORT port, uint8_t ch) {
             if ( 0 < sgCurPos ) {
                 sgCurPos --;
                 sgCmdBuffer[sgCurPos] = 0x00;
+#ifdef SUPPORT_ATCMD_HISTORY
+                gCmdHistoryIdx = 0;
+#endif
                 __put_char(port, 0x08);
                 __put_char(port, 0x20);
                 __put_char(port, 0x08);
@@ -205,6 +269,7 @@ void service_mode_cli_handler(SERIAL_PORT port, uint8_t ch) {
 #ifdef SUPPORT_AT                   
                 atcmd_printf("\r\n%s", CLI_PROMPT);
 #endif                  
+                done = true;
             }
 
             //if ( 0 !=sgCurPos ) {
@@ -237,6 +302,9 @@ void service_mode_cli_handler(SERIAL_PORT port, uint8_t ch) {
                 if ( (CLI_BUFFER_SIZE-1) > sgCurPos ) {
                     sgCmdBuffer[sgCurPos++] = ch;
                     sgCmdBuffer[sgCurPos] = 0x00;
+#ifdef SUPPORT_ATCMD_HISTORY
+                    gCmdHistoryIdx = 0;
+#endif
                     if(service_nvm_get_atcmd_echo_from_nvm()) {
                         __put_char(port, ch);
                     }
@@ -244,6 +312,8 @@ void service_mode_cli_handler(SERIAL_PORT port, uint8_t ch) {
 	    }
             break;
     }
+
+    __output_end(port, done);
 }
 
 void service_mode_cli_init(SERIAL_PORT port) {
@@ -13,7 +13,8 @@ extern "C" {
 #include "atcmd.h"
 
 #define CLI_BUFFER_SIZE   (2048)//FIXME Consider AT+LPSEND
-#define CLI_HISTORY_NUM (5)
+#define CLI_HISTORY_NUM (16)
+#define CLI_HISTORY_ARENA_SIZE (2048)
 #define CLI_ARG_SIZE		(20)
 #define CLI_PROMPT			("")
 
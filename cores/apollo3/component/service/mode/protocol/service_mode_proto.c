@@ -3,6 +3,7 @@
 #include "udrv_errno.h"
 #include "udrv_serial.h"
 #include "udrv_rtc.h"
+#include "udrv_powersave.h"
 #include "service_mode.h"
 #include "service_mode_proto_builtin_handler.h"
 //#include "nrf_log.h"
@@ -17,8 +18,12 @@ typedef struct _proto_arrived_packet_info
 #else
     uint32_t crc32;
 #endif
+    uint32_t calc_chksum;//running checksum over frame type, flag and payload
     uint32_t sgCurPos;
     uint16_t len;
+    uint16_t total;//payload length of the whole frame
+    uint16_t offset;//payload bytes already handed over in chunks
+    bool chunked;
     uint8_t flag;
     uint8_t frame_type;
     char sgProtoBuffer[PROTO_BUFFER_SIZE+1];
@@ -31,25 +36,63 @@ static proto_upper_layer_info proto_upper_layer_table[PROTO_UPPER_LAYER_NUM_MAX]
 static uint32_t proto_wlock_cnt[SERIAL_MAX];
 
 static void proto_wake_lock(SERIAL_PORT port) {
-    udrv_powersave_wake_lock();
+    udrv_powersave_wake_lock_by(UDRV_PS_WLOCK_PROTO);
     proto_wlock_cnt[port]++;
 }
 
 static void proto_wake_unlock(SERIAL_PORT port) {
     if (proto_wlock_cnt > 0) {
-        udrv_powersave_wake_unlock();
+        udrv_powersave_wake_unlock_by(UDRV_PS_WLOCK_PROTO);
         proto_wlock_cnt[port]--;
     }
 }
 
 static void proto_wake_unlock_all(SERIAL_PORT port) {
     while (proto_wlock_cnt[port] > 0) {
-        udrv_powersave_wake_unlock();
+        udrv_powersave_wake_unlock_by(UDRV_PS_WLOCK_PROTO);
         proto_wlock_cnt[port]--;
     }
 }
 
+static void proto_chunk_abort(SERIAL_PORT port) {
+    proto_arrived_packet_info *info = &arrived_pkt_info[port];
+
+    if (info->chunked) {
+        info->chunked = false;
+        if (proto_upper_layer_table[info->frame_type].chunk_handler != NULL) {
+            proto_upper_layer_table[info->frame_type].chunk_handler(port, NULL, 0, info->offset, info->total, PROTO_CHUNK_ABORT);
+        }
+    }
+}
+
+static uint32_t proto_chksum_init(void) {
+#ifdef PROTO_USE_POPCOUNT_CHKSUM
+    return 0;
+#else
+    return Crc32Init();
+#endif
+}
+
+static uint32_t proto_chksum_calc(uint32_t chksum, uint8_t *data, uint16_t length) {
+    if (length == 0) {
+        return chksum;
+    }
+#ifdef PROTO_USE_POPCOUNT_CHKSUM
+    for (int i = 0 ; i < length ; i++) {
+        chksum += __builtin_popcount(data[i]);
+    }
+    return chksum;
+#else
+    return Crc32Update(chksum, data, length);
+#endif
+}
+
+static void proto_chksum_update(SERIAL_PORT port, uint8_t ch) {
+    arrived_pkt_info[port].calc_chksum = proto_chksum_calc(arrived_pkt_info[port].calc_chksum, &ch, 1);
+}
+
 static void proto_rst_handler(void *p_context) {
+    proto_chunk_abort(((proto_arrived_packet_info *)p_context)->port);
     memset(((proto_arrived_packet_info *)p_context)->sgProtoBuffer, 0x00, PROTO_BUFFER_SIZE+1);
     ((proto_arrived_packet_info *)p_context)->sgCurPos = 0;
     ((proto_arrived_packet_info *)p_context)->curr_state = PROTO_STATE_DEFAULT;
@@ -57,6 +100,34 @@ static void proto_rst_handler(void *p_context) {
     proto_wake_unlock_all(((proto_arrived_packet_info *)p_context)->port);
 }
 
+/* Buffer one payload byte. Frames of a type with a chunk handler hand a full
+ * buffer over as soon as more payload follows, so they are not limited by PROTO_BUFFER_SIZE.
+ */
+static void proto_buffer_payload(SERIAL_PORT port, uint8_t ch) {
+    proto_arrived_packet_info *info = &arrived_pkt_info[port];
+    SERVICE_MODE_PROTOCOL_CHUNK_HANDLER chunk_handler = NULL;
+
+    if (!(info->flag & PROTO_FLAG_RESPONSE)) {
+        chunk_handler = proto_upper_layer_table[info->frame_type].chunk_handler;
+    }
+
+    if (chunk_handler != NULL) {
+        info->sgProtoBuffer[info->sgCurPos++] = ch;
+        if (info->sgCurPos == PROTO_BUFFER_SIZE && info->len > 1) {
+            chunk_handler(port, (uint8_t *)info->sgProtoBuffer, info->sgCurPos, info->offset, info->total, PROTO_CHUNK_MORE);
+            info->chunked = true;
+            info->offset += info->sgCurPos;
+            info->sgCurPos = 0;
+            //PROTO_PKT_TIMEOUT bounds the gap between chunks, not the whole frame
+            info->last_recv_time = udrv_rtc_get_timestamp((RtcID_E)SYS_RTC_COUNTER_PORT);
+        }
+        info->sgProtoBuffer[info->sgCurPos] = 0x00;
+    } else if ( (PROTO_BUFFER_SIZE-1) > info->sgCurPos ) {
+        info->sgProtoBuffer[info->sgCurPos++] = ch;
+        info->sgProtoBuffer[info->sgCurPos] = 0x00;
+    }
+}
+
 static PROTO_STATE proto_normal_handler(SERIAL_PORT port, PROTO_STATE state, uint8_t ch) {
     switch (state) {
         case PROTO_STATE_DEFAULT:
@@ -72,71 +143,43 @@ static PROTO_STATE proto_normal_handler(SERIAL_PORT port, PROTO_STATE state, uin
         case PROTO_STATE_RECV_LEN_1:
         {
             arrived_pkt_info[port].len = arrived_pkt_info[port].len | (((uint16_t)ch << 0) & 0x00FF);
+            arrived_pkt_info[port].total = arrived_pkt_info[port].len;
             return PROTO_STATE_RECV_LEN_2;
         }
         case PROTO_STATE_RECV_LEN_2:
         {
             arrived_pkt_info[port].frame_type = ch;
+            proto_chksum_update(port, ch);
             return PROTO_STATE_RECV_FRAME_TYPE;
         }
         case PROTO_STATE_RECV_FRAME_TYPE:
         {
             arrived_pkt_info[port].flag = ch;
+            proto_chksum_update(port, ch);
             return PROTO_STATE_RECV_FLAG;
         }
         case PROTO_STATE_RECV_FLAG:
         {
             if (arrived_pkt_info[port].len > 0) {
-                /* buffer the input char */
-                if ( (PROTO_BUFFER_SIZE-1) > arrived_pkt_info[port].sgCurPos ) {
-                    arrived_pkt_info[port].sgProtoBuffer[arrived_pkt_info[port].sgCurPos++] = ch;
-                    arrived_pkt_info[port].sgProtoBuffer[arrived_pkt_info[port].sgCurPos] = 0x00;
-                }
-		if (--arrived_pkt_info[port].len == 0) {
+                proto_chksum_update(port, ch);
+                proto_buffer_payload(port, ch);
+                if (--arrived_pkt_info[port].len == 0) {
                     /* payload receiving is finished */
                     return PROTO_STATE_RECV_PAYLOAD;
                 } else {
                     /* payload receiving is not finished yet */
                     return state;
                 }
-            } else {
-                /* there is no payload and this is the checksum */
-#ifdef PROTO_USE_POPCOUNT_CHKSUM
-                uint32_t calculatedCrc32 = 0;
-                arrived_pkt_info[port].chksum = ch;
-
-                calculatedCrc32 = __builtin_popcount(arrived_pkt_info[port].frame_type);
-                calculatedCrc32 += __builtin_popcount(arrived_pkt_info[port].flag);
-                for (int i = 0 ; i < arrived_pkt_info[port].sgCurPos ; i++) {
-                    calculatedCrc32 += __builtin_popcount(arrived_pkt_info[port].sgProtoBuffer[i]);
-                }
-//NRF_LOG_ERROR("%s(): calculatedCrc32=0x%x", __func__, (uint8_t)calculatedCrc32);
-//NRF_LOG_ERROR("%s(): crc32=0x%x", __func__, arrived_pkt_info[port].chksum);
-                if (calculatedCrc32 == arrived_pkt_info[port].chksum) {
-                    return PROTO_STATE_RECV_CHKSUM;
-                } else {
-                    return PROTO_STATE_CRC_ERROR;
-                }
-#else
-                arrived_pkt_info[port].crc32 = ((uint32_t)ch << 24) & 0xFF000000;
-                return PROTO_STATE_RECV_CRC_1;
-#endif
             }
+            /* there is no payload and this is the checksum */
         }
+        /* fall through */
         case PROTO_STATE_RECV_PAYLOAD:
         {
 #ifdef PROTO_USE_POPCOUNT_CHKSUM
-            uint32_t calculatedCrc32 = 0;
             arrived_pkt_info[port].chksum = ch;
 
-            calculatedCrc32 = __builtin_popcount(arrived_pkt_info[port].frame_type);
-            calculatedCrc32 += __builtin_popcount(arrived_pkt_info[port].flag);
-            for (int i = 0 ; i < arrived_pkt_info[port].sgCurPos ; i++) {
-                calculatedCrc32 += __builtin_popcount(arrived_pkt_info[port].sgProtoBuffer[i]);
-            }
-//NRF_LOG_ERROR("%s(): calculatedCrc32=0x%x", __func__, (uint8_t)calculatedCrc32);
-//NRF_LOG_ERROR("%s(): crc32=0x%x", __func__, arrived_pkt_info[port].chksum);
-            if ((uint8_t)calculatedCrc32 == arrived_pkt_info[port].chksum) {
+            if ((uint8_t)arrived_pkt_info[port].calc_chksum == arrived_pkt_info[port].chksum) {
                 return PROTO_STATE_RECV_CHKSUM;
             } else {
                 return PROTO_STATE_CRC_ERROR;
@@ -159,18 +202,9 @@ static PROTO_STATE proto_normal_handler(SERIAL_PORT port, PROTO_STATE state, uin
         }
         case PROTO_STATE_RECV_CRC_3:
         {
-            uint32_t calculatedCrc32 = 0;
             arrived_pkt_info[port].crc32 = arrived_pkt_info[port].crc32 | (((uint32_t)ch << 0) & 0x000000FF);
 
-            calculatedCrc32 = Crc32Init();
-            calculatedCrc32 = Crc32Update(calculatedCrc32, &arrived_pkt_info[port].frame_type, 1);
-            calculatedCrc32 = Crc32Update(calculatedCrc32, &arrived_pkt_info[port].flag, 1);
-            calculatedCrc32 = Crc32Update(calculatedCrc32, arrived_pkt_info[port].sgProtoBuffer, arrived_pkt_info[port].sgCurPos);
-            calculatedCrc32 = Crc32Finalize(calculatedCrc32);
-
-//NRF_LOG_ERROR("%s(): calculatedCrc32=0x%x", __func__, calculatedCrc32);
-//NRF_LOG_ERROR("%s(): crc32=0x%x", __func__, arrived_pkt_info[port].crc32);
-            if (calculatedCrc32 == arrived_pkt_info[port].crc32) {
+            if (Crc32Finalize(arrived_pkt_info[port].calc_chksum) == arrived_pkt_info[port].crc32) {
                 return PROTO_STATE_RECV_CRC_4;
             } else {
                 return PROTO_STATE_CRC_ERROR;
@@ -195,6 +229,9 @@ static PROTO_STATE proto_delimiter_handler(SERIAL_PORT port, PROTO_STATE state,
         case PROTO_STATE_CRC_ERROR:
         {
             arrived_pkt_info[port].sgCurPos = 0;//clear data buffer
+            arrived_pkt_info[port].offset = 0;
+            arrived_pkt_info[port].chunked = false;
+            arrived_pkt_info[port].calc_chksum = proto_chksum_init();
             arrived_pkt_info[port].last_recv_time = udrv_rtc_get_timestamp((RtcID_E)SYS_RTC_COUNTER_PORT);//record start time!
             proto_wake_lock(port);
             return PROTO_STATE_RECV_DELIMITER;
@@ -277,11 +314,16 @@ void service_mode_proto_recv(SERIAL_PORT port, uint8_t ch) {
                     proto_upper_layer_table[arrived_pkt_info[port].frame_type].response_handler(port, arrived_pkt_info[port].sgProtoBuffer, arrived_pkt_info[port].sgCurPos);
                 }
             } else {//This is a request frame
-                if (proto_upper_layer_table[arrived_pkt_info[port].frame_type].request_handler != NULL) {
+                if (proto_upper_layer_table[arrived_pkt_info[port].frame_type].chunk_handler != NULL) {
+                    arrived_pkt_info[port].chunked = false;
+                    proto_upper_layer_table[arrived_pkt_info[port].frame_type].chunk_handler(port, (uint8_t *)arrived_pkt_info[port].sgProtoBuffer, arrived_pkt_info[port].sgCurPos, arrived_pkt_info[port].offset, arrived_pkt_info[port].total, PROTO_CHUNK_LAST);
+                } else if (proto_upper_layer_table[arrived_pkt_info[port].frame_type].request_handler != NULL) {
                     proto_upper_layer_table[arrived_pkt_info[port].frame_type].request_handler(port, arrived_pkt_info[port].sgProtoBuffer, arrived_pkt_info[port].sgCurPos);
                 }
             }
             proto_wake_unlock_all(port);
+        } else if (arrived_pkt_info[port].curr_state == PROTO_STATE_CRC_ERROR) {
+            proto_chunk_abort(port);
         }
     } else {
         arrived_pkt_info[port].sgCurPos = 0;//clear data buffer
@@ -291,9 +333,11 @@ void service_mode_proto_recv(SERIAL_PORT port, uint8_t ch) {
 }
 #ifdef SUPPORT_BINARY
 void service_mode_proto_send(SERIAL_PORT port, uint8_t flag, uint8_t frame_type, uint8_t *payload, uint16_t length, SERVICE_MODE_PROTOCOL_HANDLER response_handler) {
+    uint8_t stage[PROTO_TX_STAGE_SIZE];
     proto_packet_header header;
     proto_packet_tailer tailer;
-    uint32_t calculatedCrc32 = 0;
+    uint32_t calculatedCrc32;
+    uint16_t head_len, tail_len;
     SERVICE_MODE_TYPE mode = service_nvm_get_mode_type_from_nvm(port);
 
     if (mode != SERVICE_MODE_TYPE_PROTOCOL) {
@@ -305,46 +349,47 @@ void service_mode_proto_send(SERIAL_PORT port, uint8_t flag, uint8_t frame_type,
     header.flag = flag;
     header.frame_type = frame_type;
 
+    calculatedCrc32 = proto_chksum_calc(proto_chksum_init(), &frame_type, 1);
+    calculatedCrc32 = proto_chksum_calc(calculatedCrc32, &flag, 1);
+    calculatedCrc32 = proto_chksum_calc(calculatedCrc32, payload, length);
 #ifdef PROTO_USE_POPCOUNT_CHKSUM
-    calculatedCrc32 += __builtin_popcount(frame_type);
-    calculatedCrc32 += __builtin_popcount(flag);
-    for (int i = 0 ; i < length ; i++) {
-        calculatedCrc32 += __builtin_popcount(payload[i]);
-    }
     tailer.chksum = (uint8_t)calculatedCrc32;
 #else
-    calculatedCrc32 = Crc32Init();
-    calculatedCrc32 = Crc32Update(calculatedCrc32, &frame_type, 1);
-    calculatedCrc32 = Crc32Update(calculatedCrc32, &flag, 1);
-    calculatedCrc32 = Crc32Update(calculatedCrc32, payload, length);
     calculatedCrc32 = Crc32Finalize(calculatedCrc32);
     tailer.crc = __builtin_bswap32(calculatedCrc32);
 #endif
 
     proto_upper_layer_table[frame_type].response_handler = response_handler;
 
-//{
-//for (int i = 0 ; i < sizeof(header) ; i++) {
-//    NRF_LOG_ERROR("%s(): header=0x%02x", __func__, *(((uint8_t *)&header)+i));
-//}
-//
-//for (int i = 0 ; i < length ; i++) {
-//    NRF_LOG_ERROR("%s(): payload=0x%02x", __func__, *(payload+i));
-//}
-//
-//for (int i = 0 ; i < sizeof(tailer) ; i++) {
-//    NRF_LOG_ERROR("%s(): tailer=0x%02x", __func__, *(((uint8_t *)&tailer)+i));
-//}
-//}
-
-    udrv_serial_write(port, &header, sizeof(header));
-    udrv_serial_write(port, payload, length);
-    udrv_serial_write(port, &tailer, sizeof(tailer));
+    /* Gather the frame into as few writes as possible: header with the start of the payload,
+     * the middle of the payload straight from the caller, then the end of the payload with the tailer. */
+    memcpy(stage, &header, sizeof(header));
+    if (sizeof(header) + length + sizeof(tailer) <= PROTO_TX_STAGE_SIZE) {
+        if (length > 0) {
+            memcpy(stage + sizeof(header), payload, length);
+        }
+        memcpy(stage + sizeof(header) + length, &tailer, sizeof(tailer));
+        udrv_serial_write(port, stage, sizeof(header) + length + sizeof(tailer));
+        return;
+    }
+
+    head_len = (length < PROTO_TX_STAGE_SIZE - sizeof(header)) ? length : PROTO_TX_STAGE_SIZE - sizeof(header);
+    memcpy(stage + sizeof(header), payload, head_len);
+    udrv_serial_write(port, stage, sizeof(header) + head_len);
+
+    tail_len = ((length - head_len) < PROTO_TX_STAGE_SIZE - sizeof(tailer)) ? (length - head_len) : PROTO_TX_STAGE_SIZE - sizeof(tailer);
+    if (length - head_len > tail_len) {
+        udrv_serial_write(port, payload + head_len, length - head_len - tail_len);
+    }
+
+    memcpy(stage, payload + length - tail_len, tail_len);
+    memcpy(stage + tail_len, &tailer, sizeof(tailer));
+    udrv_serial_write(port, stage, tail_len + sizeof(tailer));
 }
 #endif
 
 int32_t service_mode_proto_register(uint8_t frame_type, SERVICE_MODE_PROTOCOL_HANDLER request_handler) {
-    if (proto_upper_layer_table[frame_type].request_handler == NULL) {
+    if (proto_upper_layer_table[frame_type].request_handler == NULL && proto_upper_layer_table[frame_type].chunk_handler == NULL) {
         proto_upper_layer_table[frame_type].request_handler = request_handler;
         return UDRV_RETURN_OK;
     } else {
@@ -352,8 +397,18 @@ int32_t service_mode_proto_register(uint8_t frame_type, SERVICE_MODE_PROTOCOL_HA
     }
 }
 
+int32_t service_mode_proto_register_chunked(uint8_t frame_type, SERVICE_MODE_PROTOCOL_CHUNK_HANDLER chunk_handler) {
+    if (proto_upper_layer_table[frame_type].request_handler == NULL && proto_upper_layer_table[frame_type].chunk_handler == NULL) {
+        proto_upper_layer_table[frame_type].chunk_handler = chunk_handler;
+        return UDRV_RETURN_OK;
+    } else {
+        return -UDRV_OCCUPIED;
+    }
+}
+
 int32_t service_mode_proto_deregister(uint8_t frame_type) {
     proto_upper_layer_table[frame_type].request_handler = NULL;
+    proto_upper_layer_table[frame_type].chunk_handler = NULL;
     return UDRV_RETURN_OK;
 }
 
@@ -365,8 +420,9 @@ void service_mode_proto_init(SERIAL_PORT port) {
     arrived_pkt_info[port].last_recv_time = 0;//Keep start time zero
 
     //Register built-in handler
-    service_mode_proto_register(0x00, service_mode_proto_echo_request_handler);
-    service_mode_proto_register(0x01, service_mode_proto_atcmd_request_handler);
+    service_mode_proto_register(PROTO_FRAME_TYPE_ECHO, service_mode_proto_echo_request_handler);
+    service_mode_proto_register(PROTO_FRAME_TYPE_ATCMD, service_mode_proto_atcmd_request_handler);
+    service_mode_proto_register(PROTO_FRAME_TYPE_ATCMD_BATCH, service_mode_proto_atcmd_batch_request_handler);
 }
 
 void service_mode_proto_deinit(SERIAL_PORT port) {
@@ -21,12 +21,24 @@ extern "C" {
 
 #define PROTO_USE_POPCOUNT_CHKSUM
 
+#define PROTO_TX_STAGE_SIZE        (64)//header, short payloads and tailer are gathered into one write
+
 typedef void (*SERVICE_MODE_PROTOCOL_HANDLER) (int, uint8_t *, uint16_t);
 
+typedef enum _PROTO_CHUNK_STATE{
+    PROTO_CHUNK_MORE = 0,   // more payload of this frame follows
+    PROTO_CHUNK_LAST = 1,   // last chunk, the frame checksum is correct
+    PROTO_CHUNK_ABORT = 2,  // checksum error or timeout, drop the chunks received so far
+}PROTO_CHUNK_STATE;
+
+/* port, chunk, chunk length, offset of the chunk in the payload, payload length of the frame, state */
+typedef void (*SERVICE_MODE_PROTOCOL_CHUNK_HANDLER) (int, uint8_t *, uint16_t, uint16_t, uint16_t, PROTO_CHUNK_STATE);
+
 typedef struct _proto_upper_layer_info
 {
     SERVICE_MODE_PROTOCOL_HANDLER request_handler;
     SERVICE_MODE_PROTOCOL_HANDLER response_handler;
+    SERVICE_MODE_PROTOCOL_CHUNK_HANDLER chunk_handler;
 } proto_upper_layer_info;
 
 typedef enum _PROTO_STATE{
@@ -77,6 +89,9 @@ typedef struct proto_packet_tailer_{
 void service_mode_proto_recv(SERIAL_PORT port, uint8_t ch);
 void service_mode_proto_send(SERIAL_PORT port, uint8_t flag, uint8_t frame_type, uint8_t *payload, uint16_t length, SERVICE_MODE_PROTOCOL_HANDLER response_handler);
 int32_t service_mode_proto_register(uint8_t frame_type, SERVICE_MODE_PROTOCOL_HANDLER request_handler);
+/* Request frames of this type are handed over in chunks of up to PROTO_BUFFER_SIZE bytes
+ * while they arrive, so the payload can be up to 65535 bytes. */
+int32_t service_mode_proto_register_chunked(uint8_t frame_type, SERVICE_MODE_PROTOCOL_CHUNK_HANDLER chunk_handler);
 int32_t service_mode_proto_deregister(uint8_t frame_type);
 void service_mode_proto_init(SERIAL_PORT port);
 void service_mode_proto_deinit(SERIAL_PORT port);
@@ -31,6 +31,48 @@ void service_mode_proto_echo_response_handler (SERIAL_PORT port, uint8_t *payloa
     return;
 }
 
+/* While a batch frame executes, the replies of its entries are collected here
+ * and sent in as few response frames as possible.
+ */
+static struct {
+    bool active;
+    uint8_t count;
+    uint16_t len;
+    uint8_t buff[sizeof(proto_atcmd_batch_header)+PROTO_ATCMD_BATCH_SIZE];
+} atcmd_batch;
+
+static void proto_atcmd_batch_flush(SERIAL_PORT port, bool more_data) {
+    proto_atcmd_batch_header header;
+
+    header.length = __builtin_bswap16(atcmd_batch.len);
+    header.flag = PROTO_ATCMD_FLAG_RESPONSE;
+    if (more_data) {
+        header.flag |= PROTO_ATCMD_FLAG_MORE_DATA;
+    }
+    header.count = atcmd_batch.count;
+    memcpy(atcmd_batch.buff, &header, sizeof(header));
+
+    service_mode_proto_send(port, PROTO_FLAG_RESPONSE, PROTO_FRAME_TYPE_ATCMD_BATCH, atcmd_batch.buff, sizeof(header)+atcmd_batch.len, NULL);
+    atcmd_batch.len = 0;
+    atcmd_batch.count = 0;
+}
+
+static void proto_atcmd_reply(SERIAL_PORT port, uint8_t *reply, uint16_t length) {
+    if (!atcmd_batch.active) {
+        service_mode_proto_send(port, PROTO_FLAG_RESPONSE, PROTO_FRAME_TYPE_ATCMD, reply, length, NULL);
+        return;
+    }
+
+    if (length > PROTO_ATCMD_BATCH_SIZE) {
+        length = PROTO_ATCMD_BATCH_SIZE;
+    }
+    if (atcmd_batch.len + length > PROTO_ATCMD_BATCH_SIZE) {
+        proto_atcmd_batch_flush(port, true);
+    }
+    memcpy(atcmd_batch.buff+sizeof(proto_atcmd_batch_header)+atcmd_batch.len, reply, length);
+    atcmd_batch.len += length;
+}
+
 static void service_mode_proto_atcmd_report_error(SERIAL_PORT port, uint8_t atcmd_id, AT_ERRNO_E error) {
     uint8_t buff[256];
     proto_atcmd_header header;
@@ -45,7 +87,7 @@ static void service_mode_proto_atcmd_report_error(SERIAL_PORT port, uint8_t atcm
     header.atcmd_id = atcmd_id;
     memcpy(buff, &header, sizeof(header));
 
-    service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+1, NULL);
+    proto_atcmd_reply(port, buff, sizeof(header)+1);
 }
 
 void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payload, uint16_t length) {
@@ -138,7 +180,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+reply_len, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+reply_len);
                 nRet = AT_OK;
             }
             break;
@@ -155,7 +197,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+reply_len, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+reply_len);
                 nRet = AT_OK;
             }
             break;
@@ -172,7 +214,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+reply_len, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+reply_len);
                 nRet = AT_OK;
             }
             break;
@@ -189,7 +231,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+reply_len, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+reply_len);
                 nRet = AT_OK;
             }
             break;
@@ -221,7 +263,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+reply_len, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+reply_len);
                 nRet = AT_OK;
             }
             break;
@@ -253,7 +295,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+reply_len, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+reply_len);
                 nRet = AT_OK;
             }
             break;
@@ -270,7 +312,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+reply_len, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+reply_len);
                 nRet = AT_OK;
             }
             break;
@@ -302,7 +344,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+reply_len, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+reply_len);
                 nRet = AT_OK;
             }
             break;
@@ -319,7 +361,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+reply_len, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+reply_len);
                 nRet = AT_OK;
             }
             break;
@@ -352,7 +394,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+reply_len, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+reply_len);
                 nRet = AT_OK;
             }
             break;
@@ -371,7 +413,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+reply_len, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+reply_len);
                 nRet = AT_OK;
             }
             break;
@@ -399,7 +441,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+reply_len, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+reply_len);
                 nRet = AT_OK;
             }
             break;
@@ -417,7 +459,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+reply_len, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+reply_len);
                 nRet = AT_OK;
             }
             break;
@@ -496,7 +538,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+4, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+4);
                 nRet = AT_OK;
             }
             break;
@@ -675,7 +717,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+1, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+1);
                 nRet = AT_OK;
             }
             break;
@@ -713,7 +755,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+reply_len, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+reply_len);
                 nRet = AT_OK;
             }
             break;
@@ -750,7 +792,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+reply_len, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+reply_len);
                 nRet = AT_OK;
             }
             break;
@@ -787,7 +829,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+reply_len, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+reply_len);
                 nRet = AT_OK;
             }
             break;
@@ -824,7 +866,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+reply_len, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+reply_len);
                 nRet = AT_OK;
             }
             break;
@@ -855,7 +897,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+reply_len, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+reply_len);
                 nRet = AT_OK;
             }
             break;
@@ -884,7 +926,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+reply_len, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+reply_len);
                 nRet = AT_OK;
             }
             break;
@@ -921,7 +963,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+reply_len, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+reply_len);
                 nRet = AT_OK;
             }
             break;
@@ -962,7 +1004,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+1, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+1);
                 nRet = AT_OK;
             }
             break;
@@ -985,7 +1027,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+1, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+1);
                 nRet = AT_OK;
             }
             break;
@@ -1055,7 +1097,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+4, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+4);
                 nRet = AT_OK;
             }
             break;
@@ -1096,7 +1138,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+1, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+1);
                 nRet = AT_OK;
             }
             break;
@@ -1119,7 +1161,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+1, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+1);
                 nRet = AT_OK;
             }
             break;
@@ -1149,7 +1191,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+reply_len, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+reply_len);
                 nRet = AT_OK;
             }
             break;
@@ -1286,7 +1328,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+1, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+1);
                 nRet = AT_OK;
             }
             break;
@@ -1327,7 +1369,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+1, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+1);
                 nRet = AT_OK;
             }
             break;
@@ -1403,7 +1445,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+1, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+1);
                 nRet = AT_OK;
             }
             break;
@@ -1444,7 +1486,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+1, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+1);
                 nRet = AT_OK;
             }
             break;
@@ -1480,7 +1522,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+1, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+1);
                 nRet = AT_OK;
             }
             break;
@@ -1526,7 +1568,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+4, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+4);
                 nRet = AT_OK;
             }
             break;
@@ -1572,7 +1614,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+4, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+4);
                 nRet = AT_OK;
             }
             break;
@@ -1613,7 +1655,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+1, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+1);
                 nRet = AT_OK;
             }
             break;
@@ -1654,7 +1696,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+4, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+4);
                 nRet = AT_OK;
             }
             break;
@@ -1695,7 +1737,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+4, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+4);
                 nRet = AT_OK;
             }
             break;
@@ -1731,7 +1773,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+1, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+1);
                 nRet = AT_OK;
             }
             break;
@@ -1767,7 +1809,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+4, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+4);
                 nRet = AT_OK;
             }
             break;
@@ -1808,7 +1850,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+1, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+1);
                 nRet = AT_OK;
             }
             break;
@@ -1844,7 +1886,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+1, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+1);
                 nRet = AT_OK;
             }
             break;
@@ -1886,7 +1928,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+1, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+1);
                 nRet = AT_OK;
             }
             break;
@@ -1913,7 +1955,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+4, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+4);
                 nRet = AT_OK;
             }
             break;
@@ -1940,7 +1982,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+4, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+4);
                 nRet = AT_OK;
             }
             break;
@@ -1969,7 +2011,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+reply_len, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+reply_len);
                 nRet = AT_OK;
             }
             break;
@@ -1994,7 +2036,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+reply_len, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+reply_len);
                 nRet = AT_OK;
             }
             break;
@@ -2017,7 +2059,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+2, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+2);
                 nRet = AT_OK;
             }
             break;
@@ -2045,7 +2087,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+1, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+1);
                 nRet = AT_OK;
             }
             break;
@@ -2093,7 +2135,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                     header.atcmd_id = atcmd_id;
                     memcpy(buff, &header, sizeof(header));
 
-                    service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+2, NULL);
+                    proto_atcmd_reply(port, buff, sizeof(header)+2);
                     nRet = AT_OK;
                 }
                 else
@@ -2147,7 +2189,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+4, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+4);
                 nRet = AT_OK;
             }
             break;
@@ -2287,7 +2329,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+1, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+1);
                 nRet = AT_OK;
             }
             break;
@@ -2322,7 +2364,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+1, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+1);
                 nRet = AT_OK;
             }
             break;
@@ -2364,7 +2406,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+4, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+4);
                 nRet = AT_OK;
             }
             break;
@@ -2406,7 +2448,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+1, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+1);
                 nRet = AT_OK;
             }
             break;
@@ -2443,7 +2485,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+4, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+4);
                 nRet = AT_OK;
             }
             break;
@@ -2480,7 +2522,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+1, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+1);
                 nRet = AT_OK;
             }
             break;
@@ -2527,7 +2569,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+2, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+2);
                 nRet = AT_OK;
             }
             break;
@@ -2564,7 +2606,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+1, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+1);
                 nRet = AT_OK;
             }
             break;
@@ -2657,7 +2699,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+1, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+1);
                 nRet = AT_OK;
             }
             break;
@@ -2694,7 +2736,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+reply_len, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+reply_len);
                 nRet = AT_OK;
             }
             break;
@@ -2737,7 +2779,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+4, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+4);
                 nRet = AT_OK;
             }
             break;
@@ -2779,7 +2821,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+4, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+4);
                 nRet = AT_OK;
             }
             break;
@@ -2819,7 +2861,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+reply_len, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+reply_len);
                 nRet = AT_OK;
             }
             break;
@@ -2879,7 +2921,7 @@ void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payloa
                 header.atcmd_id = atcmd_id;
                 memcpy(buff, &header, sizeof(header));
 
-                service_mode_proto_send(port, PROTO_FLAG_RESPONSE, 0x01, buff, sizeof(header)+1, NULL);
+                proto_atcmd_reply(port, buff, sizeof(header)+1);
                 nRet = AT_OK;
             }
             break;
@@ -2900,6 +2942,34 @@ out:
     return;
 }
 
+void service_mode_proto_atcmd_batch_request_handler (SERIAL_PORT port, uint8_t *payload, uint16_t length) {
+    uint16_t pos = 0;
+
+    atcmd_batch.active = true;
+    atcmd_batch.len = 0;
+    atcmd_batch.count = 0;
+
+    while (pos + sizeof(proto_atcmd_header) <= length) {
+        proto_atcmd_header entry;
+        uint16_t entry_len;
+
+        memcpy(&entry, payload+pos, sizeof(entry));
+        entry_len = sizeof(entry) + __builtin_bswap16(entry.length);
+        if (pos + entry_len > length) {
+            service_mode_proto_atcmd_report_error(port, entry.atcmd_id, AT_PARAM_ERROR);
+            atcmd_batch.count++;
+            break;
+        }
+
+        service_mode_proto_atcmd_request_handler(port, payload+pos, entry_len);
+        atcmd_batch.count++;
+        pos += entry_len;
+    }
+
+    proto_atcmd_batch_flush(port, false);
+    atcmd_batch.active = false;
+}
+
 void service_mode_proto_atcmd_response_handler (SERIAL_PORT port, uint8_t *payload, uint16_t length) {
     return;
 }
@@ -132,18 +132,37 @@ typedef enum SERVICE_MODE_PROTO_ATCMD_ID_ {
 #define PROTO_ATCMD_FLAG_ERROR              0x04
 #define PROTO_ATCMD_FLAG_MORE_DATA          0x08
 
+#define PROTO_FRAME_TYPE_ECHO               0x00
+#define PROTO_FRAME_TYPE_ATCMD              0x01
+#define PROTO_FRAME_TYPE_ATCMD_BATCH        0x02
+
+#define PROTO_ATCMD_BATCH_SIZE              256//reply bytes per batch response frame
+
 typedef struct proto_atcmd_header_{
     uint16_t length;
     uint8_t flag;
     uint8_t atcmd_id;
 } __attribute__ ((packed)) proto_atcmd_header;
 
+/* A batch request carries several AT command entries back to back, each one laid out
+ * like the payload of a PROTO_FRAME_TYPE_ATCMD frame. The entries run in order and
+ * their reply and status records, the same ones a single command sends, are returned
+ * after this header. PROTO_ATCMD_FLAG_MORE_DATA is set when another response frame follows.
+ */
+typedef struct proto_atcmd_batch_header_{
+    uint16_t length;
+    uint8_t flag;
+    uint8_t count;//entries whose status record is in this frame
+} __attribute__ ((packed)) proto_atcmd_batch_header;
+
 void service_mode_proto_echo_request_handler (SERIAL_PORT port, uint8_t *payload, uint16_t length);
 
 void service_mode_proto_echo_response_handler (SERIAL_PORT port, uint8_t *payload, uint16_t length);
 
 void service_mode_proto_atcmd_request_handler (SERIAL_PORT port, uint8_t *payload, uint16_t length);
 
+void service_mode_proto_atcmd_batch_request_handler (SERIAL_PORT port, uint8_t *payload, uint16_t length);
+
 void service_mode_proto_atcmd_response_handler (SERIAL_PORT port, uint8_t *payload, uint16_t length);
 
 #ifdef __cplusplus
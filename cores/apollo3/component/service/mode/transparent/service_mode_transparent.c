@@ -4,58 +4,179 @@
 #include "udrv_errno.h"
 #include "udrv_serial.h"
 #include "udrv_timer.h"
+#include "udrv_rtc.h"
+#include "udrv_system.h"
 #include "service_lora.h"
 #include "service_mode.h"
+#include "service_nvm.h"
 
 static uint8_t tp_inst_cnt = 0;
+static bool tp_tick_running = false;
 
+/* Serial input fills the buffers in turn. A buffer is sealed when it reaches the
+ * maximum payload of the current datarate, when the delimiter arrives or after
+ * the idle gap, and the flush tick sends sealed buffers oldest first. Intake
+ * carries on in the next buffer while an uplink is in flight.
+ */
 typedef struct _tp_arrived_byte_stream_info
 {
     SERIAL_PORT port;
     TP_STATE state;
-    uint32_t sgCurPos;
-    uint32_t no_nwk_cnt;
-    char sgTpBuffer[TP_BUFFER_SIZE+1];
+    uint8_t head;//oldest sealed buffer
+    uint8_t sealed;//sealed buffers waiting for an uplink
+    uint16_t len[TP_BUFFER_NUM];
+    uint16_t max_payload;
+    uint32_t idle_ms;
+    int16_t delimiter;
+    bool flow_control;
+    bool xoff;
+    uint64_t last_rx_time;
+    uint64_t no_nwk_time;
+    uint32_t overflow;
+    uint8_t sgTpBuffer[TP_BUFFER_NUM][TP_BUFFER_SIZE];
 } tp_arrived_byte_stream_info;
 
 static tp_arrived_byte_stream_info arrived_byte_stream_info[SERIAL_MAX];
 
-static void lora_handler(void *p_context) {
+static uint64_t tp_now(void) {
+    return udrv_rtc_get_timestamp((RtcID_E)SYS_RTC_COUNTER_PORT);
+}
+
+static void tp_flow_write(SERIAL_PORT port, uint8_t ch) {
+    udrv_serial_write(port, &ch, 1);
+}
+
+static void tp_tick_start(void) {
+    if (!tp_tick_running) {
+        tp_tick_running = true;
+        udrv_system_timer_start(SYSTIMER_TRANSPARENT_MODE, TP_FLUSH_TICK_MS, NULL);
+    }
+}
+
+static void tp_escape(SERIAL_PORT port) {
+    service_mode_transparent_deinit(port);
+    service_mode_cli_init(port);
+    service_nvm_set_mode_type_to_nvm(port, SERVICE_MODE_TYPE_CLI);
+}
+
+/* Returns true while the port still holds data. */
+static bool tp_flush(SERIAL_PORT port) {
+    tp_arrived_byte_stream_info *tp = &arrived_byte_stream_info[port];
     SERVICE_LORA_SEND_INFO info;
+    uint32_t mask;
+    uint8_t fill;
+    int32_t max_payload;
+    uint16_t len;
     int32_t ret;
 
+    udrv_system_critical_section_begin(&mask);
+    fill = (tp->head + tp->sealed) % TP_BUFFER_NUM;
+    if (tp->sealed < TP_BUFFER_NUM && tp->len[fill] != 0 &&
+        (tp_now() - tp->last_rx_time) >= tp->idle_ms) {
+        tp->sealed++;
+    }
+    udrv_system_critical_section_end(&mask);
+
+    if (tp->sealed == 0) {
+        return (tp->len[fill] != 0);
+    }
+
+    /* The datarate may have dropped since the buffer was sealed, send what fits and keep the rest. */
+    max_payload = service_lora_query_txPossible(0);
+    if (max_payload > 0) {
+        tp->max_payload = (max_payload < TP_BUFFER_SIZE) ? max_payload : TP_BUFFER_SIZE;
+    }
+    len = tp->len[tp->head];
+    if (max_payload > 0 && len > max_payload) {
+        len = max_payload;
+    }
+
+    info.port = service_nvm_get_tp_port_from_nvm(port);
+    info.retry_valid = false;
+    info.confirm_valid = false;
+
+    if ((ret = service_lora_send(tp->sgTpBuffer[tp->head], len, info, false)) == UDRV_RETURN_OK) {
+        tp->no_nwk_time = 0;
+        udrv_system_critical_section_begin(&mask);
+        if (len < tp->len[tp->head]) {
+            memmove(tp->sgTpBuffer[tp->head], tp->sgTpBuffer[tp->head] + len, tp->len[tp->head] - len);
+            tp->len[tp->head] -= len;
+        } else {
+            tp->len[tp->head] = 0;
+            tp->head = (tp->head + 1) % TP_BUFFER_NUM;
+            tp->sealed--;
+        }
+        udrv_system_critical_section_end(&mask);
+        if (tp->xoff && tp->sealed < TP_BUFFER_NUM) {
+            tp->xoff = false;
+            tp_flow_write(port, TP_XON_CHAR);
+        }
+    } else if (ret == -UDRV_NO_WAN_CONNECTION) {
+        if (tp->no_nwk_time == 0) {
+            tp->no_nwk_time = tp_now();
+        } else if ((tp_now() - tp->no_nwk_time) > TP_NO_NWK_ESCAPE_MS) {
+            /* escape now immediately */
+            tp_escape(port);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void lora_handler(void *p_context) {
+    bool pending = false;
+
     for (int i = 0 ; i < SERIAL_MAX ; i++) {
         if (service_nvm_get_mode_type_from_nvm((SERIAL_PORT)i) != SERVICE_MODE_TYPE_TRANSPARENT) {
             continue;
         }
 
-        if (arrived_byte_stream_info[(SERIAL_PORT)i].sgCurPos) {
-            info.port = service_nvm_get_tp_port_from_nvm((SERIAL_PORT)i);
-            info.retry_valid = false;
-            info.confirm_valid = false;
-
-            if ((ret = service_lora_send(arrived_byte_stream_info[(SERIAL_PORT)i].sgTpBuffer, arrived_byte_stream_info[(SERIAL_PORT)i].sgCurPos, info, false)) == UDRV_RETURN_OK) {
-                memset(arrived_byte_stream_info[(SERIAL_PORT)i].sgTpBuffer, 0x00, TP_BUFFER_SIZE+1);
-                arrived_byte_stream_info[(SERIAL_PORT)i].sgCurPos = 0;
-                arrived_byte_stream_info[(SERIAL_PORT)i].no_nwk_cnt = 0;
-            } else if (ret == -UDRV_NO_WAN_CONNECTION) {
-                if (++(arrived_byte_stream_info[(SERIAL_PORT)i].no_nwk_cnt) > 5) {
-                    /* escape now immediately */
-                    service_mode_transparent_deinit((SERIAL_PORT)i);
-                    service_mode_cli_init((SERIAL_PORT)i);
-                    service_nvm_set_mode_type_to_nvm((SERIAL_PORT)i, SERVICE_MODE_TYPE_CLI);
-                }
-            }
+        if (tp_flush((SERIAL_PORT)i)) {
+            pending = true;
+        }
+    }
+
+    if (!pending && tp_tick_running) {
+        tp_tick_running = false;
+        udrv_system_timer_stop(SYSTIMER_TRANSPARENT_MODE);
+    }
+}
+
+static void tp_buffer_char(SERIAL_PORT port, uint8_t ch) {
+    tp_arrived_byte_stream_info *tp = &arrived_byte_stream_info[port];
+    bool send_xoff = false;
+    uint32_t mask;
+    uint8_t fill;
+
+    udrv_system_critical_section_begin(&mask);
+    if (tp->sealed == TP_BUFFER_NUM) {
+        /* every buffer waits for an uplink */
+        tp->overflow++;
+        udrv_system_critical_section_end(&mask);
+        return;
+    }
+
+    fill = (tp->head + tp->sealed) % TP_BUFFER_NUM;
+    tp->sgTpBuffer[fill][tp->len[fill]++] = ch;
+    tp->last_rx_time = tp_now();
+    if (tp->len[fill] >= tp->max_payload || (tp->delimiter != TP_NO_DELIMITER && ch == (uint8_t)tp->delimiter)) {
+        tp->sealed++;
+        if (tp->sealed == TP_BUFFER_NUM && tp->flow_control && !tp->xoff) {
+            tp->xoff = true;
+            send_xoff = true;
         }
     }
+    udrv_system_critical_section_end(&mask);
+
+    if (send_xoff) {
+        tp_flow_write(port, TP_XOFF_CHAR);
+    }
+    tp_tick_start();
 }
 
 static TP_STATE tp_normal_handler(SERIAL_PORT port, TP_STATE state, uint8_t ch) {
     /* buffer the input char */
-    if ( (TP_BUFFER_SIZE-1) > arrived_byte_stream_info[port].sgCurPos ) {
-        arrived_byte_stream_info[port].sgTpBuffer[(arrived_byte_stream_info[port].sgCurPos)++] = ch;
-        arrived_byte_stream_info[port].sgTpBuffer[arrived_byte_stream_info[port].sgCurPos] = 0x00;
-    }
+    tp_buffer_char(port, ch);
 
     switch (ch) {
         case TP_ESCAPE_CHAR:
@@ -84,9 +205,7 @@ static TP_STATE tp_escape_handler(SERIAL_PORT port, TP_STATE state, uint8_t ch)
         case TP_STATE_PREPARE_2:
         {
             /* escape now immediately */
-            service_mode_transparent_deinit(port);
-            service_mode_cli_init(port);
-            service_nvm_set_mode_type_to_nvm(port, SERVICE_MODE_TYPE_CLI);
+            tp_escape(port);
             return TP_STATE_DEFAULT;
         }
     }
@@ -124,16 +243,32 @@ void service_mode_transparent_handler(SERIAL_PORT port, uint8_t ch) {
 }
 
 void service_mode_transparent_init(SERIAL_PORT port) {
-    memset(arrived_byte_stream_info[port].sgTpBuffer, 0x00, TP_BUFFER_SIZE+1);
-    arrived_byte_stream_info[port].sgCurPos = 0;
-    arrived_byte_stream_info[port].state = TP_STATE_DEFAULT;
-    arrived_byte_stream_info[port].no_nwk_cnt = 0;
+    tp_arrived_byte_stream_info *tp = &arrived_byte_stream_info[port];
+    int32_t max_payload = 0;
+
+    memset(tp->len, 0x00, sizeof(tp->len));
+    tp->head = 0;
+    tp->sealed = 0;
+    tp->state = TP_STATE_DEFAULT;
+    tp->no_nwk_time = 0;
+    tp->overflow = 0;
+    tp->xoff = false;
+    tp->idle_ms = service_nvm_get_tp_idle_ms_from_nvm(port);
+    tp->delimiter = service_nvm_get_tp_delimiter_from_nvm(port);
+    tp->flow_control = service_nvm_get_tp_flow_control_from_nvm(port);
+    if (tp->idle_ms == 0) {
+        tp->idle_ms = TP_IDLE_FLUSH_MS;
+    }
+    if (service_lora_get_njs()) {
+        max_payload = service_lora_query_txPossible(0);
+    }
+    tp->max_payload = (max_payload > 0 && max_payload < TP_BUFFER_SIZE) ? max_payload : TP_BUFFER_SIZE;
 
     tp_inst_cnt++;
     if (tp_inst_cnt == 1) {
         udrv_system_timer_stop(SYSTIMER_TRANSPARENT_MODE);
         udrv_system_timer_create(SYSTIMER_TRANSPARENT_MODE, lora_handler, HTMR_PERIODIC);
-        udrv_system_timer_start(SYSTIMER_TRANSPARENT_MODE, 3000, NULL);
+        tp_tick_running = false;
     }
 }
 
@@ -141,6 +276,22 @@ void service_mode_transparent_deinit(SERIAL_PORT port) {
     tp_inst_cnt--;
     if (tp_inst_cnt == 0) {
         udrv_system_timer_stop(SYSTIMER_TRANSPARENT_MODE);
+        tp_tick_running = false;
     }
 }
+
+int32_t service_mode_transparent_set_flush(SERIAL_PORT port, uint32_t idle_ms, int16_t delimiter, bool flow_control) {
+    if (port >= SERIAL_MAX || idle_ms == 0 || delimiter < TP_NO_DELIMITER || delimiter > 0xFF) {
+        return -UDRV_WRONG_ARG;
+    }
+
+    arrived_byte_stream_info[port].idle_ms = idle_ms;
+    arrived_byte_stream_info[port].delimiter = delimiter;
+    arrived_byte_stream_info[port].flow_control = flow_control;
+    return service_nvm_set_tp_flush_to_nvm(port, idle_ms, delimiter, flow_control);
+}
+
+uint32_t service_mode_transparent_get_overflow(SERIAL_PORT port) {
+    return arrived_byte_stream_info[port].overflow;
+}
 #endif
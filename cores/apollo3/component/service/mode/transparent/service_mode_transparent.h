@@ -12,7 +12,16 @@ extern "C" {
 #include <stdbool.h>
 #include "udrv_serial.h"
 
-#define TP_BUFFER_SIZE   (512)
+#define TP_BUFFER_SIZE   (256)//above the largest LoRaWAN application payload
+#define TP_BUFFER_NUM    (2)
+
+#define TP_IDLE_FLUSH_MS       (3000)//default inter-byte gap that flushes a partial buffer
+#define TP_FLUSH_TICK_MS       (100)
+#define TP_NO_NWK_ESCAPE_MS    (15000)
+#define TP_NO_DELIMITER        (-1)
+
+#define TP_XON_CHAR    0x11
+#define TP_XOFF_CHAR   0x13
 
 #define TP_ESCAPE_CHAR '+'
 
@@ -34,6 +43,12 @@ typedef TP_STATE (*tp_event_handler)(SERIAL_PORT port, TP_STATE state, uint8_t c
 void service_mode_transparent_handler(SERIAL_PORT port, uint8_t ch);
 void service_mode_transparent_init(SERIAL_PORT port);
 void service_mode_transparent_deinit(SERIAL_PORT port);
+/* idle_ms: inter-byte gap that flushes a partial buffer, delimiter: byte that flushes the
+ * buffer it ends or TP_NO_DELIMITER, flow_control: send XOFF/XON when all buffers are full.
+ * Saved to NVM and applied from the next byte. */
+int32_t service_mode_transparent_set_flush(SERIAL_PORT port, uint32_t idle_ms, int16_t delimiter, bool flow_control);
+/* bytes dropped because every buffer was waiting for an uplink */
+uint32_t service_mode_transparent_get_overflow(SERIAL_PORT port);
 
 #ifdef __cplusplus
 }
@@ -2,6 +2,9 @@
 #include "udrv_errno.h"
 #include "udrv_flash.h"
 #include "service_nvm.h"
+#if defined(SUPPORT_LORA) && defined(SUPPORT_PASSTHRU)
+#include "service_mode_transparent.h"
+#endif
 extern char *sw_version;
 extern char *model_id;
 extern char *cli_version;
@@ -67,6 +70,9 @@ int32_t service_nvm_set_default_config_to_nvm(void) {
 #ifdef SUPPORT_LORA
 #ifdef SUPPORT_PASSTHRU
         g_rui_cfg_t.g_lora_cfg_t.tp_port[i] = 1;
+        g_rui_cfg_t.g_rui_cfg_ex.tp_idle_ms[i] = TP_IDLE_FLUSH_MS;
+        g_rui_cfg_t.g_rui_cfg_ex.tp_delimiter[i] = TP_NO_DELIMITER;
+        g_rui_cfg_t.g_rui_cfg_ex.tp_flow_control[i] = false;
 #endif
 #endif
         switch ((SERIAL_PORT)i) {
@@ -345,6 +351,16 @@ static void service_nvm_data_recovery_from_legacy(uint32_t data_flash_addr, PRE_
         {
             rui_cfg_cur->g_rui_cfg_ex.CAD = 0;
         }
+#if defined(SUPPORT_LORA) && defined(SUPPORT_PASSTHRU)
+        if(*(uint8_t*)&rui_cfg_cur->g_rui_cfg_ex.tp_flow_control == 0xFF)
+        {
+            for (int i = 0 ; i < SERIAL_MAX ; i++) {
+                rui_cfg_cur->g_rui_cfg_ex.tp_idle_ms[i] = TP_IDLE_FLUSH_MS;
+                rui_cfg_cur->g_rui_cfg_ex.tp_delimiter[i] = TP_NO_DELIMITER;
+                rui_cfg_cur->g_rui_cfg_ex.tp_flow_control[i] = false;
+            }
+        }
+#endif
 #endif
     }
     else
@@ -379,6 +395,13 @@ void service_nvm_data_add_to_legacy(PRE_rui_cfg_t *rui_cfg_cur)
     memset(rui_cfg_cur->g_rui_cfg_ex.crypt_key16,0,sizeof(rui_cfg_cur->g_rui_cfg_ex.crypt_key16));
     memset(rui_cfg_cur->g_rui_cfg_ex.crypt_IV,0,sizeof(rui_cfg_cur->g_rui_cfg_ex.crypt_IV));
     rui_cfg_cur->g_rui_cfg_ex.CAD =0;
+#if defined(SUPPORT_LORA) && defined(SUPPORT_PASSTHRU)
+    for (int i = 0 ; i < SERIAL_MAX ; i++) {
+        rui_cfg_cur->g_rui_cfg_ex.tp_idle_ms[i] = TP_IDLE_FLUSH_MS;
+        rui_cfg_cur->g_rui_cfg_ex.tp_delimiter[i] = TP_NO_DELIMITER;
+        rui_cfg_cur->g_rui_cfg_ex.tp_flow_control[i] = false;
+    }
+#endif
 #endif
 }
 
@@ -141,6 +141,9 @@ typedef struct {
     uint8_t certif;
     uint8_t IsCertPortOn;
 #endif
+    uint8_t tp_flow_control[SERIAL_MAX];
+    int16_t tp_delimiter[SERIAL_MAX];
+    uint32_t tp_idle_ms[SERIAL_MAX];
 #endif
 }rui_cfg_t_ex; //add new config here in sequence 
 
@@ -413,6 +416,14 @@ uint8_t service_nvm_get_tp_port_from_nvm(SERIAL_PORT port);
 
 int32_t service_nvm_set_tp_port_to_nvm(SERIAL_PORT port, uint8_t tp_port);
 
+uint32_t service_nvm_get_tp_idle_ms_from_nvm(SERIAL_PORT port);
+
+int16_t service_nvm_get_tp_delimiter_from_nvm(SERIAL_PORT port);
+
+bool service_nvm_get_tp_flow_control_from_nvm(SERIAL_PORT port);
+
+int32_t service_nvm_set_tp_flush_to_nvm(SERIAL_PORT port, uint32_t idle_ms, int16_t delimiter, bool flow_control);
+
 uint32_t service_nvm_get_chs_from_nvm(void);
 
 uint32_t service_nvm_set_chs_to_nvm(uint32_t frequency);
@@ -814,6 +814,26 @@ int32_t service_nvm_set_tp_port_to_nvm(SERIAL_PORT port, uint8_t tp_port) {
 
     return udrv_flash_write(SERVICE_NVM_RUI_CONFIG_NVM_ADDR, sizeof(PRE_rui_cfg_t), (uint8_t *)&g_rui_cfg_t);
 }
+
+uint32_t service_nvm_get_tp_idle_ms_from_nvm(SERIAL_PORT port) {
+    return g_rui_cfg_t.g_rui_cfg_ex.tp_idle_ms[port];
+}
+
+int16_t service_nvm_get_tp_delimiter_from_nvm(SERIAL_PORT port) {
+    return g_rui_cfg_t.g_rui_cfg_ex.tp_delimiter[port];
+}
+
+bool service_nvm_get_tp_flow_control_from_nvm(SERIAL_PORT port) {
+    return g_rui_cfg_t.g_rui_cfg_ex.tp_flow_control[port];
+}
+
+int32_t service_nvm_set_tp_flush_to_nvm(SERIAL_PORT port, uint32_t idle_ms, int16_t delimiter, bool flow_control) {
+    g_rui_cfg_t.g_rui_cfg_ex.tp_idle_ms[port] = idle_ms;
+    g_rui_cfg_t.g_rui_cfg_ex.tp_delimiter[port] = delimiter;
+    g_rui_cfg_t.g_rui_cfg_ex.tp_flow_control[port] = flow_control;
+
+    return udrv_flash_write(SERVICE_NVM_RUI_CONFIG_NVM_ADDR, sizeof(PRE_rui_cfg_t), (uint8_t *)&g_rui_cfg_t);
+}
 uint32_t service_nvm_get_chs_from_nvm(void)
 {
     return g_rui_cfg_t.g_lora_cfg_t.chs;
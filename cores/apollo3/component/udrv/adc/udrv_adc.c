@@ -32,6 +32,27 @@ int32_t udrv_adc_read (uint32_t pin, int16_t *value)
     return uhal_adc_read(pin, value);
 }
 
+int32_t udrv_adc_stream_start (uint32_t pin, uint32_t sample_rate, uint32_t block_size,
+                               uint32_t decimation, UDRV_ADC_BLOCK_HANDLER handler)
+{
+    return uhal_adc_stream_start(pin, sample_rate, block_size, decimation, handler);
+}
+
+int32_t udrv_adc_stream_stop (void)
+{
+    return uhal_adc_stream_stop();
+}
+
+uint32_t udrv_adc_stream_overruns (void)
+{
+    return uhal_adc_stream_overruns();
+}
+
+void udrv_adc_stream_handler (void *p_context)
+{
+    uhal_adc_stream_handler(p_context);
+}
+
 void udrv_adc_suspend(void) {
     uhal_adc_suspend();
 }
@@ -17,6 +17,9 @@ extern "C" {
 #include <stddef.h>
 
 #define UDRV_ADC_SAMPLE_CNT 16
+#define UDRV_ADC_STREAM_BLOCK_MAX 256
+
+typedef void (*UDRV_ADC_BLOCK_HANDLER) (int16_t *samples, uint32_t count);
 
 typedef enum{
     UDRV_ADC_RESOLUTION_6BIT  = (0UL),  //< 6 bit resolution.
@@ -101,6 +104,36 @@ void udrv_adc_oversampling (uint32_t uloversampling);
 
 int32_t udrv_adc_read (uint32_t pin, int16_t *value);
 
+/**
+ * Start continuous sampling of one analog input.
+ * The ADC stays configured and powered until udrv_adc_stream_stop(), samples
+ * are moved by DMA and blocks are delivered from the event loop.
+ * Resolution, mode and oversampling are taken from the current settings.
+ * @param  pin                      The analog input pin
+ * @param  sample_rate              Conversions per second, before decimation
+ * @param  block_size               Samples per block passed to the handler
+ * @param  decimation               Number of conversions averaged into one sample, 1 to disable
+ * @param  handler                  Block callback
+ * @return UDRV_RETURN_OK, -UDRV_BUSY if a stream is running or PWM holds the trigger timer, -UDRV_WRONG_ARG if
+ *         block_size * decimation exceeds the DMA buffer or the rate is out of range
+ */
+int32_t udrv_adc_stream_start (uint32_t pin, uint32_t sample_rate, uint32_t block_size,
+                               uint32_t decimation, UDRV_ADC_BLOCK_HANDLER handler);
+
+/**
+ * Stop continuous sampling and power down the ADC.
+ *
+ */
+int32_t udrv_adc_stream_stop (void);
+
+/**
+ * Number of blocks dropped because the handler did not keep up.
+ *
+ */
+uint32_t udrv_adc_stream_overruns (void);
+
+void udrv_adc_stream_handler (void *p_context);
+
 /**
  * Disable and save all the active ADC channel for power saving
  *
@@ -2,6 +2,7 @@
 #include "udrv_ble.h"
 #include "udrv_delay.h"
 #include "uhal_ble.h"
+#include "uhal_ble_scan.h"
 #include "service_nvm.h"
 #include "uhal_cus_ble.h"
 #include "uhal_ble_hid.h"
@@ -287,6 +288,45 @@ void udrv_ble_scan_stop(void)
     uhal_ble_scan_stop();
 }
 
+int32_t udrv_ble_scan_filter_set_rssi(int8_t min_rssi)
+{
+    return uhal_ble_scan_filter_set_rssi(min_rssi);
+}
+
+int32_t udrv_ble_scan_filter_add_address(uint8_t *mac_addr)
+{
+    return uhal_ble_scan_filter_add_address(mac_addr);
+}
+
+int32_t udrv_ble_scan_filter_set_manufacturer_id(uint16_t company_id)
+{
+    return uhal_ble_scan_filter_set_manufacturer_id(company_id);
+}
+
+int32_t udrv_ble_scan_filter_set_service_uuid(uint8_t *uuid, uint8_t uuid_len)
+{
+    return uhal_ble_scan_filter_set_service_uuid(uuid, uuid_len);
+}
+
+void udrv_ble_scan_filter_clear(void)
+{
+    uhal_ble_scan_filter_clear();
+}
+
+int32_t udrv_ble_scan_set_dedup_window(uint32_t window_ms)
+{
+    return uhal_ble_scan_set_dedup_window(window_ms);
+}
+
+int32_t udrv_ble_scan_set_batch(uint32_t interval_ms, BLE_SCAN_BATCH_HANDLER handler)
+{
+    int32_t ret = uhal_ble_scan_set_batch(interval_ms, handler);
+
+    // Let the scanner task pick up the new interval.
+    uhal_ble_scan_wakeup();
+    return ret;
+}
+
 void udrv_ble_hid_start()
 {
     //if(ble_services_is_enable)
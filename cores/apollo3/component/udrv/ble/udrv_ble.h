@@ -84,6 +84,19 @@ extern "C"
 
     typedef void (*BLE_SCAN_DATA_HANDLER) (int8_t, uint8_t *, uint8_t *, uint16_t); //rssi, mac address, raw data, raw data length
 
+    typedef struct
+    {
+        uint8_t  mac_addr[6];
+        uint16_t count;          /**< reports aggregated since the last batch */
+        int8_t   rssi_min;
+        int8_t   rssi_max;
+        int8_t   rssi_avg;
+        uint8_t  adv_length;     /**< length of the last payload */
+        uint8_t  adv_data[31];   /**< last payload */
+    } udrv_ble_scan_batch_entry_t;
+
+    typedef void (*BLE_SCAN_BATCH_HANDLER) (udrv_ble_scan_batch_entry_t *, uint16_t); //entries, number of entries
+
     typedef void (*BLE_KEYBOARD_HANDLER) (uint16_t, uint8_t);
 
     typedef void (*BLE_HANDLER)(void);
@@ -176,6 +189,20 @@ extern "C"
     
     void udrv_ble_scan_stop(void); 
 
+    int32_t udrv_ble_scan_filter_set_rssi(int8_t min_rssi);
+
+    int32_t udrv_ble_scan_filter_add_address(uint8_t *mac_addr);
+
+    int32_t udrv_ble_scan_filter_set_manufacturer_id(uint16_t company_id);
+
+    int32_t udrv_ble_scan_filter_set_service_uuid(uint8_t *uuid, uint8_t uuid_len);
+
+    void udrv_ble_scan_filter_clear(void);
+
+    int32_t udrv_ble_scan_set_dedup_window(uint32_t window_ms);
+
+    int32_t udrv_ble_scan_set_batch(uint32_t interval_ms, BLE_SCAN_BATCH_HANDLER handler);
+
     void udrv_ble_hid_start();
 
     void udrv_ble_hid_keys_send(uint8_t key_len, uint8_t * key_pattern);
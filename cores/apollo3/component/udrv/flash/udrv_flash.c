@@ -1,15 +1,13 @@
 #include <stdint.h>
 #include "udrv_flash.h"
 #include "uhal_flash.h"
+#include "service_profile.h"
 
 bool udrv_flash_initialized = false;
-#ifdef STM32WL55xx//XXX:4096 is too big for STM32WL
-__attribute__((aligned(8))) static uint8_t page_buff[2048];
-#elif PART_APOLLO3
-__attribute__((aligned(8))) static uint8_t page_buff[8192];
-#else
-__attribute__((aligned(8))) static uint8_t page_buff[4096];
-#endif
+__attribute__((aligned(8))) static uint8_t page_buff[UDRV_FLASH_PAGE_BUFF_SIZE];
+static udrv_flash_stream_t *page_buff_stream;   //stream using page_buff as its accumulator
+
+static int32_t flash_stream_program(udrv_flash_stream_t *stream);
 
 void udrv_flash_init (void) {
     if (udrv_flash_initialized == false) {
@@ -24,165 +22,394 @@ void udrv_flash_deinit (void) {
         udrv_flash_initialized = false;
     }
 }
-bool compare_page_buff(uint32_t addr,uint32_t len, uint8_t *buff)
-{
-    uint32_t page_size = udrv_flash_get_page_size();
-    uint32_t buf_size = 1024;
-    uint8_t flag = 0;
-    uint8_t tmp_buff[buf_size];
-    for(uint8_t i = 0;i<page_size/buf_size;i++)
-    {
-        if(len >= buf_size)
-        {
-            udrv_flash_read(addr + buf_size*i,buf_size,tmp_buff);
-            if(memcmp(tmp_buff,buff + buf_size*i,buf_size) != 0)
-                return false;
-        }
-        else
-        {
-            udrv_flash_read(addr + buf_size*i,len,tmp_buff);
-            if(memcmp(tmp_buff,buff + buf_size*i,len) != 0)
-                return false;
-            break;
+/*
+ * Word at page offset i of the current flash content (staged in page_buff)
+ * with the bytes of [off, off+n) replaced by buff.
+ */
+static uint32_t flash_stage_word(uint32_t i, uint32_t off, uint32_t n, uint8_t *buff) {
+    uint8_t word[4];
+    uint32_t staged;
+
+    memcpy(word, page_buff + i, 4);
+    for (uint32_t j = 0 ; j < 4 ; j++) {
+        if (i + j >= off && i + j < off + n) {
+            word[j] = buff[i + j - off];
         }
-        len -= buf_size;
     }
-    return true;
+    memcpy(&staged, word, 4);
+    return staged;
 }
 
+/*
+ * Try to update [off, off+n) of one page without erasing it. This works when
+ * every word that changes is still erased, then only those words are
+ * programmed. Return 1 when the page needs a read-modify-erase cycle instead.
+ */
+static int32_t flash_program_words(uint32_t page_addr, uint32_t off, uint32_t n, uint8_t *buff) {
+    uint32_t first = off & ~3UL;
+    uint32_t last = (off + n + 3) & ~3UL;
+    uint32_t run = 0, run_len = 0;
+    uint32_t word, staged;
+
+    uhal_flash_read(page_addr + first, page_buff + first, last - first);
+
+    for (uint32_t i = first ; i < last ; i += 4) {
+        word = *(uint32_t *)(page_buff + i);
+        staged = flash_stage_word(i, off, n, buff);
+        if (staged != word && word != 0xFFFFFFFF) {
+            return 1;
+        }
+    }
+
+    for (uint32_t i = first ; i <= last ; i += 4) {
+        bool changed = false;
+
+        if (i < last) {
+            word = *(uint32_t *)(page_buff + i);
+            staged = flash_stage_word(i, off, n, buff);
+            *(uint32_t *)(page_buff + i) = staged;
+            changed = (staged != word);
+        }
+
+        if (changed) {
+            if (run_len == 0) {
+                run = i;
+            }
+            run_len += 4;
+        } else if (run_len != 0) {
+            if (uhal_flash_write(page_addr + run, page_buff + run, run_len) != UDRV_RETURN_OK) {
+                return -UDRV_INTERNAL_ERR;
+            }
+            run_len = 0;
+        }
+    }
+
+    return UDRV_RETURN_OK;
+}
+
+/*
+ * Take page_buff back from a stream: program the page it holds there, the
+ * stream reloads it from flash on its next write.
+ */
+static int32_t flash_page_buff_reclaim(void) {
+    udrv_flash_stream_t *stream = page_buff_stream;
+    int32_t ret;
+
+    if (stream == NULL || stream->page_index == UDRV_FLASH_STREAM_NO_PAGE) {
+        return UDRV_RETURN_OK;
+    }
+
+    if ((ret = flash_stream_program(stream)) != UDRV_RETURN_OK) {
+        return ret;
+    }
+    stream->page_index = UDRV_FLASH_STREAM_NO_PAGE;
+
+    return UDRV_RETURN_OK;
+}
 
 int32_t udrv_flash_write (uint32_t addr, uint32_t len, uint8_t *buff) {
     uint32_t page_size = udrv_flash_get_page_size();
-    uint32_t actual_addr, actual_len, curr_page, remaining;
-    uint8_t *buffp;
-#ifdef STM32WL55xx//XXX:4096 is too big for STM32WL
-    if (page_size > 2048) {
-#elif PART_APOLLO3
-    if (page_size > 8192) {
-#else
-    if (page_size > 4096) {
-#endif
+    uint32_t page_addr, off, n;
+    int32_t ret = UDRV_RETURN_OK;
+
+    if (page_size > UDRV_FLASH_PAGE_BUFF_SIZE) {
         return -UDRV_BUFF_OVERFLOW;
     }
 
-    if(compare_page_buff(addr,len,buff))
-        return UDRV_RETURN_OK;
-
-    if (addr % page_size != 0) {
-        actual_addr = (addr / page_size) * page_size;
-    } else {
-        actual_addr = addr;
+    if ((ret = flash_page_buff_reclaim()) != UDRV_RETURN_OK) {
+        return ret;
     }
 
-    if ((len + (addr - actual_addr)) % page_size != 0) {
-        actual_len = (((len + (addr - actual_addr)) / page_size) + 1) * page_size;
-    } else {
-        actual_len = len + (addr - actual_addr);
-    }
-
-    buffp = buff;
-    remaining = len;
-    for (curr_page = 0 ; curr_page < (actual_len/page_size) ; curr_page++) {
-        uhal_flash_read(actual_addr + page_size*curr_page, page_buff, page_size);
-        //handle the 1st page
-        if (curr_page == 0) {
-            if (len > (page_size - (addr - actual_addr))) {
-                memcpy(page_buff+(addr - actual_addr), buffp, (page_size - (addr - actual_addr)));
-                buffp += (page_size - (addr - actual_addr));
-                remaining -= (page_size - (addr - actual_addr));
-            } else {
-                memcpy(page_buff+(addr - actual_addr), buffp, len);
-                buffp += len;
-                remaining -= len;
+    SERVICE_PROFILE_BEGIN(SERVICE_PROFILE_FLASH);
+    while (len) {
+        page_addr = (addr / page_size) * page_size;
+        off = addr - page_addr;
+        n = (len < page_size - off) ? len : page_size - off;
+
+        ret = flash_program_words(page_addr, off, n, buff);
+        if (ret < 0) {
+            break;
+        }
+
+        if (ret > 0) {
+            uhal_flash_read(page_addr, page_buff, page_size);
+            memcpy(page_buff + off, buff, n);
+
+            if (uhal_flash_erase(page_addr, page_size) != UDRV_RETURN_OK ||
+                uhal_flash_write(page_addr, page_buff, page_size) != UDRV_RETURN_OK) {
+                ret = -UDRV_INTERNAL_ERR;
+                break;
             }
-        //handle the last page
-        } else if ((curr_page) + 1 >= (actual_len/page_size) ) {
-            memcpy(page_buff, buffp, remaining);
-        } else {
-            memcpy(page_buff, buffp, page_size);
-            buffp += page_size;
-            remaining -= page_size;
         }
 
-        if (uhal_flash_erase(actual_addr + page_size*curr_page, page_size) != UDRV_RETURN_OK) {
-            return -UDRV_INTERNAL_ERR;
+        addr += n;
+        buff += n;
+        len -= n;
+    }
+    SERVICE_PROFILE_END_ARG(SERVICE_PROFILE_FLASH, 0);
+
+    return (ret < 0) ? ret : UDRV_RETURN_OK;
+}
+
+int32_t udrv_flash_read (uint32_t addr, uint32_t len, uint8_t *buff) {
+    //flash is memory mapped, no need to go through page_buff
+    return uhal_flash_read(addr, buff, len);
+}
+
+int32_t udrv_flash_erase (uint32_t addr, uint32_t len) {
+    uint32_t page_size = udrv_flash_get_page_size();
+
+    if (addr & 0x3) {
+        return -UDRV_ADDR_NOT_ALIGNED;
+    }
+
+    if (len % page_size) {
+        return -UDRV_LEN_NOT_ALIGNED;
+    }
+
+    SERVICE_PROFILE_BEGIN(SERVICE_PROFILE_FLASH);
+    int32_t ret = uhal_flash_erase(addr, len);
+    SERVICE_PROFILE_END_ARG(SERVICE_PROFILE_FLASH, 1);
+
+    return ret;
+}
+
+static inline bool flash_stream_test(uint32_t *map, uint32_t page) {
+    return (map[page >> 5] & (1UL << (page & 31))) != 0;
+}
+
+static inline void flash_stream_mark(uint32_t *map, uint32_t page) {
+    map[page >> 5] |= (1UL << (page & 31));
+}
+
+int32_t udrv_flash_stream_open (udrv_flash_stream_t *stream, uint32_t base, uint32_t size, uint8_t *page) {
+    uint32_t page_size = udrv_flash_get_page_size();
+    int32_t ret;
+
+    if (stream == NULL) {
+        return -UDRV_WRONG_ARG;
+    }
+
+    //whatever an earlier open left in the accumulator is dropped
+    if (page_buff_stream == stream) {
+        page_buff_stream = NULL;
+    }
+    stream->page = NULL;
+    stream->page_index = UDRV_FLASH_STREAM_NO_PAGE;
+
+    if (page_size > UDRV_FLASH_PAGE_BUFF_SIZE) {
+        return -UDRV_WRONG_ARG;
+    }
+
+    if (base % page_size != 0 || size > UDRV_FLASH_STREAM_PAGES_MAX * page_size) {
+        return -UDRV_WRONG_ARG;
+    }
+
+    if (page == NULL) {
+        //another stream using page_buff gets its page programmed
+        if ((ret = flash_page_buff_reclaim()) != UDRV_RETURN_OK) {
+            return ret;
         }
+        page_buff_stream = stream;
+        page = page_buff;
+    }
+
+    memset(stream, 0, sizeof(udrv_flash_stream_t));
+    stream->base = base;
+    stream->size = size;
+    stream->page = page;
+    stream->page_index = UDRV_FLASH_STREAM_NO_PAGE;
+
+    return UDRV_RETURN_OK;
+}
 
-        if (uhal_flash_write(actual_addr + page_size*curr_page, page_buff, page_size) != UDRV_RETURN_OK) {
+/*
+ * Program the words of a reloaded page that differ from flash, when all of
+ * them are still erased (e.g. fragments rebuilt into the holes left by lost
+ * ones). Return 1 when the page needs an erase instead.
+ */
+static int32_t flash_stream_patch(udrv_flash_stream_t *stream, uint32_t addr) {
+    uint32_t page_size = udrv_flash_get_page_size();
+    uint32_t run = 0, run_len = 0;
+    uint32_t word, staged;
+
+    for (uint32_t i = 0 ; i < page_size ; i += 4) {
+        uhal_flash_read(addr + i, (uint8_t *)&word, 4);
+        memcpy(&staged, stream->page + i, 4);
+        if (staged != word && word != 0xFFFFFFFF) {
+            return 1;
+        }
+    }
+
+    for (uint32_t i = 0 ; i <= page_size ; i += 4) {
+        bool changed = false;
+
+        if (i < page_size) {
+            uhal_flash_read(addr + i, (uint8_t *)&word, 4);
+            memcpy(&staged, stream->page + i, 4);
+            changed = (staged != word);
+        }
+
+        if (changed) {
+            if (run_len == 0) {
+                run = i;
+            }
+            run_len += 4;
+        } else if (run_len != 0) {
+            if (uhal_flash_write(addr + run, stream->page + run, run_len) != UDRV_RETURN_OK) {
+                return -UDRV_INTERNAL_ERR;
+            }
+            stream->program_count++;
+            run_len = 0;
+        }
+    }
+
+    return UDRV_RETURN_OK;
+}
+
+static int32_t flash_stream_program(udrv_flash_stream_t *stream) {
+    uint32_t page_size = udrv_flash_get_page_size();
+    uint32_t addr = stream->base + stream->page_index * page_size;
+    int32_t ret;
+
+    if (!stream->page_dirty) {
+        return UDRV_RETURN_OK;
+    }
+
+    if (flash_stream_test(stream->programmed, stream->page_index)) {
+        //reloaded page, patch it in place or erase and program it whole
+        if ((ret = flash_stream_patch(stream, addr)) <= 0) {
+            if (ret == UDRV_RETURN_OK) {
+                stream->page_dirty = false;
+            }
+            return ret;
+        }
+        if (uhal_flash_erase(addr, page_size) != UDRV_RETURN_OK) {
             return -UDRV_INTERNAL_ERR;
         }
+        stream->erase_count++;
+        stream->page_fill = page_size;
     }
 
+    if (uhal_flash_write(addr, stream->page, (stream->page_fill + 3) & ~3UL) != UDRV_RETURN_OK) {
+        return -UDRV_INTERNAL_ERR;
+    }
+    stream->program_count++;
+
+    flash_stream_mark(stream->programmed, stream->page_index);
+    stream->page_dirty = false;
+
     return UDRV_RETURN_OK;
 }
 
-int32_t udrv_flash_read (uint32_t addr, uint32_t len, uint8_t *buff) {
+static int32_t flash_stream_load(udrv_flash_stream_t *stream, uint32_t page_index) {
     uint32_t page_size = udrv_flash_get_page_size();
-    uint32_t actual_addr, actual_len, curr_page, remaining;
-    uint8_t *buffp;
-
-#ifdef STM32WL55xx//XXX:4096 is too big for STM32WL
-    if (page_size > 2048) {
-#elif PART_APOLLO3
-    if (page_size > 8192) {
-#else
-    if (page_size > 4096) {
-#endif
-        return -UDRV_BUFF_OVERFLOW;
+    uint32_t addr = stream->base + page_index * page_size;
+    int32_t ret;
+
+    if (stream->page_index != UDRV_FLASH_STREAM_NO_PAGE) {
+        if ((ret = flash_stream_program(stream)) != UDRV_RETURN_OK) {
+            return ret;
+        }
     }
 
-    if (addr % page_size != 0) {
-        actual_addr = (addr / page_size) * page_size;
+    if (flash_stream_test(stream->programmed, page_index)) {
+        uhal_flash_read(addr, stream->page, page_size);
     } else {
-        actual_addr = addr;
+        if (!flash_stream_test(stream->erased, page_index)) {
+            if (uhal_flash_erase(addr, page_size) != UDRV_RETURN_OK) {
+                return -UDRV_INTERNAL_ERR;
+            }
+            stream->erase_count++;
+            flash_stream_mark(stream->erased, page_index);
+        }
+        memset(stream->page, 0xFF, page_size);
     }
 
-    if ((len + (addr - actual_addr)) % page_size != 0) {
-        actual_len = (((len + (addr - actual_addr)) / page_size) + 1) * page_size;
-    } else {
-        actual_len = len + (addr - actual_addr);
-    }
-
-    buffp = buff;
-    remaining = len;
-    for (curr_page = 0 ; curr_page < (actual_len/page_size) ; curr_page++) {
-        uhal_flash_read(actual_addr + page_size*curr_page, page_buff, page_size);
-        //handle the 1st page
-        if (curr_page == 0) {
-            if (len > (page_size - (addr - actual_addr))) {
-                memcpy(buffp, page_buff+(addr - actual_addr), (page_size - (addr - actual_addr)));
-                buffp += (page_size - (addr - actual_addr));
-                remaining -= (page_size - (addr - actual_addr));
-            } else {
-                memcpy(buffp, page_buff+(addr - actual_addr), len);
-                buffp += len;
-                remaining -= len;
+    stream->page_index = page_index;
+    stream->page_fill = 0;
+    stream->page_dirty = false;
+
+    return UDRV_RETURN_OK;
+}
+
+int32_t udrv_flash_stream_write (udrv_flash_stream_t *stream, uint32_t offset, uint8_t *buff, uint32_t len) {
+    uint32_t page_size = udrv_flash_get_page_size();
+    int32_t ret;
+
+    if (offset > stream->size || len > stream->size - offset) {
+        return -UDRV_WRONG_ARG;
+    }
+
+    while (len) {
+        uint32_t page_index = offset / page_size;
+        uint32_t in_page = offset % page_size;
+        uint32_t n = (len < page_size - in_page) ? len : page_size - in_page;
+
+        if (page_index != stream->page_index) {
+            if ((ret = flash_stream_load(stream, page_index)) != UDRV_RETURN_OK) {
+                return ret;
             }
-        //handle the last page
-        } else if ((curr_page) + 1 >= (actual_len/page_size) ) {
-            memcpy(buffp, page_buff, remaining);
-        } else {
-            memcpy(buffp, page_buff, page_size);
-            buffp += page_size;
-            remaining -= page_size;
         }
+
+        memcpy(stream->page + in_page, buff, n);
+        if (in_page + n > stream->page_fill) {
+            stream->page_fill = in_page + n;
+        }
+        stream->page_dirty = true;
+
+        offset += n;
+        buff += n;
+        len -= n;
     }
 
     return UDRV_RETURN_OK;
 }
 
-int32_t udrv_flash_erase (uint32_t addr, uint32_t len) {
+int32_t udrv_flash_stream_read (udrv_flash_stream_t *stream, uint32_t offset, uint8_t *buff, uint32_t len) {
     uint32_t page_size = udrv_flash_get_page_size();
 
-    if (addr & 0x3) {
-        return -UDRV_ADDR_NOT_ALIGNED;
+    if (offset > stream->size || len > stream->size - offset) {
+        return -UDRV_WRONG_ARG;
     }
 
-    if (len % page_size) {
-        return -UDRV_LEN_NOT_ALIGNED;
+    while (len) {
+        uint32_t page_index = offset / page_size;
+        uint32_t in_page = offset % page_size;
+        uint32_t n = (len < page_size - in_page) ? len : page_size - in_page;
+
+        if (page_index == stream->page_index) {
+            memcpy(buff, stream->page + in_page, n);
+        } else {
+            uhal_flash_read(stream->base + offset, buff, n);
+        }
+
+        offset += n;
+        buff += n;
+        len -= n;
+    }
+
+    return UDRV_RETURN_OK;
+}
+
+int32_t udrv_flash_stream_flush (udrv_flash_stream_t *stream) {
+    if (stream->page_index == UDRV_FLASH_STREAM_NO_PAGE) {
+        return UDRV_RETURN_OK;
+    }
+
+    return flash_stream_program(stream);
+}
+
+int32_t udrv_flash_stream_close (udrv_flash_stream_t *stream) {
+    int32_t ret = udrv_flash_stream_flush(stream);
+
+    if (page_buff_stream == stream) {
+        page_buff_stream = NULL;
     }
+    stream->page = NULL;
+    stream->page_index = UDRV_FLASH_STREAM_NO_PAGE;
 
-    return uhal_flash_erase(addr, len);
+    return ret;
 }
 
 uint32_t udrv_flash_get_page_size(void) {
@@ -17,6 +17,41 @@ extern "C" {
 #include <stdbool.h>
 #include "pin_define.h"
 
+#ifdef STM32WL55xx//XXX:4096 is too big for STM32WL
+#define UDRV_FLASH_PAGE_BUFF_SIZE       2048
+#elif PART_APOLLO3
+#define UDRV_FLASH_PAGE_BUFF_SIZE       8192
+#else
+#define UDRV_FLASH_PAGE_BUFF_SIZE       4096
+#endif
+
+#define UDRV_FLASH_STREAM_PAGES_MAX     128
+#define UDRV_FLASH_STREAM_NO_PAGE       0xFFFFFFFF
+
+/**
+ * Streaming writer for a large flash region such as a firmware image.
+ * Writes are gathered in a RAM copy of one page. Each page is erased once
+ * when the writer first reaches it and programmed when the writer moves to
+ * another page or on udrv_flash_stream_flush(). A write into a page that has
+ * already been programmed reloads it; it is programmed in place if it only
+ * fills words still erased, and costs another erase otherwise.
+ * The accumulator can be the driver's own page buffer: udrv_flash_write()
+ * then programs the page held there before it uses the buffer, and the
+ * stream reloads that page on its next write.
+ */
+typedef struct {
+    uint32_t    base;                   //page aligned start of the region
+    uint32_t    size;
+    uint8_t     *page;                  //accumulator, UDRV_FLASH_PAGE_BUFF_SIZE bytes, NULL when closed
+    uint32_t    page_index;             //page held in the accumulator
+    uint32_t    page_fill;              //end of the data written into the accumulator
+    bool        page_dirty;
+    uint32_t    erased[UDRV_FLASH_STREAM_PAGES_MAX / 32];
+    uint32_t    programmed[UDRV_FLASH_STREAM_PAGES_MAX / 32];
+    uint32_t    erase_count;
+    uint32_t    program_count;
+} udrv_flash_stream_t;
+
 void udrv_flash_init (void);
 
 void udrv_flash_deinit (void);
@@ -31,6 +66,30 @@ uint32_t udrv_flash_get_page_size(void);
 
 bool udrv_flash_check_addr_valid(uint32_t addr, uint32_t len);
 
+/**
+ * Start writing a region, forgetting what an earlier open of the stream held.
+ * A NULL page_buff shares the driver's page buffer. The stream is left
+ * closed when this fails.
+ */
+int32_t udrv_flash_stream_open (udrv_flash_stream_t *stream, uint32_t base, uint32_t size, uint8_t *page_buff);
+
+int32_t udrv_flash_stream_write (udrv_flash_stream_t *stream, uint32_t offset, uint8_t *buff, uint32_t len);
+
+/**
+ * Read back from the region, data not flushed yet comes from the accumulator.
+ */
+int32_t udrv_flash_stream_read (udrv_flash_stream_t *stream, uint32_t offset, uint8_t *buff, uint32_t len);
+
+/**
+ * Program what is left in the accumulator, up to the last byte written.
+ */
+int32_t udrv_flash_stream_flush (udrv_flash_stream_t *stream);
+
+/**
+ * Flush and give the accumulator back.
+ */
+int32_t udrv_flash_stream_close (udrv_flash_stream_t *stream);
+
 void udrv_flash_suspend(void);
 
 void udrv_flash_resume(void);
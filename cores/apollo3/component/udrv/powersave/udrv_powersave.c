@@ -1,5 +1,6 @@
 #include <stddef.h>
 #include <stdbool.h>
+#include <string.h>
 #include "udrv_powersave.h"
 #include "uhal_powersave.h"
 #if defined(SUPPORT_LORA) || defined(SUPPORT_LORA_P2P)
@@ -14,6 +15,12 @@
 #include "udrv_rtc.h"
 #include "udrv_system.h"
 #include "udrv_errno.h"
+#include "udrv_spimst.h"
+#include "uhal_uart.h"
+#include "uhal_spimst.h"
+#include "uhal_twimst.h"
+#include "uhal_pwm.h"
+#include "uhal_adc.h"
 
 #ifdef  RAK5010_EVB
 #include "bg96.h"
@@ -32,6 +39,35 @@ static uint64_t udrv_powersave_last_wakeup_time;
 static uint32_t udrv_powersave_min_wakeup_time = 3;//3ms > the time to receive 2 byte in baudrate 9600 = (1/9600)*10*2 = 2.08ms
 
 uint32_t wlock_cnt;
+static uint32_t powersave_wlock_holder[UDRV_PS_WLOCK_MAX];
+static volatile uint32_t powersave_latency[UDRV_PS_LATENCY_MAX] = {
+    [0 ... UDRV_PS_LATENCY_MAX - 1] = UDRV_PS_LATENCY_ANY,
+};
+
+/* Power accounting. The wake-up handlers only leave their source behind,
+ * all counting is done by the sleeping task around the sleep loop. */
+static udrv_powersave_stats_t powersave_stats;
+static uint64_t powersave_stats_since;
+static volatile bool powersave_sleeping;
+static volatile UDRV_PS_WAKE_SRC powersave_wake_src = UDRV_PS_WAKE_SRC_MAX;
+
+/* The handler that ends an idle sleep only runs once the idle task unmasks
+ * interrupts, so its source is counted on the next idle sleep or read. */
+static volatile bool powersave_idle_pending;
+static volatile UDRV_PS_WAKE_SRC powersave_idle_wake_src = UDRV_PS_WAKE_SRC_MAX;
+
+static const char * const powersave_wake_src_name[UDRV_PS_WAKE_SRC_MAX] = {
+    "TIMER", "RTC", "GPIO", "UART", "BLE", "RADIO", "OTHER",
+};
+static const char * const powersave_refuse_name[UDRV_PS_REFUSE_MAX] = {
+    "WLOCK", "RXWAIT", "RESUMED", "MINWAKE", "EVENT",
+};
+static const char * const powersave_wlock_name[UDRV_PS_WLOCK_MAX] = {
+    "OTHER", "P2P", "TEST", "PROTO",
+};
+static const char * const powersave_idle_name[UDRV_PS_IDLE_MAX] = {
+    "NORMAL", "DEEP",
+};
 
 #ifdef SUPPORT_MULTITASK
 extern bool sched_pending;
@@ -54,8 +90,133 @@ struct udrv_powersave_api powersave_driver =
   uhal_sys_clock_off,
 };
 
+#ifdef SUPPORT_USB
+static const struct udrv_powersave_periph_api powersave_usb_hooks = {NULL, uhal_usb_suspend, uhal_usb_resume};
+#endif
+#ifdef SUPPORT_SPI
+static const struct udrv_powersave_periph_api powersave_spi_hooks = {uhal_spimst_is_active, udrv_spimst_suspend, udrv_spimst_resume};
+#endif
+static const struct udrv_powersave_periph_api powersave_adc_hooks = {uhal_adc_is_active, udrv_adc_suspend, udrv_adc_resume};
+static const struct udrv_powersave_periph_api powersave_pwm_hooks = {uhal_pwm_is_active, udrv_pwm_suspend, udrv_pwm_resume};
+static const struct udrv_powersave_periph_api powersave_serial_hooks = {uhal_uart_is_active, udrv_serial_suspend, udrv_serial_resume};
+static const struct udrv_powersave_periph_api powersave_twi_hooks = {uhal_twimst_is_active, udrv_twimst_suspend, udrv_twimst_resume};
+static const struct udrv_powersave_periph_api powersave_gpio_hooks = {NULL, udrv_gpio_suspend, udrv_gpio_resume};
+static const struct udrv_powersave_periph_api powersave_rtc_hooks = {NULL, udrv_rtc_suspend, udrv_rtc_resume};
+
+/* Bus masters are only touched through their udrv API, so they come back on
+ * first use; everything else has to be running again when the MCU wakes up. */
+static struct {
+    struct udrv_powersave_periph_api const *api;
+    bool lazy;
+} powersave_periph[UDRV_PS_PERIPH_MAX] = {
+#ifdef SUPPORT_USB
+    [UDRV_PS_PERIPH_USB]    = {&powersave_usb_hooks, false},
+#endif
+#ifdef SUPPORT_SPI
+    [UDRV_PS_PERIPH_SPI]    = {&powersave_spi_hooks, true},
+#endif
+    [UDRV_PS_PERIPH_ADC]    = {&powersave_adc_hooks, false},
+    [UDRV_PS_PERIPH_PWM]    = {&powersave_pwm_hooks, false},
+    [UDRV_PS_PERIPH_SERIAL] = {&powersave_serial_hooks, false},
+    [UDRV_PS_PERIPH_TWI]    = {&powersave_twi_hooks, true},
+    [UDRV_PS_PERIPH_GPIO]   = {&powersave_gpio_hooks, false},
+    [UDRV_PS_PERIPH_RTC]    = {&powersave_rtc_hooks, false},
+};
+
+/* Peripherals suspended and not resumed yet */
+static volatile uint32_t powersave_periph_suspended;
+
+static inline uint32_t powersave_critical_enter(void)
+{
+#ifdef rak11720
+    if(isInISR())
+        return taskENTER_CRITICAL_FROM_ISR();
+    taskENTER_CRITICAL();
+#endif
+    return 0;
+}
+
+static inline void powersave_critical_exit(uint32_t status)
+{
+#ifdef rak11720
+    if(isInISR())
+        taskEXIT_CRITICAL_FROM_ISR(status);
+    else
+        taskEXIT_CRITICAL();
+#endif
+}
+
+void udrv_powersave_periph_suspend_all(void)
+{
+    uint32_t status = powersave_critical_enter();
+
+    for (int i = 0 ; i < UDRV_PS_PERIPH_MAX ; i++) {
+        struct udrv_powersave_periph_api const *api = powersave_periph[i].api;
+
+        //Still down from the last sleep, or not in use
+        if (api == NULL || (powersave_periph_suspended & (1UL << i)))
+            continue;
+        if (api->IS_ACTIVE && !api->IS_ACTIVE())
+            continue;
+
+        api->SUSPEND();
+        powersave_periph_suspended |= (1UL << i);
+    }
+
+    powersave_critical_exit(status);
+}
+
+void udrv_powersave_periph_resume_all(void)
+{
+    uint32_t status = powersave_critical_enter();
+
+    for (int i = UDRV_PS_PERIPH_MAX - 1 ; i >= 0 ; i--) {
+        if (!(powersave_periph_suspended & (1UL << i)) || powersave_periph[i].lazy)
+            continue;
+
+        powersave_periph[i].api->RESUME();
+        powersave_periph_suspended &= ~(1UL << i);
+    }
+
+    powersave_critical_exit(status);
+}
+
+void udrv_powersave_periph_use(UDRV_PS_PERIPH id)
+{
+    uint32_t status;
+
+    if (!(powersave_periph_suspended & (1UL << id)))
+        return;
+
+    status = powersave_critical_enter();
+    if (powersave_periph_suspended & (1UL << id)) {
+        powersave_periph[id].api->RESUME();
+        powersave_periph_suspended &= ~(1UL << id);
+    }
+    powersave_critical_exit(status);
+}
+
+int32_t udrv_powersave_register_periph(UDRV_PS_PERIPH id, struct udrv_powersave_periph_api const *api, bool lazy)
+{
+    uint32_t status;
+
+    if (id >= UDRV_PS_PERIPH_MAX || (api != NULL && (api->SUSPEND == NULL || api->RESUME == NULL)))
+        return -UDRV_WRONG_ARG;
+
+    //Bring the old one back before its hooks are dropped
+    udrv_powersave_periph_use(id);
+
+    status = powersave_critical_enter();
+    powersave_periph[id].api = api;
+    powersave_periph[id].lazy = lazy;
+    powersave_critical_exit(status);
+
+    return UDRV_RETURN_OK;
+}
+
 static void powersave_mcu_sleep_handler(void * p_context)
 {
+    udrv_powersave_wake_source(UDRV_PS_WAKE_SRC_TIMER);
     udrv_powersave_in_sleep = false;
 }
 
@@ -68,9 +229,122 @@ static void powersave_radio_sleep_handler(void * p_context)
 
 static void powersave_sleep_handler(void * p_context)
 {
+    udrv_powersave_wake_source(UDRV_PS_WAKE_SRC_TIMER);
     udrv_powersave_in_sleep = false;
 }
 
+static inline void powersave_refuse(UDRV_PS_REFUSE reason)
+{
+    powersave_stats.refuse_cnt[reason]++;
+}
+
+void udrv_powersave_wake_source(UDRV_PS_WAKE_SRC src)
+{
+    if (powersave_sleeping && powersave_wake_src == UDRV_PS_WAKE_SRC_MAX && src < UDRV_PS_WAKE_SRC_MAX)
+        powersave_wake_src = src;
+    if (powersave_idle_pending && powersave_idle_wake_src == UDRV_PS_WAKE_SRC_MAX && src < UDRV_PS_WAKE_SRC_MAX)
+        powersave_idle_wake_src = src;
+}
+
+//Count the wake-up source of the last idle sleep, OTHER if its handler reported none
+static void powersave_idle_settle(void)
+{
+    if (!powersave_idle_pending)
+        return;
+
+    powersave_stats.idle_wakeup_cnt[(powersave_idle_wake_src < UDRV_PS_WAKE_SRC_MAX) ? powersave_idle_wake_src : UDRV_PS_WAKE_SRC_OTHER]++;
+    powersave_idle_pending = false;
+}
+
+void udrv_powersave_idle_account(UDRV_PS_IDLE depth, uint32_t slept_us, bool expired)
+{
+    uint32_t status = powersave_critical_enter();
+
+    if (depth >= UDRV_PS_IDLE_MAX)
+        depth = UDRV_PS_IDLE_MAX - 1;
+
+    powersave_idle_settle();
+    powersave_stats.idle_residency_us[depth] += slept_us;
+    powersave_stats.idle_cnt[depth]++;
+
+    //No handler reports the tick compare, so a sleep it ended is counted right away
+    if (expired)
+    {
+        powersave_stats.idle_wakeup_cnt[UDRV_PS_WAKE_SRC_TIMER]++;
+    }
+    else
+    {
+        powersave_idle_wake_src = UDRV_PS_WAKE_SRC_MAX;
+        powersave_idle_pending = true;
+    }
+
+    powersave_critical_exit(status);
+}
+
+void udrv_powersave_set_latency(UDRV_PS_LATENCY who, uint32_t max_us)
+{
+    if (who < UDRV_PS_LATENCY_MAX)
+        powersave_latency[who] = max_us;
+}
+
+uint32_t udrv_powersave_get_latency(void)
+{
+    uint32_t latency = UDRV_PS_LATENCY_ANY;
+
+    for (int i = 0 ; i < UDRV_PS_LATENCY_MAX ; i++) {
+        if (powersave_latency[i] < latency)
+            latency = powersave_latency[i];
+    }
+    return latency;
+}
+
+void udrv_powersave_get_stats(udrv_powersave_stats_t *stats)
+{
+    uint32_t status;
+
+    if (stats == NULL)
+        return;
+
+    status = powersave_critical_enter();
+    powersave_idle_settle();
+    *stats = powersave_stats;
+    memcpy(stats->wlock_cnt, powersave_wlock_holder, sizeof(stats->wlock_cnt));
+    powersave_critical_exit(status);
+
+    stats->elapsed_ms = udrv_rtc_get_timestamp((RtcID_E)SYS_RTC_COUNTER_PORT) - powersave_stats_since;
+}
+
+void udrv_powersave_reset_stats(void)
+{
+    uint32_t status = powersave_critical_enter();
+
+    memset(&powersave_stats, 0, sizeof(powersave_stats));
+    powersave_idle_pending = false;
+    powersave_stats_since = udrv_rtc_get_timestamp((RtcID_E)SYS_RTC_COUNTER_PORT);
+
+    powersave_critical_exit(status);
+}
+
+const char *udrv_powersave_wake_source_name(UDRV_PS_WAKE_SRC src)
+{
+    return (src < UDRV_PS_WAKE_SRC_MAX) ? powersave_wake_src_name[src] : "";
+}
+
+const char *udrv_powersave_refuse_name(UDRV_PS_REFUSE reason)
+{
+    return (reason < UDRV_PS_REFUSE_MAX) ? powersave_refuse_name[reason] : "";
+}
+
+const char *udrv_powersave_wlock_name(UDRV_PS_WLOCK holder)
+{
+    return (holder < UDRV_PS_WLOCK_MAX) ? powersave_wlock_name[holder] : "";
+}
+
+const char *udrv_powersave_idle_name(UDRV_PS_IDLE depth)
+{
+    return (depth < UDRV_PS_IDLE_MAX) ? powersave_idle_name[depth] : "";
+}
+
 static void handle_sleep_callback() {
     for (int i = 0 ; i < UDRV_PS_MAX_CB_NUM ; i++) {
         if (udrv_ps_sleep_cb[i]) {
@@ -88,14 +362,20 @@ static void handle_wakeup_callback() {
 }
 
 static int32_t handle_mcu_sleep(bool all) {
+    uint64_t sleep_start, sleep_end;
+    uint32_t level;
+
     if ((udrv_rtc_get_timestamp((RtcID_E)SYS_RTC_COUNTER_PORT) - udrv_powersave_last_wakeup_time) < udrv_powersave_min_wakeup_time) {
+        powersave_refuse(UDRV_PS_REFUSE_MIN_WAKEUP);
         return -UDRV_BUSY;
     }
 
     if (fund_event_queue_space_get() != EVENT_QUEUE_SIZE) {
+        powersave_refuse(UDRV_PS_REFUSE_EVENT_PENDING);
         return -UDRV_BUSY;
     }
     uint32_t sleep_level = service_nvm_get_auto_sleep_level_from_nvm();
+    level = (sleep_level < UDRV_PS_LEVEL_MAX) ? sleep_level : (UDRV_PS_LEVEL_MAX - 1);
 #ifdef SUPPORT_MULTITASK
     sched_pending = true;
 #endif
@@ -107,45 +387,7 @@ static int32_t handle_mcu_sleep(bool all) {
 
     handle_sleep_callback();
 
-#ifdef rak11720
-    UBaseType_t uxSavedInterruptStatus;
-    if(isInISR())
-    {
-        uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
-    }
-    else
-    {
-        taskENTER_CRITICAL();
-    }
-#endif
-
-#ifdef SUPPORT_USB
-    uhal_usb_suspend();
-#endif
-
-#ifdef SUPPORT_SPI
-    udrv_spimst_suspend();
-#endif
-
-    udrv_adc_suspend();
-    udrv_pwm_suspend();
-    udrv_serial_suspend();
-    udrv_twimst_suspend();
-    udrv_gpio_suspend();
-
-    udrv_rtc_suspend();
-
-#ifdef rak11720
-    if(isInISR())
-    {
-        taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
-
-    }
-    else
-    {
-        taskEXIT_CRITICAL();
-    }
-#endif
+    udrv_powersave_periph_suspend_all();
 
 #if 1
     powersave_driver.SYS_CLOCK_OFF();
@@ -157,10 +399,21 @@ static int32_t handle_mcu_sleep(bool all) {
     }
 #endif
 
+    powersave_wake_src = UDRV_PS_WAKE_SRC_MAX;
+    powersave_sleeping = true;
+    sleep_start = udrv_rtc_get_timestamp((RtcID_E)SYS_RTC_COUNTER_PORT);
+
     while (udrv_powersave_in_sleep) {
         powersave_driver.MCU_SLEEP(sleep_level);
     }
 
+    sleep_end = udrv_rtc_get_timestamp((RtcID_E)SYS_RTC_COUNTER_PORT);
+    powersave_sleeping = false;
+
+    powersave_stats.residency_ms[level] += sleep_end - sleep_start;
+    powersave_stats.sleep_cnt[level]++;
+    powersave_stats.wakeup_cnt[(powersave_wake_src < UDRV_PS_WAKE_SRC_MAX) ? powersave_wake_src : UDRV_PS_WAKE_SRC_OTHER]++;
+
 #ifdef RAK5010_EVB
     if (all) {
         Gsm_PowerUp();
@@ -171,41 +424,7 @@ static int32_t handle_mcu_sleep(bool all) {
     powersave_driver.SYS_CLOCK_ON();
 #endif
 
-#ifdef rak11720
-    if(isInISR())
-    {
-        uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
-    }
-    else
-    {
-        taskENTER_CRITICAL();
-    }
-#endif
-
-    udrv_rtc_resume();
-    udrv_gpio_resume();
-#ifdef SUPPORT_SPI
-    udrv_spimst_resume();
-#endif
-    udrv_twimst_resume();
-    udrv_serial_resume();
-    udrv_pwm_resume();
-    udrv_adc_resume();
-#ifdef SUPPORT_USB
-    uhal_usb_resume();
-#endif
-
-#ifdef rak11720
-    if(isInISR())
-    {
-        taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
-
-    }
-    else
-    {
-        taskEXIT_CRITICAL();
-    }
-#endif
+    udrv_powersave_periph_resume_all();
 
     handle_wakeup_callback();
 
@@ -224,20 +443,39 @@ static int32_t handle_mcu_sleep(bool all) {
     return UDRV_RETURN_OK;
 }
 
-void udrv_powersave_wake_lock (void) {
+void udrv_powersave_wake_lock_by (UDRV_PS_WLOCK holder) {
+    if (holder >= UDRV_PS_WLOCK_MAX) {
+        holder = UDRV_PS_WLOCK_OTHER;
+    }
+    powersave_wlock_holder[holder]++;
     wlock_cnt++;
 }
 
-void udrv_powersave_wake_unlock (void) {
+void udrv_powersave_wake_unlock_by (UDRV_PS_WLOCK holder) {
+    if (holder >= UDRV_PS_WLOCK_MAX) {
+        holder = UDRV_PS_WLOCK_OTHER;
+    }
+    if (powersave_wlock_holder[holder] > 0) {
+        powersave_wlock_holder[holder]--;
+    }
     if (wlock_cnt > 0) {
         wlock_cnt--;
     }
 }
 
+void udrv_powersave_wake_lock (void) {
+    udrv_powersave_wake_lock_by(UDRV_PS_WLOCK_OTHER);
+}
+
+void udrv_powersave_wake_unlock (void) {
+    udrv_powersave_wake_unlock_by(UDRV_PS_WLOCK_OTHER);
+}
+
 
 int32_t udrv_mcu_sleep_ms (uint32_t ms_time)
 {
     if (wlock_cnt) {
+        powersave_refuse(UDRV_PS_REFUSE_WAKE_LOCK);
 #ifdef SUPPORT_WDT
         udrv_wdt_feed();
 #endif
@@ -245,10 +483,14 @@ int32_t udrv_mcu_sleep_ms (uint32_t ms_time)
     }
 
 #ifdef rak11720
-    if( rx_wait_active == true)
+    if( rx_wait_active == true) {
+        powersave_refuse(UDRV_PS_REFUSE_RX_WAIT);
         return -UDRV_BUSY;
-    if( is_mcu_resumed == true)
+    }
+    if( is_mcu_resumed == true) {
+        powersave_refuse(UDRV_PS_REFUSE_MCU_RESUMED);
         return -UDRV_BUSY;
+    }
 #endif
 
     udrv_powersave_in_deep_sleep = false;
@@ -266,6 +508,7 @@ int32_t udrv_mcu_sleep_ms (uint32_t ms_time)
 void udrv_radio_sleep_ms (uint32_t ms_time)
 {
     if (wlock_cnt) {
+        powersave_refuse(UDRV_PS_REFUSE_WAKE_LOCK);
 #ifdef SUPPORT_WDT
         udrv_wdt_feed();
 #endif
@@ -291,6 +534,7 @@ int32_t udrv_sleep_ms (uint32_t ms_time)
     int32_t ret;
 
     if (wlock_cnt) {
+        powersave_refuse(UDRV_PS_REFUSE_WAKE_LOCK);
 #ifdef SUPPORT_WDT
         udrv_wdt_feed();
 #endif
@@ -298,10 +542,14 @@ int32_t udrv_sleep_ms (uint32_t ms_time)
     }
 
 #ifdef rak11720
-    if( rx_wait_active == true)
+    if( rx_wait_active == true) {
+        powersave_refuse(UDRV_PS_REFUSE_RX_WAIT);
         return -UDRV_BUSY;
-    if( is_mcu_resumed == true)
+    }
+    if( is_mcu_resumed == true) {
+        powersave_refuse(UDRV_PS_REFUSE_MCU_RESUMED);
         return -UDRV_BUSY;
+    }
 #endif
 
 #if defined(SUPPORT_LORA) || defined(SUPPORT_LORA_P2P)
@@ -6,6 +6,7 @@ extern "C" {
 #endif
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <udrv_timer.h>
 
 typedef void (*POWER_SAVE_HANDLER) (void);
@@ -18,8 +19,96 @@ struct udrv_powersave_api {
     void (*SYS_CLOCK_OFF) (void);
 };
 
+/* Peripheral power registry, listed in suspend order: a peripheral is
+ * suspended before the ones it depends on (GPIO, RTC) and resumed after them. */
+typedef enum _UDRV_PS_PERIPH {
+    UDRV_PS_PERIPH_USB = 0,
+    UDRV_PS_PERIPH_SPI,
+    UDRV_PS_PERIPH_ADC,
+    UDRV_PS_PERIPH_PWM,
+    UDRV_PS_PERIPH_SERIAL,
+    UDRV_PS_PERIPH_TWI,
+    UDRV_PS_PERIPH_GPIO,
+    UDRV_PS_PERIPH_RTC,
+    UDRV_PS_PERIPH_MAX,
+} UDRV_PS_PERIPH;
+
+//The structure of the power hooks of a peripheral
+struct udrv_powersave_periph_api {
+    bool (*IS_ACTIVE) (void);   // NULL: always suspended
+    void (*SUSPEND) (void);
+    void (*RESUME) (void);
+};
+
+//What ended a sleep, the first source that fired wins
+typedef enum _UDRV_PS_WAKE_SRC {
+    UDRV_PS_WAKE_SRC_TIMER = 0, // sleep duration elapsed or a software timer
+    UDRV_PS_WAKE_SRC_RTC,       // RTC alarm
+    UDRV_PS_WAKE_SRC_GPIO,
+    UDRV_PS_WAKE_SRC_UART,
+    UDRV_PS_WAKE_SRC_BLE,
+    UDRV_PS_WAKE_SRC_RADIO,     // radio DIO interrupt
+    UDRV_PS_WAKE_SRC_OTHER,
+    UDRV_PS_WAKE_SRC_MAX,
+} UDRV_PS_WAKE_SRC;
+
+//Why a sleep request was turned down
+typedef enum _UDRV_PS_REFUSE {
+    UDRV_PS_REFUSE_WAKE_LOCK = 0,
+    UDRV_PS_REFUSE_RX_WAIT,         // UART still receiving
+    UDRV_PS_REFUSE_MCU_RESUMED,     // woken up by UART, waiting for the command
+    UDRV_PS_REFUSE_MIN_WAKEUP,      // minimum wake-up time not reached
+    UDRV_PS_REFUSE_EVENT_PENDING,   // system event queue not empty
+    UDRV_PS_REFUSE_MAX,
+} UDRV_PS_REFUSE;
+
+//Wake-lock holders, udrv_powersave_wake_lock() counts as UDRV_PS_WLOCK_OTHER
+typedef enum _UDRV_PS_WLOCK {
+    UDRV_PS_WLOCK_OTHER = 0,
+    UDRV_PS_WLOCK_LORA_P2P,
+    UDRV_PS_WLOCK_LORA_TEST,
+    UDRV_PS_WLOCK_PROTO,
+    UDRV_PS_WLOCK_MAX,
+} UDRV_PS_WLOCK;
+
+//Owners of a wake-up latency bound for the idle sleep
+typedef enum _UDRV_PS_LATENCY {
+    UDRV_PS_LATENCY_USER = 0,
+    UDRV_PS_LATENCY_ADC,            // ADC stream, its trigger timer runs from HFRC
+    UDRV_PS_LATENCY_SPI,            // queued SPI transfers, the IOM DMA runs from HFRC
+    UDRV_PS_LATENCY_TWI,            // queued I2C transfers, same
+    UDRV_PS_LATENCY_BLE,            // open connection, bounded by its interval
+    UDRV_PS_LATENCY_MAX,
+} UDRV_PS_LATENCY;
+
+#define UDRV_PS_LATENCY_ANY UINT32_MAX  // no bound
+
+#define UDRV_PS_LEVEL_MAX   3   // sleep levels as passed to MCU_SLEEP, higher ones are counted in the last
+
+//Sleep depths of the idle task, picked by the tickless idle policy
+typedef enum _UDRV_PS_IDLE {
+    UDRV_PS_IDLE_NORMAL = 0,        // clocks kept running
+    UDRV_PS_IDLE_DEEP,
+    UDRV_PS_IDLE_MAX,
+} UDRV_PS_IDLE;
+
+//Power accounting since boot or the last udrv_powersave_reset_stats()
+typedef struct udrv_powersave_stats {
+    uint64_t elapsed_ms;                            // time covered by the counters
+    uint64_t residency_ms[UDRV_PS_LEVEL_MAX];       // time spent asleep per level
+    uint32_t sleep_cnt[UDRV_PS_LEVEL_MAX];          // sleeps entered per level
+    uint32_t wakeup_cnt[UDRV_PS_WAKE_SRC_MAX];
+    uint64_t idle_residency_us[UDRV_PS_IDLE_MAX];   // time the idle task spent asleep per depth
+    uint32_t idle_cnt[UDRV_PS_IDLE_MAX];            // idle task sleeps per depth
+    uint32_t idle_wakeup_cnt[UDRV_PS_WAKE_SRC_MAX]; // what ended the idle task sleeps
+    uint32_t refuse_cnt[UDRV_PS_REFUSE_MAX];
+    uint32_t wlock_cnt[UDRV_PS_WLOCK_MAX];          // locks currently held
+} udrv_powersave_stats_t;
+
 void udrv_powersave_wake_lock (void);
 void udrv_powersave_wake_unlock (void);
+void udrv_powersave_wake_lock_by (UDRV_PS_WLOCK holder);
+void udrv_powersave_wake_unlock_by (UDRV_PS_WLOCK holder);
 int32_t udrv_mcu_sleep_ms (uint32_t ms_time);
 void udrv_radio_sleep_ms (uint32_t ms_time);
 int32_t udrv_sleep_ms (uint32_t ms_time);
@@ -32,6 +121,95 @@ int32_t udrv_register_wakeup_callback(POWER_SAVE_HANDLER handler);
 void udrv_deregister_wakeup_callback(POWER_SAVE_HANDLER handler);
 void udrv_set_min_wakeup_time(uint32_t ms_time);
 
+/**
+ * @brief       Register the power hooks of a peripheral, replacing the built-in ones.
+ * @retval      int32_t
+ * @param       UDRV_PS_PERIPH id: the peripheral
+ * @param       struct udrv_powersave_periph_api const *api: the hooks, NULL to leave the peripheral alone in sleep
+ * @param       bool lazy: resume on first use after wake-up instead of on wake-up
+ */
+int32_t udrv_powersave_register_periph(UDRV_PS_PERIPH id, struct udrv_powersave_periph_api const *api, bool lazy);
+
+/**
+ * @brief       Resume a lazily resumed peripheral if it is still suspended.
+ *              Drivers call this before touching the hardware.
+ * @retval      void
+ * @param       UDRV_PS_PERIPH id: the peripheral
+ */
+void udrv_powersave_periph_use(UDRV_PS_PERIPH id);
+
+/**
+ * @brief       Suspend the peripherals in use that are not suspended yet.
+ *              Whoever powers peripherals down around a sleep has to go through
+ *              here, so that udrv_powersave_periph_use() knows what is down.
+ * @retval      void
+ */
+void udrv_powersave_periph_suspend_all(void);
+
+/**
+ * @brief       Resume the suspended peripherals, the lazy ones are left for
+ *              udrv_powersave_periph_use().
+ * @retval      void
+ */
+void udrv_powersave_periph_resume_all(void);
+
+/**
+ * @brief       Record what woke the MCU up. Called by the wake-up interrupt
+ *              handlers; only the first source of a sleep is kept.
+ * @retval      void
+ * @param       UDRV_PS_WAKE_SRC src: the wake-up source
+ */
+void udrv_powersave_wake_source(UDRV_PS_WAKE_SRC src);
+
+/**
+ * @brief       Account a sleep of the idle task. Called by the tickless idle
+ *              policy right after the WFI with interrupts still masked, the
+ *              handler that runs next reports the wake-up source unless the
+ *              tick timer woke the MCU up.
+ * @retval      void
+ * @param       UDRV_PS_IDLE depth: the sleep depth
+ * @param       uint32_t slept_us: the time spent asleep
+ * @param       bool expired: the idle time ran out, the tick timer woke the MCU up
+ */
+void udrv_powersave_idle_account(UDRV_PS_IDLE depth, uint32_t slept_us, bool expired);
+
+/**
+ * @brief       Bound the wake-up latency of the idle sleep. The idle task picks
+ *              the deepest sleep whose wake-up latency stays within every bound.
+ * @retval      void
+ * @param       UDRV_PS_LATENCY who: the owner of the bound
+ * @param       uint32_t max_us: the tolerated latency in us, UDRV_PS_LATENCY_ANY to remove the bound
+ */
+void udrv_powersave_set_latency(UDRV_PS_LATENCY who, uint32_t max_us);
+
+/**
+ * @brief       Get the tightest wake-up latency bound
+ * @retval      uint32_t: the bound in us, UDRV_PS_LATENCY_ANY if none is set
+ */
+uint32_t udrv_powersave_get_latency(void);
+
+/**
+ * @brief       Get a snapshot of the power accounting counters
+ * @retval      void
+ * @param       udrv_powersave_stats_t *stats: filled with the counters
+ */
+void udrv_powersave_get_stats(udrv_powersave_stats_t *stats);
+
+/**
+ * @brief       Clear the power accounting counters, the held wake-locks are kept
+ * @retval      void
+ */
+void udrv_powersave_reset_stats(void);
+
+/**
+ * @brief       Get the printable name of a counter index
+ * @retval      const char *: the name, "" if the index is out of range
+ */
+const char *udrv_powersave_wake_source_name(UDRV_PS_WAKE_SRC src);
+const char *udrv_powersave_refuse_name(UDRV_PS_REFUSE reason);
+const char *udrv_powersave_wlock_name(UDRV_PS_WLOCK holder);
+const char *udrv_powersave_idle_name(UDRV_PS_IDLE depth);
+
 #ifdef __cplusplus
 }
 #endif
@@ -50,6 +50,7 @@ void udrv_pwm_deinit(udrv_pwm_port port);
  * Set the duty cycle for the PWM
  *
  * @param       port
+ * @return      -UDRV_BUSY if the pin's timer is taken by a running ADC stream
  *
  */
 int32_t udrv_pwm_set_duty(udrv_pwm_port port, uint32_t duty);
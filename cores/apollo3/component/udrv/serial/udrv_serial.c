@@ -24,6 +24,61 @@ static bool udrv_serial_usb_initialized = false;
 
 static struct udrv_serial_api *serial_api[SERIAL_MAX];
 
+#ifndef RUI_BOOTLOADER
+/* CLI output accumulator: echo and AT responses produced while a port is held
+ * are sent with a single driver write instead of one write per printf/char.
+ * Other tasks drain it too (SERIAL_CLI_OUT_SYNC), so the buffer is only
+ * touched inside a critical section and written out from a copy. */
+typedef struct {
+    bool     hold;
+    uint16_t len;
+    uint8_t  buf[SERIAL_CLI_OUT_SIZE];
+} serial_cli_out_t;
+
+static serial_cli_out_t serial_cli_out[SERIAL_MAX];
+
+static int32_t serial_cli_out_drain (SERIAL_PORT Port)
+{
+    serial_cli_out_t *out = &serial_cli_out[Port];
+    uint8_t buf[SERIAL_CLI_OUT_SIZE];
+    uint16_t len;
+    uint32_t mask;
+
+    udrv_system_critical_section_begin(&mask);
+    len = out->len;
+    memcpy(buf, out->buf, len);
+    out->len = 0;
+    udrv_system_critical_section_end(&mask);
+
+    if (len != 0 && serial_api[Port])
+        return serial_api[Port]->SERIAL_WRITE(Port, buf, len, udrv_serial_timeout);
+    return 0;
+}
+
+/* Append to the accumulator, false when it has no room */
+static bool serial_cli_out_append (SERIAL_PORT Port, uint8_t const *Buffer, int32_t NumberOfBytes)
+{
+    serial_cli_out_t *out = &serial_cli_out[Port];
+    bool room;
+    uint32_t mask;
+
+    udrv_system_critical_section_begin(&mask);
+    room = (out->len + NumberOfBytes <= SERIAL_CLI_OUT_SIZE);
+    if (room) {
+        memcpy(&out->buf[out->len], Buffer, NumberOfBytes);
+        out->len += NumberOfBytes;
+    }
+    udrv_system_critical_section_end(&mask);
+
+    return room;
+}
+
+/* Keep ordering when other writers share a port with pending CLI output. */
+#define SERIAL_CLI_OUT_SYNC(Port)   do { if (serial_cli_out[Port].len != 0) serial_cli_out_drain(Port); } while (0)
+#else
+#define SERIAL_CLI_OUT_SYNC(Port)
+#endif
+
 struct udrv_serial_api serial_uart_driver =
 {
   //uhal_uart_register_cli_handler,
@@ -237,6 +292,7 @@ int32_t udrv_serial_write (SERIAL_PORT Port, uint8_t const *Buffer, int32_t Numb
             return -UDRV_TEMP_LOCKED;
         }
 
+        SERIAL_CLI_OUT_SYNC(Port);
         if(serial_api[Port])
             return serial_api[Port]->SERIAL_WRITE(Port, Buffer, NumberOfBytes, udrv_serial_timeout);
         else
@@ -290,6 +346,7 @@ int32_t udrv_serial_printf (SERIAL_PORT Port, const char *fmt, ...)
             vsprintf (print_buf, fmt, aptr);
             va_end (aptr);
  
+            SERIAL_CLI_OUT_SYNC(Port);
             return serial_api[Port]->SERIAL_WRITE(Port, print_buf, strlen(print_buf), udrv_serial_timeout);
         } else {
             return -UDRV_NOT_INIT;
@@ -303,6 +360,8 @@ int32_t udrv_serial_printf (SERIAL_PORT Port, const char *fmt, ...)
 int32_t udrv_serial_log_printf (const char *fmt, ...)
 {
     int32_t ret = 0;
+    char print_buf[512];
+    int32_t len = -1;
 
     for (int i = 0 ; i < SERIAL_MAX ; i++) {
         if (service_nvm_get_mode_type_from_nvm((SERIAL_PORT)i) == SERVICE_MODE_TYPE_CLI) {
@@ -311,20 +370,64 @@ int32_t udrv_serial_log_printf (const char *fmt, ...)
             }
 
             if(serial_api[(SERIAL_PORT)i]) {
-                char print_buf[512];
-                va_list aptr;
+                //Format once, the same text goes to every CLI port.
+                if (len < 0) {
+                    va_list aptr;
  
-                va_start (aptr, fmt);
-                vsprintf (print_buf, fmt, aptr);
-                va_end (aptr);
+                    va_start (aptr, fmt);
+                    len = vsnprintf (print_buf, sizeof(print_buf), fmt, aptr);
+                    va_end (aptr);
+
+                    if (len < 0)
+                        len = 0;
+                    else if (len >= sizeof(print_buf))
+                        len = sizeof(print_buf) - 1;
+                }
 
-                ret = serial_api[(SERIAL_PORT)i]->SERIAL_WRITE((SERIAL_PORT)i, print_buf, strlen(print_buf), udrv_serial_timeout);
+                ret = udrv_serial_cli_write((SERIAL_PORT)i, (uint8_t const *)print_buf, len);
 	    }
         }
     }
 
     return ret;
 }
+
+void udrv_serial_cli_hold (SERIAL_PORT Port)
+{
+    if (Port < SERIAL_MAX)
+        serial_cli_out[Port].hold = true;
+}
+
+int32_t udrv_serial_cli_flush (SERIAL_PORT Port)
+{
+    if (Port >= SERIAL_MAX)
+        return -UDRV_WRONG_ARG;
+
+    serial_cli_out[Port].hold = false;
+    return serial_cli_out_drain(Port);
+}
+
+int32_t udrv_serial_cli_write (SERIAL_PORT Port, uint8_t const *Buffer, int32_t NumberOfBytes)
+{
+    serial_cli_out_t *out;
+
+    if (Port >= SERIAL_MAX || Buffer == NULL || NumberOfBytes < 0)
+        return -UDRV_WRONG_ARG;
+
+    out = &serial_cli_out[Port];
+    if (!out->hold || NumberOfBytes > SERIAL_CLI_OUT_SIZE) {
+        serial_cli_out_drain(Port);
+        if(serial_api[Port])
+            return serial_api[Port]->SERIAL_WRITE(Port, Buffer, NumberOfBytes, udrv_serial_timeout);
+        else
+            return -UDRV_NOT_INIT;
+    }
+
+    while (!serial_cli_out_append(Port, Buffer, NumberOfBytes))
+        serial_cli_out_drain(Port);
+
+    return NumberOfBytes;
+}
 #endif
 
 int32_t udrv_serial_read (SERIAL_PORT Port, uint8_t *Buffer, int32_t NumberOfBytes)
@@ -375,6 +478,7 @@ void udrv_serial_flush (SERIAL_PORT Port)
 {
     if(Port >= SERIAL_UART0 && Port <= SERIAL_UART2) {
         if(serial_api[Port]) {
+            SERIAL_CLI_OUT_SYNC(Port);
             serial_api[Port]->SERIAL_FLUSH(Port, udrv_serial_timeout);
         }
     }
@@ -47,6 +47,7 @@ typedef enum _SERIAL_EVENT{
 } SERIAL_EVENT;
 
 #define SERIAL_NO_TIMEOUT UINT32_MAX
+#define SERIAL_CLI_OUT_SIZE 256   /**< Per-port CLI output accumulator */
 
 typedef enum _SERIAL_WIRE_MODE_E {
     SERIAL_TWO_WIRE_NORMAL_MODE         = 0x0,
@@ -183,6 +184,36 @@ int32_t udrv_serial_printf (SERIAL_PORT Port, const char *fmt, ...);
  * @param       const char *fmt: 
  */
 int32_t udrv_serial_log_printf (const char *fmt, ...);
+
+/**
+ * @brief       This API is used to start collecting CLI output of a specified serial port.
+ *              Bytes written by udrv_serial_cli_write() are kept in a per-port buffer until
+ *              udrv_serial_cli_flush() is called or the buffer fills up.
+ * @retval      void
+ * @param       SERIAL_PORT Port: the specified serial port
+ */
+void udrv_serial_cli_hold (SERIAL_PORT Port);
+
+/**
+ * @brief       This API is used to send the collected CLI output of a specified serial port
+ *              in one write and to stop collecting.
+ * @retval      int32_t
+ * @return      the result of the driver write, 0 if nothing was pending
+ * @param       SERIAL_PORT Port: the specified serial port
+ */
+int32_t udrv_serial_cli_flush (SERIAL_PORT Port);
+
+/**
+ * @brief       This API is used to write CLI echo and response bytes to a specified serial port.
+ *              The bytes are collected while the port is held, otherwise they are sent at once.
+ *              The caller is responsible for the lock check.
+ * @retval      int32_t
+ * @return      number of bytes accepted
+ * @param       SERIAL_PORT Port: the specified serial port
+ * @param       uint8_t const *Buffer:
+ * @param       int32_t NumberOfBytes:
+ */
+int32_t udrv_serial_cli_write (SERIAL_PORT Port, uint8_t const *Buffer, int32_t NumberOfBytes);
 #endif
 
 /**
@@ -1,5 +1,6 @@
 #include "udrv_spimst.h"
 #include "udrv_errno.h"
+#include "udrv_powersave.h"
 #include "uhal_spimst.h"
 
 static struct udrv_spimst_api *spimst_api[UDRV_SPIMST_MAX];
@@ -11,11 +12,14 @@ struct udrv_spimst_api spimst_driver =
   uhal_spimst_setup_byte_order,
   uhal_spimst_deinit,
   uhal_spimst_trx,
+  uhal_spimst_submit,
   uhal_spimst_suspend,
   uhal_spimst_resume,
 };
 
 void udrv_spimst_init(udrv_spimst_port port) {
+    udrv_powersave_periph_use(UDRV_PS_PERIPH_SPI);
+
     if(port < UDRV_SPIMST_MAX) {
         if(spimst_api[port]) {
             spimst_api[port]->SPIMST_DEINIT(port);
@@ -28,6 +32,8 @@ void udrv_spimst_init(udrv_spimst_port port) {
 }
 
 void udrv_spimst_setup_mode(udrv_spimst_port port, ENUM_SPI_MST_CPHA_T CPHA, ENUM_SPI_MST_CPOL_T CPOL) {
+    udrv_powersave_periph_use(UDRV_PS_PERIPH_SPI);
+
     if(port < UDRV_SPIMST_MAX) {
         if(!spimst_api[port]) {
             spimst_api[port] = &spimst_driver;
@@ -39,6 +45,8 @@ void udrv_spimst_setup_mode(udrv_spimst_port port, ENUM_SPI_MST_CPHA_T CPHA, ENU
 }
 
 void udrv_spimst_setup_freq(udrv_spimst_port port, uint32_t clk_Hz) {
+    udrv_powersave_periph_use(UDRV_PS_PERIPH_SPI);
+
     if(port < UDRV_SPIMST_MAX) {
         if(!spimst_api[port]) {
             spimst_api[port] = &spimst_driver;
@@ -50,6 +58,8 @@ void udrv_spimst_setup_freq(udrv_spimst_port port, uint32_t clk_Hz) {
 }
 
 void udrv_spimst_setup_byte_order(udrv_spimst_port port, bool msb_first) {
+    udrv_powersave_periph_use(UDRV_PS_PERIPH_SPI);
+
     if(port < UDRV_SPIMST_MAX) {
         if(!spimst_api[port]) {
             spimst_api[port] = &spimst_driver;
@@ -60,6 +70,8 @@ void udrv_spimst_setup_byte_order(udrv_spimst_port port, bool msb_first) {
 }
 
 void udrv_spimst_deinit(udrv_spimst_port port) {
+    udrv_powersave_periph_use(UDRV_PS_PERIPH_SPI);
+
     if(port < UDRV_SPIMST_MAX) {
         if(spimst_api[port]) {
             spimst_api[port]->SPIMST_DEINIT(port);
@@ -70,9 +82,11 @@ void udrv_spimst_deinit(udrv_spimst_port port) {
 }
 
 int8_t udrv_spimst_trx(udrv_spimst_port port, uint8_t *write_data, uint32_t write_length, uint8_t *read_data, uint32_t read_length, uint32_t csn) {
+    udrv_powersave_periph_use(UDRV_PS_PERIPH_SPI);
+
     if(port < UDRV_SPIMST_MAX) {
         if(spimst_api[port]) {
-            spimst_api[port]->SPIMST_TRX(port, write_data, write_length, read_data, read_length, csn);
+            return spimst_api[port]->SPIMST_TRX(port, write_data, write_length, read_data, read_length, csn);
 	} else {
             return -UDRV_NOT_INIT;
 	}
@@ -81,6 +95,20 @@ int8_t udrv_spimst_trx(udrv_spimst_port port, uint8_t *write_data, uint32_t writ
     }
 }
 
+int32_t udrv_spimst_submit(udrv_spimst_port port, udrv_spimst_xfer_t *xfer, uint32_t count, UDRV_SPIMST_XFER_HANDLER handler, void *p_context) {
+    udrv_powersave_periph_use(UDRV_PS_PERIPH_SPI);
+
+    if(port < UDRV_SPIMST_MAX) {
+        if(spimst_api[port]) {
+            return spimst_api[port]->SPIMST_SUBMIT(port, xfer, count, handler, p_context);
+        } else {
+            return -UDRV_NOT_INIT;
+        }
+    } else {
+        return -UDRV_WRONG_ARG;
+    }
+}
+
 void udrv_spimst_suspend(void) {
     uhal_spimst_suspend();
     return;
@@ -35,6 +35,28 @@ typedef enum {
     SPI_MST_CPOL_1          = 1
 } ENUM_SPI_MST_CPOL_T;
 
+#define UDRV_SPIMST_XFER_KEEP_CS    0x01    //Leave CS asserted after this descriptor
+
+/**
+ * One step of a queued SPI transaction.
+ * The write part is clocked out first, then the read part, both with CS held low.
+ */
+typedef struct {
+    uint8_t     *write_data;
+    uint32_t    write_length;
+    uint8_t     *read_data;
+    uint32_t    read_length;
+    uint32_t    csn;            //Chip select pin
+    uint32_t    flags;          //UDRV_SPIMST_XFER_*
+} udrv_spimst_xfer_t;
+
+/**
+ * Completion of a descriptor list, called from interrupt context, or from
+ * udrv_spimst_submit() itself when the IOM refuses the first transaction.
+ * status is UDRV_RETURN_OK or a negative udrv error code.
+ */
+typedef void (*UDRV_SPIMST_XFER_HANDLER) (udrv_spimst_port port, int32_t status, void *p_context);
+
 //The structure of SPI master function 
 struct udrv_spimst_api {
     void (*SPIMST_INIT) (udrv_spimst_port port);
@@ -43,6 +65,7 @@ struct udrv_spimst_api {
     void (*SPIMST_SETUP_BYTE_ORDER) (udrv_spimst_port port, bool msb_first);
     void (*SPIMST_DEINIT) (udrv_spimst_port port);
     int8_t (*SPIMST_TRX) (udrv_spimst_port port, uint8_t *write_data, uint32_t write_length, uint8_t *read_data, uint32_t read_length, uint32_t csn);
+    int32_t (*SPIMST_SUBMIT) (udrv_spimst_port port, udrv_spimst_xfer_t *xfer, uint32_t count, UDRV_SPIMST_XFER_HANDLER handler, void *p_context);
     void (*SPIMST_SUSPEND) (void);
     void (*SPIMST_RESUME) (void);
 };
@@ -109,6 +132,22 @@ void udrv_spimst_deinit(udrv_spimst_port port);
  */
 int8_t udrv_spimst_trx(udrv_spimst_port port, uint8_t *write_data, uint32_t write_length, uint8_t *read_data, uint32_t read_length, uint32_t csn);
 
+/**
+ * Queue a list of descriptors and return immediately.
+ * Lists run in submission order, each descriptor with its own CS. The
+ * descriptors and buffers must stay valid until the handler is called.
+ *
+ * @param   port            the specified serial port
+ * @param   xfer            Array of descriptors.
+ * @param   count           Number of descriptors.
+ * @param   handler         Called when the list completed or failed, may be NULL.
+ * @param   p_context       Passed to the handler.
+ *
+ * @return  UDRV_RETURN_OK  The list is queued.
+ * @return  -UDRV_BUSY      The queue is full.
+ */
+int32_t udrv_spimst_submit(udrv_spimst_port port, udrv_spimst_xfer_t *xfer, uint32_t count, UDRV_SPIMST_XFER_HANDLER handler, void *p_context);
+
 /**
  * @brief   Suspend SPI master hardware before entering sleep mode.
  *
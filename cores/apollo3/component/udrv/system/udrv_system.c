@@ -4,6 +4,7 @@
 #ifndef RUI_BOOTLOADER
 #include "uhal_timer.h"
 #include "fund_event_queue.h"
+#include "udrv_serial.h"
 #endif
 #ifdef SUPPORT_MULTITASK
 #include "uhal_sched.h"
@@ -34,6 +35,13 @@ void udrv_system_event_consume(void)
 
 void udrv_system_reboot(void)
 {
+#ifndef RUI_BOOTLOADER
+    // Send the CLI output still held, e.g. the OK of the command rebooting.
+    for (int i = 0 ; i < SERIAL_MAX ; i++) {
+        udrv_serial_cli_flush((SERIAL_PORT)i);
+        udrv_serial_flush((SERIAL_PORT)i);
+    }
+#endif
     return uhal_sys_reboot();
 }
 
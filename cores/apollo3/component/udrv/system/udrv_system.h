@@ -41,6 +41,7 @@ typedef enum
     UDRV_SYS_EVT_OP_SERIAL_FALLBACK,                   //serial fallback to AT mode 
     UDRV_SYS_EVT_OP_RTC,                               //RTC
     UDRV_SYS_EVT_OP_GPIO_INTERRUPT,                    //Interrupt from GPIO
+    UDRV_SYS_EVT_OP_ADC_BLOCK,                         //ADC stream block ready
 } udrv_system_event_op_t;
 
 typedef struct
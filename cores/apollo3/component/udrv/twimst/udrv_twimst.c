@@ -1,5 +1,6 @@
 #include "udrv_twimst.h"
 #include "udrv_errno.h"
+#include "udrv_powersave.h"
 #include "uhal_twimst.h"
 
 static struct udrv_twimst_api *twimst_api[UDRV_TWIMST_MAX];
@@ -10,11 +11,15 @@ struct udrv_twimst_api twimst_driver =
   uhal_twimst_setup_freq,
   uhal_twimst_write,
   uhal_twimst_read,
+  uhal_twimst_write_read,
+  uhal_twimst_submit,
   uhal_twimst_suspend,
   uhal_twimst_resume,
 };
 
 void udrv_twimst_init (udrv_twimst_port port) {
+    udrv_powersave_periph_use(UDRV_PS_PERIPH_TWI);
+
     if(port < UDRV_TWIMST_MAX) {
         if(twimst_api[port]) {
             twimst_api[port]->TWIMST_DEINIT(port);
@@ -27,6 +32,8 @@ void udrv_twimst_init (udrv_twimst_port port) {
 }
 
 void udrv_twimst_deinit (udrv_twimst_port port) {
+    udrv_powersave_periph_use(UDRV_PS_PERIPH_TWI);
+
     if(port < UDRV_TWIMST_MAX) {
 	if(twimst_api[port]) {
             twimst_api[port]->TWIMST_DEINIT(port);
@@ -36,6 +43,8 @@ void udrv_twimst_deinit (udrv_twimst_port port) {
 }
 
 void udrv_twimst_setup_freq (udrv_twimst_port port, uint32_t clk_Hz) {
+    udrv_powersave_periph_use(UDRV_PS_PERIPH_TWI);
+
     if(port < UDRV_TWIMST_MAX) {
         if(!twimst_api[port]) {
             twimst_api[port] = &twimst_driver;
@@ -46,6 +55,8 @@ void udrv_twimst_setup_freq (udrv_twimst_port port, uint32_t clk_Hz) {
 }
 
 int32_t udrv_twimst_write (udrv_twimst_port port, uint8_t address, uint8_t *data, uint16_t length, bool send_stop) {
+    udrv_powersave_periph_use(UDRV_PS_PERIPH_TWI);
+
     if(port < UDRV_TWIMST_MAX) {
         if(twimst_api[port]) 
 	    return twimst_api[port]->TWIMST_WRITE(port, address, data, length, send_stop);
@@ -57,6 +68,8 @@ int32_t udrv_twimst_write (udrv_twimst_port port, uint8_t address, uint8_t *data
 }
 
 int32_t udrv_twimst_read (udrv_twimst_port port, uint8_t address, uint8_t *data, uint16_t length) {
+    udrv_powersave_periph_use(UDRV_PS_PERIPH_TWI);
+
     if(port < UDRV_TWIMST_MAX) {
         if(twimst_api[port])
 	    return twimst_api[port]->TWIMST_READ(port, address, data, length);
@@ -67,6 +80,32 @@ int32_t udrv_twimst_read (udrv_twimst_port port, uint8_t address, uint8_t *data,
     }
 }
 
+int32_t udrv_twimst_write_read (udrv_twimst_port port, uint8_t address, uint8_t *write_data, uint16_t write_length, uint8_t *read_data, uint16_t read_length) {
+    udrv_powersave_periph_use(UDRV_PS_PERIPH_TWI);
+
+    if(port < UDRV_TWIMST_MAX) {
+        if(twimst_api[port])
+	    return twimst_api[port]->TWIMST_WRITE_READ(port, address, write_data, write_length, read_data, read_length);
+	else
+	    return -UDRV_NOT_INIT;
+    } else {
+        return -UDRV_WRONG_ARG;
+    }
+}
+
+int32_t udrv_twimst_submit (udrv_twimst_port port, udrv_twimst_xfer_t *xfer, UDRV_TWIMST_XFER_HANDLER handler, void *p_context) {
+    udrv_powersave_periph_use(UDRV_PS_PERIPH_TWI);
+
+    if(port < UDRV_TWIMST_MAX) {
+        if(twimst_api[port])
+	    return twimst_api[port]->TWIMST_SUBMIT(port, xfer, handler, p_context);
+	else
+	    return -UDRV_NOT_INIT;
+    } else {
+        return -UDRV_WRONG_ARG;
+    }
+}
+
 void udrv_twimst_suspend (void) {
     twimst_driver.TWIMST_SUSPEND();
     return;
@@ -25,12 +25,35 @@ typedef enum {
     UDRV_TWIMST_MAX = 0x4,
 } udrv_twimst_port;
 
+#define UDRV_TWIMST_XFER_NO_STOP    0x01    //Write only: end without stop condition
+
+/*
+ * One I2C transaction: the write part, then a repeated start and the read
+ * part. Either part may be empty; each is limited to 255 bytes.
+ */
+typedef struct {
+    uint8_t     address;        //7bit i2c device address
+    uint8_t     *write_data;
+    uint16_t    write_length;
+    uint8_t     *read_data;
+    uint16_t    read_length;
+    uint8_t     flags;          //UDRV_TWIMST_XFER_*
+} udrv_twimst_xfer_t;
+
+/*
+ * Completion of a queued transaction, called from interrupt context.
+ * status is UDRV_RETURN_OK or a negative udrv error code.
+ */
+typedef void (*UDRV_TWIMST_XFER_HANDLER) (udrv_twimst_port port, udrv_twimst_xfer_t *xfer, int32_t status, void *p_context);
+
 struct udrv_twimst_api {
     void (*TWIMST_INIT) (udrv_twimst_port port);
     void (*TWIMST_DEINIT) (udrv_twimst_port port);
     void (*TWIMST_SETUP_FREQ) (udrv_twimst_port port, uint32_t clk_HZ);
     int32_t (*TWIMST_WRITE) (udrv_twimst_port port, uint8_t address, uint8_t *data, uint16_t len, bool send_stop);
     int32_t (*TWIMST_READ) (udrv_twimst_port port, uint8_t address, uint8_t *data, uint16_t len);
+    int32_t (*TWIMST_WRITE_READ) (udrv_twimst_port port, uint8_t address, uint8_t *write_data, uint16_t write_len, uint8_t *read_data, uint16_t read_len);
+    int32_t (*TWIMST_SUBMIT) (udrv_twimst_port port, udrv_twimst_xfer_t *xfer, UDRV_TWIMST_XFER_HANDLER handler, void *p_context);
     uint8_t (*TWIMST_SUSPEND) (void);
     uint8_t (*TWIMST_RESUME) (void);
 
@@ -62,6 +85,31 @@ int32_t udrv_twimst_write (udrv_twimst_port port, uint8_t address, uint8_t *data
  */
 int32_t udrv_twimst_read (udrv_twimst_port port, uint8_t address, uint8_t *data, uint16_t length);
 
+/*
+ * Function udrv_twimst_write_read
+ * @brief     write a series of bytes, then read with a repeated start,
+ *            typically a register address followed by its content
+ * @param     address: 7bit i2c device address
+ * @param     write_data: pointer to bytes to write
+ * @param     write_length: number of bytes to write
+ * @param     read_data: pointer to byte array
+ * @param     read_length: number of bytes to read into array
+ * Output     error code
+ */
+int32_t udrv_twimst_write_read (udrv_twimst_port port, uint8_t address, uint8_t *write_data, uint16_t write_length, uint8_t *read_data, uint16_t read_length);
+
+/*
+ * Function udrv_twimst_submit
+ * @brief     queue a transaction and return immediately; transactions run
+ *            in submission order. xfer and its buffers must stay valid
+ *            until the handler is called.
+ * @param     xfer: transaction
+ * @param     handler: completion callback, may be NULL
+ * @param     p_context: passed to the handler
+ * Output     UDRV_RETURN_OK, -UDRV_BUSY if the queue is full
+ */
+int32_t udrv_twimst_submit (udrv_twimst_port port, udrv_twimst_xfer_t *xfer, UDRV_TWIMST_XFER_HANDLER handler, void *p_context);
+
 void udrv_twimst_suspend (void);
 void udrv_twimst_resume (void);
 
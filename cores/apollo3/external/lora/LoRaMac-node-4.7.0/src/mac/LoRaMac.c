@@ -3517,6 +3517,7 @@ LoRaMacStatus_t RestoreNvmData( LoRaMacNvmData_t* nvm )
     {
         memcpy1( ( uint8_t* ) &Nvm.MacGroup2, ( uint8_t* ) &nvm->MacGroup2,
                  sizeof( Nvm.MacGroup2 ) );
+        LoRaMacClassBResetSlotCache( );
 
         // Initialize RxC config parameters.
         MacCtx.RxWindowCConfig.Channel = MacCtx.Channel;
@@ -5147,6 +5148,7 @@ LoRaMacStatus_t LoRaMacMcChannelSetup( McChannelParams_t *channel )
     }
 
     Nvm.MacGroup2.MulticastChannelList[channel->GroupID].ChannelParams = *channel;
+    LoRaMacClassBResetSlotCache( );
     MacCtx.MacFlags.Bits.NvmHandle = 1;
 
     if( channel->IsRemotelySetup == true )
@@ -5200,6 +5202,7 @@ LoRaMacStatus_t LoRaMacMcChannelDelete( AddressIdentifier_t groupID )
     memset1( ( uint8_t* )&channel, 0, sizeof( McChannelParams_t ) );
 
     Nvm.MacGroup2.MulticastChannelList[groupID].ChannelParams = channel;
+    LoRaMacClassBResetSlotCache( );
     MacCtx.MacFlags.Bits.NvmHandle = 1;
     return LORAMAC_STATUS_OK;
 }
@@ -5272,6 +5275,7 @@ LoRaMacStatus_t LoRaMacMcChannelSetupRxParams( AddressIdentifier_t groupID, McRx
     {
         // Apply parameters
         Nvm.MacGroup2.MulticastChannelList[groupID].ChannelParams.RxParams = *rxParams;
+        LoRaMacClassBResetSlotCache( );
         MacCtx.MacFlags.Bits.NvmHandle = 1;
     }
     else
@@ -115,6 +115,90 @@ static const uint8_t BeaconPrecTimeValue[4] = { 0, 1, 1, 1 };
  */
 static LoRaMacClassBNvmData_t* ClassBNvm;
 
+/*!
+ * Ping slot parameters of one address for the current beacon period
+ */
+typedef struct sClassBSlotCache
+{
+    /*!
+    * Set to true, if the entry is in use
+    */
+    bool Used;
+    /*!
+    * Beacon time the entry was computed for
+    */
+    uint32_t BeaconTime;
+    /*!
+    * Unicast or multicast address
+    */
+    uint32_t Address;
+    /*!
+    * Ping period the offset was computed for
+    */
+    uint16_t PingPeriod;
+    /*!
+    * Pseudo random ping offset
+    */
+    uint16_t PingOffset;
+    /*!
+    * Set to true, if PingOffset is valid
+    */
+    bool OffsetValid;
+    /*!
+    * Floor plan downlink frequency, 0 if not computed yet
+    */
+    uint32_t Frequency;
+}ClassBSlotCache_t;
+
+/*!
+ * The ping offset and the downlink channel only change with the beacon time.
+ * Keep them for the unicast address and every multicast group, so the AES
+ * and the region lookups run once per beacon period instead of once per slot.
+ */
+static ClassBSlotCache_t SlotCache[LORAMAC_MAX_MC_CTX + 1];
+
+/*!
+ * \brief Returns the cache entry of an address, reset if the beacon time changed
+ *
+ * \param [IN] beaconTime The beacon time of the current period
+ * \param [IN] address The unicast or multicast address
+ *
+ * \retval Cache entry
+ */
+static ClassBSlotCache_t* GetSlotCacheEntry( uint32_t beaconTime, uint32_t address )
+{
+    ClassBSlotCache_t* entry = NULL;
+
+    for( uint8_t i = 0; i < ( LORAMAC_MAX_MC_CTX + 1 ); i++ )
+    {
+        if( ( SlotCache[i].Used == true ) && ( SlotCache[i].Address == address ) )
+        {
+            entry = &SlotCache[i];
+            break;
+        }
+        if( ( entry == NULL ) &&
+            ( ( SlotCache[i].Used == false ) || ( SlotCache[i].BeaconTime != beaconTime ) ) )
+        {
+            // First free or outdated entry
+            entry = &SlotCache[i];
+        }
+    }
+
+    if( entry == NULL )
+    {
+        entry = &SlotCache[0];
+    }
+
+    if( ( entry->Used == false ) || ( entry->Address != address ) || ( entry->BeaconTime != beaconTime ) )
+    {
+        memset1( ( uint8_t* ) entry, 0, sizeof( ClassBSlotCache_t ) );
+        entry->Used = true;
+        entry->Address = address;
+        entry->BeaconTime = beaconTime;
+    }
+    return entry;
+}
+
 /*!
  * Computes the Ping Offset
  *
@@ -132,6 +216,13 @@ static void ComputePingOffset( uint64_t beaconTime, uint32_t address, uint16_t p
      * GPS time in seconds modulo 2^32
      */
     uint32_t time = ( beaconTime % ( ( ( uint64_t ) 1 ) << 32 ) );
+    ClassBSlotCache_t* entry = GetSlotCacheEntry( time, address );
+
+    if( ( entry->OffsetValid == true ) && ( entry->PingPeriod == pingPeriod ) )
+    {
+        *pingOffset = entry->PingOffset;
+        return;
+    }
 
     memset1( buffer, 0, 16 );
     memset1( cipher, 0, 16 );
@@ -151,6 +242,10 @@ static void ComputePingOffset( uint64_t beaconTime, uint32_t address, uint16_t p
     result = ( ( ( uint32_t ) cipher[0] ) + ( ( ( uint32_t ) cipher[1] ) * 256 ) );
 
     *pingOffset = ( uint16_t )( result % pingPeriod );
+
+    entry->PingPeriod = pingPeriod;
+    entry->PingOffset = *pingOffset;
+    entry->OffsetValid = true;
 }
 
 /*!
@@ -203,6 +298,16 @@ static uint32_t CalcDownlinkChannelAndFrequency( uint32_t devAddr, TimerTime_t b
     uint32_t channel = 0;
     uint8_t nbChannels = 0;
     uint8_t offset = 0;
+    ClassBSlotCache_t* entry = NULL;
+
+    if( isBeacon == false )
+    {
+        entry = GetSlotCacheEntry( beaconTime, devAddr );
+        if( entry->Frequency != 0 )
+        {
+            return entry->Frequency;
+        }
+    }
 
     // Default initialization - ping slot channels
     getPhy.Attribute = PHY_PING_SLOT_NB_CHANNELS;
@@ -231,6 +336,11 @@ static uint32_t CalcDownlinkChannelAndFrequency( uint32_t devAddr, TimerTime_t b
 
     // Calculate the frequency for the next downlink. This holds
     // for beacons and ping slots.
+    if( entry != NULL )
+    {
+        entry->Frequency = CalcDownlinkFrequency( channel, isBeacon );
+        return entry->Frequency;
+    }
     return CalcDownlinkFrequency( channel, isBeacon );
 }
 
@@ -433,6 +543,7 @@ static void InitClassB( void )
     memset1( ( uint8_t* ) ClassBNvm, 0, sizeof( LoRaMacClassBNvmData_t ) );
     memset1( ( uint8_t* ) &Ctx.PingSlotCtx, 0, sizeof( PingSlotContext_t ) );
     memset1( ( uint8_t* ) &Ctx.BeaconCtx, 0, sizeof( BeaconContext_t ) );
+    memset1( ( uint8_t* ) SlotCache, 0, sizeof( SlotCache ) );
 
     // Setup default temperature
     Ctx.BeaconCtx.Temperature = 25.0;
@@ -1810,6 +1921,13 @@ void LoRaMacClassBSetMulticastPeriodicity( MulticastCtx_t* multicastChannel )
 #endif // LORAMAC_CLASSB_ENABLED
 }
 
+void LoRaMacClassBResetSlotCache( void )
+{
+#ifdef LORAMAC_CLASSB_ENABLED
+    memset1( ( uint8_t* ) SlotCache, 0, sizeof( SlotCache ) );
+#endif // LORAMAC_CLASSB_ENABLED
+}
+
 void LoRaMacClassBSetFPendingBit( uint32_t address, uint8_t fPendingSet )
 {
 #ifdef LORAMAC_CLASSB_ENABLED
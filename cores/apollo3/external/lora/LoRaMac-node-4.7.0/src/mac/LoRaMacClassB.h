@@ -522,6 +522,13 @@ void LoRaMacClassBStartRxSlots( void );
  */
 void LoRaMacClassBSetMulticastPeriodicity( MulticastCtx_t* multicastChannel );
 
+/*!
+ * \brief Drops the ping offsets and slot frequencies cached for the current
+ *        beacon period. Call it whenever multicast channel parameters are
+ *        set or cleared, as the cache only tracks beacon time and address.
+ */
+void LoRaMacClassBResetSlotCache( void );
+
 /*!
  * \brief Sets the FPending bit status of the related downlink slot
  *
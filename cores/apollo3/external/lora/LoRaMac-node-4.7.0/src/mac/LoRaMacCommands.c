@@ -63,6 +63,14 @@ typedef struct sLoRaMacCommandsCtx
      * Buffer to store MAC command elements
      */
     MacCommand_t MacCommandSlots[NUM_OF_MAC_COMMANDS];
+    /*
+     * Stack of free slot indexes
+     */
+    uint8_t FreeSlots[NUM_OF_MAC_COMMANDS];
+    /*
+     * Number of free slots
+     */
+    uint8_t NbFreeSlots;
     /*
      * Size of all MAC commands serialized as buffer
      */
@@ -76,26 +84,6 @@ static LoRaMacCommandsCtx_t CommandsCtx;
 
 /* Memory management functions */
 
-/*!
- * \brief Determines if a MAC command slot is free
- *
- * \param[IN]     slot           - Slot to check
- * \retval                       - Status of the operation
- */
-static bool IsSlotFree( const MacCommand_t* slot )
-{
-    uint8_t* mem = ( uint8_t* )slot;
-
-    for( uint16_t size = 0; size < sizeof( MacCommand_t ); size++ )
-    {
-        if( mem[size] != 0x00 )
-        {
-            return false;
-        }
-    }
-    return true;
-}
-
 /*!
  * \brief Allocates a new MAC command memory slot
  *
@@ -103,18 +91,13 @@ static bool IsSlotFree( const MacCommand_t* slot )
  */
 static MacCommand_t* MallocNewMacCommandSlot( void )
 {
-    uint8_t itr = 0;
-
-    while( IsSlotFree( ( const MacCommand_t* )&CommandsCtx.MacCommandSlots[itr] ) == false )
+    if( CommandsCtx.NbFreeSlots == 0 )
     {
-        itr++;
-        if( itr == NUM_OF_MAC_COMMANDS )
-        {
-            return NULL;
-        }
+        return NULL;
     }
 
-    return &CommandsCtx.MacCommandSlots[itr];
+    CommandsCtx.NbFreeSlots--;
+    return &CommandsCtx.MacCommandSlots[CommandsCtx.FreeSlots[CommandsCtx.NbFreeSlots]];
 }
 
 /*!
@@ -126,12 +109,13 @@ static MacCommand_t* MallocNewMacCommandSlot( void )
  */
 static bool FreeMacCommandSlot( MacCommand_t* slot )
 {
-    if( slot == NULL )
+    if( ( slot < CommandsCtx.MacCommandSlots ) || ( slot >= &CommandsCtx.MacCommandSlots[NUM_OF_MAC_COMMANDS] ) )
     {
         return false;
     }
 
     memset1( ( uint8_t* )slot, 0x00, sizeof( MacCommand_t ) );
+    CommandsCtx.FreeSlots[CommandsCtx.NbFreeSlots++] = slot - CommandsCtx.MacCommandSlots;
 
     return true;
 }
@@ -183,8 +167,9 @@ static bool LinkedListAdd( MacCommandsList_t* list, MacCommand_t* element )
         list->Last->Next = element;
     }
 
-    // Update the next point of this entry.
+    // Update the next and previous points of this entry.
     element->Next = NULL;
+    element->Prev = list->Last;
 
     // Update the last entry of the list.
     list->Last = element;
@@ -192,42 +177,6 @@ static bool LinkedListAdd( MacCommandsList_t* list, MacCommand_t* element )
     return true;
 }
 
-/*!
- * \brief Return the previous element in the list.
- *
- * \param[IN]     list           - List
- * \param[IN]     element        - Element where the previous element shall be searched
- * \retval                       - Status of the operation
- */
-static MacCommand_t* LinkedListGetPrevious( MacCommandsList_t* list, MacCommand_t* element )
-{
-    if( ( list == NULL ) || ( element == NULL ) )
-    {
-        return NULL;
-    }
-
-    MacCommand_t* curElement;
-
-    // Start at the head of the list
-    curElement = list->First;
-
-    // When current element is the first of the list, there's no previous element so we can return NULL immediately.
-    if( element != curElement )
-    {
-        // Loop through all elements until the end is reached or the next of current is the current element.
-        while( ( curElement != NULL ) && ( curElement->Next != element ) )
-        {
-            curElement = curElement->Next;
-        }
-    }
-    else
-    {
-        curElement = NULL;
-    }
-
-    return curElement;
-}
-
 /*!
  * \brief Remove an element from the list
  *
@@ -242,7 +191,13 @@ static bool LinkedListRemove( MacCommandsList_t* list, MacCommand_t* element )
         return false;
     }
 
-    MacCommand_t* PrevElement = LinkedListGetPrevious( list, element );
+    MacCommand_t* PrevElement = element->Prev;
+
+    // Only the head has no previous element, anything else is not linked
+    if( ( PrevElement == NULL ) && ( list->First != element ) )
+    {
+        return false;
+    }
 
     if( list->First == element )
     {
@@ -259,7 +214,13 @@ static bool LinkedListRemove( MacCommandsList_t* list, MacCommand_t* element )
         PrevElement->Next = element->Next;
     }
 
+    if( element->Next != NULL )
+    {
+        element->Next->Prev = PrevElement;
+    }
+
     element->Next = NULL;
+    element->Prev = NULL;
 
     return true;
 }
@@ -316,6 +277,13 @@ LoRaMacCommandStatus_t LoRaMacCommandsInit( void )
 
     LinkedListInit( &CommandsCtx.MacCommandList );
 
+    // All slots are free, hand out the lowest index first
+    for( uint8_t i = 0; i < NUM_OF_MAC_COMMANDS; i++ )
+    {
+        CommandsCtx.FreeSlots[i] = NUM_OF_MAC_COMMANDS - 1 - i;
+    }
+    CommandsCtx.NbFreeSlots = NUM_OF_MAC_COMMANDS;
+
     return LORAMAC_COMMANDS_SUCCESS;
 }
 
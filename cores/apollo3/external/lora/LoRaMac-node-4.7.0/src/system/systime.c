@@ -23,53 +23,59 @@
  * \author    MCD Application Team ( STMicroelectronics International )
  */
 #include <stdio.h>
+#include "utilities.h"
 #include "rtc-board.h"
 #include "systime.h"
 
-#define END_OF_FEBRUARY_LEAP                         60 //31+29
-#define END_OF_JULY_LEAP                            213 //31+29+...
-
-#define END_OF_FEBRUARY_NORM                         59 //31+28
-#define END_OF_JULY_NORM                            212 //31+28+...
-
-#define UNIX_YEAR                                    68 //1968 is leap year
-
-//UNIX time 0 = start at 01:00:00, 01/01/1970
-#define UNIX_HOUR_OFFSET                            ( ( TM_DAYS_IN_LEAP_YEAR + TM_DAYS_IN_YEAR ) * TM_SECONDS_IN_1DAY )
-
 /*!
- * \brief Correction factors
+ * \brief Calendar computations count days from 1600-03-01, the start of a 400 years era.
+ *        Starting the year in March puts the leap day at its end.
  */
-#define  DAYS_IN_MONTH_CORRECTION_NORM              ( (uint32_t )0x99AAA0 )
-#define  DAYS_IN_MONTH_CORRECTION_LEAP              ( (uint32_t )0x445550 )
-
-
-/* 365.25 = (366 + 365 + 365 + 365)/4 */
-#define DIV_365_25( X )                             ( ( ( X ) * 91867 + 22750 ) >> 25 )
-
-#define DIV_APPROX_86400( X )                       ( ( ( X ) >> 18 ) + ( ( X ) >> 17 ) )
-
-#define DIV_APPROX_1000( X )                        ( ( ( X ) >> 10 ) +( ( X ) >> 16 ) + ( ( X ) >> 17 ) )
-
-#define DIV_APPROX_60( X )                          ( ( ( X ) * 17476 ) >> 20 )
-
-#define DIV_APPROX_61( X )                          ( ( ( X ) * 68759 ) >> 22 )
-
-#define MODULO_7( X )                               ( ( X ) -( ( ( ( ( X ) + 1 ) * 299593 ) >> 21 ) * 7 ) )
+#define CALENDAR_BASE_YEAR                          1600
+#define CALENDAR_DAYS_IN_ERA                        146097 // 400 * 365 + 97 leap days
+#define CALENDAR_YEARS_IN_ERA                       400
+#define CALENDAR_UNIX_EPOCH_DAYS                    135080 // 1600-03-01 to 1970-01-01
 
 /*!
- * \brief Calculates ceiling( X / N )
+ * \brief Days from 1st March to 1st January
  */
-#define DIVC( X, N )                                ( ( ( X ) + ( N ) -1 ) / ( N ) )
+#define CALENDAR_MARCH_TO_JANUARY                   306
+#define CALENDAR_JANUARY_TO_MARCH                   59
 
-#define DIVC_BY_4( X )                              ( ( ( X ) + 3 ) >>2 )
+/*!
+ * \brief Exact unsigned division by a constant done with a multiply and a shift.
+ *        Each CALENDAR_DIV_N macro gives floor( X / N ) over the input range noted
+ *        next to it.
+ */
+#define CALENDAR_DIV( X, M, S )                     ( ( uint32_t )( ( ( uint64_t )( X ) * ( M ) ) >> ( S ) ) )
+
+#define CALENDAR_DIV_86400( X )                     CALENDAR_DIV( X, 3257812231UL, 48 ) // X <= UINT32_MAX
+#define CALENDAR_DIV_1000( X )                      CALENDAR_DIV( X,  274877907UL, 38 ) // X <= UINT32_MAX
+#define CALENDAR_DIV_3600( X )                      CALENDAR_DIV( X,      37283UL, 27 ) // X < 86400
+#define CALENDAR_DIV_60( X )                        CALENDAR_DIV( X,       2185UL, 17 ) // X < 3600
+#define CALENDAR_DIV_36524( X )                     CALENDAR_DIV( X,     235187UL, 33 ) // X < 146097
+#define CALENDAR_DIV_1460( X )                      CALENDAR_DIV( X,      45965UL, 26 ) // X < 146097
+#define CALENDAR_DIV_365( X )                       CALENDAR_DIV( X,      45965UL, 24 ) // X < 146097
+#define CALENDAR_DIV_153( X )                       CALENDAR_DIV( X,        857UL, 17 ) // X < 1532
+#define CALENDAR_DIV_100( X )                       CALENDAR_DIV( X,       1311UL, 17 ) // X < 2500
+#define CALENDAR_DIV_7( X )                         CALENDAR_DIV( X,      74899UL, 19 ) // X < 60000
+#define CALENDAR_DIV_5( X )                         CALENDAR_DIV( X,       1639UL, 13 ) // X < 1685
 
-#define DIVC_BY_2( X )                              ( ( ( X ) + 1 ) >> 1 )
+/*!
+ * \brief Calendar date of the last converted day. SysTimeLocalTime reuses it while
+ *        timestamps stay within that day. Starts out as 1970-01-01, a Thursday.
+ */
+static struct
+{
+    uint32_t DayStart;
+    struct tm Date;
+}CalendarCache =
+{
+    .DayStart = 0,
+    .Date = { .tm_mday = 1, .tm_mon = TM_MONTH_JANUARY, .tm_year = 70, .tm_wday = TM_WEEKDAY_THURSDAY, .tm_yday = 0, .tm_isdst = -1 },
+};
 
-static uint32_t CalendarGetMonth( uint32_t days, uint32_t year );
-static void CalendarDiv86400( uint32_t in, uint32_t* out, uint32_t* remainder );
-static uint32_t CalendarDiv61( uint32_t in );
-static void CalendarDiv60( uint32_t in, uint32_t* out, uint32_t* remainder );
+static void CalendarFromDays( uint32_t days, struct tm* date );
 
 const char *WeekDayString[]={ "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
 
@@ -169,195 +175,102 @@ SysTime_t SysTimeFromMs( TimerTime_t timeMs )
     return SysTimeAdd( sysTime, deltaTime );
 }
 
-uint32_t SysTimeMkTime( const struct tm* localtime )
+uint64_t SysTimeToMs64( SysTime_t sysTime )
 {
-    uint32_t nbdays;
-    uint32_t nbsecs;
-    uint32_t year = localtime->tm_year - UNIX_YEAR;
-    uint32_t correctionMonth[4] =
-    {
-        DAYS_IN_MONTH_CORRECTION_LEAP,
-        DAYS_IN_MONTH_CORRECTION_NORM,
-        DAYS_IN_MONTH_CORRECTION_NORM,
-        DAYS_IN_MONTH_CORRECTION_NORM
-    };
-
-    nbdays = DIVC( ( TM_DAYS_IN_YEAR * 3 + TM_DAYS_IN_LEAP_YEAR ) * year, 4 );
-
-    nbdays += ( DIVC_BY_2( ( localtime->tm_mon ) * ( 30 + 31 ) ) -
-                ( ( ( correctionMonth[year % 4] >> ( ( localtime->tm_mon ) * 2 ) ) & 0x03 ) ) );
-
-    nbdays += ( localtime->tm_mday - 1 );
+    return ( uint64_t )sysTime.Seconds * 1000 + sysTime.SubSeconds;
+}
 
-    // Convert from days to seconds
-    nbsecs = nbdays * TM_SECONDS_IN_1DAY;
+SysTime_t SysTimeFromMs64( uint64_t timeMs )
+{
+    // Long division in two 16 bits steps, both fit CALENDAR_DIV_1000
+    uint32_t high = ( uint32_t )( timeMs >> 16 );
+    uint32_t highQuotient = CALENDAR_DIV_1000( high );
+    uint32_t low = ( ( high - highQuotient * 1000 ) << 16 ) | ( uint32_t )( timeMs & 0xFFFF );
+    uint32_t lowQuotient = CALENDAR_DIV_1000( low );
+    SysTime_t sysTime = { .Seconds = ( highQuotient << 16 ) + lowQuotient,
+                          .SubSeconds = ( int16_t )( low - lowQuotient * 1000 ) };
 
-    nbsecs += ( ( uint32_t )localtime->tm_sec + 
-                ( ( uint32_t )localtime->tm_min * TM_SECONDS_IN_1MINUTE ) +
-                ( ( uint32_t )localtime->tm_hour * TM_SECONDS_IN_1HOUR ) );
-    return nbsecs - UNIX_HOUR_OFFSET;
+    return sysTime;
 }
 
-
+uint32_t SysTimeMkTime( const struct tm* localtime )
+{
+    uint32_t month = localtime->tm_mon;
+    // March based year and month, January and February belong to the previous year
+    uint32_t year = ( uint32_t )( localtime->tm_year + 1900 - CALENDAR_BASE_YEAR ) - ( ( month < 2 ) ? 1 : 0 );
+    uint32_t era = ( year >= CALENDAR_YEARS_IN_ERA ) ? 1 : 0;
+    uint32_t yearOfEra = year - era * CALENDAR_YEARS_IN_ERA;
+    uint32_t monthFromMarch = ( month < 2 ) ? ( month + 10 ) : ( month - 2 );
+    uint32_t dayOfYear = CALENDAR_DIV_5( 153 * monthFromMarch + 2 ) + localtime->tm_mday - 1;
+    uint32_t dayOfEra = yearOfEra * TM_DAYS_IN_YEAR + ( yearOfEra >> 2 ) - CALENDAR_DIV_100( yearOfEra ) + dayOfYear;
+    uint32_t nbdays = era * CALENDAR_DAYS_IN_ERA + dayOfEra - CALENDAR_UNIX_EPOCH_DAYS;
+
+    return nbdays * TM_SECONDS_IN_1DAY +
+           ( uint32_t )localtime->tm_hour * TM_SECONDS_IN_1HOUR +
+           ( uint32_t )localtime->tm_min * TM_SECONDS_IN_1MINUTE +
+           ( uint32_t )localtime->tm_sec;
+}
 
 void SysTimeLocalTime( const uint32_t timestamp, struct tm *localtime )
 {
-    uint32_t correctionMonth[4] =
-    {
-        DAYS_IN_MONTH_CORRECTION_LEAP,
-        DAYS_IN_MONTH_CORRECTION_NORM,
-        DAYS_IN_MONTH_CORRECTION_NORM,
-        DAYS_IN_MONTH_CORRECTION_NORM
-    };
-    uint32_t weekDays = 1; // Monday 1st January 1968
     uint32_t seconds;
     uint32_t minutes;
-    uint32_t days;
-    uint32_t divOut;
-    uint32_t divReminder;
-
-    CalendarDiv86400( timestamp + UNIX_HOUR_OFFSET, &days, &seconds );
 
-    // Calculates seconds
-    CalendarDiv60( seconds, &minutes, &divReminder );
-    localtime->tm_sec = ( uint8_t )divReminder;
-
-    // Calculates minutes and hours
-    CalendarDiv60( minutes, &divOut, &divReminder);
-    localtime->tm_min = ( uint8_t )divReminder;
-    localtime->tm_hour = ( uint8_t )divOut;
-
-    // Calculates year
-    localtime->tm_year = DIV_365_25( days );
-    days-= DIVC_BY_4( ( TM_DAYS_IN_YEAR * 3 + TM_DAYS_IN_LEAP_YEAR ) * localtime->tm_year );
-
-    localtime->tm_yday = days;
-
-    // Calculates month
-    localtime->tm_mon = CalendarGetMonth( days, localtime->tm_year );
-
-    // calculates weekdays
-    weekDays += DIVC_BY_4( ( localtime->tm_year * 5 ) );
-    weekDays += days;
-    localtime->tm_wday = MODULO_7( weekDays );
-
-    days -= ( DIVC_BY_2( ( localtime->tm_mon ) * ( 30 + 31 ) ) -
-              ( ( ( correctionMonth[localtime->tm_year % 4] >> ( ( localtime->tm_mon ) * 2 ) ) & 0x03 ) ) );
-
-    // Convert 0 to 1 indexed.
-    localtime->tm_mday = days + 1;
-
-    localtime->tm_year += UNIX_YEAR;
-
-    localtime->tm_isdst = -1;
-}
-
-static uint32_t CalendarGetMonth( uint32_t days, uint32_t year )
-{
-    uint32_t month;
-    if( ( year % 4 ) == 0 )
-    {   /*leap year*/
-        if( days < END_OF_FEBRUARY_LEAP )
-        {   // January or February
-            // month =  days * 2 / ( 30 + 31 );
-            month = CalendarDiv61( days * 2 );
-        }
-        else if( days < END_OF_JULY_LEAP )
-        {
-            month = CalendarDiv61( ( days - END_OF_FEBRUARY_LEAP ) * 2 ) + 2;
-        }
-        else
-        {
-            month = CalendarDiv61( ( days - END_OF_JULY_LEAP ) * 2 ) + 7;
-        }
-    }
-    else
+    CRITICAL_SECTION_BEGIN( );
+    seconds = timestamp - CalendarCache.DayStart;
+    // The last day of the uint32_t range is cut short, a wrapped difference must not pass as the same day
+    if( ( timestamp < CalendarCache.DayStart ) || ( seconds >= TM_SECONDS_IN_1DAY ) )
     {
-        if( days < END_OF_FEBRUARY_NORM )
-        {   // January or February
-            month = CalendarDiv61( days * 2 );
-        }
-        else if( days < END_OF_JULY_NORM )
-        {
-            month = CalendarDiv61( ( days - END_OF_FEBRUARY_NORM ) * 2 ) + 2;
-        }
-        else
-        {
-            month = CalendarDiv61( ( days - END_OF_JULY_NORM ) * 2 ) + 7;
-        }
-    }
-    return month;
-}
+        uint32_t days = CALENDAR_DIV_86400( timestamp );
 
-static void CalendarDiv86400( uint32_t in, uint32_t* out, uint32_t* remainder )
-{
-#if 0
-    *remainder = in % SECONDS_IN_1DAY;
-    *out       = in / SECONDS_IN_1DAY;
-#else
-    uint32_t outTemp = 0;
-    uint32_t divResult = DIV_APPROX_86400( in );
-
-    while( divResult >=1 )
-    {
-        outTemp += divResult;
-        in -= divResult * 86400;
-        divResult= DIV_APPROX_86400( in );
-    }
-    if( in >= 86400 )
-    {
-        outTemp += 1;
-        in -= 86400;
+        CalendarCache.DayStart = days * TM_SECONDS_IN_1DAY;
+        CalendarFromDays( days, &CalendarCache.Date );
+        seconds = timestamp - CalendarCache.DayStart;
     }
+    *localtime = CalendarCache.Date;
+    CRITICAL_SECTION_END( );
 
-    *remainder = in;
-    *out = outTemp;
-#endif
+    localtime->tm_hour = CALENDAR_DIV_3600( seconds );
+    minutes = seconds - localtime->tm_hour * TM_SECONDS_IN_1HOUR;
+    localtime->tm_min = CALENDAR_DIV_60( minutes );
+    localtime->tm_sec = minutes - localtime->tm_min * TM_SECONDS_IN_1MINUTE;
 }
 
-static uint32_t CalendarDiv61( uint32_t in )
+/*!
+ * \brief Converts days since UNIX epoch into a calendar date, constant time.
+ *
+ * \param [IN]  days Days since 1970-01-01, up to 2106-02-07
+ * \param [OUT] date Date fields, time of day fields are left untouched
+ */
+static void CalendarFromDays( uint32_t days, struct tm* date )
 {
-#if 0
-    return( in / 61 );
-#else
-    uint32_t outTemp = 0;
-    uint32_t divResult = DIV_APPROX_61( in );
-    while( divResult >=1 )
+    uint32_t dayNumber = days + CALENDAR_UNIX_EPOCH_DAYS;
+    uint32_t era = ( dayNumber >= CALENDAR_DAYS_IN_ERA ) ? 1 : 0;
+    uint32_t dayOfEra = dayNumber - era * CALENDAR_DAYS_IN_ERA;
+    // Remove the leap days of every 4th, 100th and 400th year before dividing by 365
+    uint32_t yearOfEra = CALENDAR_DIV_365( dayOfEra - CALENDAR_DIV_1460( dayOfEra ) + CALENDAR_DIV_36524( dayOfEra ) -
+                                           ( ( dayOfEra == ( CALENDAR_DAYS_IN_ERA - 1 ) ) ? 1 : 0 ) );
+    uint32_t dayOfYear = dayOfEra - ( yearOfEra * TM_DAYS_IN_YEAR + ( yearOfEra >> 2 ) - CALENDAR_DIV_100( yearOfEra ) );
+    uint32_t monthFromMarch = CALENDAR_DIV_153( 5 * dayOfYear + 2 );
+    uint32_t year = CALENDAR_BASE_YEAR + era * CALENDAR_YEARS_IN_ERA + yearOfEra;
+
+    date->tm_mday = dayOfYear - CALENDAR_DIV_5( 153 * monthFromMarch + 2 ) + 1;
+    if( monthFromMarch < 10 )
     {
-        outTemp += divResult;
-        in -= divResult * 61;
-        divResult = DIV_APPROX_61( in );
-    }
-    if( in >= 61 )
-    {
-        outTemp += 1;
-        in -= 61;
-    }
-    return outTemp;
-#endif
-}
+        // March to December, preceded by January and February of the same year
+        bool leap = ( ( year & 3 ) == 0 ) && ( ( year != CALENDAR_DIV_100( year ) * 100 ) || ( ( year & 15 ) == 0 ) );
 
-static void CalendarDiv60( uint32_t in, uint32_t* out, uint32_t* remainder )
-{
-#if 0
-    *remainder = in % 60;
-    *out       = in / 60;
-#else
-    uint32_t outTemp = 0;
-    uint32_t divResult = DIV_APPROX_60( in );
-
-    while( divResult >=1 )
-    {
-        outTemp += divResult;
-        in -= divResult * 60;
-        divResult = DIV_APPROX_60( in );
+        date->tm_mon = monthFromMarch + 2;
+        date->tm_yday = dayOfYear + CALENDAR_JANUARY_TO_MARCH + ( leap ? 1 : 0 );
     }
-    if( in >= 60 )
+    else
     {
-        outTemp += 1;
-        in -= 60;
+        year++;
+        date->tm_mon = monthFromMarch - 10;
+        date->tm_yday = dayOfYear - CALENDAR_MARCH_TO_JANUARY;
     }
-    *remainder = in;
-    *out = outTemp;
-#endif
+    date->tm_year = year - 1900;
+    // 1970-01-01 was a Thursday
+    date->tm_wday = ( days + TM_WEEKDAY_THURSDAY ) - CALENDAR_DIV_7( days + TM_WEEKDAY_THURSDAY ) * 7;
+    date->tm_isdst = -1;
 }
@@ -146,6 +146,26 @@ TimerTime_t SysTimeToMs( SysTime_t sysTime );
  */
 SysTime_t SysTimeFromMs( TimerTime_t timeMs );
 
+/*!
+ * Converts the given SysTime to milliseconds of the same time base. Unlike
+ * SysTimeToMs no RTC offset is applied and the result does not wrap.
+ *
+ * \param [IN] sysTime System time to be converted
+ *
+ * \retval timeMs Time value in ms
+ */
+uint64_t SysTimeToMs64( SysTime_t sysTime );
+
+/*!
+ * Converts the given milliseconds to a SysTime of the same time base, inverse
+ * of SysTimeToMs64.
+ *
+ * \param [IN] timeMs Time value in ms, below 1000 * 2^32
+ *
+ * \retval sysTime Converted system time
+ */
+SysTime_t SysTimeFromMs64( uint64_t timeMs );
+
 /*!
  * \brief Convert a calendar time into time since UNIX epoch as a uint32_t.
  *
@@ -41,6 +41,7 @@
         }                                      \
     }while( 0 );
 
+#if( TIMER_PAIRING_HEAP == 0 )
 /*!
  * Timers list head pointer
  */
@@ -83,6 +84,8 @@ static void TimerSetTimeout( TimerEvent_t *obj );
  */
 static bool TimerExists( TimerEvent_t *obj );
 
+#endif
+
 void TimerInit( TimerEvent_t *obj, void ( *callback )( void *context ) )
 {
     obj->Timestamp = 0;
@@ -92,6 +95,10 @@ void TimerInit( TimerEvent_t *obj, void ( *callback )( void *context ) )
     obj->Callback = callback;
     obj->Context = NULL;
     obj->Next = NULL;
+#if( TIMER_PAIRING_HEAP == 1 )
+    obj->Child = NULL;
+    obj->Prev = NULL;
+#endif
 }
 
 void TimerSetContext( TimerEvent_t *obj, void* context )
@@ -99,6 +106,262 @@ void TimerSetContext( TimerEvent_t *obj, void* context )
     obj->Context = context;
 }
 
+#if( TIMER_PAIRING_HEAP == 1 )
+/*
+ * Running timers are kept in a pairing heap. Timestamp holds the absolute
+ * deadline in RTC ticks, compared with wrap around, so nothing has to be
+ * rebased when the alarm fires. Only the heap root is programmed in the RTC.
+ */
+
+/*!
+ * Timers heap root, the next timer to expire
+ */
+static TimerEvent_t *TimerHeapRoot = NULL;
+
+/*!
+ * Timer currently programmed in the RTC alarm
+ */
+static TimerEvent_t *TimerArmed = NULL;
+
+static inline bool TimerBefore( TimerEvent_t *a, TimerEvent_t *b )
+{
+    return ( int32_t )( a->Timestamp - b->Timestamp ) < 0;
+}
+
+static inline uint32_t TimerNow( void )
+{
+    return RtcGetTimerContext( ) + RtcGetTimerElapsedTime( );
+}
+
+static inline bool TimerInHeap( TimerEvent_t *obj )
+{
+    return ( obj == TimerHeapRoot ) || ( obj->Prev != NULL );
+}
+
+/*!
+ * \brief Links two detached heaps, the later one becomes the first child
+ */
+static TimerEvent_t *TimerHeapMeld( TimerEvent_t *a, TimerEvent_t *b )
+{
+    TimerEvent_t *tmp;
+
+    if( a == NULL )
+    {
+        return b;
+    }
+    if( b == NULL )
+    {
+        return a;
+    }
+    if( TimerBefore( b, a ) )
+    {
+        tmp = a;
+        a = b;
+        b = tmp;
+    }
+
+    b->Prev = a;
+    b->Next = a->Child;
+    if( a->Child != NULL )
+    {
+        a->Child->Prev = b;
+    }
+    a->Child = b;
+    return a;
+}
+
+/*!
+ * \brief Two pass pairing of a sibling list into a single heap
+ */
+static TimerEvent_t *TimerHeapMergePairs( TimerEvent_t *first )
+{
+    TimerEvent_t *pairs = NULL;
+    TimerEvent_t *heap = NULL;
+    TimerEvent_t *a;
+    TimerEvent_t *b;
+
+    while( first != NULL )
+    {
+        a = first;
+        b = a->Next;
+        first = ( b != NULL ) ? b->Next : NULL;
+
+        a->Next = a->Prev = NULL;
+        if( b != NULL )
+        {
+            b->Next = b->Prev = NULL;
+        }
+        a = TimerHeapMeld( a, b );
+
+        // Next is reused to stack the pairs for the second pass
+        a->Next = pairs;
+        pairs = a;
+    }
+
+    while( pairs != NULL )
+    {
+        a = pairs;
+        pairs = a->Next;
+        a->Next = NULL;
+        heap = TimerHeapMeld( heap, a );
+    }
+    return heap;
+}
+
+static void TimerHeapRemove( TimerEvent_t *obj )
+{
+    TimerEvent_t *sub;
+
+    if( obj != TimerHeapRoot )
+    {
+        if( obj->Prev->Child == obj )
+        {
+            obj->Prev->Child = obj->Next;
+        }
+        else
+        {
+            obj->Prev->Next = obj->Next;
+        }
+        if( obj->Next != NULL )
+        {
+            obj->Next->Prev = obj->Prev;
+        }
+    }
+
+    sub = TimerHeapMergePairs( obj->Child );
+    if( obj == TimerHeapRoot )
+    {
+        TimerHeapRoot = sub;
+    }
+    else
+    {
+        TimerHeapRoot = TimerHeapMeld( TimerHeapRoot, sub );
+    }
+
+    obj->Child = obj->Next = obj->Prev = NULL;
+}
+
+/*!
+ * \brief Programs the RTC alarm for the heap root
+ */
+static void TimerHeapArm( void )
+{
+    TimerEvent_t *obj = TimerHeapRoot;
+    int32_t minTicks = RtcGetMinimumTimeout( );
+    int32_t timeout;
+
+    if( TimerArmed != NULL )
+    {
+        TimerArmed->IsNext2Expire = false;
+        TimerArmed = NULL;
+    }
+
+    if( obj == NULL )
+    {
+        RtcStopAlarm( );
+        return;
+    }
+
+    RtcSetTimerContext( );
+    timeout = ( int32_t )( obj->Timestamp - RtcGetTimerContext( ) );
+
+    // In case deadline too soon
+    if( timeout < minTicks )
+    {
+        timeout = minTicks;
+    }
+
+    obj->IsNext2Expire = true;
+    TimerArmed = obj;
+    RtcSetAlarm( ( uint32_t )timeout );
+}
+
+void TimerStart( TimerEvent_t *obj )
+{
+    CRITICAL_SECTION_BEGIN( );
+
+    if( ( obj == NULL ) || ( TimerInHeap( obj ) == true ) )
+    {
+        CRITICAL_SECTION_END( );
+        return;
+    }
+
+    obj->Timestamp = TimerNow( ) + obj->ReloadValue;
+    obj->IsStarted = true;
+    obj->IsNext2Expire = false;
+    obj->Child = obj->Next = obj->Prev = NULL;
+
+    TimerHeapRoot = TimerHeapMeld( TimerHeapRoot, obj );
+
+    if( TimerHeapRoot != TimerArmed )
+    {
+        TimerHeapArm( );
+    }
+    CRITICAL_SECTION_END( );
+}
+
+void TimerIrqHandler( void )
+{
+    TimerEvent_t* cur;
+
+    // Execute immediately the alarm callback
+    if( TimerHeapRoot != NULL )
+    {
+        cur = TimerHeapRoot;
+        TimerHeapRemove( cur );
+        if( cur == TimerArmed )
+        {
+            TimerArmed = NULL;
+        }
+        cur->IsNext2Expire = false;
+        cur->IsStarted = false;
+        ExecuteCallBack( cur->Callback, cur->Context );
+    }
+
+    // Remove all the expired object from the heap
+    while( ( TimerHeapRoot != NULL ) && ( ( int32_t )( TimerHeapRoot->Timestamp - TimerNow( ) ) <= 0 ) )
+    {
+        cur = TimerHeapRoot;
+        TimerHeapRemove( cur );
+        if( cur == TimerArmed )
+        {
+            TimerArmed = NULL;
+        }
+        cur->IsNext2Expire = false;
+        cur->IsStarted = false;
+        ExecuteCallBack( cur->Callback, cur->Context );
+    }
+
+    // Start the next root if it exists AND NOT running
+    if( ( TimerHeapRoot != NULL ) && ( TimerHeapRoot->IsNext2Expire == false ) )
+    {
+        TimerHeapArm( );
+    }
+}
+
+void TimerStop( TimerEvent_t *obj )
+{
+    CRITICAL_SECTION_BEGIN( );
+
+    // Heap is empty or the obj to stop is not running
+    if( ( obj == NULL ) || ( TimerInHeap( obj ) == false ) )
+    {
+        CRITICAL_SECTION_END( );
+        return;
+    }
+
+    obj->IsStarted = false;
+    TimerHeapRemove( obj );
+
+    if( obj == TimerArmed )
+    {
+        TimerHeapArm( );
+    }
+    CRITICAL_SECTION_END( );
+}
+#endif
+
+#if( TIMER_PAIRING_HEAP == 0 )
 void TimerStart( TimerEvent_t *obj )
 {
     uint32_t elapsedTime = 0;
@@ -175,11 +438,14 @@ static void TimerInsertNewHeadTimer( TimerEvent_t *obj )
     TimerSetTimeout( TimerListHead );
 }
 
+#endif
+
 bool TimerIsStarted( TimerEvent_t *obj )
 {
     return obj->IsStarted;
 }
 
+#if( TIMER_PAIRING_HEAP == 0 )
 void TimerIrqHandler( void )
 {
     TimerEvent_t* cur;
@@ -319,6 +585,8 @@ static bool TimerExists( TimerEvent_t *obj )
     return false;
 }
 
+#endif
+
 void TimerReset( TimerEvent_t *obj )
 {
     TimerStop( obj );
@@ -362,6 +630,7 @@ TimerTime_t TimerGetElapsedTime( TimerTime_t past )
     return RtcTick2Ms( nowInTicks - pastInTicks );
 }
 
+#if( TIMER_PAIRING_HEAP == 0 )
 static void TimerSetTimeout( TimerEvent_t *obj )
 {
     int32_t minTicks= RtcGetMinimumTimeout( );
@@ -375,6 +644,8 @@ static void TimerSetTimeout( TimerEvent_t *obj )
     RtcSetAlarm( obj->Timestamp );
 }
 
+#endif
+
 TimerTime_t TimerTempCompensation( TimerTime_t period, float temperature )
 {
     return RtcTempCompensation( period, temperature );
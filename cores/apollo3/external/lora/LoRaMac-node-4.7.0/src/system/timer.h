@@ -32,6 +32,15 @@ extern "C"
 #include <stdbool.h>
 #include <stdint.h>
 
+/*!
+ * \brief Keep the running timers in a pairing heap ordered by absolute
+ *        deadline instead of a sorted list. Start, stop and expiry no longer
+ *        walk every running timer. Set to 0 to use the original list.
+ */
+#ifndef TIMER_PAIRING_HEAP
+#define TIMER_PAIRING_HEAP                          1
+#endif
+
 /*!
  * \brief Timer object description
  */
@@ -44,6 +53,10 @@ typedef struct TimerEvent_s
     void ( *Callback )( void* context ); //! Timer IRQ callback function
     void *Context;                       //! User defined data object pointer to pass back
     struct TimerEvent_s *Next;           //! Pointer to the next Timer object.
+#if( TIMER_PAIRING_HEAP == 1 )
+    struct TimerEvent_s *Child;          //! Pointer to the first child in the timer heap.
+    struct TimerEvent_s *Prev;           //! Pointer to the previous sibling, or parent for a first child.
+#endif
 }TimerEvent_t;
 
 /*!
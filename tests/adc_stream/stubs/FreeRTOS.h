@@ -0,0 +1,5 @@
+/* Host stand-in for FreeRTOS, the uhal headers include it but uhal_adc.c uses none of it. */
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#endif
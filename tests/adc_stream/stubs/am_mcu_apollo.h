@@ -0,0 +1,143 @@
+/* Host stand-in for the Apollo3 HAL, just what uhal_adc.c uses. The functions
+ * are implemented by the test on a simulated ADC, DMA and CTIMER. */
+#ifndef _AM_MCU_APOLLO_H_
+#define _AM_MCU_APOLLO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define AM_HAL_STATUS_SUCCESS           0
+
+#define AM_HAL_ADC_INT_CNVCMP           (1u << 0)
+#define AM_HAL_ADC_INT_DCMP             (1u << 6)
+#define AM_HAL_ADC_INT_DERR             (1u << 7)
+
+#define AM_HAL_ADC_FIFO_SAMPLE(value)   (((value) & 0xFFFFF) >> 6)
+
+#define AM_HAL_PIN_31_ADCSE3            1
+#define AM_HAL_PIN_32_ADCSE4            1
+#define AM_HAL_PIN_33_ADCSE5            1
+#define AM_HAL_PIN_13_ADCD0PSE8         1
+#define AM_HAL_PIN_12_ADCD0NSE9         1
+
+#define AM_HAL_CTIMER_TIMERA            0x0000FFFF
+#define AM_HAL_CTIMER_HFRC_3MHZ         0x0200
+#define AM_HAL_CTIMER_HFRC_12KHZ        0x0A00
+#define AM_HAL_CTIMER_FN_REPEAT         0x0040
+#define AM_HAL_CTIMER_INT_ENABLE        0x0800
+#define AM_HAL_CTIMER_INT_TIMERA6C0     (1u << 12)
+
+#define AM_HAL_SYSCTRL_WAKE             0
+#define AM_HAL_PWRCTRL_PERIPH_ADC       8
+
+#define NVIC_configKERNEL_INTERRUPT_PRIORITY 4
+
+typedef enum { ADC_IRQn = 18, CTIMER_IRQn = 14 } IRQn_Type;
+
+typedef enum
+{
+    AM_HAL_ADC_SLOT_CHSEL_SE3 = 3, AM_HAL_ADC_SLOT_CHSEL_SE4, AM_HAL_ADC_SLOT_CHSEL_SE5,
+    AM_HAL_ADC_SLOT_CHSEL_SE8 = 8, AM_HAL_ADC_SLOT_CHSEL_SE9,
+} am_hal_adc_slot_chan_e;
+
+typedef enum { AM_HAL_ADC_SLOT_14BIT, AM_HAL_ADC_SLOT_12BIT, AM_HAL_ADC_SLOT_10BIT, AM_HAL_ADC_SLOT_8BIT } am_hal_adc_slot_prec_e;
+typedef enum
+{
+    AM_HAL_ADC_SLOT_AVG_1, AM_HAL_ADC_SLOT_AVG_2, AM_HAL_ADC_SLOT_AVG_4, AM_HAL_ADC_SLOT_AVG_8,
+    AM_HAL_ADC_SLOT_AVG_16, AM_HAL_ADC_SLOT_AVG_32, AM_HAL_ADC_SLOT_AVG_64, AM_HAL_ADC_SLOT_AVG_128,
+} am_hal_adc_meas_avg_e;
+typedef enum { AM_HAL_ADC_CLKSEL_OFF, AM_HAL_ADC_CLKSEL_HFRC, AM_HAL_ADC_CLKSEL_HFRC_DIV2 } am_hal_adc_clksel_e;
+typedef enum { AM_HAL_ADC_TRIGPOL_RISING, AM_HAL_ADC_TRIGPOL_FALLING } am_hal_adc_trigpol_e;
+typedef enum { AM_HAL_ADC_TRIGSEL_EXT0, AM_HAL_ADC_TRIGSEL_SOFTWARE = 7 } am_hal_adc_trigsel_e;
+typedef enum { AM_HAL_ADC_REFSEL_INT_2P0, AM_HAL_ADC_REFSEL_INT_1P5 } am_hal_adc_refsel_e;
+typedef enum { AM_HAL_ADC_CLKMODE_LOW_POWER, AM_HAL_ADC_CLKMODE_LOW_LATENCY } am_hal_adc_clkmode_e;
+typedef enum { AM_HAL_ADC_LPMODE0, AM_HAL_ADC_LPMODE1 } am_hal_adc_lpmode_e;
+typedef enum { AM_HAL_ADC_SINGLE_SCAN, AM_HAL_ADC_REPEATING_SCAN } am_hal_adc_repeat_e;
+typedef enum { AM_HAL_ADC_PRIOR_BEST_EFFORT, AM_HAL_ADC_PRIOR_SERVICE_IMMED } am_hal_adc_dma_prior_e;
+
+typedef struct
+{
+    am_hal_adc_clksel_e     eClock;
+    am_hal_adc_trigpol_e    ePolarity;
+    am_hal_adc_trigsel_e    eTrigger;
+    am_hal_adc_refsel_e     eReference;
+    am_hal_adc_clkmode_e    eClockMode;
+    am_hal_adc_lpmode_e     ePowerMode;
+    am_hal_adc_repeat_e     eRepeat;
+} am_hal_adc_config_t;
+
+typedef struct
+{
+    am_hal_adc_meas_avg_e   eMeasToAvg;
+    am_hal_adc_slot_prec_e  ePrecisionMode;
+    am_hal_adc_slot_chan_e  eChannel;
+    bool                    bWindowCompare;
+    bool                    bEnabled;
+} am_hal_adc_slot_config_t;
+
+typedef struct
+{
+    bool                    bDynamicPriority;
+    am_hal_adc_dma_prior_e  ePriority;
+    bool                    bDMAEnable;
+    uint32_t                ui32SampleCount;
+    uint32_t                ui32TargetAddress;
+} am_hal_adc_dma_config_t;
+
+typedef struct
+{
+    uint32_t ui32Sample;
+    uint32_t ui32Slot;
+} am_hal_adc_sample_t;
+
+typedef struct
+{
+    uint32_t uFuncSel;
+} am_hal_gpio_pincfg_t;
+
+typedef struct
+{
+    volatile uint32_t DMACFG;
+    volatile uint32_t DMASTAT;
+} ADC_Type;
+
+extern ADC_Type sim_adc_regs;
+#define ADC (&sim_adc_regs)
+
+extern const am_hal_gpio_pincfg_t g_AM_HAL_GPIO_DISABLE;
+
+typedef void (*am_hal_ctimer_handler_t)(void);
+
+uint32_t am_hal_gpio_pinconfig(uint32_t pin, am_hal_gpio_pincfg_t cfg);
+
+uint32_t am_hal_adc_initialize(uint32_t module, void **handle);
+uint32_t am_hal_adc_deinitialize(void *handle);
+uint32_t am_hal_adc_power_control(void *handle, uint32_t state, bool retain);
+uint32_t am_hal_adc_configure(void *handle, am_hal_adc_config_t *config);
+uint32_t am_hal_adc_configure_slot(void *handle, uint32_t slot, am_hal_adc_slot_config_t *config);
+uint32_t am_hal_adc_configure_dma(void *handle, am_hal_adc_dma_config_t *config);
+uint32_t am_hal_adc_enable(void *handle);
+uint32_t am_hal_adc_disable(void *handle);
+uint32_t am_hal_adc_interrupt_enable(void *handle, uint32_t mask);
+uint32_t am_hal_adc_interrupt_disable(void *handle, uint32_t mask);
+uint32_t am_hal_adc_interrupt_status(void *handle, uint32_t *status, bool enabled_only);
+uint32_t am_hal_adc_interrupt_clear(void *handle, uint32_t mask);
+uint32_t am_hal_adc_sw_trigger(void *handle);
+uint32_t am_hal_adc_samples_read(void *handle, bool full_sample, uint32_t *buffer, uint32_t *count, am_hal_adc_sample_t *samples);
+uint32_t am_hal_pwrctrl_periph_disable(uint32_t periph);
+
+void am_hal_ctimer_config_single(uint32_t timer, uint32_t segment, uint32_t config);
+void am_hal_ctimer_compare_set(uint32_t timer, uint32_t segment, uint32_t compare_reg, uint32_t value);
+void am_hal_ctimer_start(uint32_t timer, uint32_t segment);
+void am_hal_ctimer_stop(uint32_t timer, uint32_t segment);
+void am_hal_ctimer_clear(uint32_t timer, uint32_t segment);
+void am_hal_ctimer_int_enable(uint32_t mask);
+void am_hal_ctimer_int_disable(uint32_t mask);
+void am_hal_ctimer_int_clear(uint32_t mask);
+void am_hal_ctimer_int_register(uint32_t mask, am_hal_ctimer_handler_t handler);
+
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority);
+
+#endif  // #ifndef _AM_MCU_APOLLO_H_
@@ -0,0 +1,5 @@
+/* Host stand-in for the Ambiq utilities, nothing of it is used. */
+#ifndef _AM_UTIL_H_
+#define _AM_UTIL_H_
+
+#endif  // #ifndef _AM_UTIL_H_
@@ -0,0 +1,5 @@
+/* Host stand-in, see FreeRTOS.h. */
+#ifndef _STUB_EVENT_GROUPS_H_
+#define _STUB_EVENT_GROUPS_H_
+
+#endif
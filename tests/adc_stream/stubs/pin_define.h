@@ -0,0 +1,5 @@
+/* Host stand-in for the board pin map, uhal_pwm.h includes it but uhal_adc.c uses none of it. */
+#ifndef _PIN_DEFINE_H_
+#define _PIN_DEFINE_H_
+
+#endif
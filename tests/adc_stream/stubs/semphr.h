@@ -0,0 +1,5 @@
+/* Host stand-in, see FreeRTOS.h. */
+#ifndef _STUB_SEMPHR_H_
+#define _STUB_SEMPHR_H_
+
+#endif
@@ -0,0 +1,471 @@
+/*
+ * ADC stream in uhal_adc.c on a simulated ADC: each trigger converts one
+ * sample into the DMA target, which raises DCMP once the armed count is
+ * reached; the CTIMER trigger runs from HFRC and stops while the idle task
+ * is in deep sleep.
+ * Checks that blocks arrive complete and in order through idle sleep, that a
+ * slow event loop costs whole blocks counted as overruns, that the stream
+ * holds the idle task in normal sleep until stopped, and compares the HAL
+ * calls and interrupts per sample with uhal_adc_read().
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "uhal_adc.h"
+#include "udrv_system.h"
+#include "uhal_powersave.h"
+#include "uhal_pwm.h"
+#include "test.h"
+
+#define PIN             31
+#define EVENTS_MAX      16
+
+void am_adc_isr(void);
+
+ADC_Type sim_adc_regs;
+const am_hal_gpio_pincfg_t g_AM_HAL_GPIO_DISABLE;
+
+static struct
+{
+    bool powered;
+    bool nvic;
+    uint32_t inten;
+    uint32_t status;
+    uint32_t *dma_buf;
+    uint32_t dma_count;
+    uint32_t dma_pos;
+    uint32_t fifo;
+    uint32_t seq;                   // value of the next conversion
+    am_hal_ctimer_handler_t timer_isr;
+    uint32_t timer_period;
+    bool timer_on;
+    bool timer_int;
+    bool pwm_busy;
+    uint32_t latency[UDRV_PS_LATENCY_MAX];
+    udrv_system_event_t events[EVENTS_MAX];
+    int event_n;
+    uint32_t hal_calls;
+    uint32_t interrupts;
+    uint32_t power_ups;
+    uint32_t deep_sleeps;
+} sim;
+
+static struct
+{
+    uint32_t blocks;
+    uint32_t samples;
+    int32_t last;                   // last sample delivered
+    uint32_t block;
+    uint32_t decimation;
+    uint32_t gaps;                  // blocks not following the previous one
+    uint32_t errors;
+} out;
+
+// HAL on the simulated ADC
+
+uint32_t am_hal_gpio_pinconfig(uint32_t pin, am_hal_gpio_pincfg_t cfg)
+{
+    sim.hal_calls++;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_adc_initialize(uint32_t module, void **handle)
+{
+    static int instance;
+
+    sim.hal_calls++;
+    *handle = &instance;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_adc_deinitialize(void *handle)
+{
+    sim.hal_calls++;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_adc_power_control(void *handle, uint32_t state, bool retain)
+{
+    sim.hal_calls++;
+    sim.powered = true;
+    sim.power_ups++;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_adc_configure(void *handle, am_hal_adc_config_t *config)
+{
+    sim.hal_calls++;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_adc_configure_slot(void *handle, uint32_t slot, am_hal_adc_slot_config_t *config)
+{
+    sim.hal_calls++;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_adc_configure_dma(void *handle, am_hal_adc_dma_config_t *config)
+{
+    sim.hal_calls++;
+    // The target is a 32-bit bus address; the driver's buffers are in the
+    // same image as sim, so its upper half restores the host pointer.
+    sim.dma_buf = (uint32_t *)(((uintptr_t)&sim & ~(uintptr_t)0xFFFFFFFF) | config->ui32TargetAddress);
+    sim.dma_count = config->ui32SampleCount;
+    sim.dma_pos = 0;
+    ADC->DMACFG = config->bDMAEnable;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_adc_enable(void *handle)
+{
+    sim.hal_calls++;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_adc_disable(void *handle)
+{
+    sim.hal_calls++;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_adc_interrupt_enable(void *handle, uint32_t mask)
+{
+    sim.hal_calls++;
+    sim.inten |= mask;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_adc_interrupt_disable(void *handle, uint32_t mask)
+{
+    sim.hal_calls++;
+    sim.inten &= ~mask;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_adc_interrupt_status(void *handle, uint32_t *status, bool enabled_only)
+{
+    sim.hal_calls++;
+    *status = sim.status;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_adc_interrupt_clear(void *handle, uint32_t mask)
+{
+    sim.hal_calls++;
+    sim.status &= ~mask;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_adc_sw_trigger(void *handle)
+{
+    uint32_t word = (sim.seq++ & 0x3FFF) << 6;
+
+    sim.hal_calls++;
+    if (!sim.powered)
+        return AM_HAL_STATUS_SUCCESS;
+
+    sim.status |= AM_HAL_ADC_INT_CNVCMP;
+    if (ADC->DMACFG)
+    {
+        sim.dma_buf[sim.dma_pos++] = word;
+        if (sim.dma_pos == sim.dma_count)
+        {
+            ADC->DMACFG = 0;
+            sim.status |= AM_HAL_ADC_INT_DCMP;
+        }
+    }
+    else
+        sim.fifo = word;
+
+    if (sim.nvic && (sim.status & sim.inten))
+    {
+        sim.interrupts++;
+        am_adc_isr();
+    }
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_adc_samples_read(void *handle, bool full_sample, uint32_t *buffer, uint32_t *count, am_hal_adc_sample_t *samples)
+{
+    sim.hal_calls++;
+    samples[0].ui32Sample = AM_HAL_ADC_FIFO_SAMPLE(sim.fifo);
+    samples[0].ui32Slot = 0;
+    *count = 1;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_pwrctrl_periph_disable(uint32_t periph)
+{
+    sim.hal_calls++;
+    sim.powered = false;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+void am_hal_ctimer_config_single(uint32_t timer, uint32_t segment, uint32_t config) { sim.hal_calls++; }
+void am_hal_ctimer_compare_set(uint32_t timer, uint32_t segment, uint32_t compare_reg, uint32_t value)
+{
+    sim.hal_calls++;
+    sim.timer_period = value + 1;
+}
+void am_hal_ctimer_start(uint32_t timer, uint32_t segment) { sim.hal_calls++; sim.timer_on = true; }
+void am_hal_ctimer_stop(uint32_t timer, uint32_t segment) { sim.hal_calls++; sim.timer_on = false; }
+void am_hal_ctimer_clear(uint32_t timer, uint32_t segment) { sim.hal_calls++; }
+void am_hal_ctimer_int_enable(uint32_t mask) { sim.hal_calls++; sim.timer_int = true; }
+void am_hal_ctimer_int_disable(uint32_t mask) { sim.hal_calls++; sim.timer_int = false; }
+void am_hal_ctimer_int_clear(uint32_t mask) { sim.hal_calls++; }
+void am_hal_ctimer_int_register(uint32_t mask, am_hal_ctimer_handler_t handler)
+{
+    sim.hal_calls++;
+    sim.timer_isr = handler;
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq)
+{
+    sim.hal_calls++;
+    if (irq == ADC_IRQn)
+        sim.nvic = true;
+}
+
+void NVIC_DisableIRQ(IRQn_Type irq)
+{
+    sim.hal_calls++;
+    if (irq == ADC_IRQn)
+        sim.nvic = false;
+}
+
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority) { sim.hal_calls++; }
+
+// Rest of the system
+
+bool uhal_pwm_ctimer_busy(uint32_t timer, uint32_t segment)
+{
+    return sim.pwm_busy;
+}
+
+void uhal_mcu_consume_event(void)
+{
+}
+
+int32_t udrv_system_event_produce(udrv_system_event_t *event)
+{
+    CHECK(sim.event_n < EVENTS_MAX, "event queue full");
+    if (sim.event_n < EVENTS_MAX)
+        sim.events[sim.event_n++] = *event;
+    return 0;
+}
+
+// Same bookkeeping as udrv_powersave.c.
+void udrv_powersave_set_latency(UDRV_PS_LATENCY who, uint32_t max_us)
+{
+    if (who < UDRV_PS_LATENCY_MAX)
+        sim.latency[who] = max_us;
+}
+
+uint32_t udrv_powersave_get_latency(void)
+{
+    uint32_t latency = UDRV_PS_LATENCY_ANY;
+
+    for (int i = 0; i < UDRV_PS_LATENCY_MAX; i++)
+    {
+        if (sim.latency[i] < latency)
+            latency = sim.latency[i];
+    }
+    return latency;
+}
+
+static void dispatch(void)
+{
+    for (int i = 0; i < sim.event_n; i++)
+    {
+        if (sim.events[i].request == UDRV_SYS_EVT_OP_ADC_BLOCK)
+            uhal_adc_stream_handler(sim.events[i].p_context);
+    }
+    sim.event_n = 0;
+}
+
+// One trigger period with the idle task asleep: deep sleep, as chosen by
+// uhal_mcu_idle_sleep() without a tight bound, stops HFRC and the trigger.
+static void idle_period(void)
+{
+    if (udrv_powersave_get_latency() >= UHAL_PS_DEEP_SLEEP_LATENCY_US)
+    {
+        sim.deep_sleeps++;
+        return;
+    }
+    if (sim.timer_on && sim.timer_int && sim.timer_isr != NULL)
+    {
+        sim.interrupts++;
+        sim.timer_isr();
+    }
+}
+
+static void on_block(int16_t *samples, uint32_t count)
+{
+    // Sample i of a block averages raw values base + i * decimation onwards.
+    int32_t step = out.decimation;
+
+    CHECK(count == out.block, "block of %u samples, expected %u", count, out.block);
+    for (uint32_t i = 1; i < count; i++)
+    {
+        if (samples[i] - samples[i - 1] != step)
+            out.errors++;
+    }
+    if (out.blocks > 0 && samples[0] != out.last + step)
+        out.gaps++;
+    out.last = samples[count - 1];
+    out.blocks++;
+    out.samples += count;
+}
+
+static void reset(uint32_t block, uint32_t decimation)
+{
+    memset(&sim, 0, sizeof(sim));
+    memset(&out, 0, sizeof(out));
+    for (int i = 0; i < UDRV_PS_LATENCY_MAX; i++)
+        sim.latency[i] = UDRV_PS_LATENCY_ANY;
+    out.block = block;
+    out.decimation = decimation;
+}
+
+// The event loop keeps up: every block arrives, in order, through idle sleep.
+static void test_stream(uint32_t block, uint32_t decimation)
+{
+    // Conversions stay below the 14-bit wrap of the simulated values.
+    uint32_t raw = block * decimation, blocks = (16000 / raw < 100) ? 16000 / raw : 100;
+
+    reset(block, decimation);
+    CHECK(uhal_adc_stream_start(PIN, 1000, block, decimation, on_block) == UDRV_RETURN_OK, "stream start failed");
+    CHECK(sim.timer_period == 3000, "trigger period %u at 1 kHz", sim.timer_period);
+    CHECK(udrv_powersave_get_latency() < UHAL_PS_DEEP_SLEEP_LATENCY_US, "stream allows deep sleep");
+    CHECK(uhal_adc_is_active(), "ADC not active while streaming");
+    for (uint32_t t = 0; t < blocks * raw; t++)
+    {
+        idle_period();
+        dispatch();
+    }
+    CHECK(uhal_adc_stream_stop() == UDRV_RETURN_OK, "stream stop failed");
+    CHECK(out.blocks == blocks, "block %u decimation %u: %u of %u blocks", block, decimation, out.blocks, blocks);
+    CHECK(out.errors == 0 && out.gaps == 0, "block %u decimation %u: %u samples out of order, %u gaps",
+          block, decimation, out.errors, out.gaps);
+    CHECK(uhal_adc_stream_overruns() == 0, "%u overruns", uhal_adc_stream_overruns());
+    CHECK(sim.deep_sleeps == 0, "%u deep sleeps while streaming", sim.deep_sleeps);
+    CHECK(udrv_powersave_get_latency() == UDRV_PS_LATENCY_ANY, "latency bound kept after stop");
+    CHECK(!sim.powered && !sim.timer_on, "ADC or trigger left running after stop");
+}
+
+// Without the bound the idle task goes to deep sleep and the stream stalls.
+static void test_deep_sleep_stalls(void)
+{
+    reset(16, 1);
+    uhal_adc_stream_start(PIN, 1000, 16, 1, on_block);
+    udrv_powersave_set_latency(UDRV_PS_LATENCY_ADC, UDRV_PS_LATENCY_ANY);
+    for (uint32_t t = 0; t < 1000; t++)
+    {
+        idle_period();
+        dispatch();
+    }
+    CHECK(out.blocks == 0 && sim.deep_sleeps == 1000, "stream ran in deep sleep: %u blocks", out.blocks);
+    uhal_adc_stream_stop();
+}
+
+// An event loop that lags two blocks behind loses whole blocks, never a part of one.
+static void test_overrun(void)
+{
+    uint32_t dispatched = 0;
+
+    reset(16, 4);
+    uhal_adc_stream_start(PIN, 1000, 16, 4, on_block);
+    for (uint32_t t = 0; t < 64 * 60; t++)
+    {
+        idle_period();
+        if (t % (64 * 3) == 0)
+        {
+            dispatched += sim.event_n;
+            dispatch();
+        }
+    }
+    dispatched += sim.event_n;
+    dispatch();
+    CHECK(out.errors == 0, "%u samples out of order within a block", out.errors);
+    CHECK(uhal_adc_stream_overruns() > 0, "no overrun counted");
+    CHECK(out.blocks + uhal_adc_stream_overruns() == 60, "%u blocks and %u overruns of 60",
+          out.blocks, uhal_adc_stream_overruns());
+    CHECK(out.blocks == dispatched, "%u blocks delivered for %u events", out.blocks, dispatched);
+    uhal_adc_stream_stop();
+}
+
+static void test_refused(void)
+{
+    int16_t value;
+
+    reset(16, 1);
+    CHECK(uhal_adc_stream_start(PIN, 1000, 0, 1, on_block) == -UDRV_WRONG_ARG, "empty block accepted");
+    CHECK(uhal_adc_stream_start(PIN, 1000, 128, 4, on_block) == -UDRV_WRONG_ARG, "raw buffer overflow accepted");
+    CHECK(uhal_adc_stream_start(PIN, UHAL_ADC_STREAM_TRIGGER_MAX + 1, 16, 1, on_block) == -UDRV_WRONG_ARG,
+          "trigger rate above the limit accepted");
+    CHECK(uhal_adc_stream_start(7, 1000, 16, 1, on_block) == -UDRV_WRONG_ARG, "pin without ADC accepted");
+    sim.pwm_busy = true;
+    CHECK(uhal_adc_stream_start(PIN, 1000, 16, 1, on_block) == -UDRV_BUSY, "started on a timer held by PWM");
+    sim.pwm_busy = false;
+    CHECK(udrv_powersave_get_latency() == UDRV_PS_LATENCY_ANY, "refused start left a latency bound");
+
+    CHECK(uhal_adc_stream_start(PIN, 1000, 16, 1, on_block) == UDRV_RETURN_OK, "stream start failed");
+    CHECK(uhal_adc_stream_start(PIN, 1000, 16, 1, on_block) == -UDRV_BUSY, "second stream started");
+    CHECK(uhal_adc_read(PIN, &value) == -UDRV_BUSY, "single shot during a stream");
+    CHECK(uhal_adc_stream_ctimer_busy(6, AM_HAL_CTIMER_TIMERA), "trigger timer not reported busy");
+    uhal_adc_stream_stop();
+    CHECK(!uhal_adc_stream_ctimer_busy(6, AM_HAL_CTIMER_TIMERA), "trigger timer busy after stop");
+}
+
+// HAL calls and interrupts per delivered sample, uhal_adc_read() against a stream.
+static void cost(uint32_t block, uint32_t decimation, double *calls, double *irqs)
+{
+    uint32_t raw = block * decimation, blocks = 64;
+
+    reset(block, decimation);
+    uhal_adc_stream_start(PIN, 1000, block, decimation, on_block);
+    sim.hal_calls = 0;
+    sim.interrupts = 0;
+    for (uint32_t t = 0; t < blocks * raw; t++)
+    {
+        idle_period();
+        dispatch();
+    }
+    CHECK(out.samples == blocks * block, "%u of %u samples", out.samples, blocks * block);
+    *calls = (double)sim.hal_calls / out.samples;
+    *irqs = (double)sim.interrupts / out.samples;
+    uhal_adc_stream_stop();
+}
+
+int main(void)
+{
+    int16_t value;
+    uint32_t calls, irqs, power_ups;
+    double stream_calls, stream_irqs, avg_calls, avg_irqs;
+
+    test_stream(16, 1);
+    test_stream(64, 4);
+    test_stream(UDRV_ADC_STREAM_BLOCK_MAX, 1);
+    test_deep_sleep_stalls();
+    test_overrun();
+    test_refused();
+
+    reset(1, 1);
+    sim.seq = 123;
+    for (int i = 0; i < 100; i++)
+    {
+        CHECK(uhal_adc_read(PIN, &value) == UDRV_RETURN_OK && value == 123 + i, "single shot read %d", value);
+        CHECK(!sim.powered && !uhal_adc_is_active(), "ADC left powered after a single shot");
+    }
+    calls = sim.hal_calls;
+    irqs = sim.interrupts;
+    power_ups = sim.power_ups;
+    cost(64, 1, &stream_calls, &stream_irqs);
+    cost(64, 4, &avg_calls, &avg_irqs);
+
+    printf("adc_stream: per sample single shot %.0f HAL calls, %.0f interrupt, %.0f power-up; "
+           "stream block 64 %.2f HAL calls, %.2f interrupts; with decimation 4 %.2f, %.2f\n",
+           calls / 100.0, irqs / 100.0, power_ups / 100.0, stream_calls, stream_irqs, avg_calls, avg_irqs);
+
+    TEST_DONE("adc_stream");
+}
@@ -0,0 +1,14 @@
+/* Host stand-in for the Cordio dm_api.h, only the AD types the scan filter parses */
+#ifndef DM_API_H
+#define DM_API_H
+
+#define DM_ADV_TYPE_FLAGS           0x01
+#define DM_ADV_TYPE_16_UUID_PART    0x02
+#define DM_ADV_TYPE_16_UUID         0x03
+#define DM_ADV_TYPE_128_UUID_PART   0x06
+#define DM_ADV_TYPE_128_UUID        0x07
+#define DM_ADV_TYPE_SERVICE_DATA    0x16
+#define DM_ADV_TYPE_SVC_DATA_128    0x21
+#define DM_ADV_TYPE_MANUFACTURER    0xFF
+
+#endif
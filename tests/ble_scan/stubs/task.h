@@ -0,0 +1,12 @@
+/* Host stand-in for FreeRTOS task.h, 1 tick = 1 ms and the test owns the clock */
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+
+TickType_t xTaskGetTickCount(void);
+
+#endif
@@ -0,0 +1,312 @@
+/*
+ * BLE scan filtering, deduplication and batching in uhal_ble_scan.c, fed the
+ * way the DM_SCAN_REPORT_IND handler in uhal_ble.c feeds it, with the scanner
+ * task polling uhal_ble_scan_batch_collect() on the wait it returns.
+ * Covers the address/RSSI/manufacturer/UUID filters, the dedup window, batch
+ * aggregation, the cache-full and scan-stop cases, and reports user callbacks
+ * per second and CPU time per advertisement under a synthetic storm.
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "uhal_ble_scan.h"
+#include "dm_api.h"
+#include "task.h"
+#include "udrv_errno.h"
+#include "test.h"
+
+static uint32_t now_ms;
+static uint32_t reports;        // per-report callbacks
+static uint32_t batches;        // batch callbacks
+static uint32_t batch_entries;
+static udrv_ble_scan_batch_entry_t last_batch[SCAN_CACHE_SIZE];
+static uint16_t last_batch_num;
+
+TickType_t xTaskGetTickCount(void)
+{
+    return now_ms;
+}
+
+static void batch_handler(udrv_ble_scan_batch_entry_t *entries, uint16_t num)
+{
+    batches++;
+    batch_entries += num;
+    memcpy(last_batch, entries, num * sizeof(entries[0]));
+    last_batch_num = num;
+}
+
+// DM_SCAN_REPORT_IND in uhal_ble.c, with a per-report handler registered.
+static void report(int8_t rssi, uint8_t *mac, uint8_t *adv, uint8_t len)
+{
+    if (len == 0 || !uhal_ble_scan_filter_accept(rssi, mac, adv, len))
+        return;
+    if (uhal_ble_scan_batch_enabled())
+    {
+        uhal_ble_scan_batch_add(rssi, mac, adv, len);
+        return;
+    }
+    if (uhal_ble_scan_dedup_check(mac, now_ms))
+        reports++;
+}
+
+// One pass of the scanner task, returns the time it sleeps for.
+static uint32_t scanner_poll(void)
+{
+    uint32_t wait_ms;
+    uint16_t num = uhal_ble_scan_batch_collect(now_ms, &wait_ms);
+
+    uhal_ble_scan_batch_deliver(num);
+    return wait_ms;
+}
+
+static void mac_of(uint8_t *mac, uint32_t id)
+{
+    mac[0] = id;
+    mac[1] = id >> 8;
+    mac[2] = 0x5a;
+    mac[3] = 0xc1;
+    mac[4] = 0x0d;
+    mac[5] = 0xe4;
+}
+
+static void reset(void)
+{
+    uhal_ble_scan_filter_clear();
+    uhal_ble_scan_set_batch(0, NULL);
+    uhal_ble_scan_set_dedup_window(0);
+    uhal_ble_scan_set_active(true);
+    reports = batches = batch_entries = last_batch_num = 0;
+}
+
+static void test_filter(void)
+{
+    uint8_t a[6], b[6];
+    uint8_t flags[] = {2, DM_ADV_TYPE_FLAGS, 0x06};
+    uint8_t mfr[] = {2, 0x01, 0x06, 5, 0xff, 0x34, 0x12, 0xaa, 0xbb};
+    uint8_t uuid16[] = {5, 0x03, 0x0a, 0x18, 0x0f, 0x18};
+    uint8_t svc16[] = {4, 0x16, 0x0f, 0x18, 0x55};
+    uint8_t uuid128[18] = {17, 0x07};
+    uint8_t both[] = {5, 0xff, 0x34, 0x12, 0xaa, 0xbb, 3, 0x02, 0x0f, 0x18};
+    uint8_t bad[] = {9, 0xff, 0x34, 0x12};
+    uint8_t want16[] = {0x0f, 0x18};
+    uint8_t want128[16];
+
+    for (int i = 0; i < 16; i++)
+        uuid128[2 + i] = want128[i] = 0x10 + i;
+    mac_of(a, 1);
+    mac_of(b, 2);
+
+    reset();
+    CHECK(uhal_ble_scan_filter_accept(-90, a, flags, sizeof(flags)), "no filter rejected a report");
+
+    uhal_ble_scan_filter_set_rssi(-70);
+    CHECK(!uhal_ble_scan_filter_accept(-71, a, flags, sizeof(flags)), "RSSI below the threshold accepted");
+    CHECK(uhal_ble_scan_filter_accept(-70, a, flags, sizeof(flags)), "RSSI at the threshold rejected");
+
+    reset();
+    uhal_ble_scan_filter_add_address(b);
+    CHECK(!uhal_ble_scan_filter_accept(-50, a, flags, sizeof(flags)), "address not in the list accepted");
+    CHECK(uhal_ble_scan_filter_accept(-50, b, flags, sizeof(flags)), "listed address rejected");
+    for (int i = 1; i < SCAN_FILTER_ADDR_MAX; i++)
+        CHECK(uhal_ble_scan_filter_add_address(a) == UDRV_RETURN_OK, "address %d not added", i);
+    CHECK(uhal_ble_scan_filter_add_address(a) == -UDRV_BUFF_OVERFLOW, "address list overflowed");
+
+    reset();
+    uhal_ble_scan_filter_set_manufacturer_id(0x1234);
+    CHECK(uhal_ble_scan_filter_accept(-50, a, mfr, sizeof(mfr)), "matching company ID rejected");
+    CHECK(!uhal_ble_scan_filter_accept(-50, a, flags, sizeof(flags)), "report without company ID accepted");
+    CHECK(!uhal_ble_scan_filter_accept(-50, a, bad, sizeof(bad)), "truncated AD structure accepted");
+
+    reset();
+    uhal_ble_scan_filter_set_service_uuid(want16, 2);
+    CHECK(uhal_ble_scan_filter_accept(-50, a, uuid16, sizeof(uuid16)), "16-bit UUID in the list rejected");
+    CHECK(uhal_ble_scan_filter_accept(-50, a, svc16, sizeof(svc16)), "16-bit service data rejected");
+    CHECK(!uhal_ble_scan_filter_accept(-50, a, mfr, sizeof(mfr)), "report without UUID accepted");
+    CHECK(uhal_ble_scan_filter_set_service_uuid(want16, 4) == -UDRV_WRONG_ARG, "UUID length 4 accepted");
+
+    reset();
+    uhal_ble_scan_filter_set_service_uuid(want128, 16);
+    CHECK(uhal_ble_scan_filter_accept(-50, a, uuid128, sizeof(uuid128)), "128-bit UUID rejected");
+    uuid128[17] ^= 1;
+    CHECK(!uhal_ble_scan_filter_accept(-50, a, uuid128, sizeof(uuid128)), "other 128-bit UUID accepted");
+
+    reset();
+    uhal_ble_scan_filter_set_manufacturer_id(0x1234);
+    uhal_ble_scan_filter_set_service_uuid(want16, 2);
+    CHECK(uhal_ble_scan_filter_accept(-50, a, both, sizeof(both)), "company ID and UUID rejected");
+    CHECK(!uhal_ble_scan_filter_accept(-50, a, mfr, sizeof(mfr)), "company ID alone passed both filters");
+    reset();
+}
+
+static void test_dedup(void)
+{
+    uint8_t mac[6], adv[] = {2, DM_ADV_TYPE_FLAGS, 0x06};
+
+    reset();
+    now_ms = 1000;
+    uhal_ble_scan_set_dedup_window(500);
+    mac_of(mac, 7);
+    report(-60, mac, adv, sizeof(adv));
+    now_ms += 499;
+    report(-60, mac, adv, sizeof(adv));
+    CHECK(reports == 1, "device reported %u times within the window", reports);
+    now_ms += 1;
+    report(-60, mac, adv, sizeof(adv));
+    CHECK(reports == 2, "device not reported again after the window (%u)", reports);
+
+    // More devices than the cache holds: each still reported at most once per window.
+    reports = 0;
+    for (int round = 0; round < 3; round++)
+    {
+        for (int id = 0; id < 3 * SCAN_CACHE_SIZE; id++)
+        {
+            mac_of(mac, 100 + id);
+            report(-60, mac, adv, sizeof(adv));
+        }
+        now_ms += 10;
+    }
+    CHECK(reports <= 3 * 3 * SCAN_CACHE_SIZE && reports >= 3 * SCAN_CACHE_SIZE,
+          "%u reports for %d devices seen 3 times", reports, 3 * SCAN_CACHE_SIZE);
+    reset();
+}
+
+static void test_batch(void)
+{
+    uint8_t mac[6], adv[] = {2, DM_ADV_TYPE_FLAGS, 0x06};
+    uint32_t wait;
+
+    reset();
+    now_ms = 10000;
+    uhal_ble_scan_set_active(false);
+    CHECK(uhal_ble_scan_set_batch(1000, NULL) == -UDRV_WRONG_ARG, "batch without handler accepted");
+    uhal_ble_scan_set_batch(1000, batch_handler);
+    CHECK(scanner_poll() == UINT32_MAX, "scanner task wakes up without a scan running");
+
+    uhal_ble_scan_set_active(true);
+    CHECK(scanner_poll() == 1000, "first batch not due after one interval");
+    mac_of(mac, 1);
+    report(-40, mac, adv, sizeof(adv));
+    report(-80, mac, adv, sizeof(adv));
+    report(-60, mac, adv, sizeof(adv));
+    mac_of(mac, 2);
+    report(-70, mac, adv, sizeof(adv));
+    now_ms += 400;
+    wait = scanner_poll();
+    CHECK(wait == 600 && batches == 0, "batch delivered early (wait %u, %u batches)", wait, batches);
+
+    // Dedup settings do not touch the batch in progress.
+    uhal_ble_scan_set_dedup_window(100);
+    now_ms += 600;
+    wait = scanner_poll();
+    CHECK(wait == 1000 && batches == 1 && last_batch_num == 2, "batch: wait %u, %u batches of %u",
+          wait, batches, last_batch_num);
+    for (int i = 0; i < last_batch_num; i++)
+    {
+        udrv_ble_scan_batch_entry_t *e = &last_batch[i];
+
+        if (e->mac_addr[0] == 1)
+            CHECK(e->count == 3 && e->rssi_min == -80 && e->rssi_max == -40 && e->rssi_avg == -60,
+                  "device 1: count %u RSSI %d/%d/%d", e->count, e->rssi_min, e->rssi_max, e->rssi_avg);
+        else
+            CHECK(e->count == 1 && e->rssi_avg == -70, "device 2: count %u RSSI %d", e->count, e->rssi_avg);
+    }
+    CHECK(reports == 0, "per-report callbacks while batching");
+
+    // A full cache drops new devices until the next batch.
+    for (int id = 0; id < SCAN_CACHE_SIZE + 8; id++)
+    {
+        mac_of(mac, 100 + id);
+        report(-50, mac, adv, sizeof(adv));
+    }
+    now_ms += 1000;
+    scanner_poll();
+    CHECK(last_batch_num == SCAN_CACHE_SIZE, "full cache batch has %u entries", last_batch_num);
+
+    // Stop flushes the partial batch and the task sleeps until the next start.
+    mac_of(mac, 3);
+    report(-50, mac, adv, sizeof(adv));
+    now_ms += 100;
+    uhal_ble_scan_set_active(false);
+    wait = scanner_poll();
+    CHECK(wait == UINT32_MAX && batches == 3 && last_batch_num == 1,
+          "scan stop: wait %u, %u batches, last %u entries", wait, batches, last_batch_num);
+    CHECK(scanner_poll() == UINT32_MAX && batches == 3, "scanner task woke up after scan stop");
+    reset();
+}
+
+static double cpu_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Synthetic storm: devices advertising every 100 ms with jitter for 60 s of
+// virtual time, returns user callbacks per second and stores the CPU time per
+// advertisement spent in the stack task.
+static double storm(int devices, uint32_t dedup_ms, uint32_t batch_ms, double *ns_per_adv)
+{
+    static uint8_t macs[256][6];
+    static int8_t rssi[256];
+    uint8_t adv[] = {2, DM_ADV_TYPE_FLAGS, 0x06, 5, 0xff, 0x34, 0x12, 0xaa, 0xbb};
+    uint32_t next_poll, advs = 0, end;
+    double cpu = 0, t;
+
+    reset();
+    uhal_ble_scan_set_dedup_window(dedup_ms);
+    if (batch_ms != 0)
+        uhal_ble_scan_set_batch(batch_ms, batch_handler);
+    srand(devices);
+    now_ms = 100000;
+    end = now_ms + 60000;
+    next_poll = now_ms + scanner_poll();
+    for (; now_ms < end; now_ms++)
+    {
+        int n = 0;
+
+        // Each device advertises on average every 100 ms.
+        for (int id = 0; id < devices; id++)
+        {
+            if (rand() % 100 == 0)
+            {
+                mac_of(macs[n], id);
+                rssi[n++] = -40 - rand() % 50;
+            }
+        }
+        t = cpu_ns();
+        for (int i = 0; i < n; i++)
+            report(rssi[i], macs[i], adv, sizeof(adv));
+        cpu += cpu_ns() - t;
+        advs += n;
+        if (batch_ms != 0 && now_ms >= next_poll)
+            next_poll = now_ms + scanner_poll();
+    }
+    *ns_per_adv = cpu / advs;
+    if (batch_ms != 0)
+        CHECK(batch_entries >= 59 * (uint32_t)((devices < SCAN_CACHE_SIZE) ? devices : SCAN_CACHE_SIZE),
+              "%d devices: %u batch entries in 60 s", devices, batch_entries);
+    return (reports + batches) / 60.0;
+}
+
+int main(void)
+{
+    double raw, dedup, batch, raw_ns, dedup_ns, batch_ns;
+
+    test_filter();
+    test_dedup();
+    test_batch();
+
+    raw = storm(24, 0, 0, &raw_ns);
+    dedup = storm(24, 1000, 0, &dedup_ns);
+    batch = storm(24, 0, 1000, &batch_ns);
+    printf("ble_scan: 24 devices at 10 Hz, callbacks/s %.0f raw, %.0f with 1 s dedup, %.0f with 1 s batch; "
+           "%.0f/%.0f/%.0f ns per advertisement\n", raw, dedup, batch, raw_ns, dedup_ns, batch_ns);
+    storm(200, 1000, 0, &dedup_ns);
+    storm(200, 0, 1000, &batch_ns);
+    printf("ble_scan: 200 devices at 10 Hz, %.0f ns per advertisement with dedup, %.0f with batch\n",
+           dedup_ns, batch_ns);
+
+    TEST_DONE("ble_scan");
+}
@@ -0,0 +1,790 @@
+/*
+ * Class B beacon tracking and ping slots on a virtual clock, US915.
+ *
+ * A simulated gateway sends a beacon every 128 s on the US915 beacon channel
+ * plan and loses one of them. The device acquires the first beacon and opens
+ * its unicast ping slots plus the slots of two multicast groups, one on the
+ * floor-plan channel and one on a fixed frequency. Halfway through a beacon
+ * period the floor-plan group is deleted, a new group takes its place and the
+ * fixed-frequency group gets another periodicity, the way the multicast setup
+ * calls in LoRaMac.c change them, each followed by the slot cache reset.
+ *
+ * Every window the MAC opens is logged with its time and frequency and has to
+ * match the ping offset, period and floor-plan channel of LoRaWAN 1.0.4,
+ * computed here from scratch, for one of the addresses configured during that
+ * beacon period. The same schedule then runs again with the slot cache dropped
+ * before every LoRaMacClassBProcess(), so every slot computes its offset and
+ * channel again as before the cache, and both timelines have to be the same.
+ * Reports the AES blocks and the CPU time per window of either run.
+ */
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "LoRaMac.h"
+#include "LoRaMacClassB.h"
+#include "LoRaMacClassBConfig.h"
+#include "LoRaMacConfirmQueue.h"
+#include "Region.h"
+#include "RegionNvm.h"
+#include "secure-element.h"
+#include "radio.h"
+#include "rtc-board.h"
+#include "aes.h"
+#include "test.h"
+
+#define DEV_ADDR            0x26011234
+#define UNICAST_PERIODICITY 5
+#define FIRST_BEACON        1399999488  // GPS seconds, on beacon channel 0
+#define FIRST_BEACON_AT     60000       // local ms when its preamble starts
+#define PERIODS             8
+#define LOST_BEACON         3           // the gateway sends no beacon in this period
+#define CHANGE_PERIOD       5           // multicast groups change in this period
+#define CHANGE_AT           50000       // ms into CHANGE_PERIOD
+#define MIN_RX_SYMBOLS      6
+#define MAX_RX_ERROR        10
+#define MAX_WINDOWS         4096
+#define BEACON_PREAMBLE     10
+
+#define BEACON_FREQ         923300000
+#define BEACON_STEP         600000
+
+//
+// Virtual RTC, one tick per millisecond
+//
+
+static uint32_t now;
+static uint32_t timer_context;
+static uint32_t alarm_at;
+static bool alarm_armed;
+static uint32_t bkup[2];
+
+void BoardCriticalSectionBegin(uint32_t *mask)
+{
+}
+
+void BoardCriticalSectionEnd(uint32_t *mask)
+{
+}
+
+void RtcInit(void)
+{
+}
+
+uint32_t RtcGetMinimumTimeout(void)
+{
+    return 1;
+}
+
+uint32_t RtcMs2Tick(TimerTime_t milliseconds)
+{
+    return milliseconds;
+}
+
+TimerTime_t RtcTick2Ms(uint32_t tick)
+{
+    return tick;
+}
+
+void RtcDelayMs(TimerTime_t milliseconds)
+{
+    now += milliseconds;
+}
+
+void RtcSetAlarm(uint32_t timeout)
+{
+    alarm_at = timer_context + timeout;
+    alarm_armed = true;
+}
+
+void RtcStartAlarm(uint32_t timeout)
+{
+    RtcSetAlarm(timeout);
+}
+
+void RtcStopAlarm(void)
+{
+    alarm_armed = false;
+}
+
+uint32_t RtcSetTimerContext(void)
+{
+    timer_context = now;
+    return timer_context;
+}
+
+uint32_t RtcGetTimerContext(void)
+{
+    return timer_context;
+}
+
+uint32_t RtcGetCalendarTime(uint16_t *milliseconds)
+{
+    *milliseconds = now % 1000;
+    return now / 1000;
+}
+
+uint32_t RtcGetTimerValue(void)
+{
+    return now;
+}
+
+uint32_t RtcGetTimerElapsedTime(void)
+{
+    return now - timer_context;
+}
+
+void RtcBkupWrite(uint32_t data0, uint32_t data1)
+{
+    bkup[0] = data0;
+    bkup[1] = data1;
+}
+
+void RtcBkupRead(uint32_t *data0, uint32_t *data1)
+{
+    *data0 = bkup[0];
+    *data1 = bkup[1];
+}
+
+void RtcProcess(void)
+{
+}
+
+TimerTime_t RtcTempCompensation(TimerTime_t period, float temperature)
+{
+    return period;
+}
+
+//
+// Secure element and confirm queue, only what Class B asks for
+//
+
+static int aes_blocks;
+static bool ping_slot_info_pending;
+
+SecureElementStatus_t SecureElementAesEncrypt(uint8_t *buffer, uint16_t size, KeyIdentifier_t keyID,
+                                              uint8_t *encBuffer)
+{
+    static const uint8_t zero_key[16];
+    aes_context ctx;
+
+    CHECK(keyID == SLOT_RAND_ZERO_KEY && size == 16, "AES with key %d, %u bytes", keyID, size);
+    aes_set_key(zero_key, 16, &ctx);
+    aes_encrypt(buffer, encBuffer, &ctx);
+    aes_blocks++;
+    return SECURE_ELEMENT_SUCCESS;
+}
+
+bool LoRaMacConfirmQueueIsCmdActive(Mlme_t request)
+{
+    return request == MLME_PING_SLOT_INFO && ping_slot_info_pending;
+}
+
+void LoRaMacConfirmQueueSetStatus(LoRaMacEventInfoStatus_t status, Mlme_t request)
+{
+    if (request == MLME_PING_SLOT_INFO)
+        ping_slot_info_pending = false;
+}
+
+//
+// LoRaWAN 1.0.4 Class B, computed independently of the MAC
+//
+
+static uint32_t beacon_at(int period)
+{
+    return FIRST_BEACON_AT + period * 128000;
+}
+
+static uint32_t beacon_time(int period)
+{
+    return FIRST_BEACON + period * 128;
+}
+
+static uint32_t beacon_freq(uint32_t time)
+{
+    return BEACON_FREQ + (time / 128) % 8 * BEACON_STEP;
+}
+
+static uint32_t ping_freq(uint32_t time, uint32_t address)
+{
+    return BEACON_FREQ + (address + time / 128) % 8 * BEACON_STEP;
+}
+
+static uint16_t ping_offset(uint32_t time, uint32_t address, uint16_t period)
+{
+    static const uint8_t zero_key[16];
+    aes_context ctx;
+    uint8_t block[16] = { time & 0xFF, (time >> 8) & 0xFF, (time >> 16) & 0xFF, time >> 24,
+                          address & 0xFF, (address >> 8) & 0xFF, (address >> 16) & 0xFF, address >> 24 };
+    uint8_t rand[16];
+
+    aes_set_key(zero_key, 16, &ctx);
+    aes_encrypt(block, rand, &ctx);
+    return (rand[0] + rand[1] * 256) % period;
+}
+
+static uint16_t beacon_crc(const uint8_t *buf, uint16_t len)
+{
+    uint16_t crc = 0;
+
+    for (uint16_t i = 0; i < len; i++)
+    {
+        crc ^= buf[i] << 8;
+        for (int j = 0; j < 8; j++)
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+// RFU | Param | Time | CRC | GwSpecific | RFU | CRC
+static uint8_t beacon_frame(uint32_t time, uint8_t *frame)
+{
+    GetPhyParams_t get = { .Attribute = PHY_BEACON_FORMAT };
+    PhyParam_t format = RegionGetPhyParam(LORAMAC_REGION_US915, &get);
+    uint8_t rfu1 = format.BeaconFormat.Rfu1Size;
+    uint8_t rfu2 = format.BeaconFormat.Rfu2Size;
+    uint16_t crc;
+
+    memset(frame, 0, format.BeaconFormat.BeaconSize);
+    frame[rfu1 + 1] = time & 0xFF;
+    frame[rfu1 + 2] = (time >> 8) & 0xFF;
+    frame[rfu1 + 3] = (time >> 16) & 0xFF;
+    frame[rfu1 + 4] = time >> 24;
+    crc = beacon_crc(frame, rfu1 + 5);
+    frame[rfu1 + 5] = crc & 0xFF;
+    frame[rfu1 + 6] = crc >> 8;
+    crc = beacon_crc(frame + rfu1 + 7, 7 + rfu2);
+    frame[rfu1 + 14 + rfu2] = crc & 0xFF;
+    frame[rfu1 + 15 + rfu2] = crc >> 8;
+    return format.BeaconFormat.BeaconSize;
+}
+
+//
+// Slot owners: the unicast address and every multicast configuration, with
+// the beacon periods it was set up in
+//
+
+static struct {
+    uint32_t address;
+    uint32_t freq;                      // 0 for the floor plan
+    uint8_t periodicity;
+    int first, last;
+    int windows;
+} owners[8];
+static int nb_owners;
+
+static int owner_add(uint32_t address, uint32_t freq, uint8_t periodicity, int first)
+{
+    owners[nb_owners].address = address;
+    owners[nb_owners].freq = freq;
+    owners[nb_owners].periodicity = periodicity;
+    owners[nb_owners].first = first;
+    owners[nb_owners].last = PERIODS;
+    owners[nb_owners].windows = 0;
+    return nb_owners++;
+}
+
+//
+// Radio
+//
+
+static struct {
+    uint32_t at;
+    uint32_t freq;
+    bool beacon;
+} timeline[2][MAX_WINDOWS];
+static int windows[2];
+static int run_mode;                    // 0 with the slot cache, 1 reset before every process
+
+static RadioState_t radio_state = RF_IDLE;
+static uint32_t radio_freq;
+static struct {
+    uint32_t bw;
+    uint32_t sf;
+    uint16_t symb_timeout;
+    bool fix_len;
+    bool continuous;
+} rx_cfg;
+static uint32_t radio_event_at;
+static void (*radio_event)(void);
+static uint8_t beacon[32];
+static uint8_t beacon_len;
+static int beacons;
+
+static uint32_t radio_time_on_air(RadioModems_t modem, uint32_t bandwidth, uint32_t datarate, uint8_t coderate,
+                                  uint16_t preambleLen, bool fixLen, uint8_t payloadLen, bool crcOn)
+{
+    static const uint32_t bw_hz[] = { 125000, 250000, 500000 };
+    double tsym = (double)(1 << datarate) * 1000 / bw_hz[bandwidth];
+    int de = datarate >= 11 && bandwidth == 0;
+    double payload = ceil((8.0 * payloadLen - 4.0 * datarate + 28 + (crcOn ? 16 : 0) - (fixLen ? 20 : 0)) /
+                          (4.0 * (datarate - 2 * de)));
+
+    if (payload < 0)
+        payload = 0;
+    return (uint32_t)ceil((preambleLen + 4.25 + 8 + payload * (coderate + 4)) * tsym);
+}
+
+static void radio_init(RadioEvents_t *events)
+{
+}
+
+static RadioState_t radio_get_status(void)
+{
+    return radio_state;
+}
+
+static void radio_set_modem(RadioModems_t modem)
+{
+}
+
+static void radio_set_channel(uint32_t freq)
+{
+    radio_freq = freq;
+}
+
+static bool radio_is_channel_free(uint32_t freq, uint32_t rxBandwidth, int16_t rssiThresh, uint32_t maxCarrierSenseTime)
+{
+    return true;
+}
+
+static uint32_t radio_random(void)
+{
+    return 0;
+}
+
+static void radio_set_rx_config(RadioModems_t modem, uint32_t bandwidth, uint32_t datarate, uint8_t coderate,
+                                uint32_t bandwidthAfc, uint16_t preambleLen, uint16_t symbTimeout, bool fixLen,
+                                uint8_t payloadLen, bool crcOn, bool freqHopOn, uint8_t hopPeriod,
+                                bool iqInverted, bool rxContinuous)
+{
+    rx_cfg.bw = bandwidth;
+    rx_cfg.sf = datarate;
+    rx_cfg.symb_timeout = symbTimeout;
+    rx_cfg.fix_len = fixLen;
+    rx_cfg.continuous = rxContinuous;
+}
+
+static void radio_set_tx_config(RadioModems_t modem, int8_t power, uint32_t fdev, uint32_t bandwidth,
+                                uint32_t datarate, uint8_t coderate, uint16_t preambleLen, bool fixLen,
+                                bool crcOn, bool freqHopOn, uint8_t hopPeriod, bool iqInverted, uint32_t timeout)
+{
+}
+
+static bool radio_check_rf_frequency(uint32_t frequency)
+{
+    return true;
+}
+
+// What LoRaMac.c does on RxDone for a beacon
+static void radio_rx_done(void)
+{
+    radio_state = RF_IDLE;
+    beacons++;
+    CHECK(LoRaMacClassBRxBeacon(beacon, beacon_len), "beacon at %u ms not taken", now);
+}
+
+// What LoRaMac.c does on RxTimeout in Class B
+static void radio_rx_timeout(void)
+{
+    radio_state = RF_IDLE;
+    if (LoRaMacClassBIsBeaconExpected())
+    {
+        LoRaMacClassBSetBeaconState(BEACON_STATE_TIMEOUT);
+        LoRaMacClassBBeaconTimerEvent(NULL);
+    }
+    if (LoRaMacClassBIsPingExpected())
+    {
+        LoRaMacClassBSetPingSlotState(PINGSLOT_STATE_CALC_PING_OFFSET);
+        LoRaMacClassBPingSlotTimerEvent(NULL);
+    }
+    if (LoRaMacClassBIsMulticastExpected())
+    {
+        LoRaMacClassBSetMulticastSlotState(PINGSLOT_STATE_CALC_PING_OFFSET);
+        LoRaMacClassBMulticastSlotTimerEvent(NULL);
+    }
+}
+
+static void radio_sleep(void)
+{
+    radio_state = RF_IDLE;
+    radio_event = NULL;
+}
+
+// Beacon windows catch a beacon if they open before the last MIN_RX_SYMBOLS of
+// its preamble and its preamble starts before they time out. Ping slot windows
+// never get a downlink and time out after the symbol timeout.
+static void radio_rx(uint32_t timeout)
+{
+    double tsym = (double)(1 << rx_cfg.sf) * 1000 / (125000 << rx_cfg.bw);
+    uint32_t window = rx_cfg.symb_timeout != 0 ? (uint32_t)ceil(rx_cfg.symb_timeout * tsym) : timeout;
+    uint32_t late = (uint32_t)((BEACON_PREAMBLE - MIN_RX_SYMBOLS) * tsym);
+    int m = run_mode;
+
+    radio_state = RF_RX_RUNNING;
+    if (windows[m] < MAX_WINDOWS)
+    {
+        timeline[m][windows[m]].at = now;
+        timeline[m][windows[m]].freq = radio_freq;
+        timeline[m][windows[m]].beacon = rx_cfg.fix_len;
+        windows[m]++;
+    }
+
+    if (rx_cfg.fix_len)
+    {
+        int period = now <= FIRST_BEACON_AT + late ? 0 : (now - FIRST_BEACON_AT - late + 127999) / 128000;
+        uint32_t at = beacon_at(period);
+
+        if (!rx_cfg.continuous)
+            CHECK(radio_freq == beacon_freq(beacon_time(period)), "beacon window at %u ms on %u Hz",
+                  now, radio_freq);
+        if (period != LOST_BEACON && radio_freq == beacon_freq(beacon_time(period)) &&
+            (rx_cfg.continuous || (int32_t)(at - now) <= (int32_t)window))
+        {
+            beacon_len = beacon_frame(beacon_time(period), beacon);
+            radio_event = radio_rx_done;
+            radio_event_at = at + radio_time_on_air(MODEM_LORA, rx_cfg.bw, rx_cfg.sf, 1, BEACON_PREAMBLE, true,
+                                                             beacon_len, false);
+            return;
+        }
+        if (rx_cfg.continuous)
+        {
+            radio_event = NULL;
+            return;
+        }
+    }
+    radio_event = radio_rx_timeout;
+    radio_event_at = now + window;
+}
+
+static void radio_start_cad(void)
+{
+}
+
+static void radio_set_tx_continuous_wave(uint32_t freq, int8_t power, uint16_t time)
+{
+}
+
+static int16_t radio_rssi(RadioModems_t modem)
+{
+    return -120;
+}
+
+static void radio_write(uint32_t addr, uint8_t data)
+{
+}
+
+static uint8_t radio_read(uint32_t addr)
+{
+    return 0;
+}
+
+static void radio_write_buffer(uint32_t addr, uint8_t *buffer, uint8_t size)
+{
+}
+
+static void radio_read_buffer(uint32_t addr, uint8_t *buffer, uint8_t size)
+{
+}
+
+static void radio_set_max_payload_length(RadioModems_t modem, uint8_t max)
+{
+}
+
+static void radio_set_public_network(bool enable)
+{
+}
+
+static uint32_t radio_get_wakeup_time(void)
+{
+    return 1;
+}
+
+static void radio_irq_process(void)
+{
+}
+
+static void radio_set_rx_duty_cycle(uint32_t rxTime, uint32_t sleepTime)
+{
+}
+
+const struct Radio_s Radio = {
+    .Init = radio_init,
+    .GetStatus = radio_get_status,
+    .SetModem = radio_set_modem,
+    .SetChannel = radio_set_channel,
+    .IsChannelFree = radio_is_channel_free,
+    .Random = radio_random,
+    .SetRxConfig = radio_set_rx_config,
+    .SetTxConfig = radio_set_tx_config,
+    .CheckRfFrequency = radio_check_rf_frequency,
+    .TimeOnAir = radio_time_on_air,
+    .Sleep = radio_sleep,
+    .Standby = radio_sleep,
+    .Rx = radio_rx,
+    .StartCad = radio_start_cad,
+    .SetTxContinuousWave = radio_set_tx_continuous_wave,
+    .Rssi = radio_rssi,
+    .Write = radio_write,
+    .Read = radio_read,
+    .WriteBuffer = radio_write_buffer,
+    .ReadBuffer = radio_read_buffer,
+    .SetMaxPayloadLength = radio_set_max_payload_length,
+    .SetPublicNetwork = radio_set_public_network,
+    .GetWakeupTime = radio_get_wakeup_time,
+    .IrqProcess = radio_irq_process,
+    .RxBoosted = radio_rx,
+    .SetRxDutyCycle = radio_set_rx_duty_cycle,
+};
+
+//
+// MAC side and the event loop
+//
+
+static RegionNvmDataGroup1_t region_group1;
+static RegionNvmDataGroup2_t region_group2;
+static Band_t region_bands[REGION_NVM_MAX_NB_BANDS];
+static LoRaMacClassBNvmData_t classb_nvm;
+static MulticastCtx_t multicast[LORAMAC_MAX_MC_CTX];
+static uint32_t downlink_counters[LORAMAC_MAX_MC_CTX];
+static MlmeIndication_t mlme_indication;
+static McpsIndication_t mcps_indication;
+static MlmeConfirm_t mlme_confirm;
+static LoRaMacFlags_t mac_flags;
+static uint32_t dev_addr = DEV_ADDR;
+static LoRaMacRegion_t region = LORAMAC_REGION_US915;
+static LoRaMacParams_t mac_params;
+static ActivationType_t activation = ACTIVATION_TYPE_OTAA;
+
+// Process Class B and advance to the next event until end
+static void run_until(uint32_t end)
+{
+    for (;;)
+    {
+        if (run_mode == 1)
+            LoRaMacClassBResetSlotCache();
+        LoRaMacClassBProcess();
+
+        if (radio_event != NULL && (!alarm_armed || (int32_t)(radio_event_at - alarm_at) <= 0) &&
+            (int32_t)(radio_event_at - end) <= 0)
+        {
+            void (*event)(void) = radio_event;
+
+            if ((int32_t)(radio_event_at - now) > 0)
+                now = radio_event_at;
+            radio_event = NULL;
+            event();
+        }
+        else if (alarm_armed && (int32_t)(alarm_at - end) <= 0)
+        {
+            if ((int32_t)(alarm_at - now) > 0)
+                now = alarm_at;
+            alarm_armed = false;
+            TimerIrqHandler();
+        }
+        else
+        {
+            now = end;
+            return;
+        }
+    }
+}
+
+// What LoRaMacMcChannelSetup() and LoRaMacMcChannelSetupRxParams() do for a Class B group
+static void multicast_setup(uint8_t group, int owner)
+{
+    McChannelParams_t *params = &multicast[group].ChannelParams;
+
+    memset(params, 0, sizeof(*params));
+    params->IsEnabled = true;
+    params->GroupID = (AddressIdentifier_t)group;
+    params->Address = owners[owner].address;
+    params->RxParams.Class = CLASS_B;
+    params->RxParams.Params.ClassB.Frequency = owners[owner].freq;
+    params->RxParams.Params.ClassB.Datarate = DR_8;
+    params->RxParams.Params.ClassB.Periodicity = owners[owner].periodicity;
+    LoRaMacClassBResetSlotCache();
+    LoRaMacClassBSetMulticastPeriodicity(&multicast[group]);
+}
+
+// What LoRaMacMcChannelDelete() does
+static void multicast_delete(uint8_t group)
+{
+    memset(&multicast[group].ChannelParams, 0, sizeof(McChannelParams_t));
+    LoRaMacClassBResetSlotCache();
+}
+
+static void classb_run(int mode)
+{
+    LoRaMacClassBParams_t params = {
+        .MlmeIndication = &mlme_indication,
+        .McpsIndication = &mcps_indication,
+        .MlmeConfirm = &mlme_confirm,
+        .LoRaMacFlags = &mac_flags,
+        .LoRaMacDevAddr = &dev_addr,
+        .LoRaMacRegion = &region,
+        .LoRaMacParams = &mac_params,
+        .MulticastChannels = multicast,
+        .NetworkActivation = &activation,
+    };
+    LoRaMacClassBCallback_t callbacks = { 0 };
+
+    run_mode = mode;
+    now = 1000;
+    alarm_armed = false;
+    radio_event = NULL;
+    radio_state = RF_IDLE;
+    beacons = 0;
+    nb_owners = 0;
+    memset(multicast, 0, sizeof(multicast));
+    for (int i = 0; i < LORAMAC_MAX_MC_CTX; i++)
+        multicast[i].DownLinkCounter = &downlink_counters[i];
+    mac_params.SystemMaxRxError = MAX_RX_ERROR;
+    mac_params.MinRxSymbols = MIN_RX_SYMBOLS;
+    mac_params.MaxRxWindow = 3000;
+
+    LoRaMacClassBInit(&params, &callbacks, &classb_nvm);
+
+    owner_add(DEV_ADDR, 0, UNICAST_PERIODICITY, 0);
+    multicast_setup(0, owner_add(0x01A20001, 0, 3, 0));
+    multicast_setup(1, owner_add(0x01A20002, BEACON_FREQ + 2 * BEACON_STEP, 1, 0));
+
+    LoRaMacClassBSetPingSlotInfo(UNICAST_PERIODICITY);
+    ping_slot_info_pending = true;
+    LoRaMacClassBPingSlotInfoAns();
+    CHECK(!ping_slot_info_pending, "PingSlotInfoAns not confirmed");
+
+    LoRaMacClassBSetBeaconState(BEACON_STATE_ACQUISITION);
+    LoRaMacClassBBeaconTimerEvent(NULL);
+    run_until(beacon_at(CHANGE_PERIOD) + CHANGE_AT);
+
+    // Group 0 replaced by another address, group 1 gets fewer slots
+    owners[1].last = CHANGE_PERIOD;
+    owners[2].last = CHANGE_PERIOD;
+    multicast_delete(0);
+    multicast_setup(0, owner_add(0x01A20003, 0, 2, CHANGE_PERIOD));
+    multicast_setup(1, owner_add(0x01A20002, BEACON_FREQ + 2 * BEACON_STEP, 3, CHANGE_PERIOD));
+    run_until(beacon_at(PERIODS));
+
+    CHECK(beacons == PERIODS - 1, "%d beacons received", beacons);
+    LoRaMacClassBHaltBeaconing();
+}
+
+//
+// Tests
+//
+
+// Whether a window opening lead ms before a slot of owner o in the period fits
+static bool owner_slot(int o, int period, uint32_t at, uint32_t freq, int32_t lead)
+{
+    uint32_t time = beacon_time(period);
+    uint16_t ping_period = 32 << owners[o].periodicity;
+    uint32_t slot = CLASSB_BEACON_RESERVED + ping_offset(time, owners[o].address, ping_period) * 30;
+    int32_t rel = (int32_t)(at - beacon_at(period) + lead - slot);
+
+    if (period < owners[o].first || period > owners[o].last || rel < 0)
+        return false;
+    if (freq != (owners[o].freq != 0 ? owners[o].freq : ping_freq(time, owners[o].address)))
+        return false;
+    return rel % (ping_period * 30) == 0 && rel / (ping_period * 30) < (128 >> owners[o].periodicity);
+}
+
+// Every ping slot window has to open for one of the owners of its period. With
+// the beacon locked the window opens early by the wakeup time and the window
+// offset, without it by the wakeup time only. A multicast slot already
+// scheduled when its group changes still opens once with the new parameters,
+// the MAC recomputes the offsets after it.
+static void check_timeline(void)
+{
+    RxConfigParams_t rx;
+    int32_t lead, lead_unlocked;
+    int slots = 0;
+    int stale = 0;
+
+    RegionComputeRxWindowParameters(region, DR_8, MIN_RX_SYMBOLS, MAX_RX_ERROR, &rx);
+    lead = radio_get_wakeup_time() - rx.WindowOffset;
+    lead_unlocked = radio_get_wakeup_time();
+
+    for (int i = 0; i < windows[0]; i++)
+    {
+        uint32_t at = timeline[0][i].at;
+        uint32_t freq = timeline[0][i].freq;
+        int period = at < FIRST_BEACON_AT ? -1 : (at - FIRST_BEACON_AT) / 128000;
+        bool found = false;
+
+        if (timeline[0][i].beacon)
+            continue;
+        slots++;
+        CHECK(period >= 0, "ping slot at %u ms before the first beacon", at);
+        if (period < 0)
+            continue;
+
+        for (int o = 0; o < nb_owners; o++)
+        {
+            if (owner_slot(o, period, at, freq, lead) ||
+                (period == LOST_BEACON && owner_slot(o, period, at, freq, lead_unlocked)))
+            {
+                owners[o].windows++;
+                found = true;
+            }
+        }
+        if (!found && period == CHANGE_PERIOD && at - beacon_at(period) > CHANGE_AT && stale++ == 0)
+            continue;
+        CHECK(found, "ping slot in period %d at +%u ms on %u Hz matches no slot", period, at - beacon_at(period),
+              freq);
+    }
+
+    for (int o = 0; o < nb_owners; o++)
+        CHECK(owners[o].windows > 0, "no window for %08x periodicity %u", owners[o].address, owners[o].periodicity);
+    CHECK(slots > 100, "%d ping slot windows", slots);
+}
+
+// Cached and per-slot offsets and channels open the same windows
+static void check_same_timeline(void)
+{
+    int n = windows[0] < windows[1] ? windows[0] : windows[1];
+
+    CHECK(windows[0] == windows[1], "%d windows with the slot cache, %d without", windows[0], windows[1]);
+    for (int i = 0; i < n; i++)
+    {
+        if (timeline[0][i].at != timeline[1][i].at || timeline[0][i].freq != timeline[1][i].freq ||
+            timeline[0][i].beacon != timeline[1][i].beacon)
+        {
+            CHECK(false, "window %d at %u ms on %u Hz with the slot cache, at %u ms on %u Hz without", i,
+                  timeline[0][i].at, timeline[0][i].freq, timeline[1][i].at, timeline[1][i].freq);
+            break;
+        }
+    }
+}
+
+int main(void)
+{
+    InitDefaultsParams_t init = { .NvmGroup1 = &region_group1, .NvmGroup2 = &region_group2, .Bands = region_bands };
+    struct timespec t0, t1, t2;
+    int aes[2];
+    double cpu[2];
+
+    init.Type = INIT_TYPE_DEFAULTS;
+    RegionInitDefaults(region, &init);
+
+    aes_blocks = 0;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t0);
+    classb_run(0);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t1);
+    aes[0] = aes_blocks;
+    check_timeline();
+
+    aes_blocks = 0;
+    classb_run(1);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t2);
+    aes[1] = aes_blocks;
+    check_same_timeline();
+
+    CHECK(windows[0] < MAX_WINDOWS, "timeline full");
+    CHECK(aes[0] <= PERIODS * LORAMAC_MAX_MC_CTX, "%d AES blocks with the slot cache", aes[0]);
+    cpu[0] = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / 1000 / windows[0];
+    cpu[1] = ((t2.tv_sec - t1.tv_sec) * 1e9 + (t2.tv_nsec - t1.tv_nsec)) / 1000 / windows[1];
+    printf("classb: %d windows in %d beacon periods, %d vs %d AES blocks, %.2f vs %.2f us CPU per window "
+           "with the slot cache vs per slot\n", windows[0], PERIODS, aes[0], aes[1], cpu[0], cpu[1]);
+    TEST_DONE("classb");
+}
@@ -0,0 +1,9 @@
+/* Host stand-in for service/nvm/service_nvm.h, only what the CLI mode uses */
+#ifndef __SERVICE_NVM_H__
+#define __SERVICE_NVM_H__
+
+#include <stdint.h>
+
+uint8_t service_nvm_get_atcmd_echo_from_nvm(void);
+
+#endif
@@ -0,0 +1,243 @@
+/*
+ * CLI command history: up/down recall, prefix search, repeat suppression and
+ * eviction by entry count and by arena space, including entries that wrap
+ * around the end of the arena.
+ */
+#include <stdint.h>
+#include <stdarg.h>
+#include "service_mode_cli.h"
+#include "service_nvm.h"
+#include "test.h"
+
+at_cmd_cust_info atcmd_cust_tbl[ATCMD_CUST_TABLE_SIZE];
+
+static char parsed[CLI_BUFFER_SIZE + 1];
+static char screen[CLI_BUFFER_SIZE + 1];
+static uint32_t cursor;
+
+/* Echo goes to a one-line terminal, the line is what sits left of the cursor */
+int32_t udrv_serial_cli_write(SERIAL_PORT Port, uint8_t const *Buffer, int32_t NumberOfBytes)
+{
+    for (int32_t i = 0; i < NumberOfBytes; i++)
+    {
+        if (Buffer[i] == 0x08)
+            cursor -= (cursor > 0);
+        else if (Buffer[i] == '\r' || Buffer[i] == '\n')
+            cursor = 0;
+        else if (cursor < CLI_BUFFER_SIZE)
+            screen[cursor++] = Buffer[i];
+    }
+    screen[cursor] = 0;
+    return NumberOfBytes;
+}
+
+void udrv_serial_cli_hold(SERIAL_PORT Port)
+{
+}
+
+int32_t udrv_serial_cli_flush(SERIAL_PORT Port)
+{
+    return 0;
+}
+
+int32_t udrv_serial_read_available(SERIAL_PORT Port)
+{
+    return 0;
+}
+
+int32_t udrv_serial_log_printf(const char *fmt, ...)
+{
+    return 0;
+}
+
+uint8_t service_nvm_get_atcmd_echo_from_nvm(void)
+{
+    return 1;
+}
+
+void update_permission()
+{
+}
+
+int At_Parser(SERIAL_PORT port, char *buff, int len)
+{
+    memcpy(parsed, buff, len);
+    parsed[len] = 0;
+    return 0;
+}
+
+static void type(const char *s)
+{
+    while (*s)
+        service_mode_cli_handler(SERIAL_UART0, (uint8_t)*s++);
+}
+
+static void up(int n)
+{
+    while (n--)
+        type("\x1b[A");
+}
+
+static void down(int n)
+{
+    while (n--)
+        type("\x1b[B");
+}
+
+static void run(const char *cmd)
+{
+    type(cmd);
+    type("\r");
+}
+
+/* Read the line on screen and erase it without submitting it */
+static const char *line(void)
+{
+    static char copy[CLI_BUFFER_SIZE + 1];
+
+    strcpy(copy, screen);
+    for (size_t i = strlen(copy); i > 0; i--)
+        type("\x7f");
+    return copy;
+}
+
+/* Type prefix, press up n times and read the line */
+static const char *recall(const char *prefix, int n)
+{
+    type(prefix);
+    up(n);
+    return line();
+}
+
+static void test_recall(void)
+{
+    run("AT+A");
+    run("AT+B");
+    run("AT+B");
+    run("AT+CA");
+    run("AT+X");
+
+    //The repeated AT+B was stored once
+    CHECK(!strcmp(recall("", 1), "AT+X"), "newest");
+    CHECK(!strcmp(recall("", 2), "AT+CA"), "second newest");
+    CHECK(!strcmp(recall("", 3), "AT+B"), "third newest");
+    CHECK(!strcmp(recall("", 4), "AT+A"), "oldest");
+    CHECK(!strcmp(recall("", 100), "AT+A"), "past the oldest");
+
+    //Down walks back to newer entries and finally to the typed line
+    type("AT+");
+    up(3);
+    down(1);
+    CHECK(!strcmp(line(), "AT+CA"), "down");
+    type("AT+");
+    up(2);
+    down(2);
+    CHECK(!strcmp(line(), "AT+"), "down to the typed line");
+
+    //A recalled command that is run again becomes the newest entry
+    up(3);
+    type("\r");
+    CHECK(!strcmp(parsed, "AT+B"), "recalled command not run");
+    CHECK(!strcmp(recall("", 1), "AT+B") && !strcmp(recall("", 2), "AT+X"), "rerun not recorded");
+}
+
+static void test_prefix(void)
+{
+    run("AT+CB");
+    run("AT+D");
+
+    CHECK(!strcmp(recall("AT+C", 1), "AT+CB"), "prefix newest");
+    CHECK(!strcmp(recall("AT+C", 2), "AT+CA"), "prefix older");
+    CHECK(!strcmp(recall("AT+C", 9), "AT+CA"), "past the oldest prefix match");
+
+    //No match keeps the typed line
+    CHECK(!strcmp(recall("AT+Q", 1), "AT+Q"), "no prefix match");
+
+    //Editing a recalled line starts a new search from it
+    type("AT+");
+    up(1);
+    type("\x7f");
+    CHECK(!strcmp(recall("C", 1), "AT+CB"), "search after edit");
+}
+
+static void test_count(void)
+{
+    char cmd[32];
+
+    for (int i = 0; i < CLI_HISTORY_NUM + 10; i++)
+    {
+        snprintf(cmd, sizeof(cmd), "AT+N%d", i);
+        run(cmd);
+    }
+
+    snprintf(cmd, sizeof(cmd), "AT+N%d", 10);
+    CHECK(!strcmp(recall("", CLI_HISTORY_NUM), cmd), "oldest of a full history");
+    CHECK(!strcmp(recall("", CLI_HISTORY_NUM + 1), cmd), "evicted entry recalled");
+}
+
+static void long_cmd(char *cmd, int i)
+{
+    int len = 100 + (i * 37) % 500;
+
+    snprintf(cmd, 9, "AT+L%03d=", i);
+    memset(cmd + 8, 'a' + i % 26, len - 8);
+    cmd[len] = 0;
+}
+
+static void test_arena(void)
+{
+    static char cmd[CLI_BUFFER_SIZE];
+
+    //Long lines of varying length wrap around the arena many times
+    for (int i = 0; i < 200; i++)
+    {
+        int total = 0;
+        int held = 0;
+        bool full = false;
+
+        long_cmd(cmd, i);
+        run(cmd);
+        CHECK(!strcmp(parsed, cmd), "long line %d", i);
+
+        //Every entry that fits is still held and comes back intact
+        for (int n = 1; n <= CLI_HISTORY_NUM && n <= i + 1; n++)
+        {
+            long_cmd(cmd, i + 1 - n);
+            total += strlen(cmd);
+            if (total > CLI_HISTORY_ARENA_SIZE)
+            {
+                full = true;
+                break;
+            }
+            CHECK(!strcmp(recall("", n), cmd), "entry %d after line %d", n, i);
+            held = n;
+        }
+
+        //and nothing older is
+        if (full)
+        {
+            long_cmd(cmd, i + 1 - held);
+            CHECK(!strcmp(recall("", held + 1), cmd), "stale entry after line %d", i);
+        }
+    }
+
+    //A line as long as the input buffer fills the arena alone
+    memset(cmd, 'z', CLI_BUFFER_SIZE - 1);
+    cmd[CLI_BUFFER_SIZE - 1] = 0;
+    memcpy(cmd, "AT+Z=", 5);
+    run(cmd);
+    CHECK(!strcmp(recall("", 1), cmd), "full-size line");
+    run("AT+Y");
+    CHECK(!strcmp(recall("", 2), "AT+Y"), "full-size line not evicted");
+}
+
+int main(void)
+{
+    service_mode_cli_init(SERIAL_UART0);
+
+    test_recall();
+    test_prefix();
+    test_count();
+    test_arena();
+    TEST_DONE("cli_history");
+}
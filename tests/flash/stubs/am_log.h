@@ -0,0 +1,5 @@
+/* Host stand-in for the Ambiq log, nothing of it is used. */
+#ifndef _AM_LOG_H_
+#define _AM_LOG_H_
+
+#endif  // #ifndef _AM_LOG_H_
@@ -0,0 +1,9 @@
+/* Host stand-in for the Apollo3 HAL, the flash is simulated by the test
+ * behind uhal_flash.h. */
+#ifndef _AM_MCU_APOLLO_H_
+#define _AM_MCU_APOLLO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#endif  // #ifndef _AM_MCU_APOLLO_H_
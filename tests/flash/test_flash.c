@@ -0,0 +1,445 @@
+/*
+ * Flash driver on a simulated 1 MB flash of 8 kB pages, where an erase sets a
+ * page to 0xFF and programming can only clear bits.
+ * Reconstructs a firmware image from a LoRaWAN fragmentation session with
+ * lost fragments, the decoder storing rows through the page-aggregating
+ * stream as the FUOTA service does, with and without NVM writes sharing the
+ * driver's page buffer in between; the decoder keeps its partial solutions
+ * in the rows of lost fragments, so some pages are rewritten behind the
+ * cursor. Checks the image and the NVM data, the
+ * reopen and open failure of a stream, and reports erase and program counts
+ * against a udrv_flash_write() per fragment.
+ * Also replays NVM workloads through udrv_flash_write() and udrv_flash_read()
+ * against a reference copy: configuration saves where half the commands set
+ * the value already stored, records appended to a user data page, and random
+ * writes across page boundaries. Reports erases and flash time against the
+ * read-erase-program of every changed page the driver did before, at an
+ * assumed 15 ms per page erase and 10 us per programmed word.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "udrv_flash.h"
+#include "uhal_flash.h"
+#include "FragDecoder.h"
+#include "test.h"
+
+#define FLASH_SIZE      0x100000
+#define PAGE_SIZE       8192
+#define OTA_ADDRESS     0x74000         // MCU_FLASH_OTA_ADDRESS
+#define OTA_SIZE        (0xFE000 - OTA_ADDRESS)
+#define NVM_ADDRESS     0xFC000
+#define IMAGE_SIZE      (100 * 1024)
+#define FRAG_SIZE       200
+#define FRAG_NB         (IMAGE_SIZE / FRAG_SIZE)
+
+static uint8_t flash[FLASH_SIZE];
+static uint32_t erases;
+static uint32_t programs;
+static uint32_t words;                  // programmed words
+static uint32_t bits_set;               // program calls that tried to set a bit
+
+// Simulated flash
+
+void uhal_flash_init(void)
+{
+}
+
+void uhal_flash_deinit(void)
+{
+}
+
+int32_t uhal_flash_write(uint32_t addr, uint8_t *buff, uint32_t len)
+{
+    CHECK(addr % 4 == 0 && len % 4 == 0, "program of %u bytes at 0x%x not word aligned", len, addr);
+    CHECK(addr + len <= FLASH_SIZE && len <= PAGE_SIZE, "program of %u bytes at 0x%x", len, addr);
+    for (uint32_t i = 0; i < len; i++)
+    {
+        if ((flash[addr + i] & buff[i]) != buff[i])
+            bits_set++;
+        flash[addr + i] &= buff[i];
+    }
+    programs++;
+    words += len / 4;
+    return UDRV_RETURN_OK;
+}
+
+int32_t uhal_flash_read(uint32_t addr, uint8_t *buff, uint32_t len)
+{
+    memcpy(buff, flash + addr, len);
+    return UDRV_RETURN_OK;
+}
+
+int32_t uhal_flash_erase(uint32_t addr, uint32_t len)
+{
+    CHECK(addr % PAGE_SIZE == 0 && len % PAGE_SIZE == 0, "erase of %u bytes at 0x%x", len, addr);
+    memset(flash + addr, 0xFF, len);
+    erases += len / PAGE_SIZE;
+    return UDRV_RETURN_OK;
+}
+
+uint32_t uhal_flash_get_page_size(void)
+{
+    return PAGE_SIZE;
+}
+
+bool uhal_flash_check_addr_valid(uint32_t addr, uint32_t len)
+{
+    return addr + len <= FLASH_SIZE;
+}
+
+int32_t udrv_serial_log_printf(const char *fmt, ...)
+{
+    return 0;
+}
+
+// Fragmentation encoder, LoRaWAN Fragmented Data Block Transport
+
+static void set_parity(uint16_t index, uint8_t *row)
+{
+    row[index >> 3] |= 1 << (7 - (index % 8));
+}
+
+static bool get_parity(uint16_t index, uint8_t *row)
+{
+    return (row[index >> 3] >> (7 - (index % 8))) & 1;
+}
+
+static int32_t prbs23(int32_t x)
+{
+    return (x >> 1) + (((x & 1) ^ ((x & 0x20) >> 5)) << 22);
+}
+
+static void parity_row(int32_t n, int32_t m, uint8_t *row)
+{
+    int32_t m_pow2 = ((m & (m - 1)) == 0) ? 1 : 0;
+    int32_t x = 1 + 1001 * n;
+
+    memset(row, 0, (m >> 3) + 1);
+    for (int32_t coeff = 0; coeff < m / 2; coeff++)
+    {
+        int32_t r = 1 << 16;
+
+        while (r >= m)
+        {
+            x = prbs23(x);
+            r = x % (m + m_pow2);
+        }
+        set_parity(r, row);
+    }
+}
+
+// Coded fragment n (1-based), the XOR of the uncoded ones in its parity row.
+static void encode(const uint8_t *image, int32_t n, uint8_t *frag)
+{
+    uint8_t row[(FRAG_NB >> 3) + 1];
+
+    parity_row(n, FRAG_NB, row);
+    memset(frag, 0, FRAG_SIZE);
+    for (int32_t i = 0; i < FRAG_NB; i++)
+    {
+        if (get_parity(i, row))
+        {
+            for (int32_t j = 0; j < FRAG_SIZE; j++)
+                frag[j] ^= image[i * FRAG_SIZE + j];
+        }
+    }
+}
+
+// Decoder storage, as the FUOTA service and as it was before
+
+static udrv_flash_stream_t stream;
+
+static int8_t stream_write(uint32_t addr, uint8_t *data, uint32_t size)
+{
+    return (stream.page != NULL && udrv_flash_stream_write(&stream, addr, data, size) == UDRV_RETURN_OK) ? 0 : -1;
+}
+
+static int8_t stream_read(uint32_t addr, uint8_t *data, uint32_t size)
+{
+    return (stream.page != NULL && udrv_flash_stream_read(&stream, addr, data, size) == UDRV_RETURN_OK) ? 0 : -1;
+}
+
+static int8_t direct_write(uint32_t addr, uint8_t *data, uint32_t size)
+{
+    return (udrv_flash_write(OTA_ADDRESS + addr, size, data) == UDRV_RETURN_OK) ? 0 : -1;
+}
+
+static int8_t direct_read(uint32_t addr, uint8_t *data, uint32_t size)
+{
+    return (udrv_flash_read(OTA_ADDRESS + addr, size, data) == UDRV_RETURN_OK) ? 0 : -1;
+}
+
+static FragDecoderCallbacks_t stream_callbacks = {stream_write, stream_read};
+static FragDecoderCallbacks_t direct_callbacks = {direct_write, direct_read};
+
+static uint8_t image[IMAGE_SIZE];
+
+// Run a session losing loss_pct of the fragments, with an NVM write every
+// nvm_every fragments when nonzero. The region holds an older image.
+static void session(bool use_stream, int loss_pct, int nvm_every, uint32_t *erase_count, uint32_t *program_count)
+{
+    uint8_t frag[FRAG_SIZE];
+    uint32_t nvm = 0;
+    int32_t status = FRAG_SESSION_ONGOING;
+    int32_t counter;
+
+    srand(31 + loss_pct);
+    for (uint32_t i = 0; i < IMAGE_SIZE; i++)
+        image[i] = (uint8_t)rand();
+    for (uint32_t i = 0; i < OTA_SIZE; i++)
+        flash[OTA_ADDRESS + i] = (uint8_t)rand();
+    memset(flash + NVM_ADDRESS, 0xFF, PAGE_SIZE);
+    erases = 0;
+    programs = 0;
+    bits_set = 0;
+
+    if (use_stream)
+        CHECK(udrv_flash_stream_open(&stream, OTA_ADDRESS, OTA_SIZE, NULL) == UDRV_RETURN_OK, "stream open failed");
+    FragDecoderInit(FRAG_NB, FRAG_SIZE, use_stream ? &stream_callbacks : &direct_callbacks);
+    for (counter = 1; status < 0 && counter <= FRAG_NB + 200; counter++)
+    {
+        if (rand() % 100 < loss_pct)
+            continue;
+        if (counter <= FRAG_NB)
+            memcpy(frag, image + (counter - 1) * FRAG_SIZE, FRAG_SIZE);
+        else
+            encode(image, counter - FRAG_NB, frag);
+        status = FragDecoderProcess(counter, frag);
+
+        if (nvm_every != 0 && counter % nvm_every == 0)
+        {
+            nvm++;
+            CHECK(udrv_flash_write(NVM_ADDRESS + (nvm % 16) * 16, sizeof(nvm), (uint8_t *)&nvm) == UDRV_RETURN_OK,
+                  "NVM write failed");
+        }
+    }
+    if (use_stream)
+    {
+        CHECK(udrv_flash_stream_close(&stream) == UDRV_RETURN_OK, "stream close failed");
+        CHECK(stream.page == NULL, "stream not closed");
+    }
+
+    CHECK(status >= 0 && FragDecoderGetStatus().MatrixError == 0, "%d%% lost: session not finished (%d)",
+          loss_pct, status);
+    CHECK(memcmp(flash + OTA_ADDRESS, image, IMAGE_SIZE) == 0, "%d%% lost, %s: image differs", loss_pct,
+          use_stream ? "stream" : "direct");
+    CHECK(bits_set == 0, "%u programs tried to set a bit", bits_set);
+    if (nvm != 0)
+    {
+        uint32_t last;
+
+        memcpy(&last, flash + NVM_ADDRESS + (nvm % 16) * 16, sizeof(last));
+        CHECK(last == nvm, "NVM write lost");
+    }
+    *erase_count = erases;
+    *program_count = programs;
+}
+
+static void test_open(void)
+{
+    uint8_t data[100];
+
+    memset(data, 0x5A, sizeof(data));
+    memset(flash + OTA_ADDRESS, 0, PAGE_SIZE);
+    CHECK(udrv_flash_stream_open(&stream, OTA_ADDRESS, OTA_SIZE, NULL) == UDRV_RETURN_OK, "stream open failed");
+    CHECK(udrv_flash_stream_write(&stream, 0, data, sizeof(data)) == UDRV_RETURN_OK, "stream write failed");
+
+    // Reopened for a new session: the dirty page of the earlier one is dropped.
+    programs = 0;
+    CHECK(udrv_flash_stream_open(&stream, OTA_ADDRESS, OTA_SIZE, NULL) == UDRV_RETURN_OK, "stream reopen failed");
+    CHECK(udrv_flash_stream_close(&stream) == UDRV_RETURN_OK && programs == 0, "dirty page of an earlier open programmed");
+    CHECK(udrv_flash_write(NVM_ADDRESS, sizeof(data), data) == UDRV_RETURN_OK && programs == 1,
+          "page buffer still held by a closed stream");
+
+    // A failed open leaves the stream closed, even one that was open.
+    CHECK(udrv_flash_stream_open(&stream, OTA_ADDRESS, OTA_SIZE, NULL) == UDRV_RETURN_OK, "stream open failed");
+    CHECK(udrv_flash_stream_open(&stream, OTA_ADDRESS + 4, OTA_SIZE, NULL) == -UDRV_WRONG_ARG, "unaligned base accepted");
+    CHECK(stream.page == NULL && stream_write(0, data, sizeof(data)) == -1, "write to a failed stream accepted");
+    CHECK(udrv_flash_stream_open(&stream, OTA_ADDRESS, (UDRV_FLASH_STREAM_PAGES_MAX + 1) * PAGE_SIZE, NULL) ==
+          -UDRV_WRONG_ARG, "oversized region accepted");
+    CHECK(stream.page == NULL, "stream open after a failed open");
+}
+
+// NVM workloads
+
+#define NVM_BASE        0xF8000         // three pages ending below the bootloader flags
+#define NVM_SIZE        (3 * PAGE_SIZE)
+#define CFG_SIZE        1024            // about sizeof(PRE_rui_cfg_t)
+#define RECORD_SIZE     16
+#define ERASE_US        15000
+#define WORD_US         10
+
+typedef struct {
+    uint32_t writes;
+    uint32_t erases;
+    uint32_t words;
+    uint32_t old_erases;                // read-erase-program of every changed page
+} nvm_cost_t;
+
+static uint8_t nvm_ref[NVM_SIZE];
+
+static void nvm_reset(void)
+{
+    memset(flash + NVM_BASE, 0xFF, NVM_SIZE);
+    memset(nvm_ref, 0xFF, NVM_SIZE);
+}
+
+static void nvm_write(nvm_cost_t *cost, uint32_t off, uint8_t *data, uint32_t len)
+{
+    uint32_t erase_count = erases, word_count = words;
+
+    if (memcmp(nvm_ref + off, data, len) != 0)
+        cost->old_erases += (off + len - 1) / PAGE_SIZE - off / PAGE_SIZE + 1;
+    memcpy(nvm_ref + off, data, len);
+
+    bits_set = 0;
+    CHECK(udrv_flash_write(NVM_BASE + off, len, data) == UDRV_RETURN_OK, "write of %u bytes at %u failed", len, off);
+    CHECK(bits_set == 0, "write of %u bytes at %u tried to set a bit", len, off);
+    CHECK(memcmp(flash + NVM_BASE, nvm_ref, NVM_SIZE) == 0, "write of %u bytes at %u: flash differs", len, off);
+    cost->writes++;
+    cost->erases += erases - erase_count;
+    cost->words += words - word_count;
+}
+
+static uint32_t nvm_ms(uint32_t erase_count, uint32_t word_count)
+{
+    return (erase_count * ERASE_US + word_count * WORD_US) / 1000;
+}
+
+static uint32_t nvm_old_ms(nvm_cost_t *cost)
+{
+    return nvm_ms(cost->old_erases, cost->old_erases * (PAGE_SIZE / 4));
+}
+
+// The whole configuration saved after each of 200 commands, half of which
+// set the value already stored.
+static void nvm_config(nvm_cost_t *cost)
+{
+    uint8_t cfg[CFG_SIZE];
+
+    nvm_reset();
+    for (uint32_t i = 0; i < CFG_SIZE; i++)
+        cfg[i] = (uint8_t)rand();
+    nvm_write(cost, 0, cfg, CFG_SIZE);
+    CHECK(cost->erases == 0, "first save into an erased page erased it");
+
+    for (int i = 0; i < 200; i++)
+    {
+        uint32_t field = (rand() % (CFG_SIZE / 4)) * 4;
+
+        if (rand() % 2)
+        {
+            uint32_t value = (uint32_t)rand();
+
+            memcpy(cfg + field, &value, sizeof(value));
+        }
+        nvm_write(cost, 0, cfg, CFG_SIZE);
+    }
+}
+
+// Records appended until the page is full, then the first one rewritten.
+static void nvm_records(nvm_cost_t *cost)
+{
+    uint8_t record[RECORD_SIZE];
+
+    nvm_reset();
+    for (uint32_t off = 0; off < PAGE_SIZE; off += RECORD_SIZE)
+    {
+        for (int i = 0; i < RECORD_SIZE; i++)
+            record[i] = (uint8_t)rand();
+        nvm_write(cost, PAGE_SIZE + off, record, RECORD_SIZE);
+    }
+    CHECK(cost->erases == 0, "%u erases appending records", cost->erases);
+    CHECK(cost->words == PAGE_SIZE / 4, "%u words programmed for a %u byte page", cost->words, PAGE_SIZE);
+
+    memset(record, 0, RECORD_SIZE);
+    nvm_write(cost, PAGE_SIZE, record, RECORD_SIZE);
+    CHECK(cost->erases == 1, "rewritten record took %u erases", cost->erases);
+}
+
+// Writes of random length and alignment, a third of them repeating the data
+// in place, with unaligned reads checked in between.
+static void nvm_random(nvm_cost_t *cost)
+{
+    uint8_t data[600];
+
+    nvm_reset();
+    for (int i = 0; i < 1000; i++)
+    {
+        uint32_t len = 1 + rand() % sizeof(data);
+        uint32_t off = rand() % (NVM_SIZE - len + 1);
+        uint32_t word_count = words;
+        bool same = (rand() % 3 == 0);
+
+        if (same)
+            memcpy(data, nvm_ref + off, len);
+        else
+        {
+            for (uint32_t j = 0; j < len; j++)
+                data[j] = (uint8_t)rand();
+        }
+        nvm_write(cost, off, data, len);
+        CHECK(!same || words == word_count, "rewrite of %u unchanged bytes at %u programmed", len, off);
+
+        len = 1 + rand() % sizeof(data);
+        off = rand() % (NVM_SIZE - len + 1);
+        CHECK(udrv_flash_read(NVM_BASE + off, len, data) == UDRV_RETURN_OK && memcmp(data, nvm_ref + off, len) == 0,
+              "read of %u bytes at %u differs", len, off);
+    }
+}
+
+// Reads go to flash: they neither see nor flush a stream's unprogrammed page.
+static void test_read(void)
+{
+    uint8_t data[100], back[100];
+
+    nvm_reset();
+    memset(data, 0x5A, sizeof(data));
+    CHECK(udrv_flash_stream_open(&stream, NVM_BASE, NVM_SIZE, NULL) == UDRV_RETURN_OK, "stream open failed");
+    CHECK(udrv_flash_stream_write(&stream, 3, data, sizeof(data)) == UDRV_RETURN_OK, "stream write failed");
+    programs = 0;
+    CHECK(udrv_flash_read(NVM_BASE + 1, sizeof(back), back) == UDRV_RETURN_OK && programs == 0,
+          "read programmed the stream's page");
+    CHECK(memcmp(back, nvm_ref + 1, sizeof(back)) == 0, "read returned unprogrammed data");
+    CHECK(udrv_flash_stream_read(&stream, 3, back, sizeof(back)) == UDRV_RETURN_OK &&
+          memcmp(back, data, sizeof(back)) == 0, "stream lost its page");
+    CHECK(udrv_flash_stream_close(&stream) == UDRV_RETURN_OK, "stream close failed");
+    CHECK(udrv_flash_read(NVM_BASE + 3, sizeof(back), back) == UDRV_RETURN_OK && memcmp(back, data, sizeof(back)) == 0,
+          "read after close differs");
+}
+
+int main(void)
+{
+    uint32_t erase_count[4], program_count[4];
+    nvm_cost_t config = {0}, records = {0}, random_writes = {0};
+
+    test_open();
+    test_read();
+    srand(32);
+    nvm_config(&config);
+    nvm_records(&records);
+    nvm_random(&random_writes);
+    session(true, 5, 0, &erase_count[0], &program_count[0]);
+    session(true, 10, 0, &erase_count[1], &program_count[1]);
+    session(true, 5, 20, &erase_count[2], &program_count[2]);
+    session(false, 5, 0, &erase_count[3], &program_count[3]);
+    CHECK(erase_count[0] < 2 * (IMAGE_SIZE + PAGE_SIZE - 1) / PAGE_SIZE, "%u erases for a %u page image", erase_count[0],
+          (IMAGE_SIZE + PAGE_SIZE - 1) / PAGE_SIZE);
+
+    printf("flash: %u kB image in %u fragments, erases/programs with the stream %u/%u at 5%% lost, %u/%u at 10%%, "
+           "%u/%u with an NVM write every 20 fragments; a write per fragment %u/%u\n",
+           IMAGE_SIZE / 1024, FRAG_NB, erase_count[0], program_count[0], erase_count[1], program_count[1],
+           erase_count[2], program_count[2], erase_count[3], program_count[3]);
+
+    printf("flash: NVM erases and flash time against read-erase-program of each changed page: "
+           "%u configuration saves %u/%u ms vs %u/%u ms, %u appended records %u/%u ms vs %u/%u ms, "
+           "%u random writes %u/%u ms vs %u/%u ms\n",
+           config.writes, config.erases, nvm_ms(config.erases, config.words), config.old_erases, nvm_old_ms(&config),
+           records.writes, records.erases, nvm_ms(records.erases, records.words), records.old_erases,
+           nvm_old_ms(&records), random_writes.writes, random_writes.erases,
+           nvm_ms(random_writes.erases, random_writes.words), random_writes.old_erases, nvm_old_ms(&random_writes));
+
+    TEST_DONE("flash");
+}
@@ -0,0 +1,24 @@
+/* Host stand-in for FreeRTOS. The test plays the idle task, the timers,
+ * semaphores and tasks of uhal_powersave.c are only compiled. */
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stdint.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE             0
+#define pdTRUE              1
+#define pdPASS              1
+#define pdFAIL              0
+#define portMAX_DELAY       0xFFFFFFFFu
+
+#define configTICK_RATE_HZ          1000
+#define configSTIMER_CLOCK_HZ       32768
+#define configMINIMAL_STACK_SIZE    256
+
+#define portYIELD_FROM_ISR(x)   ((void)(x))
+
+#endif
@@ -0,0 +1,9 @@
+/* Host stand-in for the variant FreeRTOSConfig.h, the settings are in FreeRTOS.h. */
+#ifndef FREERTOS_CONFIG_H
+#define FREERTOS_CONFIG_H
+
+#include "FreeRTOS.h"
+
+#define NVIC_configKERNEL_INTERRUPT_PRIORITY    7
+
+#endif
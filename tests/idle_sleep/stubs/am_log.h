@@ -0,0 +1,7 @@
+/* Host stand-in for the log macros, the logs of uhal_powersave.c are dropped. */
+#ifndef _AM_LOG_H_
+#define _AM_LOG_H_
+
+#define am_log_inf(...)     do { } while (0)
+
+#endif  // #ifndef _AM_LOG_H_
@@ -0,0 +1,63 @@
+/* Host stand-in for the Apollo3 HAL, just what uhal_powersave.c and uhal_rtc.c
+ * use. The sleep, the STIMER and CTIMER 3 are implemented by the test on a
+ * virtual clock. */
+#ifndef _AM_MCU_APOLLO_H_
+#define _AM_MCU_APOLLO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define AM_HAL_SYSCTRL_SLEEP_DEEP       true
+#define AM_HAL_SYSCTRL_SLEEP_NORMAL     false
+
+#define AM_HAL_STIMER_INT_COMPAREA      (1u << 0)
+#define AM_HAL_STIMER_INT_OVERFLOW      (1u << 8)
+
+#define AM_HAL_CTIMER_BOTH              0xFFFFu
+#define AM_HAL_CTIMER_XT_32_768KHZ      (0x01u << 1)
+#define AM_HAL_CTIMER_FN_ONCE           (0x00u << 6)
+#define AM_HAL_CTIMER_INT_ENABLE        (1u << 9)
+#define AM_HAL_CTIMER_INT_TIMERA3       (1u << 6)
+
+#define SCB_ICSR_VECTACTIVE_Msk         0x1FFu
+
+typedef struct
+{
+    volatile uint32_t ICSR;
+} SCB_Type;
+
+extern SCB_Type sim_scb;
+#define SCB (&sim_scb)
+
+typedef enum { CTIMER_IRQn = 14 } IRQn_Type;
+
+typedef struct
+{
+    uint32_t ui32Link;
+    uint32_t ui32TimerAConfig;
+    uint32_t ui32TimerBConfig;
+} am_hal_ctimer_config_t;
+
+typedef void (*am_hal_ctimer_handler_t)(void);
+
+void am_hal_sysctrl_sleep(bool deep);
+uint32_t am_hal_stimer_counter_get(void);
+uint32_t am_hal_stimer_int_status_get(bool enabled_only);
+void am_hal_stimer_int_clear(uint32_t interrupt);
+
+void am_hal_ctimer_stop(uint32_t timer, uint32_t segment);
+void am_hal_ctimer_clear(uint32_t timer, uint32_t segment);
+void am_hal_ctimer_compare_set(uint32_t timer, uint32_t segment, uint32_t compare_reg, uint32_t value);
+void am_hal_ctimer_start(uint32_t timer, uint32_t segment);
+
+// The one-shot alarm interrupt is raised by the test, the rest is setup
+#define am_hal_ctimer_config(t, c)              ((void)(c))
+#define am_hal_ctimer_int_clear(i)              ((void)(i))
+#define am_hal_ctimer_int_enable(i)             ((void)(i))
+#define am_hal_ctimer_int_register(i, h)        ((void)(h))
+#define am_hal_ctimer_int_status_get(e)         0u
+#define am_hal_ctimer_int_service(s)            ((void)(s))
+#define NVIC_SetPriority(irq, p)                ((void)(p))
+#define NVIC_EnableIRQ(irq)                     ((void)(irq))
+
+#endif  // #ifndef _AM_MCU_APOLLO_H_
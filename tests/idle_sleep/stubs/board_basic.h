@@ -0,0 +1,5 @@
+/* Host stand-in for the board definitions, udrv_spimst.h includes it but nothing of it is used. */
+#ifndef _BOARD_BASIC_H_
+#define _BOARD_BASIC_H_
+
+#endif
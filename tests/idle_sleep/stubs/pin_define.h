@@ -0,0 +1,8 @@
+/* Host stand-in for the board pin map, just the UART RX pins uhal_powersave.c watches while asleep. */
+#ifndef _PIN_DEFINE_H_
+#define _PIN_DEFINE_H_
+
+#define WB_RXD0     40
+#define WB_RXD1     43
+
+#endif
@@ -0,0 +1,23 @@
+/* Host stand-in for the variant rtos.h, see FreeRTOS.h. */
+#ifndef RTOS_H_
+#define RTOS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "timers.h"
+#include "semphr.h"
+
+enum
+{
+  RAK_TASK_PRIO_LOWEST  = 0,
+  RAK_TASK_PRIO_LOW     = 1,
+  RAK_TASK_PRIO_NORMAL  = 2,
+  RAK_TASK_PRIO_HIGH    = 3,
+  RAK_TASK_PRIO_HIGHEST = 4,
+};
+
+#endif /* RTOS_H_ */
@@ -0,0 +1,543 @@
+/*
+ * Tickless idle policy of uhal_powersave.c, the LoRaMac alarm of uhal_rtc.c
+ * and the idle sleep accounting of udrv_powersave.c on a simulated sleep
+ * controller. The test plays the idle task: it calls uhal_mcu_idle_sleep()
+ * with interrupts masked and the tick compare set for the idle time, the mock
+ * WFI sleeps on a virtual STIMER until that compare, the one-shot CTIMER 3
+ * alarm or a scheduled interrupt, and the handlers only run once it has
+ * returned, reporting their wake-up source the way the uhal ISRs do. Some
+ * interrupts report none.
+ *
+ * Random idle times, alarms, interrupts and latency bounds have to give the
+ * AT+LPMSTAT idle depths, counts, residency and wake-up sources the schedule
+ * makes, every idle sleep with exactly one source and the residency within
+ * the elapsed time. The STIMER starts just before it wraps, and a reset
+ * between a sleep and its handler must not count that handler. An alarm
+ * across the STIMER wrap has to count down through it, and stay due between
+ * its interrupt and the rtc task.
+ *
+ * Duty-cycled workloads then run for a virtual hour each: LoRaWAN class A
+ * uplinks with their two receive windows on the LoRaMac alarm, a periodic
+ * FreeRTOS timer and the events of a BLE connection. Every wake-up has to
+ * serve at least one of them on time, and the wake-ups per hour are reported.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "uhal_powersave.h"
+#include "uhal_rtc.h"
+#include "udrv_powersave.h"
+#include "udrv_rtc.h"
+#include "udrv_gpio.h"
+#include "udrv_serial.h"
+#include "udrv_system.h"
+#include "test.h"
+
+#define SLEEPS          20000
+#define CHECK_EVERY     1000
+#define STIMER_HZ       32768
+#define STIMER_START    0xFFFF0000u     // wraps after 2 s
+#define HOUR            (3600ull * STIMER_HZ)
+#define WORK_TICKS      33              // tasks run about 1 ms after a wake-up
+#define MAX_IDLE_TICKS  (UINT32_MAX / (STIMER_HZ / configTICK_RATE_HZ))  // xMaximumPossibleSuppressedTicks
+
+void uhal_rtc_ctimer_handler(void);
+void uhal_rtc_handler(void);
+
+//
+// Simulated sleep controller
+//
+
+SCB_Type sim_scb;
+
+static uint64_t now;                    // STIMER ticks since the start
+static uint64_t tick_compare;
+static uint64_t alarm_at, irq_at;       // 0: none
+static uint32_t ctimer_compare;
+static UDRV_PS_WAKE_SRC irq_src;        // UDRV_PS_WAKE_SRC_MAX: the handler reports nothing
+static bool compare_pending, alarm_pending, irq_pending;
+static int sleeps_entered;
+static bool slept_deep;
+
+void am_hal_sysctrl_sleep(bool deep)
+{
+    uint64_t wake = tick_compare;
+
+    sleeps_entered++;
+    slept_deep = deep;
+    if (alarm_at && alarm_at < wake)
+        wake = alarm_at;
+    if (irq_at && irq_at < wake)
+        wake = irq_at;
+    if (wake > now)
+        now = wake;
+
+    compare_pending = (now >= tick_compare);
+    alarm_pending = alarm_at && now >= alarm_at;
+    irq_pending = irq_at && now >= irq_at;
+}
+
+uint32_t am_hal_stimer_counter_get(void)
+{
+    return (uint32_t)(STIMER_START + now);
+}
+
+uint32_t am_hal_stimer_int_status_get(bool enabled_only)
+{
+    return compare_pending ? AM_HAL_STIMER_INT_COMPAREA : 0;
+}
+
+void am_hal_stimer_int_clear(uint32_t interrupt)
+{
+}
+
+// CTIMER 3, one-shot on the same 32 kHz clock
+void am_hal_ctimer_stop(uint32_t timer, uint32_t segment)
+{
+    alarm_at = 0;
+}
+
+void am_hal_ctimer_clear(uint32_t timer, uint32_t segment)
+{
+    alarm_at = 0;
+}
+
+void am_hal_ctimer_compare_set(uint32_t timer, uint32_t segment, uint32_t compare_reg, uint32_t value)
+{
+    ctimer_compare = value;
+}
+
+void am_hal_ctimer_start(uint32_t timer, uint32_t segment)
+{
+    alarm_at = now + ctimer_compare;
+}
+
+// The LoRaMac timer list sets its next expiry, ticks from now
+static void set_alarm(uint64_t ticks)
+{
+    uint32_t ref = am_hal_stimer_counter_get();
+
+    uhal_rtc_set_alarm(SYS_RTC_COUNTER_PORT, (uint32_t)ticks, &ref);
+}
+
+static void alarm_irq(void)
+{
+    sim_scb.ICSR = CTIMER_IRQn + 16;
+    uhal_rtc_ctimer_handler();
+    sim_scb.ICSR = 0;
+}
+
+uint64_t udrv_rtc_get_timestamp(RtcID_E timer_id)
+{
+    return now * 1000 / STIMER_HZ;
+}
+
+// Interrupts unmasked: the handlers run and the tick compare is cleared, returns what they reported
+static UDRV_PS_WAKE_SRC run_handlers(void)
+{
+    UDRV_PS_WAKE_SRC src = UDRV_PS_WAKE_SRC_MAX;
+
+    compare_pending = false;
+    if (alarm_pending)
+    {
+        // The rtc task runs the handler after the interrupt
+        alarm_irq();
+        uhal_rtc_handler();
+        src = UDRV_PS_WAKE_SRC_RTC;
+        alarm_pending = false;
+    }
+    if (irq_pending)
+    {
+        if (irq_src < UDRV_PS_WAKE_SRC_MAX)
+        {
+            udrv_powersave_wake_source(irq_src);
+            if (src == UDRV_PS_WAKE_SRC_MAX)
+                src = irq_src;
+        }
+        irq_pending = false;
+        irq_at = 0;
+    }
+    return src;
+}
+
+//
+// Rest of the platform, uhal_powersave.c only needs it to link
+//
+
+bool no_busy_loop = true;
+
+void udrv_adc_suspend(void) { }
+void udrv_adc_resume(void) { }
+void udrv_pwm_suspend(void) { }
+void udrv_pwm_resume(void) { }
+void udrv_serial_suspend(void) { }
+void udrv_serial_resume(void) { }
+void udrv_gpio_suspend(void) { }
+void udrv_gpio_resume(void) { }
+void udrv_rtc_suspend(void) { }
+void udrv_rtc_resume(void) { }
+void udrv_twimst_suspend(void) { }
+void udrv_twimst_resume(void) { }
+bool uhal_adc_is_active(void) { return false; }
+bool uhal_pwm_is_active(void) { return false; }
+bool uhal_uart_is_active(void) { return false; }
+bool uhal_twimst_is_active(void) { return false; }
+
+void uhal_gpio_set_dir(uint32_t pin, gpio_dir_t dir) { }
+void uhal_gpio_set_pull(uint32_t pin, gpio_pull_t pull) { }
+void uhal_gpio_intc_trigger_mode(uint32_t pin, gpio_intc_trigger_mode_t mode) { }
+int32_t uhal_gpio_register_isr(uint32_t pin, gpio_isr_func handler) { return 0; }
+void uhal_gpio_intc_clear(uint32_t pin) { }
+void uhal_gpio_pin_suspend(uint32_t pin) { }
+void uhal_uart_suspend(void) { }
+void uhal_uart_resume(void) { }
+
+int32_t uhal_uart_write(SERIAL_PORT Port, uint8_t const *Buffer, int32_t NumberOfBytes, uint32_t Timeout)
+{
+    return NumberOfBytes;
+}
+
+int32_t udrv_system_event_produce(udrv_system_event_t *event) { return 0; }
+void udrv_system_event_consume(void) { }
+
+uint16_t fund_event_queue_space_get(void)
+{
+    return EVENT_QUEUE_SIZE;
+}
+
+uint32_t service_nvm_get_auto_sleep_level_from_nvm(void)
+{
+    return 1;
+}
+
+uint32_t service_nvm_get_auto_sleep_time_from_nvm(void)
+{
+    return 0;
+}
+
+//
+// Idle task
+//
+
+static struct {
+    uint64_t residency_us[UDRV_PS_IDLE_MAX];
+    uint32_t cnt[UDRV_PS_IDLE_MAX];
+    uint32_t wakeup_cnt[UDRV_PS_WAKE_SRC_MAX];
+} expect;
+
+static uint32_t latency_us = UDRV_PS_LATENCY_ANY;
+
+static uint64_t rand_ticks(uint32_t max)
+{
+    return 1 + (uint64_t)rand() % max;
+}
+
+static void schedule(void)
+{
+    static const UDRV_PS_WAKE_SRC srcs[] = {
+        UDRV_PS_WAKE_SRC_GPIO, UDRV_PS_WAKE_SRC_UART, UDRV_PS_WAKE_SRC_BLE, UDRV_PS_WAKE_SRC_RADIO,
+        UDRV_PS_WAKE_SRC_MAX,
+    };
+    static const uint32_t latencies[] = { UDRV_PS_LATENCY_ANY, UHAL_PS_DEEP_SLEEP_LATENCY_US - 1, 5000 };
+
+    if (!alarm_at && rand() % 4 == 0)
+        set_alarm(rand_ticks(5 * STIMER_HZ));
+    if (!irq_at && rand() % 4 == 0)
+    {
+        irq_at = now + rand_ticks(2 * STIMER_HZ);
+        irq_src = srcs[rand() % (sizeof(srcs) / sizeof(srcs[0]))];
+    }
+    if (rand() % 50 == 0)
+    {
+        latency_us = latencies[rand() % (sizeof(latencies) / sizeof(latencies[0]))];
+        udrv_powersave_set_latency(UDRV_PS_LATENCY_USER, latency_us);
+    }
+}
+
+// One idle period of idle_ticks, then the handlers run
+static void idle(uint32_t idle_ticks, bool reset_before_handlers)
+{
+    uint64_t idle_us = (uint64_t)idle_ticks * 1000000 / configTICK_RATE_HZ;
+    uint64_t start = now;
+    UDRV_PS_IDLE depth;
+    UDRV_PS_WAKE_SRC src;
+    bool expired;
+    int entered = sleeps_entered;
+
+    if (alarm_at)
+    {
+        uint64_t alarm_us = (alarm_at > now) ? (alarm_at - now) * 1000000 / STIMER_HZ : 0;
+        if (alarm_us < idle_us)
+            idle_us = alarm_us;
+    }
+    depth = (idle_us < UHAL_PS_DEEP_SLEEP_MIN_IDLE_US || latency_us < UHAL_PS_DEEP_SLEEP_LATENCY_US) ?
+            UDRV_PS_IDLE_NORMAL : UDRV_PS_IDLE_DEEP;
+
+    tick_compare = now + (uint64_t)idle_ticks * STIMER_HZ / configTICK_RATE_HZ;
+    uhal_mcu_idle_sleep(idle_ticks);
+    CHECK(sleeps_entered == entered + 1, "%d WFI for one idle sleep", sleeps_entered - entered);
+    CHECK(slept_deep == (depth == UDRV_PS_IDLE_DEEP), "idle %u ms, alarm in %llu us, latency %u us: slept %s",
+          idle_ticks, (unsigned long long)idle_us, latency_us, slept_deep ? "deep" : "normal");
+
+    expired = compare_pending;
+    expect.residency_us[depth] += (now - start) * 1000000 / STIMER_HZ;
+    expect.cnt[depth]++;
+    if (reset_before_handlers)
+    {
+        udrv_powersave_reset_stats();
+        memset(&expect, 0, sizeof(expect));
+    }
+    src = run_handlers();
+    if (!reset_before_handlers)
+    {
+        if (expired)
+            src = UDRV_PS_WAKE_SRC_TIMER;
+        else if (src == UDRV_PS_WAKE_SRC_MAX)
+            src = UDRV_PS_WAKE_SRC_OTHER;
+        expect.wakeup_cnt[src]++;
+    }
+}
+
+static void check_stats(int sleeps)
+{
+    udrv_powersave_stats_t stats;
+    uint64_t residency_us = 0;
+    uint32_t cnt = 0, wakeups = 0;
+
+    udrv_powersave_get_stats(&stats);
+    for (int i = 0; i < UDRV_PS_IDLE_MAX; i++)
+    {
+        CHECK(stats.idle_cnt[i] == expect.cnt[i], "after %d sleeps: %u %s idle sleeps, expected %u", sleeps,
+              stats.idle_cnt[i], udrv_powersave_idle_name((UDRV_PS_IDLE)i), expect.cnt[i]);
+        CHECK(stats.idle_residency_us[i] == expect.residency_us[i], "after %d sleeps: %llu us %s, expected %llu",
+              sleeps, (unsigned long long)stats.idle_residency_us[i], udrv_powersave_idle_name((UDRV_PS_IDLE)i),
+              (unsigned long long)expect.residency_us[i]);
+        residency_us += stats.idle_residency_us[i];
+        cnt += stats.idle_cnt[i];
+    }
+    for (int i = 0; i < UDRV_PS_WAKE_SRC_MAX; i++)
+    {
+        CHECK(stats.idle_wakeup_cnt[i] == expect.wakeup_cnt[i], "after %d sleeps: %u idle wake-ups by %s, expected %u",
+              sleeps, stats.idle_wakeup_cnt[i], udrv_powersave_wake_source_name((UDRV_PS_WAKE_SRC)i),
+              expect.wakeup_cnt[i]);
+        wakeups += stats.idle_wakeup_cnt[i];
+        CHECK(stats.wakeup_cnt[i] == 0, "after %d sleeps: idle wake-ups counted as MCU_SLEEP ones", sleeps);
+    }
+    CHECK(wakeups == cnt, "after %d sleeps: %u idle sleeps, %u wake-ups", sleeps, cnt, wakeups);
+    CHECK(residency_us <= (stats.elapsed_ms + 1) * 1000, "after %d sleeps: %llu us asleep in %llu ms", sleeps,
+          (unsigned long long)residency_us, (unsigned long long)stats.elapsed_ms);
+}
+
+//
+// Scenarios
+//
+
+static void test_random(void)
+{
+    static const uint32_t idle_ms[] = { 1, 2, 3, 10, 100, 1000, 5000 };
+
+    udrv_powersave_reset_stats();
+    srand(47);
+    for (int n = 1; n <= SLEEPS; n++)
+    {
+        schedule();
+        idle(idle_ms[rand() % (sizeof(idle_ms) / sizeof(idle_ms[0]))], false);
+        // Tasks run until the next idle period
+        now += rand_ticks(STIMER_HZ / 100);
+        if (n % CHECK_EVERY == 0)
+            check_stats(n);
+    }
+    CHECK(am_hal_stimer_counter_get() < STIMER_START, "the STIMER did not wrap");
+}
+
+// A handler that runs after a reset belongs to a sleep that is no longer counted
+static void test_reset(void)
+{
+    udrv_powersave_stats_t stats;
+
+    alarm_at = 0;
+    irq_at = now + 10;
+    irq_src = UDRV_PS_WAKE_SRC_UART;
+    idle(100, true);
+    udrv_powersave_get_stats(&stats);
+    for (int i = 0; i < UDRV_PS_WAKE_SRC_MAX; i++)
+        CHECK(stats.idle_wakeup_cnt[i] == 0, "%s counted after the reset", udrv_powersave_wake_source_name((UDRV_PS_WAKE_SRC)i));
+    check_stats(1);
+}
+
+// The alarm counts down across the STIMER wrap and is due until the rtc task drops it
+static void test_alarm_wrap(void)
+{
+    uint32_t remaining;
+
+    uhal_rtc_cancel_alarm(SYS_RTC_COUNTER_PORT);
+    irq_at = 0;
+    now += (uint32_t)(0xFFFFFF00u - am_hal_stimer_counter_get());
+    set_alarm(1000);
+    now += 500;
+    CHECK(am_hal_stimer_counter_get() < 0x100, "the STIMER did not wrap");
+    remaining = uhal_rtc_get_alarm_remaining();
+    CHECK(remaining == 500, "%u ticks left after the wrap, expected 500", remaining);
+
+    now += 600;
+    alarm_irq();
+    CHECK(!alarm_at, "CTIMER 3 still running after its interrupt");
+    remaining = uhal_rtc_get_alarm_remaining();
+    CHECK(remaining == 0, "%u ticks left on a fired alarm", remaining);
+
+    uhal_rtc_handler();
+    remaining = uhal_rtc_get_alarm_remaining();
+    CHECK(remaining == UINT32_MAX, "%u ticks left on a handled alarm", remaining);
+}
+
+//
+// Duty-cycled workloads
+//
+
+typedef struct {
+    const char *name;
+    uint32_t uplink_s;          // LoRaWAN class A uplink period, RX1 and RX2 follow after 1 and 2 s
+    uint32_t timer_ms;          // FreeRTOS timer period, 0: none
+    uint32_t ble_ms;            // BLE connection interval, 0: not connected
+    uint32_t wakeups;           // one per event, none of them at the same time
+} workload_t;
+
+static const workload_t workloads[] = {
+    { "class A uplink every 60 s",                        60,     0,  0,   180 },
+    { "class A every 60 s and a sensor read every 10 s",  60, 10000,  0,   540 },
+    { "class A every 5 min and a 50 ms BLE connection",  300,     0, 50, 72036 },
+};
+
+// Event n of a period, half a period after the start so that none of them coincide
+static uint64_t event_at(uint64_t start, uint64_t period_ms, uint64_t n)
+{
+    return start + (period_ms / 2 + n * period_ms) * STIMER_HZ / 1000;
+}
+
+static uint32_t run_hour(const workload_t *w)
+{
+    udrv_powersave_stats_t stats;
+    uint64_t start = now, end = now + HOUR;
+    uint64_t uplink_ms = (uint64_t)w->uplink_s * 1000;
+    uint64_t uplinks = 0, timers = 0, ble_events = 0;
+    uint64_t lora_at, timer_at, ble_at;
+    int rx = 0;                 // 0: next is the uplink, 1 and 2: the receive windows
+
+    uhal_rtc_cancel_alarm(SYS_RTC_COUNTER_PORT);
+    irq_at = 0;
+    latency_us = w->ble_ms ? w->ble_ms * 1000 / 4 : UDRV_PS_LATENCY_ANY;
+    udrv_powersave_set_latency(UDRV_PS_LATENCY_USER, UDRV_PS_LATENCY_ANY);
+    udrv_powersave_set_latency(UDRV_PS_LATENCY_BLE, latency_us);
+    udrv_powersave_reset_stats();
+    memset(&expect, 0, sizeof(expect));
+
+    lora_at = event_at(start, uplink_ms, 0);
+    timer_at = w->timer_ms ? event_at(start, w->timer_ms, 0) : 0;
+    ble_at = w->ble_ms ? event_at(start, w->ble_ms, 0) : 0;
+    set_alarm(lora_at - now);
+    for (;;)
+    {
+        uint64_t wake, next = lora_at;
+        uint32_t idle_ticks = MAX_IDLE_TICKS;
+        int served = 0;
+
+        if (timer_at && timer_at < next)
+            next = timer_at;
+        if (ble_at && ble_at < next)
+            next = ble_at;
+        if (next >= end)
+            break;
+
+        if (ble_at && !irq_at)
+        {
+            irq_at = ble_at;
+            irq_src = UDRV_PS_WAKE_SRC_BLE;
+        }
+        // The FreeRTOS tick compare lands on the tick the timer expires in
+        if (timer_at)
+            idle_ticks = (uint32_t)(((timer_at - now) * configTICK_RATE_HZ + STIMER_HZ - 1) / STIMER_HZ);
+        idle(idle_ticks, false);
+        wake = now;
+
+        if (wake >= lora_at)
+        {
+            CHECK(wake == lora_at, "%s: LoRaMac alarm served %llu ticks late", w->name,
+                  (unsigned long long)(wake - lora_at));
+            rx = (rx + 1) % 3;
+            if (rx == 0)
+                uplinks++;
+            lora_at = event_at(start, uplink_ms, uplinks) + (uint64_t)rx * STIMER_HZ;
+            set_alarm(lora_at - now);
+            served++;
+        }
+        if (timer_at && wake >= timer_at)
+        {
+            CHECK(wake - timer_at < STIMER_HZ / configTICK_RATE_HZ + 1, "%s: timer served %llu ticks late",
+                  w->name, (unsigned long long)(wake - timer_at));
+            timer_at = event_at(start, w->timer_ms, ++timers);
+            served++;
+        }
+        if (ble_at && wake >= ble_at)
+        {
+            CHECK(wake == ble_at, "%s: BLE event served %llu ticks late", w->name,
+                  (unsigned long long)(wake - ble_at));
+            ble_at = event_at(start, w->ble_ms, ++ble_events);
+            served++;
+        }
+        CHECK(served, "%s: woken for nothing after %llu ms", w->name,
+              (unsigned long long)((wake - start) * 1000 / STIMER_HZ));
+
+        // Tasks run until the next idle period
+        now += WORK_TICKS;
+    }
+    check_stats(0);
+    udrv_powersave_get_stats(&stats);
+    CHECK(stats.idle_cnt[UDRV_PS_IDLE_NORMAL] == 0, "%s: %u normal idle sleeps", w->name,
+          stats.idle_cnt[UDRV_PS_IDLE_NORMAL]);
+    udrv_powersave_set_latency(UDRV_PS_LATENCY_BLE, UDRV_PS_LATENCY_ANY);
+    latency_us = UDRV_PS_LATENCY_ANY;
+    return stats.idle_cnt[UDRV_PS_IDLE_DEEP];
+}
+
+static void test_hour(void)
+{
+    printf("idle_sleep: wake-ups per hour, all of them from deep sleep:");
+    for (size_t i = 0; i < sizeof(workloads) / sizeof(workloads[0]); i++)
+    {
+        uint32_t wakeups = run_hour(&workloads[i]);
+
+        CHECK(wakeups == workloads[i].wakeups, "%s: %u wake-ups per hour, expected %u", workloads[i].name,
+              wakeups, workloads[i].wakeups);
+        printf("%s %s %u", (i == 0) ? "" : ",", workloads[i].name, wakeups);
+    }
+    printf("\n");
+}
+
+static void lora_timer_irq(void *m_data)
+{
+}
+
+int main(void)
+{
+    udrv_powersave_stats_t stats;
+
+    uhal_rtc_init(SYS_RTC_COUNTER_PORT, lora_timer_irq, STIMER_HZ);
+
+    test_random();
+    udrv_powersave_get_stats(&stats);
+    printf("idle_sleep: %d idle sleeps in %llu.%03llu s, %u normal and %u deep, asleep %.1f%%, woken by",
+           SLEEPS, (unsigned long long)(stats.elapsed_ms / 1000), (unsigned long long)(stats.elapsed_ms % 1000),
+           stats.idle_cnt[UDRV_PS_IDLE_NORMAL], stats.idle_cnt[UDRV_PS_IDLE_DEEP],
+           (stats.idle_residency_us[UDRV_PS_IDLE_NORMAL] + stats.idle_residency_us[UDRV_PS_IDLE_DEEP]) / 10.0 /
+           stats.elapsed_ms);
+    for (int i = 0; i < UDRV_PS_WAKE_SRC_MAX; i++)
+        printf("%s %s=%u", (i == 0) ? "" : ",", udrv_powersave_wake_source_name((UDRV_PS_WAKE_SRC)i),
+               stats.idle_wakeup_cnt[i]);
+    printf("\n");
+    test_reset();
+    test_alarm_wrap();
+    test_hour();
+
+    TEST_DONE("idle_sleep");
+}
@@ -0,0 +1,11 @@
+/* Host stand-in for service/nvm/service_nvm.h, only the configured datarate and TX power the link adaptation reads */
+#ifndef __SERVICE_NVM_H__
+#define __SERVICE_NVM_H__
+
+#include <stdint.h>
+#include "service_lora.h"
+
+SERVICE_LORA_DATA_RATE service_nvm_get_dr_from_nvm(void);
+uint8_t service_nvm_get_txpower_from_nvm(void);
+
+#endif
@@ -0,0 +1,1242 @@
+/*
+ * LoRaMac and the EU868 region on a virtual clock: OTAA join, unconfirmed and
+ * confirmed uplinks, a LinkADRReq applied to the following uplinks, the
+ * retransmission of a confirmed uplink whose first copy is lost, a run of
+ * confirmed uplinks on a busy, lossy channel, and the link adaptation of
+ * service_lora_linkq.c against ADR near the gateway and at the cell edge.
+ *
+ * The RTC backend counts 1 ms ticks that only move when nothing is left to do
+ * before the next timer or radio event, so windows and duty-cycle waits cost
+ * no wall time. The radio computes time on air, hands every uplink to a small
+ * network server and only delivers its answer to a receive window opened on
+ * the right frequency and spreading factor while the preamble arrives. On the
+ * air, frames can be lost at random and uplinks collide with those of other
+ * devices on the same channel and spreading factor, or fade below the
+ * demodulation floor over a set path loss.
+ *
+ * service_lora.c and LmHandler are not built here, they need FreeRTOS, udrv
+ * and service_nvm. Flash writes are counted the way OnNvmDataChange() in
+ * service_lora.c issues them, one udrv_flash_write() per context it stores,
+ * and the service_lora functions the link adaptation calls are mirrored on
+ * the MIB.
+ */
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "LoRaMac.h"
+#include "radio.h"
+#include "rtc-board.h"
+#include "utilities.h"
+#include "aes.h"
+#include "cmac.h"
+#include "service_lora.h"
+#include "service_lora_linkq.h"
+#include "service_nvm.h"
+#include "udrv_errno.h"
+#include "test.h"
+
+#define RX1_DELAY_MS        1000
+#define JOIN_DELAY_MS       5000
+#define TEST_NAME           (TIMER_PAIRING_HEAP ? "lorawan" : "lorawan_list")
+#define NET_ID              0x000013
+#define DEV_ADDR            0x26011234
+
+static const uint8_t dev_eui[8] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77 };
+static const uint8_t join_eui[8] = { 0x70, 0xB3, 0xD5, 0x7E, 0xD0, 0x00, 0x00, 0x01 };
+static const uint8_t app_key[16] = { 0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6,
+                                     0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C };
+
+//
+// Virtual RTC, one tick per millisecond
+//
+
+static uint32_t now = 1000;
+static uint32_t timer_context;
+static uint32_t alarm_at;
+static bool alarm_armed;
+static uint32_t bkup[2];
+
+void BoardCriticalSectionBegin(uint32_t *mask)
+{
+}
+
+void BoardCriticalSectionEnd(uint32_t *mask)
+{
+}
+
+void RtcInit(void)
+{
+}
+
+uint32_t RtcGetMinimumTimeout(void)
+{
+    return 1;
+}
+
+uint32_t RtcMs2Tick(TimerTime_t milliseconds)
+{
+    return milliseconds;
+}
+
+TimerTime_t RtcTick2Ms(uint32_t tick)
+{
+    return tick;
+}
+
+void RtcDelayMs(TimerTime_t milliseconds)
+{
+    now += milliseconds;
+}
+
+void RtcSetAlarm(uint32_t timeout)
+{
+    alarm_at = timer_context + timeout;
+    alarm_armed = true;
+}
+
+void RtcStartAlarm(uint32_t timeout)
+{
+    RtcSetAlarm(timeout);
+}
+
+void RtcStopAlarm(void)
+{
+    alarm_armed = false;
+}
+
+uint32_t RtcSetTimerContext(void)
+{
+    timer_context = now;
+    return timer_context;
+}
+
+uint32_t RtcGetTimerContext(void)
+{
+    return timer_context;
+}
+
+uint32_t RtcGetCalendarTime(uint16_t *milliseconds)
+{
+    *milliseconds = now % 1000;
+    return now / 1000;
+}
+
+uint32_t RtcGetTimerValue(void)
+{
+    return now;
+}
+
+uint32_t RtcGetTimerElapsedTime(void)
+{
+    return now - timer_context;
+}
+
+void RtcBkupWrite(uint32_t data0, uint32_t data1)
+{
+    bkup[0] = data0;
+    bkup[1] = data1;
+}
+
+void RtcBkupRead(uint32_t *data0, uint32_t *data1)
+{
+    *data0 = bkup[0];
+    *data1 = bkup[1];
+}
+
+void RtcProcess(void)
+{
+}
+
+TimerTime_t RtcTempCompensation(TimerTime_t period, float temperature)
+{
+    return period;
+}
+
+//
+// Network server, LoRaWAN 1.0.x session with a single device
+//
+
+static struct {
+    uint8_t nwk_s_key[16];
+    uint8_t app_s_key[16];
+    uint32_t join_nonce;
+    bool joined;
+    uint16_t fcnt_up;
+    uint16_t fcnt_down;
+    int frames;                         // uplinks heard, repetitions included
+    int lost;                           // uplinks still to be dropped on the air
+    uint8_t port;
+    uint8_t payload[64];
+    uint8_t payload_len;
+    uint8_t fopts[15];
+    uint8_t fopts_len;
+    uint8_t cmd[15];                    // MAC commands for the next downlink
+    uint8_t cmd_len;
+    uint8_t margin;                     // dB of the last uplink above the demodulation floor
+} ns;
+
+static void ns_cmac(const uint8_t *key, const uint8_t *b0, const uint8_t *msg, uint16_t len, uint8_t mic[4])
+{
+    AES_CMAC_CTX ctx;
+    uint8_t digest[AES_CMAC_DIGEST_LENGTH];
+
+    AES_CMAC_Init(&ctx);
+    AES_CMAC_SetKey(&ctx, key);
+    if (b0 != NULL)
+        AES_CMAC_Update(&ctx, b0, 16);
+    AES_CMAC_Update(&ctx, msg, len);
+    AES_CMAC_Final(digest, &ctx);
+    memcpy(mic, digest, 4);
+}
+
+static void ns_block(uint8_t *block, uint8_t first, uint8_t dir, uint32_t fcnt, uint8_t last)
+{
+    memset(block, 0, 16);
+    block[0] = first;
+    block[5] = dir;
+    block[6] = DEV_ADDR & 0xFF;
+    block[7] = (DEV_ADDR >> 8) & 0xFF;
+    block[8] = (DEV_ADDR >> 16) & 0xFF;
+    block[9] = (DEV_ADDR >> 24) & 0xFF;
+    block[10] = fcnt & 0xFF;
+    block[11] = (fcnt >> 8) & 0xFF;
+    block[15] = last;
+}
+
+static void ns_frame_mic(uint8_t dir, uint32_t fcnt, const uint8_t *msg, uint8_t len, uint8_t mic[4])
+{
+    uint8_t b0[16];
+
+    ns_block(b0, 0x49, dir, fcnt, len);
+    ns_cmac(ns.nwk_s_key, b0, msg, len, mic);
+}
+
+static void ns_payload_crypt(const uint8_t *key, uint8_t dir, uint32_t fcnt, uint8_t *buf, uint8_t len)
+{
+    aes_context ctx;
+    uint8_t a[16], s[16];
+
+    aes_set_key(key, 16, &ctx);
+    for (uint8_t i = 0; i < len; i += 16)
+    {
+        ns_block(a, 0x01, dir, fcnt, i / 16 + 1);
+        aes_encrypt(a, s, &ctx);
+        for (uint8_t j = 0; j < 16 && i + j < len; j++)
+            buf[i + j] ^= s[j];
+    }
+}
+
+static void ns_derive(uint8_t *key, uint8_t type, uint16_t dev_nonce)
+{
+    aes_context ctx;
+    uint8_t base[16] = { type, ns.join_nonce & 0xFF, (ns.join_nonce >> 8) & 0xFF, (ns.join_nonce >> 16) & 0xFF,
+                         NET_ID & 0xFF, (NET_ID >> 8) & 0xFF, (NET_ID >> 16) & 0xFF,
+                         dev_nonce & 0xFF, (dev_nonce >> 8) & 0xFF };
+
+    aes_set_key(app_key, 16, &ctx);
+    aes_encrypt(base, key, &ctx);
+}
+
+static uint8_t ns_join(const uint8_t *frame, uint8_t len, uint8_t *dl)
+{
+    aes_context ctx;
+    uint8_t mic[4];
+    uint16_t dev_nonce;
+
+    ns_cmac(app_key, NULL, frame, len - 4, mic);
+    CHECK(len == 23 && memcmp(mic, frame + len - 4, 4) == 0, "join request MIC");
+    for (int i = 0; i < 8; i++)
+        CHECK(frame[9 + i] == dev_eui[7 - i], "join request DevEUI byte %d", i);
+    dev_nonce = frame[17] | (frame[18] << 8);
+
+    ns.join_nonce++;
+    dl[0] = 0x20;
+    dl[1] = ns.join_nonce & 0xFF;
+    dl[2] = (ns.join_nonce >> 8) & 0xFF;
+    dl[3] = (ns.join_nonce >> 16) & 0xFF;
+    dl[4] = NET_ID & 0xFF;
+    dl[5] = (NET_ID >> 8) & 0xFF;
+    dl[6] = (NET_ID >> 16) & 0xFF;
+    dl[7] = DEV_ADDR & 0xFF;
+    dl[8] = (DEV_ADDR >> 8) & 0xFF;
+    dl[9] = (DEV_ADDR >> 16) & 0xFF;
+    dl[10] = (DEV_ADDR >> 24) & 0xFF;
+    dl[11] = 0x00;                      // RX1 DR offset 0, RX2 DR0
+    dl[12] = RX1_DELAY_MS / 1000;
+    ns_cmac(app_key, NULL, dl, 13, dl + 13);
+
+    // The device decrypts the accept with AES encrypt, so the server uses decrypt
+    aes_set_key(app_key, 16, &ctx);
+    aes_decrypt(dl + 1, dl + 1, &ctx);
+
+    ns_derive(ns.nwk_s_key, 0x01, dev_nonce);
+    ns_derive(ns.app_s_key, 0x02, dev_nonce);
+    ns.joined = true;
+    ns.fcnt_down = 0;
+    return 17;
+}
+
+// Returns the length of the downlink to send in RX1, 0 for none
+static uint8_t ns_uplink(const uint8_t *frame, uint8_t len, uint8_t *dl)
+{
+    uint8_t mic[4];
+    uint8_t mhdr = frame[0];
+    bool confirmed = mhdr == 0x80;
+    uint8_t pos;
+    uint8_t dl_len;
+
+    ns.frames++;
+    if (mhdr == 0x00)
+        return ns_join(frame, len, dl);
+
+    CHECK(ns.joined && (mhdr == 0x40 || mhdr == 0x80), "unexpected uplink MHDR %02x", mhdr);
+    if (!ns.joined || len < 12)
+        return 0;
+
+    ns.fcnt_up = frame[6] | (frame[7] << 8);
+    ns_frame_mic(0, ns.fcnt_up, frame, len - 4, mic);
+    CHECK(memcmp(mic, frame + len - 4, 4) == 0, "uplink %u MIC", ns.fcnt_up);
+    CHECK((uint32_t)(frame[1] | (frame[2] << 8) | (frame[3] << 16) | ((uint32_t)frame[4] << 24)) == DEV_ADDR,
+          "uplink DevAddr");
+
+    ns.fopts_len = frame[5] & 0x0F;
+    memcpy(ns.fopts, frame + 8, ns.fopts_len);
+    pos = 8 + ns.fopts_len;
+    ns.payload_len = 0;
+    if (len - 4 > pos)
+    {
+        ns.port = frame[pos++];
+        ns.payload_len = len - 4 - pos;
+        memcpy(ns.payload, frame + pos, ns.payload_len);
+        ns_payload_crypt(ns.port ? ns.app_s_key : ns.nwk_s_key, 0, ns.fcnt_up, ns.payload, ns.payload_len);
+    }
+
+    // LinkCheckReq, the only MAC command the device sends unasked here, gets the margin seen by one gateway
+    if (ns.fopts_len != 0 && ns.fopts[0] == 0x02 && ns.cmd_len + 3 <= sizeof(ns.cmd))
+    {
+        ns.cmd[ns.cmd_len++] = 0x02;
+        ns.cmd[ns.cmd_len++] = ns.margin;
+        ns.cmd[ns.cmd_len++] = 1;
+    }
+
+    if (!confirmed && ns.cmd_len == 0)
+        return 0;
+
+    dl[0] = 0x60;
+    dl[1] = DEV_ADDR & 0xFF;
+    dl[2] = (DEV_ADDR >> 8) & 0xFF;
+    dl[3] = (DEV_ADDR >> 16) & 0xFF;
+    dl[4] = (DEV_ADDR >> 24) & 0xFF;
+    dl[5] = (confirmed ? 0x20 : 0x00) | ns.cmd_len;
+    dl[6] = ns.fcnt_down & 0xFF;
+    dl[7] = (ns.fcnt_down >> 8) & 0xFF;
+    memcpy(dl + 8, ns.cmd, ns.cmd_len);
+    dl_len = 8 + ns.cmd_len;
+    ns_frame_mic(1, ns.fcnt_down, dl, dl_len, dl + dl_len);
+    ns.fcnt_down++;
+    ns.cmd_len = 0;
+    return dl_len + 4;
+}
+
+//
+// Air: random loss, path loss and the uplinks of other devices
+//
+
+#define AIR_OTHERS          64          // uplinks of other devices kept for the collision check
+
+static uint32_t radio_time_on_air(RadioModems_t modem, uint32_t bandwidth, uint32_t datarate, uint8_t coderate,
+                                  uint16_t preambleLen, bool fixLen, uint8_t payloadLen, bool crcOn);
+
+static struct {
+    uint32_t loss;                      // frames lost at random, per mille, both ways
+    uint32_t gap;                       // mean gap between uplinks of other devices in ms, 0 for none
+    int32_t path_loss;                  // dB from the device to the gateway, 0 for none
+    uint32_t seed;
+    uint32_t next_at;                   // start of the next uplink of another device
+    struct {
+        uint32_t start;
+        uint32_t end;
+        uint32_t freq;
+        uint32_t sf;
+    } others[AIR_OTHERS];
+    int nb_others;
+    int collisions;
+    int lost;
+    int faded;                          // uplinks below the demodulation floor
+} air = { .seed = 38 };
+
+static uint32_t air_random(uint32_t range)
+{
+    air.seed = air.seed * 1103515245 + 12345;
+    return (air.seed >> 8) % range;
+}
+
+static bool air_lost(void)
+{
+    if (air.loss == 0 || air_random(1000) >= air.loss)
+        return false;
+    air.lost++;
+    return true;
+}
+
+/* Whether an uplink sent with power dBm on sf is above the demodulation floor
+ * of the gateway, and by how many dB. The SNR is the power less the path loss
+ * over the -117 dBm noise of 125 kHz, give or take 4 dB of fading, the floor
+ * is -7.5 dB at SF7 and 2.5 dB lower per spreading factor. The gateway sends
+ * at 27 dBm, downlinks are not limited by the path loss here. */
+static bool air_demodulated(int8_t power, uint32_t sf, uint8_t *margin)
+{
+    int32_t snr_x10, floor_x10;
+
+    if (air.path_loss == 0)
+    {
+        *margin = 20;
+        return true;
+    }
+    snr_x10 = (power - air.path_loss + 117) * 10 + (int32_t)air_random(81) - 40;
+    floor_x10 = -75 - 25 * ((int32_t)sf - 7);
+    if (snr_x10 < floor_x10)
+    {
+        air.faded++;
+        return false;
+    }
+    *margin = (snr_x10 - floor_x10) / 10;
+    return true;
+}
+
+// Whether an uplink on freq and sf from start to end reaches the server
+static bool air_uplink(uint32_t freq, uint32_t sf, uint32_t start, uint32_t end)
+{
+    static const uint32_t channels[] = { 868100000, 868300000, 868500000 };
+    bool collided = false;
+
+    // Other devices send 20 bytes on the default channels at random spreading factors
+    while (air.gap != 0 && (int32_t)(air.next_at - end) < 0)
+    {
+        int i = air.nb_others++ % AIR_OTHERS;
+
+        air.others[i].sf = 7 + air_random(6);
+        air.others[i].freq = channels[air_random(3)];
+        air.others[i].start = air.next_at;
+        air.others[i].end = air.next_at + radio_time_on_air(MODEM_LORA, 0, air.others[i].sf, 1, 8, false, 20, true);
+        air.next_at += 1 + air_random(2 * air.gap);
+    }
+
+    // Without capture, neither of two overlapping frames on the same channel and spreading factor gets through
+    for (int i = 0; i < AIR_OTHERS && i < air.nb_others; i++)
+    {
+        if (air.others[i].freq == freq && air.others[i].sf == sf &&
+            (int32_t)(air.others[i].start - end) < 0 && (int32_t)(start - air.others[i].end) < 0)
+            collided = true;
+    }
+    if (collided)
+    {
+        air.collisions++;
+        return false;
+    }
+    return !air_lost();
+}
+
+//
+// Radio
+//
+
+static const RadioEvents_t *radio_events;
+static RadioState_t radio_state = RF_IDLE;
+static uint32_t radio_freq;
+static struct {
+    uint32_t bw;
+    uint32_t sf;
+    uint8_t cr;
+    uint16_t preamble;
+    uint16_t symb_timeout;
+    bool continuous;
+    int8_t power;
+} tx_cfg, rx_cfg;
+static uint32_t radio_event_at;
+static void (*radio_event)(void);
+static uint32_t radio_seed = 1;
+
+static struct {
+    uint8_t buf[64];
+    uint8_t len;
+    uint32_t at;                        // start of the preamble
+    uint32_t freq;
+    uint32_t sf;
+} downlink;
+
+static uint8_t rx_buf[64];
+static uint8_t rx_len;
+
+static struct {
+    int tx;
+    uint32_t airtime;
+    uint32_t last_sf;
+    int missed;                         // downlinks no receive window caught
+} radio_stats;
+
+static uint32_t radio_time_on_air(RadioModems_t modem, uint32_t bandwidth, uint32_t datarate, uint8_t coderate,
+                                  uint16_t preambleLen, bool fixLen, uint8_t payloadLen, bool crcOn)
+{
+    static const uint32_t bw_hz[] = { 125000, 250000, 500000 };
+    double tsym, payload;
+    int de;
+
+    if (modem == MODEM_FSK)
+        return (uint32_t)ceil((preambleLen + 3 + 1 + payloadLen + (crcOn ? 2 : 0)) * 8 * 1000.0 / datarate);
+
+    tsym = (double)(1 << datarate) * 1000 / bw_hz[bandwidth];
+    de = datarate >= 11 && bandwidth == 0;
+    payload = ceil((8.0 * payloadLen - 4.0 * datarate + 28 + (crcOn ? 16 : 0) - (fixLen ? 20 : 0)) /
+                   (4.0 * (datarate - 2 * de)));
+    if (payload < 0)
+        payload = 0;
+    return (uint32_t)ceil((preambleLen + 4.25 + 8 + payload * (coderate + 4)) * tsym);
+}
+
+static void radio_init(RadioEvents_t *events)
+{
+    radio_events = events;
+}
+
+static RadioState_t radio_get_status(void)
+{
+    return radio_state;
+}
+
+static void radio_set_modem(RadioModems_t modem)
+{
+}
+
+static void radio_set_channel(uint32_t freq)
+{
+    radio_freq = freq;
+}
+
+static bool radio_is_channel_free(uint32_t freq, uint32_t rxBandwidth, int16_t rssiThresh, uint32_t maxCarrierSenseTime)
+{
+    return true;
+}
+
+static uint32_t radio_random(void)
+{
+    radio_seed = radio_seed * 1103515245 + 12345;
+    return radio_seed >> 8;
+}
+
+static void radio_set_rx_config(RadioModems_t modem, uint32_t bandwidth, uint32_t datarate, uint8_t coderate,
+                                uint32_t bandwidthAfc, uint16_t preambleLen, uint16_t symbTimeout, bool fixLen,
+                                uint8_t payloadLen, bool crcOn, bool freqHopOn, uint8_t hopPeriod,
+                                bool iqInverted, bool rxContinuous)
+{
+    rx_cfg.bw = bandwidth;
+    rx_cfg.sf = datarate;
+    rx_cfg.cr = coderate;
+    rx_cfg.preamble = preambleLen;
+    rx_cfg.symb_timeout = symbTimeout;
+    rx_cfg.continuous = rxContinuous;
+}
+
+static void radio_set_tx_config(RadioModems_t modem, int8_t power, uint32_t fdev, uint32_t bandwidth,
+                                uint32_t datarate, uint8_t coderate, uint16_t preambleLen, bool fixLen,
+                                bool crcOn, bool freqHopOn, uint8_t hopPeriod, bool iqInverted, uint32_t timeout)
+{
+    tx_cfg.bw = bandwidth;
+    tx_cfg.sf = datarate;
+    tx_cfg.cr = coderate;
+    tx_cfg.preamble = preambleLen;
+    tx_cfg.power = power;
+}
+
+static bool radio_check_rf_frequency(uint32_t frequency)
+{
+    return true;
+}
+
+static void radio_tx_done(void)
+{
+    radio_state = RF_IDLE;
+    radio_events->TxDone();
+}
+
+static void radio_rx_done(void)
+{
+    radio_state = RF_IDLE;
+    memcpy(rx_buf, downlink.buf, downlink.len);
+    rx_len = downlink.len;
+    downlink.len = 0;
+    radio_events->RxDone(rx_buf, rx_len, -60, 8);
+}
+
+static void radio_rx_timeout(void)
+{
+    radio_state = RF_IDLE;
+    if (downlink.len != 0 && (int32_t)(now - downlink.at) >= 0)
+    {
+        radio_stats.missed++;
+        downlink.len = 0;
+    }
+    radio_events->RxTimeout();
+}
+
+static void radio_send(uint8_t *buffer, uint8_t size)
+{
+    uint32_t toa = radio_time_on_air(MODEM_LORA, tx_cfg.bw, tx_cfg.sf, tx_cfg.cr, tx_cfg.preamble,
+                                     false, size, true);
+    uint32_t delay;
+
+    radio_stats.tx++;
+    radio_stats.airtime += toa;
+    radio_stats.last_sf = tx_cfg.sf;
+
+    if (ns.lost > 0)
+        ns.lost--;
+    else if (air_demodulated(tx_cfg.power, tx_cfg.sf, &ns.margin) &&
+             air_uplink(radio_freq, tx_cfg.sf, now, now + toa))
+    {
+        delay = buffer[0] == 0x00 ? JOIN_DELAY_MS : RX1_DELAY_MS;
+        downlink.len = ns_uplink(buffer, size, downlink.buf);
+        if (downlink.len != 0 && air_lost())
+            downlink.len = 0;
+        downlink.at = now + toa + delay;
+        downlink.freq = radio_freq;
+        downlink.sf = tx_cfg.sf;
+    }
+
+    radio_state = RF_TX_RUNNING;
+    radio_event = radio_tx_done;
+    radio_event_at = now + toa;
+}
+
+static void radio_sleep(void)
+{
+    radio_state = RF_IDLE;
+    radio_event = NULL;
+}
+
+static void radio_rx(uint32_t timeout)
+{
+    double tsym = (double)(1 << rx_cfg.sf) * 1000 / (125000 << rx_cfg.bw);
+    uint32_t window = (uint32_t)ceil(rx_cfg.symb_timeout * tsym);
+    int32_t late = (int32_t)(now - downlink.at);
+
+    // A window opened after the preamble started still locks on while 4 of its symbols are left
+    radio_state = RF_RX_RUNNING;
+    if (downlink.len != 0 && downlink.freq == radio_freq && downlink.sf == rx_cfg.sf &&
+        late <= (int32_t)((rx_cfg.preamble - 4) * tsym) && (rx_cfg.continuous || -late <= (int32_t)window))
+    {
+        radio_event = radio_rx_done;
+        radio_event_at = downlink.at + radio_time_on_air(MODEM_LORA, rx_cfg.bw, rx_cfg.sf, rx_cfg.cr,
+                                                         rx_cfg.preamble, false, downlink.len, false);
+    }
+    else if (rx_cfg.continuous)
+        radio_event = NULL;
+    else
+    {
+        radio_event = radio_rx_timeout;
+        radio_event_at = now + window;
+    }
+}
+
+static void radio_start_cad(void)
+{
+}
+
+static void radio_set_tx_continuous_wave(uint32_t freq, int8_t power, uint16_t time)
+{
+}
+
+static int16_t radio_rssi(RadioModems_t modem)
+{
+    return -120;
+}
+
+static void radio_write(uint32_t addr, uint8_t data)
+{
+}
+
+static uint8_t radio_read(uint32_t addr)
+{
+    return 0;
+}
+
+static void radio_write_buffer(uint32_t addr, uint8_t *buffer, uint8_t size)
+{
+}
+
+static void radio_read_buffer(uint32_t addr, uint8_t *buffer, uint8_t size)
+{
+}
+
+static void radio_set_max_payload_length(RadioModems_t modem, uint8_t max)
+{
+}
+
+static void radio_set_public_network(bool enable)
+{
+}
+
+static uint32_t radio_get_wakeup_time(void)
+{
+    return 1;
+}
+
+static void radio_irq_process(void)
+{
+}
+
+static void radio_set_rx_duty_cycle(uint32_t rxTime, uint32_t sleepTime)
+{
+}
+
+const struct Radio_s Radio = {
+    .Init = radio_init,
+    .GetStatus = radio_get_status,
+    .SetModem = radio_set_modem,
+    .SetChannel = radio_set_channel,
+    .IsChannelFree = radio_is_channel_free,
+    .Random = radio_random,
+    .SetRxConfig = radio_set_rx_config,
+    .SetTxConfig = radio_set_tx_config,
+    .CheckRfFrequency = radio_check_rf_frequency,
+    .TimeOnAir = radio_time_on_air,
+    .Send = radio_send,
+    .Sleep = radio_sleep,
+    .Standby = radio_sleep,
+    .Rx = radio_rx,
+    .StartCad = radio_start_cad,
+    .SetTxContinuousWave = radio_set_tx_continuous_wave,
+    .Rssi = radio_rssi,
+    .Write = radio_write,
+    .Read = radio_read,
+    .WriteBuffer = radio_write_buffer,
+    .ReadBuffer = radio_read_buffer,
+    .SetMaxPayloadLength = radio_set_max_payload_length,
+    .SetPublicNetwork = radio_set_public_network,
+    .GetWakeupTime = radio_get_wakeup_time,
+    .IrqProcess = radio_irq_process,
+    .RxBoosted = radio_rx,
+    .SetRxDutyCycle = radio_set_rx_duty_cycle,
+};
+
+//
+// MAC callbacks and the event loop
+//
+
+static bool mlme_done, mcps_done;
+static MlmeConfirm_t mlme_confirm;
+static McpsConfirm_t mcps_confirm;
+static McpsIndication_t mcps_indication;
+static int flash_writes;
+
+static void mcps_confirm_cb(McpsConfirm_t *confirm)
+{
+    mcps_confirm = *confirm;
+    mcps_done = true;
+    if (confirm->McpsRequest == MCPS_CONFIRMED)
+        service_lora_linkq_tx(confirm->AckReceived);
+}
+
+static void mcps_indication_cb(McpsIndication_t *indication)
+{
+    mcps_indication = *indication;
+}
+
+static void mlme_confirm_cb(MlmeConfirm_t *confirm)
+{
+    mlme_confirm = *confirm;
+    mlme_done = true;
+    if (confirm->MlmeRequest == MLME_LINK_CHECK && confirm->Status == LORAMAC_EVENT_INFO_STATUS_OK)
+        service_lora_linkq_margin(confirm->DemodMargin);
+}
+
+static void mlme_indication_cb(MlmeIndication_t *indication)
+{
+}
+
+static uint8_t get_battery_level(void)
+{
+    return 254;
+}
+
+static float get_temperature_level(void)
+{
+    return 25;
+}
+
+// As OnNvmDataChange() in service_lora.c, which writes flash once for each of these contexts
+static void nvm_data_change(uint16_t notifyFlags)
+{
+    static const uint16_t stored[] = {
+        LORAMAC_NVM_NOTIFY_FLAG_CRYPTO, LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP1, LORAMAC_NVM_NOTIFY_FLAG_MAC_GROUP2,
+        LORAMAC_NVM_NOTIFY_FLAG_SECURE_ELEMENT, LORAMAC_NVM_NOTIFY_FLAG_REGION_GROUP2,
+    };
+
+    if (notifyFlags == LORAMAC_NVM_NOTIFY_FLAG_NONE || LoRaMacStop() != LORAMAC_STATUS_OK)
+        return;
+    for (int i = 0; i < sizeof(stored) / sizeof(stored[0]); i++)
+    {
+        if (notifyFlags & stored[i])
+            flash_writes++;
+    }
+    LoRaMacStart();
+}
+
+static void mac_process_notify(void)
+{
+}
+
+// Process the MAC and advance to the next event until done is set or limit ms have passed
+static bool run(bool *done, uint32_t limit)
+{
+    uint32_t end = now + limit;
+
+    for (;;)
+    {
+        LoRaMacProcess();
+        if (done != NULL && *done)
+            return true;
+
+        if (radio_event != NULL && (!alarm_armed || (int32_t)(radio_event_at - alarm_at) <= 0) &&
+            (int32_t)(radio_event_at - end) <= 0)
+        {
+            void (*event)(void) = radio_event;
+
+            if ((int32_t)(radio_event_at - now) > 0)
+                now = radio_event_at;
+            radio_event = NULL;
+            event();
+        }
+        else if (alarm_armed && (int32_t)(alarm_at - end) <= 0)
+        {
+            if ((int32_t)(alarm_at - now) > 0)
+                now = alarm_at;
+            alarm_armed = false;
+            TimerIrqHandler();
+        }
+        else
+        {
+            now = end;
+            return false;
+        }
+    }
+}
+
+static void mib_set(Mib_t type, MibRequestConfirm_t *mib)
+{
+    mib->Type = type;
+    CHECK(LoRaMacMibSetRequestConfirm(mib) == LORAMAC_STATUS_OK, "MIB %d", type);
+}
+
+//
+// What the link adaptation uses of service_lora and service_nvm
+//
+
+static struct {
+    SERVICE_LORA_DATA_RATE dr;
+    uint8_t txpower;
+    bool adr;
+    bool linkcheck;                     // a LinkCheckReq with every uplink
+} nvm = { .dr = SERVICE_LORA_DR_5, .adr = true };
+
+SERVICE_LORA_DATA_RATE service_nvm_get_dr_from_nvm(void)
+{
+    return nvm.dr;
+}
+
+uint8_t service_nvm_get_txpower_from_nvm(void)
+{
+    return nvm.txpower;
+}
+
+SERVICE_LORA_BAND service_lora_get_band(void)
+{
+    return SERVICE_LORA_EU868;
+}
+
+bool service_lora_get_adr(void)
+{
+    return nvm.adr;
+}
+
+static int32_t mib_status(LoRaMacStatus_t status)
+{
+    if (status == LORAMAC_STATUS_OK)
+        return UDRV_RETURN_OK;
+    return status == LORAMAC_STATUS_PARAMETER_INVALID ? -UDRV_WRONG_ARG : -UDRV_INTERNAL_ERR;
+}
+
+int32_t service_lora_set_dr(SERVICE_LORA_DATA_RATE dr, bool commit)
+{
+    MibRequestConfirm_t mib;
+
+    mib.Type = MIB_CHANNELS_DATARATE;
+    mib.Param.ChannelsDatarate = (int8_t)dr;
+    return mib_status(LoRaMacMibSetRequestConfirm(&mib));
+}
+
+int32_t service_lora_set_txpower(uint8_t txp, bool commit)
+{
+    MibRequestConfirm_t mib;
+
+    mib.Type = MIB_CHANNELS_TX_POWER;
+    mib.Param.ChannelsTxPower = txp;
+    return mib_status(LoRaMacMibSetRequestConfirm(&mib));
+}
+
+// Send once the duty cycle allows it and wait for the confirm
+static bool send(bool confirmed, uint8_t port, const char *text)
+{
+    McpsReq_t req;
+    MlmeReq_t link_check = { .Type = MLME_LINK_CHECK };
+    LoRaMacStatus_t status;
+    SERVICE_LORA_DATA_RATE dr = nvm.dr;
+
+    // As service_lora_send(), the datarate is the configured one unless the link adaptation picks another
+    service_lora_linkq_apply(&dr);
+    memset(&req, 0, sizeof(req));
+    if (confirmed)
+    {
+        req.Type = MCPS_CONFIRMED;
+        req.Req.Confirmed.fPort = port;
+        req.Req.Confirmed.fBuffer = (void *)text;
+        req.Req.Confirmed.fBufferSize = strlen(text);
+        req.Req.Confirmed.Datarate = dr;
+    }
+    else
+    {
+        req.Type = MCPS_UNCONFIRMED;
+        req.Req.Unconfirmed.fPort = port;
+        req.Req.Unconfirmed.fBuffer = (void *)text;
+        req.Req.Unconfirmed.fBufferSize = strlen(text);
+        req.Req.Unconfirmed.Datarate = dr;
+    }
+    if (nvm.linkcheck)
+        CHECK(LoRaMacMlmeRequest(&link_check) == LORAMAC_STATUS_OK, "link check request for \"%s\"", text);
+
+    mcps_done = false;
+    memset(&mcps_indication, 0, sizeof(mcps_indication));
+    for (int tries = 0; tries < 10; tries++)
+    {
+        status = LoRaMacMcpsRequest(&req);
+        if (status != LORAMAC_STATUS_DUTYCYCLE_RESTRICTED)
+            break;
+        run(NULL, req.ReqReturn.DutyCycleWaitTime);
+    }
+    CHECK(status == LORAMAC_STATUS_OK, "MCPS request status %d", status);
+    if (status != LORAMAC_STATUS_OK)
+        return false;
+
+    CHECK(run(&mcps_done, 60000), "no MCPS confirm for \"%s\"", text);
+    return mcps_done;
+}
+
+// Send on a clean channel, the server has to get it
+static bool uplink(bool confirmed, uint8_t port, const char *text)
+{
+    if (!send(confirmed, port, text))
+        return false;
+    CHECK(mcps_confirm.Status == LORAMAC_EVENT_INFO_STATUS_OK, "MCPS confirm status %d", mcps_confirm.Status);
+    CHECK(ns.payload_len == strlen(text) && memcmp(ns.payload, text, ns.payload_len) == 0 && ns.port == port,
+          "server got \"%.*s\" on port %u", ns.payload_len, ns.payload, ns.port);
+    return true;
+}
+
+//
+// Tests
+//
+
+static uint32_t join_ms;
+
+static void test_join(void)
+{
+    MlmeReq_t req;
+    MibRequestConfirm_t mib;
+    uint32_t start = now;
+
+    memset(&req, 0, sizeof(req));
+    req.Type = MLME_JOIN;
+    req.Req.Join.NetworkActivation = ACTIVATION_TYPE_OTAA;
+    req.Req.Join.Datarate = DR_5;
+    CHECK(LoRaMacMlmeRequest(&req) == LORAMAC_STATUS_OK, "join request");
+
+    CHECK(run(&mlme_done, 60000), "no join confirm");
+    CHECK(mlme_confirm.MlmeRequest == MLME_JOIN && mlme_confirm.Status == LORAMAC_EVENT_INFO_STATUS_OK,
+          "join confirm status %d", mlme_confirm.Status);
+    join_ms = now - start;
+    CHECK(join_ms >= JOIN_DELAY_MS && join_ms < JOIN_DELAY_MS + 1000, "join took %u ms", join_ms);
+
+    mib.Type = MIB_DEV_ADDR;
+    LoRaMacMibGetRequestConfirm(&mib);
+    CHECK(mib.Param.DevAddr == DEV_ADDR, "DevAddr %08x", mib.Param.DevAddr);
+    mib.Type = MIB_NETWORK_ACTIVATION;
+    LoRaMacMibGetRequestConfirm(&mib);
+    CHECK(mib.Param.NetworkActivation == ACTIVATION_TYPE_OTAA, "not activated");
+
+    mib.Param.ChannelsDatarate = DR_5;
+    mib_set(MIB_CHANNELS_DATARATE, &mib);
+}
+
+static void test_unconfirmed(void)
+{
+    int frames = ns.frames;
+    uint16_t fcnt;
+
+    uplink(false, 2, "hello");
+    fcnt = ns.fcnt_up;
+    CHECK(mcps_confirm.NbTrans == 1 && !mcps_confirm.AckReceived, "unconfirmed NbTrans %u", mcps_confirm.NbTrans);
+    CHECK(mcps_confirm.UpLinkCounter == fcnt, "confirm FCnt %u, sent %u", mcps_confirm.UpLinkCounter, fcnt);
+    uplink(false, 3, "a longer payload that spans two AES blocks");
+    CHECK(ns.fcnt_up == (uint16_t)(fcnt + 1), "second FCnt %u after %u", ns.fcnt_up, fcnt);
+    CHECK(ns.frames == frames + 2, "%d frames heard", ns.frames - frames);
+    CHECK(radio_stats.last_sf == 7, "DR5 sent on SF%u", radio_stats.last_sf);
+}
+
+static void test_confirmed(void)
+{
+    uplink(true, 2, "ack me");
+    CHECK(mcps_confirm.AckReceived && mcps_confirm.NbTrans == 1, "ack %d after %u transmissions",
+          mcps_confirm.AckReceived, mcps_confirm.NbTrans);
+    CHECK(mcps_indication.AckReceived && mcps_indication.RxSlot == RX_SLOT_WIN_1, "ack not seen in RX1");
+}
+
+static void test_link_adr(void)
+{
+    int frames;
+
+    // LinkADRReq: DR3 at max power, channels 0-2, two transmissions per uplink
+    ns.cmd[0] = 0x03;
+    ns.cmd[1] = 0x30;
+    ns.cmd[2] = 0x07;
+    ns.cmd[3] = 0x00;
+    ns.cmd[4] = 0x02;
+    ns.cmd_len = 5;
+    uplink(false, 2, "adr");
+
+    frames = ns.frames;
+    uplink(false, 2, "after adr");
+    CHECK(radio_stats.last_sf == 9, "DR3 sent on SF%u", radio_stats.last_sf);
+    CHECK(ns.fopts_len == 2 && ns.fopts[0] == 0x03 && ns.fopts[1] == 0x07, "LinkADRAns %u bytes %02x %02x",
+          ns.fopts_len, ns.fopts[0], ns.fopts[1]);
+    CHECK(mcps_confirm.NbTrans == 2 && ns.frames == frames + 2, "NbTrans %u, %d frames heard",
+          mcps_confirm.NbTrans, ns.frames - frames);
+}
+
+static void test_retransmission(void)
+{
+    uint16_t fcnt = ns.fcnt_up;
+
+    ns.lost = 1;
+    uplink(true, 2, "retry");
+    CHECK(mcps_confirm.AckReceived && mcps_confirm.NbTrans == 2, "ack %d after %u transmissions",
+          mcps_confirm.AckReceived, mcps_confirm.NbTrans);
+    CHECK(ns.fcnt_up == (uint16_t)(fcnt + 1), "retransmission FCnt %u", ns.fcnt_up);
+}
+
+/* Confirmed uplinks with up to four transmissions each, while 10% of the
+ * frames are lost and other devices send every 200 ms on average. */
+static struct {
+    int uplinks;
+    int acked;
+    int tx;
+} lossy;
+
+static void test_lossy_air(void)
+{
+    MibRequestConfirm_t mib;
+    char text[24];
+    uint32_t fcnt = 0;
+    int tx = radio_stats.tx;
+
+    mib.Param.ChannelsNbTrans = 4;
+    mib_set(MIB_CHANNELS_NB_TRANS, &mib);
+    air.loss = 100;
+    air.gap = 200;
+    air.next_at = now;
+
+    for (lossy.uplinks = 0; lossy.uplinks < 100; lossy.uplinks++)
+    {
+        snprintf(text, sizeof(text), "lossy %d", lossy.uplinks);
+        if (!send(true, 2, text))
+            break;
+        CHECK(mcps_confirm.NbTrans >= 1 && mcps_confirm.NbTrans <= 4, "%s: %u transmissions", text,
+              mcps_confirm.NbTrans);
+        if (lossy.uplinks > 0)
+            CHECK(mcps_confirm.UpLinkCounter == fcnt + 1, "%s: FCnt %u after %u", text, mcps_confirm.UpLinkCounter,
+                  fcnt);
+        fcnt = mcps_confirm.UpLinkCounter;
+        lossy.tx += mcps_confirm.NbTrans;
+        if (!mcps_confirm.AckReceived)
+        {
+            CHECK(mcps_confirm.NbTrans == 4, "%s: given up after %u transmissions", text, mcps_confirm.NbTrans);
+            continue;
+        }
+        // Only a frame the server heard can be acked
+        lossy.acked++;
+        CHECK(ns.fcnt_up == (uint16_t)fcnt && ns.payload_len == strlen(text) &&
+              memcmp(ns.payload, text, ns.payload_len) == 0, "%s acked, the server got FCnt %u", text, ns.fcnt_up);
+    }
+    air.loss = 0;
+    air.gap = 0;
+
+    CHECK(radio_stats.tx - tx == lossy.tx, "%d transmissions for %d counted in the confirms", radio_stats.tx - tx,
+          lossy.tx);
+    CHECK(air.collisions > 0 && air.lost > 0, "%d collisions, %d frames lost", air.collisions, air.lost);
+    CHECK(lossy.tx > lossy.uplinks, "no uplink was repeated");
+    CHECK(lossy.acked >= lossy.uplinks * 9 / 10, "%d of %d uplinks acked", lossy.acked, lossy.uplinks);
+}
+
+/* Confirmed uplinks with a LinkCheckReq each from DR2 at full power, near the
+ * gateway and at the edge of the cell: with ADR, where the network server
+ * sends no LinkADRReq and the datarate stays where it is, and with the link
+ * adaptation moving by the LinkCheckAns margins and the lost uplinks. */
+#define PATH_UPLINKS        40
+
+static struct {
+    int32_t path_loss;
+    bool adapt;
+    int acked;
+    uint32_t airtime;
+    int8_t dr;                          // where the link adaptation ended
+    int8_t txpower;
+} path[] = {
+    { 115, false }, { 115, true }, { 146, false }, { 146, true },
+};
+
+static void test_path_loss(void)
+{
+    MibRequestConfirm_t mib;
+    service_lora_linkq_t linkq;
+    char text[24];
+
+    mib.Param.ChannelsNbTrans = 1;
+    mib_set(MIB_CHANNELS_NB_TRANS, &mib);
+    nvm.dr = SERVICE_LORA_DR_2;
+    nvm.txpower = 0;
+    nvm.linkcheck = true;
+
+    for (int r = 0; r < sizeof(path) / sizeof(path[0]); r++)
+    {
+        uint32_t airtime = radio_stats.airtime;
+
+        nvm.adr = !path[r].adapt;
+        mib.Param.AdrEnable = nvm.adr;
+        mib_set(MIB_ADR, &mib);
+        CHECK(service_lora_set_dr(nvm.dr, false) == UDRV_RETURN_OK, "DR%d not set", nvm.dr);
+        CHECK(service_lora_set_txpower(nvm.txpower, false) == UDRV_RETURN_OK, "TX power %u not set", nvm.txpower);
+        service_lora_set_link_adapt(path[r].adapt);
+        air.path_loss = path[r].path_loss;
+
+        for (int i = 0; i < PATH_UPLINKS; i++)
+        {
+            snprintf(text, sizeof(text), "path %d", i);
+            if (!send(true, 2, text))
+                break;
+            if (mcps_confirm.AckReceived)
+                path[r].acked++;
+        }
+        path[r].airtime = radio_stats.airtime - airtime;
+        air.path_loss = 0;
+
+        service_lora_linkq_get(&linkq);
+        path[r].dr = linkq.dr;
+        path[r].txpower = linkq.txpower;
+        service_lora_set_link_adapt(false);
+        if (!path[r].adapt)
+            continue;
+
+        // Switching it off puts the configured datarate and TX power back, not the adapted ones
+        mib.Type = MIB_CHANNELS_DATARATE;
+        LoRaMacMibGetRequestConfirm(&mib);
+        CHECK(mib.Param.ChannelsDatarate == nvm.dr, "%d dB: DR%d left after DR%d", path[r].path_loss,
+              mib.Param.ChannelsDatarate, path[r].dr);
+        mib.Type = MIB_CHANNELS_TX_POWER;
+        LoRaMacMibGetRequestConfirm(&mib);
+        CHECK(mib.Param.ChannelsTxPower == nvm.txpower, "%d dB: TX power %d left after %d", path[r].path_loss,
+              mib.Param.ChannelsTxPower, path[r].txpower);
+    }
+    nvm.dr = SERVICE_LORA_DR_5;
+    nvm.adr = true;
+    nvm.linkcheck = false;
+    mib.Param.AdrEnable = true;
+    mib_set(MIB_ADR, &mib);
+
+    // Near the gateway: as many uplinks get through on a fraction of the airtime, at less power
+    CHECK(path[1].dr == LINKQ_MAX_DR && path[1].txpower > 0, "115 dB: adapted to DR%d, TX power %d", path[1].dr,
+          path[1].txpower);
+    CHECK(path[1].acked >= path[0].acked && path[1].airtime * 2 < path[0].airtime,
+          "115 dB: %d acked in %u ms with the adaptation, %d in %u ms with ADR", path[1].acked, path[1].airtime,
+          path[0].acked, path[0].airtime);
+    // At the edge: ADR keeps losing uplinks on DR2, the adaptation moves down to DR0 and gets them through
+    CHECK(path[3].dr == DR_0 && path[3].txpower == 0, "146 dB: adapted to DR%d, TX power %d", path[3].dr,
+          path[3].txpower);
+    CHECK(path[2].acked < PATH_UPLINKS && path[3].acked > path[2].acked,
+          "146 dB: %d acked with the adaptation, %d with ADR", path[3].acked, path[2].acked);
+    CHECK(air.faded > 0, "no uplink faded");
+}
+
+int main(void)
+{
+    LoRaMacPrimitives_t primitives = {
+        .MacMcpsConfirm = mcps_confirm_cb,
+        .MacMcpsIndication = mcps_indication_cb,
+        .MacMlmeConfirm = mlme_confirm_cb,
+        .MacMlmeIndication = mlme_indication_cb,
+    };
+    LoRaMacCallback_t callbacks = {
+        .GetBatteryLevel = get_battery_level,
+        .GetTemperatureLevel = get_temperature_level,
+        .NvmDataChange = nvm_data_change,
+        .MacProcessNotify = mac_process_notify,
+    };
+    MibRequestConfirm_t mib;
+    struct timespec t0, t1;
+    uint32_t start;
+    int tx;
+
+    CHECK(LoRaMacInitialization(&primitives, &callbacks, LORAMAC_REGION_EU868) == LORAMAC_STATUS_OK, "init");
+    mib.Param.DevEui = (uint8_t *)dev_eui;
+    mib_set(MIB_DEV_EUI, &mib);
+    mib.Param.JoinEui = (uint8_t *)join_eui;
+    mib_set(MIB_JOIN_EUI, &mib);
+    mib.Param.AppKey = (uint8_t *)app_key;
+    mib_set(MIB_APP_KEY, &mib);
+    mib.Param.NwkKey = (uint8_t *)app_key;
+    mib_set(MIB_NWK_KEY, &mib);
+    mib.Param.EnablePublicNetwork = true;
+    mib_set(MIB_PUBLIC_NETWORK, &mib);
+    mib.Param.AdrEnable = true;
+    mib_set(MIB_ADR, &mib);
+    LoRaMacStart();
+
+    start = now;
+    test_join();
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t0);
+    tx = radio_stats.tx;
+    test_unconfirmed();
+    test_confirmed();
+    test_link_adr();
+    test_retransmission();
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t1);
+    tx = radio_stats.tx - tx;
+    test_lossy_air();
+    test_path_loss();
+
+    CHECK(radio_stats.missed == 0, "%d downlinks missed", radio_stats.missed);
+    // EU868 grants 1% of an hour as duty-cycle time credits up front and refills them as time passes
+    CHECK(radio_stats.airtime <= 36000 + (now - start) / 100, "%u ms on air in %u ms", radio_stats.airtime,
+          now - start);
+
+    printf("%s: join %u ms, %d transmissions, %u ms on air in %u s (%.2f%%), %.1f us CPU per transmission, "
+           "%d flash writes; lossy air: %d/%d acked in %d transmissions, %d collisions, %d frames lost; "
+           "ADR/link adaptation at %d dB: %d/%d acked in %u/%u ms on air, at %d dB: %d/%d in %u/%u ms\n",
+           TEST_NAME, join_ms, tx, radio_stats.airtime, (now - start) / 1000,
+           radio_stats.airtime * 100.0 / (now - start),
+           ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / 1000 / (tx ? tx : 1), flash_writes,
+           lossy.acked, lossy.uplinks, lossy.tx, air.collisions, air.lost, path[0].path_loss, path[0].acked,
+           path[1].acked, path[0].airtime, path[1].airtime, path[2].path_loss, path[2].acked, path[3].acked,
+           path[2].airtime, path[3].airtime);
+    TEST_DONE(TEST_NAME);
+}
@@ -0,0 +1,269 @@
+/*
+ * The MAC command list as it was before the free slot stack and the
+ * previous links: a slot is free when all of its bytes are zero and the
+ * previous element is found from the head of the list. Kept as the
+ * reference and benchmark baseline, with the same statuses as the
+ * LoRaMacCommands API.
+ */
+#include <string.h>
+#include "utilities.h"
+#include "LoRaMacCommands.h"
+#include "maccmds_ref.h"
+
+#define NUM_OF_MAC_COMMANDS 32
+#define CID_FIELD_SIZE 1
+
+typedef struct sRefCommandsList
+{
+    RefCommand_t* First;
+    RefCommand_t* Last;
+} RefCommandsList_t;
+
+static struct
+{
+    RefCommandsList_t MacCommandList;
+    RefCommand_t MacCommandSlots[NUM_OF_MAC_COMMANDS];
+    size_t SerializedCmdsSize;
+} RefCtx;
+
+static bool IsSlotFree( const RefCommand_t* slot )
+{
+    uint8_t* mem = ( uint8_t* )slot;
+
+    for( uint16_t size = 0; size < sizeof( RefCommand_t ); size++ )
+    {
+        if( mem[size] != 0x00 )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static RefCommand_t* MallocNewMacCommandSlot( void )
+{
+    uint8_t itr = 0;
+
+    while( IsSlotFree( ( const RefCommand_t* )&RefCtx.MacCommandSlots[itr] ) == false )
+    {
+        itr++;
+        if( itr == NUM_OF_MAC_COMMANDS )
+        {
+            return NULL;
+        }
+    }
+
+    return &RefCtx.MacCommandSlots[itr];
+}
+
+static bool FreeMacCommandSlot( RefCommand_t* slot )
+{
+    if( slot == NULL )
+    {
+        return false;
+    }
+
+    memset1( ( uint8_t* )slot, 0x00, sizeof( RefCommand_t ) );
+
+    return true;
+}
+
+static void LinkedListAdd( RefCommandsList_t* list, RefCommand_t* element )
+{
+    if( list->First == NULL )
+    {
+        list->First = element;
+    }
+    if( list->Last )
+    {
+        list->Last->Next = element;
+    }
+    element->Next = NULL;
+    list->Last = element;
+}
+
+static RefCommand_t* LinkedListGetPrevious( RefCommandsList_t* list, RefCommand_t* element )
+{
+    RefCommand_t* curElement = list->First;
+
+    if( element != curElement )
+    {
+        while( ( curElement != NULL ) && ( curElement->Next != element ) )
+        {
+            curElement = curElement->Next;
+        }
+    }
+    else
+    {
+        curElement = NULL;
+    }
+
+    return curElement;
+}
+
+static void LinkedListRemove( RefCommandsList_t* list, RefCommand_t* element )
+{
+    RefCommand_t* PrevElement = LinkedListGetPrevious( list, element );
+
+    if( list->First == element )
+    {
+        list->First = element->Next;
+    }
+    if( list->Last == element )
+    {
+        list->Last = PrevElement;
+    }
+    if( PrevElement != NULL )
+    {
+        PrevElement->Next = element->Next;
+    }
+    element->Next = NULL;
+}
+
+static bool IsSticky( uint8_t cid )
+{
+    switch( cid )
+    {
+        case MOTE_MAC_RESET_IND:
+        case MOTE_MAC_REKEY_IND:
+        case MOTE_MAC_DEVICE_MODE_IND:
+        case MOTE_MAC_DL_CHANNEL_ANS:
+        case MOTE_MAC_RX_PARAM_SETUP_ANS:
+        case MOTE_MAC_RX_TIMING_SETUP_ANS:
+        case MOTE_MAC_TX_PARAM_SETUP_ANS:
+        case MOTE_MAC_PING_SLOT_CHANNEL_ANS:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool IsConfirmationRequired( uint8_t cid )
+{
+    switch( cid )
+    {
+        case MOTE_MAC_RESET_IND:
+        case MOTE_MAC_REKEY_IND:
+        case MOTE_MAC_DEVICE_MODE_IND:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void RefCommandsInit( void )
+{
+    memset1( ( uint8_t* )&RefCtx, 0, sizeof( RefCtx ) );
+}
+
+LoRaMacCommandStatus_t RefCommandsAddCmd( uint8_t cid, uint8_t* payload, size_t payloadSize )
+{
+    RefCommand_t* newCmd = MallocNewMacCommandSlot( );
+
+    if( newCmd == NULL )
+    {
+        return LORAMAC_COMMANDS_ERROR_MEMORY;
+    }
+    LinkedListAdd( &RefCtx.MacCommandList, newCmd );
+
+    newCmd->CID = cid;
+    newCmd->PayloadSize = payloadSize;
+    memcpy1( ( uint8_t* )newCmd->Payload, payload, payloadSize );
+    newCmd->IsSticky = IsSticky( cid );
+    newCmd->IsConfirmationRequired = IsConfirmationRequired( cid );
+
+    RefCtx.SerializedCmdsSize += ( CID_FIELD_SIZE + payloadSize );
+
+    return LORAMAC_COMMANDS_SUCCESS;
+}
+
+LoRaMacCommandStatus_t RefCommandsRemoveCmd( RefCommand_t* macCmd )
+{
+    LinkedListRemove( &RefCtx.MacCommandList, macCmd );
+    RefCtx.SerializedCmdsSize -= ( CID_FIELD_SIZE + macCmd->PayloadSize );
+    FreeMacCommandSlot( macCmd );
+
+    return LORAMAC_COMMANDS_SUCCESS;
+}
+
+LoRaMacCommandStatus_t RefCommandsGetCmd( uint8_t cid, RefCommand_t** macCmd )
+{
+    RefCommand_t* curElement = RefCtx.MacCommandList.First;
+
+    while( ( curElement != NULL ) && ( curElement->CID != cid ) )
+    {
+        curElement = curElement->Next;
+    }
+    *macCmd = curElement;
+
+    return curElement == NULL ? LORAMAC_COMMANDS_ERROR_CMD_NOT_FOUND : LORAMAC_COMMANDS_SUCCESS;
+}
+
+void RefCommandsRemoveNoneStickyCmds( void )
+{
+    RefCommand_t* curElement = RefCtx.MacCommandList.First;
+    RefCommand_t* nexElement;
+
+    while( curElement != NULL )
+    {
+        nexElement = curElement->Next;
+        if( curElement->IsSticky == false )
+        {
+            RefCommandsRemoveCmd( curElement );
+        }
+        curElement = nexElement;
+    }
+}
+
+void RefCommandsRemoveStickyAnsCmds( void )
+{
+    RefCommand_t* curElement = RefCtx.MacCommandList.First;
+    RefCommand_t* nexElement;
+
+    while( curElement != NULL )
+    {
+        nexElement = curElement->Next;
+        if( ( IsSticky( curElement->CID ) == true ) &&
+            ( IsConfirmationRequired( curElement->CID ) == false ) )
+        {
+            RefCommandsRemoveCmd( curElement );
+        }
+        curElement = nexElement;
+    }
+}
+
+size_t RefCommandsGetSizeSerializedCmds( void )
+{
+    return RefCtx.SerializedCmdsSize;
+}
+
+size_t RefCommandsSerializeCmds( size_t availableSize, uint8_t* buffer )
+{
+    RefCommand_t* curElement = RefCtx.MacCommandList.First;
+    RefCommand_t* nextElement;
+    uint8_t itr = 0;
+
+    while( curElement != NULL )
+    {
+        if( ( availableSize - itr ) >= ( CID_FIELD_SIZE + curElement->PayloadSize ) )
+        {
+            buffer[itr++] = curElement->CID;
+            memcpy1( &buffer[itr], curElement->Payload, curElement->PayloadSize );
+            itr += curElement->PayloadSize;
+        }
+        else
+        {
+            break;
+        }
+        curElement = curElement->Next;
+    }
+
+    while( curElement != NULL )
+    {
+        nextElement = curElement->Next;
+        RefCommandsRemoveCmd( curElement );
+        curElement = nextElement;
+    }
+
+    return RefCtx.SerializedCmdsSize;
+}
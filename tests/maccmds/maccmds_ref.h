@@ -0,0 +1,31 @@
+/* The previous MAC command list, see maccmds_ref.c */
+#ifndef _MACCMDS_REF_H_
+#define _MACCMDS_REF_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "LoRaMacCommands.h"
+
+// MacCommand_t as it was, without the previous link
+typedef struct sRefCommand RefCommand_t;
+struct sRefCommand
+{
+    RefCommand_t* Next;
+    uint8_t CID;
+    uint8_t Payload[LORAMAC_COMMADS_MAX_NUM_OF_PARAMS];
+    size_t PayloadSize;
+    bool IsSticky;
+    bool IsConfirmationRequired;
+};
+
+void RefCommandsInit( void );
+LoRaMacCommandStatus_t RefCommandsAddCmd( uint8_t cid, uint8_t* payload, size_t payloadSize );
+LoRaMacCommandStatus_t RefCommandsRemoveCmd( RefCommand_t* macCmd );
+LoRaMacCommandStatus_t RefCommandsGetCmd( uint8_t cid, RefCommand_t** macCmd );
+void RefCommandsRemoveNoneStickyCmds( void );
+void RefCommandsRemoveStickyAnsCmds( void );
+size_t RefCommandsGetSizeSerializedCmds( void );
+size_t RefCommandsSerializeCmds( size_t availableSize, uint8_t* buffer );
+
+#endif
@@ -0,0 +1,227 @@
+/*
+ * MAC command list with the free slot stack and previous links, against the
+ * slot scan and list walk it had before (maccmds_ref.c).
+ *
+ * Random steps add commands of every uplink CID, remove the first one of a
+ * CID, drop the non-sticky or the sticky answer commands as after an uplink
+ * or a downlink, and serialize into FOpts sized buffers, which drops what
+ * does not fit. Both lists get the same steps and have to return the same
+ * statuses, sizes and serialized bytes. Every few steps both are filled up
+ * and have to take the same number of commands, so no slot is lost or handed
+ * out twice, and a command removed twice must be refused. Reports the cost
+ * of the MAC command handling of one uplink with either list.
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "LoRaMacCommands.h"
+#include "LoRaMacTypes.h"
+#include "maccmds_ref.h"
+#include "test.h"
+
+#define STEPS           100000
+#define BENCH_UPLINKS   200000
+#define SLOTS           32      // NUM_OF_MAC_COMMANDS
+#define FOPTS_LEN       15
+#define PORT0_LEN       242     // largest MAC command payload on port 0
+
+static const uint8_t cids[] = {
+    MOTE_MAC_RESET_IND, MOTE_MAC_LINK_CHECK_REQ, MOTE_MAC_LINK_ADR_ANS, MOTE_MAC_DUTY_CYCLE_ANS,
+    MOTE_MAC_RX_PARAM_SETUP_ANS, MOTE_MAC_DEV_STATUS_ANS, MOTE_MAC_NEW_CHANNEL_ANS,
+    MOTE_MAC_RX_TIMING_SETUP_ANS, MOTE_MAC_TX_PARAM_SETUP_ANS, MOTE_MAC_DL_CHANNEL_ANS, MOTE_MAC_REKEY_IND,
+    MOTE_MAC_DEVICE_TIME_REQ, MOTE_MAC_ADR_PARAM_SETUP_ANS, MOTE_MAC_REJOIN_PARAM_ANS, MOTE_MAC_DEVICE_MODE_IND,
+    MOTE_MAC_PING_SLOT_INFO_REQ, MOTE_MAC_PING_SLOT_CHANNEL_ANS, MOTE_MAC_BEACON_TIMING_REQ,
+    MOTE_MAC_BEACON_FREQ_ANS,
+};
+#define NB_CIDS (sizeof(cids) / sizeof(cids[0]))
+
+//
+// Both lists side by side
+//
+static LoRaMacCommandStatus_t add_both(int step, uint8_t cid, uint8_t *payload, size_t len)
+{
+    LoRaMacCommandStatus_t status = LoRaMacCommandsAddCmd(cid, payload, len);
+    LoRaMacCommandStatus_t ref = RefCommandsAddCmd(cid, payload, len);
+
+    CHECK(status == ref, "step %d: add of CID %02X returned %d, previously %d", step, cid, status, ref);
+    return status;
+}
+
+static void serialize_both(int step, size_t available)
+{
+    uint8_t buf[PORT0_LEN], ref_buf[PORT0_LEN];
+    size_t size, ref_size;
+
+    memset(buf, 0, sizeof(buf));
+    memset(ref_buf, 0, sizeof(ref_buf));
+    CHECK(LoRaMacCommandsSerializeCmds(available, &size, buf) == LORAMAC_COMMANDS_SUCCESS,
+          "step %d: serialize failed", step);
+    ref_size = RefCommandsSerializeCmds(available, ref_buf);
+    CHECK(size == ref_size && !memcmp(buf, ref_buf, size), "step %d: %zu bytes serialized into %zu, previously %zu",
+          step, size, available, ref_size);
+}
+
+// Same size and commands, in the same order
+static void check_lists(int step)
+{
+    size_t size;
+
+    CHECK(LoRaMacCommandsGetSizeSerializedCmds(&size) == LORAMAC_COMMANDS_SUCCESS, "step %d: size failed", step);
+    CHECK(size == RefCommandsGetSizeSerializedCmds(), "step %d: serialized size %zu, previously %zu", step, size,
+          RefCommandsGetSizeSerializedCmds());
+    if (size <= PORT0_LEN)
+        serialize_both(step, PORT0_LEN);
+}
+
+static void remove_cid(int step, uint8_t cid)
+{
+    MacCommand_t *cmd;
+    RefCommand_t *ref;
+    LoRaMacCommandStatus_t status = LoRaMacCommandsGetCmd(cid, &cmd);
+
+    CHECK(status == RefCommandsGetCmd(cid, &ref), "step %d: CID %02X found in one list only", step, cid);
+    if (status != LORAMAC_COMMANDS_SUCCESS || ref == NULL)
+        return;
+    CHECK(cmd->CID == ref->CID && cmd->PayloadSize == ref->PayloadSize &&
+          !memcmp(cmd->Payload, ref->Payload, cmd->PayloadSize) && cmd->IsSticky == ref->IsSticky &&
+          cmd->IsConfirmationRequired == ref->IsConfirmationRequired, "step %d: CID %02X differs", step, cid);
+    CHECK(LoRaMacCommandsRemoveCmd(cmd) == LORAMAC_COMMANDS_SUCCESS, "step %d: remove of CID %02X failed", step, cid);
+    RefCommandsRemoveCmd(ref);
+    CHECK(LoRaMacCommandsRemoveCmd(cmd) == LORAMAC_COMMANDS_ERROR_CMD_NOT_FOUND,
+          "step %d: CID %02X removed twice", step, cid);
+}
+
+// Both have to take the same number of commands, then the fill is dropped again
+static void check_fill(int step)
+{
+    uint8_t payload[LORAMAC_COMMADS_MAX_NUM_OF_PARAMS] = { 0x07 };
+    int added = 0;
+
+    while (add_both(step, MOTE_MAC_LINK_ADR_ANS, payload, 1) == LORAMAC_COMMANDS_SUCCESS)
+    {
+        if (++added > SLOTS)
+            break;
+    }
+    CHECK(added <= SLOTS, "step %d: more than %d commands taken", step, SLOTS);
+    check_lists(step);
+    LoRaMacCommandsRemoveNoneStickyCmds();
+    RefCommandsRemoveNoneStickyCmds();
+}
+
+static void test_random(void)
+{
+    uint8_t payload[LORAMAC_COMMADS_MAX_NUM_OF_PARAMS];
+    int full = 0;
+
+    LoRaMacCommandsInit();
+    RefCommandsInit();
+    srand(37);
+    for (int step = 0; step < STEPS; step++)
+    {
+        int r = rand() % 100;
+        uint8_t cid = cids[rand() % NB_CIDS];
+
+        if (r < 55)
+        {
+            for (int i = 0; i < LORAMAC_COMMADS_MAX_NUM_OF_PARAMS; i++)
+                payload[i] = rand();
+            if (add_both(step, cid, payload, rand() % (LORAMAC_COMMADS_MAX_NUM_OF_PARAMS + 1)) ==
+                LORAMAC_COMMANDS_ERROR_MEMORY)
+                full++;
+        }
+        else if (r < 75)
+            remove_cid(step, cid);
+        else if (r < 80)
+        {
+            LoRaMacCommandsRemoveNoneStickyCmds();
+            RefCommandsRemoveNoneStickyCmds();
+        }
+        else if (r < 85)
+        {
+            LoRaMacCommandsRemoveStickyAnsCmds();
+            RefCommandsRemoveStickyAnsCmds();
+        }
+        else if (r < 88)
+            serialize_both(step, rand() % (FOPTS_LEN + 1));
+        check_lists(step);
+        if (step % 1000 == 999)
+            check_fill(step);
+    }
+    CHECK(full != 0, "the list never filled up");
+}
+
+//
+// Benchmark
+//
+static double now_ns(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/* ns per uplink: the answers to a downlink with three LinkADRReq, a
+ * DevStatusReq and an RxParamSetupReq are added, serialized into FOpts, the
+ * non-sticky ones go after the uplink and the sticky one after the next
+ * downlink. pending commands that need a confirmation are kept throughout,
+ * so serializing goes to the port 0 size when there are any. */
+static double bench_uplink(int with_ref, int pending)
+{
+    uint8_t payload[LORAMAC_COMMADS_MAX_NUM_OF_PARAMS] = { 0x07, 0x00 };
+    uint8_t buf[PORT0_LEN];
+    size_t available = pending ? PORT0_LEN : FOPTS_LEN;
+    size_t size;
+    double start;
+
+    LoRaMacCommandsInit();
+    RefCommandsInit();
+    for (int i = 0; i < pending; i++)
+    {
+        if (with_ref)
+            RefCommandsAddCmd(MOTE_MAC_RESET_IND, payload, 1);
+        else
+            LoRaMacCommandsAddCmd(MOTE_MAC_RESET_IND, payload, 1);
+    }
+
+    start = now_ns();
+    for (int n = 0; n < BENCH_UPLINKS; n++)
+    {
+        if (with_ref)
+        {
+            for (int i = 0; i < 3; i++)
+                RefCommandsAddCmd(MOTE_MAC_LINK_ADR_ANS, payload, 1);
+            RefCommandsAddCmd(MOTE_MAC_DEV_STATUS_ANS, payload, 2);
+            RefCommandsAddCmd(MOTE_MAC_RX_PARAM_SETUP_ANS, payload, 1);
+            size = RefCommandsGetSizeSerializedCmds();
+            size = RefCommandsSerializeCmds(available, buf);
+            RefCommandsRemoveNoneStickyCmds();
+            RefCommandsRemoveStickyAnsCmds();
+        }
+        else
+        {
+            for (int i = 0; i < 3; i++)
+                LoRaMacCommandsAddCmd(MOTE_MAC_LINK_ADR_ANS, payload, 1);
+            LoRaMacCommandsAddCmd(MOTE_MAC_DEV_STATUS_ANS, payload, 2);
+            LoRaMacCommandsAddCmd(MOTE_MAC_RX_PARAM_SETUP_ANS, payload, 1);
+            LoRaMacCommandsGetSizeSerializedCmds(&size);
+            LoRaMacCommandsSerializeCmds(available, &size, buf);
+            LoRaMacCommandsRemoveNoneStickyCmds();
+            LoRaMacCommandsRemoveStickyAnsCmds();
+        }
+    }
+    CHECK(size == (size_t)(11 + 2 * pending), "%d pending: %zu bytes serialized", pending, size);
+    return (now_ns() - start) / BENCH_UPLINKS;
+}
+
+int main(void)
+{
+    test_random();
+
+    printf("maccmds: %d steps; ns per uplink with the slot stack/previous slot scan: %.0f/%.0f, "
+           "%.0f/%.0f with 24 commands pending\n", STEPS, bench_uplink(0, 0), bench_uplink(1, 0),
+           bench_uplink(0, 24), bench_uplink(1, 24));
+
+    TEST_DONE("maccmds");
+}
@@ -0,0 +1,5 @@
+/* Host stand-in for the board definitions, nothing of them is used. */
+#ifndef _BOARD_BASIC_H_
+#define _BOARD_BASIC_H_
+
+#endif
@@ -0,0 +1,5 @@
+/* Host stand-in for the delay functions, none of them is used. */
+#ifndef _DELAY_H_
+#define _DELAY_H_
+
+#endif
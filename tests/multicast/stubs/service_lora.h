@@ -0,0 +1,33 @@
+/* Host stand-in for service/lora/service_lora.h, only the work mode and band the multicast groups read */
+#ifndef __SERVICE_LORA_H__
+#define __SERVICE_LORA_H__
+
+#include <stdint.h>
+#include "LoRaMac.h"
+
+typedef enum _SERVICE_LORA_WORK_MODE
+{
+    SERVICE_LORA_P2P = 0,
+    SERVICE_LORAWAN = 1,
+    SERVICE_LORA_FSK = 2
+} SERVICE_LORA_WORK_MODE;
+
+typedef enum _SERVICE_LORA_BAND
+{
+    SERVICE_LORA_AS923 = LORAMAC_REGION_AS923,
+    SERVICE_LORA_AU915 = LORAMAC_REGION_AU915,
+    SERVICE_LORA_CN470 = LORAMAC_REGION_CN470,
+    SERVICE_LORA_CN779 = LORAMAC_REGION_CN779,
+    SERVICE_LORA_EU433 = LORAMAC_REGION_EU433,
+    SERVICE_LORA_EU868 = LORAMAC_REGION_EU868,
+    SERVICE_LORA_KR920 = LORAMAC_REGION_KR920,
+    SERVICE_LORA_IN865 = LORAMAC_REGION_IN865,
+    SERVICE_LORA_US915 = LORAMAC_REGION_US915,
+    SERVICE_LORA_RU864 = LORAMAC_REGION_RU864,
+    SERVICE_LORA_LA915 = LORAMAC_REGION_LA915,
+} SERVICE_LORA_BAND;
+
+SERVICE_LORA_BAND service_lora_get_band(void);
+SERVICE_LORA_WORK_MODE service_lora_get_nwm(void);
+
+#endif
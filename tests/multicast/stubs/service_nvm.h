@@ -0,0 +1,12 @@
+/* Host stand-in for service/nvm/service_nvm.h, only the multicast group copy */
+#ifndef __SERVICE_NVM_H__
+#define __SERVICE_NVM_H__
+
+#include <stdint.h>
+#include "service_lora.h"
+#include "service_lora_multicast.h"
+
+McSession_t *service_nvm_get_multicast_from_nvm(void);
+int32_t service_nvm_set_multicast_to_nvm(McSession_t *McSession);
+
+#endif
@@ -0,0 +1,492 @@
+/*
+ * Multicast groups on a mock MAC: random adds, removes and downlinks against
+ * a model of the four group slots.
+ *
+ * LoRaMacMcChannelSetup(), LoRaMacMcChannelSetupRxParams() and
+ * LoRaMacMcChannelDelete() are mocked to keep the MAC side of every group,
+ * and the NVM copy is kept too. After every step the group list, the
+ * downlink statistics of every address, the MAC and NVM side and, every few
+ * steps, the AT+LSTMULC and AT+MULCSTAT output have to match the model.
+ * Downlinks to addresses that are not a group, unicast ones and lookups of
+ * address 0, which every free slot holds, must find nothing. The groups are
+ * then cleared and set up again from NVM. Reports the cost of a downlink
+ * through MulticastMcpsIndication() with 0 to 4 groups.
+ */
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "service_lora_multicast.h"
+#include "service_lora.h"
+#include "atcmd.h"
+#include "atcmd_multicast.h"
+#include "udrv_errno.h"
+#include "test.h"
+
+#define OPS             20000
+#define BENCH_FRAMES    2000000
+#define NB_GROUPS       LORAMAC_MAX_MC_CTX
+#define POOL            (2 * NB_GROUPS)     // group addresses the random steps pick from
+#define UNKNOWN_ADDR    0x26FFFFFF
+
+//
+// Mock MAC, NVM and serial output
+//
+static struct
+{
+    bool Enabled;
+    uint32_t Address;
+    DeviceClass_t Class;
+    uint32_t Frequency;
+    int8_t Datarate;
+} mac_group[NB_GROUPS];
+
+static McSession_t nvm_group[NB_GROUPS];
+static SERVICE_LORA_WORK_MODE nwm = SERVICE_LORAWAN;
+static char out[1024];
+static size_t out_len;
+
+LoRaMacStatus_t LoRaMacMcChannelSetup(McChannelParams_t *channel)
+{
+    if (channel->GroupID >= NB_GROUPS)
+        return LORAMAC_STATUS_MC_GROUP_UNDEFINED;
+    CHECK(!mac_group[channel->GroupID].Enabled, "group %d set up twice", channel->GroupID);
+    mac_group[channel->GroupID].Enabled = channel->IsEnabled;
+    mac_group[channel->GroupID].Address = channel->Address;
+    return LORAMAC_STATUS_OK;
+}
+
+LoRaMacStatus_t LoRaMacMcChannelSetupRxParams(AddressIdentifier_t groupID, McRxParams_t *rxParams, uint8_t *status)
+{
+    if (groupID >= NB_GROUPS || !mac_group[groupID].Enabled)
+        return LORAMAC_STATUS_MC_GROUP_UNDEFINED;
+    mac_group[groupID].Class = rxParams->Class;
+    if (rxParams->Class == CLASS_B)
+    {
+        mac_group[groupID].Frequency = rxParams->Params.ClassB.Frequency;
+        mac_group[groupID].Datarate = rxParams->Params.ClassB.Datarate;
+    }
+    else
+    {
+        mac_group[groupID].Frequency = rxParams->Params.ClassC.Frequency;
+        mac_group[groupID].Datarate = rxParams->Params.ClassC.Datarate;
+    }
+    *status = 0;
+    return LORAMAC_STATUS_OK;
+}
+
+LoRaMacStatus_t LoRaMacMcChannelDelete(AddressIdentifier_t groupID)
+{
+    if (groupID >= NB_GROUPS || !mac_group[groupID].Enabled)
+        return LORAMAC_STATUS_MC_GROUP_UNDEFINED;
+    memset(&mac_group[groupID], 0, sizeof(mac_group[groupID]));
+    return LORAMAC_STATUS_OK;
+}
+
+McSession_t *service_nvm_get_multicast_from_nvm(void)
+{
+    return nvm_group;
+}
+
+int32_t service_nvm_set_multicast_to_nvm(McSession_t *McSession)
+{
+    memcpy(nvm_group, McSession, sizeof(nvm_group));
+    return UDRV_RETURN_OK;
+}
+
+SERVICE_LORA_BAND service_lora_get_band(void)
+{
+    return SERVICE_LORA_EU868;
+}
+
+SERVICE_LORA_WORK_MODE service_lora_get_nwm(void)
+{
+    return nwm;
+}
+
+int32_t udrv_serial_log_printf(const char *fmt, ...)
+{
+    va_list ap;
+    int n;
+
+    va_start(ap, fmt);
+    n = vsnprintf(out + out_len, sizeof(out) - out_len, fmt, ap);
+    va_end(ap);
+    if (n > 0)
+        out_len = out_len + n < sizeof(out) ? out_len + n : sizeof(out) - 1;
+    return n;
+}
+
+// AT+ADDMULC and AT+RMVMULC are not run, their parameter parsers are left out
+uint8_t at_check_hex_param(const char *p_str, uint32_t str_len, uint8_t *p_hex)
+{
+    return AT_PARAM_ERROR;
+}
+
+uint8_t at_check_hex_uint32(const char *p_str, uint32_t *value)
+{
+    return AT_PARAM_ERROR;
+}
+
+uint8_t at_check_digital_uint32_t(const char *p_str, uint32_t *value)
+{
+    return AT_PARAM_ERROR;
+}
+
+uint8_t at_error_code_form_udrv(int8_t udrv_code)
+{
+    return AT_ERROR;
+}
+
+//
+// Model of the group slots
+//
+static McSession_t model[NB_GROUPS];
+static McSessionStats_t model_stats[NB_GROUPS];
+static uint32_t pool[POOL];
+static uint32_t fcnt[POOL];     // next FCnt the network sends to each address
+static uint32_t group_frames;
+
+static int model_find(uint32_t addr)
+{
+    for (int i = 0; i < NB_GROUPS; i++)
+    {
+        if (addr != 0 && model[i].Address == addr)
+            return i;
+    }
+    return -1;
+}
+
+static McSession_t random_session(uint32_t addr)
+{
+    McSession_t s;
+
+    memset(&s, 0, sizeof(s));
+    s.Devclass = rand() % 2 ? 1 : 2;
+    s.Address = addr;
+    for (int j = 0; j < 16; j++)
+    {
+        s.McAppSKey[j] = rand();
+        s.McNwkSKey[j] = rand();
+    }
+    // A quarter of them take the band default channel
+    s.Frequency = rand() % 4 ? 869000000 + rand() % 50 * 10000 : 0;
+    s.Datarate = rand() % 6;
+    s.Periodicity = rand() % 8;
+    return s;
+}
+
+static void step_add(int p)
+{
+    McSession_t s = random_session(pool[p]);
+    int32_t ret = service_lora_addmulc(s);
+    int slot = -1;
+
+    if (model_find(pool[p]) < 0)
+    {
+        for (int i = 0; i < NB_GROUPS && slot < 0; i++)
+        {
+            if (model[i].Address == 0)
+                slot = i;
+        }
+    }
+    if (slot < 0)
+    {
+        CHECK(ret == -UDRV_PARAM_ERR, "add of %08X returned %d, the group exists or all are used", pool[p], ret);
+        return;
+    }
+    CHECK(ret == UDRV_RETURN_OK, "add of %08X returned %d", pool[p], ret);
+    s.GroupID = slot;
+    if (s.Frequency == 0)
+    {
+        // The EU868 default channel is kept with the group
+        s.Frequency = 869525000;
+        s.Datarate = s.Devclass == 1 ? 3 : 0;
+    }
+    model[slot] = s;
+    memset(&model_stats[slot], 0, sizeof(model_stats[slot]));
+}
+
+static void step_remove(uint32_t addr)
+{
+    int32_t ret = service_lora_rmvmulc(addr);
+    int slot = model_find(addr);
+
+    if (slot < 0)
+    {
+        CHECK(ret != UDRV_RETURN_OK, "remove of %08X, which is no group, returned OK", addr);
+        return;
+    }
+    CHECK(ret == UDRV_RETURN_OK, "remove of %08X returned %d", addr, ret);
+    memset(&model[slot], 0, sizeof(model[slot]));
+    memset(&model_stats[slot], 0, sizeof(model_stats[slot]));
+}
+
+static void step_downlink(uint32_t addr, uint8_t multicast, uint32_t downlink_counter)
+{
+    McpsIndication_t ind;
+    int slot = multicast == 1 ? model_find(addr) : -1;
+
+    memset(&ind, 0, sizeof(ind));
+    ind.Status = LORAMAC_EVENT_INFO_STATUS_OK;
+    ind.Multicast = multicast;
+    ind.DevAddress = addr;
+    ind.DownLinkCounter = downlink_counter;
+    ind.Rssi = -40 - rand() % 80;
+    ind.Snr = rand() % 30 - 20;
+    MulticastMcpsIndication(&ind);
+
+    if (slot < 0)
+        return;
+    McSessionStats_t *st = &model_stats[slot];
+    if (st->Frames != 0 && downlink_counter > st->LastFCnt + 1)
+        st->FCntGaps += downlink_counter - st->LastFCnt - 1;
+    st->Frames++;
+    st->LastFCnt = downlink_counter;
+    st->LastRssi = ind.Rssi;
+    st->LastSnr = ind.Snr;
+    group_frames++;
+}
+
+//
+// Checks against the model
+//
+static int same_session(const McSession_t *a, const McSession_t *b)
+{
+    return a->Devclass == b->Devclass && a->Address == b->Address && a->Frequency == b->Frequency &&
+           a->Datarate == b->Datarate && a->Periodicity == b->Periodicity && a->GroupID == b->GroupID &&
+           !memcmp(a->McAppSKey, b->McAppSKey, 16) && !memcmp(a->McNwkSKey, b->McNwkSKey, 16);
+}
+
+static void check_groups(int op)
+{
+    McSession_t list[NB_GROUPS];
+    McSessionStats_t st;
+    uint8_t count;
+    int n = 0;
+
+    CHECK(service_lora_get_multicast_list(list, NB_GROUPS, &count) == UDRV_RETURN_OK, "op %d: list failed", op);
+    for (int i = 0; i < NB_GROUPS; i++)
+    {
+        if (model[i].Address == 0)
+        {
+            CHECK(!mac_group[i].Enabled, "op %d: MAC group %d enabled, it is free", op, i);
+            CHECK(nvm_group[i].Address == 0, "op %d: NVM group %d is %08X, it is free", op, i, nvm_group[i].Address);
+            continue;
+        }
+        CHECK(n < count && list[n].entry == i + 1 && same_session(&list[n], &model[i]),
+              "op %d: group %d (%08X) is not entry %d of the list of %u", op, i, model[i].Address, n, count);
+        n++;
+
+        CHECK(mac_group[i].Enabled && mac_group[i].Address == model[i].Address &&
+              mac_group[i].Class == (model[i].Devclass == 1 ? CLASS_B : CLASS_C) &&
+              mac_group[i].Frequency == model[i].Frequency && mac_group[i].Datarate == model[i].Datarate,
+              "op %d: MAC group %d is %08X %u DR%d, not %08X %u DR%d", op, i, mac_group[i].Address,
+              mac_group[i].Frequency, mac_group[i].Datarate, model[i].Address, model[i].Frequency,
+              model[i].Datarate);
+        CHECK(same_session(&nvm_group[i], &model[i]), "op %d: NVM group %d differs", op, i);
+    }
+    CHECK(count == n, "op %d: list of %u groups, %d expected", op, count, n);
+
+    for (int p = 0; p < POOL; p++)
+    {
+        int slot = model_find(pool[p]);
+        int32_t ret = service_lora_get_multicast_stats(pool[p], &st);
+
+        if (slot < 0)
+        {
+            CHECK(ret == -UDRV_WRONG_ARG, "op %d: stats of %08X, which is no group, returned %d", op, pool[p], ret);
+            continue;
+        }
+        CHECK(ret == UDRV_RETURN_OK && st.Frames == model_stats[slot].Frames &&
+              st.FCntGaps == model_stats[slot].FCntGaps && st.LastFCnt == model_stats[slot].LastFCnt &&
+              st.LastRssi == model_stats[slot].LastRssi && st.LastSnr == model_stats[slot].LastSnr,
+              "op %d: stats of %08X are %u frames %u gaps, %u frames %u gaps expected", op, pool[p], st.Frames,
+              st.FCntGaps, model_stats[slot].Frames, model_stats[slot].FCntGaps);
+    }
+    CHECK(service_lora_get_multicast_stats(0, &st) == -UDRV_WRONG_ARG, "op %d: stats of address 0 found", op);
+    CHECK(service_lora_get_multicast_stats(UNKNOWN_ADDR, &st) == -UDRV_WRONG_ARG,
+          "op %d: stats of an unknown address found", op);
+}
+
+static int run_at(int (*handler)(SERIAL_PORT, char *, stParam *), char *cmd, const char *arg)
+{
+    stParam param;
+
+    memset(&param, 0, sizeof(param));
+    if (arg != NULL)
+    {
+        param.argv[0] = (char *)arg;
+        param.argc = 1;
+    }
+    out_len = 0;
+    out[0] = '\0';
+    return handler(SERIAL_UART0, cmd, &param);
+}
+
+static void check_at(int op)
+{
+    char expect[sizeof(out)];
+    size_t len = 0;
+
+    // AT+LSTMULC=? lists every slot, as the iterator it was built on did
+    CHECK(run_at(At_Lstmulc, "AT+LSTMULC", "?") == AT_OK, "op %d: AT+LSTMULC=? failed", op);
+    for (int i = 0; i < NB_GROUPS; i++)
+    {
+        const McSession_t *s = &model[i];
+
+        len += snprintf(expect + len, sizeof(expect) - len, "%s%s%08X:", i ? "," : "",
+                        s->Address == 0 ? "0:" : s->Devclass == 1 ? "B:" : "C:", s->Address);
+        for (int j = 0; j < 16; j++)
+            len += snprintf(expect + len, sizeof(expect) - len, "%02X", s->McNwkSKey[j]);
+        len += snprintf(expect + len, sizeof(expect) - len, ":");
+        for (int j = 0; j < 16; j++)
+            len += snprintf(expect + len, sizeof(expect) - len, "%02X", s->McAppSKey[j]);
+        len += snprintf(expect + len, sizeof(expect) - len, ":%09d:%02d:%d", s->Frequency, s->Datarate,
+                        s->Periodicity);
+    }
+    snprintf(expect + len, sizeof(expect) - len, "\r\n");
+    CHECK(!strcmp(out, expect), "op %d: AT+LSTMULC=? printed\n%s, expected\n%s", op, out, expect);
+
+    len = 0;
+    CHECK(run_at(At_Mulcstat, "AT+MULCSTAT", "?") == AT_OK, "op %d: AT+MULCSTAT=? failed", op);
+    for (int i = 0; i < NB_GROUPS; i++)
+    {
+        if (model[i].Address == 0)
+            continue;
+        len += snprintf(expect + len, sizeof(expect) - len, "%s%08X:%u:%u:%u:%d:%d", len ? "," : "",
+                        model[i].Address, model_stats[i].Frames, model_stats[i].FCntGaps, model_stats[i].LastFCnt,
+                        model_stats[i].LastRssi, model_stats[i].LastSnr);
+    }
+    snprintf(expect + len, sizeof(expect) - len, "\r\n");
+    CHECK(!strcmp(out, expect), "op %d: AT+MULCSTAT=? printed %s, expected %s", op, out, expect);
+}
+
+static void test_random(void)
+{
+    for (int p = 0; p < POOL; p++)
+        pool[p] = 0x01A20000 + p * 0x1111;
+
+    srand(36);
+    for (int op = 0; op < OPS; op++)
+    {
+        int p = rand() % POOL;
+        int r = rand() % 100;
+
+        if (r < 15)
+            step_add(p);
+        else if (r < 25)
+            step_remove(rand() % 8 ? pool[p] : UNKNOWN_ADDR);
+        else if (r < 80)
+        {
+            // One downlink in five is lost on the air
+            fcnt[p] += rand() % 5 ? 1 : 1 + rand() % 3;
+            step_downlink(pool[p], 1, fcnt[p]++);
+        }
+        else if (r < 90)
+            step_downlink(pool[p], 0, rand());
+        else if (r < 95)
+            step_downlink(UNKNOWN_ADDR, 1, rand());
+        else
+            step_downlink(0, 1, rand());
+
+        check_groups(op);
+        if (op % 16 == 0)
+            check_at(op);
+    }
+    CHECK(group_frames > OPS / 8, "only %u downlinks went to a group", group_frames);
+}
+
+static void test_at_errors(void)
+{
+    CHECK(run_at(At_Lstmulc, "AT+LSTMULC", NULL) == AT_PARAM_ERROR, "AT+LSTMULC without ? accepted");
+    CHECK(run_at(At_Mulcstat, "AT+MULCSTAT", "1") == AT_PARAM_ERROR, "AT+MULCSTAT=1 accepted");
+    nwm = SERVICE_LORA_P2P;
+    CHECK(run_at(At_Lstmulc, "AT+LSTMULC", "?") == AT_MODE_NO_SUPPORT, "AT+LSTMULC=? ran in P2P mode");
+    CHECK(run_at(At_Mulcstat, "AT+MULCSTAT", "?") == AT_MODE_NO_SUPPORT, "AT+MULCSTAT=? ran in P2P mode");
+    nwm = SERVICE_LORAWAN;
+}
+
+// Clearing the groups and setting them up again from NVM, as after a reset
+static void test_restore(void)
+{
+    McSession_t saved[NB_GROUPS];
+
+    memcpy(saved, nvm_group, sizeof(saved));
+    CHECK(service_lora_clear_multicast() == UDRV_RETURN_OK, "clear failed");
+    for (int i = 0; i < NB_GROUPS; i++)
+    {
+        CHECK(!mac_group[i].Enabled, "MAC group %d enabled after clear", i);
+        CHECK(nvm_group[i].Address == 0, "NVM group %d kept after clear", i);
+    }
+    memcpy(nvm_group, saved, sizeof(saved));
+    CHECK(service_lora_setup_multicast() == UDRV_RETURN_OK, "setup from NVM failed");
+    for (int i = 0; i < NB_GROUPS; i++)
+        memset(&model_stats[i], 0, sizeof(model_stats[i]));
+    check_groups(OPS);
+    check_at(OPS);
+}
+
+//
+// Benchmark
+//
+static double now_ns(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+// ns per downlink to addr
+static double bench_downlink(uint32_t addr)
+{
+    McpsIndication_t ind;
+    double start;
+
+    memset(&ind, 0, sizeof(ind));
+    ind.Multicast = 1;
+    ind.DevAddress = addr;
+    start = now_ns();
+    for (int i = 0; i < BENCH_FRAMES; i++)
+    {
+        ind.DownLinkCounter = i;
+        MulticastMcpsIndication(&ind);
+    }
+    return (now_ns() - start) / BENCH_FRAMES;
+}
+
+static void bench(void)
+{
+    double last[NB_GROUPS + 1], unknown[NB_GROUPS + 1];
+
+    service_lora_clear_multicast();
+    for (int n = 0; n <= NB_GROUPS; n++)
+    {
+        if (n > 0)
+            service_lora_addmulc(random_session(pool[n - 1]));
+        last[n] = n > 0 ? bench_downlink(pool[n - 1]) : 0;
+        unknown[n] = bench_downlink(UNKNOWN_ADDR);
+    }
+    printf("multicast: %d steps, %u group downlinks; ns per downlink to the last/an unknown group with 0..%d groups:",
+           OPS, group_frames, NB_GROUPS);
+    for (int n = 0; n <= NB_GROUPS; n++)
+    {
+        if (n > 0)
+            printf(" %.1f/%.1f", last[n], unknown[n]);
+        else
+            printf(" -/%.1f", unknown[n]);
+    }
+    printf("\n");
+}
+
+int main(void)
+{
+    test_at_errors();
+    test_random();
+    test_restore();
+    bench();
+
+    TEST_DONE("multicast");
+}
@@ -0,0 +1,7 @@
+/* Host stand-in for FreeRTOS.h, the tests run single-threaded */
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stdint.h>
+
+#endif
@@ -0,0 +1,8 @@
+/* Host stand-in for FreeRTOS task.h, critical sections are no-ops single-threaded */
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+
+#endif
@@ -0,0 +1,252 @@
+/*
+ * NUS Tx pipeline in uhal_ble_nus_pipe.c against a model of the Cordio
+ * notification path and a link layer with a fixed number of controller
+ * buffers emptied once per connection event:
+ *  - ATTS sends a notification right away and confirms it while L2CAP flow is
+ *    enabled, otherwise the confirm waits for flow to resume and further
+ *    notifications are rejected with ATT_ERR_OVERFLOW (ATT_NUM_SIMUL_NTF 1);
+ *  - HCI disables flow at HCI_ACL_QUEUE_HI queued packets and enables it again
+ *    at HCI_ACL_QUEUE_LO.
+ * Checks that a successful write reaches the air complete and in order, with
+ * the stack task running either right away or interleaved with connection
+ * events, and reports bytes per connection interval.
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "uhal_ble_nus_pipe.h"
+#include "att_defs.h"
+#include "test.h"
+
+#define ATT_NUM_SIMUL_NTF   1
+#define HCI_QUEUE_HI        5
+#define HCI_QUEUE_LO        3
+#define CTRL_BUFS           4
+#define QUEUE_MAX           64
+#define AIR_MAX             (1 << 20)
+
+typedef struct
+{
+    uint8_t *p;
+    uint16_t len;
+} pkt_t;
+
+static struct
+{
+    pkt_t att[QUEUE_MAX];       // notifications not yet processed by the stack task
+    int att_head;
+    int att_n;
+    pkt_t hci[QUEUE_MAX];       // queued in HCI, the first ones in the controller
+    int hci_head;
+    int hci_n;
+    bool flow_disabled;
+    bool ntf_pending;
+    bool sem;
+    int immediate;              // percentage of notifications the stack task handles within send
+    uint32_t events;
+    uint32_t overflows;
+} sim;
+
+static uint8_t air[AIR_MAX];
+static uint32_t air_len;
+
+static void confirm(uint8_t status)
+{
+    if (status == ATT_ERR_OVERFLOW)
+        sim.overflows++;
+    uhal_nus_tx_pipe_confirm(status);
+    sim.sem = true;
+}
+
+static void hci_send(pkt_t pkt)
+{
+    sim.hci[(sim.hci_head + sim.hci_n++) % QUEUE_MAX] = pkt;
+    if (sim.hci_n >= HCI_QUEUE_HI)
+        sim.flow_disabled = true;
+}
+
+static void att_process(void)
+{
+    pkt_t pkt = sim.att[sim.att_head];
+
+    sim.att_head = (sim.att_head + 1) % QUEUE_MAX;
+    sim.att_n--;
+    if (sim.ntf_pending)
+    {
+        confirm(ATT_ERR_OVERFLOW);
+        return;
+    }
+    hci_send(pkt);
+    if (!sim.flow_disabled)
+        confirm(ATT_SUCCESS);
+    else
+        sim.ntf_pending = true;
+}
+
+static void conn_event(void)
+{
+    int n = (sim.hci_n < CTRL_BUFS) ? sim.hci_n : CTRL_BUFS;
+
+    for (int i = 0; i < n; i++)
+    {
+        pkt_t pkt = sim.hci[sim.hci_head];
+
+        memcpy(air + air_len, pkt.p, pkt.len);
+        air_len += pkt.len;
+        sim.hci_head = (sim.hci_head + 1) % QUEUE_MAX;
+        sim.hci_n--;
+    }
+    sim.events++;
+    if (sim.flow_disabled && sim.hci_n <= HCI_QUEUE_LO)
+    {
+        sim.flow_disabled = false;
+        if (sim.ntf_pending)
+        {
+            sim.ntf_pending = false;
+            confirm(ATT_SUCCESS);
+        }
+    }
+}
+
+static int32_t send(uint8_t *pdata, uint16_t len)
+{
+    sim.att[(sim.att_head + sim.att_n++) % QUEUE_MAX] = (pkt_t){pdata, len};
+    if (rand() % 100 < sim.immediate)
+        att_process();
+    return 0;
+}
+
+static nus_tx_wait_t wait(void)
+{
+    while (!sim.sem)
+    {
+        // The stack task catches up while the writer blocks, connection events
+        // may come in between.
+        if (sim.att_n > 0 && (sim.hci_n == 0 || rand() % 4 != 0))
+            att_process();
+        else if (sim.hci_n > 0)
+            conn_event();
+        else
+            return NUS_TX_WAIT_TIMEOUT;
+    }
+    sim.sem = false;
+    return NUS_TX_WAIT_CONFIRM;
+}
+
+static nus_tx_wait_t wait_isr(void)
+{
+    return NUS_TX_WAIT_ABORT;
+}
+
+static void drain(void)
+{
+    while (sim.att_n > 0)
+        att_process();
+    while (sim.hci_n > 0)
+        conn_event();
+    sim.sem = false;
+}
+
+static void reset(uint8_t depth, int immediate)
+{
+    memset(&sim, 0, sizeof(sim));
+    sim.immediate = immediate;
+    air_len = 0;
+    uhal_nus_tx_pipe_reset(depth);
+}
+
+static void fill(uint8_t *buf, uint32_t len, uint32_t seed)
+{
+    for (uint32_t i = 0; i < len; i++)
+        buf[i] = (uint8_t)((seed + i) * 2654435761u >> 24);
+}
+
+// Random write sizes and stack scheduling: every write reported as sent is on
+// air exactly once and in order.
+static void test_order(uint8_t depth, uint16_t chunk, int immediate)
+{
+    static uint8_t buf[4096];
+    int writes = 0, failed = 0;
+
+    reset(depth, immediate);
+    srand(depth * 1000 + chunk + immediate);
+    for (int w = 0; w < 2000; w++)
+    {
+        uint32_t len = 1 + rand() % sizeof(buf);
+        int32_t ret;
+
+        air_len = 0;
+        fill(buf, len, w);
+        ret = uhal_nus_tx_pipe_write(buf, len, chunk, send, wait);
+        drain();
+        writes++;
+        if (ret != 0)
+        {
+            failed++;
+            continue;
+        }
+        CHECK(air_len == len && memcmp(air, buf, len) == 0,
+              "depth %u chunk %u: write %d of %u bytes reordered or incomplete (%u on air)",
+              depth, chunk, w, len, air_len);
+    }
+    // Beyond what the stack holds pending, lagging confirms cost whole writes.
+    if (depth <= ATT_NUM_SIMUL_NTF || immediate == 100)
+        CHECK(failed == 0, "depth %u chunk %u: %d of %d writes failed", depth, chunk, failed, writes);
+}
+
+static void test_isr(void)
+{
+    uint8_t buf[100];
+
+    reset(1, 0);
+    fill(buf, sizeof(buf), 0);
+    CHECK(uhal_nus_tx_pipe_write(buf, sizeof(buf), 20, send, wait_isr) == -1, "write from ISR did not fail");
+    drain();
+    reset(1, 100);
+    CHECK(uhal_nus_tx_pipe_write(buf, sizeof(buf), 20, send, wait) == 0, "write after ISR failure failed");
+}
+
+// Bytes on air per connection interval for one 64 kB write.
+static double throughput(uint8_t depth, uint16_t chunk, uint32_t *overflows)
+{
+    static uint8_t buf[65535];
+
+    reset(depth, 100);
+    fill(buf, sizeof(buf), 1);
+    CHECK(uhal_nus_tx_pipe_write(buf, sizeof(buf), chunk, send, wait) == 0, "depth %u chunk %u: write failed", depth, chunk);
+    drain();
+    CHECK(air_len == sizeof(buf) && memcmp(air, buf, sizeof(buf)) == 0, "depth %u chunk %u: stream corrupted", depth, chunk);
+    *overflows = sim.overflows;
+    return (double)air_len / sim.events;
+}
+
+int main(void)
+{
+    static const uint8_t depths[] = {1, 2, NUS_TX_PIPELINE_MAX};
+    static const uint16_t chunks[] = {20, 244};
+    uint32_t overflows;
+
+    for (unsigned d = 0; d < sizeof(depths); d++)
+    {
+        for (unsigned c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++)
+        {
+            test_order(depths[d], chunks[c], 100);
+            test_order(depths[d], chunks[c], 50);
+            test_order(depths[d], chunks[c], 0);
+        }
+    }
+    test_isr();
+
+    printf("nus_pipe: bytes per connection interval");
+    for (unsigned c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++)
+    {
+        for (unsigned d = 0; d < sizeof(depths); d++)
+        {
+            double bpi = throughput(depths[d], chunks[c], &overflows);
+            printf("%s chunk %u depth %u %.0f (%u rejected)", (c || d) ? "," : "", chunks[c], depths[d], bpi, overflows);
+        }
+    }
+    printf("\n");
+
+    TEST_DONE("nus_pipe");
+}
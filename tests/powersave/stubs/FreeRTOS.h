@@ -0,0 +1,5 @@
+/* Host stand-in for FreeRTOS, the uhal headers include it but udrv_powersave.c uses none of it. */
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#endif
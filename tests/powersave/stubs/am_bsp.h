@@ -0,0 +1,5 @@
+/* Host stand-in for the board support package, uhal_spimst.h includes it but udrv_powersave.c uses none of it. */
+#ifndef _STUB_AM_BSP_H_
+#define _STUB_AM_BSP_H_
+
+#endif
@@ -0,0 +1,7 @@
+/* Host stand-in for the log macros, uhal_adc.h includes it but udrv_powersave.c logs nothing. */
+#ifndef _AM_LOG_H_
+#define _AM_LOG_H_
+
+#define am_log_inf(...)     do { } while (0)
+
+#endif  // #ifndef _AM_LOG_H_
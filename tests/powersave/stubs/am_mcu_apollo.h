@@ -0,0 +1,5 @@
+/* Host stand-in for the Apollo3 HAL, the uhal headers include it but udrv_powersave.c uses none of it. */
+#ifndef _AM_MCU_APOLLO_H_
+#define _AM_MCU_APOLLO_H_
+
+#endif  // #ifndef _AM_MCU_APOLLO_H_
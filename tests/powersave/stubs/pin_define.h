@@ -0,0 +1,5 @@
+/* Host stand-in for the board pin map, the uhal headers include it but udrv_powersave.c uses none of it. */
+#ifndef _PIN_DEFINE_H_
+#define _PIN_DEFINE_H_
+
+#endif
@@ -0,0 +1,374 @@
+/*
+ * Peripheral power registry in udrv_powersave.c with mock suspend and resume
+ * hooks, each of which takes a fixed time on a virtual clock. A sleep only
+ * suspends what is in use and wakes up without the lazy bus masters, which
+ * come back at their next udrv_spimst_* or udrv_twimst_* call; the SPI and
+ * TWI drivers are the real udrv ones on mock uhal drivers that fail a
+ * transfer on a bus that is down.
+ *
+ * Interrupts while asleep resume and suspend the peripherals around the event
+ * they run, the way uhal_mcu_resume() and uhal_mcu_suspend() do. A radio
+ * transfer from there and the first ones after the wake-up have to find the
+ * bus up. Reports the sleep entry and exit latency against the fixed sequence
+ * that suspended and resumed every peripheral on each sleep.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include "udrv_powersave.h"
+#include "udrv_spimst.h"
+#include "udrv_twimst.h"
+#include "udrv_system.h"
+#include "udrv_rtc.h"
+#include "udrv_errno.h"
+#include "test.h"
+
+#define SLEEPS          1000
+#define SLEEP_MS        1000
+#define AWAKE_US        5000            // between two sleeps, above the minimum wake-up time
+#define RADIO_EVERY     10              // wake-ups per radio transfer
+
+extern bool udrv_powersave_in_sleep;
+
+//
+// Mock peripherals
+//
+
+static struct {
+    const char *name;
+    uint32_t suspend_us;
+    uint32_t resume_us;
+    bool active;                        // set up by the application
+    bool up;
+    int suspends;
+    int resumes;
+} hw[UDRV_PS_PERIPH_MAX] = {
+    [UDRV_PS_PERIPH_USB]    = {"USB", 0, 0},
+    [UDRV_PS_PERIPH_SPI]    = {"SPI", 30, 45},
+    [UDRV_PS_PERIPH_ADC]    = {"ADC", 40, 120},
+    [UDRV_PS_PERIPH_PWM]    = {"PWM", 15, 15},
+    [UDRV_PS_PERIPH_SERIAL] = {"SERIAL", 25, 60},
+    [UDRV_PS_PERIPH_TWI]    = {"TWI", 25, 40},
+    [UDRV_PS_PERIPH_GPIO]   = {"GPIO", 50, 50},
+    [UDRV_PS_PERIPH_RTC]    = {"RTC", 5, 5},
+};
+
+static uint64_t now_us;
+
+static void hw_suspend(UDRV_PS_PERIPH id)
+{
+    now_us += hw[id].suspend_us;
+    hw[id].suspends++;
+    if (hw[id].active)
+        hw[id].up = false;
+}
+
+static void hw_resume(UDRV_PS_PERIPH id)
+{
+    now_us += hw[id].resume_us;
+    hw[id].resumes++;
+    if (hw[id].active)
+        hw[id].up = true;
+}
+
+static void hw_reset(void)
+{
+    for (int i = 0; i < UDRV_PS_PERIPH_MAX; i++)
+    {
+        hw[i].active = false;
+        hw[i].up = false;
+        hw[i].suspends = 0;
+        hw[i].resumes = 0;
+    }
+}
+
+void udrv_adc_suspend(void) { hw_suspend(UDRV_PS_PERIPH_ADC); }
+void udrv_adc_resume(void) { hw_resume(UDRV_PS_PERIPH_ADC); }
+void udrv_pwm_suspend(void) { hw_suspend(UDRV_PS_PERIPH_PWM); }
+void udrv_pwm_resume(void) { hw_resume(UDRV_PS_PERIPH_PWM); }
+void udrv_serial_suspend(void) { hw_suspend(UDRV_PS_PERIPH_SERIAL); }
+void udrv_serial_resume(void) { hw_resume(UDRV_PS_PERIPH_SERIAL); }
+void udrv_gpio_suspend(void) { hw_suspend(UDRV_PS_PERIPH_GPIO); }
+void udrv_gpio_resume(void) { hw_resume(UDRV_PS_PERIPH_GPIO); }
+void udrv_rtc_suspend(void) { hw_suspend(UDRV_PS_PERIPH_RTC); }
+void udrv_rtc_resume(void) { hw_resume(UDRV_PS_PERIPH_RTC); }
+bool uhal_adc_is_active(void) { return hw[UDRV_PS_PERIPH_ADC].active; }
+bool uhal_pwm_is_active(void) { return hw[UDRV_PS_PERIPH_PWM].active; }
+bool uhal_uart_is_active(void) { return hw[UDRV_PS_PERIPH_SERIAL].active; }
+
+// SPI and TWI below the real udrv drivers
+void uhal_spimst_init(udrv_spimst_port port) { hw[UDRV_PS_PERIPH_SPI].active = hw[UDRV_PS_PERIPH_SPI].up = true; }
+void uhal_spimst_setup_mode(udrv_spimst_port port, ENUM_SPI_MST_CPHA_T CPHA, ENUM_SPI_MST_CPOL_T CPOL) { }
+void uhal_spimst_setup_freq(udrv_spimst_port port, uint32_t clk_Hz) { }
+void uhal_spimst_setup_byte_order(udrv_spimst_port port, bool msb_first) { }
+void uhal_spimst_deinit(udrv_spimst_port port) { hw[UDRV_PS_PERIPH_SPI].active = hw[UDRV_PS_PERIPH_SPI].up = false; }
+void uhal_spimst_suspend(void) { hw_suspend(UDRV_PS_PERIPH_SPI); }
+void uhal_spimst_resume(void) { hw_resume(UDRV_PS_PERIPH_SPI); }
+bool uhal_spimst_is_active(void) { return hw[UDRV_PS_PERIPH_SPI].active; }
+
+int8_t uhal_spimst_trx(udrv_spimst_port port, uint8_t *write_data, uint32_t write_length, uint8_t *read_data,
+                       uint32_t read_length, uint32_t csn)
+{
+    return hw[UDRV_PS_PERIPH_SPI].up ? 0 : -1;
+}
+
+int32_t uhal_spimst_submit(udrv_spimst_port port, udrv_spimst_xfer_t *xfer, uint32_t count,
+                           UDRV_SPIMST_XFER_HANDLER handler, void *p_context)
+{
+    return hw[UDRV_PS_PERIPH_SPI].up ? UDRV_RETURN_OK : -UDRV_INTERNAL_ERR;
+}
+
+void uhal_twimst_init(udrv_twimst_port port) { hw[UDRV_PS_PERIPH_TWI].active = hw[UDRV_PS_PERIPH_TWI].up = true; }
+void uhal_twimst_deinit(udrv_twimst_port port) { hw[UDRV_PS_PERIPH_TWI].active = hw[UDRV_PS_PERIPH_TWI].up = false; }
+void uhal_twimst_setup_freq(udrv_twimst_port port, uint32_t clk_Hz) { }
+uint8_t uhal_twimst_suspend(void) { hw_suspend(UDRV_PS_PERIPH_TWI); return 0; }
+uint8_t uhal_twimst_resume(void) { hw_resume(UDRV_PS_PERIPH_TWI); return 0; }
+bool uhal_twimst_is_active(void) { return hw[UDRV_PS_PERIPH_TWI].active; }
+
+int32_t uhal_twimst_write(udrv_twimst_port port, uint8_t twi_addr, uint8_t *data, uint16_t len, bool send_stop)
+{
+    return hw[UDRV_PS_PERIPH_TWI].up ? UDRV_RETURN_OK : -UDRV_NACK;
+}
+
+int32_t uhal_twimst_read(udrv_twimst_port port, uint8_t twi_addr, uint8_t *data, uint16_t len)
+{
+    return hw[UDRV_PS_PERIPH_TWI].up ? UDRV_RETURN_OK : -UDRV_NACK;
+}
+
+int32_t uhal_twimst_write_read(udrv_twimst_port port, uint8_t twi_addr, uint8_t *write_data, uint16_t write_len,
+                               uint8_t *read_data, uint16_t read_len)
+{
+    return hw[UDRV_PS_PERIPH_TWI].up ? UDRV_RETURN_OK : -UDRV_NACK;
+}
+
+int32_t uhal_twimst_submit(udrv_twimst_port port, udrv_twimst_xfer_t *xfer, UDRV_TWIMST_XFER_HANDLER handler,
+                           void *p_context)
+{
+    return hw[UDRV_PS_PERIPH_TWI].up ? UDRV_RETURN_OK : -UDRV_NACK;
+}
+
+//
+// Platform
+//
+
+static timer_handler ps_handler;
+static uint32_t ps_timeout_ms;
+static void (*asleep_irq)(void);        // runs while asleep, before the sleep timer fires
+static uint64_t entered_at, woken_at;
+
+uint64_t udrv_rtc_get_timestamp(RtcID_E timer_id)
+{
+    return now_us / 1000;
+}
+
+uint16_t fund_event_queue_space_get(void)
+{
+    return EVENT_QUEUE_SIZE;
+}
+
+uint32_t service_nvm_get_auto_sleep_level_from_nvm(void)
+{
+    return 1;
+}
+
+int32_t uhal_ps_timer_create(timer_handler tmr_handler, TimerMode_E mode)
+{
+    ps_handler = tmr_handler;
+    return UDRV_RETURN_OK;
+}
+
+int32_t uhal_ps_timer_start(uint32_t count, void *m_data)
+{
+    ps_timeout_ms = count;
+    return UDRV_RETURN_OK;
+}
+
+int32_t uhal_ps_timer_stop()
+{
+    return UDRV_RETURN_OK;
+}
+
+void uhal_sys_clock_init(void) { }
+void uhal_sys_clock_on(void) { }
+void uhal_sys_clock_off(void) { }
+
+void uhal_mcu_sleep(uint32_t level)
+{
+    entered_at = now_us;
+    now_us += ps_timeout_ms * 1000ULL;
+    if (asleep_irq)
+        asleep_irq();
+    woken_at = now_us;
+    ps_handler(NULL);
+}
+
+//
+// Scenarios
+//
+
+static uint8_t radio_buf[4];
+
+// Event consumer of an interrupt while asleep, as around udrv_system_event_consume()
+static void radio_irq(void)
+{
+    udrv_powersave_periph_resume_all();
+    CHECK(udrv_spimst_trx(UDRV_SPIMST_0, radio_buf, 2, radio_buf, 2, 0) == 0, "SPI down in the wake-up handler");
+    udrv_powersave_periph_suspend_all();
+}
+
+static void sensor_irq(void)
+{
+    udrv_powersave_periph_resume_all();
+    CHECK(udrv_twimst_write(UDRV_TWIMST_0, 0x44, radio_buf, 1, true) == UDRV_RETURN_OK,
+          "TWI down in the wake-up handler");
+    udrv_powersave_periph_suspend_all();
+}
+
+// Latency of one sleep in us, entry up to the WFI and exit from the wake-up to the return
+static void sleep_once(void (*irq)(void), uint32_t *entry, uint32_t *exit)
+{
+    uint64_t start;
+
+    now_us += AWAKE_US;
+    asleep_irq = irq;
+    start = now_us;
+    CHECK(udrv_mcu_sleep_ms(SLEEP_MS) == UDRV_RETURN_OK, "sleep refused");
+    CHECK(!udrv_powersave_in_sleep, "still asleep");
+    if (entry)
+        *entry = entered_at - start;
+    if (exit)
+        *exit = now_us - woken_at;
+}
+
+// Serial, GPIO and RTC are up all the time; the radio SPI is set up, the rest is not
+static void setup(void)
+{
+    hw_reset();
+    for (int i = UDRV_PS_PERIPH_SERIAL; i <= UDRV_PS_PERIPH_RTC; i++)
+        hw[i].active = hw[i].up = (i != UDRV_PS_PERIPH_TWI);
+    udrv_spimst_init(UDRV_SPIMST_0);
+}
+
+static void test_active_only(void)
+{
+    uint32_t entry, exit;
+
+    setup();
+    sleep_once(NULL, &entry, &exit);
+    CHECK(entry == 30 + 25 + 50 + 5 && exit == 5 + 50 + 60, "sleep entry/exit %u/%u us", entry, exit);
+    for (int i = UDRV_PS_PERIPH_ADC; i <= UDRV_PS_PERIPH_TWI; i++)
+        CHECK(i == UDRV_PS_PERIPH_SERIAL || (hw[i].suspends == 0 && hw[i].resumes == 0), "unused %s touched",
+              hw[i].name);
+    CHECK(hw[UDRV_PS_PERIPH_SERIAL].up && hw[UDRV_PS_PERIPH_GPIO].up && hw[UDRV_PS_PERIPH_RTC].up,
+          "not resumed on wake-up");
+    CHECK(!hw[UDRV_PS_PERIPH_SPI].up, "SPI resumed on wake-up");
+
+    // A bus that stays unused is left down across sleeps
+    sleep_once(NULL, NULL, NULL);
+    CHECK(hw[UDRV_PS_PERIPH_SPI].suspends == 1 && hw[UDRV_PS_PERIPH_SPI].resumes == 0, "idle SPI suspended %d, "
+          "resumed %d times", hw[UDRV_PS_PERIPH_SPI].suspends, hw[UDRV_PS_PERIPH_SPI].resumes);
+
+    CHECK(udrv_spimst_trx(UDRV_SPIMST_0, radio_buf, 2, radio_buf, 2, 0) == 0, "SPI down on first use");
+    CHECK(udrv_spimst_trx(UDRV_SPIMST_0, radio_buf, 2, radio_buf, 2, 0) == 0, "SPI down on second use");
+    CHECK(hw[UDRV_PS_PERIPH_SPI].resumes == 1, "SPI resumed %d times", hw[UDRV_PS_PERIPH_SPI].resumes);
+}
+
+// Interrupts while asleep resume and suspend the peripherals around their event
+static void test_wake_handler(void)
+{
+    setup();
+    udrv_twimst_init(UDRV_TWIMST_0);
+
+    sleep_once(radio_irq, NULL, NULL);
+    CHECK(udrv_spimst_trx(UDRV_SPIMST_0, radio_buf, 2, radio_buf, 2, 0) == 0, "SPI down after an RTC alarm wake-up");
+    CHECK(udrv_twimst_write(UDRV_TWIMST_0, 0x44, radio_buf, 1, true) == UDRV_RETURN_OK,
+          "TWI down after an RTC alarm wake-up");
+
+    sleep_once(sensor_irq, NULL, NULL);
+    CHECK(udrv_twimst_write(UDRV_TWIMST_0, 0x44, radio_buf, 1, true) == UDRV_RETURN_OK, "TWI down after a wake-up");
+    CHECK(udrv_spimst_trx(UDRV_SPIMST_0, radio_buf, 2, radio_buf, 2, 0) == 0, "SPI down after a wake-up");
+
+    // Both in one handler, then neither
+    sleep_once(radio_irq, NULL, NULL);
+    sleep_once(sensor_irq, NULL, NULL);
+    sleep_once(NULL, NULL, NULL);
+    CHECK(udrv_spimst_submit(UDRV_SPIMST_0, NULL, 0, NULL, NULL) == UDRV_RETURN_OK, "SPI down after three sleeps");
+    CHECK(udrv_twimst_read(UDRV_TWIMST_0, 0x44, radio_buf, 1) == UDRV_RETURN_OK, "TWI down after three sleeps");
+    for (int i = 0; i < UDRV_PS_PERIPH_MAX; i++)
+        CHECK(hw[i].up == hw[i].active, "%s %s after the sleeps", hw[i].name, hw[i].up ? "up" : "down");
+}
+
+static int hook_suspends, hook_resumes;
+
+static bool hook_is_active(void) { return true; }
+static void hook_suspend(void) { hook_suspends++; }
+static void hook_resume(void) { hook_resumes++; }
+
+static void test_register(void)
+{
+    static const struct udrv_powersave_periph_api hooks = {hook_is_active, hook_suspend, hook_resume};
+    static const struct udrv_powersave_periph_api no_resume = {hook_is_active, hook_suspend, NULL};
+    static const struct udrv_powersave_periph_api spi = {uhal_spimst_is_active, udrv_spimst_suspend,
+                                                         udrv_spimst_resume};
+
+    setup();
+    CHECK(udrv_powersave_register_periph(UDRV_PS_PERIPH_ADC, &hooks, false) == UDRV_RETURN_OK, "register refused");
+    CHECK(udrv_powersave_register_periph(UDRV_PS_PERIPH_PWM, &no_resume, false) == -UDRV_WRONG_ARG,
+          "hooks without resume taken");
+    CHECK(udrv_powersave_register_periph(UDRV_PS_PERIPH_MAX, &hooks, false) == -UDRV_WRONG_ARG,
+          "out of range peripheral taken");
+    sleep_once(NULL, NULL, NULL);
+    CHECK(hook_suspends == 1 && hook_resumes == 1, "registered hooks suspended %d, resumed %d times", hook_suspends,
+          hook_resumes);
+    CHECK(hw[UDRV_PS_PERIPH_ADC].suspends == 0, "replaced hooks called");
+
+    // Replacing the hooks of a lazy peripheral that is down brings it back first
+    CHECK(!hw[UDRV_PS_PERIPH_SPI].up, "SPI resumed on wake-up");
+    udrv_powersave_register_periph(UDRV_PS_PERIPH_SPI, NULL, false);
+    CHECK(hw[UDRV_PS_PERIPH_SPI].up, "SPI left down when its hooks were dropped");
+    sleep_once(NULL, NULL, NULL);
+    CHECK(hw[UDRV_PS_PERIPH_SPI].up && hw[UDRV_PS_PERIPH_SPI].suspends == 1, "SPI suspended without hooks");
+
+    udrv_powersave_register_periph(UDRV_PS_PERIPH_ADC, NULL, false);
+    udrv_powersave_register_periph(UDRV_PS_PERIPH_SPI, &spi, true);
+    sleep_once(NULL, NULL, NULL);
+    CHECK(hook_suspends == 2 && !hw[UDRV_PS_PERIPH_SPI].up, "hooks not dropped or restored");
+}
+
+/* Mean latency over SLEEPS sleeps with the radio used on every tenth
+ * wake-up, against the fixed sequence of every suspend and every resume. */
+static void bench(void)
+{
+    uint64_t entry_sum = 0, exit_sum = 0;
+    uint32_t entry, exit, fixed_entry = 0, fixed_exit = 0;
+
+    for (int i = UDRV_PS_PERIPH_SPI; i < UDRV_PS_PERIPH_MAX; i++)
+    {
+        fixed_entry += hw[i].suspend_us;
+        fixed_exit += hw[i].resume_us;
+    }
+
+    setup();
+    for (int n = 0; n < SLEEPS; n++)
+    {
+        sleep_once((n % RADIO_EVERY) == 0 ? radio_irq : NULL, &entry, &exit);
+        entry_sum += entry;
+        exit_sum += exit;
+    }
+    CHECK(entry_sum < fixed_entry * (uint64_t)SLEEPS && exit_sum < fixed_exit * (uint64_t)SLEEPS,
+          "%.0f/%.0f us, fixed sequence %u/%u us", (double)entry_sum / SLEEPS, (double)exit_sum / SLEEPS,
+          fixed_entry, fixed_exit);
+
+    printf("powersave: sleep entry/exit %.1f/%.1f us, fixed sequence %u/%u us; SPI resumed %d times in %d sleeps\n",
+           (double)entry_sum / SLEEPS, (double)exit_sum / SLEEPS, fixed_entry, fixed_exit,
+           hw[UDRV_PS_PERIPH_SPI].resumes, SLEEPS);
+}
+
+int main(void)
+{
+    test_active_only();
+    test_wake_handler();
+    test_register();
+    bench();
+
+    TEST_DONE("powersave");
+}
@@ -0,0 +1,140 @@
+/*
+ * Profiling zones of service_profile.c on the Linux time source of
+ * service_profile.h, CLOCK_MONOTONIC in ns instead of the DWT cycle counter.
+ *
+ * Zones around sleeps of known length have to report about that length in
+ * us, and the counter has to move forward between them. Passes of different
+ * lengths have to give the count, min, max and total they make, a start
+ * taken before the 32-bit counter wrapped has to give the length across the
+ * wrap, and the trace ring has to return the last records oldest first once
+ * it has gone round. A reset clears both.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "service_profile.h"
+#include "test.h"
+
+#define SLEEP_US        2000
+#define SLACK_US        50000           // a loaded host may take the CPU away for a while
+#define PASSES          (3 * SERVICE_PROFILE_TRACE_NUM + 5)
+
+static void sleep_us(uint32_t us)
+{
+    struct timespec ts = { us / 1000000, (us % 1000000) * 1000 };
+
+    nanosleep(&ts, NULL);
+}
+
+//
+// Time source
+//
+
+static void test_clock(void)
+{
+    service_profile_stat_t stat;
+    uint32_t us, first, second;
+
+    CHECK(SERVICE_PROFILE_HZ == 1000000000UL, "%lu Hz, the host counts in ns", (unsigned long)SERVICE_PROFILE_HZ);
+    CHECK(service_profile_cycles_to_us(1000) == 1, "1000 ns are %u us", service_profile_cycles_to_us(1000));
+
+    first = service_profile_now();
+    sleep_us(SLEEP_US);
+    second = service_profile_now();
+    us = service_profile_cycles_to_us(second - first);
+    CHECK(us >= SLEEP_US && us < SLEEP_US + SLACK_US, "the clock moved %u us over a %u us sleep", us, SLEEP_US);
+
+    service_profile_reset();
+    {
+        SERVICE_PROFILE_BEGIN(SERVICE_PROFILE_FLASH);
+        sleep_us(SLEEP_US);
+        SERVICE_PROFILE_END_ARG(SERVICE_PROFILE_FLASH, 1);
+    }
+    service_profile_get(SERVICE_PROFILE_FLASH, &stat);
+    us = service_profile_cycles_to_us(stat.max);
+    CHECK(stat.count == 1, "%u passes through FLASH", stat.count);
+    CHECK(us >= SLEEP_US && us < SLEEP_US + SLACK_US, "FLASH took %u us over a %u us sleep", us, SLEEP_US);
+}
+
+// The ns counter wraps every 4.3 s, a zone across it still has its length
+static void test_wrap(void)
+{
+    service_profile_stat_t stat;
+    uint32_t us;
+
+    service_profile_reset();
+    service_profile_record(SERVICE_PROFILE_LORAMAC, service_profile_now() - 3000000000u, 0);
+    service_profile_get(SERVICE_PROFILE_LORAMAC, &stat);
+    us = service_profile_cycles_to_us(stat.max);
+    CHECK(us >= 3000000 && us < 3000000 + SLACK_US, "%u us for a zone of 3 s", us);
+}
+
+//
+// Statistics and trace ring
+//
+
+static void test_stats(void)
+{
+    static service_profile_trace_t trace[SERVICE_PROFILE_TRACE_NUM + 8];
+    service_profile_stat_t stat;
+    uint64_t total = 0;
+    uint32_t min = UINT32_MAX, max = 0;
+    uint16_t n;
+
+    service_profile_reset();
+    for (int i = 0; i < PASSES; i++)
+    {
+        uint32_t cycles = 1000 + (i * 7919) % 50000;
+        SERVICE_PROFILE_ZONE zone = (i % 3) ? SERVICE_PROFILE_EVENT_HANDLER : SERVICE_PROFILE_SERIAL;
+
+        service_profile_record(zone, service_profile_now() - cycles, (uint16_t)i);
+        if (zone == SERVICE_PROFILE_EVENT_HANDLER)
+        {
+            total += cycles;
+            min = (cycles < min) ? cycles : min;
+            max = (cycles > max) ? cycles : max;
+        }
+    }
+
+    // The recorded length includes reading the clock, the floor is what it was given
+    service_profile_get(SERVICE_PROFILE_EVENT_HANDLER, &stat);
+    CHECK(stat.count == PASSES - (PASSES + 2) / 3, "%u passes through HANDLER", stat.count);
+    CHECK(stat.min >= min && stat.min < min + SLACK_US * 1000, "min %u ns, expected %u", stat.min, min);
+    CHECK(stat.max >= max && stat.max < max + SLACK_US * 1000, "max %u ns, expected %u", stat.max, max);
+    CHECK(stat.total >= total && stat.total < total + (uint64_t)stat.count * SLACK_US * 1000,
+          "total %llu ns, expected %llu", (unsigned long long)stat.total, (unsigned long long)total);
+    CHECK(stat.min <= stat.max && stat.total >= (uint64_t)stat.min * stat.count, "min %u, max %u and total %llu",
+          stat.min, stat.max, (unsigned long long)stat.total);
+
+    n = service_profile_trace_read(trace, sizeof(trace) / sizeof(trace[0]));
+    CHECK(n == SERVICE_PROFILE_TRACE_NUM, "%u records in the trace ring", n);
+    for (uint16_t i = 0; i < n; i++)
+    {
+        uint16_t pass = PASSES - n + i;
+
+        CHECK(trace[i].arg == pass, "record %u is pass %u, expected %u", i, trace[i].arg, pass);
+        CHECK(trace[i].zone == ((pass % 3) ? SERVICE_PROFILE_EVENT_HANDLER : SERVICE_PROFILE_SERIAL),
+              "record %u is zone %s", i, service_profile_zone_name((SERVICE_PROFILE_ZONE)trace[i].zone));
+        CHECK(i == 0 || (int32_t)(trace[i].start + trace[i].cycles - trace[i - 1].start - trace[i - 1].cycles) >= 0,
+              "record %u ends before record %u", i, i - 1);
+    }
+    n = service_profile_trace_read(trace, 5);
+    CHECK(n == 5 && trace[4].arg == PASSES - 1, "%u records, the last one pass %u", n, trace[4].arg);
+
+    service_profile_reset();
+    service_profile_get(SERVICE_PROFILE_EVENT_HANDLER, &stat);
+    CHECK(stat.count == 0 && stat.total == 0, "%u passes after the reset", stat.count);
+    n = service_profile_trace_read(trace, sizeof(trace) / sizeof(trace[0]));
+    CHECK(n == 0, "%u records after the reset", n);
+}
+
+int main(void)
+{
+    service_profile_init();
+    test_clock();
+    test_wrap();
+    test_stats();
+
+    TEST_DONE("profile");
+}
@@ -0,0 +1,223 @@
+/*
+ * Protocol mode framing: send/receive round trip, chunked delivery of frames
+ * larger than PROTO_BUFFER_SIZE, checksum errors and the inter-chunk timeout.
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include "service_mode_proto.h"
+#include "service_mode_proto_builtin_handler.h"
+#include "service_mode.h"
+#include "udrv_powersave.h"
+#include "udrv_rtc.h"
+#include "test.h"
+
+#define TYPE_CHUNKED    0x20
+#define TYPE_PLAIN      0x21
+
+static uint64_t now_ms = 1;
+
+uint64_t udrv_rtc_get_timestamp(RtcID_E timer_id)
+{
+    return now_ms;
+}
+
+SERVICE_MODE_TYPE service_nvm_get_mode_type_from_nvm(SERIAL_PORT port)
+{
+    return SERVICE_MODE_TYPE_PROTOCOL;
+}
+
+void udrv_powersave_wake_lock_by(UDRV_PS_WLOCK holder)
+{
+}
+
+void udrv_powersave_wake_unlock_by(UDRV_PS_WLOCK holder)
+{
+}
+
+void service_mode_proto_echo_request_handler(SERIAL_PORT port, uint8_t *payload, uint16_t length)
+{
+}
+
+void service_mode_proto_atcmd_request_handler(SERIAL_PORT port, uint8_t *payload, uint16_t length)
+{
+}
+
+void service_mode_proto_atcmd_batch_request_handler(SERIAL_PORT port, uint8_t *payload, uint16_t length)
+{
+}
+
+static uint8_t wire[65536 + 16];
+static uint32_t wire_len;
+static int writes;
+
+int32_t udrv_serial_write(SERIAL_PORT port, uint8_t const *buffer, int32_t length)
+{
+    memcpy(wire + wire_len, buffer, length);
+    wire_len += length;
+    writes++;
+    return length;
+}
+
+static uint8_t rx[65536];
+static uint32_t rx_len;
+static int frames, aborts, plain_frames, order_errors;
+
+static void chunk_handler(int port, uint8_t *chunk, uint16_t length, uint16_t offset, uint16_t total, PROTO_CHUNK_STATE state)
+{
+    if (state == PROTO_CHUNK_ABORT)
+    {
+        aborts++;
+        rx_len = 0;
+        return;
+    }
+    if (offset != rx_len || length > PROTO_BUFFER_SIZE)
+        order_errors++;
+    memcpy(rx + rx_len, chunk, length);
+    rx_len += length;
+    if (state == PROTO_CHUNK_LAST)
+    {
+        frames++;
+        if (rx_len != total)
+            order_errors++;
+    }
+}
+
+static void plain_handler(int port, uint8_t *payload, uint16_t length)
+{
+    memcpy(rx, payload, length);
+    rx_len = length;
+    plain_frames++;
+}
+
+static void feed(uint32_t from, uint32_t to)
+{
+    for (uint32_t i = from; i < to; i++)
+        service_mode_proto_recv(SERIAL_UART0, wire[i]);
+}
+
+static void encode(uint8_t type, uint8_t *payload, uint16_t length)
+{
+    wire_len = 0;
+    writes = 0;
+    service_mode_proto_send(SERIAL_UART0, 0, type, payload, length, NULL);
+}
+
+static void test_roundtrip(void)
+{
+    static uint8_t payload[65535];
+
+    srand(1);
+    for (int it = 0; it < 1000; it++)
+    {
+        uint16_t length = (it % 10 == 0) ? rand() % 65536 : rand() % 600;
+        int before = frames;
+
+        if (it == 1)
+            length = 0;
+        if (it == 2)
+            length = 65535;
+        for (uint32_t i = 0; i < length; i++)
+            payload[i] = rand();
+
+        encode(TYPE_CHUNKED, payload, length);
+        CHECK(wire_len == length + sizeof(proto_packet_header) + sizeof(proto_packet_tailer), "wire length %u", length);
+        CHECK(writes <= 3, "%d writes for %u bytes", writes, length);
+        if (wire_len <= PROTO_TX_STAGE_SIZE)
+            CHECK(writes == 1, "%d writes for a staged frame", writes);
+
+        rx_len = 0;
+        feed(0, wire_len);
+        CHECK(frames == before + 1 && rx_len == length && memcmp(rx, payload, length) == 0, "round trip %u", length);
+    }
+    CHECK(order_errors == 0, "%d chunk order errors", order_errors);
+
+    for (uint16_t length = 0; length < PROTO_BUFFER_SIZE - 1; length++)
+    {
+        int before = plain_frames;
+
+        for (uint16_t i = 0; i < length; i++)
+            payload[i] = i * 7 + length;
+        encode(TYPE_PLAIN, payload, length);
+        feed(0, wire_len);
+        CHECK(plain_frames == before + 1 && rx_len == length && memcmp(rx, payload, length) == 0, "plain round trip %u", length);
+    }
+}
+
+static void test_corrupt(void)
+{
+    static uint8_t payload[2000];
+
+    for (uint16_t i = 0; i < sizeof(payload); i++)
+        payload[i] = i;
+
+    encode(TYPE_CHUNKED, payload, sizeof(payload));
+    wire[sizeof(proto_packet_header) + 1000] ^= 0x01;
+
+    int frames0 = frames, aborts0 = aborts;
+    rx_len = 0;
+    feed(0, wire_len);
+    CHECK(frames == frames0 && aborts == aborts0 + 1, "corrupt chunked frame delivered");
+
+    //The next frame is received normally
+    encode(TYPE_CHUNKED, payload, sizeof(payload));
+    rx_len = 0;
+    feed(0, wire_len);
+    CHECK(frames == frames0 + 1 && memcmp(rx, payload, sizeof(payload)) == 0, "frame after corrupt one");
+}
+
+static void test_timeout(void)
+{
+    static uint8_t payload[PROTO_BUFFER_SIZE * 8];
+    uint32_t step = PROTO_BUFFER_SIZE;
+    int frames0, aborts0;
+
+    for (uint16_t i = 0; i < sizeof(payload); i++)
+        payload[i] = i ^ 0x5A;
+    encode(TYPE_CHUNKED, payload, sizeof(payload));
+
+    //Slow sender: each gap is under the timeout, the frame as a whole is not
+    frames0 = frames;
+    rx_len = 0;
+    for (uint32_t pos = 0; pos < wire_len; pos += step)
+    {
+        feed(pos, pos + step < wire_len ? pos + step : wire_len);
+        now_ms += PROTO_PKT_TIMEOUT - 100;
+    }
+    CHECK(frames == frames0 + 1 && memcmp(rx, payload, sizeof(payload)) == 0, "slow chunked frame dropped");
+
+    //A gap over the timeout aborts the frame
+    frames0 = frames;
+    aborts0 = aborts;
+    rx_len = 0;
+    feed(0, wire_len / 2);
+    now_ms += PROTO_PKT_TIMEOUT + 1;
+    feed(wire_len / 2, wire_len);
+    CHECK(frames == frames0 && aborts == aborts0 + 1, "stalled chunked frame not aborted");
+
+    //The rest of the stalled frame may hold a delimiter and open a bogus frame, which times out too
+    now_ms += PROTO_PKT_TIMEOUT + 1;
+    rx_len = 0;
+    feed(0, wire_len);
+    CHECK(frames == frames0 + 1, "frame after timeout");
+}
+
+static void test_garbage(void)
+{
+    srand(2);
+    for (int i = 0; i < 2000000; i++)
+        service_mode_proto_recv(SERIAL_UART0, (rand() & 7) == 0 ? PROTO_START_DELIMITER : rand());
+    CHECK(order_errors == 0, "%d chunk order errors on garbage", order_errors);
+}
+
+int main(void)
+{
+    service_mode_proto_init(SERIAL_UART0);
+    service_mode_proto_register_chunked(TYPE_CHUNKED, chunk_handler);
+    service_mode_proto_register(TYPE_PLAIN, plain_handler);
+
+    test_roundtrip();
+    test_corrupt();
+    test_timeout();
+    test_garbage();
+    TEST_DONE("proto");
+}
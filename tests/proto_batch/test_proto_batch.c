@@ -0,0 +1,713 @@
+/*
+ * Batched AT command frames against one frame per command. A provisioning
+ * script of 50 AT commands, 25 LoRaWAN session parameters set and read back,
+ * goes through the protocol framing and the built-in AT command handler on a
+ * mock service_lora and service_nvm: once command by command, waiting for
+ * the responses of each, and once packed into batch frames as large as the
+ * receive buffer takes.
+ *
+ * Both runs have to leave the same settings behind and return the same data
+ * and status records. Every batch response frame but the last of a request
+ * carries PROTO_ATCMD_FLAG_MORE_DATA, and their counts add up to the entries
+ * of the request. A bad entry in a batch gets its own error status and the
+ * entries after it still run.
+ *
+ * The wall time is estimated for a 115200 baud UART and a host that needs
+ * TURNAROUND_MS from the last byte of a response to the next request, the
+ * default latency timer of an FTDI USB serial adapter.
+ */
+#include <stdint.h>
+#include <string.h>
+#include "atcmd.h"
+#include "service_mode_proto.h"
+#include "service_mode_proto_builtin_handler.h"
+#include "service_mode.h"
+#include "service_lora.h"
+#include "udrv_errno.h"
+#include "udrv_powersave.h"
+#include "udrv_rtc.h"
+#include "test.h"
+
+#define BAUD            115200
+#define BITS_PER_BYTE   10
+#define TURNAROUND_MS   16
+#define MAX_REQUEST     (PROTO_BUFFER_SIZE - 1)     // payload the receive buffer keeps
+#define FRAME_OVERHEAD  (sizeof(proto_packet_header) + sizeof(proto_packet_tailer))
+
+static int unused_calls;
+
+int unused(const char *name)
+{
+    CHECK(0, "%s called", name);
+    unused_calls++;
+    return 0;
+}
+
+//
+// Mock device settings
+//
+
+static struct {
+    SERVICE_LORA_WORK_MODE nwm;
+    uint8_t dev_eui[8];
+    uint8_t app_eui[8];
+    uint8_t app_key[16];
+    uint8_t dev_addr[4];
+    uint8_t app_skey[16];
+    uint8_t nwk_skey[16];
+    SERVICE_LORA_JOIN_MODE njm;
+    SERVICE_LORA_CLASS class;
+    bool adr;
+    SERVICE_LORA_DATA_RATE dr;
+    uint8_t txp;
+    SERVICE_LORA_CONFIRM_MODE cfm;
+    uint8_t retry;
+    bool dcs;
+    bool pnm;
+    uint32_t rx1dl;
+    uint32_t rx2dl;
+    uint32_t jn1dl;
+    uint32_t jn2dl;
+    SERVICE_LORA_DATA_RATE rx2dr;
+    uint32_t rx2freq;
+    uint8_t linkcheck;
+    uint8_t pgslot;
+    uint32_t auto_sleep;
+} dev;
+
+static void dev_reset(void)
+{
+    memset(&dev, 0, sizeof(dev));
+    dev.nwm = SERVICE_LORA_P2P;
+    dev.rx1dl = 1000;
+    dev.rx2dl = 2000;
+    dev.jn1dl = 5000;
+    dev.jn2dl = 6000;
+}
+
+static int32_t set_bytes(uint8_t *dst, uint32_t size, uint8_t *buff, uint32_t len)
+{
+    if (len != size)
+        return -UDRV_WRONG_ARG;
+    memcpy(dst, buff, len);
+    return UDRV_RETURN_OK;
+}
+
+static int32_t get_bytes(uint8_t *src, uint32_t size, uint8_t *buff, uint32_t len)
+{
+    if (len < size)
+        return -UDRV_WRONG_ARG;
+    memcpy(buff, src, size);
+    return UDRV_RETURN_OK;
+}
+
+SERVICE_LORA_WORK_MODE service_lora_get_nwm(void)
+{
+    return dev.nwm;
+}
+
+int32_t service_lora_set_nwm(SERVICE_LORA_WORK_MODE nwm)
+{
+    dev.nwm = nwm;
+    return UDRV_RETURN_OK;
+}
+
+int32_t service_lora_set_dev_eui(uint8_t *buff, uint32_t len)
+{
+    return set_bytes(dev.dev_eui, sizeof(dev.dev_eui), buff, len);
+}
+
+int32_t service_lora_get_dev_eui(uint8_t *buff, uint32_t len)
+{
+    return get_bytes(dev.dev_eui, sizeof(dev.dev_eui), buff, len);
+}
+
+int32_t service_lora_set_app_eui(uint8_t *buff, uint32_t len)
+{
+    return set_bytes(dev.app_eui, sizeof(dev.app_eui), buff, len);
+}
+
+int32_t service_lora_get_app_eui(uint8_t *buff, uint32_t len)
+{
+    return get_bytes(dev.app_eui, sizeof(dev.app_eui), buff, len);
+}
+
+int32_t service_lora_set_app_key(uint8_t *buff, uint32_t len)
+{
+    return set_bytes(dev.app_key, sizeof(dev.app_key), buff, len);
+}
+
+int32_t service_lora_get_app_key(uint8_t *buff, uint32_t len)
+{
+    return get_bytes(dev.app_key, sizeof(dev.app_key), buff, len);
+}
+
+int32_t service_lora_set_dev_addr(uint8_t *buff, uint32_t len)
+{
+    return set_bytes(dev.dev_addr, sizeof(dev.dev_addr), buff, len);
+}
+
+int32_t service_lora_get_dev_addr(uint8_t *buff, uint32_t len)
+{
+    return get_bytes(dev.dev_addr, sizeof(dev.dev_addr), buff, len);
+}
+
+int32_t service_lora_set_app_skey(uint8_t *buff, uint32_t len)
+{
+    return set_bytes(dev.app_skey, sizeof(dev.app_skey), buff, len);
+}
+
+int32_t service_lora_get_app_skey(uint8_t *buff, uint32_t len)
+{
+    return get_bytes(dev.app_skey, sizeof(dev.app_skey), buff, len);
+}
+
+int32_t service_lora_set_nwk_skey(uint8_t *buff, uint32_t len)
+{
+    return set_bytes(dev.nwk_skey, sizeof(dev.nwk_skey), buff, len);
+}
+
+int32_t service_lora_get_nwk_skey(uint8_t *buff, uint32_t len)
+{
+    return get_bytes(dev.nwk_skey, sizeof(dev.nwk_skey), buff, len);
+}
+
+int32_t service_lora_set_njm(SERVICE_LORA_JOIN_MODE njm, bool commit)
+{
+    dev.njm = njm;
+    return UDRV_RETURN_OK;
+}
+
+SERVICE_LORA_JOIN_MODE service_lora_get_njm(void)
+{
+    return dev.njm;
+}
+
+int32_t service_lora_set_class(SERVICE_LORA_CLASS device_class, bool commit)
+{
+    dev.class = device_class;
+    return UDRV_RETURN_OK;
+}
+
+SERVICE_LORA_CLASS service_lora_get_class(void)
+{
+    return dev.class;
+}
+
+int32_t service_lora_set_adr(bool adr, bool commit)
+{
+    dev.adr = adr;
+    return UDRV_RETURN_OK;
+}
+
+bool service_lora_get_adr(void)
+{
+    return dev.adr;
+}
+
+int32_t service_lora_set_dr(SERVICE_LORA_DATA_RATE dr, bool commit)
+{
+    dev.dr = dr;
+    return UDRV_RETURN_OK;
+}
+
+SERVICE_LORA_DATA_RATE service_lora_get_dr(void)
+{
+    return dev.dr;
+}
+
+int32_t service_lora_set_txpower(uint8_t txp, bool commit)
+{
+    dev.txp = txp;
+    return UDRV_RETURN_OK;
+}
+
+uint8_t service_lora_get_txpower(void)
+{
+    return dev.txp;
+}
+
+int32_t service_lora_set_cfm(SERVICE_LORA_CONFIRM_MODE cfm)
+{
+    dev.cfm = cfm;
+    return UDRV_RETURN_OK;
+}
+
+SERVICE_LORA_CONFIRM_MODE service_lora_get_cfm(void)
+{
+    return dev.cfm;
+}
+
+int32_t service_lora_set_retry(uint8_t retry)
+{
+    dev.retry = retry;
+    return UDRV_RETURN_OK;
+}
+
+uint8_t service_lora_get_retry(void)
+{
+    return dev.retry;
+}
+
+int32_t service_lora_set_dcs(uint8_t dutycycle, bool commit)
+{
+    dev.dcs = dutycycle;
+    return UDRV_RETURN_OK;
+}
+
+bool service_lora_get_dcs(void)
+{
+    return dev.dcs;
+}
+
+int32_t service_lora_set_pub_nwk_mode(bool pnm, bool commit)
+{
+    dev.pnm = pnm;
+    return UDRV_RETURN_OK;
+}
+
+bool service_lora_get_pub_nwk_mode(void)
+{
+    return dev.pnm;
+}
+
+int32_t service_lora_set_rx1dl(uint32_t rx1dl, bool commit)
+{
+    dev.rx1dl = rx1dl;
+    return UDRV_RETURN_OK;
+}
+
+int32_t service_lora_set_rx2dl(uint32_t rx2dl, bool commit)
+{
+    dev.rx2dl = rx2dl;
+    return UDRV_RETURN_OK;
+}
+
+int32_t service_lora_set_jn1dl(uint32_t jn1dl, bool commit)
+{
+    dev.jn1dl = jn1dl;
+    return UDRV_RETURN_OK;
+}
+
+int32_t service_lora_set_jn2dl(uint32_t jn2dl, bool commit)
+{
+    dev.jn2dl = jn2dl;
+    return UDRV_RETURN_OK;
+}
+
+uint32_t service_lora_get_jn1dl(void)
+{
+    return dev.jn1dl;
+}
+
+uint32_t service_lora_get_jn2dl(void)
+{
+    return dev.jn2dl;
+}
+
+uint32_t service_nvm_get_rx1dl_from_nvm(void)
+{
+    return dev.rx1dl;
+}
+
+uint32_t service_nvm_get_rx2dl_from_nvm(void)
+{
+    return dev.rx2dl;
+}
+
+uint32_t service_nvm_get_jn1dl_from_nvm(void)
+{
+    return dev.jn1dl;
+}
+
+uint32_t service_nvm_get_jn2dl_from_nvm(void)
+{
+    return dev.jn2dl;
+}
+
+uint32_t service_lora_set_rx2dr(SERVICE_LORA_DATA_RATE datarate, bool commit)
+{
+    dev.rx2dr = datarate;
+    return UDRV_RETURN_OK;
+}
+
+SERVICE_LORA_DATA_RATE service_lora_get_rx2dr(void)
+{
+    return dev.rx2dr;
+}
+
+uint32_t service_lora_set_rx2freq(uint32_t freq, bool commit)
+{
+    dev.rx2freq = freq;
+    return UDRV_RETURN_OK;
+}
+
+uint32_t service_lora_get_rx2freq(void)
+{
+    return dev.rx2freq;
+}
+
+int32_t service_lora_set_linkcheck(uint8_t mode)
+{
+    dev.linkcheck = mode;
+    return UDRV_RETURN_OK;
+}
+
+uint8_t service_lora_get_linkcheck(void)
+{
+    return dev.linkcheck;
+}
+
+int32_t service_lora_set_ping_slot_periodicity(uint8_t periodicity)
+{
+    dev.pgslot = periodicity;
+    return UDRV_RETURN_OK;
+}
+
+uint8_t service_lora_get_ping_slot_periodicity(void)
+{
+    return dev.pgslot;
+}
+
+int32_t service_nvm_set_auto_sleep_time_to_nvm(uint32_t time)
+{
+    dev.auto_sleep = time;
+    return UDRV_RETURN_OK;
+}
+
+uint32_t service_nvm_get_auto_sleep_time_from_nvm(void)
+{
+    return dev.auto_sleep;
+}
+
+SERVICE_MODE_TYPE service_nvm_get_mode_type_from_nvm(SERIAL_PORT port)
+{
+    return SERVICE_MODE_TYPE_PROTOCOL;
+}
+
+//
+// Platform
+//
+
+uint64_t udrv_rtc_get_timestamp(RtcID_E timer_id)
+{
+    return 1;
+}
+
+void udrv_powersave_wake_lock_by(UDRV_PS_WLOCK holder)
+{
+}
+
+void udrv_powersave_wake_unlock_by(UDRV_PS_WLOCK holder)
+{
+}
+
+static uint8_t wire[8192];              // device to host
+static uint32_t wire_len;
+
+int32_t udrv_serial_write(SERIAL_PORT port, uint8_t const *buffer, int32_t length)
+{
+    CHECK(wire_len + length <= sizeof(wire), "response overflow");
+    if (wire_len + length <= sizeof(wire))
+    {
+        memcpy(wire + wire_len, buffer, length);
+        wire_len += length;
+    }
+    return length;
+}
+
+//
+// Host side
+//
+
+/* The script: every parameter is written, then read back. Multi-byte values
+ * are big endian, delays in seconds. */
+static const struct {
+    uint8_t id;
+    uint8_t len;
+    uint8_t arg[16];
+} params[] = {
+    { SERVICE_MODE_PROTO_ATCMD_NWM, 1, { SERVICE_LORAWAN } },
+    { SERVICE_MODE_PROTO_ATCMD_DEUI, 8, { 0xAC, 0x1F, 0x09, 0xFF, 0xFE, 0x00, 0x42, 0x01 } },
+    { SERVICE_MODE_PROTO_ATCMD_APPEUI, 8, { 0x70, 0xB3, 0xD5, 0x7E, 0xD0, 0x00, 0x00, 0x01 } },
+    { SERVICE_MODE_PROTO_ATCMD_APPKEY, 16, { 0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6,
+                                             0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C } },
+    { SERVICE_MODE_PROTO_ATCMD_DADDR, 4, { 0x26, 0x01, 0x12, 0x34 } },
+    { SERVICE_MODE_PROTO_ATCMD_APPSKEY, 16, { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88,
+                                              0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF, 0x00 } },
+    { SERVICE_MODE_PROTO_ATCMD_NWKSKEY, 16, { 0x00, 0xFF, 0xEE, 0xDD, 0xCC, 0xBB, 0xAA, 0x99,
+                                              0x88, 0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11 } },
+    { SERVICE_MODE_PROTO_ATCMD_NJM, 1, { SERVICE_LORA_OTAA } },
+    { SERVICE_MODE_PROTO_ATCMD_CLASS, 1, { 'C' } },
+    { SERVICE_MODE_PROTO_ATCMD_ADR, 1, { 0 } },
+    { SERVICE_MODE_PROTO_ATCMD_DR, 1, { 3 } },
+    { SERVICE_MODE_PROTO_ATCMD_TXP, 1, { 2 } },
+    { SERVICE_MODE_PROTO_ATCMD_CFM, 1, { 1 } },
+    { SERVICE_MODE_PROTO_ATCMD_RETY, 1, { 3 } },
+    { SERVICE_MODE_PROTO_ATCMD_DCS, 1, { 0 } },
+    { SERVICE_MODE_PROTO_ATCMD_PNM, 1, { 1 } },
+    { SERVICE_MODE_PROTO_ATCMD_RX1DL, 4, { 0, 0, 0, 2 } },
+    { SERVICE_MODE_PROTO_ATCMD_RX2DL, 4, { 0, 0, 0, 3 } },
+    { SERVICE_MODE_PROTO_ATCMD_JN2DL, 4, { 0, 0, 0, 7 } },
+    { SERVICE_MODE_PROTO_ATCMD_JN1DL, 4, { 0, 0, 0, 6 } },
+    { SERVICE_MODE_PROTO_ATCMD_RX2DR, 1, { 3 } },
+    { SERVICE_MODE_PROTO_ATCMD_RX2FQ, 4, { 0x33, 0xD3, 0xE6, 0x08 } },      // 869525000 Hz
+    { SERVICE_MODE_PROTO_ATCMD_LINKCHECK, 1, { 2 } },
+    { SERVICE_MODE_PROTO_ATCMD_PGSLOT, 1, { 4 } },
+    { SERVICE_MODE_PROTO_ATCMD_AUTOSLEEP, 1, { 1 } },
+};
+#define NB_PARAMS   (sizeof(params) / sizeof(params[0]))
+#define NB_ENTRIES  (2 * NB_PARAMS)
+
+static uint8_t host_records[2][4096];   // data and status records of either run
+static uint32_t host_records_len[2];
+
+static struct {
+    int round_trips;
+    uint32_t bytes;                     // both ways
+    int frames;                         // response frames
+    int more_data;
+    int batch_count;                    // entries acknowledged by the batch headers
+} run[2];
+
+// One AT command entry, the payload of a PROTO_FRAME_TYPE_ATCMD frame
+static uint16_t entry(uint8_t *buf, int n)
+{
+    const bool write = n < NB_PARAMS;
+    const int p = write ? n : n - NB_PARAMS;
+    proto_atcmd_header header;
+
+    header.length = __builtin_bswap16(write ? params[p].len : 0);
+    header.flag = write ? PROTO_ATCMD_FLAG_WR_OR_EXE : 0;
+    header.atcmd_id = params[p].id;
+    memcpy(buf, &header, sizeof(header));
+    if (write)
+        memcpy(buf + sizeof(header), params[p].arg, params[p].len);
+    return sizeof(header) + (write ? params[p].len : 0);
+}
+
+// Frames the payload and feeds it to the device, the responses pile up in wire
+static void request(uint8_t type, const uint8_t *payload, uint16_t length)
+{
+    uint8_t chksum = __builtin_popcount(type);
+
+    service_mode_proto_recv(SERIAL_UART0, PROTO_START_DELIMITER);
+    service_mode_proto_recv(SERIAL_UART0, length >> 8);
+    service_mode_proto_recv(SERIAL_UART0, length & 0xFF);
+    service_mode_proto_recv(SERIAL_UART0, type);
+    service_mode_proto_recv(SERIAL_UART0, 0);
+    for (uint16_t i = 0; i < length; i++)
+    {
+        chksum += __builtin_popcount(payload[i]);
+        service_mode_proto_recv(SERIAL_UART0, payload[i]);
+    }
+    service_mode_proto_recv(SERIAL_UART0, chksum);
+}
+
+/* Splits the responses to one request into frames and keeps their records.
+ * Returns the entries acknowledged by batch headers. */
+static int responses(int r, uint8_t type)
+{
+    uint32_t pos = 0;
+    int count = 0;
+
+    while (pos + FRAME_OVERHEAD <= wire_len)
+    {
+        uint16_t length = (wire[pos + 1] << 8) | wire[pos + 2];
+        uint8_t *payload = wire + pos + sizeof(proto_packet_header);
+        uint8_t chksum = __builtin_popcount(wire[pos + 3]) + __builtin_popcount(wire[pos + 4]);
+        bool last = pos + FRAME_OVERHEAD + length >= wire_len;
+
+        CHECK(wire[pos] == PROTO_START_DELIMITER && wire[pos + 3] == type && (wire[pos + 4] & PROTO_FLAG_RESPONSE),
+              "response frame at %u: %02X type %02X flag %02X", pos, wire[pos], wire[pos + 3], wire[pos + 4]);
+        for (uint16_t i = 0; i < length; i++)
+            chksum += __builtin_popcount(payload[i]);
+        CHECK(chksum == payload[length], "response frame at %u: checksum", pos);
+        run[r].frames++;
+
+        if (type == PROTO_FRAME_TYPE_ATCMD_BATCH)
+        {
+            proto_atcmd_batch_header header;
+
+            memcpy(&header, payload, sizeof(header));
+            CHECK(__builtin_bswap16(header.length) == length - sizeof(header) &&
+                  length - sizeof(header) <= PROTO_ATCMD_BATCH_SIZE, "batch response of %u bytes", length);
+            CHECK(!(header.flag & PROTO_ATCMD_FLAG_MORE_DATA) == last, "MORE_DATA %s the last response frame",
+                  last ? "on" : "missing before");
+            if (header.flag & PROTO_ATCMD_FLAG_MORE_DATA)
+                run[r].more_data++;
+            count += header.count;
+            payload += sizeof(header);
+            length -= sizeof(header);
+        }
+        memcpy(host_records[r] + host_records_len[r], payload, length);
+        host_records_len[r] += length;
+        pos += FRAME_OVERHEAD + length + (type == PROTO_FRAME_TYPE_ATCMD_BATCH ? sizeof(proto_atcmd_batch_header) : 0);
+    }
+    CHECK(pos == wire_len, "%u bytes of responses left", wire_len - pos);
+    run[r].bytes += wire_len;
+    wire_len = 0;
+    return count;
+}
+
+static void replay_single(void)
+{
+    uint8_t buf[MAX_REQUEST];
+
+    for (int n = 0; n < NB_ENTRIES; n++)
+    {
+        uint16_t length = entry(buf, n);
+
+        request(PROTO_FRAME_TYPE_ATCMD, buf, length);
+        run[0].round_trips++;
+        run[0].bytes += FRAME_OVERHEAD + length;
+        responses(0, PROTO_FRAME_TYPE_ATCMD);
+    }
+}
+
+static void replay_batch(void)
+{
+    uint8_t buf[MAX_REQUEST];
+    int n = 0;
+
+    while (n < NB_ENTRIES)
+    {
+        uint8_t next[sizeof(proto_atcmd_header) + 16];
+        uint16_t length = 0;
+        int first = n;
+
+        // As many entries as the receive buffer of the device takes
+        while (n < NB_ENTRIES)
+        {
+            uint16_t size = entry(next, n);
+
+            if (length + size > MAX_REQUEST)
+                break;
+            memcpy(buf + length, next, size);
+            length += size;
+            n++;
+        }
+        request(PROTO_FRAME_TYPE_ATCMD_BATCH, buf, length);
+        run[1].round_trips++;
+        run[1].bytes += FRAME_OVERHEAD + length;
+        run[1].batch_count += responses(1, PROTO_FRAME_TYPE_ATCMD_BATCH);
+        CHECK(run[1].batch_count == n, "batch of entries %d to %d: %d acknowledged", first, n - 1,
+              run[1].batch_count - first);
+    }
+}
+
+static double wall_ms(int r)
+{
+    return run[r].bytes * BITS_PER_BYTE * 1000.0 / BAUD + run[r].round_trips * TURNAROUND_MS;
+}
+
+// Every write has to be in the device and be read back as written
+static void check_settings(const char *how)
+{
+    uint32_t pos = 0;
+    int reads = 0;
+
+    CHECK(dev.nwm == SERVICE_LORAWAN && dev.njm == SERVICE_LORA_OTAA && dev.class == SERVICE_LORA_CLASS_C &&
+          dev.dr == 3 && dev.txp == 2 && dev.cfm == 1 && dev.retry == 3 && dev.pnm && !dev.adr &&
+          dev.rx1dl == 2000 && dev.rx2dl == 3000 && dev.jn1dl == 6000 && dev.jn2dl == 7000 &&
+          dev.rx2freq == 869525000 && dev.linkcheck == 2 && dev.pgslot == 4 && dev.auto_sleep == 1 &&
+          !memcmp(dev.app_key, params[3].arg, 16) && !memcmp(dev.dev_addr, params[4].arg, 4),
+          "%s: settings not applied", how);
+
+    // Records: a status record per write, a data record and a status record per read
+    for (int n = 0; n < NB_ENTRIES && pos + sizeof(proto_atcmd_header) <= host_records_len[0]; n++)
+    {
+        proto_atcmd_header header;
+        const int p = n % NB_PARAMS;
+
+        if (n >= NB_PARAMS)
+        {
+            memcpy(&header, host_records[0] + pos, sizeof(header));
+            CHECK(header.atcmd_id == params[p].id && __builtin_bswap16(header.length) == params[p].len &&
+                  !memcmp(host_records[0] + pos + sizeof(header), params[p].arg, params[p].len),
+                  "%s: parameter %d read back differently", how, params[p].id);
+            pos += sizeof(header) + __builtin_bswap16(header.length);
+            reads++;
+        }
+        memcpy(&header, host_records[0] + pos, sizeof(header));
+        CHECK(header.atcmd_id == params[p].id && !(header.flag & PROTO_ATCMD_FLAG_ERROR) &&
+              host_records[0][pos + sizeof(header)] == AT_OK, "%s: entry %d for parameter %d failed", how, n,
+              params[p].id);
+        pos += sizeof(header) + 1;
+    }
+    CHECK(reads == NB_PARAMS && pos == host_records_len[0], "%s: %d reads, %u of %u record bytes", how, reads, pos,
+          host_records_len[0]);
+}
+
+static void test_provisioning(void)
+{
+    dev_reset();
+    replay_single();
+    check_settings("single frames");
+
+    dev_reset();
+    replay_batch();
+    CHECK(host_records_len[1] == host_records_len[0] && !memcmp(host_records[1], host_records[0], host_records_len[0]),
+          "batched records differ from the single frame ones");
+    check_settings("batch frames");
+
+    CHECK(run[0].round_trips == NB_ENTRIES && run[1].round_trips * 10 <= run[0].round_trips,
+          "%d round trips batched, %d single", run[1].round_trips, run[0].round_trips);
+    CHECK(run[1].more_data > 0, "no batch response needed a continuation frame");
+    CHECK(wall_ms(1) * 5 < wall_ms(0), "%.0f ms batched, %.0f ms single", wall_ms(1), wall_ms(0));
+}
+
+// A bad entry between good ones, then an entry cut short at the end of the frame
+static void test_entry_status(void)
+{
+    uint8_t buf[64] = { 0 };
+    uint16_t length = 0;
+    uint32_t records = host_records_len[1];
+    proto_atcmd_header header;
+    const uint8_t *rec;
+
+    dev_reset();
+    length += entry(buf + length, 0);                                   // NWM LoRaWAN
+    header.length = __builtin_bswap16(4);
+    header.flag = PROTO_ATCMD_FLAG_WR_OR_EXE;
+    header.atcmd_id = SERVICE_MODE_PROTO_ATCMD_RX2DL;
+    memcpy(buf + length, &header, sizeof(header));
+    memcpy(buf + length + sizeof(header), "\x00\x00\x00\x01", 4);       // 1 s, below the RX2 minimum
+    length += sizeof(header) + 4;
+    length += entry(buf + length, 10);                                  // DR 3
+    header.length = __builtin_bswap16(16);
+    header.atcmd_id = SERVICE_MODE_PROTO_ATCMD_APPKEY;
+    memcpy(buf + length, &header, sizeof(header));
+    length += sizeof(header) + 2;                                       // 2 of 16 bytes
+
+    request(PROTO_FRAME_TYPE_ATCMD_BATCH, buf, length);
+    CHECK(responses(1, PROTO_FRAME_TYPE_ATCMD_BATCH) == 4, "not every entry acknowledged");
+    CHECK(host_records_len[1] - records == 4 * (sizeof(header) + 1), "%u record bytes for 4 statuses",
+          host_records_len[1] - records);
+
+    rec = host_records[1] + records;
+    CHECK(rec[3] == SERVICE_MODE_PROTO_ATCMD_NWM && rec[4] == AT_OK, "NWM status %u", rec[4]);
+    rec += sizeof(header) + 1;
+    CHECK(rec[3] == SERVICE_MODE_PROTO_ATCMD_RX2DL && (rec[2] & PROTO_ATCMD_FLAG_ERROR) && rec[4] == AT_PARAM_ERROR,
+          "RX2DL status %u", rec[4]);
+    rec += sizeof(header) + 1;
+    CHECK(rec[3] == SERVICE_MODE_PROTO_ATCMD_DR && rec[4] == AT_OK && dev.dr == 3, "DR status %u", rec[4]);
+    rec += sizeof(header) + 1;
+    CHECK(rec[3] == SERVICE_MODE_PROTO_ATCMD_APPKEY && rec[4] == AT_PARAM_ERROR, "cut APPKEY status %u", rec[4]);
+    CHECK(dev.rx2dl == 2000, "rejected RX2DL applied");
+}
+
+int main(void)
+{
+    service_mode_proto_init(SERIAL_UART0);
+
+    test_provisioning();
+    test_entry_status();
+    CHECK(unused_calls == 0, "%d calls outside the script", unused_calls);
+
+    printf("proto_batch: %zu commands in %d round trips, %u bytes, %.0f ms with single frames; "
+           "%d round trips, %u bytes, %.0f ms batched (%d response frames, %d continued)\n", NB_ENTRIES,
+           run[0].round_trips, run[0].bytes, wall_ms(0), run[1].round_trips, run[1].bytes, wall_ms(1),
+           run[1].frames, run[1].more_data);
+    TEST_DONE("proto_batch");
+}
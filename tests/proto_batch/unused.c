@@ -0,0 +1,344 @@
+/*
+ * The rest of what service_mode_proto_builtin_handler.c calls. The
+ * provisioning script does not reach any of it, each one fails the test.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include "udrv_serial.h"
+#include "service_lora.h"
+#include "service_mode.h"
+
+int unused(const char *name);
+
+const char *sw_version = "";
+const char *model_id = "";
+const char *chip_id = "";
+const char *build_date = "";
+const char *build_time = "";
+const char *repo_info = "";
+const char *cli_version = "";
+const char *api_version = "";
+const char BOOT_VERSION = 0;
+
+void service_battery_get_SysVolt_level(float *sys_lvl)
+{
+    unused(__func__);
+}
+
+void service_battery_get_batt_level(float *bat_lvl)
+{
+    unused(__func__);
+}
+
+bool service_lora_get_auto_join(void)
+{
+    return unused(__func__);
+}
+
+uint32_t service_lora_get_auto_join_max_cnt(void)
+{
+    return unused(__func__);
+}
+
+uint32_t service_lora_get_auto_join_period(void)
+{
+    return unused(__func__);
+}
+
+SERVICE_LORA_BAND service_lora_get_band(void)
+{
+    return unused(__func__);
+}
+
+uint32_t service_lora_get_beacon_freq(void)
+{
+    return unused(__func__);
+}
+
+beacon_bgw_t service_lora_get_beacon_gwspecific(void)
+{
+    beacon_bgw_t bgw = { 0 };
+
+    unused(__func__);
+    return bgw;
+}
+
+uint32_t service_lora_get_beacon_time(void)
+{
+    return unused(__func__);
+}
+
+bool service_lora_get_cfs(void)
+{
+    return unused(__func__);
+}
+
+bool service_lora_get_join_start(void)
+{
+    return unused(__func__);
+}
+
+int32_t service_lora_get_last_recv(uint8_t *port, uint8_t *buff, uint32_t len)
+{
+    return unused(__func__);
+}
+
+int32_t service_lora_get_local_time(char *local_time)
+{
+    return unused(__func__);
+}
+
+int32_t service_lora_get_net_id(uint8_t *buff, uint32_t len)
+{
+    return unused(__func__);
+}
+
+bool service_lora_get_njs(void)
+{
+    return unused(__func__);
+}
+
+int16_t service_lora_get_rssi(void)
+{
+    return unused(__func__);
+}
+
+int8_t service_lora_get_snr(void)
+{
+    return unused(__func__);
+}
+
+int32_t service_lora_join(int32_t param1, int32_t param2, int32_t param3, int32_t param4)
+{
+    return unused(__func__);
+}
+
+int32_t service_lora_lptp_send(uint8_t port, bool ack, uint8_t *p_data, uint16_t len)
+{
+    return unused(__func__);
+}
+
+bool service_lora_p2p_get_CAD(void)
+{
+    return unused(__func__);
+}
+
+uint32_t service_lora_p2p_get_bandwidth(void)
+{
+    return unused(__func__);
+}
+
+uint32_t service_lora_p2p_get_bitrate(void)
+{
+    return unused(__func__);
+}
+
+uint8_t service_lora_p2p_get_codingrate(void)
+{
+    return unused(__func__);
+}
+
+bool service_lora_p2p_get_crypto_enable(void)
+{
+    return unused(__func__);
+}
+
+int32_t service_lora_p2p_get_crypto_key(uint8_t *buff, uint32_t len)
+{
+    return unused(__func__);
+}
+
+uint32_t service_lora_p2p_get_fdev(void)
+{
+    return unused(__func__);
+}
+
+uint32_t service_lora_p2p_get_freq(void)
+{
+    return unused(__func__);
+}
+
+uint8_t service_lora_p2p_get_powerdbm(void)
+{
+    return unused(__func__);
+}
+
+uint16_t service_lora_p2p_get_preamlen(void)
+{
+    return unused(__func__);
+}
+
+uint8_t service_lora_p2p_get_sf(void)
+{
+    return unused(__func__);
+}
+
+int32_t service_lora_p2p_recv(uint32_t timeout)
+{
+    return unused(__func__);
+}
+
+int32_t service_lora_p2p_send(uint8_t *p_data, uint8_t len, bool cad_enable)
+{
+    return unused(__func__);
+}
+
+int32_t service_lora_p2p_set_bandwidth(uint32_t bandwidth)
+{
+    return unused(__func__);
+}
+
+int32_t service_lora_p2p_set_bitrate(uint32_t bitrate)
+{
+    return unused(__func__);
+}
+
+int32_t service_lora_p2p_set_codingrate(uint8_t codingrate)
+{
+    return unused(__func__);
+}
+
+int32_t service_lora_p2p_set_crypto_enable(bool enable)
+{
+    return unused(__func__);
+}
+
+int32_t service_lora_p2p_set_crypto_key(uint8_t *buff, uint32_t len)
+{
+    return unused(__func__);
+}
+
+int32_t service_lora_p2p_set_fdev(uint32_t fdev)
+{
+    return unused(__func__);
+}
+
+int32_t service_lora_p2p_set_freq(uint32_t freq)
+{
+    return unused(__func__);
+}
+
+int32_t service_lora_p2p_set_powerdbm(uint8_t powerdbm)
+{
+    return unused(__func__);
+}
+
+int32_t service_lora_p2p_set_preamlen(uint16_t preamlen)
+{
+    return unused(__func__);
+}
+
+int32_t service_lora_p2p_set_sf(uint8_t spreadfact)
+{
+    return unused(__func__);
+}
+
+int32_t service_lora_send(uint8_t *buff, uint32_t len, SERVICE_LORA_SEND_INFO info, bool blocking)
+{
+    return unused(__func__);
+}
+
+int32_t service_lora_set_band(SERVICE_LORA_BAND band)
+{
+    return unused(__func__);
+}
+
+int32_t service_lora_set_lora_default(void)
+{
+    return unused(__func__);
+}
+
+void service_mode_cli_deinit(SERIAL_PORT port)
+{
+    unused(__func__);
+}
+
+void service_mode_cli_init(SERIAL_PORT port)
+{
+    unused(__func__);
+}
+
+int32_t service_nvm_get_atcmd_alias_from_nvm(uint8_t *buff, uint32_t len)
+{
+    return unused(__func__);
+}
+
+uint32_t service_nvm_get_baudrate_from_nvm(void)
+{
+    return unused(__func__);
+}
+
+uint8_t service_nvm_get_cli_ver_from_nvm(uint8_t *buff, uint32_t len)
+{
+    return unused(__func__);
+}
+
+uint8_t service_nvm_get_firmware_ver_from_nvm(uint8_t *buff, uint32_t len)
+{
+    return unused(__func__);
+}
+
+uint8_t service_nvm_get_hwmodel_from_nvm(uint8_t *buff, uint32_t len)
+{
+    return unused(__func__);
+}
+
+int32_t service_nvm_get_sn_from_nvm(uint8_t *buff, uint32_t len)
+{
+    return unused(__func__);
+}
+
+int32_t service_nvm_set_atcmd_alias_to_nvm(uint8_t *buff, uint32_t len)
+{
+    return unused(__func__);
+}
+
+int32_t service_nvm_set_baudrate_to_nvm(uint32_t baudrate)
+{
+    return unused(__func__);
+}
+
+int32_t service_nvm_set_cfg_to_nvm(void)
+{
+    return unused(__func__);
+}
+
+int32_t service_nvm_set_cli_ver_to_nvm(uint8_t *buff, uint32_t len)
+{
+    return unused(__func__);
+}
+
+int32_t service_nvm_set_firmware_ver_to_nvm(uint8_t *buff, uint32_t len)
+{
+    return unused(__func__);
+}
+
+int32_t service_nvm_set_hwmodel_to_nvm(uint8_t *buff, uint32_t len)
+{
+    return unused(__func__);
+}
+
+int32_t service_nvm_set_mode_type_to_nvm(SERIAL_PORT port, SERVICE_MODE_TYPE mode_type)
+{
+    return unused(__func__);
+}
+
+void udrv_enter_dfu(void)
+{
+    unused(__func__);
+}
+
+void udrv_serial_init(SERIAL_PORT Port, uint32_t BaudRate, SERIAL_WORD_LEN_E DataBits, SERIAL_STOP_BIT_E StopBits, SERIAL_PARITY_E Parity, SERIAL_WIRE_MODE_E WireMode)
+{
+    unused(__func__);
+}
+
+int32_t udrv_sleep_ms(uint32_t ms_time)
+{
+    return unused(__func__);
+}
+
+void udrv_system_reboot(void)
+{
+    unused(__func__);
+}
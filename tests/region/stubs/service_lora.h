@@ -0,0 +1,11 @@
+/* Host stand-in for service/lora/service_lora.h, only the listen-before-talk settings the regions read */
+#ifndef __SERVICE_LORA_H__
+#define __SERVICE_LORA_H__
+
+#include <stdint.h>
+
+int32_t service_lora_get_lbt(void);
+int16_t service_lora_get_lbt_rssi(void);
+uint32_t service_lora_get_lbt_scantime(void);
+
+#endif
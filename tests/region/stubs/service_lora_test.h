@@ -0,0 +1,7 @@
+/* Host stand-in for service/lora/service_lora_test.h, with the debug output off */
+#ifndef __SERVICE_LORA_TEST_H__
+#define __SERVICE_LORA_TEST_H__
+
+#define LORA_TEST_DEBUG(fmt, args...)
+
+#endif
@@ -0,0 +1,355 @@
+/*
+ * Channel selection of every region that picks from the common enabled
+ * channel list, against the scan of every mask bit it did before.
+ *
+ * Each region gets its default channels, extra channels where it takes them
+ * and a sparse mask where it has sub-bands, then picks channels for join
+ * requests and uplinks at random datarates with the duty cycle enforced on
+ * a virtual clock. RegionCommonIdentifyChannels() is wrapped at link time so
+ * every call is repeated with the previous scan on the same mask, channels
+ * and band state, and the candidate lists have to match. Each region then
+ * runs again from the same seed with only the previous scan, and the channels
+ * it picks after the join have to be spread the same way. The comparison is
+ * against the previous picks rather than a uniform spread: randr() takes the
+ * low bits of rand1(), a power of two LCG, so the picks are not uniform with
+ * either scan. Reports the NextChannel cost with either scan.
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "Region.h"
+#include "RegionNvm.h"
+#include "radio.h"
+#include "timer.h"
+#include "utilities.h"
+#include "test.h"
+
+#define DRAWS           20000
+#define BENCH_DRAWS     200000
+#define MAX_CHANNELS    REGION_NVM_MAX_NB_CHANNELS
+
+LoRaMacStatus_t __real_RegionCommonIdentifyChannels(RegionCommonIdentifyChannelsParam_t *identifyChannelsParam,
+                                                    TimerTime_t *aggregatedTimeOff, uint8_t *enabledChannels,
+                                                    uint8_t *nbEnabledChannels, uint8_t *nbRestrictedChannels,
+                                                    TimerTime_t *nextTxDelay);
+LoRaMacStatus_t RefIdentifyChannels(RegionCommonIdentifyChannelsParam_t *identifyChannelsParam,
+                                    TimerTime_t *aggregatedTimeOff, uint8_t *enabledChannels,
+                                    uint8_t *nbEnabledChannels, uint8_t *nbRestrictedChannels,
+                                    TimerTime_t *nextTxDelay);
+void RefCountNbOfEnabledChannels(RegionCommonCountNbOfEnabledChannelsParams_t *countNbOfEnabledChannelsParams,
+                                 uint8_t *enabledChannels, uint8_t *nbEnabledChannels, uint8_t *nbRestrictedChannels);
+
+static const struct
+{
+    LoRaMacRegion_t region;
+    const char *name;
+    int8_t max_tx_dr;
+    uint16_t mask[REGION_NVM_CHANNELS_MASK_SIZE];       // sub-band mask, or none
+    int8_t join_dr[2];                                  // 125 and 500 kHz join datarates with a mask
+} regions[] = {
+    { LORAMAC_REGION_AS923, "AS923", DR_7 },
+    { LORAMAC_REGION_AU915, "AU915", DR_6, { 0xFF00, 0x0000, 0x0F00, 0x0000, 0x0002, 0x0000 }, { DR_2, DR_6 } },
+    { LORAMAC_REGION_CN470, "CN470", DR_5 },
+    { LORAMAC_REGION_CN779, "CN779", DR_7 },
+    { LORAMAC_REGION_EU433, "EU433", DR_7 },
+    { LORAMAC_REGION_EU868, "EU868", DR_7 },
+    { LORAMAC_REGION_KR920, "KR920", DR_5 },
+    { LORAMAC_REGION_IN865, "IN865", DR_7 },
+    { LORAMAC_REGION_US915, "US915", DR_4, { 0xFF00, 0x0000, 0x0000, 0x00F0, 0x0002, 0x0000 }, { DR_0, DR_4 } },
+    { LORAMAC_REGION_RU864, "RU864", DR_7 },
+};
+
+#define NB_REGIONS      (sizeof(regions) / sizeof(regions[0]))
+
+//
+// Virtual clock and radio
+//
+
+static TimerTime_t now = 1000;
+
+TimerTime_t TimerGetCurrentTime(void)
+{
+    return now;
+}
+
+TimerTime_t TimerGetElapsedTime(TimerTime_t past)
+{
+    return (past == 0) ? 0 : now - past;
+}
+
+static bool check_rf_frequency(uint32_t frequency)
+{
+    return true;
+}
+
+static uint32_t time_on_air(RadioModems_t modem, uint32_t bandwidth, uint32_t datarate, uint8_t coderate,
+                            uint16_t preambleLen, bool fixLen, uint8_t payloadLen, bool crcOn)
+{
+    // SF12 at 125 kHz is about 1.3 s for a 20 byte frame, halving per step
+    return (modem == MODEM_FSK) ? 5 : (1300 >> (12 - datarate)) + payloadLen;
+}
+
+static bool is_channel_free(uint32_t freq, uint32_t rxBandwidth, int16_t rssiThresh, uint32_t maxCarrierSenseTime)
+{
+    return true;
+}
+
+// Listen before talk off, as configured by default
+int32_t service_lora_get_lbt(void)
+{
+    return 0;
+}
+
+int16_t service_lora_get_lbt_rssi(void)
+{
+    return -80;
+}
+
+uint32_t service_lora_get_lbt_scantime(void)
+{
+    return 5;
+}
+
+const struct Radio_s Radio = {
+    .CheckRfFrequency = check_rf_frequency,
+    .TimeOnAir = time_on_air,
+    .IsChannelFree = is_channel_free,
+};
+
+//
+// Wrapped channel identification
+//
+
+enum { SCAN_CHECK, SCAN_NEW, SCAN_REF };
+
+static int scan = SCAN_CHECK;
+static uint32_t compared;
+static uint32_t restricted;                     // calls that found some band restricted
+
+LoRaMacStatus_t __wrap_RegionCommonIdentifyChannels(RegionCommonIdentifyChannelsParam_t *identifyChannelsParam,
+                                                    TimerTime_t *aggregatedTimeOff, uint8_t *enabledChannels,
+                                                    uint8_t *nbEnabledChannels, uint8_t *nbRestrictedChannels,
+                                                    TimerTime_t *nextTxDelay)
+{
+    uint8_t ref_channels[MAX_CHANNELS];
+    uint8_t nb_ref, nb_ref_restricted;
+    LoRaMacStatus_t status;
+
+    if (scan == SCAN_REF)
+        return RefIdentifyChannels(identifyChannelsParam, aggregatedTimeOff, enabledChannels, nbEnabledChannels,
+                                   nbRestrictedChannels, nextTxDelay);
+
+    status = __real_RegionCommonIdentifyChannels(identifyChannelsParam, aggregatedTimeOff, enabledChannels,
+                                                 nbEnabledChannels, nbRestrictedChannels, nextTxDelay);
+    if (scan == SCAN_NEW)
+        return status;
+
+    // The test never sets an aggregated time-off, so the list is always built
+    RefCountNbOfEnabledChannels(identifyChannelsParam->CountNbOfEnabledChannelsParam, ref_channels, &nb_ref,
+                                &nb_ref_restricted);
+    CHECK(*nbEnabledChannels == nb_ref && *nbRestrictedChannels == nb_ref_restricted,
+          "%u enabled, %u restricted channels, previously %u, %u", *nbEnabledChannels, *nbRestrictedChannels, nb_ref,
+          nb_ref_restricted);
+    CHECK(memcmp(enabledChannels, ref_channels, nb_ref) == 0, "enabled channels differ");
+    compared++;
+    if (nb_ref_restricted != 0)
+        restricted++;
+    return status;
+}
+
+//
+// Regions
+//
+
+static RegionNvmDataGroup1_t group1;
+static RegionNvmDataGroup2_t group2;
+static Band_t bands[REGION_NVM_MAX_NB_BANDS];
+static bool joined;
+static int8_t min_tx_dr;
+
+static void region_init(int r)
+{
+    InitDefaultsParams_t init = { .NvmGroup1 = &group1, .NvmGroup2 = &group2, .Bands = bands };
+    GetPhyParams_t get = { .Attribute = PHY_MIN_TX_DR };
+    LoRaMacRegion_t region = regions[r].region;
+
+    memset(&group1, 0, sizeof(group1));
+    memset(&group2, 0, sizeof(group2));
+    memset(bands, 0, sizeof(bands));
+    init.Type = INIT_TYPE_DEFAULTS;
+    RegionInitDefaults(region, &init);
+    init.Type = INIT_TYPE_RESET_TO_DEFAULT_CHANNELS;
+    RegionInitDefaults(region, &init);
+    min_tx_dr = RegionGetPhyParam(region, &get).Value;
+    joined = false;
+    now = 1000;
+}
+
+// Join done: extra channels above the default ones, or a sparse sub-band mask
+static void region_join(int r)
+{
+    LoRaMacRegion_t region = regions[r].region;
+    uint8_t defaults = 0;
+
+    joined = true;
+    if (regions[r].mask[0] != 0)
+    {
+        ChanMaskSetParams_t set = { .ChannelsMaskIn = (uint16_t *)regions[r].mask, .ChannelsMaskType = CHANNELS_MASK };
+
+        CHECK(RegionChanMaskSet(region, &set), "%s: channel mask refused", regions[r].name);
+        return;
+    }
+
+    while (group2.Channels[defaults].Frequency != 0)
+        defaults++;
+    for (uint8_t id = defaults; id < 16; id++)
+    {
+        ChannelParams_t channel = group2.Channels[0];
+        ChannelAddParams_t add = { .NewChannel = &channel, .ChannelId = id };
+
+        channel.Frequency = group2.Channels[defaults - 1].Frequency + 200000 * (id - defaults + 1);
+        channel.Rx1Frequency = 0;
+        RegionChannelAdd(region, &add);
+    }
+}
+
+// Sub-band regions join only on their 125 and 500 kHz join datarates
+static int8_t region_dr(int r)
+{
+    if (!joined && regions[r].mask[0] != 0)
+        return regions[r].join_dr[randr(0, 1)];
+    return min_tx_dr + randr(0, regions[r].max_tx_dr - min_tx_dr);
+}
+
+static LoRaMacStatus_t region_pick(int r, uint8_t *channel)
+{
+    LoRaMacRegion_t region = regions[r].region;
+    NextChanParams_t next = {
+        .Datarate = region_dr(r),
+        .Joined = joined,
+        .DutyCycleEnabled = true,
+        .ElapsedTimeSinceStartUp = { .Seconds = now / 1000, .SubSeconds = now % 1000 },
+        .LastTxIsJoinRequest = !joined,
+        .PktLen = 20,
+    };
+    TimerTime_t delay = 0, aggregated = 0;
+    LoRaMacStatus_t status;
+
+    status = RegionNextChannel(region, &next, channel, &delay, &aggregated);
+    if (status == LORAMAC_STATUS_OK)
+    {
+        SetBandTxDoneParams_t done = {
+            .Channel = *channel,
+            .Joined = joined,
+            .LastTxDoneTime = now,
+            .LastTxAirTime = 100,
+            .ElapsedTimeSinceStartUp = next.ElapsedTimeSinceStartUp,
+        };
+
+        RegionSetBandTxDone(region, &done);
+        now += 20 + rand() % 200;
+    }
+    else
+    {
+        // Wait out the band time-off like the MAC would
+        now += (delay != 0) ? delay : 1000;
+    }
+    return status;
+}
+
+// Channels picked after the join with the given scan, from the same seed
+static uint32_t region_run(int r, int with, uint32_t *picked)
+{
+    uint32_t draws = 0;
+    uint8_t channel;
+
+    srand1(34 + r);
+    srand(34 + r);
+    scan = with;
+    region_init(r);
+    for (int i = 0; i < 200; i++)
+        region_pick(r, &channel);
+    region_join(r);
+
+    memset(picked, 0, MAX_CHANNELS * sizeof(picked[0]));
+    for (int i = 0; i < DRAWS; i++)
+    {
+        if (region_pick(r, &channel) == LORAMAC_STATUS_OK)
+        {
+            picked[channel]++;
+            draws++;
+        }
+    }
+    scan = SCAN_CHECK;
+    return draws;
+}
+
+static void test_region(int r, uint32_t *nb_channels)
+{
+    uint32_t picked[MAX_CHANNELS], ref_picked[MAX_CHANNELS];
+    uint32_t draws;
+
+    compared = 0;
+    draws = region_run(r, SCAN_CHECK, picked);
+    CHECK(draws > DRAWS / 4 && compared >= DRAWS, "%s: %u of %u picks succeeded, %u lists compared",
+          regions[r].name, draws, DRAWS, compared);
+    CHECK(region_run(r, SCAN_REF, ref_picked) == draws, "%s: previous scan succeeded a different number of times",
+          regions[r].name);
+
+    *nb_channels = 0;
+    for (int c = 0; c < MAX_CHANNELS; c++)
+    {
+        CHECK(picked[c] == ref_picked[c], "%s: channel %d picked %u times, previously %u", regions[r].name, c,
+              picked[c], ref_picked[c]);
+        if (picked[c] != 0)
+            (*nb_channels)++;
+    }
+}
+
+static double now_ns(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+// ns per joined NextChannel call with the given scan
+static double bench_region(int r, int with)
+{
+    uint8_t channel;
+    double start;
+
+    srand1(34);
+    region_init(r);
+    region_join(r);
+    scan = with;
+    start = now_ns();
+    for (int i = 0; i < BENCH_DRAWS; i++)
+        region_pick(r, &channel);
+    scan = SCAN_CHECK;
+    return (now_ns() - start) / BENCH_DRAWS;
+}
+
+int main(void)
+{
+    uint32_t nb_channels[NB_REGIONS];
+    uint32_t restricted_calls = 0;
+
+    for (int r = 0; r < NB_REGIONS; r++)
+    {
+        test_region(r, &nb_channels[r]);
+        restricted_calls += restricted;
+        restricted = 0;
+    }
+    CHECK(restricted_calls != 0, "duty cycle never restricted a band");
+
+    printf("region: NextChannel ns with the enabled bit scan/every bit, channels used:");
+    for (int r = 0; r < NB_REGIONS; r++)
+        printf(" %s %.0f/%.0f %u", regions[r].name, bench_region(r, SCAN_NEW), bench_region(r, SCAN_REF),
+               nb_channels[r]);
+    printf("\n");
+
+    TEST_DONE("region");
+}
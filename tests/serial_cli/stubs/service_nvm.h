@@ -0,0 +1,17 @@
+/* Host stand-in for service/nvm/service_nvm.h, only what udrv_serial.c uses */
+#ifndef __SERVICE_NVM_H__
+#define __SERVICE_NVM_H__
+
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include "udrv_serial.h"
+#include "service_mode.h"
+
+SERVICE_MODE_TYPE service_nvm_get_mode_type_from_nvm(SERIAL_PORT port);
+SERIAL_WLOCK_STATE service_nvm_get_lock_status_from_nvm(SERIAL_PORT Port);
+int32_t service_nvm_set_lock_status_to_nvm(SERIAL_PORT Port, SERIAL_WLOCK_STATE wlock_state);
+int32_t service_nvm_get_serial_passwd_from_nvm(uint8_t *passwd, uint32_t len);
+int32_t service_nvm_set_serial_passwd_to_nvm(uint8_t *passwd, uint32_t len);
+
+#endif
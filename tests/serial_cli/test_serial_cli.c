@@ -0,0 +1,179 @@
+/*
+ * CLI output accumulator in udrv_serial.c: output of a held port is sent with
+ * one driver write on flush, overflow drains in order, large writes bypass it
+ * and other writers on the port never overtake pending CLI output.
+ */
+#include <stdint.h>
+#include <string.h>
+#include "udrv_serial.h"
+#include "udrv_errno.h"
+#include "udrv_system.h"
+#include "uhal_uart.h"
+#include "service_nvm.h"
+#include "test.h"
+
+#define PORT    SERIAL_UART0
+
+static uint8_t out[8192];
+static uint32_t out_len;
+static int writes;
+static int32_t write_max;
+
+void uhal_uart_register_cli_handler(SERIAL_CLI_HANDLER handler) {}
+void uhal_uart_register_onewire_handler(SERIAL_CLI_HANDLER handler) {}
+void uhal_uart_init(SERIAL_PORT Port, uint32_t BaudRate, SERIAL_WORD_LEN_E DataBits, SERIAL_STOP_BIT_E StopBits, SERIAL_PARITY_E Parity, SERIAL_WIRE_MODE_E WireMode) {}
+void uhal_uart_deinit(SERIAL_PORT Port) {}
+int32_t uhal_uart_read(SERIAL_PORT Port, uint8_t *Buffer, int32_t NumberOfBytes, uint32_t Timeout) { return 0; }
+int32_t uhal_uart_peek(SERIAL_PORT Port) { return -1; }
+void uhal_uart_flush(SERIAL_PORT Port, uint32_t Timeout) {}
+int32_t uhal_uart_read_available(SERIAL_PORT Port) { return 0; }
+void uhal_uart_suspend(void) {}
+void uhal_uart_resume(void) {}
+void udrv_enter_dfu(void) {}
+int32_t udrv_system_event_produce(udrv_system_event_t *event) { return 0; }
+void udrv_system_critical_section_begin(uint32_t *mask) {}
+void udrv_system_critical_section_end(uint32_t *mask) {}
+
+int32_t uhal_uart_write(SERIAL_PORT Port, uint8_t const *Buffer, int32_t NumberOfBytes, uint32_t Timeout)
+{
+    memcpy(out + out_len, Buffer, NumberOfBytes);
+    out_len += NumberOfBytes;
+    writes++;
+    if (NumberOfBytes > write_max)
+        write_max = NumberOfBytes;
+    return NumberOfBytes;
+}
+
+SERVICE_MODE_TYPE service_nvm_get_mode_type_from_nvm(SERIAL_PORT port)
+{
+    return SERVICE_MODE_TYPE_CLI;
+}
+
+SERIAL_WLOCK_STATE service_nvm_get_lock_status_from_nvm(SERIAL_PORT Port)
+{
+    return SERIAL_WLOCK_OPEN;
+}
+
+int32_t service_nvm_set_lock_status_to_nvm(SERIAL_PORT Port, SERIAL_WLOCK_STATE wlock_state)
+{
+    return UDRV_RETURN_OK;
+}
+
+int32_t service_nvm_get_serial_passwd_from_nvm(uint8_t *passwd, uint32_t len)
+{
+    memset(passwd, 0, len);
+    return UDRV_RETURN_OK;
+}
+
+int32_t service_nvm_set_serial_passwd_to_nvm(uint8_t *passwd, uint32_t len)
+{
+    return UDRV_RETURN_OK;
+}
+
+static void reset(void)
+{
+    out_len = 0;
+    writes = 0;
+    write_max = 0;
+}
+
+static void cli_puts(const char *s)
+{
+    udrv_serial_cli_write(PORT, (uint8_t const *)s, strlen(s));
+}
+
+static void test_unheld(void)
+{
+    reset();
+    cli_puts("AT");
+    cli_puts("\r\n");
+    CHECK(writes == 2 && out_len == 4 && memcmp(out, "AT\r\n", 4) == 0, "unheld writes");
+}
+
+static void test_held(void)
+{
+    reset();
+    udrv_serial_cli_hold(PORT);
+    cli_puts("A");
+    cli_puts("T");
+    cli_puts("+VER=?\r\n");
+    udrv_serial_log_printf("%s:%d\r\n", "ver", 4);
+    cli_puts("OK\r\n");
+    CHECK(writes == 0, "held output written early");
+    udrv_serial_cli_flush(PORT);
+    CHECK(writes == 1 && out_len == 21 && memcmp(out, "AT+VER=?\r\nver:4\r\nOK\r\n", 21) == 0, "held output not in one write");
+
+    //Flush with nothing pending writes nothing
+    reset();
+    udrv_serial_cli_flush(PORT);
+    CHECK(writes == 0, "empty flush wrote");
+}
+
+static void test_overflow(void)
+{
+    uint8_t expect[3000];
+    uint32_t n = 0;
+
+    reset();
+    udrv_serial_cli_hold(PORT);
+    for (int i = 0; n + 13 <= sizeof(expect); i++)
+    {
+        uint8_t line[13];
+
+        memset(line, 'a' + i % 26, sizeof(line));
+        udrv_serial_cli_write(PORT, line, sizeof(line));
+        memcpy(expect + n, line, sizeof(line));
+        n += sizeof(line);
+    }
+    udrv_serial_cli_flush(PORT);
+    CHECK(out_len == n && memcmp(out, expect, n) == 0, "overflow reordered output");
+    CHECK(write_max <= SERIAL_CLI_OUT_SIZE && writes <= (int)(n / (SERIAL_CLI_OUT_SIZE - 12)) + 1, "%d writes for %u bytes", writes, n);
+}
+
+static void test_large(void)
+{
+    uint8_t big[SERIAL_CLI_OUT_SIZE + 100];
+
+    memset(big, 'x', sizeof(big));
+    reset();
+    udrv_serial_cli_hold(PORT);
+    cli_puts("head");
+    udrv_serial_cli_write(PORT, big, sizeof(big));
+    CHECK(out_len == 4 + sizeof(big) && memcmp(out, "head", 4) == 0 && out[4] == 'x', "large write overtook pending output");
+    cli_puts("tail");
+    udrv_serial_cli_flush(PORT);
+    CHECK(out_len == 8 + sizeof(big) && memcmp(out + out_len - 4, "tail", 4) == 0, "output after large write");
+}
+
+static void test_other_writers(void)
+{
+    reset();
+    udrv_serial_cli_hold(PORT);
+    cli_puts("echo");
+    udrv_serial_write(PORT, (uint8_t const *)"raw", 3);
+    udrv_serial_printf(PORT, "%s", "fmt");
+    CHECK(out_len == 10 && memcmp(out, "echorawfmt", 10) == 0, "direct write overtook CLI output");
+    cli_puts("end");
+    udrv_serial_cli_flush(PORT);
+    CHECK(out_len == 13 && memcmp(out + 10, "end", 3) == 0, "CLI output after direct write");
+}
+
+static void test_args(void)
+{
+    CHECK(udrv_serial_cli_write(SERIAL_MAX, (uint8_t const *)"x", 1) == -UDRV_WRONG_ARG, "bad port accepted");
+    CHECK(udrv_serial_cli_write(PORT, NULL, 1) == -UDRV_WRONG_ARG, "NULL buffer accepted");
+    CHECK(udrv_serial_cli_flush(SERIAL_MAX) == -UDRV_WRONG_ARG, "bad port flushed");
+}
+
+int main(void)
+{
+    udrv_serial_init(PORT, 115200, SERIAL_WORD_LEN_8, SERIAL_STOP_BIT_1, SERIAL_PARITY_DISABLE, SERIAL_TWO_WIRE_NORMAL_MODE);
+
+    test_unheld();
+    test_held();
+    test_overflow();
+    test_large();
+    test_other_writers();
+    test_args();
+    TEST_DONE("serial_cli");
+}
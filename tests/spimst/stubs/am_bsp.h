@@ -0,0 +1,7 @@
+/* Host stand-in for the board support package, see am_bsp_pins.h. */
+#ifndef _AM_BSP_H_
+#define _AM_BSP_H_
+
+#include "am_bsp_pins.h"
+
+#endif  // #ifndef _AM_BSP_H_
@@ -0,0 +1,21 @@
+/* Host stand-in for the board pin definitions of the IOM SPI pads. */
+#ifndef _AM_BSP_PINS_H_
+#define _AM_BSP_PINS_H_
+
+#include "am_mcu_apollo.h"
+
+#define AM_BSP_GPIO_IOM0_SCK        5
+#define AM_BSP_GPIO_IOM0_MISO       6
+#define AM_BSP_GPIO_IOM0_MOSI       7
+#define AM_BSP_GPIO_IOM1_SCK        8
+#define AM_BSP_GPIO_IOM1_MISO       9
+#define AM_BSP_GPIO_IOM1_MOSI       10
+
+extern const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_IOM0_SCK;
+extern const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_IOM0_MISO;
+extern const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_IOM0_MOSI;
+extern const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_IOM1_SCK;
+extern const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_IOM1_MISO;
+extern const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_IOM1_MOSI;
+
+#endif  // #ifndef _AM_BSP_PINS_H_
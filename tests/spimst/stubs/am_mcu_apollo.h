@@ -0,0 +1,102 @@
+/* Host stand-in for the Apollo3 HAL, just what uhal_spimst.c uses. The IOM
+ * functions are implemented by the test on a simulated bus. */
+#ifndef _AM_MCU_APOLLO_H_
+#define _AM_MCU_APOLLO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define AM_HAL_STATUS_SUCCESS           0
+#define AM_HAL_STATUS_FAIL              1
+
+#define AM_HAL_SYSCTRL_WAKE             0
+#define AM_HAL_SYSCTRL_DEEPSLEEP        2
+
+#define AM_HAL_IOM_MAX_TXNSIZE_SPI      4095
+
+#define AM_HAL_IOM_125KHZ               125000
+#define AM_HAL_IOM_250KHZ               250000
+#define AM_HAL_IOM_500KHZ               500000
+#define AM_HAL_IOM_1MHZ                 1000000
+#define AM_HAL_IOM_2MHZ                 2000000
+#define AM_HAL_IOM_4MHZ                 4000000
+#define AM_HAL_IOM_8MHZ                 8000000
+
+typedef enum { AM_HAL_IOM_SPI_MODE, AM_HAL_IOM_I2C_MODE } am_hal_iom_mode_e;
+typedef enum { AM_HAL_IOM_SPI_MODE_0, AM_HAL_IOM_SPI_MODE_1, AM_HAL_IOM_SPI_MODE_2, AM_HAL_IOM_SPI_MODE_3 } am_hal_iom_spi_mode_e;
+typedef enum { AM_HAL_IOM_TX, AM_HAL_IOM_RX, AM_HAL_IOM_FULLDUPLEX } am_hal_iom_dir_e;
+typedef enum { AM_HAL_IOM_REQ_SPI_LSB = 4 } am_hal_iom_request_e;
+
+typedef struct
+{
+    am_hal_iom_mode_e       eInterfaceMode;
+    uint32_t                ui32ClockFreq;
+    am_hal_iom_spi_mode_e   eSpiMode;
+    uint32_t                *pNBTxnBuf;
+    uint32_t                ui32NBTxnBufLength;
+} am_hal_iom_config_t;
+
+typedef struct
+{
+    union
+    {
+        uint32_t ui32SpiChipSelect;
+        uint32_t ui32I2CDevAddr;
+    } uPeerInfo;
+    uint32_t                ui32InstrLen;
+    uint32_t                ui32Instr;
+    uint32_t                ui32NumBytes;
+    am_hal_iom_dir_e        eDirection;
+    uint32_t                *pui32TxBuffer;
+    uint32_t                *pui32RxBuffer;
+    bool                    bContinue;
+} am_hal_iom_transfer_t;
+
+typedef void (*am_hal_iom_callback_t)(void *pCallbackCtxt, uint32_t transactionStatus);
+
+typedef struct
+{
+    uint32_t uFuncSel;
+} am_hal_gpio_pincfg_t;
+
+typedef enum { IOMSTR0_IRQn = 6, IOMSTR1_IRQn = 7 } IRQn_Type;
+
+#define NVIC_configMAX_SYSCALL_INTERRUPT_PRIORITY 4
+
+typedef struct
+{
+    volatile uint32_t ICSR;
+} SCB_Type;
+
+#define SCB_ICSR_VECTACTIVE_Msk         0x1FFu
+
+extern SCB_Type sim_scb;
+#define SCB (&sim_scb)
+
+extern const am_hal_gpio_pincfg_t g_AM_HAL_GPIO_DISABLE;
+
+uint32_t am_hal_gpio_pinconfig(uint32_t pin, am_hal_gpio_pincfg_t cfg);
+
+uint32_t am_hal_iom_initialize(uint32_t module, void **handle);
+uint32_t am_hal_iom_uninitialize(void *handle);
+uint32_t am_hal_iom_power_ctrl(void *handle, uint32_t state, bool retain);
+uint32_t am_hal_iom_configure(void *handle, am_hal_iom_config_t *config);
+uint32_t am_hal_iom_control(void *handle, am_hal_iom_request_e request, void *args);
+uint32_t am_hal_iom_enable(void *handle);
+uint32_t am_hal_iom_disable(void *handle);
+uint32_t am_hal_iom_interrupt_enable(void *handle, uint32_t mask);
+uint32_t am_hal_iom_interrupt_status_get(void *handle, bool enabled_only, uint32_t *status);
+uint32_t am_hal_iom_interrupt_clear(void *handle, uint32_t mask);
+uint32_t am_hal_iom_interrupt_service(void *handle, uint32_t status);
+uint32_t am_hal_iom_nonblocking_transfer(void *handle, am_hal_iom_transfer_t *transaction,
+                                         am_hal_iom_callback_t callback, void *context);
+uint32_t am_hal_iom_blocking_transfer(void *handle, am_hal_iom_transfer_t *transaction);
+uint32_t am_hal_iom_spi_blocking_fullduplex(void *handle, am_hal_iom_transfer_t *transaction);
+
+uint32_t am_hal_interrupt_master_disable(void);
+void am_hal_interrupt_master_set(uint32_t state);
+
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority);
+
+#endif  // #ifndef _AM_MCU_APOLLO_H_
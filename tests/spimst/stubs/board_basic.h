@@ -0,0 +1,5 @@
+/* Host stand-in for the board definitions, the SPI ports come from -D flags as in boards.txt. */
+#ifndef _BOARD_BASIC_H_
+#define _BOARD_BASIC_H_
+
+#endif
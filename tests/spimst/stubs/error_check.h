@@ -0,0 +1,19 @@
+/* Host stand-in for the error check macro, failures go to the test's assert_callback(). */
+#ifndef ERROR_CHECK_H_
+#define ERROR_CHECK_H_
+
+#include <stdint.h>
+
+void assert_callback(uint16_t line_num, const uint8_t *file_name, uint32_t err_code);
+
+#define ERROR_CHECK(ERR_CODE)                               \
+    do                                                      \
+    {                                                       \
+        const uint32_t LOCAL_ERR_CODE = (ERR_CODE);         \
+        if (LOCAL_ERR_CODE != 0)                            \
+        {                                                   \
+            assert_callback(__LINE__, (uint8_t*) __FILE__, LOCAL_ERR_CODE); \
+        }                                                   \
+    } while (0)
+
+#endif  // #ifndef ERROR_CHECK_H_
@@ -0,0 +1,20 @@
+/* Host stand-in for the FreeRTOS semaphores, see FreeRTOS.h. */
+#ifndef SEMAPHORE_H
+#define SEMAPHORE_H
+
+#include "FreeRTOS.h"
+
+typedef struct sim_sem *SemaphoreHandle_t;
+
+SemaphoreHandle_t sim_sem_create(int count);
+BaseType_t sim_sem_take(SemaphoreHandle_t sem, TickType_t wait);
+BaseType_t sim_sem_give(SemaphoreHandle_t sem);
+
+#define xSemaphoreCreateMutex()             sim_sem_create(1)
+#define xSemaphoreCreateBinary()            sim_sem_create(0)
+#define xSemaphoreTake(s, t)                sim_sem_take((s), (t))
+#define xSemaphoreGive(s)                   sim_sem_give(s)
+#define xSemaphoreTakeFromISR(s, w)         sim_sem_take((s), 0)
+#define xSemaphoreGiveFromISR(s, w)         sim_sem_give(s)
+
+#endif
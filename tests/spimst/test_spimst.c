@@ -0,0 +1,669 @@
+/*
+ * SPI master transaction queue in uhal_spimst.c on a mock IOM: a queued
+ * transaction completes after its bytes were clocked out at the configured
+ * rate and is reported through the IOM interrupt, the blocking HAL calls take
+ * the bus right away. Chip selects are GPIOs recorded with the transfers.
+ * Checks that random descriptor lists from several submitters reach the bus in
+ * submission order with the right chip select framing, that a failed
+ * transaction ends its list only, how the blocking calls share the bus with
+ * the queue, that the idle task is kept out of deep sleep while a transfer
+ * is in flight, and reports the CPU time taken by long and short transfers.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "uhal_spimst.h"
+#include "uhal_gpio.h"
+#include "udrv_powersave.h"
+#include "semphr.h"
+#include "test.h"
+
+#define PORT            UDRV_SPIMST_0
+#define CLOCK_HZ        8000000
+#define TXN_SETUP_NS    2000            // IOM command queue and DMA start per transaction
+#define ISR_COST_NS     10000           // IOM interrupt: HAL service, callback, next transaction
+#define CS_PINS         3
+#define CS_FIRST        20
+#define TRACE_MAX       20000
+#define JOB_DESCS       4
+#define POOL_SIZE       (1 << 20)
+
+void am_iomaster0_isr(void);
+void am_iomaster1_isr(void);
+
+SCB_Type sim_scb;
+const am_hal_gpio_pincfg_t g_AM_HAL_GPIO_DISABLE;
+const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_IOM0_SCK, g_AM_BSP_GPIO_IOM0_MISO, g_AM_BSP_GPIO_IOM0_MOSI;
+const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_IOM1_SCK, g_AM_BSP_GPIO_IOM1_MISO, g_AM_BSP_GPIO_IOM1_MOSI;
+
+typedef enum { EV_CS_LOW, EV_CS_HIGH, EV_TX, EV_RX, EV_DUPLEX } ev_type_t;
+
+typedef struct
+{
+    ev_type_t type;
+    uint32_t pin;
+    uint8_t *p;
+    uint32_t len;
+} ev_t;
+
+typedef struct
+{
+    ev_t ev[TRACE_MAX];
+    int n;
+} trace_t;
+
+typedef struct
+{
+    bool powered;
+    bool enabled;
+    uint32_t clock;
+    bool inflight;
+    bool irq;
+    am_hal_iom_transfer_t t;
+    am_hal_iom_callback_t cb;
+    void *ctx;
+    uint64_t done_at;
+    int fail_in;                // the nth next queued transaction completes with an error
+    bool refuse;                // the next queued transaction is refused
+} iom_t;
+
+static iom_t iom[2];
+static trace_t bus;
+static uint8_t pin_logic[64];
+static uint64_t now_ns;
+static uint32_t interrupts;
+static uint32_t queued_txns;
+static uint32_t hal_errors;
+
+struct sim_sem
+{
+    int count;
+};
+
+// FreeRTOS
+
+SemaphoreHandle_t sim_sem_create(int count)
+{
+    SemaphoreHandle_t sem = calloc(1, sizeof(*sem));
+
+    sem->count = count;
+    return sem;
+}
+
+static bool sim_step(void);
+
+// A task blocks: the bus runs until the semaphore is given.
+BaseType_t sim_sem_take(SemaphoreHandle_t sem, TickType_t wait)
+{
+    while (sem->count == 0)
+    {
+        if (wait == 0 || !sim_step())
+        {
+            CHECK(wait == 0, "task blocked with nothing left to wake it");
+            return pdFAIL;
+        }
+    }
+    sem->count--;
+    return pdPASS;
+}
+
+BaseType_t sim_sem_give(SemaphoreHandle_t sem)
+{
+    sem->count = 1;
+    return pdPASS;
+}
+
+void assert_callback(uint16_t line_num, const uint8_t *file_name, uint32_t err_code)
+{
+    hal_errors++;
+}
+
+// Power
+
+static uint32_t spi_latency = UDRV_PS_LATENCY_ANY;
+
+void udrv_powersave_set_latency(UDRV_PS_LATENCY who, uint32_t max_us)
+{
+    CHECK(who == UDRV_PS_LATENCY_SPI, "latency bound %d set by the SPI driver", who);
+    spi_latency = max_us;
+}
+
+// Chip selects
+
+void uhal_gpio_set_dir(uint32_t pin, gpio_dir_t dir)
+{
+}
+
+gpio_logic_t uhal_gpio_get_logic(uint32_t pin)
+{
+    return pin_logic[pin] ? GPIO_LOGIC_HIGH : GPIO_LOGIC_LOW;
+}
+
+static void trace_add(trace_t *tr, ev_type_t type, uint32_t pin, uint8_t *p, uint32_t len)
+{
+    ev_t *last = &tr->ev[(tr->n > 0) ? tr->n - 1 : 0];
+
+    // Transactions split by the driver show up as one.
+    if (tr->n > 0 && (type == EV_TX || type == EV_RX) && last->type == type && last->pin == pin &&
+        last->p + last->len == p)
+    {
+        last->len += len;
+        return;
+    }
+    CHECK(tr->n < TRACE_MAX, "trace full");
+    if (tr->n < TRACE_MAX)
+        tr->ev[tr->n++] = (ev_t){type, pin, p, len};
+}
+
+void uhal_gpio_set_logic(uint32_t pin, gpio_logic_t logic)
+{
+    if (pin_logic[pin] != (logic == GPIO_LOGIC_HIGH))
+        trace_add(&bus, logic == GPIO_LOGIC_HIGH ? EV_CS_HIGH : EV_CS_LOW, pin, NULL, 0);
+    pin_logic[pin] = (logic == GPIO_LOGIC_HIGH);
+}
+
+// The one chip select low during a transfer.
+static uint32_t selected(void)
+{
+    uint32_t pin = 0;
+    int low = 0;
+
+    for (uint32_t i = CS_FIRST; i < CS_FIRST + CS_PINS; i++)
+    {
+        if (!pin_logic[i])
+        {
+            pin = i;
+            low++;
+        }
+    }
+    CHECK(low == 1, "%d chip selects low during a transfer", low);
+    return pin;
+}
+
+// Mock IOM
+
+static iom_t *iom_of(void *handle)
+{
+    return (iom_t *)handle;
+}
+
+static uint64_t bus_ns(uint32_t bytes, uint32_t clock)
+{
+    return (uint64_t)bytes * 8 * 1000000000 / clock;
+}
+
+// What the peripheral answers: a running count per chip select.
+static uint8_t counter[64];
+
+static void device_read(uint32_t pin, uint8_t *p, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++)
+        p[i] = counter[pin]++;
+}
+
+static void bus_transfer(am_hal_iom_transfer_t *t)
+{
+    uint32_t pin = selected();
+
+    CHECK(t->ui32NumBytes <= AM_HAL_IOM_MAX_TXNSIZE_SPI, "transaction of %u bytes", t->ui32NumBytes);
+    if (t->eDirection == AM_HAL_IOM_TX)
+        trace_add(&bus, EV_TX, pin, (uint8_t *)t->pui32TxBuffer, t->ui32NumBytes);
+    else if (t->eDirection == AM_HAL_IOM_RX)
+    {
+        device_read(pin, (uint8_t *)t->pui32RxBuffer, t->ui32NumBytes);
+        trace_add(&bus, EV_RX, pin, (uint8_t *)t->pui32RxBuffer, t->ui32NumBytes);
+    }
+    else
+    {
+        device_read(pin, (uint8_t *)t->pui32RxBuffer, t->ui32NumBytes);
+        trace_add(&bus, EV_DUPLEX, pin, (uint8_t *)t->pui32TxBuffer, t->ui32NumBytes);
+    }
+}
+
+uint32_t am_hal_gpio_pinconfig(uint32_t pin, am_hal_gpio_pincfg_t cfg)
+{
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_initialize(uint32_t module, void **handle)
+{
+    *handle = &iom[module];
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_uninitialize(void *handle)
+{
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_power_ctrl(void *handle, uint32_t state, bool retain)
+{
+    iom_of(handle)->powered = (state == AM_HAL_SYSCTRL_WAKE);
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_configure(void *handle, am_hal_iom_config_t *config)
+{
+    iom_of(handle)->clock = config->ui32ClockFreq;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_control(void *handle, am_hal_iom_request_e request, void *args)
+{
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_enable(void *handle)
+{
+    iom_of(handle)->enabled = true;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_disable(void *handle)
+{
+    CHECK(!iom_of(handle)->inflight, "IOM disabled with a transaction in flight");
+    iom_of(handle)->enabled = false;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_interrupt_enable(void *handle, uint32_t mask)
+{
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_interrupt_status_get(void *handle, bool enabled_only, uint32_t *status)
+{
+    *status = iom_of(handle)->irq ? 1 : 0;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_interrupt_clear(void *handle, uint32_t mask)
+{
+    iom_of(handle)->irq = false;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_interrupt_service(void *handle, uint32_t status)
+{
+    iom_t *m = iom_of(handle);
+    uint32_t result = AM_HAL_STATUS_SUCCESS;
+
+    if (m->fail_in > 0 && --m->fail_in == 0)
+        result = AM_HAL_STATUS_FAIL;
+    else
+        bus_transfer(&m->t);
+    m->cb(m->ctx, result);
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_nonblocking_transfer(void *handle, am_hal_iom_transfer_t *transaction,
+                                         am_hal_iom_callback_t callback, void *context)
+{
+    iom_t *m = iom_of(handle);
+
+    CHECK(m->enabled, "transfer on a disabled IOM");
+    CHECK(!m->inflight, "second transaction queued before the first completed");
+    if (m->refuse)
+    {
+        m->refuse = false;
+        return AM_HAL_STATUS_FAIL;
+    }
+    m->t = *transaction;
+    m->cb = callback;
+    m->ctx = context;
+    m->inflight = true;
+    m->done_at = now_ns + TXN_SETUP_NS + bus_ns(transaction->ui32NumBytes, m->clock);
+    queued_txns++;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_blocking_transfer(void *handle, am_hal_iom_transfer_t *transaction)
+{
+    iom_t *m = iom_of(handle);
+
+    CHECK(!m->inflight, "blocking transfer while the queue owns the bus");
+    bus_transfer(transaction);
+    now_ns += bus_ns(transaction->ui32NumBytes, m->clock);
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_spi_blocking_fullduplex(void *handle, am_hal_iom_transfer_t *transaction)
+{
+    return am_hal_iom_blocking_transfer(handle, transaction);
+}
+
+uint32_t am_hal_interrupt_master_disable(void)
+{
+    return 0;
+}
+
+void am_hal_interrupt_master_set(uint32_t state)
+{
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq)
+{
+}
+
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority)
+{
+}
+
+// Complete the next transaction in flight through its interrupt.
+static bool sim_step(void)
+{
+    int next = -1;
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (iom[i].inflight && (next < 0 || iom[i].done_at < iom[next].done_at))
+            next = i;
+    }
+    if (next < 0)
+        return false;
+
+    // The IOM DMA would stop in deep sleep
+    CHECK(spi_latency == 0, "transaction in flight allows deep sleep");
+
+    // The interrupt runs before the next transaction is started.
+    now_ns = iom[next].done_at + ISR_COST_NS;
+    iom[next].inflight = false;
+    iom[next].irq = true;
+    interrupts++;
+    SCB->ICSR = 16 + IOMSTR0_IRQn + next;
+    if (next == 0)
+        am_iomaster0_isr();
+    else
+        am_iomaster1_isr();
+    SCB->ICSR = 0;
+    return true;
+}
+
+static void drain(void)
+{
+    while (sim_step())
+        ;
+}
+
+// Submitters
+
+typedef struct
+{
+    udrv_spimst_xfer_t xfer[JOB_DESCS];
+    uint32_t count;
+    int32_t status;
+    int done;                   // completion order, 0 while pending
+} job_t;
+
+static int completions;
+static bool complete_in_task;   // a list that cannot start completes in submit
+
+static void on_done(udrv_spimst_port port, int32_t status, void *p_context)
+{
+    job_t *job = p_context;
+
+    CHECK(SCB->ICSR != 0 || complete_in_task, "completion outside the IOM interrupt");
+    job->status = status;
+    job->done = ++completions;
+}
+
+static uint8_t pool[POOL_SIZE];
+static uint32_t pool_used;
+
+static uint8_t *pool_take(uint32_t len)
+{
+    uint8_t *p = &pool[pool_used];
+
+    pool_used += len;
+    return p;
+}
+
+static uint32_t rand_len(void)
+{
+    switch (rand() % 8)
+    {
+        case 0: return 0;
+        case 1: return 1 + rand() % 10000;
+        default: return 1 + rand() % 64;
+    }
+}
+
+static void make_job(job_t *job)
+{
+    memset(job, 0, sizeof(*job));
+    job->count = 1 + rand() % JOB_DESCS;
+    for (uint32_t i = 0; i < job->count; i++)
+    {
+        udrv_spimst_xfer_t *x = &job->xfer[i];
+
+        // A descriptor following one that keeps CS talks to the same device.
+        x->csn = (i > 0 && (job->xfer[i - 1].flags & UDRV_SPIMST_XFER_KEEP_CS)) ?
+                 job->xfer[i - 1].csn : CS_FIRST + rand() % CS_PINS;
+        x->write_length = rand_len();
+        x->read_length = rand_len();
+        if (x->write_length + x->read_length == 0)
+            x->write_length = 1;
+        x->write_data = x->write_length ? pool_take(x->write_length) : NULL;
+        x->read_data = x->read_length ? pool_take(x->read_length) : NULL;
+        if (i + 1 < job->count && rand() % 3 == 0)
+            x->flags = UDRV_SPIMST_XFER_KEEP_CS;
+    }
+}
+
+// What the bus should show for a job that completed.
+static void expect_job(trace_t *tr, job_t *job)
+{
+    for (uint32_t i = 0; i < job->count; i++)
+    {
+        udrv_spimst_xfer_t *x = &job->xfer[i];
+
+        if (i == 0 || !(job->xfer[i - 1].flags & UDRV_SPIMST_XFER_KEEP_CS))
+            trace_add(tr, EV_CS_LOW, x->csn, NULL, 0);
+        if (x->write_length)
+            trace_add(tr, EV_TX, x->csn, x->write_data, x->write_length);
+        if (x->read_length)
+            trace_add(tr, EV_RX, x->csn, x->read_data, x->read_length);
+        if (!(x->flags & UDRV_SPIMST_XFER_KEEP_CS))
+            trace_add(tr, EV_CS_HIGH, x->csn, NULL, 0);
+    }
+}
+
+static int trace_diff(trace_t *a, trace_t *b)
+{
+    int n = (a->n < b->n) ? a->n : b->n;
+
+    for (int i = 0; i < n; i++)
+    {
+        if (memcmp(&a->ev[i], &b->ev[i], sizeof(ev_t)) != 0)
+            return i;
+    }
+    return (a->n == b->n) ? -1 : n;
+}
+
+static void reset(void)
+{
+    drain();
+    bus.n = 0;
+    pool_used = 0;
+    completions = 0;
+    interrupts = 0;
+    queued_txns = 0;
+    memset(counter, 0, sizeof(counter));
+    for (int i = 0; i < 64; i++)
+        pin_logic[i] = 1;
+}
+
+// Lists submitted while others run complete in submission order, framed by
+// their chip selects, however the submissions interleave with the bus.
+static void test_order(void)
+{
+    static job_t jobs[16];
+    static trace_t expected;
+
+    srand(29);
+    for (int round = 0; round < 300; round++)
+    {
+        int n = 0;
+
+        reset();
+        expected.n = 0;
+        while (n < 16)
+        {
+            make_job(&jobs[n]);
+            if (uhal_spimst_submit(PORT, jobs[n].xfer, jobs[n].count, on_done, &jobs[n]) != UDRV_RETURN_OK)
+            {
+                CHECK(n - completions == 7, "round %d: queue full at %d lists, depth 8 holds 7",
+                      round, n - completions);
+                break;
+            }
+            n++;
+            if (rand() % 2)
+                sim_step();
+        }
+        drain();
+        for (int i = 0; i < n; i++)
+        {
+            CHECK(jobs[i].done == i + 1 && jobs[i].status == UDRV_RETURN_OK,
+                  "round %d: list %d completed %d with %d", round, i, jobs[i].done, jobs[i].status);
+            expect_job(&expected, &jobs[i]);
+        }
+        int at = trace_diff(&bus, &expected);
+        CHECK(at < 0, "round %d: bus differs from submission order at event %d of %d", round, at, bus.n);
+        CHECK(!uhal_spimst_busy(PORT), "port busy after draining");
+        CHECK(spi_latency == UDRV_PS_LATENCY_ANY, "round %d: latency bound kept on an idle bus", round);
+    }
+}
+
+// A failed transaction aborts its own list, releases CS, and the queue goes on.
+static void test_error(void)
+{
+    job_t a, b;
+
+    reset();
+    make_job(&a);
+    a.count = 2;
+    a.xfer[0].flags = UDRV_SPIMST_XFER_KEEP_CS;
+    a.xfer[1].csn = a.xfer[0].csn;
+    make_job(&b);
+    iom[0].fail_in = 1;
+    uhal_spimst_submit(PORT, a.xfer, a.count, on_done, &a);
+    uhal_spimst_submit(PORT, b.xfer, b.count, on_done, &b);
+    drain();
+    CHECK(a.status == -UDRV_INTERNAL_ERR, "failed list reported %d", a.status);
+    CHECK(b.status == UDRV_RETURN_OK && b.done == 2, "list after a failure reported %d", b.status);
+    CHECK(pin_logic[a.xfer[0].csn], "chip select left low after a failure");
+
+    reset();
+    make_job(&a);
+    iom[0].refuse = true;
+    complete_in_task = true;
+    uhal_spimst_submit(PORT, a.xfer, a.count, on_done, &a);
+    complete_in_task = false;
+    drain();
+    CHECK(a.status == -UDRV_INTERNAL_ERR && a.done == 1, "refused transaction reported %d", a.status);
+    CHECK(pin_logic[a.xfer[0].csn], "chip select left low after a refused transaction");
+
+    CHECK(uhal_spimst_submit(PORT, NULL, 1, on_done, &a) == -UDRV_WRONG_ARG, "empty list accepted");
+    a.xfer[0].write_length = 4;
+    a.xfer[0].write_data = NULL;
+    CHECK(uhal_spimst_submit(PORT, a.xfer, 1, on_done, &a) == -UDRV_WRONG_ARG, "missing buffer accepted");
+}
+
+// The blocking calls: direct on an idle bus, after the queue otherwise.
+static void test_blocking(void)
+{
+    static uint8_t cmd[4] = {0x1D, 0x08, 0x00, 0x00}, rx[4096], big[20000];
+    static trace_t expected;
+    job_t job;
+    uint32_t before;
+
+    reset();
+    CHECK(uhal_spimst_trx(PORT, cmd, 4, NULL, 0, CS_FIRST) == 0, "write failed");
+    CHECK(uhal_spimst_trx(PORT, NULL, 0, rx, 300, CS_FIRST) == 0, "read failed");
+    CHECK(rx[0] == 0 && rx[299] == (uint8_t)299, "read data 0x%02x..0x%02x", rx[0], rx[299]);
+    before = queued_txns;
+    CHECK(uhal_spimst_trx(PORT, cmd, 4, rx, 4, CS_FIRST + 1) == 0, "full duplex failed");
+    CHECK(queued_txns == before, "full duplex on an idle bus went through the queue");
+    expected.n = 0;
+    trace_add(&expected, EV_CS_LOW, CS_FIRST, NULL, 0);
+    trace_add(&expected, EV_TX, CS_FIRST, cmd, 4);
+    trace_add(&expected, EV_CS_HIGH, CS_FIRST, NULL, 0);
+    trace_add(&expected, EV_CS_LOW, CS_FIRST, NULL, 0);
+    trace_add(&expected, EV_RX, CS_FIRST, rx, 300);
+    trace_add(&expected, EV_CS_HIGH, CS_FIRST, NULL, 0);
+    trace_add(&expected, EV_CS_LOW, CS_FIRST + 1, NULL, 0);
+    trace_add(&expected, EV_DUPLEX, CS_FIRST + 1, cmd, 4);
+    trace_add(&expected, EV_CS_HIGH, CS_FIRST + 1, NULL, 0);
+    CHECK(trace_diff(&bus, &expected) < 0, "blocking calls framed wrong");
+
+    // Full duplex behind a long queued write waits for it.
+    reset();
+    memset(&job, 0, sizeof(job));
+    job.count = 1;
+    job.xfer[0] = (udrv_spimst_xfer_t){.write_data = big, .write_length = sizeof(big), .csn = CS_FIRST + 2};
+    uhal_spimst_submit(PORT, job.xfer, 1, on_done, &job);
+    CHECK(uhal_spimst_trx(PORT, cmd, 4, rx, 4, CS_FIRST) == 0, "full duplex behind the queue failed");
+    CHECK(job.done == 1, "full duplex ran before the queued write completed");
+    CHECK(bus.n == 6 && bus.ev[4].type == EV_DUPLEX, "full duplex not after the queued write");
+
+    // From an interrupt the bus is only used when free.
+    reset();
+    uhal_spimst_submit(PORT, job.xfer, 1, on_done, &job);
+    SCB->ICSR = 16;
+    CHECK(uhal_spimst_trx(PORT, cmd, 4, NULL, 0, CS_FIRST) == -1, "ISR write on a busy bus");
+    drain();
+    SCB->ICSR = 16;
+    CHECK(uhal_spimst_trx(PORT, cmd, 4, NULL, 0, CS_FIRST) == 0, "ISR write on a free bus failed");
+    SCB->ICSR = 0;
+
+    // Sleep leaves a port with queued work powered.
+    reset();
+    uhal_spimst_submit(PORT, job.xfer, 1, on_done, &job);
+    uhal_spimst_suspend();
+    CHECK(iom[0].enabled, "port with queued work powered down");
+    drain();
+    uhal_spimst_suspend();
+    CHECK(!iom[0].enabled, "idle port left powered");
+    uhal_spimst_resume();
+    CHECK(iom[0].enabled, "port not powered up again");
+}
+
+// CPU time of one read in us: a blocking transfer holds the CPU for the whole
+// bus time, a queued one only for its interrupts.
+static void cpu_time(uint32_t length, double *blocking, double *queued, double *elapsed)
+{
+    static uint8_t buf[65536];
+    uint32_t txns = (length + AM_HAL_IOM_MAX_TXNSIZE_SPI - 1) / AM_HAL_IOM_MAX_TXNSIZE_SPI;
+    uint64_t start;
+
+    reset();
+    start = now_ns;
+    CHECK(uhal_spimst_trx(PORT, NULL, 0, buf, length, CS_FIRST) == 0, "read of %u bytes failed", length);
+    *blocking = (txns * TXN_SETUP_NS + bus_ns(length, CLOCK_HZ)) / 1000.0;
+    *queued = interrupts * ISR_COST_NS / 1000.0;
+    *elapsed = (now_ns - start) / 1000.0;
+}
+
+int main(void)
+{
+    double big_blocking, big_queued, big_elapsed, small_blocking, small_queued, small_elapsed;
+
+    uhal_spimst_setup_freq(PORT, CLOCK_HZ);
+    uhal_spimst_init(PORT);
+    CHECK(iom[0].enabled && iom[0].clock == CLOCK_HZ, "port not set up");
+
+    test_order();
+    test_error();
+    test_blocking();
+    CHECK(hal_errors == 0, "%u HAL errors", hal_errors);
+
+    cpu_time(65536, &big_blocking, &big_queued, &big_elapsed);
+    cpu_time(4, &small_blocking, &small_queued, &small_elapsed);
+    printf("spimst: CPU time at 8 MHz, %u us per interrupt: 64 kB read %.0f us blocking, %.0f us queued "
+           "(%.1f%% of %.0f us); 4-byte read %.0f us blocking, %.0f us queued\n",
+           ISR_COST_NS / 1000, big_blocking, big_queued, 100.0 * big_queued / big_elapsed, big_elapsed,
+           small_blocking, small_queued);
+
+    TEST_DONE("spimst");
+}
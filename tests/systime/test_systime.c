@@ -0,0 +1,186 @@
+/*
+ * SysTimeLocalTime()/SysTimeMkTime() against the host gmtime_r() for every
+ * day a uint32_t timestamp can reach (1970-01-01 .. 2106-02-07) and against
+ * the previous implementation in systime_ref.c up to 2095, the millisecond
+ * conversions, and a timing comparison of the three.
+ */
+#include <stdint.h>
+#include <time.h>
+#include "systime.h"
+#include "test.h"
+
+#define REF_LAST_DAY    46020           // 2095-12-31, the old DIV_365_25() overflows in 2096
+
+uint32_t RefSysTimeMkTime(const struct tm *localtime);
+void RefSysTimeLocalTime(const uint32_t timestamp, struct tm *localtime);
+
+uint32_t RtcGetCalendarTime(uint16_t *milliseconds)
+{
+    *milliseconds = 0;
+    return 0;
+}
+
+void RtcBkupWrite(uint32_t data0, uint32_t data1)
+{
+}
+
+void RtcBkupRead(uint32_t *data0, uint32_t *data1)
+{
+    *data0 = 0;
+    *data1 = 0;
+}
+
+void BoardCriticalSectionBegin(uint32_t *mask)
+{
+}
+
+void BoardCriticalSectionEnd(uint32_t *mask)
+{
+}
+
+static int tm_equal(const struct tm *a, const struct tm *b)
+{
+    return a->tm_sec == b->tm_sec && a->tm_min == b->tm_min && a->tm_hour == b->tm_hour &&
+           a->tm_mday == b->tm_mday && a->tm_mon == b->tm_mon && a->tm_year == b->tm_year &&
+           a->tm_wday == b->tm_wday && a->tm_yday == b->tm_yday;
+}
+
+static void test_calendar(void)
+{
+    static const uint32_t tod[] = { 0, 1, 59, 3599, 43210, 86399 };
+
+    for (uint64_t day = 0; day * 86400 <= UINT32_MAX; day++)
+    {
+        for (unsigned i = 0; i < sizeof(tod) / sizeof(tod[0]); i++)
+        {
+            uint64_t ts = day * 86400 + tod[i];
+            time_t tt = (time_t)ts;
+            struct tm ref, got;
+
+            if (ts > UINT32_MAX)
+                continue;
+
+            gmtime_r(&tt, &ref);
+            SysTimeLocalTime((uint32_t)ts, &got);
+            CHECK(tm_equal(&got, &ref), "localtime %llu: %d-%d-%d %d:%d:%d",
+                  (unsigned long long)ts, got.tm_year + 1900, got.tm_mon + 1, got.tm_mday,
+                  got.tm_hour, got.tm_min, got.tm_sec);
+            CHECK(SysTimeMkTime(&ref) == ts, "mktime %llu", (unsigned long long)ts);
+        }
+    }
+
+    struct tm last;
+    SysTimeLocalTime(UINT32_MAX, &last);
+    CHECK(last.tm_year == 206 && last.tm_mon == 1 && last.tm_mday == 7 &&
+          last.tm_hour == 6 && last.tm_min == 28 && last.tm_sec == 15, "localtime UINT32_MAX");
+
+    // The cached last day is shorter than 86400 s, a timestamp after the wrap is another day
+    SysTimeLocalTime(45296, &last);
+    CHECK(last.tm_year == 70 && last.tm_yday == 0 && last.tm_hour == 12, "localtime after UINT32_MAX");
+}
+
+static void test_reference(void)
+{
+    for (uint32_t day = 0; day <= REF_LAST_DAY; day++)
+    {
+        uint32_t ts = day * 86400 + 45296;
+        struct tm ref, got;
+
+        RefSysTimeLocalTime(ts, &ref);
+        SysTimeLocalTime(ts, &got);
+        CHECK(tm_equal(&got, &ref), "reference localtime %u", ts);
+        CHECK(SysTimeMkTime(&got) == RefSysTimeMkTime(&got), "reference mktime %u", ts);
+    }
+}
+
+static double now_ns(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+// ns per call over the 1970-2095 range, a new day on every call unless same_day
+static double bench_localtime(void (*fn)(const uint32_t, struct tm *), int same_day)
+{
+    static volatile int sink;
+    struct tm tm;
+    double start = now_ns();
+    uint32_t calls = 0;
+
+    for (int round = 0; round < 20; round++)
+    {
+        for (uint32_t day = 0; day <= REF_LAST_DAY; day++, calls++)
+        {
+            fn(same_day ? 1700000000 + (day & 0xFFFF) : day * 86400 + round * 3607, &tm);
+            sink += tm.tm_mday;
+        }
+    }
+    return (now_ns() - start) / calls;
+}
+
+static void gmtime_wrapper(const uint32_t timestamp, struct tm *localtime)
+{
+    time_t tt = timestamp;
+
+    gmtime_r(&tt, localtime);
+}
+
+static double bench_mktime(uint32_t (*fn)(const struct tm *))
+{
+    static volatile uint32_t sink;
+    struct tm tm[256];
+    double start;
+    uint32_t calls = 0;
+
+    for (int i = 0; i < 256; i++)
+        SysTimeLocalTime(i * 15552007u, &tm[i]);
+    start = now_ns();
+    for (int round = 0; round < 4000; round++)
+    {
+        for (int i = 0; i < 256; i++, calls++)
+            sink += fn(&tm[i]);
+    }
+    return (now_ns() - start) / calls;
+}
+
+static void bench(void)
+{
+    printf("systime: localtime %.1f ns (same day %.1f ns, previous %.1f ns, gmtime_r %.1f ns), "
+           "mktime %.1f ns (previous %.1f ns)\n",
+           bench_localtime(SysTimeLocalTime, 0), bench_localtime(SysTimeLocalTime, 1),
+           bench_localtime(RefSysTimeLocalTime, 0), bench_localtime(gmtime_wrapper, 0),
+           bench_mktime(SysTimeMkTime), bench_mktime(RefSysTimeMkTime));
+}
+
+static void test_ms(void)
+{
+    for (uint64_t ms = 0; ms < (1000ULL << 32); ms += 999983ULL)
+    {
+        SysTime_t t = SysTimeFromMs64(ms);
+
+        CHECK(t.Seconds == ms / 1000 && t.SubSeconds == ms % 1000, "from ms64 %llu", (unsigned long long)ms);
+        CHECK(SysTimeToMs64(t) == ms, "to ms64 %llu", (unsigned long long)ms);
+    }
+
+    uint64_t ms = (1000ULL << 32) - 1;
+    SysTime_t t = SysTimeFromMs64(ms);
+    CHECK(t.Seconds == UINT32_MAX && t.SubSeconds == 999, "from ms64 max");
+
+    for (uint32_t ms32 = 0; ms32 < UINT32_MAX - 65521; ms32 += 65521)
+    {
+        t = SysTimeFromMs(ms32);
+        CHECK(t.Seconds == ms32 / 1000 && t.SubSeconds == ms32 % 1000 && SysTimeToMs(t) == ms32,
+              "ms %u", ms32);
+    }
+}
+
+int main(void)
+{
+    test_calendar();
+    test_reference();
+    test_ms();
+    bench();
+    TEST_DONE("systime");
+}
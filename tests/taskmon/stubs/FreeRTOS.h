@@ -0,0 +1,24 @@
+/* Host stand-in for FreeRTOS. The test plays the kernel: the task list, the
+ * run-time counters and the heap of service_taskmon.c are implemented there. */
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define pdFALSE             0
+#define pdTRUE              1
+#define pdPASS              1
+
+#define configTICK_RATE_HZ  1000
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(((TickType_t)(ms) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000))
+
+void *pvPortMalloc(size_t size);
+void vPortFree(void *pv);
+
+#endif
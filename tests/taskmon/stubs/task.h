@@ -0,0 +1,40 @@
+/* Host stand-in for FreeRTOS task.h, see FreeRTOS.h. */
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+
+typedef enum
+{
+    eRunning = 0,
+    eReady,
+    eBlocked,
+    eSuspended,
+    eDeleted,
+    eInvalid
+} eTaskState;
+
+typedef struct xTASK_STATUS
+{
+    TaskHandle_t xHandle;
+    const char *pcTaskName;
+    UBaseType_t xTaskNumber;
+    eTaskState eCurrentState;
+    UBaseType_t uxCurrentPriority;
+    UBaseType_t uxBasePriority;
+    uint32_t ulRunTimeCounter;
+    StackType_t *pxStackBase;
+    uint16_t usStackHighWaterMark;
+} TaskStatus_t;
+
+UBaseType_t uxTaskGetNumberOfTasks(void);
+UBaseType_t uxTaskGetSystemState(TaskStatus_t * const pxTaskStatusArray, const UBaseType_t uxArraySize,
+                                 uint32_t * const pulTotalRunTime);
+UBaseType_t uxTaskGetTaskNumber(TaskHandle_t xTask);
+void vTaskSetTaskNumber(TaskHandle_t xTask, const UBaseType_t uxHandle);
+void vTaskSuspendAll(void);
+BaseType_t xTaskResumeAll(void);
+
+#endif
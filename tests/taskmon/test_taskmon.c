@@ -0,0 +1,304 @@
+/*
+ * FreeRTOS task monitor of service_taskmon.c on a simulated kernel. The test
+ * keeps the task list, hands out TaskStatus_t snapshots in a different order
+ * every time, advances the 32-bit run-time counters, and calls the
+ * traceTASK_SWITCHED_IN() hook with the uxTaskNumber tag of each task.
+ *
+ * Random creates, deletes and runs, with more live tasks than slots at
+ * times, have to give every tracked task the CPU share, switch count and
+ * stack minimum the schedule makes. Tasks left out are reported as
+ * untracked, and the slot of a deleted task goes to a later task with fresh
+ * statistics. A new task may reuse the TCB of a deleted one, along with its
+ * tag, which the kernel does not initialize: it must not take over the slot
+ * the tag points to. Shares then have to stay exact while the run-time
+ * counters wrap between samples. Snapshots are freed and the scheduler is
+ * resumed every time.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "service_taskmon.h"
+#include "test.h"
+
+#define SIM_TASKS       (SERVICE_TASKMON_TASK_MAX + 8)
+#define ROUNDS          3000
+#define WRAP_ROUNDS     12
+#define WRAP_TICKS      1000000000u     // more than 4 rounds wrap the counters
+
+//
+// Simulated kernel
+//
+
+typedef struct {
+    bool live;
+    UBaseType_t number;                 // xTaskNumber, never reused
+    UBaseType_t tag;                    // uxTaskNumber, left over in a reused TCB
+    char name[SERVICE_TASKMON_NAME_LEN];
+    uint32_t run;                       // ulRunTimeCounter
+    uint16_t stack_hwm;                 // words
+    uint16_t share;                     // permille of the run time it takes
+    uint64_t run_counted;               // since it was created or the monitor reset
+    uint16_t stack_min;
+} sim_task_t;
+
+static sim_task_t tasks[SIM_TASKS];     // the index is the TCB, reused after a delete
+static uint32_t tag_switches[SERVICE_TASKMON_TASK_MAX + 1];    // since the tag was handed out or the reset
+static UBaseType_t next_number = 1;
+static uint32_t total_run;
+static uint64_t total_counted;
+static int suspended, heap_blocks, snapshots;
+
+void *pvPortMalloc(size_t size)
+{
+    heap_blocks++;
+    return malloc(size);
+}
+
+void vPortFree(void *pv)
+{
+    heap_blocks--;
+    free(pv);
+}
+
+void vTaskSuspendAll(void)
+{
+    suspended++;
+}
+
+BaseType_t xTaskResumeAll(void)
+{
+    CHECK(suspended > 0, "scheduler resumed more often than suspended");
+    suspended--;
+    return pdFALSE;
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void)
+{
+    UBaseType_t n = 0;
+
+    for (int i = 0; i < SIM_TASKS; i++)
+        n += tasks[i].live;
+    return n;
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t * const pxTaskStatusArray, const UBaseType_t uxArraySize,
+                                 uint32_t * const pulTotalRunTime)
+{
+    UBaseType_t n = 0;
+
+    CHECK(suspended > 0, "snapshot taken with the scheduler running");
+    CHECK(uxArraySize >= uxTaskGetNumberOfTasks(), "snapshot of %lu tasks for %lu", uxArraySize,
+          uxTaskGetNumberOfTasks());
+    // The kernel walks its ready, delayed and suspended lists, the order changes
+    for (int k = 0; k < SIM_TASKS && n < uxArraySize; k++)
+    {
+        sim_task_t *t = &tasks[(k + snapshots * 7) % SIM_TASKS];
+        TaskStatus_t *s = &pxTaskStatusArray[n];
+
+        if (!t->live)
+            continue;
+        memset(s, 0, sizeof(*s));
+        s->xHandle = t;
+        s->pcTaskName = t->name;
+        s->xTaskNumber = t->number;
+        s->eCurrentState = eReady;
+        s->ulRunTimeCounter = t->run;
+        s->usStackHighWaterMark = t->stack_hwm;
+        n++;
+    }
+    snapshots++;
+    *pulTotalRunTime = total_run;
+    return n;
+}
+
+UBaseType_t uxTaskGetTaskNumber(TaskHandle_t xTask)
+{
+    return ((sim_task_t *)xTask)->tag;
+}
+
+void vTaskSetTaskNumber(TaskHandle_t xTask, const UBaseType_t uxHandle)
+{
+    CHECK(uxHandle >= 1 && uxHandle <= SERVICE_TASKMON_TASK_MAX, "tag %lu", uxHandle);
+    ((sim_task_t *)xTask)->tag = uxHandle;
+    tag_switches[uxHandle] = 0;
+}
+
+// prvInitialiseNewTask() sets no uxTaskNumber, a new task in a reused TCB has the old tag
+static void task_create(int i, uint16_t share)
+{
+    sim_task_t *t = &tasks[i];
+    UBaseType_t tag = t->tag;
+
+    memset(t, 0, sizeof(*t));
+    t->live = true;
+    t->tag = tag;
+    t->number = next_number++;
+    snprintf(t->name, sizeof(t->name), "T%lu", t->number);
+    t->share = share;
+    t->stack_hwm = t->stack_min = 64 + rand() % 512;
+}
+
+// Every live task runs its share of ticks, switched in once per 100 permille and at least once
+static void run(uint32_t ticks)
+{
+    for (int i = 0; i < SIM_TASKS; i++)
+    {
+        sim_task_t *t = &tasks[i];
+        uint32_t ran = (uint32_t)((uint64_t)ticks * t->share / 1000);
+
+        if (!t->live)
+            continue;
+        t->run += ran;
+        t->run_counted += ran;
+        // A stale tag counts for the slot it points to, until the task has its own
+        for (int n = 0; n <= t->share / 100; n++)
+        {
+            service_taskmon_switched_in(t->tag);
+            tag_switches[t->tag]++;
+        }
+        if (rand() % 8 == 0 && t->stack_hwm > 8)
+        {
+            t->stack_hwm -= 1 + rand() % 8;
+            if (t->stack_hwm < t->stack_min)
+                t->stack_min = t->stack_hwm;
+        }
+    }
+    total_run += ticks;
+    total_counted += ticks;
+}
+
+static void reset(void)
+{
+    service_taskmon_reset();
+    for (int i = 0; i < SIM_TASKS; i++)
+        tasks[i].run_counted = 0;
+    memset(tag_switches, 0, sizeof(tag_switches));
+    total_counted = 0;
+}
+
+//
+// Checks
+//
+
+static int tracked_live(void)
+{
+    int n = uxTaskGetNumberOfTasks();
+
+    return (n < SERVICE_TASKMON_TASK_MAX) ? n : SERVICE_TASKMON_TASK_MAX;
+}
+
+// A task is picked up once a slot is free before it is seen, which may take a second sample
+static void check(int round)
+{
+    service_taskmon_info_t info[SERVICE_TASKMON_TASK_MAX + 1];
+    int live = uxTaskGetNumberOfTasks(), count, untracked;
+
+    service_taskmon_sample();
+    count = service_taskmon_get(info, SERVICE_TASKMON_TASK_MAX + 1);
+    untracked = service_taskmon_get_untracked();
+    CHECK(suspended == 0 && heap_blocks == 0, "round %d: scheduler suspended %d, %d snapshots not freed", round,
+          suspended, heap_blocks);
+    CHECK(count == tracked_live(), "round %d: %d tasks tracked, %d live", round, count, live);
+    CHECK(untracked == live - tracked_live(), "round %d: %d untracked of %d live", round, untracked, live);
+
+    for (int k = 0; k < count; k++)
+    {
+        sim_task_t *t = NULL;
+        uint16_t permille;
+
+        for (int i = 0; i < SIM_TASKS; i++)
+        {
+            if (tasks[i].live && !strcmp(tasks[i].name, info[k].name))
+                t = &tasks[i];
+        }
+        CHECK(t != NULL, "round %d: %s tracked but not live", round, info[k].name);
+        if (t == NULL)
+            continue;
+
+        permille = total_counted ? (uint16_t)(t->run_counted * 1000 / total_counted) : 0;
+        CHECK(info[k].cpu_permille == permille, "round %d: %s at %u permille, expected %u", round, t->name,
+              info[k].cpu_permille, permille);
+        CHECK(info[k].switches == tag_switches[t->tag], "round %d: %s switched in %u times, expected %u", round,
+              t->name, info[k].switches, tag_switches[t->tag]);
+        CHECK(info[k].stack_free == t->stack_min * sizeof(StackType_t), "round %d: %s has %u bytes free, expected %zu",
+              round, t->name, info[k].stack_free, t->stack_min * sizeof(StackType_t));
+    }
+}
+
+//
+// Scenarios
+//
+
+static void test_reuse(void)
+{
+    int deleted = 0, reused = 0;
+
+    srand(50);
+    for (int i = 0; i < SERVICE_TASKMON_TASK_MAX + 2; i++)
+        task_create(i, 1 + rand() % 30);
+    service_taskmon_sample();
+    service_taskmon_sample();
+    reset();
+    check(-1);
+
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        int i = rand() % SIM_TASKS;
+
+        if (tasks[i].live && rand() % 3 == 0)
+        {
+            tasks[i].live = false;
+            deleted++;
+        }
+        else if (!tasks[i].live)
+        {
+            // The new task keeps the TCB, and may take the slot of the task deleted in it
+            task_create(i, 1 + rand() % 30);
+            reused++;
+        }
+        run(1000 + rand() % 100000);
+        service_taskmon_sample();
+        check(round);
+    }
+    CHECK(deleted > SIM_TASKS && reused > SIM_TASKS, "%d tasks deleted and %d created", deleted, reused);
+}
+
+// Sampled more often than the 32-bit counters wrap, the shares stay exact across it
+static void test_wrap(void)
+{
+    static const uint16_t shares[] = { 200, 300, 450 };
+    uint32_t last = 0;
+    int wraps = 0;
+
+    for (int i = 0; i < SIM_TASKS; i++)
+        tasks[i].live = false;
+    service_taskmon_sample();
+    for (int i = 0; i < 3; i++)
+        task_create(i, shares[i]);
+    service_taskmon_sample();
+    reset();
+
+    for (int round = 0; round < WRAP_ROUNDS; round++)
+    {
+        run(WRAP_TICKS);
+        wraps += (total_run < last);
+        last = total_run;
+        check(ROUNDS + round);
+    }
+    CHECK(wraps >= 2, "the run-time counter wrapped %d times", wraps);
+}
+
+int main(void)
+{
+    service_taskmon_init();
+    test_reuse();
+    test_wrap();
+
+    printf("taskmon: %d rounds with %d slots for up to %d tasks, %d snapshots\n", ROUNDS,
+           SERVICE_TASKMON_TASK_MAX, SIM_TASKS, snapshots);
+    TEST_DONE("taskmon");
+}
@@ -0,0 +1,25 @@
+#ifndef _TEST_H_
+#define _TEST_H_
+
+#include <stdio.h>
+
+static int test_failed;
+
+#define CHECK(cond, ...)                                                \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            if (test_failed++ < 10) {                                   \
+                printf("%s:%d: ", __FILE__, __LINE__);                  \
+                printf(__VA_ARGS__);                                    \
+                printf("\n");                                           \
+            }                                                           \
+        }                                                               \
+    } while (0)
+
+#define TEST_DONE(name)                                                 \
+    do {                                                                \
+        printf("%s: %s\n", name, test_failed ? "FAIL" : "ok");          \
+        return test_failed != 0;                                        \
+    } while (0)
+
+#endif  // #ifndef _TEST_H_
@@ -0,0 +1,21 @@
+/* Host stand-in for service/lora/service_lora.h, only what transparent mode uses */
+#ifndef __SERVICE_LORA_H__
+#define __SERVICE_LORA_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct _SERVICE_LORA_SEND_INFO
+{
+    uint8_t port;
+    bool retry_valid;
+    uint8_t retry;
+    bool confirm_valid;
+    uint8_t confirm;
+} SERVICE_LORA_SEND_INFO;
+
+bool service_lora_get_njs(void);
+int32_t service_lora_send(uint8_t *buff, uint32_t len, SERVICE_LORA_SEND_INFO info, bool blocking);
+int32_t service_lora_query_txPossible(int16_t len);
+
+#endif
@@ -0,0 +1,18 @@
+/* Host stand-in for service/nvm/service_nvm.h, only what transparent mode uses */
+#ifndef __SERVICE_NVM_H__
+#define __SERVICE_NVM_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "udrv_serial.h"
+#include "service_mode.h"
+
+SERVICE_MODE_TYPE service_nvm_get_mode_type_from_nvm(SERIAL_PORT port);
+int32_t service_nvm_set_mode_type_to_nvm(SERIAL_PORT port, SERVICE_MODE_TYPE mode_type);
+uint8_t service_nvm_get_tp_port_from_nvm(SERIAL_PORT port);
+uint32_t service_nvm_get_tp_idle_ms_from_nvm(SERIAL_PORT port);
+int16_t service_nvm_get_tp_delimiter_from_nvm(SERIAL_PORT port);
+bool service_nvm_get_tp_flow_control_from_nvm(SERIAL_PORT port);
+int32_t service_nvm_set_tp_flush_to_nvm(SERIAL_PORT port, uint32_t idle_ms, int16_t delimiter, bool flow_control);
+
+#endif
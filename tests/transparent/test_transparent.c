@@ -0,0 +1,301 @@
+/*
+ * Transparent mode buffering: flush on delimiter, idle gap and payload size,
+ * intake into the second buffer while an uplink is pending, XOFF/XON flow
+ * control, a datarate drop after sealing and the "+++" escape.
+ */
+#include <stdint.h>
+#include "service_mode_transparent.h"
+#include "service_mode.h"
+#include "service_nvm.h"
+#include "service_lora.h"
+#include "udrv_errno.h"
+#include "udrv_rtc.h"
+#include "udrv_system.h"
+#include "test.h"
+
+#define PORT    SERIAL_UART0
+
+static uint64_t now_ms = 1;
+static timer_handler tick;
+static bool tick_running;
+
+static int32_t send_ret;
+static int32_t tx_possible = 242;
+static uint8_t sent[16][TP_BUFFER_SIZE];
+static uint16_t sent_len[16];
+static int sends;
+
+static uint8_t serial_out[64];
+static int serial_out_len;
+
+static SERVICE_MODE_TYPE mode = SERVICE_MODE_TYPE_TRANSPARENT;
+static uint32_t nvm_idle_ms;
+static int16_t nvm_delimiter = TP_NO_DELIMITER;
+static bool nvm_flow_control;
+static int cli_inits;
+
+uint64_t udrv_rtc_get_timestamp(RtcID_E timer_id)
+{
+    return now_ms;
+}
+
+void udrv_system_critical_section_begin(uint32_t *mask)
+{
+}
+
+void udrv_system_critical_section_end(uint32_t *mask)
+{
+}
+
+int32_t udrv_system_timer_create(SysTimerID_E timer_id, timer_handler tmr_handler, TimerMode_E mode)
+{
+    tick = tmr_handler;
+    return UDRV_RETURN_OK;
+}
+
+int32_t udrv_system_timer_start(SysTimerID_E timer_id, uint32_t count, void *m_data)
+{
+    tick_running = true;
+    return UDRV_RETURN_OK;
+}
+
+int32_t udrv_system_timer_stop(SysTimerID_E timer_id)
+{
+    tick_running = false;
+    return UDRV_RETURN_OK;
+}
+
+int32_t udrv_serial_write(SERIAL_PORT port, uint8_t const *buffer, int32_t length)
+{
+    memcpy(serial_out + serial_out_len, buffer, length);
+    serial_out_len += length;
+    return length;
+}
+
+bool service_lora_get_njs(void)
+{
+    return true;
+}
+
+int32_t service_lora_query_txPossible(int16_t len)
+{
+    return tx_possible;
+}
+
+int32_t service_lora_send(uint8_t *buff, uint32_t len, SERVICE_LORA_SEND_INFO info, bool blocking)
+{
+    if (send_ret != UDRV_RETURN_OK)
+        return send_ret;
+    memcpy(sent[sends], buff, len);
+    sent_len[sends++] = len;
+    return UDRV_RETURN_OK;
+}
+
+SERVICE_MODE_TYPE service_nvm_get_mode_type_from_nvm(SERIAL_PORT port)
+{
+    return mode;
+}
+
+int32_t service_nvm_set_mode_type_to_nvm(SERIAL_PORT port, SERVICE_MODE_TYPE mode_type)
+{
+    mode = mode_type;
+    return UDRV_RETURN_OK;
+}
+
+uint8_t service_nvm_get_tp_port_from_nvm(SERIAL_PORT port)
+{
+    return 2;
+}
+
+uint32_t service_nvm_get_tp_idle_ms_from_nvm(SERIAL_PORT port)
+{
+    return nvm_idle_ms;
+}
+
+int16_t service_nvm_get_tp_delimiter_from_nvm(SERIAL_PORT port)
+{
+    return nvm_delimiter;
+}
+
+bool service_nvm_get_tp_flow_control_from_nvm(SERIAL_PORT port)
+{
+    return nvm_flow_control;
+}
+
+int32_t service_nvm_set_tp_flush_to_nvm(SERIAL_PORT port, uint32_t idle_ms, int16_t delimiter, bool flow_control)
+{
+    nvm_idle_ms = idle_ms;
+    nvm_delimiter = delimiter;
+    nvm_flow_control = flow_control;
+    return UDRV_RETURN_OK;
+}
+
+void service_mode_cli_init(SERIAL_PORT port)
+{
+    cli_inits++;
+}
+
+static void start(void)
+{
+    service_mode_transparent_init(PORT);
+    sends = 0;
+    serial_out_len = 0;
+    send_ret = UDRV_RETURN_OK;
+}
+
+static void stop(void)
+{
+    service_mode_transparent_deinit(PORT);
+}
+
+static void type(const char *s, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++)
+        service_mode_transparent_handler(PORT, (uint8_t)s[i]);
+}
+
+static void run_tick(void)
+{
+    now_ms += TP_FLUSH_TICK_MS;
+    if (tick_running)
+        tick(NULL);
+}
+
+static void test_defaults(void)
+{
+    //Nothing in NVM yet, the idle gap falls back to the default
+    nvm_idle_ms = 0;
+    start();
+    type("abc", 3);
+    CHECK(tick_running, "tick not started");
+    for (uint32_t t = 0; t + TP_FLUSH_TICK_MS < TP_IDLE_FLUSH_MS; t += TP_FLUSH_TICK_MS)
+        run_tick();
+    CHECK(sends == 0, "flushed before the idle gap");
+    run_tick();
+    CHECK(sends == 1 && sent_len[0] == 3 && memcmp(sent[0], "abc", 3) == 0, "idle flush");
+    run_tick();
+    CHECK(!tick_running, "tick left running with empty buffers");
+    stop();
+}
+
+static void test_settings(void)
+{
+    CHECK(service_mode_transparent_set_flush(PORT, 0, TP_NO_DELIMITER, false) == -UDRV_WRONG_ARG, "idle 0 accepted");
+    CHECK(service_mode_transparent_set_flush(PORT, 100, 0x100, false) == -UDRV_WRONG_ARG, "delimiter 0x100 accepted");
+    CHECK(service_mode_transparent_set_flush(PORT, 100, -2, false) == -UDRV_WRONG_ARG, "delimiter -2 accepted");
+    CHECK(service_mode_transparent_set_flush(PORT, 500, '\n', true) == UDRV_RETURN_OK, "valid settings rejected");
+    CHECK(nvm_idle_ms == 500 && nvm_delimiter == '\n' && nvm_flow_control, "settings not saved");
+}
+
+static void test_delimiter(void)
+{
+    nvm_idle_ms = 500;
+    nvm_delimiter = '\n';
+    nvm_flow_control = false;
+    start();
+    type("hello\nwor", 9);
+    run_tick();
+    CHECK(sends == 1 && sent_len[0] == 6 && memcmp(sent[0], "hello\n", 6) == 0, "delimiter flush");
+    run_tick();
+    CHECK(sends == 1, "partial line flushed early");
+    for (int i = 0; i < 5; i++)
+        run_tick();
+    CHECK(sends == 2 && sent_len[1] == 3 && memcmp(sent[1], "wor", 3) == 0, "idle flush after delimiter");
+    stop();
+}
+
+static void test_size(void)
+{
+    char data[120];
+
+    for (int i = 0; i < (int)sizeof(data); i++)
+        data[i] = 'a' + i % 26;
+
+    nvm_idle_ms = 500;
+    nvm_delimiter = TP_NO_DELIMITER;
+    tx_possible = 51;
+    start();
+    type(data, 51);
+    run_tick();
+    CHECK(sends == 1 && sent_len[0] == 51 && memcmp(sent[0], data, 51) == 0, "size flush");
+
+    //The datarate drops after the buffer was sealed
+    type(data, 51);
+    tx_possible = 11;
+    run_tick();
+    CHECK(sends == 2 && sent_len[1] == 11 && memcmp(sent[1], data, 11) == 0, "first part after DR drop");
+    for (int i = 0; i < 4; i++)
+        run_tick();
+    CHECK(sends == 6 && sent_len[5] == 7 && memcmp(sent[5], data + 44, 7) == 0, "rest after DR drop");
+    tx_possible = 242;
+    stop();
+}
+
+static void test_double_buffer(void)
+{
+    char data[2 * 51 + 10];
+
+    for (int i = 0; i < (int)sizeof(data); i++)
+        data[i] = 'A' + i % 26;
+
+    nvm_idle_ms = 500;
+    nvm_delimiter = TP_NO_DELIMITER;
+    nvm_flow_control = true;
+    tx_possible = 51;
+    start();
+    send_ret = -UDRV_BUSY;
+
+    //Both buffers fill while the uplink is pending, the rest overflows
+    type(data, sizeof(data));
+    CHECK(serial_out_len == 1 && serial_out[0] == TP_XOFF_CHAR, "XOFF not sent");
+    CHECK(service_mode_transparent_get_overflow(PORT) == 10, "overflow %u", service_mode_transparent_get_overflow(PORT));
+    run_tick();
+    CHECK(sends == 0, "sent while busy");
+
+    send_ret = UDRV_RETURN_OK;
+    run_tick();
+    CHECK(sends == 1 && memcmp(sent[0], data, 51) == 0, "first buffer");
+    CHECK(serial_out_len == 2 && serial_out[1] == TP_XON_CHAR, "XON not sent");
+    run_tick();
+    CHECK(sends == 2 && memcmp(sent[1], data + 51, 51) == 0, "second buffer");
+    tx_possible = 242;
+    nvm_flow_control = false;
+    stop();
+}
+
+static void test_no_network(void)
+{
+    nvm_idle_ms = 100;
+    nvm_delimiter = '\n';
+    start();
+    send_ret = -UDRV_NO_WAN_CONNECTION;
+    type("x\n", 2);
+    for (uint32_t t = 0; t <= TP_NO_NWK_ESCAPE_MS + TP_FLUSH_TICK_MS; t += TP_FLUSH_TICK_MS)
+        run_tick();
+    CHECK(mode == SERVICE_MODE_TYPE_CLI && cli_inits == 1, "no escape without network");
+    mode = SERVICE_MODE_TYPE_TRANSPARENT;
+}
+
+static void test_escape(void)
+{
+    nvm_idle_ms = 100;
+    nvm_delimiter = TP_NO_DELIMITER;
+    start();
+    type("+a++", 4);
+    CHECK(mode == SERVICE_MODE_TYPE_TRANSPARENT, "escaped on a broken sequence");
+    type("+", 1);
+    CHECK(mode == SERVICE_MODE_TYPE_CLI && cli_inits == 2, "no escape on +++");
+    mode = SERVICE_MODE_TYPE_TRANSPARENT;
+}
+
+int main(void)
+{
+    test_defaults();
+    test_settings();
+    test_delimiter();
+    test_size();
+    test_double_buffer();
+    test_no_network();
+    test_escape();
+    TEST_DONE("transparent");
+}
@@ -0,0 +1,13 @@
+/* Host stand-in for the board pin definitions of the IOM I2C pads. */
+#ifndef _AM_BSP_PINS_H_
+#define _AM_BSP_PINS_H_
+
+#include "am_mcu_apollo.h"
+
+#define AM_BSP_GPIO_IOM2_SCL        27
+#define AM_BSP_GPIO_IOM2_SDA        25
+
+extern const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_IOM2_SCL;
+extern const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_IOM2_SDA;
+
+#endif  // #ifndef _AM_BSP_PINS_H_
@@ -0,0 +1,5 @@
+/* Host stand-in for the board pin map, nothing of it is used. */
+#ifndef _PIN_DEFINE_H_
+#define _PIN_DEFINE_H_
+
+#endif
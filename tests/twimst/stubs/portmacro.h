@@ -0,0 +1,5 @@
+/* Host stand-in, see FreeRTOS.h. */
+#ifndef _STUB_PORTMACRO_H_
+#define _STUB_PORTMACRO_H_
+
+#endif
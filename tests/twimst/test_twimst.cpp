@@ -0,0 +1,721 @@
+/*
+ * Wire and the I2C master queue in uhal_twimst.c on a mock IOM driving
+ * simulated register-file slaves: the first byte of a write sets the register
+ * pointer, the next ones are stored, reads return the registers from the
+ * pointer on. Transactions complete after their bits were clocked out and are
+ * reported through the IOM interrupt; the bus records start, repeated start,
+ * address (~ for a NACK), data and stop.
+ * Checks the framing of Wire writes, register reads and writes held back by
+ * endTransmission(false), that a NACK of a held back write is reported by the
+ * next call, that random queued transactions reach the bus in order with the
+ * right framing while the idle task is kept out of deep sleep, and reports
+ * bus time and wake-ups of register reads.
+ */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+extern "C" {
+#include "uhal_twimst.h"
+#include "udrv_powersave.h"
+#include "semphr.h"
+}
+#include "Wire.h"
+#include "test.h"
+
+#define CLOCK_HZ        400000
+#define TXN_SETUP_NS    2000            // IOM command queue and DMA start per transaction
+#define ISR_COST_NS     10000           // IOM interrupt: HAL service, callback, next transaction
+#define TRACE_MAX       8192
+#define ABSENT          0x30
+#define QUEUE_FREE      7
+
+extern "C" void am_iomaster2_isr(void);
+
+typedef struct
+{
+    uint8_t addr;
+    uint8_t reg[256];
+    uint8_t ptr;
+    bool first;                 // the next byte written sets the pointer
+} slave_t;
+
+typedef struct
+{
+    char s[TRACE_MAX];
+    size_t len;
+    bool held;                  // no stop since the last start
+    uint64_t bits;
+} bus_t;
+
+static struct
+{
+    bool enabled;
+    uint32_t clock;
+    bool inflight;
+    bool irq;
+    am_hal_iom_transfer_t t;
+    am_hal_iom_callback_t cb;
+    void *ctx;
+    uint64_t done_at;
+} iom;
+
+static slave_t slaves[2] = {{0x48}, {0x49}};
+static slave_t ref_slaves[2];
+static bus_t bus, ref;
+static uint64_t now_ns;
+static uint32_t interrupts;
+static uint32_t wakeups;
+
+struct sim_sem
+{
+    int count;
+};
+
+extern "C" {
+
+SCB_Type sim_scb;
+const am_hal_gpio_pincfg_t g_AM_HAL_GPIO_DISABLE = {0};
+const am_hal_gpio_pincfg_t g_AM_BSP_GPIO_IOM2_SCL = {0}, g_AM_BSP_GPIO_IOM2_SDA = {0};
+
+void udrv_powersave_periph_use(UDRV_PS_PERIPH id)
+{
+}
+
+static uint32_t twi_latency = UDRV_PS_LATENCY_ANY;
+
+void udrv_powersave_set_latency(UDRV_PS_LATENCY who, uint32_t max_us)
+{
+    CHECK(who == UDRV_PS_LATENCY_TWI, "latency bound %d set by the I2C driver", who);
+    twi_latency = max_us;
+}
+
+// FreeRTOS
+
+static bool sim_step(void);
+
+SemaphoreHandle_t sim_sem_create(int count)
+{
+    SemaphoreHandle_t sem = (SemaphoreHandle_t)calloc(1, sizeof(*sem));
+
+    sem->count = count;
+    return sem;
+}
+
+// A task blocks: the bus runs until the semaphore is given.
+BaseType_t sim_sem_take(SemaphoreHandle_t sem, TickType_t wait)
+{
+    while (sem->count == 0)
+    {
+        if (wait == 0 || !sim_step())
+        {
+            CHECK(wait == 0, "task blocked with nothing left to wake it");
+            return pdFAIL;
+        }
+    }
+    sem->count--;
+    return pdPASS;
+}
+
+BaseType_t sim_sem_give(SemaphoreHandle_t sem)
+{
+    if (SCB->ICSR != 0)
+        wakeups++;
+    sem->count = 1;
+    return pdPASS;
+}
+
+}
+
+// Bus and slaves
+
+static void tok(bus_t *b, const char *fmt, ...)
+{
+    va_list ap;
+
+    if (b->len > 0 && b->len < TRACE_MAX - 1)
+        b->s[b->len++] = ' ';
+    va_start(ap, fmt);
+    b->len += vsnprintf(b->s + b->len, TRACE_MAX - b->len, fmt, ap);
+    va_end(ap);
+    CHECK(b->len < TRACE_MAX - 1, "trace full");
+}
+
+static void clear(bus_t *b)
+{
+    b->len = 0;
+    b->s[0] = '\0';
+}
+
+static slave_t *find(slave_t *set, uint32_t addr)
+{
+    for (int i = 0; i < 2; i++)
+    {
+        if (set[i].addr == addr)
+            return &set[i];
+    }
+    return NULL;
+}
+
+static bool bus_address(bus_t *b, slave_t *s, uint32_t addr, bool rd)
+{
+    tok(b, b->held ? "Sr" : "S");
+    tok(b, "%02x%s", (addr << 1) | rd, s ? "" : "~");
+    b->held = true;
+    b->bits += 1 + 9;
+    if (s != NULL && !rd)
+        s->first = true;
+    return s != NULL;
+}
+
+static void bus_write(bus_t *b, slave_t *s, uint8_t data)
+{
+    tok(b, "%02x", data);
+    b->bits += 9;
+    if (s->first)
+        s->ptr = data;
+    else
+        s->reg[s->ptr++] = data;
+    s->first = false;
+}
+
+static uint8_t bus_read(bus_t *b, slave_t *s)
+{
+    uint8_t data = s->reg[s->ptr++];
+
+    tok(b, "%02x", data);
+    b->bits += 9;
+    return data;
+}
+
+static void bus_stop(bus_t *b)
+{
+    tok(b, "P");
+    b->held = false;
+    b->bits += 1;
+}
+
+// One IOM transaction on the bus.
+static uint32_t bus_transfer(am_hal_iom_transfer_t *t)
+{
+    uint32_t addr = t->uPeerInfo.ui32I2CDevAddr;
+    slave_t *s = find(slaves, addr);
+    bool rx = (t->eDirection == AM_HAL_IOM_RX);
+
+    CHECK(t->ui32NumBytes <= AM_HAL_IOM_MAX_TXNSIZE_I2C, "transaction of %u bytes", t->ui32NumBytes);
+    CHECK(t->ui32InstrLen <= AM_HAL_IOM_MAX_OFFSETSIZE, "offset of %u bytes", t->ui32InstrLen);
+    if (!rx || t->ui32InstrLen > 0)
+    {
+        if (!bus_address(&bus, s, addr, false))
+        {
+            bus_stop(&bus);
+            return AM_HAL_STATUS_FAIL;
+        }
+        for (uint32_t i = t->ui32InstrLen; i-- > 0;)
+            bus_write(&bus, s, (uint8_t)(t->ui32Instr >> (i * 8)));
+        for (uint32_t i = 0; !rx && i < t->ui32NumBytes; i++)
+            bus_write(&bus, s, ((uint8_t *)t->pui32TxBuffer)[i]);
+    }
+    if (rx)
+    {
+        if (!bus_address(&bus, s, addr, true))
+        {
+            bus_stop(&bus);
+            return AM_HAL_STATUS_FAIL;
+        }
+        for (uint32_t i = 0; i < t->ui32NumBytes; i++)
+            ((uint8_t *)t->pui32RxBuffer)[i] = bus_read(&bus, s);
+    }
+    if (!t->bContinue)
+        bus_stop(&bus);
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+static uint64_t bus_ns(uint64_t bits)
+{
+    return bits * 1000000000 / iom.clock;
+}
+
+// Start, address and bytes, a repeated start and address before a read at an offset, stop.
+static uint64_t txn_bits(am_hal_iom_transfer_t *t)
+{
+    return 1 + 9 * (1 + t->ui32InstrLen + t->ui32NumBytes) + ((t->ui32InstrLen > 0) ? 10 : 0) + 1;
+}
+
+// Mock IOM
+
+extern "C" {
+
+uint32_t am_hal_gpio_pinconfig(uint32_t pin, am_hal_gpio_pincfg_t cfg)
+{
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_initialize(uint32_t module, void **handle)
+{
+    CHECK(module == 2, "I2C on IOM%u", module);
+    *handle = &iom;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_power_ctrl(void *handle, uint32_t state, bool retain)
+{
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_configure(void *handle, am_hal_iom_config_t *config)
+{
+    CHECK(config->eInterfaceMode == AM_HAL_IOM_I2C_MODE, "IOM2 not in I2C mode");
+    iom.clock = config->ui32ClockFreq;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_enable(void *handle)
+{
+    iom.enabled = true;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+// The IOM releases a bus held without stop.
+uint32_t am_hal_iom_disable(void *handle)
+{
+    CHECK(!iom.inflight, "IOM disabled with a transaction in flight");
+    if (bus.held)
+        bus_stop(&bus);
+    iom.enabled = false;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_interrupt_enable(void *handle, uint32_t mask)
+{
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_interrupt_status_get(void *handle, bool enabled_only, uint32_t *status)
+{
+    *status = iom.irq ? 1 : 0;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_interrupt_clear(void *handle, uint32_t mask)
+{
+    iom.irq = false;
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_interrupt_service(void *handle, uint32_t status)
+{
+    iom.cb(iom.ctx, bus_transfer(&iom.t));
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_nonblocking_transfer(void *handle, am_hal_iom_transfer_t *transaction,
+                                         am_hal_iom_callback_t callback, void *context)
+{
+    CHECK(iom.enabled, "transfer on a disabled IOM");
+    CHECK(!iom.inflight, "second transaction queued before the first completed");
+    iom.t = *transaction;
+    iom.cb = callback;
+    iom.ctx = context;
+    iom.inflight = true;
+    iom.done_at = now_ns + TXN_SETUP_NS + bus_ns(txn_bits(transaction));
+    return AM_HAL_STATUS_SUCCESS;
+}
+
+uint32_t am_hal_iom_blocking_transfer(void *handle, am_hal_iom_transfer_t *transaction)
+{
+    CHECK(!iom.inflight, "blocking transfer while the queue owns the bus");
+    now_ns += bus_ns(txn_bits(transaction));
+    return bus_transfer(transaction);
+}
+
+uint32_t am_hal_interrupt_master_disable(void)
+{
+    return 0;
+}
+
+void am_hal_interrupt_master_set(uint32_t state)
+{
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq)
+{
+}
+
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority)
+{
+}
+
+}
+
+// Complete the transaction in flight through its interrupt.
+static bool sim_step(void)
+{
+    if (!iom.inflight)
+        return false;
+
+    // The IOM DMA would stop in deep sleep
+    CHECK(twi_latency == 0, "transaction in flight allows deep sleep");
+
+    // The interrupt runs before the next transaction is started.
+    now_ns = iom.done_at + ISR_COST_NS;
+    iom.inflight = false;
+    iom.irq = true;
+    interrupts++;
+    SCB->ICSR = 16 + IOMSTR2_IRQn;
+    am_iomaster2_isr();
+    SCB->ICSR = 0;
+    return true;
+}
+
+// Arduino core: only what the Wire vtable needs from Print.
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+
+    while (size-- > 0)
+        n += write(*buffer++);
+    return n;
+}
+
+static void reset(void)
+{
+    while (sim_step())
+        ;
+    clear(&bus);
+    for (int i = 0; i < 2; i++)
+    {
+        for (int r = 0; r < 256; r++)
+            slaves[i].reg[r] = (uint8_t)(r * 7 + slaves[i].addr);
+        slaves[i].ptr = 0;
+    }
+}
+
+#define CHECK_BUS(expect, what) \
+    CHECK(strcmp(bus.s, expect) == 0, "%s: bus \"%s\", expected \"%s\"", what, bus.s, expect)
+
+static void test_wire_framing(void)
+{
+    uint8_t data[4] = {1, 2, 3, 4};
+
+    reset();
+    Wire.beginTransmission(0x48);
+    Wire.write(0x10);
+    Wire.write(0xaa);
+    Wire.write(0xbb);
+    CHECK(Wire.endTransmission() == 0, "write failed");
+    CHECK_BUS("S 90 10 aa bb P", "write");
+    CHECK(slaves[0].reg[0x10] == 0xaa && slaves[0].reg[0x11] == 0xbb, "registers not written");
+
+    clear(&bus);
+    Wire.beginTransmission(0x48);
+    Wire.write(0x10);
+    CHECK(Wire.endTransmission(false) == 0, "held back write failed");
+    CHECK_BUS("", "held back write");
+    CHECK(Wire.requestFrom(0x48, 2) == 2, "register read failed");
+    CHECK_BUS("S 90 10 Sr 91 aa bb P", "register read");
+    CHECK(Wire.read() == 0xaa && Wire.read() == 0xbb && Wire.read() == -1, "register read data");
+
+    clear(&bus);
+    CHECK(Wire.requestFrom(0x48, 1, 0x11, 1, true) == 1, "internal address read failed");
+    CHECK_BUS("S 90 11 Sr 91 bb P", "internal address read");
+
+    // Longer than the IOM offset: write without stop, then the read.
+    clear(&bus);
+    Wire.beginTransmission(0x48);
+    Wire.write(0x20);
+    Wire.write(data, sizeof(data));
+    Wire.endTransmission(false);
+    CHECK(Wire.requestFrom(0x48, 1) == 1 && Wire.read() == (uint8_t)(0x24 * 7 + 0x48), "long write read");
+    CHECK_BUS("S 90 20 01 02 03 04 Sr 91 44 P", "long write read");
+
+    // A different device: the held back write goes first on its own.
+    clear(&bus);
+    Wire.beginTransmission(0x48);
+    Wire.write(0x10);
+    Wire.endTransmission(false);
+    CHECK(Wire.requestFrom(0x49, 2) == 2, "read after held back write failed");
+    CHECK_BUS("S 90 10 Sr 93 49 50 P", "read of another device");
+
+    clear(&bus);
+    Wire.beginTransmission(0x48);
+    Wire.write(0x10);
+    Wire.endTransmission(false);
+    Wire.beginTransmission(0x49);
+    Wire.write(0x05);
+    CHECK(Wire.endTransmission() == 0, "write after held back write failed");
+    CHECK_BUS("S 90 10 Sr 92 05 P", "write after held back write");
+
+    // end() does not lose a held back write.
+    clear(&bus);
+    Wire.beginTransmission(0x48);
+    Wire.write(0x30);
+    Wire.write(0x77);
+    Wire.endTransmission(false);
+    Wire.end();
+    CHECK_BUS("S 90 30 77 P", "held back write at end()");
+    CHECK(slaves[0].reg[0x30] == 0x77, "held back write lost at end()");
+    Wire.begin();
+}
+
+static void test_wire_nack(void)
+{
+    reset();
+    Wire.beginTransmission(ABSENT);
+    Wire.write(0x01);
+    CHECK(Wire.endTransmission() == 1, "NACK not reported");
+    CHECK_BUS("S 60~ P", "write to absent device");
+
+    clear(&bus);
+    CHECK(Wire.requestFrom(ABSENT, 2) == 0, "read NACK not reported");
+    CHECK_BUS("S 61~ P", "read from absent device");
+
+    clear(&bus);
+    Wire.beginTransmission(ABSENT);
+    Wire.write(0x01);
+    Wire.endTransmission(false);
+    CHECK(Wire.requestFrom(ABSENT, 2) == 0, "register read NACK not reported");
+    CHECK_BUS("S 60~ P", "register read from absent device");
+
+    // Sent on its own by the next beginTransmission(), reported by the
+    // endTransmission() after it; that write still goes out.
+    clear(&bus);
+    Wire.beginTransmission(ABSENT);
+    Wire.write(0x01);
+    CHECK(Wire.endTransmission(false) == 0, "held back write failed before it was sent");
+    Wire.beginTransmission(0x48);
+    Wire.write(0x10);
+    Wire.write(0x55);
+    CHECK(Wire.endTransmission() == 1, "NACK of held back write lost");
+    CHECK_BUS("S 60~ P S 90 10 55 P", "write after held back NACK");
+    CHECK(slaves[0].reg[0x10] == 0x55, "write after held back NACK not done");
+    Wire.beginTransmission(0x48);
+    Wire.write(0x10);
+    CHECK(Wire.endTransmission() == 0, "NACK of held back write reported twice");
+
+    // Reported by requestFrom() from another device, which reads nothing.
+    clear(&bus);
+    Wire.beginTransmission(ABSENT);
+    Wire.write(0x01);
+    Wire.endTransmission(false);
+    CHECK(Wire.requestFrom(0x48, 1) == 0 && Wire.available() == 0, "NACK of held back write lost by requestFrom");
+    CHECK_BUS("S 60~ P", "read after held back NACK");
+    CHECK(Wire.requestFrom(0x48, 1) == 1, "NACK of held back write reported twice by requestFrom");
+
+    // Held back by Wire, sent by Wire1: on Wire's bus, reported to Wire.
+    clear(&bus);
+    Wire.beginTransmission(ABSENT);
+    Wire.write(0x01);
+    Wire.endTransmission(false);
+    Wire1.beginTransmission(0x48);
+    CHECK_BUS("S 60~ P", "held back write sent by the other instance");
+    Wire1.endTransmission();
+    Wire.beginTransmission(0x48);
+    Wire.write(0x10);
+    CHECK(Wire.endTransmission() == 1, "NACK of held back write lost by the other instance");
+    Wire.beginTransmission(0x48);
+    Wire.write(0x10);
+    CHECK(Wire.endTransmission() == 0, "NACK of held back write reported twice");
+}
+
+// Queue
+
+typedef struct
+{
+    udrv_twimst_xfer_t xfer;
+    uint8_t wbuf[8];
+    uint8_t rbuf[16];
+    uint8_t expect[16];
+    int32_t expect_status;
+    int32_t status;
+    int done;
+} job_t;
+
+static int completions;
+
+static void on_done(udrv_twimst_port port, udrv_twimst_xfer_t *xfer, int32_t status, void *p_context)
+{
+    job_t *job = (job_t *)p_context;
+
+    CHECK(SCB->ICSR != 0, "completion outside the IOM interrupt");
+    job->status = status;
+    job->done = ++completions;
+}
+
+// The framing a transaction is expected to have, on the reference slaves.
+static void expect_xfer(job_t *job)
+{
+    udrv_twimst_xfer_t *x = &job->xfer;
+    slave_t *s = find(ref_slaves, x->address);
+
+    job->expect_status = UDRV_RETURN_OK;
+    if (x->write_length > 0 || x->read_length == 0)
+    {
+        if (!bus_address(&ref, s, x->address, false))
+        {
+            bus_stop(&ref);
+            job->expect_status = -UDRV_NACK;
+            return;
+        }
+        for (uint16_t i = 0; i < x->write_length; i++)
+            bus_write(&ref, s, x->write_data[i]);
+    }
+    if (x->read_length > 0)
+    {
+        if (!bus_address(&ref, s, x->address, true))
+        {
+            bus_stop(&ref);
+            job->expect_status = -UDRV_NACK;
+            return;
+        }
+        for (uint16_t i = 0; i < x->read_length; i++)
+            job->expect[i] = bus_read(&ref, s);
+    }
+    if (x->read_length > 0 || !(x->flags & UDRV_TWIMST_XFER_NO_STOP))
+        bus_stop(&ref);
+}
+
+static void make_job(job_t *job)
+{
+    static const uint8_t addrs[] = {0x48, 0x49, ABSENT};
+    udrv_twimst_xfer_t *x = &job->xfer;
+
+    memset(job, 0, sizeof(*job));
+    x->address = addrs[rand() % 8 == 0 ? 2 : rand() % 2];
+    x->write_data = job->wbuf;
+    x->write_length = rand() % (sizeof(job->wbuf) + 1);
+    x->read_data = job->rbuf;
+    x->read_length = (rand() % 2) ? rand() % (sizeof(job->rbuf) + 1) : 0;
+    if (x->read_length == 0 && rand() % 4 == 0)
+        x->flags = UDRV_TWIMST_XFER_NO_STOP;
+    for (uint16_t i = 0; i < x->write_length; i++)
+        job->wbuf[i] = (uint8_t)rand();
+}
+
+static void test_queue(void)
+{
+    job_t jobs[QUEUE_FREE + 1];
+
+    reset();
+    memcpy(ref_slaves, slaves, sizeof(slaves));
+    clear(&ref);
+    ref.held = bus.held;
+    srand(30);
+    for (int round = 0; round < 300; round++)
+    {
+        int n = 1 + rand() % QUEUE_FREE;
+
+        completions = 0;
+        for (int i = 0; i < n; i++)
+        {
+            make_job(&jobs[i]);
+            expect_xfer(&jobs[i]);
+            CHECK(udrv_twimst_submit(UDRV_TWIMST_0, &jobs[i].xfer, on_done, &jobs[i]) == UDRV_RETURN_OK,
+                  "round %d: submit %d refused", round, i);
+        }
+        if (n == QUEUE_FREE)
+        {
+            make_job(&jobs[n]);
+            CHECK(udrv_twimst_submit(UDRV_TWIMST_0, &jobs[n].xfer, on_done, &jobs[n]) == -UDRV_BUSY,
+                  "round %d: submit to a full queue accepted", round);
+        }
+        while (sim_step())
+            ;
+        for (int i = 0; i < n; i++)
+        {
+            CHECK(jobs[i].done == i + 1, "round %d: transaction %d completed %d", round, i, jobs[i].done);
+            CHECK(jobs[i].status == jobs[i].expect_status, "round %d: transaction %d status %d, expected %d",
+                  round, i, jobs[i].status, jobs[i].expect_status);
+            CHECK(jobs[i].status != UDRV_RETURN_OK ||
+                  memcmp(jobs[i].rbuf, jobs[i].expect, jobs[i].xfer.read_length) == 0,
+                  "round %d: transaction %d read the wrong data", round, i);
+        }
+        CHECK(strcmp(bus.s, ref.s) == 0, "round %d: bus \"%s\", expected \"%s\"", round, bus.s, ref.s);
+        CHECK(twi_latency == UDRV_PS_LATENCY_ANY, "round %d: latency bound kept on an idle bus", round);
+        clear(&bus);
+        clear(&ref);
+    }
+
+    // Not accepted with nothing to write from or read into.
+    jobs[0].xfer = (udrv_twimst_xfer_t){0x48, NULL, 2, NULL, 0, 0};
+    CHECK(udrv_twimst_submit(UDRV_TWIMST_0, &jobs[0].xfer, on_done, &jobs[0]) == -UDRV_WRONG_ARG,
+          "write without data accepted");
+}
+
+// Wire register reads of len bytes from both devices, with or without a stop
+// after the register address.
+static uint64_t wire_reads(int reads, uint8_t len, bool stop, uint32_t *irqs, uint32_t *wakes)
+{
+    uint64_t start = now_ns;
+
+    interrupts = 0;
+    wakeups = 0;
+    for (int i = 0; i < reads; i++)
+    {
+        uint8_t addr = slaves[i % 2].addr;
+
+        Wire.beginTransmission(addr);
+        Wire.write((uint8_t)(i * len));
+        Wire.endTransmission(stop);
+        CHECK(Wire.requestFrom(addr, len) == len, "register read %d failed", i);
+    }
+    *irqs = interrupts;
+    *wakes = wakeups;
+    return now_ns - start;
+}
+
+// The same reads queued at once.
+static uint64_t queued_reads(int reads, uint8_t len, uint32_t *irqs)
+{
+    job_t jobs[QUEUE_FREE];
+    uint64_t start = now_ns;
+
+    interrupts = 0;
+    wakeups = 0;
+    completions = 0;
+    for (int i = 0; i < reads; i++)
+    {
+        udrv_twimst_xfer_t *x = &jobs[i].xfer;
+
+        memset(&jobs[i], 0, sizeof(jobs[i]));
+        jobs[i].wbuf[0] = (uint8_t)(i * len);
+        *x = (udrv_twimst_xfer_t){slaves[i % 2].addr, jobs[i].wbuf, 1, jobs[i].rbuf, len, 0};
+        CHECK(udrv_twimst_submit(UDRV_TWIMST_0, x, on_done, &jobs[i]) == UDRV_RETURN_OK, "submit %d refused", i);
+    }
+    while (sim_step())
+        ;
+    for (int i = 0; i < reads; i++)
+        CHECK(jobs[i].status == UDRV_RETURN_OK, "queued read %d failed", i);
+    *irqs = interrupts;
+    return now_ns - start;
+}
+
+int main(void)
+{
+    uint32_t irqs[3], wakes[2];
+    uint64_t ns[3];
+    const int reads = 6;
+
+    Wire.begin();
+    Wire1.begin();
+    Wire.setClock(CLOCK_HZ);
+    Wire.begin();
+
+    test_wire_framing();
+    test_wire_nack();
+    test_queue();
+
+    reset();
+    ns[0] = wire_reads(reads, 6, true, &irqs[0], &wakes[0]);
+    ns[1] = wire_reads(reads, 6, false, &irqs[1], &wakes[1]);
+    ns[2] = queued_reads(reads, 6, &irqs[2]);
+    CHECK(ns[1] < ns[0] && irqs[1] * 2 == irqs[0], "combined register read not faster");
+    printf("twimst: %d 6-byte register reads at %u kHz: write and read %u us, %u interrupts, %u wake-ups; "
+           "combined %u us, %u, %u; queued at once %u us, %u interrupts\n", reads, CLOCK_HZ / 1000,
+           (unsigned)(ns[0] / 1000), irqs[0], wakes[0], (unsigned)(ns[1] / 1000), irqs[1], wakes[1],
+           (unsigned)(ns[2] / 1000), irqs[2]);
+
+    TEST_DONE("twimst");
+}
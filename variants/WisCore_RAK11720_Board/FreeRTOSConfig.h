@@ -84,8 +84,13 @@ extern "C"
 #define configUSE_MALLOC_FAILED_HOOK            1
 
 /* Run time and task stats gathering related definitions. */
+#if CFG_PROFILE
+#define configGENERATE_RUN_TIME_STATS           1
+#define configUSE_TRACE_FACILITY                1
+#else
 #define configGENERATE_RUN_TIME_STATS           0
 #define configUSE_TRACE_FACILITY                0
+#endif
 #define configUSE_STATS_FORMATTING_FUNCTIONS    0
 
 /* Software timer related definitions. */
@@ -141,6 +146,16 @@ extern void am_freertos_wakeup(uint32_t);
     } while (0);
 
 #define configPOST_SLEEP_PROCESSING(time)    am_freertos_wakeup(time)
+
+#if CFG_PROFILE
+extern uint32_t am_hal_stimer_counter_get(void);
+extern void service_taskmon_switched_in(uint32_t tag);
+
+/* Run time is counted on the STIMER, already running for the tick and through deep sleep */
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()     am_hal_stimer_counter_get()
+#define traceTASK_SWITCHED_IN()              service_taskmon_switched_in(pxCurrentTCB->uxTaskNumber)
+#endif
 #endif
 /*-----------------------------------------------------------*/
 #ifndef AM_PART_APOLLO
@@ -9,6 +9,8 @@
 #include "portmacro.h"
 #include "portable.h"
 
+#include "uhal_powersave.h"
+
 //*****************************************************************************
 //
 // Sleep function called from FreeRTOS IDLE task.
@@ -16,11 +18,12 @@
 // Return 0 if this function also incorporates the WFI, else return value same
 // as idleTime
 //
+// The sleep depth is chosen by the tickless idle policy in uhal_powersave.c
+//
 //*****************************************************************************
 uint32_t am_freertos_sleep(uint32_t idleTime)
 {
-    am_hal_sysctrl_sleep(AM_HAL_SYSCTRL_SLEEP_DEEP);
-    return 0;
+    return uhal_mcu_idle_sleep(idleTime);
 }
 
 //*****************************************************************************
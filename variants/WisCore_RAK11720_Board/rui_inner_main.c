@@ -19,6 +19,7 @@
 
 #include "udrv_errno.h"
 #include "udrv_gpio.h"
+#include "udrv_adc.h"
 #include "udrv_serial.h"
 #include "udrv_timer.h"
 #include "udrv_system.h"
@@ -32,6 +33,8 @@
 #include "service_mode_proto.h"
 #include "service_mode_cli.h"
 #include "service_mode_transparent.h"
+#include "service_profile.h"
+#include "service_taskmon.h"
 
 #if CFG_SYSVIEW
 #include "SEGGER_RTT.h"
@@ -115,6 +118,7 @@ void error_fault_handler(uint32_t info)
 /********************************************************************/
 void rui_event_handler_func(void *data, uint16_t size) {
     udrv_system_event_t *event = (udrv_system_event_t *)data;
+    SERVICE_PROFILE_BEGIN(SERVICE_PROFILE_EVENT_HANDLER);
     switch (event->request) {
         case UDRV_SYS_EVT_OP_SERIAL_FALLBACK:
         {
@@ -151,6 +155,7 @@ void rui_event_handler_func(void *data, uint16_t size) {
         }
         case UDRV_SYS_EVT_OP_SERIAL_UART:
         {
+            SERVICE_PROFILE_BEGIN(SERVICE_PROFILE_SERIAL);
             if (service_nvm_get_mode_type_from_nvm(SERIAL_UART1) != SERVICE_MODE_TYPE_CUSTOM) {
                 
                 if(no_busy_loop == true)
@@ -235,6 +240,7 @@ void rui_event_handler_func(void *data, uint16_t size) {
                     }
                 }
             }
+            SERVICE_PROFILE_END(SERVICE_PROFILE_SERIAL);
             break;
         }
 #ifdef SUPPORT_USB
@@ -388,11 +394,17 @@ void rui_event_handler_func(void *data, uint16_t size) {
             udrv_gpio_handler_handler(event->p_context);
             break;
         }
+        case UDRV_SYS_EVT_OP_ADC_BLOCK:
+        {
+            udrv_adc_stream_handler(event->p_context);
+            break;
+        }
         default:
         {
             break;
         }
     }
+    SERVICE_PROFILE_END_ARG(SERVICE_PROFILE_EVENT_HANDLER, event->request);
 }
 
 #if defined(AM_PART_APOLLO3) || defined(AM_PART_APOLLO3P)
@@ -452,6 +464,10 @@ dump_ota_status(void)
 
 void rui_init(void)
 {
+#if CFG_PROFILE
+    service_profile_init();
+    service_taskmon_init();
+#endif
     SERVICE_MODE_TYPE mode;
     uint32_t baudrate;
     uint8_t set_dev_name[30];
@@ -554,6 +570,7 @@ void rui_init(void)
 
 void rui_running(void)
 {
+    SERVICE_PROFILE_BEGIN(SERVICE_PROFILE_LOOP);
 #ifdef SUPPORT_LORA
 #ifdef LORA_STACK_104
     // Process Radio IRQ
@@ -565,11 +582,20 @@ void rui_running(void)
 #endif
 #endif
 
+    SERVICE_PROFILE_BEGIN(SERVICE_PROFILE_EVENT_CONSUME);
     udrv_system_event_consume();
+    SERVICE_PROFILE_END(SERVICE_PROFILE_EVENT_CONSUME);
+
+    SERVICE_PROFILE_BEGIN(SERVICE_PROFILE_LORAMAC);
     LoRaMacProcess( );
+    SERVICE_PROFILE_END(SERVICE_PROFILE_LORAMAC);
 
     // Call all packages process functions
+    SERVICE_PROFILE_BEGIN(SERVICE_PROFILE_LMH_PACKAGES);
     LmHandlerPackagesProcess();
+    SERVICE_PROFILE_END(SERVICE_PROFILE_LMH_PACKAGES);
+
+    SERVICE_PROFILE_END(SERVICE_PROFILE_LOOP);
 }
 
 static void loop_task(void* arg)
@@ -28,6 +28,7 @@
 #include "radio.h"
 #include "sx126x-board.h"
 #include "udrv_gpio.h"
+#include "service_profile.h"
 
 #if defined( USE_RADIO_DEBUG )
 /*!
@@ -59,8 +60,23 @@ void SX126xIoInit( void )
     udrv_gpio_init(RADIO_ANT_SW, GPIO_DIR_OUT, GPIO_PULL_NONE, GPIO_LOGIC_HIGH);
 }
 
+#if CFG_PROFILE
+static DioIrqHandler *SX126xDioIrq;
+
+static void SX126xOnDioIrq( void *context )
+{
+    SERVICE_PROFILE_BEGIN( SERVICE_PROFILE_RADIO_IRQ );
+    SX126xDioIrq( context );
+    SERVICE_PROFILE_END( SERVICE_PROFILE_RADIO_IRQ );
+}
+#endif
+
 void SX126xIoIrqInit( DioIrqHandler *dioIrq )
 {
+#if CFG_PROFILE
+    SX126xDioIrq = dioIrq;
+    dioIrq = SX126xOnDioIrq;
+#endif
     GpioSetInterrupt( &SX126x.DIO1, IRQ_RISING_EDGE, IRQ_HIGH_PRIORITY, dioIrq );
 }
 